@@ -122,6 +122,7 @@ $set 7 #Fluxbox
 10 Can not connect to X server.\nMake sure you started X before you start Fluxbox.
 11 Warning: X server does not support locale
 12 Warning: cannot set locale modifiers
+13 Warning: session.leakCheckInterval needs the X-Resource extension
 
 $set 8 #Gnome_OBSOLETE
 
@@ -145,6 +146,7 @@ $set 10 #Menu
 8 Reload Config
 9 Restart
 10 Warning: unbalanced [encoding] tags
+11 Command timed out
 
 $set 11 #Remember
 
@@ -122,6 +122,7 @@ enum {
 	FluxboxNoDisplay = 10,
 	FluxboxWarningLocale = 11,
 	FluxboxWarningLocaleModifiers = 12,
+	FluxboxLeakCheckUnsupported = 13,
 
 	GnomeSet = 8,
 	GnomeOutOfMemoryClientList = 1,
@@ -142,6 +143,7 @@ enum {
 	MenuReconfigure = 8,
 	MenuRestart = 9,
 	MenuErrorEndEncoding = 10,
+	MenuPipeTimeout = 11,
 
 	RememberSet = 11,
 	RememberDecorations = 1,
@@ -23,6 +23,7 @@
 #include "ButtonTheme.hh"
 #include "FbTk/Button.hh"
 #include "FbTk/ImageControl.hh"
+#include "FbTk/RequestStats.hh"
 
 ButtonTool::ButtonTool(FbTk::Button *button, 
                        ToolbarItem::Type type, 
@@ -50,6 +51,7 @@ void ButtonTool::updateSizing() {
 }
 
 void ButtonTool::renderTheme(int alpha) {
+    FbTk::RequestStats::Widget widget(typeid(*this));
     FbTk::Button &btn = static_cast<FbTk::Button &>(window());
 
     btn.setGC(static_cast<const ButtonTheme &>(*theme()).gc());
@@ -31,13 +31,16 @@
 #include "FbTk/MenuItem.hh"
 #include "FbTk/MemFun.hh"
 
+#include <set>
+
 namespace { // anonymous
 
 class ClientMenuItem: public FbTk::MenuItem {
 public:
     ClientMenuItem(Focusable &client, ClientMenu &menu):
         FbTk::MenuItem(client.title(), menu),
-        m_client(client) {
+        m_client(client),
+        m_width(0) {
         m_signals.join(client.titleSig(),
                        FbTk::MemFunSelectArg1(menu, &ClientMenu::titleChanged));
         m_signals.join(client.dieSig(), FbTk::MemFun(menu, &ClientMenu::clientDied));
@@ -65,6 +68,13 @@ public:
     }
 
     const FbTk::BiDiString &label() const { return m_client.title(); }
+
+    unsigned int width(const FbTk::ThemeProxy<FbTk::MenuTheme> &theme) const {
+        m_width = FbTk::MenuItem::width(theme);
+        return m_width;
+    }
+    /// @return the width the menu last measured, before the title changed
+    unsigned int lastWidth() const { return m_width; }
     const FbTk::PixmapWithMask *icon() const {
         return m_client.screen().clientMenuUsePixmap() ? &m_client.icon() : 0;
     }
@@ -82,6 +92,7 @@ public:
 
 private:
     Focusable &m_client;
+    mutable unsigned int m_width;
     FbTk::SignalTracker m_signals;
 };
 
@@ -130,27 +141,86 @@ namespace {
 
 ClientMenuItem* getMenuItem(ClientMenu& menu, Focusable& win) {
     // find the corresponding menuitem
-    ClientMenuItem *cl_item = 0;
     for (size_t i = 0; i < menu.numberOfItems(); i++) {
         FbTk::MenuItem *item = menu.find(i);
         if (item && typeid(*item) == typeid(ClientMenuItem)) {
-            cl_item = static_cast<ClientMenuItem *>(item);
+            ClientMenuItem *cl_item = static_cast<ClientMenuItem *>(item);
             if (cl_item->client() == &win)
-                break;
+                return cl_item;
         }
     }
 
-    return cl_item;
-
+    return 0;
 }
 
 } // anonymous
 
+void ClientMenu::addWindow(FluxboxWindow &win) {
+    FluxboxWindow::ClientList::iterator client_it = win.clientList().begin();
+    FluxboxWindow::ClientList::iterator client_it_end = win.clientList().end();
+    for (; client_it != client_it_end; ++client_it) {
+        // the client may come from another window in the menu
+        ClientMenuItem *cl_item = getMenuItem(*this, **client_it);
+        if (cl_item)
+            remove(cl_item->getIndex());
+        insert(new ClientMenuItem(**client_it, *this));
+    }
+
+    updateMenuLater();
+}
+
+void ClientMenu::removeWindow(FluxboxWindow &win) {
+    bool removed = false;
+    for (size_t i = numberOfItems(); i > 0; --i) {
+        FbTk::MenuItem *item = find(i - 1);
+        if (item && typeid(*item) == typeid(ClientMenuItem) &&
+            static_cast<ClientMenuItem *>(item)->client()->fbwindow() == &win) {
+            remove(i - 1);
+            removed = true;
+        }
+    }
+
+    if (removed)
+        updateMenuLater();
+}
+
+void ClientMenu::updateClientList(BScreen &screen) {
+    std::set<FluxboxWindow *> listed(m_list.begin(), m_list.end());
+    std::set<FluxboxWindow *> shown;
+
+    bool changed = false;
+    for (size_t i = numberOfItems(); i > 0; --i) {
+        FbTk::MenuItem *item = find(i - 1);
+        if (item == 0 || typeid(*item) != typeid(ClientMenuItem))
+            continue;
+        FluxboxWindow *win = static_cast<ClientMenuItem *>(item)->client()->fbwindow();
+        if (listed.find(win) == listed.end()) {
+            remove(i - 1);
+            changed = true;
+        } else
+            shown.insert(win);
+    }
+
+    // new windows are appended to the list
+    Focusables::iterator it = m_list.begin();
+    for (; it != m_list.end(); ++it) {
+        if (shown.find(*it) != shown.end())
+            continue;
+        FluxboxWindow::ClientList::iterator client_it = (*it)->clientList().begin();
+        for (; client_it != (*it)->clientList().end(); ++client_it)
+            insert(new ClientMenuItem(**client_it, *this));
+        changed = true;
+    }
+
+    if (changed)
+        updateMenuLater();
+}
+
 void ClientMenu::titleChanged(Focusable& win) {
     // find correct menu item
     ClientMenuItem* cl_item = getMenuItem(*this, win);
     if (cl_item)
-        themeReconfigured();
+        updateItem(cl_item->getIndex(), cl_item->lastWidth());
 }
 
 void ClientMenu::clientDied(Focusable &win) {
@@ -158,6 +228,8 @@ void ClientMenu::clientDied(Focusable &win) {
     ClientMenuItem* cl_item = getMenuItem(*this, win);
 
     // update accordingly
-    if (cl_item)
+    if (cl_item) {
         remove(cl_item->getIndex());
+        updateMenuLater();
+    }
 }
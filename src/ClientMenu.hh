@@ -47,9 +47,15 @@ public:
     ClientMenu(BScreen &screen, 
                Focusables &clients, bool listen_for_iconlist_changes);
 
-    /// refresh the entire menu
+    /// refresh the entire menu, prefer addWindow() and removeWindow()
     void refreshMenu();
 
+    /// adds the clients of @win at the end of the menu
+    void addWindow(FluxboxWindow &win);
+
+    /// removes the clients that are still in @win from the menu
+    void removeWindow(FluxboxWindow &win);
+
     /// Called when window title changed.
     void titleChanged(Focusable& win);
 
@@ -58,9 +64,9 @@ public:
 
 private:
 
-    void updateClientList(BScreen& screen) {
-        refreshMenu();
-    }
+    /// adds and removes only the items of the windows that entered or
+    /// left the list
+    void updateClientList(BScreen& screen);
 
     Focusables &m_list; ///< clients in the menu
     FbTk::SignalTracker m_slots; ///< track all the slots
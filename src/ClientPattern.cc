@@ -30,6 +30,7 @@
 #include "Workspace.hh"
 
 #include "FbTk/StringUtil.hh"
+#include "FbTk/AtomCache.hh"
 #include "FbTk/App.hh"
 #include "FbTk/stringstream.hh"
 #include "FbTk/STLUtil.hh"
@@ -40,15 +41,25 @@
 #endif // _GNU_SOURCE
 
 #include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <set>
 #include <string>
 #include <memory>
 #include <algorithm>
+#include <vector>
 #ifdef HAVE_CSTDIO
   #include <cstdio>
 #else
   #include <stdio.h>
 #endif
 
+#ifdef HAVE_CSTDLIB
+  #include <cstdlib>
+#else
+  #include <stdlib.h>
+#endif
+
 #ifdef HAVE_CSTRING
   #include <cstring>
 #else
@@ -135,6 +146,76 @@ Prop2String property_2_strings[] = { // sorted by 'prop'
 };
 
 
+/// how a property is stored, so literals can be compared to it directly
+enum PropertyType { TEXT_PROPERTY, NUMBER_PROPERTY, BOOL_PROPERTY };
+
+PropertyType propertyType(ClientPattern::WinProperty prop) {
+    switch (prop) {
+    case ClientPattern::TRANSIENT:
+    case ClientPattern::MAXIMIZED:
+    case ClientPattern::MINIMIZED:
+    case ClientPattern::SHADED:
+    case ClientPattern::STUCK:
+    case ClientPattern::FOCUSHIDDEN:
+    case ClientPattern::ICONHIDDEN:
+    case ClientPattern::URGENT:
+        return BOOL_PROPERTY;
+    case ClientPattern::WORKSPACE:
+    case ClientPattern::HEAD:
+    case ClientPattern::SCREEN:
+        return NUMBER_PROPERTY;
+    default:
+        return TEXT_PROPERTY;
+    }
+}
+
+/// @return true if the regular expression only matches @str itself
+bool isLiteral(const FbTk::FbString &str) {
+    return str.find_first_of("\\^$.[]|()*+?{}") == FbTk::FbString::npos;
+}
+
+/// @return true if @str is a number the way number2String() writes it
+bool isPlainNumber(const FbTk::FbString &str) {
+    if (str.empty() || str.size() > 9 || (str[0] == '0' && str.size() > 1))
+        return false;
+    return str.find_first_not_of("0123456789") == FbTk::FbString::npos;
+}
+
+/// @return the text property if the client keeps it as a string, else 0
+const FbTk::FbString *storedText(ClientPattern::WinProperty prop,
+                                 const Focusable &client) {
+    switch (prop) {
+    case ClientPattern::TITLE:
+        return &client.title().logical();
+    case ClientPattern::CLASS:
+        return &client.getWMClassClass();
+    case ClientPattern::NAME:
+        return &client.getWMClassName();
+    case ClientPattern::WORKSPACENAME: {
+        const FluxboxWindow *fbwin = client.fbwindow();
+        const Workspace *w = (fbwin ?
+                client.screen().getWorkspace(fbwin->workspaceNumber()) :
+                client.screen().currentWorkspace());
+        return w ? &w->name() : 0;
+    }
+    default:
+        return 0;
+    }
+}
+
+/// all existing patterns, for ClientPattern::dumpStats()
+std::set<const ClientPattern *> &livePatterns() {
+    static std::set<const ClientPattern *> patterns;
+    return patterns;
+}
+
+struct MoreTime {
+    bool operator()(const std::pair<uint64_t, const ClientPattern *> &a,
+                    const std::pair<uint64_t, const ClientPattern *> &b) const {
+        return a.first > b.first;
+    }
+};
+
 } // end of anonymous namespace
 
 
@@ -143,17 +224,82 @@ Prop2String property_2_strings[] = { // sorted by 'prop'
  * We have a "term" in the whole expression which is the full pattern
  * we also need to keep track of the uncompiled regular expression
  * for final output
+ * When the term is parsed it is compiled to the cheapest way to match it:
+ * most terms compare a property to a literal, which needs no regexp and,
+ * for numbers and booleans, no string either.
  */
 struct ClientPattern::Term {
 
+    enum Type {
+        REGEXP,   ///< match the property text with regexp
+        LITERAL,  ///< the property text equals literal
+        PREFIX,   ///< the property text starts with literal, from 'foo.*'
+        NUMBER,   ///< the numeric property equals number
+        BOOLEAN,  ///< the boolean property equals boolean
+        CURRENT,  ///< the property equals the one of the focused window/workspace
+        MOUSE     ///< the head is the one with the mouse
+    };
+
     Term(const FbTk::FbString& _regstr, WinProperty _prop, bool _negate, const FbTk::FbString& _xprop) :
         regstr(_regstr),
         xpropstr(_xprop),
         regexp(_regstr, true),
         prop(_prop),
-        negate(_negate) {
+        negate(_negate),
+        type(REGEXP),
+        number(0),
+        boolean(false) {
 
-        xprop = XInternAtom(FbTk::App::instance()->display(), xpropstr.c_str(), False);
+        xprop = FbTk::AtomCache::instance().get(xpropstr);
+        compile();
+    }
+
+    void compile() {
+        if (prop == XPROP)
+            return;
+
+        if (regstr == "[current]") {
+            type = CURRENT;
+            return;
+        }
+        if (prop == HEAD && regstr == "[mouse]") {
+            type = MOUSE;
+            return;
+        }
+
+        if (isLiteral(regstr)) {
+            PropertyType ptype = propertyType(prop);
+            if (ptype == BOOL_PROPERTY && (regstr == "yes" || regstr == "no")) {
+                type = BOOLEAN;
+                boolean = (regstr == "yes");
+            } else if (ptype == NUMBER_PROPERTY && isPlainNumber(regstr)) {
+                type = NUMBER;
+                number = atoi(regstr.c_str());
+            } else {
+                type = LITERAL;
+                literal = regstr;
+            }
+#ifdef USE_REGEXP
+        } else if (regstr.size() > 2 &&
+                   regstr.compare(regstr.size() - 2, 2, ".*") == 0 &&
+                   propertyType(prop) == TEXT_PROPERTY &&
+                   isLiteral(regstr.substr(0, regstr.size() - 2))) {
+            type = PREFIX;
+            literal = regstr.substr(0, regstr.size() - 2);
+#endif // USE_REGEXP
+        }
+    }
+
+    /// @return whether @text matches, not counting negate
+    bool matchText(const FbTk::FbString &text) const {
+        switch (type) {
+        case LITERAL:
+            return text == literal;
+        case PREFIX:
+            return text.compare(0, literal.size(), literal) == 0;
+        default:
+            return regexp.match(text);
+        }
     }
 
     // (title=.*bar) or (@FOO=.*bar)
@@ -163,17 +309,34 @@ struct ClientPattern::Term {
     FbTk::RegExp regexp;       // compiled version of '.*bar'
     WinProperty prop;
     bool negate;
+
+    Type type;
+    FbTk::FbString literal;    // for LITERAL and PREFIX
+    int number;                // for NUMBER
+    bool boolean;              // for BOOLEAN
 };
 
+bool ClientPattern::s_collect_stats = false;
+
 ClientPattern::ClientPattern():
     m_matchlimit(0),
-    m_nummatches(0) {}
+    m_nummatches(0),
+    m_properties(0) {
+    m_stats.evaluations = m_stats.hits = 0;
+    m_stats.nsec = 0;
+    livePatterns().insert(this);
+}
 
 // parse the given pattern (to end of line)
 ClientPattern::ClientPattern(const char *str):
     m_matchlimit(0),
-    m_nummatches(0)
+    m_nummatches(0),
+    m_properties(0)
 {
+    m_stats.evaluations = m_stats.hits = 0;
+    m_stats.nsec = 0;
+    livePatterns().insert(this);
+
     /* A rough grammar of a pattern is:
        PATTERN ::= MATCH+ LIMIT?
        MATCH ::= '(' word ')'
@@ -278,10 +441,12 @@ ClientPattern::ClientPattern(const char *str):
 
     if (had_error) {
         FbTk::STLUtil::destroyAndClear(m_terms);
+        m_properties = 0;
     }
 }
 
 ClientPattern::~ClientPattern() {
+    livePatterns().erase(this);
     FbTk::STLUtil::destroyAndClear(m_terms);
 }
 
@@ -311,6 +476,19 @@ string ClientPattern::toString() const {
 
 // does this client match this pattern?
 bool ClientPattern::match(const Focusable &win) const {
+    if (!s_collect_stats)
+        return matchTerms(win);
+
+    uint64_t start = FbTk::FbTime::monoNanoseconds();
+    bool matched = matchTerms(win);
+    m_stats.nsec += FbTk::FbTime::monoNanoseconds() - start;
+    ++m_stats.evaluations;
+    if (matched)
+        ++m_stats.hits;
+    return matched;
+}
+
+bool ClientPattern::matchTerms(const Focusable &win) const {
     if (m_matchlimit != 0 && m_nummatches >= m_matchlimit)
         return false; // already matched out
 
@@ -321,35 +499,76 @@ bool ClientPattern::match(const Focusable &win) const {
     Terms::const_iterator it_end = m_terms.end();
     for (; it != it_end; ++it) {
         const Term& term = *(*it);
+        bool matched = false;
+        int number;
+
         if (term.prop == XPROP) {
-            if (!term.negate ^ ((term.regexp.match(win.getTextProperty(term.xprop))) || term.regexp.match(FbTk::StringUtil::number2String(win.getCardinalProperty(term.xprop)))))
-                return false;
-        } else if (term.regstr == "[current]") {
-            WinClient *focused = FocusControl::focusedWindow();
+            matched = term.regexp.match(win.getTextProperty(term.xprop)) ||
+                      term.regexp.match(FbTk::StringUtil::number2String(win.getCardinalProperty(term.xprop)));
+        } else switch (term.type) {
+        case Term::CURRENT:
             if (term.prop == WORKSPACE) {
-                if (!term.negate ^ (getProperty(term.prop, win) == FbTk::StringUtil::number2String(win.screen().currentWorkspaceID())))
-                    return false;
+                matched = getNumber(term.prop, win, number) &&
+                          number == (int)win.screen().currentWorkspaceID();
             } else if (term.prop == WORKSPACENAME) {
                 const Workspace *w = win.screen().currentWorkspace();
-                if (!w || (!term.negate ^ (getProperty(term.prop, win) == w->name())))
+                if (!w)
                     return false;
-            } else if (!focused || (!term.negate ^ (getProperty(term.prop, win) == getProperty(term.prop, *focused))))
-                return false;
-        } else if (term.prop == HEAD && term.regstr == "[mouse]") {
-            if (!term.negate ^ (getProperty(term.prop, win) == FbTk::StringUtil::number2String(win.screen().getCurrHead())))
-                return false;
+                const FbTk::FbString *text = storedText(term.prop, win);
+                matched = text ? *text == w->name()
+                               : getProperty(term.prop, win) == w->name();
+            } else {
+                WinClient *focused = FocusControl::focusedWindow();
+                if (!focused)
+                    return false;
+                const FbTk::FbString *text = storedText(term.prop, win);
+                const FbTk::FbString *focused_text = storedText(term.prop, *focused);
+                if (text && focused_text)
+                    matched = *text == *focused_text;
+                else
+                    matched = getProperty(term.prop, win) == getProperty(term.prop, *focused);
+            }
+            break;
+        case Term::MOUSE:
+            matched = getNumber(term.prop, win, number) &&
+                      number == win.screen().getCurrHead();
+            break;
+        case Term::NUMBER:
+            matched = getNumber(term.prop, win, number) && number == term.number;
+            break;
+        case Term::BOOLEAN:
+            matched = getBool(term.prop, win) == term.boolean;
+            break;
+        default: {
+            const FbTk::FbString *text = storedText(term.prop, win);
+            matched = text ? term.matchText(*text)
+                           : term.matchText(getProperty(term.prop, win));
+            break;
+        }
+        }
 
-        } else if (!term.negate ^ term.regexp.match(getProperty(term.prop, win)))
+        if (!term.negate ^ matched)
             return false;
     }
     return true;
 }
 
+bool ClientPattern::getLiteral(WinProperty prop, FbTk::FbString &literal) const {
+    Terms::const_iterator it = m_terms.begin(), it_end = m_terms.end();
+    for (; it != it_end; ++it) {
+        if ((*it)->prop == prop && (*it)->type == Term::LITERAL && !(*it)->negate) {
+            literal = (*it)->literal;
+            return true;
+        }
+    }
+    return false;
+}
+
 bool ClientPattern::dependsOnFocusedWindow() const {
     Terms::const_iterator it = m_terms.begin(), it_end = m_terms.end();
     for (; it != it_end; ++it) {
         if ((*it)->prop != WORKSPACE && (*it)->prop != WORKSPACENAME &&
-            (*it)->regstr == "[current]")
+            (*it)->type == Term::CURRENT)
             return true;
     }
     return false;
@@ -359,7 +578,7 @@ bool ClientPattern::dependsOnCurrentWorkspace() const {
     Terms::const_iterator it = m_terms.begin(), it_end = m_terms.end();
     for (; it != it_end; ++it) {
         if (((*it)->prop == WORKSPACE || (*it)->prop == WORKSPACENAME) &&
-            (*it)->regstr == "[current]")
+            (*it)->type == Term::CURRENT)
             return true;
     }
     return false;
@@ -378,6 +597,7 @@ bool ClientPattern::addTerm(const FbTk::FbString &str, WinProperty prop, bool ne
 
     if ((rc = !term->regexp.error())) {
         m_terms.push_back(term);
+        m_properties |= propertyBit(prop);
     } else {
         delete term;
     }
@@ -391,6 +611,18 @@ FbTk::FbString ClientPattern::getProperty(WinProperty prop, const Focusable &cli
 
     // we need this for some of the window properties
     const FluxboxWindow *fbwin = client.fbwindow();
+    int number;
+
+    switch (propertyType(prop)) {
+    case BOOL_PROPERTY:
+        return getBool(prop, client) ? "yes" : "no";
+    case NUMBER_PROPERTY:
+        if (getNumber(prop, client, number))
+            result = FbTk::StringUtil::number2String(number);
+        return result;
+    default:
+        break;
+    }
 
     switch (prop) {
     case TITLE:
@@ -402,32 +634,6 @@ FbTk::FbString ClientPattern::getProperty(WinProperty prop, const Focusable &cli
     case ROLE:
         result = client.getWMRole();
         break;
-    case TRANSIENT:
-        result = client.isTransient() ? "yes" : "no";
-        break;
-    case MAXIMIZED:
-        result = (fbwin && fbwin->isMaximized()) ? "yes" : "no";
-        break;
-    case MINIMIZED:
-        result = (fbwin && fbwin->isIconic()) ? "yes" : "no";
-        break;
-    case SHADED:
-        result = (fbwin && fbwin->isShaded()) ? "yes" : "no";
-        break;
-    case STUCK:
-        result = (fbwin && fbwin->isStuck()) ? "yes" : "no";
-        break;
-    case FOCUSHIDDEN:
-        result = (fbwin && fbwin->isFocusHidden()) ? "yes" : "no";
-        break;
-    case ICONHIDDEN:
-        result = (fbwin && fbwin->isIconHidden()) ? "yes" : "no";
-        break;
-    case WORKSPACE: {
-        unsigned int wsnum = (fbwin ? fbwin->workspaceNumber() : client.screen().currentWorkspaceID());
-        result = FbTk::StringUtil::number2String(wsnum);
-        break;
-    }
     case WORKSPACENAME: {
         const Workspace *w = (fbwin ?
                 client.screen().getWorkspace(fbwin->workspaceNumber()) :
@@ -437,23 +643,11 @@ FbTk::FbString ClientPattern::getProperty(WinProperty prop, const Focusable &cli
         }
         break;
     }
-    case HEAD:
-        if (fbwin) {
-            result = FbTk::StringUtil::number2String(client.screen().getHead(fbwin->fbWindow()));
-        }
-        break;
     case LAYER:
         if (fbwin) {
             result = ::ResourceLayer::getString(fbwin->layerNum());
         }
         break;
-    case URGENT:
-        result = Fluxbox::instance()->attentionHandler()
-                .isDemandingAttention(client) ? "yes" : "no";
-        break;
-    case SCREEN:
-        result = FbTk::StringUtil::number2String(client.screen().screenNumber());
-        break;
 
     case XPROP:
         break;
@@ -466,6 +660,97 @@ FbTk::FbString ClientPattern::getProperty(WinProperty prop, const Focusable &cli
     return result;
 }
 
+bool ClientPattern::getBool(WinProperty prop, const Focusable &client) {
+
+    const FluxboxWindow *fbwin = client.fbwindow();
+
+    switch (prop) {
+    case TRANSIENT:
+        return client.isTransient();
+    case MAXIMIZED:
+        return fbwin && fbwin->isMaximized();
+    case MINIMIZED:
+        return fbwin && fbwin->isIconic();
+    case SHADED:
+        return fbwin && fbwin->isShaded();
+    case STUCK:
+        return fbwin && fbwin->isStuck();
+    case FOCUSHIDDEN:
+        return fbwin && fbwin->isFocusHidden();
+    case ICONHIDDEN:
+        return fbwin && fbwin->isIconHidden();
+    case URGENT:
+        return Fluxbox::instance()->attentionHandler()
+                .isDemandingAttention(client);
+    default:
+        return false;
+    }
+}
+
+bool ClientPattern::getNumber(WinProperty prop, const Focusable &client, int &number) {
+
+    const FluxboxWindow *fbwin = client.fbwindow();
+
+    switch (prop) {
+    case WORKSPACE:
+        number = (fbwin ? fbwin->workspaceNumber() : client.screen().currentWorkspaceID());
+        return true;
+    case HEAD:
+        if (!fbwin)
+            return false;
+        number = client.screen().getHead(fbwin->fbWindow());
+        return true;
+    case SCREEN:
+        number = client.screen().screenNumber();
+        return true;
+    default:
+        return false;
+    }
+}
+
+void ClientPattern::dumpStats(std::ostream &os, size_t count) {
+    std::vector<std::pair<uint64_t, const ClientPattern *> > patterns;
+    std::set<const ClientPattern *>::const_iterator it = livePatterns().begin();
+    std::set<const ClientPattern *>::const_iterator it_end = livePatterns().end();
+    for (; it != it_end; ++it) {
+        if ((*it)->m_stats.evaluations > 0)
+            patterns.push_back(std::make_pair((*it)->m_stats.nsec, *it));
+    }
+    count = std::min(count, patterns.size());
+    std::partial_sort(patterns.begin(), patterns.begin() + count,
+                      patterns.end(), MoreTime());
+
+    os<<"slowest window patterns of "<<patterns.size()<<" used: "
+      <<"evaluations, hits, total ms, ns per evaluation"<<std::endl;
+    for (size_t i = 0; i < count; ++i) {
+        const ClientPattern &pat = *patterns[i].second;
+        os<<std::setw(10)<<pat.m_stats.evaluations
+          <<std::setw(10)<<pat.m_stats.hits
+          <<std::setw(10)<<std::fixed<<std::setprecision(3)
+          <<pat.m_stats.nsec / 1e6
+          <<std::setw(8)<<std::setprecision(0)
+          <<double(pat.m_stats.nsec) / pat.m_stats.evaluations
+          <<" "<<pat.toString()<<std::endl;
+    }
+    os.unsetf(std::ios::floatfield);
+    os<<std::setprecision(6);
+}
+
+void ClientPattern::writeStatsJson(std::ostream &os) {
+    Stats total = { 0, 0, 0 };
+    std::set<const ClientPattern *>::const_iterator it = livePatterns().begin();
+    std::set<const ClientPattern *>::const_iterator it_end = livePatterns().end();
+    for (; it != it_end; ++it) {
+        total.evaluations += (*it)->m_stats.evaluations;
+        total.hits += (*it)->m_stats.hits;
+        total.nsec += (*it)->m_stats.nsec;
+    }
+    os<<"{\"patterns\":"<<livePatterns().size()
+      <<",\"evaluations\":"<<total.evaluations
+      <<",\"hits\":"<<total.hits
+      <<",\"usec\":"<<total.nsec / 1000<<'}';
+}
+
 bool ClientPattern::operator ==(const ClientPattern &pat) const {
     // we require the terms to be identical (order too)
     Terms::const_iterator it = m_terms.begin();
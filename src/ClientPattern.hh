@@ -27,6 +27,9 @@
 #include "FbTk/RegExp.hh"
 #include "FbTk/NotCopyable.hh"
 #include "FbTk/FbString.hh"
+#include "FbTk/FbTime.hh"
+
+#include <iosfwd>
 
 #include <list>
 
@@ -61,6 +64,22 @@ public:
     /// Does this client match this pattern?
     bool match(const Focusable &win) const;
 
+    /**
+     * Gets a literal the pattern requires for a text property, a client
+     * can only match if its @prop is exactly @literal.
+     * @return false if there is no such term
+     */
+    bool getLiteral(WinProperty prop, FbTk::FbString &literal) const;
+
+    /// @return the bit for @prop in a property mask
+    static unsigned int propertyBit(WinProperty prop) { return 1u << prop; }
+
+    /**
+     * Does the pattern read any of the given properties?
+     * @param props mask of propertyBit()s
+     */
+    bool dependsOn(unsigned int props) const { return (m_properties & props) != 0; }
+
     /// Does this pattern depend on the focused window?
     bool dependsOnFocusedWindow() const;
 
@@ -92,7 +111,32 @@ public:
 
     static FbTk::FbString getProperty(WinProperty prop, const Focusable &client);
 
+    /// @return the value of a yes/no property like MAXIMIZED, false for others
+    static bool getBool(WinProperty prop, const Focusable &client);
+
+    /**
+     * Gets a numeric property: WORKSPACE, HEAD or SCREEN
+     * @return false if the client doesn't have it
+     */
+    static bool getNumber(WinProperty prop, const Focusable &client, int &number);
+
+    /// count the evaluations of all patterns and time them, see dumpStats()
+    static void setCollectStats(bool collect) { s_collect_stats = collect; }
+
+    /// prints the @count patterns that took the most time to match so far
+    static void dumpStats(std::ostream &os, size_t count);
+    /// writes the evaluations, hits and time of all patterns together as
+    /// a JSON object
+    static void writeStatsJson(std::ostream &os);
+
 private:
+    bool matchTerms(const Focusable &win) const;
+
+    /// collected while s_collect_stats is set
+    struct Stats {
+        unsigned long evaluations, hits;
+        uint64_t nsec;
+    };
     struct Term;
     friend struct Term;
     typedef std::list<Term *> Terms;
@@ -100,6 +144,10 @@ private:
     Terms m_terms; ///< our pattern is made up of a sequence of terms, currently we "and" them all
     int m_matchlimit;
     int m_nummatches;
+    unsigned int m_properties; ///< propertyBit()s of the terms
+    mutable Stats m_stats;
+
+    static bool s_collect_stats;
 };
 
 #endif // CLIENTPATTERN_HH
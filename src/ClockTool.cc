@@ -35,6 +35,7 @@
 #include "FbTk/Menu.hh"
 #include "FbTk/MenuItem.hh"
 #include "FbTk/I18n.hh"
+#include "FbTk/RequestStats.hh"
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -278,6 +279,7 @@ unsigned int ClockTool::height() const {
 }
 
 void ClockTool::updateTime() {
+    FbTk::RequestStats::Widget widget(typeid(*this));
     // update clock
     timeval now;
     gettimeofday(&now, 0);
@@ -321,9 +323,9 @@ void ClockTool::updateSizing() {
 }
 
 void ClockTool::reRender() {
-    if (m_pixmap)
-        m_screen.imageControl().removeImage(m_pixmap);
-
+    // released after the new one is rendered, so the image cache finds
+    // it again if neither size nor texture changed
+    Pixmap old_pm = m_pixmap;
     if (m_theme->texture().usePixmap()) {
         m_pixmap = m_screen.imageControl().renderImage(width(), height(),
                                                        m_theme->texture(), orientation());
@@ -332,10 +334,13 @@ void ClockTool::reRender() {
         m_pixmap = 0;
         m_button.setBackgroundColor(m_theme->texture().color());
     }
+    if (old_pm)
+        m_screen.imageControl().removeImage(old_pm);
 }
 
 
 void ClockTool::renderTheme(int alpha) {
+    FbTk::RequestStats::Widget widget(typeid(*this));
     m_button.setAlpha(alpha);
     m_button.setJustify(m_theme->justify());
 
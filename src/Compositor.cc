@@ -0,0 +1,656 @@
+// Compositor.cc for Fluxbox Window Manager
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#include "Compositor.hh"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include "Screen.hh"
+#include "FbRootWindow.hh"
+#include "Debug.hh"
+
+#include "FbTk/App.hh"
+#include "FbTk/AtomCache.hh"
+#include "FbTk/FbPixmap.hh"
+#include "FbTk/MemFun.hh"
+#include "FbTk/MemoryAccount.hh"
+#include "FbTk/RoundTrips.hh"
+
+#ifdef HAVE_COMPOSITOR
+#include <X11/Xatom.h>
+#include <X11/extensions/Xcomposite.h>
+#include <X11/extensions/Xdamage.h>
+#include <X11/extensions/Xfixes.h>
+#include <X11/extensions/Xrender.h>
+#include <X11/extensions/shape.h>
+#endif // HAVE_COMPOSITOR
+
+#include <cstdio>
+#include <iostream>
+
+using std::cerr;
+using std::endl;
+
+#ifdef HAVE_COMPOSITOR
+
+namespace {
+
+const unsigned long OPAQUE = 0xffffffff;
+
+/// counts a picture we created for the leak check, @return picture
+Picture counted(Picture picture) {
+    if (picture != None)
+        FbTk::MemoryAccount::created(FbTk::MemoryAccount::PICTURES);
+    return picture;
+}
+
+void freePicture(Display *disp, Picture picture) {
+    XRenderFreePicture(disp, picture);
+    FbTk::MemoryAccount::destroyed(FbTk::MemoryAccount::PICTURES);
+}
+
+} // end anonymous namespace
+
+struct Compositor::Win {
+    Win(): id(None), x(0), y(0), width(0), height(0), border(0),
+           mapped(false), input_only(false), argb(false),
+           opacity(OPAQUE), bypass(0),
+           damage(None), pixmap(None), picture(None), format(0) { }
+
+    unsigned int outerWidth() const { return width + 2 * border; }
+    unsigned int outerHeight() const { return height + 2 * border; }
+
+    Window id;
+    int x, y;
+    unsigned int width, height, border;
+    bool mapped, input_only;
+    bool argb; ///< has an alpha channel of its own
+    unsigned long opacity; ///< _NET_WM_WINDOW_OPACITY
+    long bypass; ///< _NET_WM_BYPASS_COMPOSITOR
+    Damage damage;
+    Pixmap pixmap;
+    Picture picture;
+    XRenderPictFormat *format;
+};
+
+Compositor *Compositor::create(BScreen &screen) {
+    Display *disp = FbTk::App::instance()->display();
+    int event_base, error_base, damage_event;
+    int major = 0, minor = 0;
+
+    // the overlay window came with Composite 0.3
+    if (!XCompositeQueryExtension(disp, &event_base, &error_base) ||
+        !XCompositeQueryVersion(disp, &major, &minor) ||
+        (major == 0 && minor < 3) ||
+        !XDamageQueryExtension(disp, &damage_event, &error_base) ||
+        !XFixesQueryExtension(disp, &event_base, &error_base) ||
+        !XRenderQueryExtension(disp, &event_base, &error_base)) {
+        cerr<<"Fluxbox: the compositor needs the Composite, Damage, XFixes and RENDER extensions"<<endl;
+        return 0;
+    }
+
+    char name[32];
+    sprintf(name, "_NET_WM_CM_S%d", screen.screenNumber());
+    Atom selection = FbTk::AtomCache::instance().get(name);
+    FBTK_ROUNDTRIP("Compositor::create");
+    if (XGetSelectionOwner(disp, selection) != None) {
+        cerr<<"Fluxbox: another compositing manager is running on screen "
+            <<screen.screenNumber()<<endl;
+        return 0;
+    }
+
+    return new Compositor(screen, damage_event, selection);
+}
+
+Compositor::Compositor(BScreen &screen, int damage_event, Atom selection):
+    m_screen(screen),
+    m_display(FbTk::App::instance()->display()),
+    m_root(screen.rootWindow().window()),
+    m_damage_event(damage_event),
+    m_selection(selection),
+    m_selection_owner(None),
+    m_opacity_atom(FbTk::AtomCache::instance().get("_NET_WM_WINDOW_OPACITY")),
+    m_bypass_atom(FbTk::AtomCache::instance().get("_NET_WM_BYPASS_COMPOSITOR")),
+    m_redirected(false),
+    m_overlay(None),
+    m_overlay_picture(None),
+    m_buffer(None),
+    m_buffer_picture(None),
+    m_buffer_width(0), m_buffer_height(0),
+    m_root_picture(None),
+    m_damage(None) {
+
+    m_paint.setFunctor(FbTk::MemFun(*this, &Compositor::paint));
+
+    m_selection_owner = XCreateSimpleWindow(m_display, m_root, -1, -1, 1, 1, 0, 0, 0);
+    FbTk::MemoryAccount::created(FbTk::MemoryAccount::WINDOWS);
+    XSetSelectionOwner(m_display, m_selection, m_selection_owner, CurrentTime);
+
+    m_damage = XFixesCreateRegion(m_display, 0, 0);
+
+    // the only time we ask for the tree, bottom to top; the notifies of
+    // the root window keep it up to date from here on
+    XGrabServer(m_display);
+    Window root, parent, *children = 0;
+    unsigned int num_children = 0;
+    FBTK_ROUNDTRIP("Compositor::Compositor");
+    if (XQueryTree(m_display, m_root, &root, &parent, &children, &num_children)) {
+        for (unsigned int i = 0; i < num_children; ++i)
+            addWindow(children[i]);
+        if (children)
+            XFree(children);
+    }
+    redirect();
+    XUngrabServer(m_display);
+
+    fbdbg<<"Compositor: screen "<<screen.screenNumber()<<", "
+         <<m_stack.size()<<" windows"<<endl;
+}
+
+Compositor::~Compositor() {
+    Stack::iterator it = m_stack.begin();
+    for (; it != m_stack.end(); ++it) {
+        freePixmap(**it);
+        if ((*it)->damage != None)
+            XDamageDestroy(m_display, (*it)->damage);
+        delete *it;
+    }
+
+    AlphaPictures::iterator alpha = m_alpha_pictures.begin();
+    for (; alpha != m_alpha_pictures.end(); ++alpha)
+        freePicture(m_display, alpha->second);
+
+    if (m_root_picture != None)
+        freePicture(m_display, m_root_picture);
+    if (m_buffer_picture != None)
+        freePicture(m_display, m_buffer_picture);
+    if (m_buffer != None)
+        FbTk::MemoryAccount::freePixmap(m_display, m_buffer);
+
+    if (m_redirected)
+        unredirect();
+
+    XFixesDestroyRegion(m_display, m_damage);
+    // gives up the selection too
+    XDestroyWindow(m_display, m_selection_owner);
+    FbTk::MemoryAccount::destroyed(FbTk::MemoryAccount::WINDOWS);
+}
+
+void Compositor::handleEvent(const XEvent &event) {
+    switch (event.type) {
+    case CreateNotify:
+        if (event.xcreatewindow.parent == m_root &&
+            find(event.xcreatewindow.window) == 0)
+            addWindow(event.xcreatewindow.window);
+        break;
+    case ConfigureNotify:
+        if (event.xconfigure.event == m_root &&
+            event.xconfigure.window != m_root)
+            configureWindow(event.xconfigure);
+        break;
+    case MapNotify:
+        if (event.xmap.event == m_root) {
+            Win *win = find(event.xmap.window);
+            if (win && !win->mapped)
+                mapWindow(*win);
+        }
+        break;
+    case UnmapNotify:
+        if (event.xunmap.event == m_root) {
+            Win *win = find(event.xunmap.window);
+            if (win && win->mapped)
+                unmapWindow(*win, false);
+        }
+        break;
+    case DestroyNotify:
+        if (event.xdestroywindow.event == m_root)
+            removeWindow(event.xdestroywindow.window, true);
+        break;
+    case ReparentNotify:
+        if (event.xreparent.event != m_root)
+            break;
+        if (event.xreparent.parent == m_root) {
+            if (find(event.xreparent.window) == 0)
+                addWindow(event.xreparent.window);
+        } else
+            removeWindow(event.xreparent.window, false);
+        break;
+    case CirculateNotify:
+        if (event.xcirculate.event == m_root) {
+            Win *win = find(event.xcirculate.window);
+            if (win == 0)
+                break;
+            m_stack.remove(win);
+            if (event.xcirculate.place == PlaceOnTop)
+                m_stack.push_back(win);
+            else
+                m_stack.push_front(win);
+            if (win->mapped)
+                damageWindow(*win);
+        }
+        break;
+    case PropertyNotify:
+        if (event.xproperty.window == m_root) {
+            if (FbTk::FbPixmap::isRootPixmapProperty(event.xproperty.atom) &&
+                m_root_picture != None) {
+                freePicture(m_display, m_root_picture);
+                m_root_picture = None;
+                damageAll();
+            }
+        } else if (event.xproperty.atom == m_opacity_atom ||
+                   event.xproperty.atom == m_bypass_atom) {
+            Win *win = find(event.xproperty.window);
+            if (win) {
+                readProperties(*win);
+                if (win->mapped)
+                    damageWindow(*win);
+            }
+        }
+        break;
+    case Expose:
+        if (event.xexpose.window == m_overlay) {
+            XRectangle rect;
+            rect.x = event.xexpose.x;
+            rect.y = event.xexpose.y;
+            rect.width = event.xexpose.width;
+            rect.height = event.xexpose.height;
+            addDamage(XFixesCreateRegion(m_display, &rect, 1));
+        }
+        break;
+    default:
+        if (event.type == m_damage_event + XDamageNotify) {
+            const XDamageNotifyEvent &notify =
+                reinterpret_cast<const XDamageNotifyEvent &>(event);
+            Damages::iterator it = m_damages.find(notify.damage);
+            if (it == m_damages.end())
+                break;
+            const Win &win = *it->second;
+            XserverRegion parts = XFixesCreateRegion(m_display, 0, 0);
+            XDamageSubtract(m_display, notify.damage, None, parts);
+            XFixesTranslateRegion(m_display, parts,
+                                  win.x + win.border, win.y + win.border);
+            addDamage(parts);
+        }
+        break;
+    }
+}
+
+Compositor::Win *Compositor::find(Window id) {
+    Windows::iterator it = m_windows.find(id);
+    return it == m_windows.end() ? 0 : it->second;
+}
+
+void Compositor::addWindow(Window id) {
+    if (id == m_overlay)
+        return;
+
+    XWindowAttributes attr;
+    FBTK_ROUNDTRIP("Compositor::addWindow");
+    if (!XGetWindowAttributes(m_display, id, &attr))
+        return;
+
+    Win *win = new Win;
+    win->id = id;
+    win->x = attr.x;
+    win->y = attr.y;
+    win->width = attr.width;
+    win->height = attr.height;
+    win->border = attr.border_width;
+    win->input_only = attr.c_class == InputOnly;
+    if (!win->input_only) {
+        win->format = XRenderFindVisualFormat(m_display, attr.visual);
+        win->argb = win->format && win->format->type == PictTypeDirect &&
+            win->format->direct.alphaMask != 0;
+        // our own windows keep the events we already asked for
+        XSelectInput(m_display, id, attr.your_event_mask | PropertyChangeMask);
+    }
+
+    m_windows[id] = win;
+    m_stack.push_back(win);
+
+    if (attr.map_state == IsViewable)
+        mapWindow(*win);
+}
+
+void Compositor::removeWindow(Window id, bool destroyed) {
+    Win *win = find(id);
+    if (win == 0)
+        return;
+
+    if (win->mapped)
+        unmapWindow(*win, destroyed);
+    m_stack.remove(win);
+    m_windows.erase(id);
+    delete win;
+}
+
+void Compositor::mapWindow(Win &win) {
+    win.mapped = true;
+    if (win.input_only)
+        return;
+
+    readProperties(win);
+    win.damage = XDamageCreate(m_display, win.id, XDamageReportNonEmpty);
+    m_damages[win.damage] = &win;
+    damageWindow(win);
+}
+
+void Compositor::unmapWindow(Win &win, bool destroyed) {
+    win.mapped = false;
+    if (win.input_only)
+        return;
+
+    damageWindow(win);
+    freePixmap(win);
+    if (win.damage != None) {
+        // the server frees it along with the window
+        if (!destroyed)
+            XDamageDestroy(m_display, win.damage);
+        m_damages.erase(win.damage);
+        win.damage = None;
+    }
+}
+
+void Compositor::configureWindow(const XConfigureEvent &event) {
+    Win *win = find(event.window);
+    if (win == 0)
+        return;
+
+    if (win->mapped)
+        damageWindow(*win);
+
+    if (win->width != (unsigned int)event.width ||
+        win->height != (unsigned int)event.height ||
+        win->border != (unsigned int)event.border_width)
+        // the server gives the window a new pixmap
+        freePixmap(*win);
+
+    win->x = event.x;
+    win->y = event.y;
+    win->width = event.width;
+    win->height = event.height;
+    win->border = event.border_width;
+    restack(*win, event.above);
+
+    if (win->mapped)
+        damageWindow(*win);
+}
+
+void Compositor::restack(Win &win, Window above) {
+    m_stack.remove(&win);
+    if (above == None) {
+        m_stack.push_front(&win);
+        return;
+    }
+
+    Stack::iterator it = m_stack.begin();
+    for (; it != m_stack.end(); ++it) {
+        if ((*it)->id == above) {
+            m_stack.insert(++it, &win);
+            return;
+        }
+    }
+    m_stack.push_back(&win);
+}
+
+void Compositor::readProperties(Win &win) {
+    Atom type;
+    int format;
+    unsigned long num, left;
+    unsigned char *data = 0;
+
+    win.opacity = OPAQUE;
+    FBTK_ROUNDTRIP("Compositor::readProperties");
+    if (XGetWindowProperty(m_display, win.id, m_opacity_atom, 0, 1, False,
+                           XA_CARDINAL, &type, &format, &num, &left,
+                           &data) == Success && data) {
+        if (format == 32 && num == 1)
+            win.opacity = *reinterpret_cast<unsigned long *>(data) & OPAQUE;
+        XFree(data);
+        data = 0;
+    }
+
+    win.bypass = 0;
+    FBTK_ROUNDTRIP("Compositor::readProperties");
+    if (XGetWindowProperty(m_display, win.id, m_bypass_atom, 0, 1, False,
+                           XA_CARDINAL, &type, &format, &num, &left,
+                           &data) == Success && data) {
+        if (format == 32 && num == 1)
+            win.bypass = *reinterpret_cast<long *>(data);
+        XFree(data);
+    }
+}
+
+void Compositor::freePixmap(Win &win) {
+    if (win.picture != None)
+        freePicture(m_display, win.picture);
+    if (win.pixmap != None) {
+        FbTk::MemoryAccount::freePixmap(m_display, win.pixmap);
+        FbTk::MemoryAccount::destroyed(FbTk::MemoryAccount::NAMED_PIXMAPS);
+    }
+    win.picture = None;
+    win.pixmap = None;
+}
+
+void Compositor::damageWindow(const Win &win) {
+    XRectangle rect;
+    rect.x = win.x;
+    rect.y = win.y;
+    rect.width = win.outerWidth();
+    rect.height = win.outerHeight();
+    addDamage(XFixesCreateRegion(m_display, &rect, 1));
+}
+
+void Compositor::damageAll() {
+    XRectangle rect;
+    rect.x = rect.y = 0;
+    rect.width = m_screen.rootWindow().width();
+    rect.height = m_screen.rootWindow().height();
+    addDamage(XFixesCreateRegion(m_display, &rect, 1));
+}
+
+void Compositor::addDamage(unsigned long region) {
+    XFixesUnionRegion(m_display, m_damage, m_damage, region);
+    XFixesDestroyRegion(m_display, region);
+    m_paint.schedule();
+}
+
+void Compositor::redirect() {
+    XCompositeRedirectSubwindows(m_display, m_root, CompositeRedirectManual);
+    m_redirected = true;
+
+    m_overlay = XCompositeGetOverlayWindow(m_display, m_root);
+    // clicks go through to the windows we show
+    XserverRegion region = XFixesCreateRegion(m_display, 0, 0);
+    XFixesSetWindowShapeRegion(m_display, m_overlay, ShapeBounding, 0, 0, None);
+    XFixesSetWindowShapeRegion(m_display, m_overlay, ShapeInput, 0, 0, region);
+    XFixesDestroyRegion(m_display, region);
+    XSelectInput(m_display, m_overlay, ExposureMask);
+
+    XRenderPictFormat *format =
+        XRenderFindVisualFormat(m_display, m_screen.rootWindow().visual());
+    XRenderPictureAttributes attr;
+    attr.subwindow_mode = IncludeInferiors;
+    m_overlay_picture = counted(XRenderCreatePicture(m_display, m_overlay, format,
+                                                     CPSubwindowMode, &attr));
+    damageAll();
+}
+
+void Compositor::unredirect() {
+    // the pixmaps of the windows go stale
+    Stack::iterator it = m_stack.begin();
+    for (; it != m_stack.end(); ++it)
+        freePixmap(**it);
+
+    if (m_overlay_picture != None)
+        freePicture(m_display, m_overlay_picture);
+    m_overlay_picture = None;
+    XCompositeReleaseOverlayWindow(m_display, m_root);
+    m_overlay = None;
+
+    XCompositeUnredirectSubwindows(m_display, m_root, CompositeRedirectManual);
+    m_redirected = false;
+}
+
+bool Compositor::coversScreen(const Win &win) const {
+    // _NET_WM_BYPASS_COMPOSITOR 2 asks to stay composited
+    return !win.argb && win.opacity == OPAQUE && win.bypass != 2 &&
+        win.x <= 0 && win.y <= 0 &&
+        win.x + (int)win.outerWidth() >= (int)m_screen.rootWindow().width() &&
+        win.y + (int)win.outerHeight() >= (int)m_screen.rootWindow().height();
+}
+
+unsigned long Compositor::alphaPicture(unsigned long opacity) {
+    unsigned int alpha = opacity >> 24;
+    AlphaPictures::iterator it = m_alpha_pictures.find(alpha);
+    if (it != m_alpha_pictures.end())
+        return it->second;
+
+    XRenderPictFormat *format = XRenderFindStandardFormat(m_display, PictStandardA8);
+    Pixmap pixmap = FbTk::MemoryAccount::createPixmap(m_display, m_root, 1, 1, 8);
+    XRenderPictureAttributes attr;
+    attr.repeat = True;
+    Picture picture = counted(XRenderCreatePicture(m_display, pixmap, format, CPRepeat, &attr));
+    FbTk::MemoryAccount::freePixmap(m_display, pixmap);
+
+    XRenderColor color;
+    color.red = color.green = color.blue = 0;
+    color.alpha = alpha * 0x101;
+    XRenderFillRectangle(m_display, PictOpSrc, picture, &color, 0, 0, 1, 1);
+
+    m_alpha_pictures[alpha] = picture;
+    return picture;
+}
+
+void Compositor::paintRoot() {
+    if (m_root_picture == None) {
+        Pixmap pixmap = FbTk::FbPixmap::getRootPixmap(m_screen.screenNumber());
+        if (pixmap == None) {
+            XRenderColor color;
+            color.red = color.green = color.blue = 0x4000;
+            color.alpha = 0xffff;
+            XRenderFillRectangle(m_display, PictOpSrc, m_buffer_picture, &color,
+                                 0, 0, m_buffer_width, m_buffer_height);
+            return;
+        }
+
+        XRenderPictFormat *format =
+            XRenderFindVisualFormat(m_display, m_screen.rootWindow().visual());
+        XRenderPictureAttributes attr;
+        attr.repeat = True;
+        m_root_picture = counted(XRenderCreatePicture(m_display, pixmap, format,
+                                                      CPRepeat, &attr));
+    }
+
+    XRenderComposite(m_display, PictOpSrc, m_root_picture, None, m_buffer_picture,
+                     0, 0, 0, 0, 0, 0, m_buffer_width, m_buffer_height);
+}
+
+void Compositor::paint() {
+    m_paint.cancel();
+
+    // nothing needs compositing below an opaque window on all of the screen
+    Win *top = 0;
+    Stack::reverse_iterator it = m_stack.rbegin();
+    for (; it != m_stack.rend() && top == 0; ++it) {
+        if ((*it)->mapped && !(*it)->input_only)
+            top = *it;
+    }
+    if (top && coversScreen(*top)) {
+        if (m_redirected)
+            unredirect();
+        XFixesSetRegion(m_display, m_damage, 0, 0);
+        return;
+    }
+    if (!m_redirected)
+        redirect(); // damages all
+
+    const unsigned int width = m_screen.rootWindow().width();
+    const unsigned int height = m_screen.rootWindow().height();
+    if (m_buffer == None || m_buffer_width != width || m_buffer_height != height) {
+        if (m_buffer_picture != None)
+            freePicture(m_display, m_buffer_picture);
+        if (m_buffer != None)
+            FbTk::MemoryAccount::freePixmap(m_display, m_buffer);
+        m_buffer = FbTk::MemoryAccount::createPixmap(m_display, m_root, width, height,
+                                 m_screen.rootWindow().depth());
+        m_buffer_picture = counted(XRenderCreatePicture(m_display, m_buffer,
+            XRenderFindVisualFormat(m_display, m_screen.rootWindow().visual()),
+            0, 0));
+        m_buffer_width = width;
+        m_buffer_height = height;
+
+        XRectangle rect;
+        rect.x = rect.y = 0;
+        rect.width = width;
+        rect.height = height;
+        XFixesSetRegion(m_display, m_damage, &rect, 1);
+    }
+
+    XFixesSetPictureClipRegion(m_display, m_buffer_picture, 0, 0, m_damage);
+    paintRoot();
+
+    Stack::iterator win_it = m_stack.begin();
+    for (; win_it != m_stack.end(); ++win_it) {
+        Win &win = **win_it;
+        if (!win.mapped || win.input_only || win.format == 0 || win.opacity == 0)
+            continue;
+
+        if (win.picture == None) {
+            win.pixmap = XCompositeNameWindowPixmap(m_display, win.id);
+            FbTk::MemoryAccount::created(FbTk::MemoryAccount::NAMED_PIXMAPS);
+            XRenderPictureAttributes attr;
+            attr.subwindow_mode = IncludeInferiors;
+            win.picture = counted(XRenderCreatePicture(m_display, win.pixmap, win.format,
+                                                       CPSubwindowMode, &attr));
+        }
+
+        Picture mask = win.opacity == OPAQUE ? None : alphaPicture(win.opacity);
+        XRenderComposite(m_display,
+                         win.argb || mask != None ? PictOpOver : PictOpSrc,
+                         win.picture, mask, m_buffer_picture,
+                         0, 0, 0, 0, win.x, win.y,
+                         win.outerWidth(), win.outerHeight());
+    }
+
+    XFixesSetPictureClipRegion(m_display, m_buffer_picture, 0, 0, None);
+    XFixesSetPictureClipRegion(m_display, m_overlay_picture, 0, 0, m_damage);
+    XRenderComposite(m_display, PictOpSrc, m_buffer_picture, None, m_overlay_picture,
+                     0, 0, 0, 0, 0, 0, width, height);
+    XFixesSetRegion(m_display, m_damage, 0, 0);
+}
+
+#else // HAVE_COMPOSITOR
+
+Compositor *Compositor::create(BScreen &screen) {
+    cerr<<"Fluxbox: built without compositor support"<<endl;
+    return 0;
+}
+
+Compositor::~Compositor() {
+}
+
+void Compositor::handleEvent(const XEvent &event) {
+}
+
+#endif // HAVE_COMPOSITOR
@@ -0,0 +1,113 @@
+// Compositor.hh for Fluxbox Window Manager
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#ifndef COMPOSITOR_HH
+#define COMPOSITOR_HH
+
+#include "FbTk/IdleTask.hh"
+#include "FbTk/NotCopyable.hh"
+
+#include <X11/Xlib.h>
+
+#include <list>
+#include <map>
+
+class BScreen;
+
+/**
+ * Composites the top level windows of a screen onto its overlay window,
+ * so _NET_WM_WINDOW_OPACITY and ARGB windows work without an external
+ * compositing manager.
+ *
+ * The stacking order follows the notifies of the root window, so
+ * painting never asks the server for the tree. Only the damaged area is
+ * painted, once per burst of events, and the screen is unredirected
+ * while an opaque window covers all of it.
+ */
+class Compositor: private FbTk::NotCopyable {
+public:
+    /// @return 0 without the Composite, Damage, XFixes and RENDER
+    ///         extensions, or if another compositing manager runs
+    static Compositor *create(BScreen &screen);
+    ~Compositor();
+
+    /// follows the windows of the screen, call it with every event
+    void handleEvent(const XEvent &event);
+
+private:
+    Compositor(BScreen &screen, int damage_event, Atom selection);
+
+    struct Win;
+    typedef std::list<Win *> Stack;
+    typedef std::map<Window, Win *> Windows;
+    typedef std::map<unsigned long, Win *> Damages;
+    typedef std::map<unsigned int, unsigned long> AlphaPictures;
+
+    Win *find(Window id);
+    void addWindow(Window id);
+    void removeWindow(Window id, bool destroyed);
+    void mapWindow(Win &win);
+    void unmapWindow(Win &win, bool destroyed);
+    void configureWindow(const XConfigureEvent &event);
+    /// puts 'win' right above 'above', at the bottom for None
+    void restack(Win &win, Window above);
+    void readProperties(Win &win);
+    void freePixmap(Win &win);
+
+    /// adds the area of 'win' to the damage
+    void damageWindow(const Win &win);
+    void damageAll();
+    /// takes over 'region'
+    void addDamage(unsigned long region);
+
+    void redirect();
+    void unredirect();
+    /// @return true if 'win' is opaque and covers the whole screen
+    bool coversScreen(const Win &win) const;
+    unsigned long alphaPicture(unsigned long opacity);
+    void paintRoot();
+    void paint();
+
+    BScreen &m_screen;
+    Display *m_display;
+    Window m_root;
+    int m_damage_event;
+    Atom m_selection;
+    Window m_selection_owner;
+    Atom m_opacity_atom, m_bypass_atom;
+
+    bool m_redirected;
+    Window m_overlay;
+    unsigned long m_overlay_picture;
+    Pixmap m_buffer;
+    unsigned long m_buffer_picture;
+    unsigned int m_buffer_width, m_buffer_height;
+    unsigned long m_root_picture;
+    unsigned long m_damage; ///< region to paint next
+
+    Stack m_stack; ///< bottom to top
+    Windows m_windows;
+    Damages m_damages; ///< the windows of the damage objects
+    AlphaPictures m_alpha_pictures;
+    FbTk::IdleTask m_paint;
+};
+
+#endif // COMPOSITOR_HH
@@ -35,6 +35,7 @@
 #include "FbTk/I18n.hh"
 #include "FbTk/stringstream.hh"
 #include "FbTk/StringUtil.hh"
+#include "FbTk/AtomCache.hh"
 #include "FbTk/Util.hh"
 
 #ifdef HAVE_CONFIG_H
@@ -252,9 +253,9 @@ protected:
     void real_execute() {
 
         WinClient& client = fbwindow().winClient();
-        Atom prop = XInternAtom(client.display(), m_name.c_str(), False);
+        Atom prop = FbTk::AtomCache::instance().get(m_name);
 
-        client.changeProperty(prop, XInternAtom(client.display(), "UTF8_STRING", False), 8,
+        client.changeProperty(prop, FbTk::AtomCache::instance().get("UTF8_STRING"), 8,
                 PropModeReplace, (unsigned char*)m_value.c_str(), m_value.size());
     }
 
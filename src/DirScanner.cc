@@ -0,0 +1,212 @@
+// DirScanner.cc for Fluxbox Window Manager
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#include "DirScanner.hh"
+
+#include "FbTk/FileUtil.hh"
+#include "FbTk/Reactor.hh"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif // HAVE_PTHREAD
+
+#ifdef HAVE_CERRNO
+  #include <cerrno>
+#else
+  #include <errno.h>
+#endif
+
+#include <algorithm>
+
+using std::string;
+
+namespace {
+
+struct ReadJobs {
+    void operator()(int fd, int events) const {
+        DirScanner::instance().update();
+    }
+};
+
+struct ByName {
+    bool operator()(const DirScanner::Entry &a, const DirScanner::Entry &b) const {
+        return a.name < b.name;
+    }
+};
+
+} // end anonymous namespace
+
+struct DirScanner::Job {
+    string directory;
+    time_t timestamp;
+    Entries entries;
+#ifdef HAVE_PTHREAD
+    pthread_t thread;
+#endif // HAVE_PTHREAD
+};
+
+DirScanner::Client::~Client() {
+    DirScanner::instance().cancel(*this);
+}
+
+DirScanner &DirScanner::instance() {
+    static DirScanner scanner;
+    return scanner;
+}
+
+DirScanner::DirScanner() {
+    m_pipe[0] = m_pipe[1] = -1;
+#ifdef HAVE_PTHREAD
+    if (pipe(m_pipe) == 0) {
+        fcntl(m_pipe[0], F_SETFL, fcntl(m_pipe[0], F_GETFL) | O_NONBLOCK);
+        fcntl(m_pipe[0], F_SETFD, FD_CLOEXEC);
+        fcntl(m_pipe[1], F_SETFD, FD_CLOEXEC);
+        FbTk::Reactor::instance().addFunctor(m_pipe[0], FbTk::Reactor::READ, ReadJobs());
+    } else
+        m_pipe[0] = m_pipe[1] = -1;
+#endif // HAVE_PTHREAD
+}
+
+DirScanner::~DirScanner() {
+    // the threads still need their jobs and the pipe
+    Jobs::iterator it = m_jobs.begin();
+    for (; it != m_jobs.end(); ++it) {
+#ifdef HAVE_PTHREAD
+        pthread_join(it->second->thread, 0);
+#endif // HAVE_PTHREAD
+        delete it->second;
+    }
+
+    if (m_pipe[0] != -1) {
+        FbTk::Reactor::instance().remove(m_pipe[0]);
+        close(m_pipe[0]);
+        close(m_pipe[1]);
+    }
+}
+
+const DirScanner::Entries *DirScanner::scan(const string &directory,
+                                            Client &client) {
+    time_t timestamp = FbTk::FileUtil::getLastStatusChangeTimestamp(directory.c_str());
+    Listings::iterator it = m_listings.find(directory);
+    if (it != m_listings.end() && it->second.timestamp == timestamp)
+        return &it->second.entries;
+
+    m_clients.insert(Clients::value_type(directory, &client));
+    if (m_jobs.find(directory) != m_jobs.end())
+        return 0;
+
+    Job *job = new Job;
+    job->directory = directory;
+
+#ifdef HAVE_PTHREAD
+    if (m_pipe[1] != -1 &&
+        pthread_create(&job->thread, 0, threadMain, job) == 0) {
+        m_jobs[directory] = job;
+        return 0;
+    }
+#endif // HAVE_PTHREAD
+
+    // list it ourselves then
+    cancel(client);
+    list(*job);
+    Listing &listing = m_listings[directory];
+    listing.timestamp = job->timestamp;
+    listing.entries.swap(job->entries);
+    delete job;
+    return &listing.entries;
+}
+
+void DirScanner::cancel(Client &client) {
+    Clients::iterator it = m_clients.begin();
+    while (it != m_clients.end()) {
+        if (it->second == &client)
+            m_clients.erase(it++);
+        else
+            ++it;
+    }
+}
+
+void DirScanner::update() {
+    Job *job;
+    ssize_t size;
+    while ((size = read(m_pipe[0], &job, sizeof(job))) == sizeof(job))
+        finish(job);
+}
+
+void DirScanner::list(Job &job) {
+    // the timestamp before reading, so changes while we read make the
+    // listing outdated
+    job.timestamp = FbTk::FileUtil::getLastStatusChangeTimestamp(job.directory.c_str());
+
+    FbTk::Directory dir(job.directory.c_str());
+    job.entries.resize(dir.entries());
+    for (size_t i = 0; i < job.entries.size(); ++i) {
+        Entry &entry = job.entries[i];
+        entry.name = dir.readFilename();
+        string path(job.directory + '/' + entry.name);
+        entry.regular = FbTk::FileUtil::isRegularFile(path.c_str());
+        entry.style = !entry.regular &&
+            (FbTk::FileUtil::isRegularFile((path + "/theme.cfg").c_str()) ||
+             FbTk::FileUtil::isRegularFile((path + "/style.cfg").c_str()));
+    }
+
+    std::sort(job.entries.begin(), job.entries.end(), ByName());
+}
+
+#ifdef HAVE_PTHREAD
+void *DirScanner::threadMain(void *arg) {
+    Job *job = static_cast<Job *>(arg);
+    list(*job);
+
+    // a pointer is written in one piece, and update() joins us
+    int fd = instance().m_pipe[1];
+    while (write(fd, &job, sizeof(job)) == -1 && errno == EINTR)
+        ;
+    return 0;
+}
+#endif // HAVE_PTHREAD
+
+void DirScanner::finish(Job *job) {
+#ifdef HAVE_PTHREAD
+    pthread_join(job->thread, 0);
+#endif // HAVE_PTHREAD
+    m_jobs.erase(job->directory);
+
+    Listing &listing = m_listings[job->directory];
+    listing.timestamp = job->timestamp;
+    listing.entries.swap(job->entries);
+
+    // clients may wait for other directories again while we call them
+    std::vector<Client *> clients;
+    Clients::iterator it = m_clients.lower_bound(job->directory);
+    Clients::iterator it_end = m_clients.upper_bound(job->directory);
+    for (; it != it_end; ++it)
+        clients.push_back(it->second);
+    m_clients.erase(job->directory);
+    string directory(job->directory);
+    delete job;
+
+    for (size_t i = 0; i < clients.size(); ++i)
+        clients[i]->scanned(m_listings[directory].entries);
+}
@@ -0,0 +1,101 @@
+// DirScanner.hh for Fluxbox Window Manager
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#ifndef DIRSCANNER_HH
+#define DIRSCANNER_HH
+
+#include "FbTk/NotCopyable.hh"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <sys/types.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * Lists the directories of [stylesdir] and [wallpapers] menu entries in a
+ * thread, so a slow file system doesn't block the event loop while a menu
+ * is built. The listings are kept until the status change time of their
+ * directory changes; menus that use a directory are reloaded then anyway,
+ * by the AutoReloadHelper watching it.
+ *
+ * Without pthreads, directories are listed right away.
+ */
+class DirScanner: private FbTk::NotCopyable {
+public:
+    struct Entry {
+        std::string name;
+        bool regular; ///< a regular file
+        bool style; ///< a directory with a theme.cfg or style.cfg
+    };
+    /// sorted by name
+    typedef std::vector<Entry> Entries;
+
+    /// waits for the entries of a directory
+    class Client {
+    public:
+        virtual ~Client();
+        virtual void scanned(const Entries &entries) = 0;
+    };
+
+    static DirScanner &instance();
+
+    /**
+     * @return the entries of 'directory' if they're known, else 0 and
+     *         'client' gets them once they are
+     */
+    const Entries *scan(const std::string &directory, Client &client);
+    /// 'client' doesn't wait for anything anymore
+    void cancel(Client &client);
+
+    /// reads the finished scans
+    void update();
+
+private:
+    DirScanner();
+    ~DirScanner();
+
+    struct Job;
+    struct Listing {
+        time_t timestamp;
+        Entries entries;
+    };
+    typedef std::map<std::string, Listing> Listings;
+    typedef std::map<std::string, Job *> Jobs;
+    typedef std::multimap<std::string, Client *> Clients;
+
+    static void list(Job &job);
+#ifdef HAVE_PTHREAD
+    static void *threadMain(void *job);
+#endif // HAVE_PTHREAD
+    void finish(Job *job);
+
+    Listings m_listings;
+    Jobs m_jobs;
+    Clients m_clients;
+    int m_pipe[2]; ///< the threads write their finished jobs here
+};
+
+#endif // DIRSCANNER_HH
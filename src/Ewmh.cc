@@ -29,21 +29,28 @@
 #include "fluxbox.hh"
 #include "FbWinFrameTheme.hh"
 #include "FocusControl.hh"
+#include "FbAtoms.hh"
 #include "Debug.hh"
 
 #include "FbTk/App.hh"
+#include "FbTk/ArgbKernels.hh"
+#include "FbTk/AtomCache.hh"
 #include "FbTk/FbWindow.hh"
 #include "FbTk/I18n.hh"
 #include "FbTk/LayerItem.hh"
 #include "FbTk/Layer.hh"
 #include "FbTk/FbPixmap.hh"
+#include "FbTk/IconCache.hh"
+#include "FbTk/IdleTask.hh"
+#include "FbTk/MemFun.hh"
+#include "FbTk/MultLayers.hh"
+#include "FbTk/RefCount.hh"
 
 #include <X11/Xproto.h>
 #include <X11/Xatom.h>
 
 #include <iostream>
 #include <algorithm>
-#include <new>
 
 #ifdef HAVE_CSTRING
   #include <cstring>
@@ -63,16 +70,64 @@ using std::endl;
 using std::vector;
 using std::list;
 
-// mipspro has no new(nothrow)
-#if defined sgi && ! defined GCC
-#define FB_new_nothrow new
-#else
-#define FB_new_nothrow new(std::nothrow)
-#endif
-
 
 namespace {
 
+/// icons are shown at about the height of a titlebar or the toolbar
+const unsigned long PREFERRED_ICON_SIZE = 32;
+/// larger icons are only used if there is nothing else
+const unsigned long MAX_ICON_SIZE = 256;
+
+/// FNV-1a over the 32 bits of each pixel of an icon
+uint64_t hashIcon(const unsigned long *pixels, unsigned long size) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned long i = 0; i < size; ++i) {
+        unsigned long pixel = pixels[i];
+        for (int byte = 0; byte < 4; ++byte, pixel >>= 8) {
+            hash ^= pixel & 0xff;
+            hash *= 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+/// pixel of an rgb color in the visual of 'img'
+unsigned long visualPixel(const XImage &img, unsigned int rgb) {
+
+    unsigned char r = ( rgb & 0x00ff0000 ) >> 16;
+    unsigned char g = ( rgb & 0x0000ff00 ) >> 8;
+    unsigned char b = ( rgb & 0x000000ff );
+
+    // 15 bit display, 5R 5G 5B
+    if (img.red_mask == 0x7c00
+        && img.green_mask == 0x03e0
+        && img.blue_mask == 0x1f) {
+
+        return ((r << 7) & 0x7c00) | ((g << 2) & 0x03e0) | ((b >> 3) & 0x001f);
+
+    // 16 bit display, 5R 6G 5B
+    } else if (img.red_mask == 0xf800
+               && img.green_mask == 0x07e0
+               && img.blue_mask == 0x1f) {
+
+        return ((r << 8) & 0xf800) | ((g << 3) & 0x07e0) | ((b >> 3) & 0x001f);
+
+    // 24/32 bit display, 8R 8G 8B
+    } else if (img.red_mask == 0xff0000
+               && img.green_mask == 0xff00
+               && img.blue_mask == 0xff) {
+
+        return rgb;
+    }
+
+    return 0;
+}
+
+int hostByteOrder() {
+    unsigned int one = 1;
+    return *reinterpret_cast<unsigned char*>(&one) ? LSBFirst : MSBFirst;
+}
+
 /* From Extended Window Manager Hints, draft 1.3:
  *
  * _NET_WM_ICON CARDINAL[][2+n]/32
@@ -208,10 +263,31 @@ void extractNetWmIcon(Atom net_wm_icon, WinClient& winclient) {
     Drawable parent = winclient.screen().rootWindow().drawable();
     unsigned int depth = DefaultDepth(dpy, scrn);
 
-    // pick the smallest icon size atm
-    // TODO: find a better criteria
-    width = icon_data.begin()->first.first;
-    height = icon_data.begin()->first.second;
+    // pick the smallest icon that doesn't have to be scaled up, or else
+    // the largest one up to MAX_ICON_SIZE; only that one gets decoded
+    IconContainer::const_iterator best = icon_data.begin();
+    IconContainer::const_iterator it = icon_data.begin();
+    for (; it != icon_data.end(); ++it) {
+        unsigned long w = it->first.first;
+        unsigned long h = it->first.second;
+        if (w > MAX_ICON_SIZE || h > MAX_ICON_SIZE)
+            continue;
+        best = it;
+        if (w >= PREFERRED_ICON_SIZE && h >= PREFERRED_ICON_SIZE)
+            break;
+    }
+    width = best->first.first;
+    height = best->first.second;
+
+    // windows of the same application share the decoded icon
+    FbTk::IconCache &cache = FbTk::IconCache::instance();
+    uint64_t hash = hashIcon(best->second, width * height);
+    FbTk::RefCount<FbTk::PixmapWithMask> shared = cache.findData(hash, width, height, scrn);
+    if (shared) {
+        XFree(raw_data);
+        winclient.setIcon(shared);
+        return;
+    }
 
     // tmp image for the pixmap
     XImage* img_pm = XCreateImage(dpy, DefaultVisual(dpy, scrn), depth,
@@ -238,72 +314,70 @@ void extractNetWmIcon(Atom net_wm_icon, WinClient& winclient) {
     img_mask->data = static_cast<char*>(malloc(img_mask->bytes_per_line * height));
 
 
-    const unsigned long* src = icon_data.begin()->second;
-    unsigned int rgba;
-    unsigned long pixel;
+    const unsigned long* src = best->second;
+    std::vector<unsigned int> rgb(width);
+    std::vector<unsigned char> opaque(width);
+    const FbTk::ArgbKernels::Impl &kernels = FbTk::ArgbKernels::best();
+
+    // rows of 32 bit pixels in our byte order, and masks numbering their
+    // bits like their bytes, are written directly. everything else goes
+    // through XPutPixel.
+    const bool direct_pm = img_pm->bits_per_pixel == 32 &&
+        img_pm->byte_order == hostByteOrder() &&
+        img_pm->red_mask == 0xff0000 &&
+        img_pm->green_mask == 0xff00 &&
+        img_pm->blue_mask == 0xff;
+    const bool direct_mask = img_mask->bitmap_bit_order == img_mask->byte_order;
+    const bool msb_first = img_mask->bitmap_bit_order == MSBFirst;
     unsigned long x;
     unsigned long y;
-    unsigned char r, g, b, a;
-
-    for (y = 0; y < height; y++) {
-        for (x = 0; x < width; x++, src++) {
-
-            rgba = *src; // use only 32bit
-
-            a = ( rgba & 0xff000000 ) >> 24;
-            r = ( rgba & 0x00ff0000 ) >> 16;
-            g = ( rgba & 0x0000ff00 ) >> 8;
-            b = ( rgba & 0x000000ff );
-
-            // 15 bit display, 5R 5G 5B
-            if (img_pm->red_mask == 0x7c00
-                && img_pm->green_mask == 0x03e0
-                && img_pm->blue_mask == 0x1f) {
 
-                pixel = ((r << 7) & 0x7c00) | ((g << 2) & 0x03e0) | ((b >> 3) & 0x001f);
+    for (y = 0; y < height; y++, src += width) {
 
-            // 16 bit display, 5R 6G 5B
-            } else if (img_pm->red_mask == 0xf800
-                       && img_pm->green_mask == 0x07e0
-                       && img_pm->blue_mask == 0x1f) {
+        kernels.split(&rgb[0], &opaque[0], src, width, 127);
 
-                pixel = ((r << 8) & 0xf800) | ((g << 3) & 0x07e0) | ((b >> 3) & 0x001f);
-
-            // 24/32 bit display, 8R 8G 8B
-            } else if (img_pm->red_mask == 0xff0000
-                       && img_pm->green_mask == 0xff00
-                       && img_pm->blue_mask == 0xff) {
-
-                pixel = rgba & 0x00ffffff;
+        // transfer rgb data
+        if (direct_pm) {
+            memcpy(img_pm->data + y * img_pm->bytes_per_line, &rgb[0],
+                   width * sizeof(unsigned int));
+        } else {
+            for (x = 0; x < width; x++)
+                XPutPixel(img_pm, x, y, visualPixel(*img_pm, rgb[x]));
+        }
 
-            } else {
-                pixel = 0;
+        // transfer mask data, the gc draws cleared bits in its foreground
+        // (1) and set bits in its background (0)
+        if (direct_mask) {
+            unsigned char *bits = reinterpret_cast<unsigned char*>(img_mask->data) +
+                y * img_mask->bytes_per_line;
+            memset(bits, 0, (width + 7) / 8);
+            for (x = 0; x < width; x++) {
+                if (!opaque[x])
+                    bits[x / 8] |= msb_first ? 0x80 >> (x % 8) : 1 << (x % 8);
             }
-
-            // transfer rgb data
-            XPutPixel(img_pm, x, y, pixel);
-
-            // transfer mask data
-            XPutPixel(img_mask, x, y, a > 127 ? 0 : 1);
+        } else {
+            for (x = 0; x < width; x++)
+                XPutPixel(img_mask, x, y, opaque[x] ? 0 : 1);
         }
     }
 
     // the final icon
-    FbTk::PixmapWithMask icon;
-    icon.pixmap() = FbTk::FbPixmap(parent, width, height, depth);
-    icon.mask() = FbTk::FbPixmap(parent, width, height, 1);
+    FbTk::RefCount<FbTk::PixmapWithMask> icon(new FbTk::PixmapWithMask());
+    icon->pixmap() = FbTk::FbPixmap(parent, width, height, depth);
+    icon->mask() = FbTk::FbPixmap(parent, width, height, 1);
 
-    FbTk::GContext gc_pm(icon.pixmap());
-    FbTk::GContext gc_mask(icon.mask());
+    FbTk::GContext gc_pm(icon->pixmap());
+    FbTk::GContext gc_mask(icon->mask());
 
-    XPutImage(dpy, icon.pixmap().drawable(), gc_pm.gc(), img_pm, 0, 0, 0, 0, width, height);
-    XPutImage(dpy, icon.mask().drawable(), gc_mask.gc(), img_mask, 0, 0, 0, 0, width, height);
+    XPutImage(dpy, icon->pixmap().drawable(), gc_pm.gc(), img_pm, 0, 0, 0, 0, width, height);
+    XPutImage(dpy, icon->mask().drawable(), gc_mask.gc(), img_mask, 0, 0, 0, 0, width, height);
 
     XDestroyImage(img_pm);   // frees img_pm->data as well
     XDestroyImage(img_mask); // frees img_mask->data as well
 
     XFree(raw_data);
 
+    cache.insertData(hash, width, height, scrn, icon);
     winclient.setIcon(icon);
 }
 
@@ -312,85 +386,14 @@ void extractNetWmIcon(Atom net_wm_icon, WinClient& winclient) {
 class Ewmh::EwmhAtoms {
 public:
 
-    EwmhAtoms() {
-        Display *disp = FbTk::App::instance()->display();
-
-        supported = XInternAtom(disp, "_NET_SUPPORTED", False);
-        client_list = XInternAtom(disp, "_NET_CLIENT_LIST", False);
-        client_list_stacking = XInternAtom(disp, "_NET_CLIENT_LIST_STACKING", False);
-        number_of_desktops = XInternAtom(disp, "_NET_NUMBER_OF_DESKTOPS", False);
-        desktop_geometry = XInternAtom(disp, "_NET_DESKTOP_GEOMETRY", False);
-        desktop_viewport = XInternAtom(disp, "_NET_DESKTOP_VIEWPORT", False);
-        current_desktop = XInternAtom(disp, "_NET_CURRENT_DESKTOP", False);
-        desktop_names = XInternAtom(disp, "_NET_DESKTOP_NAMES", False);
-        active_window = XInternAtom(disp, "_NET_ACTIVE_WINDOW", False);
-        workarea = XInternAtom(disp, "_NET_WORKAREA", False);
-        supporting_wm_check = XInternAtom(disp, "_NET_SUPPORTING_WM_CHECK", False);
-        virtual_roots = XInternAtom(disp, "_NET_VIRTUAL_ROOTS", False);
-
-        close_window = XInternAtom(disp, "_NET_CLOSE_WINDOW", False);
-        moveresize_window = XInternAtom(disp, "_NET_MOVERESIZE_WINDOW", False);
-        restack_window = XInternAtom(disp, "_NET_RESTACK_WINDOW", False);
-        request_frame_extents = XInternAtom(disp,
-                "_NET_REQUEST_FRAME_EXTENTS", False);
-
-
-        wm_moveresize = XInternAtom(disp, "_NET_WM_MOVERESIZE", False);
-
-        properties = XInternAtom(disp, "_NET_PROPERTIES", False);
-        wm_name = XInternAtom(disp, "_NET_WM_NAME", False);
-        wm_icon_name = XInternAtom(disp, "_NET_WM_ICON_NAME", False);
-        wm_desktop = XInternAtom(disp, "_NET_WM_DESKTOP", False);
-
-        // type atoms
-        wm_window_type = XInternAtom(disp, "_NET_WM_WINDOW_TYPE", False);
-        wm_window_type_dock = XInternAtom(disp, "_NET_WM_WINDOW_TYPE_DOCK", False);
-        wm_window_type_desktop = XInternAtom(disp, "_NET_WM_WINDOW_TYPE_DESKTOP", False);
-        wm_window_type_splash = XInternAtom(disp, "_NET_WM_WINDOW_TYPE_SPLASH", False);
-        wm_window_type_dialog = XInternAtom(disp, "_NET_WM_WINDOW_TYPE_DIALOG", False);
-        wm_window_type_menu = XInternAtom(disp, "_NET_WM_WINDOW_TYPE_MENU", False);
-        wm_window_type_toolbar = XInternAtom(disp, "_NET_WM_WINDOW_TYPE_TOOLBAR", False);
-        wm_window_type_normal = XInternAtom(disp, "_NET_WM_WINDOW_TYPE_NORMAL", False);
-
-        // state atom and the supported state atoms
-        wm_state = XInternAtom(disp, "_NET_WM_STATE", False);
-        wm_state_sticky = XInternAtom(disp, "_NET_WM_STATE_STICKY", False);
-        wm_state_shaded = XInternAtom(disp, "_NET_WM_STATE_SHADED", False);
-        wm_state_maximized_horz = XInternAtom(disp, "_NET_WM_STATE_MAXIMIZED_HORZ", False);
-        wm_state_maximized_vert = XInternAtom(disp, "_NET_WM_STATE_MAXIMIZED_VERT", False);
-        wm_state_fullscreen = XInternAtom(disp, "_NET_WM_STATE_FULLSCREEN", False);
-        wm_state_hidden = XInternAtom(disp, "_NET_WM_STATE_HIDDEN", False);
-        wm_state_skip_taskbar = XInternAtom(disp, "_NET_WM_STATE_SKIP_TASKBAR", False);
-        wm_state_skip_pager = XInternAtom(disp, "_NET_WM_STATE_SKIP_PAGER", False);
-        wm_state_above = XInternAtom(disp, "_NET_WM_STATE_ABOVE", False);
-        wm_state_below = XInternAtom(disp, "_NET_WM_STATE_BELOW", False);
-        wm_state_modal = XInternAtom(disp, "_NET_WM_STATE_MODAL", False);
-        wm_state_demands_attention = XInternAtom(disp, "_NET_WM_STATE_DEMANDS_ATTENTION", False);
-
-        // allowed actions
-        wm_allowed_actions = XInternAtom(disp, "_NET_WM_ALLOWED_ACTIONS", False);
-        wm_action_move = XInternAtom(disp, "_NET_WM_ACTION_MOVE", False);
-        wm_action_resize = XInternAtom(disp, "_NET_WM_ACTION_RESIZE", False);
-        wm_action_minimize = XInternAtom(disp, "_NET_WM_ACTION_MINIMIZE", False);
-        wm_action_shade = XInternAtom(disp, "_NET_WM_ACTION_SHADE", False);
-        wm_action_stick = XInternAtom(disp, "_NET_WM_ACTION_STICK", False);
-        wm_action_maximize_horz = XInternAtom(disp, "_NET_WM_ACTION_MAXIMIZE_HORZ", False);
-        wm_action_maximize_vert = XInternAtom(disp, "_NET_WM_ACTION_MAXIMIZE_VERT", False);
-        wm_action_fullscreen = XInternAtom(disp, "_NET_WM_ACTION_FULLSCREEN", False);
-        wm_action_change_desktop = XInternAtom(disp, "_NET_WM_ACTION_CHANGE_DESKTOP", False);
-        wm_action_close = XInternAtom(disp, "_NET_WM_ACTION_CLOSE", False);
-
-        wm_strut = XInternAtom(disp, "_NET_WM_STRUT", False);
-        wm_icon_geometry = XInternAtom(disp, "_NET_WM_ICON_GEOMETRY", False);
-        wm_icon = XInternAtom(disp, "_NET_WM_ICON", False);
-        wm_pid = XInternAtom(disp, "_NET_WM_PID", False);
-        wm_handled_icons = XInternAtom(disp, "_NET_WM_HANDLED_ICONS", False);
-
-        frame_extents = XInternAtom(disp, "_NET_FRAME_EXTENTS", False);
-
-        wm_ping = XInternAtom(disp, "_NET_WM_PING", False);
-        utf8_string = XInternAtom(disp, "UTF8_STRING", False);
+    EwmhAtoms();
+
+    struct Name {
+        const char *name;
+        Atom EwmhAtoms::*atom;
     };
+    static const Name s_names[];
+    static FbTk::AtomCache::Names s_queued; ///< interned with the others
 
     // root window properties
     Atom supported,
@@ -461,6 +464,7 @@ public:
          wm_icon,
          wm_pid,
          wm_handled_icons,
+         wm_bypass_compositor,
 
          frame_extents;
 
@@ -470,6 +474,92 @@ public:
     Atom utf8_string;
 };
 
+const Ewmh::EwmhAtoms::Name Ewmh::EwmhAtoms::s_names[] = {
+    { "_NET_SUPPORTED", &Ewmh::EwmhAtoms::supported },
+    { "_NET_CLIENT_LIST", &Ewmh::EwmhAtoms::client_list },
+    { "_NET_CLIENT_LIST_STACKING", &Ewmh::EwmhAtoms::client_list_stacking },
+    { "_NET_NUMBER_OF_DESKTOPS", &Ewmh::EwmhAtoms::number_of_desktops },
+    { "_NET_DESKTOP_GEOMETRY", &Ewmh::EwmhAtoms::desktop_geometry },
+    { "_NET_DESKTOP_VIEWPORT", &Ewmh::EwmhAtoms::desktop_viewport },
+    { "_NET_CURRENT_DESKTOP", &Ewmh::EwmhAtoms::current_desktop },
+    { "_NET_DESKTOP_NAMES", &Ewmh::EwmhAtoms::desktop_names },
+    { "_NET_ACTIVE_WINDOW", &Ewmh::EwmhAtoms::active_window },
+    { "_NET_WORKAREA", &Ewmh::EwmhAtoms::workarea },
+    { "_NET_SUPPORTING_WM_CHECK", &Ewmh::EwmhAtoms::supporting_wm_check },
+    { "_NET_VIRTUAL_ROOTS", &Ewmh::EwmhAtoms::virtual_roots },
+
+    { "_NET_CLOSE_WINDOW", &Ewmh::EwmhAtoms::close_window },
+    { "_NET_MOVERESIZE_WINDOW", &Ewmh::EwmhAtoms::moveresize_window },
+    { "_NET_RESTACK_WINDOW", &Ewmh::EwmhAtoms::restack_window },
+    { "_NET_REQUEST_FRAME_EXTENTS", &Ewmh::EwmhAtoms::request_frame_extents },
+
+    { "_NET_WM_MOVERESIZE", &Ewmh::EwmhAtoms::wm_moveresize },
+
+    { "_NET_PROPERTIES", &Ewmh::EwmhAtoms::properties },
+    { "_NET_WM_NAME", &Ewmh::EwmhAtoms::wm_name },
+    { "_NET_WM_ICON_NAME", &Ewmh::EwmhAtoms::wm_icon_name },
+    { "_NET_WM_DESKTOP", &Ewmh::EwmhAtoms::wm_desktop },
+
+    // type atoms
+    { "_NET_WM_WINDOW_TYPE", &Ewmh::EwmhAtoms::wm_window_type },
+    { "_NET_WM_WINDOW_TYPE_DOCK", &Ewmh::EwmhAtoms::wm_window_type_dock },
+    { "_NET_WM_WINDOW_TYPE_DESKTOP", &Ewmh::EwmhAtoms::wm_window_type_desktop },
+    { "_NET_WM_WINDOW_TYPE_SPLASH", &Ewmh::EwmhAtoms::wm_window_type_splash },
+    { "_NET_WM_WINDOW_TYPE_DIALOG", &Ewmh::EwmhAtoms::wm_window_type_dialog },
+    { "_NET_WM_WINDOW_TYPE_MENU", &Ewmh::EwmhAtoms::wm_window_type_menu },
+    { "_NET_WM_WINDOW_TYPE_TOOLBAR", &Ewmh::EwmhAtoms::wm_window_type_toolbar },
+    { "_NET_WM_WINDOW_TYPE_NORMAL", &Ewmh::EwmhAtoms::wm_window_type_normal },
+
+    // state atom and the supported state atoms
+    { "_NET_WM_STATE", &Ewmh::EwmhAtoms::wm_state },
+    { "_NET_WM_STATE_STICKY", &Ewmh::EwmhAtoms::wm_state_sticky },
+    { "_NET_WM_STATE_SHADED", &Ewmh::EwmhAtoms::wm_state_shaded },
+    { "_NET_WM_STATE_MAXIMIZED_HORZ", &Ewmh::EwmhAtoms::wm_state_maximized_horz },
+    { "_NET_WM_STATE_MAXIMIZED_VERT", &Ewmh::EwmhAtoms::wm_state_maximized_vert },
+    { "_NET_WM_STATE_FULLSCREEN", &Ewmh::EwmhAtoms::wm_state_fullscreen },
+    { "_NET_WM_STATE_HIDDEN", &Ewmh::EwmhAtoms::wm_state_hidden },
+    { "_NET_WM_STATE_SKIP_TASKBAR", &Ewmh::EwmhAtoms::wm_state_skip_taskbar },
+    { "_NET_WM_STATE_SKIP_PAGER", &Ewmh::EwmhAtoms::wm_state_skip_pager },
+    { "_NET_WM_STATE_ABOVE", &Ewmh::EwmhAtoms::wm_state_above },
+    { "_NET_WM_STATE_BELOW", &Ewmh::EwmhAtoms::wm_state_below },
+    { "_NET_WM_STATE_MODAL", &Ewmh::EwmhAtoms::wm_state_modal },
+    { "_NET_WM_STATE_DEMANDS_ATTENTION", &Ewmh::EwmhAtoms::wm_state_demands_attention },
+
+    // allowed actions
+    { "_NET_WM_ALLOWED_ACTIONS", &Ewmh::EwmhAtoms::wm_allowed_actions },
+    { "_NET_WM_ACTION_MOVE", &Ewmh::EwmhAtoms::wm_action_move },
+    { "_NET_WM_ACTION_RESIZE", &Ewmh::EwmhAtoms::wm_action_resize },
+    { "_NET_WM_ACTION_MINIMIZE", &Ewmh::EwmhAtoms::wm_action_minimize },
+    { "_NET_WM_ACTION_SHADE", &Ewmh::EwmhAtoms::wm_action_shade },
+    { "_NET_WM_ACTION_STICK", &Ewmh::EwmhAtoms::wm_action_stick },
+    { "_NET_WM_ACTION_MAXIMIZE_HORZ", &Ewmh::EwmhAtoms::wm_action_maximize_horz },
+    { "_NET_WM_ACTION_MAXIMIZE_VERT", &Ewmh::EwmhAtoms::wm_action_maximize_vert },
+    { "_NET_WM_ACTION_FULLSCREEN", &Ewmh::EwmhAtoms::wm_action_fullscreen },
+    { "_NET_WM_ACTION_CHANGE_DESKTOP", &Ewmh::EwmhAtoms::wm_action_change_desktop },
+    { "_NET_WM_ACTION_CLOSE", &Ewmh::EwmhAtoms::wm_action_close },
+
+    { "_NET_WM_STRUT", &Ewmh::EwmhAtoms::wm_strut },
+    { "_NET_WM_ICON_GEOMETRY", &Ewmh::EwmhAtoms::wm_icon_geometry },
+    { "_NET_WM_ICON", &Ewmh::EwmhAtoms::wm_icon },
+    { "_NET_WM_PID", &Ewmh::EwmhAtoms::wm_pid },
+    { "_NET_WM_HANDLED_ICONS", &Ewmh::EwmhAtoms::wm_handled_icons },
+    { "_NET_WM_BYPASS_COMPOSITOR", &Ewmh::EwmhAtoms::wm_bypass_compositor },
+
+    { "_NET_FRAME_EXTENTS", &Ewmh::EwmhAtoms::frame_extents },
+
+    { "_NET_WM_PING", &Ewmh::EwmhAtoms::wm_ping },
+    { "UTF8_STRING", &Ewmh::EwmhAtoms::utf8_string }
+};
+
+FbTk::AtomCache::Names Ewmh::EwmhAtoms::s_queued(Ewmh::EwmhAtoms::s_names,
+        sizeof(Ewmh::EwmhAtoms::s_names) / sizeof(Ewmh::EwmhAtoms::s_names[0]));
+
+Ewmh::EwmhAtoms::EwmhAtoms() {
+    FbTk::AtomCache &cache = FbTk::AtomCache::instance();
+    for (size_t i = 0; i < sizeof(s_names) / sizeof(s_names[0]); ++i)
+        this->*s_names[i].atom = cache.get(s_names[i].name);
+}
+
 
 enum EwmhMoveResizeDirection {
     _NET_WM_MOVERESIZE_SIZE_TOPLEFT    =   0,
@@ -486,12 +576,64 @@ enum EwmhMoveResizeDirection {
     _NET_WM_MOVERESIZE_CANCEL           = 11    // cancel operation
 };
 
+/**
+ * Keeps what the client list properties of a screen hold, so adding a
+ * window only appends it. Changes to the clients and to the stacking
+ * order are written once the event queue is empty.
+ */
+class Ewmh::ClientLists {
+public:
+    ClientLists(BScreen &screen, Atom client_list, Atom client_list_stacking):
+        m_screen(screen),
+        m_client_list(client_list),
+        m_client_list_stacking(client_list_stacking) {
+        m_update.setFunctor(FbTk::MemFun(*this, &ClientLists::update));
+        m_tracker.join(screen.layerManager().stackingSig(),
+                       FbTk::MemFun(m_update, &FbTk::IdleTask::schedule));
+    }
+
+    void schedule() { m_update.schedule(); }
+    void update();
+
+private:
+    /// a client in a frame, sorted by the layer item of the frame, then
+    /// in creation order
+    struct Framed {
+        const FbTk::LayerItem *item;
+        size_t order;
+        Window window;
+        bool stacked;
+
+        bool operator < (const Framed &other) const {
+            return item != other.item ? item < other.item : order < other.order;
+        }
+    };
+
+    /// takes new_list as the new property and keeps old_list for reuse
+    void changeProperty(Atom property, vector<Window> &old_list,
+                        vector<Window> &new_list);
+
+    BScreen &m_screen;
+    Atom m_client_list, m_client_list_stacking;
+    vector<Window> m_clients; ///< in creation order
+    vector<Window> m_stacking; ///< bottom to top
+    // reused by update(), so it doesn't allocate once they are large enough
+    vector<Window> m_new_clients, m_new_stacking;
+    vector<Framed> m_framed;
+    FbTk::IdleTask m_update;
+    FbTk::SignalTracker m_tracker;
+};
+
 Ewmh::Ewmh() {
     setName("ewmh");
     m_net = new EwmhAtoms;
+    m_flush.setFunctor(FbTk::MemFun(*this, &Ewmh::flush));
 }
 
 Ewmh::~Ewmh() {
+    ClientListsMap::iterator it = m_client_lists.begin();
+    for (; it != m_client_lists.end(); ++it)
+        delete it->second;
     delete m_net;
 }
 
@@ -533,6 +675,7 @@ void Ewmh::initForScreen(BScreen &screen) {
     Atom atomsupported[] = {
         // window properties
         m_net->wm_strut,
+        m_net->wm_bypass_compositor,
         m_net->wm_state,
         m_net->wm_name,
         m_net->wm_icon,
@@ -590,6 +733,9 @@ void Ewmh::initForScreen(BScreen &screen) {
 
         m_net->frame_extents,
 
+        FbAtoms::instance()->getNetWMSyncRequestAtom(),
+        FbAtoms::instance()->getNetWMSyncRequestCounterAtom(),
+
         // desktop properties
         m_net->wm_desktop,
         m_net->desktop_names,
@@ -621,7 +767,12 @@ void Ewmh::initForScreen(BScreen &screen) {
     updateWorkspaceCount(screen);
     updateCurrentWorkspace(screen);
     updateWorkspaceNames(screen);
-    updateClientList(screen);
+
+    ClientLists *&lists = m_client_lists[&screen];
+    if (lists == 0)
+        lists = new ClientLists(screen, m_net->client_list, m_net->client_list_stacking);
+    lists->update();
+
     updateViewPort(screen);
     updateGeometry(screen);
     updateWorkarea(screen);
@@ -716,33 +867,33 @@ void Ewmh::setupFrame(FluxboxWindow &win) {
         updateWorkspace(win);
     }
 
-    updateFrameExtents(win);
+    markDirty(win, (1 << PROP_FRAME_EXTENTS) | (1 << PROP_BYPASS_COMPOSITOR));
 
 }
 
 void Ewmh::updateFrameClose(FluxboxWindow &win) {
+    // the clients that are left keep the pending properties, in particular
+    // for the next window manager when we shut down
+    std::map<FluxboxWindow *, unsigned int>::iterator it = m_dirty.find(&win);
+    if (it != m_dirty.end()) {
+        unsigned int properties = it->second;
+        m_dirty.erase(it);
+        flushWindow(win, properties);
+    }
+    m_bypass_compositor.erase(&win);
 }
 
 void Ewmh::updateFocusedWindow(BScreen &screen, Window win) {
-    /* From Extended Window Manager Hints, draft 1.3:
-     *
-     * _NET_ACTIVE_WINDOW, WINDOW/32
-     *
-     * The window ID of the currently active window or None
-     * if no window has the focus. This is a read-only
-     * property set by the Window Manager.
-     *
-     */
-    screen.rootWindow().changeProperty(m_net->active_window,
-                                       XA_WINDOW, 32,
-                                       PropModeReplace,
-                                       (unsigned char *)&win, 1);
+    // focus passes through several windows during a single action
+    m_active_windows[&screen].window = win;
+    m_flush.schedule();
 }
 
 // EWMH says, regarding _NET_WM_STATE and _NET_WM_DESKTOP
 // The Window Manager should remove the property whenever a window is withdrawn
 // but it should leave the property in place when it is shutting down
 void Ewmh::updateClientClose(WinClient &winclient){
+    m_written.erase(&winclient);
     if (!winclient.screen().isShuttingdown()) {
         XDeleteProperty(FbTk::App::instance()->display(), winclient.window(),
                         m_net->wm_state);
@@ -751,30 +902,62 @@ void Ewmh::updateClientClose(WinClient &winclient){
     }
 }
 
-void Ewmh::updateClientList(BScreen &screen) {
-
-    if (screen.isShuttingdown())
+void Ewmh::ClientLists::update() {
+    m_update.cancel();
+    if (m_screen.isShuttingdown())
         return;
 
-    list<Focusable *> creation_order_list =
-            screen.focusControl().creationOrderList().clientList();
-
-    size_t num = creation_order_list.size();
-    Window *wl = FB_new_nothrow Window[num];
-    if (wl == 0) {
-        _FB_USES_NLS;
-        cerr<<_FB_CONSOLETEXT(Ewmh, OutOfMemoryClientList,
-                      "Fatal: Out of memory, can't allocate for EWMH client list", "")<<endl;
-        return;
+    // only clients are in the creation order list
+    const list<Focusable *> &creation_order =
+        m_screen.focusControl().creationOrderList().clientList();
+
+    vector<Window> &clients = m_new_clients;
+    vector<Window> &stacking = m_new_stacking;
+    clients.clear();
+    stacking.clear();
+    m_framed.clear();
+    // the clients of each frame, and those without one go at the bottom
+    list<Focusable *>::const_iterator it = creation_order.begin();
+    list<Focusable *>::const_iterator it_end = creation_order.end();
+    for (; it != it_end; ++it) {
+        WinClient &client = static_cast<WinClient &>(**it);
+        clients.push_back(client.window());
+        if (client.fbwindow()) {
+            Framed framed = { &client.fbwindow()->layerItem(), m_framed.size(),
+                              client.window(), false };
+            m_framed.push_back(framed);
+        } else
+            stacking.push_back(client.window());
     }
-
-    int win=0;
-    list<Focusable *>::iterator client_it = creation_order_list.begin();
-    list<Focusable *>::iterator client_it_end = creation_order_list.end();
-    for (; client_it != client_it_end; ++client_it) {
-        WinClient *client = dynamic_cast<WinClient *>(*client_it);
-        if (client)
-            wl[win++] = client->window();
+    std::sort(m_framed.begin(), m_framed.end());
+
+    // the layers and their items are listed top first
+    size_t stacked = 0;
+    const FbTk::MultLayers &layers = m_screen.layerManager();
+    for (size_t i = layers.numLayers(); i > 0 && stacked < m_framed.size(); --i) {
+        const FbTk::Layer::ItemList &items = layers.getLayer(i - 1)->itemList();
+        FbTk::Layer::ItemList::const_reverse_iterator item = items.rbegin();
+        for (; item != items.rend(); ++item) {
+            Framed key = { *item, 0, None, false };
+            vector<Framed>::iterator found =
+                std::lower_bound(m_framed.begin(), m_framed.end(), key);
+            for (; found != m_framed.end() && found->item == *item; ++found) {
+                stacking.push_back(found->window);
+                found->stacked = true;
+                ++stacked;
+            }
+        }
+    }
+    // frames that aren't stacked (yet)
+    if (stacked < m_framed.size()) {
+        size_t unstacked = 0;
+        vector<Framed>::const_iterator rest = m_framed.begin();
+        for (; rest != m_framed.end(); ++rest) {
+            if (!rest->stacked) {
+                stacking.insert(stacking.begin() + unstacked, rest->window);
+                ++unstacked;
+            }
+        }
     }
 
     /*  From Extended Window Manager Hints, draft 1.3:
@@ -790,14 +973,38 @@ void Ewmh::updateClientList(BScreen &screen) {
      * SHOULD be set and updated by the Window
      * Manager.
      */
-    screen.rootWindow().changeProperty(m_net->client_list,
-                                       XA_WINDOW, 32,
-                                       PropModeReplace, (unsigned char *)wl, num);
-    screen.rootWindow().changeProperty(m_net->client_list_stacking,
-                                       XA_WINDOW, 32,
-                                       PropModeReplace, (unsigned char *)wl, num);
-
-    delete [] wl;
+    changeProperty(m_client_list, m_clients, clients);
+    changeProperty(m_client_list_stacking, m_stacking, stacking);
+}
+
+void Ewmh::ClientLists::changeProperty(Atom property, vector<Window> &old_list,
+                                       vector<Window> &new_list) {
+    if (new_list == old_list)
+        return;
+
+    // new windows come last in both lists, which is just an append; the
+    // first time we replace what a previous window manager left
+    if (!old_list.empty() && old_list.size() < new_list.size() &&
+        std::equal(old_list.begin(), old_list.end(), new_list.begin())) {
+        m_screen.rootWindow().changeProperty(property, XA_WINDOW, 32, PropModeAppend,
+                (unsigned char *)const_cast<Window *>(&new_list[old_list.size()]),
+                new_list.size() - old_list.size());
+    } else {
+        m_screen.rootWindow().changeProperty(property, XA_WINDOW, 32, PropModeReplace,
+                (unsigned char *)(new_list.empty() ? 0 : const_cast<Window *>(&new_list[0])),
+                new_list.size());
+    }
+    old_list.swap(new_list);
+}
+
+void Ewmh::updateClientList(BScreen &screen) {
+
+    if (screen.isShuttingdown())
+        return;
+
+    ClientListsMap::iterator it = m_client_lists.find(&screen);
+    if (it != m_client_lists.end())
+        it->second->schedule();
 }
 
 void Ewmh::updateWorkspaceNames(BScreen &screen) {
@@ -977,13 +1184,12 @@ void Ewmh::updateWorkarea(BScreen &screen) {
 }
 
 void Ewmh::updateState(FluxboxWindow &win) {
+    markDirty(win, (1 << PROP_STATE) | (1 << PROP_ALLOWED_ACTIONS) |
+                   (1 << PROP_BYPASS_COMPOSITOR));
+}
 
-
-    updateActions(win);
-
-    typedef vector<Atom> StateVec;
-
-    StateVec state;
+void Ewmh::getState(FluxboxWindow &win, WinClient &client,
+                    PropertyValues &state) {
 
     if (win.isMaximizedHorz())
         state.push_back(m_net->wm_state_maximized_horz);
@@ -1004,66 +1210,142 @@ void Ewmh::updateState(FluxboxWindow &win) {
     if (win.isFullscreen())
         state.push_back(m_net->wm_state_fullscreen);
 
-    FluxboxWindow::ClientList::iterator it = win.clientList().begin();
-    FluxboxWindow::ClientList::iterator it_end = win.clientList().end();
-    for (; it != it_end; ++it) {
+    Atom ret_type;
+    int fmt;
+    unsigned long nitems, bytes_after;
+    unsigned char *data = 0;
 
-        StateVec client_state(state);
-        Atom ret_type;
-        int fmt;
-        unsigned long nitems, bytes_after;
-        unsigned char *data = 0;
-
-        // set client-specific state
-        if ((*it)->isStateModal())
-            client_state.push_back(m_net->wm_state_modal);
-        if (Fluxbox::instance()->attentionHandler().isDemandingAttention(**it))
-            client_state.push_back(m_net->wm_state_demands_attention);
-
-        // search the old states for _NET_WM_STATE_SKIP_PAGER and append it
-        // to the current state, so it wont get deleted by us.
-        (*it)->property(m_net->wm_state, 0, 0x7fffffff, False, XA_ATOM,
-                                 &ret_type, &fmt, &nitems, &bytes_after,
-                                 &data);
-        if (data) {
-            Atom *old_states = (Atom *)data;
-            for (unsigned long i=0; i < nitems; ++i) {
-                if (old_states[i] == m_net->wm_state_skip_pager) {
-                    client_state.push_back(m_net->wm_state_skip_pager);
-                }
+    // set client-specific state
+    if (client.isStateModal())
+        state.push_back(m_net->wm_state_modal);
+    if (Fluxbox::instance()->attentionHandler().isDemandingAttention(client))
+        state.push_back(m_net->wm_state_demands_attention);
+
+    // search the old states for _NET_WM_STATE_SKIP_PAGER and append it
+    // to the current state, so it wont get deleted by us.
+    client.property(m_net->wm_state, 0, 0x7fffffff, False, XA_ATOM,
+                    &ret_type, &fmt, &nitems, &bytes_after,
+                    &data);
+    if (data) {
+        Atom *old_states = (Atom *)data;
+        for (unsigned long i=0; i < nitems; ++i) {
+            if (old_states[i] == m_net->wm_state_skip_pager) {
+                state.push_back(m_net->wm_state_skip_pager);
             }
-            XFree(data);
         }
-
-        if (!client_state.empty()) {
-            (*it)->changeProperty(m_net->wm_state, XA_ATOM, 32, PropModeReplace,
-                                  reinterpret_cast<unsigned char*>(&client_state.front()),
-                                  client_state.size());
-        } else
-            (*it)->deleteProperty(m_net->wm_state);
+        XFree(data);
     }
 }
 
-void Ewmh::updateLayer(FluxboxWindow &win) {
-    updateState(win);
+void Ewmh::markDirty(FluxboxWindow &win, unsigned int properties) {
+    m_dirty[&win] |= properties;
+    m_flush.schedule();
 }
 
-void Ewmh::updateHints(FluxboxWindow &win) {
+void Ewmh::flush() {
+    m_flush.cancel();
+
+    // a maximize alone changes the state, the allowed actions and the
+    // frame extents, often more than once; write each of them once, and
+    // only if it differs from what the client has
+    std::map<FluxboxWindow *, unsigned int> dirty;
+    dirty.swap(m_dirty);
+    std::map<FluxboxWindow *, unsigned int>::iterator win = dirty.begin();
+    for (; win != dirty.end(); ++win)
+        flushWindow(*win->first, win->second);
+
+    std::map<BScreen *, ActiveWindow>::iterator it = m_active_windows.begin();
+    for (; it != m_active_windows.end(); ++it) {
+        ActiveWindow &active = it->second;
+        if (active.known && active.written == active.window)
+            continue;
+
+        /* From Extended Window Manager Hints, draft 1.3:
+         *
+         * _NET_ACTIVE_WINDOW, WINDOW/32
+         *
+         * The window ID of the currently active window or None
+         * if no window has the focus. This is a read-only
+         * property set by the Window Manager.
+         *
+         */
+        it->first->rootWindow().changeProperty(m_net->active_window,
+                                               XA_WINDOW, 32,
+                                               PropModeReplace,
+                                               (unsigned char *)&active.window, 1);
+        active.written = active.window;
+        active.known = true;
+    }
 }
 
-void Ewmh::updateWorkspace(FluxboxWindow &win) {
-    long workspace = win.workspaceNumber();
+void Ewmh::flushWindow(FluxboxWindow &win, unsigned int properties) {
+    if (properties & (1 << PROP_BYPASS_COMPOSITOR))
+        updateBypassCompositor(win);
 
-    if (win.isStuck())
-        workspace = -1; // appear on all desktops/workspaces
+    PropertyValues desktop, extents, actions;
+    if (properties & (1 << PROP_DESKTOP)) {
+        // -1 appears on all desktops/workspaces
+        desktop.push_back(win.isStuck() ? (unsigned long)-1 : win.workspaceNumber());
+    }
+    if (properties & (1 << PROP_FRAME_EXTENTS)) {
+        /* Frame extents are basically the amount the window manager frame
+           protrudes from the client window, on left, right, top, bottom
+           (it is independent of window position).
+         */
+        // our frames currently don't protrude from left/right
+        int bw = win.frame().window().borderWidth();
+        extents.push_back(bw);
+        extents.push_back(bw);
+        extents.push_back(win.frame().titlebarHeight() + bw);
+        extents.push_back(win.frame().handleHeight() + bw);
+    }
+    if (properties & (1 << PROP_ALLOWED_ACTIONS))
+        getActions(win, actions);
 
     FluxboxWindow::ClientList::iterator it = win.clientList().begin();
     FluxboxWindow::ClientList::iterator it_end = win.clientList().end();
     for (; it != it_end; ++it) {
-        (*it)->changeProperty(m_net->wm_desktop, XA_CARDINAL, 32, PropModeReplace,
-                              (unsigned char *)&workspace, 1);
+        if (properties & (1 << PROP_STATE)) {
+            PropertyValues state;
+            getState(win, **it, state);
+            writeProperty(**it, PROP_STATE, m_net->wm_state, XA_ATOM, state);
+        }
+        if (properties & (1 << PROP_DESKTOP))
+            writeProperty(**it, PROP_DESKTOP, m_net->wm_desktop, XA_CARDINAL, desktop);
+        if (properties & (1 << PROP_FRAME_EXTENTS))
+            writeProperty(**it, PROP_FRAME_EXTENTS, m_net->frame_extents,
+                          XA_CARDINAL, extents);
+        if (properties & (1 << PROP_ALLOWED_ACTIONS))
+            writeProperty(**it, PROP_ALLOWED_ACTIONS, m_net->wm_allowed_actions,
+                          XA_ATOM, actions);
     }
+}
 
+void Ewmh::writeProperty(WinClient &client, ClientProperty property,
+                         Atom atom, Atom type, const PropertyValues &values) {
+    WrittenProperties &written = m_written[&client];
+    if ((written.known & (1 << property)) && written.values[property] == values)
+        return;
+
+    if (values.empty())
+        client.deleteProperty(atom);
+    else
+        client.changeProperty(atom, type, 32, PropModeReplace,
+                              (unsigned char *)const_cast<unsigned long *>(&values[0]),
+                              values.size());
+    written.values[property] = values;
+    written.known |= 1 << property;
+}
+
+void Ewmh::updateLayer(FluxboxWindow &win) {
+    updateState(win);
+}
+
+void Ewmh::updateHints(FluxboxWindow &win) {
+}
+
+void Ewmh::updateWorkspace(FluxboxWindow &win) {
+    markDirty(win, 1 << PROP_DESKTOP);
 }
 
 
@@ -1302,6 +1584,10 @@ bool Ewmh::propertyNotify(WinClient &winclient, Atom the_property) {
     } else if (the_property == m_net->wm_icon) {
         extractNetWmIcon(m_net->wm_icon, winclient);
         return true;
+    } else if (the_property == m_net->wm_bypass_compositor) {
+        if (winclient.fbwindow())
+            markDirty(*winclient.fbwindow(), 1 << PROP_BYPASS_COMPOSITOR);
+        return true;
     }
 
     return false;
@@ -1423,7 +1709,7 @@ void Ewmh::updateStrut(WinClient &winclient) {
 
 
 
-void Ewmh::updateActions(FluxboxWindow &win) {
+void Ewmh::getActions(FluxboxWindow &win, PropertyValues &actions) {
 
     /* From Extended Window Manager Hints, draft 1.3:
      *
@@ -1439,8 +1725,6 @@ void Ewmh::updateActions(FluxboxWindow &win) {
      * decide which actions should be made available to the user.
      */
 
-    typedef vector<Atom> ActionsVector;
-    ActionsVector actions;
     actions.reserve(10);
     // all windows can change desktop,
     // be shaded or be sticky
@@ -1474,17 +1758,46 @@ void Ewmh::updateActions(FluxboxWindow &win) {
     if (max_height == 0 && max_width == 0) {
         actions.push_back(m_net->wm_action_fullscreen);
     }
+}
 
+void Ewmh::updateBypassCompositor(FluxboxWindow &win) {
 
+    /* From Extended Window Manager Hints, 1.5:
+     *
+     * _NET_WM_BYPASS_COMPOSITOR, CARDINAL/32
+     *
+     * The Window Manager MUST copy this hint from the client window to
+     * its frame. 0 indicates no preference, 1 requests the compositor
+     * to unredirect the window and 2 to keep compositing it.
+     */
 
-    FluxboxWindow::ClientList::iterator it = win.clientList().begin();
-    FluxboxWindow::ClientList::iterator it_end = win.clientList().end();
-    for (; it != it_end; ++it) {
-        (*it)->changeProperty(m_net->wm_allowed_actions, XA_ATOM, 32, PropModeReplace,
-                              reinterpret_cast<unsigned char*>(&actions.front()),
-                              actions.size());
-    }
+    bool exists = false;
+    long hint = win.winClient().cardinalProperty(m_net->wm_bypass_compositor,
+                                                 &exists);
+    if (!exists || hint < 0 || hint > 2)
+        hint = 0;
+
+    // the compositor sees our frame; a fullscreen frame covers the head
+    // anyway, so it may skip the offscreen copy unless the client objects
+    if (hint == 0 && win.isFullscreen() &&
+        win.screen().doFullscreenUnredirect())
+        hint = 1;
+
+    std::map<FluxboxWindow *, long>::iterator it =
+        m_bypass_compositor.find(&win);
+    long old_hint = it == m_bypass_compositor.end() ? 0 : it->second;
+    if (hint == old_hint)
+        return;
 
+    if (hint == 0) {
+        win.frame().window().deleteProperty(m_net->wm_bypass_compositor);
+        m_bypass_compositor.erase(it);
+    } else {
+        win.frame().window().changeProperty(m_net->wm_bypass_compositor,
+                                            XA_CARDINAL, 32, PropModeReplace,
+                                            (unsigned char *)&hint, 1);
+        m_bypass_compositor[&win] = hint;
+    }
 }
 
 void Ewmh::setupState(FluxboxWindow &win) {
@@ -1524,25 +1837,6 @@ void Ewmh::setupState(FluxboxWindow &win) {
 }
 
 void Ewmh::updateFrameExtents(FluxboxWindow &win) {
-    /* Frame extents are basically the amount the window manager frame
-       protrudes from the client window, on left, right, top, bottom
-       (it is independent of window position).
-     */
-
-    FluxboxWindow::ClientList::iterator it = win.clientList().begin();
-    FluxboxWindow::ClientList::iterator it_end = win.clientList().end();
-    for (; it != it_end; ++it) {
-        long extents[4];
-        // our frames currently don't protrude from left/right
-        int bw = win.frame().window().borderWidth();
-        extents[0] = bw;
-        extents[1] = bw;
-        extents[2] = win.frame().titlebarHeight() + bw;
-        extents[3] = win.frame().handleHeight() + bw;
-
-        (*it)->changeProperty(m_net->frame_extents,
-                              XA_CARDINAL, 32, PropModeReplace,
-                              (unsigned char *)extents, 4);
-    }
+    markDirty(win, 1 << PROP_FRAME_EXTENTS);
 }
 
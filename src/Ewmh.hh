@@ -21,6 +21,10 @@
 
 #include "AtomHandler.hh"
 #include "FbTk/FbString.hh"
+#include "FbTk/IdleTask.hh"
+
+#include <map>
+#include <vector>
 
 /// Implementes Extended Window Manager Hints ( http://www.freedesktop.org/Standards/wm-spec )
 class Ewmh:public AtomHandler {
@@ -60,13 +64,33 @@ private:
 
     enum { STATE_REMOVE = 0, STATE_ADD = 1, STATE_TOGGLE = 2};
 
+    /// the properties we keep on each client, written by flush()
+    enum ClientProperty {
+        PROP_STATE, PROP_DESKTOP, PROP_FRAME_EXTENTS, PROP_ALLOWED_ACTIONS,
+        NUM_CLIENT_PROPERTIES,
+        PROP_BYPASS_COMPOSITOR = NUM_CLIENT_PROPERTIES ///< on the frame
+    };
+    typedef std::vector<unsigned long> PropertyValues;
+
     void setState(FluxboxWindow &win, Atom state, bool value);
     void setState(FluxboxWindow &win, Atom state, bool value,
                   WinClient &client);
     void toggleState(FluxboxWindow &win, Atom state);
     void toggleState(FluxboxWindow &win, Atom state, WinClient &client);
     void updateStrut(WinClient &winclient);
-    void updateActions(FluxboxWindow &win);
+    void updateBypassCompositor(FluxboxWindow &win);
+
+    /// marks properties of the clients of 'win' to be written by flush()
+    void markDirty(FluxboxWindow &win, unsigned int properties);
+    /// writes the dirty properties and _NET_ACTIVE_WINDOW, once per loop
+    void flush();
+    void flushWindow(FluxboxWindow &win, unsigned int properties);
+    /// writes 'values' unless they are what we wrote the last time
+    void writeProperty(WinClient &client, ClientProperty property,
+                       Atom atom, Atom type, const PropertyValues &values);
+
+    void getState(FluxboxWindow &win, WinClient &client, PropertyValues &state);
+    void getActions(FluxboxWindow &win, PropertyValues &actions);
 
     void setupState(FluxboxWindow &win);
 
@@ -74,4 +98,33 @@ private:
 
     class EwmhAtoms;
     EwmhAtoms* m_net;
+
+    /// _NET_CLIENT_LIST and _NET_CLIENT_LIST_STACKING of a screen
+    class ClientLists;
+    typedef std::map<BScreen *, ClientLists *> ClientListsMap;
+    ClientListsMap m_client_lists;
+
+    /// _NET_WM_BYPASS_COMPOSITOR last set on the frame of a window
+    std::map<FluxboxWindow *, long> m_bypass_compositor;
+
+    /// the client properties we wrote last, to skip writes without a change
+    struct WrittenProperties {
+        WrittenProperties(): known(0) { }
+        unsigned int known; ///< bits of the ClientProperty values we know
+        PropertyValues values[NUM_CLIENT_PROPERTIES];
+    };
+    std::map<WinClient *, WrittenProperties> m_written;
+
+    /// the dirty ClientProperty bits of each window
+    std::map<FluxboxWindow *, unsigned int> m_dirty;
+
+    /// the _NET_ACTIVE_WINDOW of each screen, and what we last wrote
+    struct ActiveWindow {
+        ActiveWindow(): window(None), written(None), known(false) { }
+        Window window, written;
+        bool known;
+    };
+    std::map<BScreen *, ActiveWindow> m_active_windows;
+
+    FbTk::IdleTask m_flush;
 };
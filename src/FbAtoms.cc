@@ -20,7 +20,6 @@
 // DEALINGS IN THE SOFTWARE.
 
 #include "FbAtoms.hh"
-#include "FbTk/App.hh"
 
 namespace {
 
@@ -28,18 +27,28 @@ FbAtoms* s_singleton = 0;
 
 } // end of anonymous namespace
 
-FbAtoms::FbAtoms() {
+const FbAtoms::Name FbAtoms::s_names[] = {
+    { "WM_PROTOCOLS", &FbAtoms::xa_wm_protocols },
+    { "WM_STATE", &FbAtoms::xa_wm_state },
+    { "WM_CHANGE_STATE", &FbAtoms::xa_wm_change_state },
+    { "WM_DELETE_WINDOW", &FbAtoms::xa_wm_delete_window },
+    { "WM_TAKE_FOCUS", &FbAtoms::xa_wm_take_focus },
+    // the sync protocol is announced in WM_PROTOCOLS, like WM_TAKE_FOCUS
+    { "_NET_WM_SYNC_REQUEST", &FbAtoms::net_wm_sync_request },
+    { "_NET_WM_SYNC_REQUEST_COUNTER", &FbAtoms::net_wm_sync_request_counter },
+    { "_MOTIF_WM_HINTS", &FbAtoms::motif_wm_hints },
+
+    { "_BLACKBOX_ATTRIBUTES", &FbAtoms::blackbox_attributes }
+};
 
-    Display* dpy = FbTk::App::instance()->display();
+FbTk::AtomCache::Names FbAtoms::s_queued(FbAtoms::s_names,
+                                         sizeof(FbAtoms::s_names) / sizeof(FbAtoms::s_names[0]));
 
-    xa_wm_protocols = XInternAtom(dpy, "WM_PROTOCOLS", False);
-    xa_wm_state = XInternAtom(dpy, "WM_STATE", False);
-    xa_wm_change_state = XInternAtom(dpy, "WM_CHANGE_STATE", False);
-    xa_wm_delete_window = XInternAtom(dpy, "WM_DELETE_WINDOW", False);
-    xa_wm_take_focus = XInternAtom(dpy, "WM_TAKE_FOCUS", False);
-    motif_wm_hints = XInternAtom(dpy, "_MOTIF_WM_HINTS", False);
+FbAtoms::FbAtoms() {
 
-    blackbox_attributes = XInternAtom(dpy, "_BLACKBOX_ATTRIBUTES", False);
+    FbTk::AtomCache &cache = FbTk::AtomCache::instance();
+    for (size_t i = 0; i < sizeof(s_names) / sizeof(s_names[0]); ++i)
+        this->*s_names[i].atom = cache.get(s_names[i].name);
 
     s_singleton = this;
 }
@@ -22,6 +22,8 @@
 #ifndef FBATOMS_HH
 #define FBATOMS_HH
 
+#include "FbTk/AtomCache.hh"
+
 #include <X11/Xlib.h>
 
 /// atom handler for basic X atoms
@@ -36,6 +38,8 @@ public:
     Atom getWMDeleteAtom() const { return xa_wm_delete_window; }
     Atom getWMProtocolsAtom() const { return xa_wm_protocols; }
     Atom getWMTakeFocusAtom() const { return xa_wm_take_focus; }
+    Atom getNetWMSyncRequestAtom() const { return net_wm_sync_request; }
+    Atom getNetWMSyncRequestCounterAtom() const { return net_wm_sync_request_counter; }
 
     Atom getMWMHintsAtom() const { return motif_wm_hints; }
 
@@ -46,6 +50,13 @@ public:
 private:
     FbAtoms();
 
+    struct Name {
+        const char *name;
+        Atom FbAtoms::*atom;
+    };
+    static const Name s_names[];
+    static FbTk::AtomCache::Names s_queued; ///< interned with the others
+
     Atom blackbox_attributes;
     Atom motif_wm_hints;
     Atom xa_wm_protocols;
@@ -53,6 +64,8 @@ private:
     Atom xa_wm_delete_window;
     Atom xa_wm_take_focus;
     Atom xa_wm_change_state;
+    Atom net_wm_sync_request;
+    Atom net_wm_sync_request_counter;
 };
 
 #endif //FBATOMS_HH
@@ -35,6 +35,8 @@
 #include "FbTk/CommandParser.hh"
 #include "FbTk/StringUtil.hh"
 #include "FbTk/stringstream.hh"
+#include "FbTk/RoundTrips.hh"
+#include "FbTk/Tracer.hh"
 
 #include <sys/types.h>
 #include <unistd.h>
@@ -90,6 +92,7 @@ void showMenu(BScreen &screen, FbTk::Menu &menu) {
     int x = 0;
     int y = 0;
 
+    FBTK_ROUNDTRIP("showMenu");
     XQueryPointer(menu.fbwindow().display(),
                   screen.rootWindow().window(), &ignored_w, &ignored_w,
                   &x, &y, &ignored_i, &ignored_i, &ignored_ui);
@@ -234,6 +237,128 @@ void RestartFluxboxCmd::execute() {
     Fluxbox::instance()->restart(m_cmd.c_str());
 }
 
+REGISTER_COMMAND_PARSER(dumpstats, DumpStatsCmd::parse, void);
+
+FbTk::Command<void> *DumpStatsCmd::parse(const string &command,
+        const string &args, bool trusted) {
+    // don't let remote commands overwrite arbitrary files
+    if (!trusted && !args.empty())
+        return 0;
+    return new DumpStatsCmd(args);
+}
+
+DumpStatsCmd::DumpStatsCmd(const string &filename):
+    m_filename(FbTk::StringUtil::expandFilename(filename)) {
+}
+
+void DumpStatsCmd::execute() {
+    string filename = m_filename.empty() ?
+        Fluxbox::instance()->getDefaultDataFilename("stats") : m_filename;
+
+    ofstream out(filename.c_str());
+    if (!out) {
+        std::cerr<<"Fluxbox: can't write statistics to "<<filename<<endl;
+        return;
+    }
+    Fluxbox::instance()->dumpStats(out);
+}
+
+REGISTER_COMMAND_PARSER(dumpmemory, DumpMemoryCmd::parse, void);
+
+FbTk::Command<void> *DumpMemoryCmd::parse(const string &command,
+        const string &args, bool trusted) {
+    if (!trusted && !args.empty())
+        return 0;
+    return new DumpMemoryCmd(args);
+}
+
+DumpMemoryCmd::DumpMemoryCmd(const string &filename):
+    m_filename(FbTk::StringUtil::expandFilename(filename)) {
+}
+
+void DumpMemoryCmd::execute() {
+    string filename = m_filename.empty() ?
+        Fluxbox::instance()->getDefaultDataFilename("memory") : m_filename;
+
+    ofstream out(filename.c_str());
+    if (!out) {
+        std::cerr<<"Fluxbox: can't write the memory report to "<<filename<<endl;
+        return;
+    }
+    Fluxbox::instance()->dumpMemory(out);
+}
+
+REGISTER_COMMAND_PARSER(starttrace, TraceCmd::parse, void);
+REGISTER_COMMAND_PARSER(stoptrace, TraceCmd::parse, void);
+REGISTER_COMMAND_PARSER(dumptrace, TraceCmd::parse, void);
+
+FbTk::Command<void> *TraceCmd::parse(const string &command,
+        const string &args, bool trusted) {
+    if (command == "starttrace") {
+        unsigned long spans = 100000;
+        if (!args.empty())
+            FbTk::StringUtil::extractNumber(args, spans);
+        return new TraceCmd(START, spans, "");
+    } else if (command == "stoptrace")
+        return new TraceCmd(STOP, 0, "");
+
+    // don't let remote commands overwrite arbitrary files
+    if (!trusted && !args.empty())
+        return 0;
+    return new TraceCmd(DUMP, 0, args);
+}
+
+TraceCmd::TraceCmd(Action action, unsigned long spans, const string &filename):
+    m_action(action), m_spans(spans),
+    m_filename(FbTk::StringUtil::expandFilename(filename)) {
+}
+
+void TraceCmd::execute() {
+    FbTk::Tracer &tracer = FbTk::Tracer::instance();
+    switch (m_action) {
+    case START:
+        tracer.start(m_spans);
+        break;
+    case STOP:
+        tracer.stop();
+        break;
+    case DUMP: {
+        string filename = m_filename.empty() ?
+            Fluxbox::instance()->getDefaultDataFilename("trace.json") : m_filename;
+        ofstream out(filename.c_str());
+        if (!out) {
+            std::cerr<<"Fluxbox: can't write the trace to "<<filename<<endl;
+            return;
+        }
+        tracer.write(out);
+        break;
+    }
+    }
+}
+
+REGISTER_COMMAND_PARSER(benchmarkkeys, BenchmarkKeysCmd::parse, void);
+
+FbTk::Command<void> *BenchmarkKeysCmd::parse(const string &command,
+        const string &args, bool trusted) {
+    // it blocks fluxbox for a while
+    if (!trusted)
+        return 0;
+    unsigned long events = 100000;
+    if (!args.empty())
+        FbTk::StringUtil::extractNumber(args, events);
+    return new BenchmarkKeysCmd(events);
+}
+
+void BenchmarkKeysCmd::execute() {
+    string filename = Fluxbox::instance()->getDefaultDataFilename("keysbench");
+    ofstream out(filename.c_str());
+    if (!out) {
+        std::cerr<<"Fluxbox: can't write the keys benchmark to "<<filename<<endl;
+        return;
+    }
+    Keys::benchmark(out, m_events);
+}
+
 REGISTER_COMMAND(reconfigure, FbCommands::ReconfigureFluxboxCmd, void);
 REGISTER_COMMAND(reconfig, FbCommands::ReconfigureFluxboxCmd, void);
 
@@ -83,6 +83,53 @@ private:
     std::string m_cmd;
 };
 
+/// writes performance statistics to a file
+class DumpStatsCmd: public FbTk::Command<void> {
+public:
+    explicit DumpStatsCmd(const std::string &filename);
+    void execute();
+    static FbTk::Command<void> *parse(const std::string &command,
+                                      const std::string &args, bool trusted);
+private:
+    std::string m_filename;
+};
+
+/// writes the memory we hold in the X server and in caches to a file
+class DumpMemoryCmd: public FbTk::Command<void> {
+public:
+    explicit DumpMemoryCmd(const std::string &filename);
+    void execute();
+    static FbTk::Command<void> *parse(const std::string &command,
+                                      const std::string &args, bool trusted);
+private:
+    std::string m_filename;
+};
+
+/// starts or stops recording a trace, or writes it to a file
+class TraceCmd: public FbTk::Command<void> {
+public:
+    enum Action { START, STOP, DUMP };
+    TraceCmd(Action action, unsigned long spans, const std::string &filename);
+    void execute();
+    static FbTk::Command<void> *parse(const std::string &command,
+                                      const std::string &args, bool trusted);
+private:
+    Action m_action;
+    unsigned long m_spans;
+    std::string m_filename;
+};
+
+/// times the dispatch of generated events through the key bindings
+class BenchmarkKeysCmd: public FbTk::Command<void> {
+public:
+    explicit BenchmarkKeysCmd(unsigned long events): m_events(events) { }
+    void execute();
+    static FbTk::Command<void> *parse(const std::string &command,
+                                      const std::string &args, bool trusted);
+private:
+    unsigned long m_events;
+};
+
 /// reconfigures fluxbox
 class ReconfigureFluxboxCmd: public FbTk::Command<void> {
 public:
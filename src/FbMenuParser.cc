@@ -22,14 +22,28 @@
 
 #include "FbMenuParser.hh"
 
-#include "FbTk/StringUtil.hh"
-
 bool FbMenuParser::open(const std::string &filename) {
-    m_file.open(filename.c_str());
-    m_curr_pos = 0;
-    m_row = 0;
+    close();
+    if (!m_file.open(filename.c_str()))
+        return false;
+    m_tokenizer.reset(new FbTk::Tokenizer(m_file));
     m_curr_token = DONE;
-    return isLoaded();
+    return true;
+}
+
+void FbMenuParser::openText(const std::string &text) {
+    close();
+    m_text = text;
+    m_tokenizer.reset(new FbTk::Tokenizer(m_text.data(), m_text.size()));
+    m_curr_token = DONE;
+}
+
+void FbMenuParser::close() {
+    m_tokenizer.reset(0);
+    m_file.close();
+    m_text.clear();
+    m_curr_line = FbTk::Tokenizer::Range();
+    m_curr_pos = 0;
 }
 
 FbTk::Parser &FbMenuParser::operator >> (FbTk::Parser::Item &out) {
@@ -71,10 +85,10 @@ FbTk::Parser &FbMenuParser::operator >> (FbTk::Parser::Item &out) {
     }
     
     std::string key;
-    int err = FbTk::StringUtil::
-        getStringBetween(key, m_curr_line.c_str() + m_curr_pos,
-                         first, second);
-    if (err <= 0) {        
+    const char *end = FbTk::Tokenizer::
+        between(FbTk::Tokenizer::Range(m_curr_pos, m_curr_line.end),
+                first, second, key);
+    if (end == 0) {
         if (m_curr_token == TYPE)
             m_curr_token = NAME;
         else if (m_curr_token == NAME)
@@ -88,7 +102,7 @@ FbTk::Parser &FbMenuParser::operator >> (FbTk::Parser::Item &out) {
         return *this;
     }
 
-    m_curr_pos += err; // update current position in current line
+    m_curr_pos = end; // update current position in current line
 
     // set value
     out.second = key;
@@ -124,11 +138,11 @@ FbTk::Parser::Item FbMenuParser::nextItem() {
 }
 
 bool FbMenuParser::nextLine() {
-    if (!std::getline(m_file, m_curr_line))
+    if (!m_tokenizer->nextLine())
         return false;
 
-    m_row++;
-    m_curr_pos = 0;
+    m_curr_line = m_tokenizer->line();
+    m_curr_pos = m_curr_line.begin;
     m_curr_token = TYPE;
 
     return true;
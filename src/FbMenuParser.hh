@@ -24,32 +24,38 @@
 #define FBMENUPARSER_HH
 
 #include "FbTk/Parser.hh"
+#include "FbTk/FileUtil.hh"
+#include "FbTk/Tokenizer.hh"
 
-#include <fstream>
+#include <memory>
 
 class FbMenuParser: public FbTk::Parser {
 public:
-    FbMenuParser():m_row(0), m_curr_pos(0), m_curr_token(TYPE) {}
-    FbMenuParser(const std::string &filename):m_row(0), m_curr_pos(0),
-                                              m_curr_token(TYPE) { open(filename); }
+    FbMenuParser(): m_curr_pos(0), m_curr_token(TYPE) {}
+    FbMenuParser(const std::string &filename): m_curr_pos(0), m_curr_token(TYPE) {
+        open(filename);
+    }
     ~FbMenuParser() { close(); }
 
     bool open(const std::string &filename);
-    void close() { m_file.close(); }
+    /// parses 'text' instead of a file, e.g. the output of a command
+    void openText(const std::string &text);
+    void close();
     FbTk::Parser &operator >> (FbTk::Parser::Item &out);
     FbTk::Parser::Item nextItem();
 
-    bool isLoaded() const { return m_file.is_open(); }
-    bool eof() const { return m_file.eof(); }
-    int row() const { return m_row; }
-    std::string line() const { return m_curr_line; }
+    bool isLoaded() const { return m_tokenizer.get() != 0; }
+    bool eof() const { return m_tokenizer.get() == 0 || m_tokenizer->eof(); }
+    int row() const { return m_tokenizer.get() ? m_tokenizer->row() : 0; }
+    std::string line() const { return m_curr_line.str(); }
 private:
     bool nextLine();
 
-    mutable std::ifstream m_file;
-    int m_row;
-    int m_curr_pos;
-    std::string m_curr_line;
+    FbTk::MappedFile m_file;
+    std::string m_text;
+    std::auto_ptr<FbTk::Tokenizer> m_tokenizer; ///< over m_file or m_text
+    FbTk::Tokenizer::Range m_curr_line;
+    const char *m_curr_pos;
     enum Object {TYPE, NAME, ARGUMENT, ICON, DONE} m_curr_token;
 };
 
@@ -0,0 +1,83 @@
+// AllocStats.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#include "AllocStats.hh"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#ifdef ALLOC_STATS
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+unsigned long s_allocations = 0;
+
+} // anonymous namespace
+
+#if __cplusplus < 201103L
+#define FBTK_THROWS_BAD_ALLOC throw (std::bad_alloc)
+#define FBTK_THROWS_NOTHING throw ()
+#else
+#define FBTK_THROWS_BAD_ALLOC
+#define FBTK_THROWS_NOTHING noexcept
+#endif
+
+// the array and nothrow forms of the library call these
+void *operator new(std::size_t size) FBTK_THROWS_BAD_ALLOC {
+    ++s_allocations;
+    void *p = std::malloc(size ? size : 1);
+    if (p == 0)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) FBTK_THROWS_NOTHING {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) FBTK_THROWS_NOTHING {
+    std::free(p);
+}
+
+#endif // ALLOC_STATS
+
+namespace FbTk {
+
+bool AllocStats::counting() {
+#ifdef ALLOC_STATS
+    return true;
+#else
+    return false;
+#endif // ALLOC_STATS
+}
+
+unsigned long AllocStats::count() {
+#ifdef ALLOC_STATS
+    return s_allocations;
+#else
+    return 0;
+#endif // ALLOC_STATS
+}
+
+} // end namespace FbTk
@@ -1,5 +1,5 @@
-// SearchResult.hh for FbTk - Fluxbox Toolkit
-// Copyright (c) 2007 Fluxbox Team (fluxgen at fluxbox dot org)
+// AllocStats.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
 //
 // Permission is hereby granted, free of charge, to any person obtaining a
 // copy of this software and associated documentation files (the "Software"),
@@ -19,37 +19,24 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
 // DEALINGS IN THE SOFTWARE.
 
-#ifndef FBTK_SEARCHRESULT_HH
-#define FBTK_SEARCHRESULT_HH
-
-#include <vector>
-#include <string>
+#ifndef FBTK_ALLOCSTATS_HH
+#define FBTK_ALLOCSTATS_HH
 
 namespace FbTk {
 
-class ITypeAheadable;
-
-class SearchResult {
+/**
+   Counts the calls of operator new, when built with --enable-alloc-stats.
+   The event loop takes the difference around each event, so the paths
+   that should not allocate in steady state can be checked with DumpStats.
+ */
+class AllocStats {
 public:
-    typedef std::vector < ITypeAheadable* > BaseItems;
-    typedef BaseItems::iterator BaseItemsIt;
-
-    SearchResult(const std::string &to_search_for):
-        m_seeked_string(to_search_for) { }
-
-    void add(ITypeAheadable* item) { m_results.push_back(item); }
-    size_t size() const { return m_results.size(); }
-    const BaseItems& result() const { return m_results; }
-    const std::string& seekedString() const { return m_seeked_string; }
-
-    void seek();
-
-private:
-    BaseItems m_results;
-    std::string m_seeked_string;
-
+    /// @return true if this build counts allocations
+    static bool counting();
+    /// @return allocations since the start, 0 if not counting
+    static unsigned long count();
 };
 
 } // end namespace FbTk
 
-#endif // FBTK_SEARCHRESULT_HH
+#endif // FBTK_ALLOCSTATS_HH
@@ -25,6 +25,8 @@
 #include "Image.hh"
 
 #include "EventManager.hh"
+#include "RoundTrips.hh"
+#include "StartupProfile.hh"
 
 #ifdef HAVE_CSTRING
   #include <cstring>
@@ -59,6 +61,7 @@ App::App(const char *displayname):m_done(false), m_display(0) {
     // a blank string, rather than a null string, so we make them equivalent
     if (displayname != 0 && displayname[0] == '\0')
         displayname = 0;
+    StartupProfile::Phase phase("X connection");
     m_display = XOpenDisplay(displayname);
     if (!m_display) {
         if (displayname) {
@@ -83,6 +86,7 @@ App::~App() {
 }
 
 void App::sync(bool discard) {
+    FBTK_ROUNDTRIP("App::sync");
     XSync(display(), discard);
 }
 
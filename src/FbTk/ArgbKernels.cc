@@ -0,0 +1,124 @@
+// ArgbKernels.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "ArgbKernels.hh"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define FBTK_ARGB_SSE2
+#endif // __SSE2__
+
+namespace FbTk {
+
+namespace ArgbKernels {
+
+namespace {
+
+// the scalar version, also used for the last pixels of a row by the others
+
+void splitScalar(unsigned int *rgb, unsigned char *opaque,
+                 const unsigned long *argb, unsigned int num,
+                 unsigned char threshold) {
+    for (unsigned int i = 0; i < num; ++i) {
+        unsigned int pixel = argb[i]; // use only 32bit
+        rgb[i] = pixel & 0x00ffffff;
+        opaque[i] = (pixel >> 24) > threshold ? 0xff : 0;
+    }
+}
+
+const Impl s_scalar = { "scalar", splitScalar };
+
+#ifdef FBTK_ARGB_SSE2
+
+/// the low 32 bits of the longs argb[0] to argb[3]
+inline __m128i load4(const unsigned long *argb) {
+    const __m128i *p = reinterpret_cast<const __m128i *>(argb);
+    if (sizeof(unsigned long) == 4)
+        return _mm_loadu_si128(p);
+    // two 64 bit longs in each register, keep the low halves
+    __m128i lo = _mm_shuffle_epi32(_mm_loadu_si128(p), _MM_SHUFFLE(3, 1, 2, 0));
+    __m128i hi = _mm_shuffle_epi32(_mm_loadu_si128(p + 1), _MM_SHUFFLE(3, 1, 2, 0));
+    return _mm_unpacklo_epi64(lo, hi);
+}
+
+void splitSSE2(unsigned int *rgb, unsigned char *opaque,
+               const unsigned long *argb, unsigned int num,
+               unsigned char threshold) {
+    const __m128i rgb_mask = _mm_set1_epi32(0x00ffffff);
+    const __m128i limit = _mm_set1_epi32(threshold);
+    unsigned int i = 0;
+    for (; i + 8 <= num; i += 8) {
+        __m128i a = load4(argb + i);
+        __m128i b = load4(argb + i + 4);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(rgb + i), _mm_and_si128(a, rgb_mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(rgb + i + 4), _mm_and_si128(b, rgb_mask));
+
+        // all ones where opaque, then narrowed to bytes keeping the sign
+        __m128i oa = _mm_cmpgt_epi32(_mm_srli_epi32(a, 24), limit);
+        __m128i ob = _mm_cmpgt_epi32(_mm_srli_epi32(b, 24), limit);
+        __m128i o = _mm_packs_epi16(_mm_packs_epi32(oa, ob), _mm_setzero_si128());
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(opaque + i), o);
+    }
+    splitScalar(rgb + i, opaque + i, argb + i, num - i, threshold);
+}
+
+const Impl s_sse2 = { "sse2", splitSSE2 };
+
+#endif // FBTK_ARGB_SSE2
+
+/// available implementations, slowest first
+struct Available {
+    Available(): num(0) {
+        impls[num++] = &s_scalar;
+#ifdef FBTK_ARGB_SSE2
+        impls[num++] = &s_sse2;
+#endif // FBTK_ARGB_SSE2
+    }
+
+    const Impl *impls[2];
+    unsigned int num;
+};
+
+const Available &available() {
+    static Available s_available;
+    return s_available;
+}
+
+} // anonymous namespace
+
+const Impl &best() {
+    const Available &avail = available();
+    return *avail.impls[avail.num - 1];
+}
+
+unsigned int count() {
+    return available().num;
+}
+
+const Impl &get(unsigned int index) {
+    const Available &avail = available();
+    return *avail.impls[index < avail.num ? index : 0];
+}
+
+} // end namespace ArgbKernels
+
+} // end namespace FbTk
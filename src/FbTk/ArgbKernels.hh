@@ -0,0 +1,56 @@
+// ArgbKernels.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#ifndef FBTK_ARGBKERNELS_HH
+#define FBTK_ARGBKERNELS_HH
+
+namespace FbTk {
+
+/**
+   Conversion of the 32 bit ARGB rows of _NET_WM_ICON, which X hands out
+   as longs. Every implementation produces exactly the same bytes as the
+   scalar one, best() picks the fastest one the cpu supports.
+ */
+namespace ArgbKernels {
+
+struct Impl {
+    const char *name;
+    /// rgb[i] = the low 24 bits of argb[i], opaque[i] = 0xff if the alpha
+    /// of argb[i] is above 'threshold', else 0
+    void (*split)(unsigned int *rgb, unsigned char *opaque,
+                  const unsigned long *argb, unsigned int num,
+                  unsigned char threshold);
+};
+
+/// @return fastest implementation for this cpu
+const Impl &best();
+
+/// @return number of implementations usable on this cpu
+unsigned int count();
+/// @return implementation number 'index', 0 is the plain C++ one
+const Impl &get(unsigned int index);
+
+} // end namespace ArgbKernels
+
+} // end namespace FbTk
+
+#endif // FBTK_ARGBKERNELS_HH
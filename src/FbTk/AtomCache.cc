@@ -0,0 +1,87 @@
+// AtomCache.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "AtomCache.hh"
+#include "App.hh"
+#include "RoundTrips.hh"
+#include "StartupProfile.hh"
+
+namespace FbTk {
+
+AtomCache::Names::Names(const char *const *names, size_t num) {
+    for (size_t i = 0; i < num; ++i)
+        AtomCache::instance().queue(names[i]);
+}
+
+AtomCache &AtomCache::instance() {
+    static AtomCache cache;
+    return cache;
+}
+
+void AtomCache::queue(const std::string &name) {
+    if (m_atoms.find(name) == m_atoms.end())
+        m_queue.push_back(name);
+}
+
+void AtomCache::resolve() {
+    StartupProfile::Phase phase("atoms");
+    // names may be queued twice
+    std::vector<char *> names;
+    names.reserve(m_queue.size());
+    for (size_t i = 0; i < m_queue.size(); ++i) {
+        Atoms::iterator it = m_atoms.find(m_queue[i]);
+        if (it != m_atoms.end())
+            continue;
+        m_atoms[m_queue[i]] = None;
+        names.push_back(const_cast<char *>(m_queue[i].c_str()));
+    }
+
+    if (!names.empty()) {
+        std::vector<Atom> atoms(names.size(), None);
+        FBTK_ROUNDTRIP("AtomCache::resolve");
+        XInternAtoms(App::instance()->display(), &names[0], names.size(),
+                     False, &atoms[0]);
+        for (size_t i = 0; i < names.size(); ++i)
+            m_atoms[names[i]] = atoms[i];
+    }
+    m_queue.clear();
+}
+
+Atom AtomCache::get(const std::string &name) {
+    Atoms::iterator it = m_atoms.find(name);
+    if (it != m_atoms.end())
+        return it->second;
+
+    m_queue.push_back(name);
+    resolve();
+    return m_atoms[name];
+}
+
+void AtomCache::get(const char *const *names, Atom *atoms, size_t num) {
+    for (size_t i = 0; i < num; ++i)
+        queue(names[i]);
+    resolve();
+    for (size_t i = 0; i < num; ++i)
+        atoms[i] = m_atoms[names[i]];
+}
+
+} // end namespace FbTk
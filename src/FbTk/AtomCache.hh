@@ -0,0 +1,79 @@
+// AtomCache.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#ifndef FBTK_ATOMCACHE_HH
+#define FBTK_ATOMCACHE_HH
+
+#include "NotCopyable.hh"
+
+#include <X11/Xlib.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace FbTk {
+
+/**
+   Interns atoms in batches. Each XInternAtom() is a round-trip, so the
+   names a module will need are queued with a Names object at namespace
+   scope, and the first lookup of an unknown name interns all the queued
+   ones with it in a single XInternAtoms(). Names that are neither queued
+   nor known yet, like those of user patterns, are interned when they're
+   first asked for, together with whatever was queued meanwhile.
+*/
+class AtomCache: private NotCopyable {
+public:
+    /// queues names to intern with the next batch
+    class Names {
+    public:
+        Names(const char *const *names, size_t num);
+        /// for tables of structs with a 'name' member
+        template <typename T>
+        Names(const T *table, size_t num) {
+            for (size_t i = 0; i < num; ++i)
+                AtomCache::instance().queue(table[i].name);
+        }
+    };
+
+    static AtomCache &instance();
+
+    void queue(const std::string &name);
+    /// interns the queued names
+    void resolve();
+
+    /// @return the atom called 'name'
+    Atom get(const std::string &name);
+    /// looks up 'num' atoms at once
+    void get(const char *const *names, Atom *atoms, size_t num);
+
+private:
+    AtomCache() { }
+
+    typedef std::map<std::string, Atom> Atoms;
+    Atoms m_atoms;
+    std::vector<std::string> m_queue;
+};
+
+} // end namespace FbTk
+
+#endif // FBTK_ATOMCACHE_HH
@@ -22,16 +22,57 @@
 #include "AutoReloadHelper.hh"
 
 #include "FileUtil.hh"
+#include "FileWatcher.hh"
 #include "StringUtil.hh"
 
 namespace FbTk {
 
+AutoReloadHelper::AutoReloadHelper():
+    m_watched(true),
+    m_all_dirty(false),
+    m_pending(false) {
+}
+
+AutoReloadHelper::~AutoReloadHelper() {
+    FileWatcher::instance().remove(*this);
+}
+
 void AutoReloadHelper::checkReload() {
     if (!m_reload_cmd.get())
         return;
-    TimestampMap::const_iterator it = m_timestamps.begin();
+
+    if (m_pending) {
+        reload();
+        return;
+    }
+
+    TimestampMap::const_iterator it;
     TimestampMap::const_iterator it_end = m_timestamps.end();
-    for (; it != it_end; ++it) {
+
+    if (m_watched) {
+        FileWatcher::instance().update();
+
+        if (!m_all_dirty) {
+            std::set<std::string> dirty;
+            dirty.swap(m_dirty);
+
+            std::set<std::string>::const_iterator file = dirty.begin();
+            for (; file != dirty.end(); ++file) {
+                it = m_timestamps.find(*file);
+                if (it != it_end &&
+                    FileUtil::getLastStatusChangeTimestamp(it->first.c_str()) != it->second) {
+                    reload();
+                    return;
+                }
+            }
+            return;
+        }
+    }
+
+    m_all_dirty = false;
+    m_dirty.clear();
+
+    for (it = m_timestamps.begin(); it != it_end; ++it) {
         if (FileUtil::getLastStatusChangeTimestamp(it->first.c_str()) !=
             it->second) {
             reload();
@@ -48,10 +89,23 @@ void AutoReloadHelper::setMainFile(const std::string& file) {
     reload();
 }
 
+void AutoReloadHelper::deferMainFile(const std::string& file) {
+    std::string expanded_file = StringUtil::expandFilename(file);
+    if (expanded_file == m_main_file)
+        return;
+    m_main_file = expanded_file;
+    m_pending = true;
+}
+
 void AutoReloadHelper::addFile(const std::string& file) {
     if (file.empty())
         return;
     std::string expanded_file = StringUtil::expandFilename(file);
+
+    TimestampMap::iterator it = m_timestamps.find(expanded_file);
+    if (it == m_timestamps.end() && m_watched)
+        m_watched = FileWatcher::instance().add(expanded_file, *this);
+
     m_timestamps[expanded_file] = FileUtil::getLastStatusChangeTimestamp(expanded_file.c_str());
 }
 
@@ -59,6 +113,11 @@ void AutoReloadHelper::reload() {
     if (!m_reload_cmd.get())
         return;
     m_timestamps.clear();
+    FileWatcher::instance().remove(*this);
+    m_watched = true;
+    m_all_dirty = false;
+    m_dirty.clear();
+    m_pending = false;
     addFile(m_main_file);
     m_reload_cmd->execute();
 }
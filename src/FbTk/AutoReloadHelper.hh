@@ -23,6 +23,7 @@
 #define AUTORELOADHELPER_HH
 
 #include <map>
+#include <set>
 #include <string>
 #include <sys/types.h>
 
@@ -31,22 +32,44 @@
 
 namespace FbTk {
 
+/**
+   Executes a command whenever one of a set of files changed.
+
+   If the FileWatcher can watch all the files, checkReload() only looks at
+   the files it was told about, otherwise every file is stat()ed.
+ */
 class AutoReloadHelper {
 public:
+    AutoReloadHelper();
+    ~AutoReloadHelper();
 
     void setMainFile(const std::string& filename);
+    /// like setMainFile(), but the file is read by the next checkReload()
+    void deferMainFile(const std::string& filename);
     void addFile(const std::string& filename);
     void setReloadCmd(RefCount<Command<void> > cmd) { m_reload_cmd = cmd; }
 
     void checkReload();
     void reload();
 
+    /// called by the FileWatcher, 'filename' might have changed
+    void markDirty(const std::string &filename) { m_dirty.insert(filename); }
+    /// called by the FileWatcher, every file might have changed
+    void markAllDirty() { m_all_dirty = true; }
+    /// called by the FileWatcher, a file isn't watched anymore
+    void watchLost() { m_watched = false; }
+
 private:
     RefCount<Command<void> > m_reload_cmd;
     std::string m_main_file;
 
     typedef std::map<std::string, time_t> TimestampMap;
     TimestampMap m_timestamps;
+
+    bool m_watched; ///< all files are watched by the FileWatcher
+    bool m_all_dirty;
+    bool m_pending; ///< the main file wasn't read yet
+    std::set<std::string> m_dirty;
 };
 
 } // end namespace FbTk
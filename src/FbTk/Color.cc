@@ -26,6 +26,8 @@
 #include "I18n.hh"
 
 #include <iostream>
+#include <map>
+#include <vector>
 
 using std::cerr;
 using std::endl;
@@ -37,6 +39,149 @@ inline unsigned char maxValue(unsigned short colval) {
    return colval == 65535 ? 0xFF : static_cast<unsigned char>(colval/0xFF);
 }
 
+/// where a color channel lives in the pixels of a TrueColor visual
+struct Channel {
+    Channel(): shift(0), bits(0) { }
+    explicit Channel(unsigned long mask): shift(0), bits(0) {
+        while (mask != 0 && (mask & 1) == 0) {
+            mask >>= 1;
+            ++shift;
+        }
+        for (; mask & 1; mask >>= 1)
+            ++bits;
+    }
+
+    /// rounds value to what the visual can show, like the server does
+    unsigned long pixel(unsigned short &value) const {
+        if (bits == 0 || bits > 16)
+            return 0;
+        unsigned long max = (1ul << bits) - 1;
+        unsigned long v = value >> (16 - bits);
+        value = v * 65535 / max;
+        return v << shift;
+    }
+
+    int shift, bits;
+};
+
+struct RGB {
+    explicit RGB(const XColor &color):
+        red(color.red), green(color.green), blue(color.blue) { }
+    bool operator < (const RGB &other) const {
+        if (red != other.red)
+            return red < other.red;
+        if (green != other.green)
+            return green < other.green;
+        return blue < other.blue;
+    }
+    unsigned short red, green, blue;
+};
+
+/**
+ * The colors of the default colormap of a screen. On TrueColor visuals
+ * a pixel is computed from the rgb value without asking the server,
+ * other visuals share one server allocation for all colors with the same
+ * rgb value, so copying a color costs no round trip.
+ */
+struct ColorMap {
+    ColorMap(): initialized(false), true_color(false) { }
+
+    bool initialized, true_color;
+    Channel red, green, blue;
+    /// parsed color strings, named colors are looked up by the server
+    std::map<string, XColor> parsed;
+    /// allocated colors by the rgb value asked for
+    std::map<RGB, XColor> allocated;
+    /// the number of colors holding each allocated pixel, the server
+    /// gets a single allocation of it
+    std::map<unsigned long, unsigned int> refs;
+};
+
+ColorMap &colorMap(int screen) {
+    static std::vector<ColorMap> maps;
+    Display *disp = FbTk::App::instance()->display();
+    if (maps.empty())
+        maps.resize(ScreenCount(disp));
+
+    ColorMap &cmap = maps[screen];
+    if (!cmap.initialized) {
+        cmap.initialized = true;
+        Visual *visual = DefaultVisual(disp, screen);
+        cmap.true_color = visual->c_class == TrueColor;
+        cmap.red = Channel(visual->red_mask);
+        cmap.green = Channel(visual->green_mask);
+        cmap.blue = Channel(visual->blue_mask);
+    }
+    return cmap;
+}
+
+bool parseColor(const string &color_string, int screen, XColor &color) {
+    ColorMap &cmap = colorMap(screen);
+    std::map<string, XColor>::const_iterator it = cmap.parsed.find(color_string);
+    if (it != cmap.parsed.end()) {
+        color = it->second;
+        return true;
+    }
+
+    Display *disp = FbTk::App::instance()->display();
+    if (!XParseColor(disp, DefaultColormap(disp, screen),
+                     color_string.c_str(), &color))
+        return false;
+    cmap.parsed[color_string] = color;
+    return true;
+}
+
+/// sets the pixel and the rgb value the screen shows for the rgb of color
+bool allocColor(int screen, XColor &color) {
+    ColorMap &cmap = colorMap(screen);
+    if (cmap.true_color) {
+        color.pixel = cmap.red.pixel(color.red) |
+            cmap.green.pixel(color.green) |
+            cmap.blue.pixel(color.blue);
+        return true;
+    }
+
+    RGB rgb(color);
+    std::map<RGB, XColor>::const_iterator it = cmap.allocated.find(rgb);
+    if (it != cmap.allocated.end()) {
+        color = it->second;
+        ++cmap.refs[color.pixel];
+        return true;
+    }
+
+    Display *disp = FbTk::App::instance()->display();
+    Colormap colm = DefaultColormap(disp, screen);
+    if (!XAllocColor(disp, colm, &color))
+        return false;
+    // close colors may get the same pixel
+    if (cmap.refs[color.pixel]++ != 0)
+        XFreeColors(disp, colm, &color.pixel, 1, 0);
+    cmap.allocated[rgb] = color;
+    return true;
+}
+
+void freeColor(int screen, unsigned long pixel) {
+    ColorMap &cmap = colorMap(screen);
+    if (cmap.true_color)
+        return;
+
+    std::map<unsigned long, unsigned int>::iterator ref = cmap.refs.find(pixel);
+    if (ref == cmap.refs.end() || --ref->second != 0)
+        return;
+    cmap.refs.erase(ref);
+
+    std::map<RGB, XColor>::iterator it = cmap.allocated.begin();
+    while (it != cmap.allocated.end()) {
+        if (it->second.pixel == pixel)
+            cmap.allocated.erase(it++);
+        else
+            ++it;
+    }
+
+    Display *disp = FbTk::App::instance()->display();
+    XFreeColors(disp, DefaultColormap(disp, screen), &pixel, 1, 0);
+}
+
 }
 
 namespace FbTk {
@@ -85,16 +230,14 @@ bool Color::setFromString(const char *color_string, int screen) {
     StringUtil::removeFirstWhitespace(color_string_tmp);
     StringUtil::removeTrailingWhitespace(color_string_tmp);
 
-    Display *disp = App::instance()->display();
-    Colormap colm = DefaultColormap(disp, screen);
-
     XColor color;
 
-    if (! XParseColor(disp, colm, color_string_tmp.c_str(), &color))
+    if (! parseColor(color_string_tmp, screen, color))
         return false;
-    else if (! XAllocColor(disp, colm, &color))
+    else if (! allocColor(screen, color))
         return false;
 
+    free();
     setPixel(color.pixel);
     setRGB(maxValue(color.red),
            maxValue(color.green),
@@ -107,14 +250,12 @@ bool Color::setFromString(const char *color_string, int screen) {
 
 bool Color::validColorString(const char *color_string, int screen) {
     XColor color;
-    Display *disp = App::instance()->display();
-    Colormap colm = DefaultColormap(disp, screen);
     // trim white space
     string color_string_tmp = color_string;
     StringUtil::removeFirstWhitespace(color_string_tmp);
     StringUtil::removeTrailingWhitespace(color_string_tmp);
 
-    return XParseColor(disp, colm, color_string_tmp.c_str(), &color) != 0;
+    return parseColor(color_string_tmp, screen, color);
 }
 
 Color &Color::operator = (const Color &col_copy) {
@@ -129,9 +270,7 @@ Color &Color::operator = (const Color &col_copy) {
 
 void Color::free() {
     if (isAllocated()) {
-        unsigned long pixel = m_pixel;
-        Display *disp = App::instance()->display();
-        XFreeColors(disp, DefaultColormap(disp, m_screen), &pixel, 1, 0);
+        freeColor(m_screen, m_pixel);
         setPixel(0);
         setRGB(0, 0, 0);
         setAllocated(false);
@@ -155,7 +294,6 @@ void Color::copy(const Color &col_copy) {
 
 void Color::allocate(unsigned short red, unsigned short green, unsigned short blue, int screen) {
 
-    Display *disp = App::instance()->display();
     XColor color;
     // fill xcolor structure
     color.red = red;
@@ -163,7 +301,7 @@ void Color::allocate(unsigned short red, unsigned short green, unsigned short bl
     color.blue = blue;
 
 
-    if (!XAllocColor(disp, DefaultColormap(disp, screen), &color)) {
+    if (!allocColor(screen, color)) {
         _FB_USES_NLS;
         cerr<<"FbTk::Color: "<<_FBTK_CONSOLETEXT(Error, ColorAllocation, "Allocation error.", "XAllocColor failed...")<<endl;
     } else {
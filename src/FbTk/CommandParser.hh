@@ -23,8 +23,10 @@
 #define CommandParser_HH
 
 #include "StringUtil.hh"
+#include "RefCount.hh"
 
 #include <string>
+#include <list>
 #include <map>
 
 using std::string;
@@ -105,6 +107,39 @@ public:
         return parse(command, args, trusted);
     }
 
+    /**
+       Like parse(), but keeps the most recently used commands and hands out
+       the same one again for the same line, as key bindings do. For lines
+       that come in over and over, like those of fluxbox-remote.
+    */
+    RefCount<Command<Type> > parseCached(const string &line, bool trusted = true) {
+        CacheKey key(trusted, line);
+        typename CacheIndex::iterator found = m_cache_index.find(key);
+        if (found != m_cache_index.end()) {
+            // move to the front of the lru list
+            m_cache.splice(m_cache.begin(), m_cache, found->second);
+            return found->second->second;
+        }
+
+        RefCount<Command<Type> > cmd(parse(line, trusted));
+        if (cmd == 0)
+            return cmd;
+
+        m_cache.push_front(std::make_pair(key, cmd));
+        m_cache_index[key] = m_cache.begin();
+        if (m_cache.size() > CACHE_SIZE) {
+            m_cache_index.erase(m_cache.back().first);
+            m_cache.pop_back();
+        }
+        return cmd;
+    }
+
+    /// forgets the commands of parseCached(), e.g. when the config changed
+    void clearCache() {
+        m_cache_index.clear();
+        m_cache.clear();
+    }
+
     bool registerCommand(string name, Creator creator) {
         name = StringUtil::toLower(name);
         m_creators[name] = creator;
@@ -124,7 +159,14 @@ private:
     CommandParser() {}
     ~CommandParser() {}
 
+    enum { CACHE_SIZE = 32 };
+    typedef std::pair<bool, std::string> CacheKey; ///< trusted, line
+    typedef std::list<std::pair<CacheKey, RefCount<Command<Type> > > > Cache;
+    typedef std::map<CacheKey, typename Cache::iterator> CacheIndex;
+
     CreatorMap m_creators;
+    Cache m_cache; ///< most recently used first
+    CacheIndex m_cache_index;
 };
 
 } // end namespace FbTk
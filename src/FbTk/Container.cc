@@ -29,6 +29,7 @@
 #include "STLUtil.hh"
 
 #include <algorithm>
+#include <iterator>
 
 namespace FbTk {
 
@@ -74,20 +75,34 @@ void Container::insertItem(Item item, int pos) {
         return;
 
     item->setOrientation(m_orientation);
-    if (pos >= size() || pos < 0) {
-        m_item_list.push_back(item);
-    } else if (pos == 0) {
-        m_item_list.push_front(item);
-    } else {
-        ItemList::iterator it = begin();
-        for (; pos != 0; ++it, --pos)
+    if (pos >= size() || pos < 0)
+        pos = size();
+
+    m_item_list.insert(m_item_list.begin() + pos, item);
+    reindex(pos);
+
+    repositionItems();
+}
+
+void Container::insertItems(const ItemList &items, int pos) {
+    if (pos < 0 || pos > size())
+        pos = size();
+
+    ItemList added;
+    ItemList::const_iterator it = items.begin();
+    ItemList::const_iterator it_end = items.end();
+    for (; it != it_end; ++it) {
+        // it must be a child of this window, and only be here once
+        if ((*it)->parent() != this ||
+            !m_item_index.insert(std::make_pair(*it, -1)).second)
             continue;
 
-        m_item_list.insert(it, item);
+        (*it)->setOrientation(m_orientation);
+        added.push_back(*it);
     }
 
-    // make sure we dont have duplicate items
-    m_item_list.unique();
+    m_item_list.insert(m_item_list.begin() + pos, added.begin(), added.end());
+    reindex(pos);
 
     repositionItems();
 }
@@ -105,82 +120,76 @@ void Container::moveItem(Item item, int movement) {
     if (newindex < 0) // neg wrap
         newindex += size;
 
-    ItemList::iterator it = std::find(begin(), end(), item);
-    m_item_list.erase(it);
+    m_item_list.erase(m_item_list.begin() + index);
+    m_item_list.insert(m_item_list.begin() + newindex, item);
+    reindex(std::min(index, newindex));
 
-    for (it = begin(); newindex >= 0; ++it, --newindex) {
-        if (newindex == 0) {
-            break;
-        }
-    }
-
-    m_item_list.insert(it, item);
     repositionItems();
 }
 
 // returns true if something was done
 bool Container::moveItemTo(Item item, int x, int y) {
-    Window parent_return=0,
-        root_return=0,
-        *children_return = NULL;
-
-    unsigned int nchildren_return;
-
-    // get the root window
-    if (!XQueryTree(display(), window(),
-                    &root_return, &parent_return, &children_return, &nchildren_return))
-        parent_return = parent_return;
-
-    if (children_return != NULL)
-        XFree(children_return);
-
-    int dest_x = 0, dest_y = 0;
-    Window itemwin = 0;
-    if (!XTranslateCoordinates(display(),
-                               root_return, window(),
-                               x, y, &dest_x, &dest_y,
-                               &itemwin))
-        return false;
-
-    ItemList::iterator it = find_if(begin(), end(),
-                                    CompareWindow(&FbWindow::window,
-                                                  itemwin));
-    // not found :(
-    if (it == end())
-        return false;
+    // root coordinates
+    int root_x, root_y;
+    rootPosition(root_x, root_y);
+    x -= root_x;
+    y -= root_y;
+    return itemAt(x, y) != 0;
+}
 
-    Window child_return = 0;
-    //make x and y relative to our item
-    if (!XTranslateCoordinates(display(),
-                               window(), itemwin,
-                               dest_x, dest_y, &x, &y,
-                               &child_return))
-        return false;
-    return true;
+Container::Item Container::itemAt(int &x, int &y) {
+    ItemList::iterator it = begin();
+    for (; it != end(); ++it) {
+        const int bw = (*it)->borderWidth();
+        if (x < (*it)->x() || y < (*it)->y() ||
+            x >= (*it)->x() + static_cast<int>((*it)->width()) + 2 * bw ||
+            y >= (*it)->y() + static_cast<int>((*it)->height()) + 2 * bw)
+            continue;
+        x -= (*it)->x() + bw;
+        y -= (*it)->y() + bw;
+        return *it;
+    }
+    return 0;
 }
 
 bool Container::removeItem(Item item) {
-    ItemList::iterator it = begin();
-    ItemList::iterator it_end = end();
-    for (; it != it_end && (*it) != item; ++it);
+    return removeItem(find(item));
+}
+
+bool Container::removeItems(const ItemList &items) {
+    // clear the slots of the items, then close the gaps in one pass
+    bool removed = false;
+    ItemList::const_iterator it = items.begin();
+    ItemList::const_iterator it_end = items.end();
+    for (; it != it_end; ++it) {
+        IndexMap::iterator index_it = m_item_index.find(*it);
+        if (index_it == m_item_index.end())
+            continue;
+
+        m_item_list[index_it->second] = 0;
+        m_item_index.erase(index_it);
+        removed = true;
+    }
 
-    if (it == it_end)
+    if (!removed)
         return false;
 
-    m_item_list.erase(it);
+    m_item_list.erase(std::remove(m_item_list.begin(), m_item_list.end(),
+                                  static_cast<Item>(0)),
+                      m_item_list.end());
+    reindex(0);
+
     repositionItems();
     return true;
 }
 
 bool Container::removeItem(int index) {
-    if (index < 0 || index > size())
+    if (index < 0 || index >= size())
         return false;
 
-    ItemList::iterator it = begin();
-    for (; index != 0; ++it, --index)
-        continue;
-
-    m_item_list.erase(it);
+    m_item_index.erase(m_item_list[index]);
+    m_item_list.erase(m_item_list.begin() + index);
+    reindex(index);
 
     repositionItems();
     return true;
@@ -188,25 +197,43 @@ bool Container::removeItem(int index) {
 
 void Container::removeAll() {
     m_item_list.clear();
+    m_item_index.clear();
     if (!m_update_lock) {
         clear();
     }
 
 }
 
-int Container::find(ConstItem item) {
-    ItemList::iterator it = m_item_list.begin();
-    ItemList::iterator it_end = m_item_list.end();
-    int index = 0;
-    for (; it != it_end; ++it, ++index) {
-        if ((*it) == item)
-            break;
+void Container::setItems(const ItemList &items) {
+    m_item_list.clear();
+    m_item_index.clear();
+
+    ItemList::const_iterator it = items.begin();
+    ItemList::const_iterator it_end = items.end();
+    for (; it != it_end; ++it) {
+        // it must be a child of this window, and only be here once
+        if ((*it)->parent() != this ||
+            !m_item_index.insert(std::make_pair(*it, size())).second)
+            continue;
+
+        (*it)->setOrientation(m_orientation);
+        m_item_list.push_back(*it);
     }
 
-    if (it == it_end)
+    repositionItems();
+}
+
+int Container::find(ConstItem item) const {
+    IndexMap::const_iterator it = m_item_index.find(item);
+    if (it == m_item_index.end())
         return -1;
 
-    return index;
+    return it->second;
+}
+
+void Container::reindex(int from) {
+    for (int index = from; index < size(); ++index)
+        m_item_index[m_item_list[index]] = index;
 }
 
 void Container::setMaxSizePerClient(unsigned int size) {
@@ -398,7 +425,8 @@ void Container::repositionItems() {
         translatePosition(m_orientation, tmpx, tmpy, tmpw, tmph, borderW);
         translateSize(m_orientation, tmpw, tmph);
 
-        // resize each clients including border in size
+        // resize each clients including border in size, items that keep
+        // their geometry don't send any request
         (*it)->moveResize(tmpx, tmpy,
                           tmpw, tmph);
 
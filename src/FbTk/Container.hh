@@ -28,7 +28,8 @@
 #include "NotCopyable.hh"
 #include "Orientation.hh"
 
-#include <list>
+#include <vector>
+#include <map>
 #include <functional>
 
 namespace FbTk {
@@ -42,7 +43,7 @@ public:
     enum Alignment { LEFT, CENTER, RIGHT, RELATIVE };
     typedef Button * Item;
     typedef const Button * ConstItem;
-    typedef std::list<Item> ItemList;
+    typedef std::vector<Item> ItemList;
 
     explicit Container(const FbWindow &parent, bool auto_resize = true);
     virtual ~Container();
@@ -54,12 +55,25 @@ public:
                     unsigned int width, unsigned int height);
 
     void insertItem(Item item, int pos = -1);
+    /// inserts the items in order at pos with a single relayout
+    void insertItems(const ItemList &items, int pos = -1);
     bool removeItem(int item); // return true if something was removed
     bool removeItem(Item item); // return true if something was removed
+    /// removes the items with a single relayout, returns true if something was removed
+    bool removeItems(const ItemList &items);
     void removeAll();
+    /// makes 'items' the items, in that order, with a single relayout
+    void setItems(const ItemList &items);
     void moveItem(Item item, int movement); // wraps around
     bool moveItemTo(Item item, int x, int y);
-    int find(ConstItem item);
+    /**
+       Finds the item at x, y in the container from their cached geometry
+       @param x, y are made relative to the item found
+       @return the item, 0 if there is none at x, y
+    */
+    Item itemAt(int &x, int &y);
+    /// @return the index of the item, -1 if it isn't in the container
+    int find(ConstItem item) const;
     void setMaxSizePerClient(unsigned int size);
     void setMaxTotalSize(unsigned int size);
     void setAlignment(Alignment a);
@@ -99,7 +113,11 @@ public:
     void clear(); // clear all windows
 
 private:
+    typedef std::map<ConstItem, int> IndexMap;
+
     void repositionItems();
+    /// updates the index of the items from 'from' on
+    void reindex(int from);
 
     Orientation m_orientation;
 
@@ -107,6 +125,7 @@ private:
     unsigned int m_max_size_per_client;
     unsigned int m_max_total_size;
     ItemList m_item_list;
+    IndexMap m_item_index; ///< the position of each item in m_item_list
     bool m_update_lock, m_auto_resize;
 };
 
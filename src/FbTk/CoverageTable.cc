@@ -0,0 +1,152 @@
+// CoverageTable.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "CoverageTable.hh"
+
+#include <algorithm>
+
+namespace FbTk {
+
+namespace {
+
+void makeUnique(std::vector<int> &values) {
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+}
+
+size_t indexOf(const std::vector<int> &values, int value) {
+    return std::lower_bound(values.begin(), values.end(), value) - values.begin();
+}
+
+} // end anonymous namespace
+
+void CoverageTable::clear() {
+    m_rects.clear();
+    m_xs.clear();
+    m_ys.clear();
+    m_count.clear();
+    m_area.clear();
+    m_column.clear();
+    m_row.clear();
+    m_built = false;
+}
+
+void CoverageTable::add(int left, int top, int right, int bottom) {
+    if (left >= right || top >= bottom)
+        return;
+
+    Rect rect = { left, top, right, bottom };
+    m_rects.push_back(rect);
+    m_built = false;
+}
+
+void CoverageTable::build() {
+    m_xs.clear();
+    m_ys.clear();
+    for (size_t r = 0; r < m_rects.size(); ++r) {
+        m_xs.push_back(m_rects[r].left);
+        m_xs.push_back(m_rects[r].right);
+        m_ys.push_back(m_rects[r].top);
+        m_ys.push_back(m_rects[r].bottom);
+    }
+    makeUnique(m_xs);
+    makeUnique(m_ys);
+
+    const size_t nx = m_xs.size(), ny = m_ys.size();
+    m_count.assign(nx * ny, 0);
+    m_area.assign(nx * ny, 0);
+    m_column.assign(nx * ny, 0);
+    m_row.assign(nx * ny, 0);
+
+    // add up the corners of each rectangle, the prefix sums of that give
+    // the number of rectangles covering each cell
+    for (size_t r = 0; r < m_rects.size(); ++r) {
+        size_t x0 = indexOf(m_xs, m_rects[r].left), x1 = indexOf(m_xs, m_rects[r].right);
+        size_t y0 = indexOf(m_ys, m_rects[r].top), y1 = indexOf(m_ys, m_rects[r].bottom);
+        ++m_count[x0 * ny + y0];
+        --m_count[x1 * ny + y0];
+        --m_count[x0 * ny + y1];
+        ++m_count[x1 * ny + y1];
+    }
+
+    for (size_t i = 0; i < nx; ++i) {
+        for (size_t j = 0; j < ny; ++j) {
+            int &count = m_count[i * ny + j];
+            if (i > 0)
+                count += m_count[(i - 1) * ny + j];
+            if (j > 0)
+                count += m_count[i * ny + j - 1];
+            if (i > 0 && j > 0)
+                count -= m_count[(i - 1) * ny + j - 1];
+        }
+    }
+
+    for (size_t i = 0; i + 1 < nx; ++i) {
+        const int64_t dx = m_xs[i + 1] - m_xs[i];
+        for (size_t j = 0; j + 1 < ny; ++j) {
+            const int64_t dy = m_ys[j + 1] - m_ys[j];
+            const int64_t count = m_count[i * ny + j];
+            m_area[(i + 1) * ny + j + 1] = m_area[i * ny + j + 1] +
+                m_area[(i + 1) * ny + j] - m_area[i * ny + j] + count * dx * dy;
+            m_column[i * ny + j + 1] = m_column[i * ny + j] + count * dy;
+            m_row[(i + 1) * ny + j] = m_row[i * ny + j] + count * dx;
+        }
+    }
+
+    m_built = true;
+}
+
+int64_t CoverageTable::integral(int x, int y) const {
+    if (m_xs.empty() || x <= m_xs.front() || y <= m_ys.front())
+        return 0;
+
+    // nothing is covered beyond the last edges
+    x = std::min(x, m_xs.back());
+    y = std::min(y, m_ys.back());
+
+    // the grid point at or below (x, y)
+    size_t i = std::upper_bound(m_xs.begin(), m_xs.end(), x) - m_xs.begin() - 1;
+    size_t j = std::upper_bound(m_ys.begin(), m_ys.end(), y) - m_ys.begin() - 1;
+
+    const size_t ny = m_ys.size();
+    const int64_t dx = x - m_xs[i], dy = y - m_ys[j];
+    int64_t area = m_area[i * ny + j];
+    // the cell the point lies in is covered evenly
+    if (dx != 0)
+        area += dx * m_column[i * ny + j];
+    if (dy != 0)
+        area += dy * m_row[i * ny + j];
+    if (dx != 0 && dy != 0)
+        area += dx * dy * m_count[i * ny + j];
+
+    return area;
+}
+
+int64_t CoverageTable::coverage(int left, int top, int right, int bottom) const {
+    if (!m_built || left >= right || top >= bottom)
+        return 0;
+
+    return integral(right, bottom) - integral(left, bottom) -
+        integral(right, top) + integral(left, top);
+}
+
+} // end namespace FbTk
@@ -0,0 +1,79 @@
+// CoverageTable.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#ifndef FBTK_COVERAGETABLE_HH
+#define FBTK_COVERAGETABLE_HH
+
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+namespace FbTk {
+
+/**
+ * Tells how much a set of rectangles covers any other rectangle, i.e. the
+ * sum of the areas it shares with each of them.
+ * The rectangles are added first, then build() makes a summed-area table
+ * over the distinct rectangle edges. Each query is exact and takes four
+ * binary searches, no matter how many rectangles there are.
+ */
+class CoverageTable {
+public:
+    CoverageTable(): m_built(false) { }
+
+    void clear();
+    /// adds the rectangle [left, right) x [top, bottom)
+    void add(int left, int top, int right, int bottom);
+    void build();
+
+    /// @return the summed area the rectangle shares with all added rectangles
+    int64_t coverage(int left, int top, int right, int bottom) const;
+    /// @return true if the rectangle doesn't share any area with the added ones
+    bool isFree(int left, int top, int right, int bottom) const {
+        return coverage(left, top, right, bottom) == 0;
+    }
+
+    size_t size() const { return m_rects.size(); }
+
+private:
+    struct Rect {
+        int left, top, right, bottom;
+    };
+
+    /// covered area in (-inf, x) x (-inf, y)
+    int64_t integral(int x, int y) const;
+
+    std::vector<Rect> m_rects;
+    std::vector<int> m_xs, m_ys; ///< the sorted distinct edges
+
+    // all indexed by [i * m_ys.size() + j] for the grid point (m_xs[i], m_ys[j]),
+    // the cell (i, j) spans to the grid point (i + 1, j + 1)
+    std::vector<int> m_count; ///< rectangles covering cell (i, j)
+    std::vector<int64_t> m_area; ///< covered area up to the grid point
+    std::vector<int64_t> m_column; ///< covered height in column i up to m_ys[j]
+    std::vector<int64_t> m_row; ///< covered width in row j up to m_xs[i]
+    bool m_built;
+};
+
+} // end namespace FbTk
+
+#endif // FBTK_COVERAGETABLE_HH
@@ -0,0 +1,177 @@
+// EventCoalescer.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#include "EventCoalescer.hh"
+#include "EventManager.hh"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <utility>
+
+namespace {
+
+/// indices of the last (latest) event of a kind, -1 if none
+struct WindowState {
+    WindowState(): motion(-1), expose(-1), configure(-1) { }
+    int motion, expose, configure;
+};
+
+typedef std::map<Window, WindowState> WindowStates;
+typedef std::set<std::pair<Window, Atom> > Properties;
+
+void mergeExpose(XExposeEvent &into, const XExposeEvent &from) {
+    int x2 = std::max(into.x + into.width, from.x + from.width);
+    int y2 = std::max(into.y + into.height, from.y + from.height);
+    into.x = std::min(into.x, from.x);
+    into.y = std::min(into.y, from.y);
+    into.width = x2 - into.x;
+    into.height = y2 - into.y;
+}
+
+/// copies the values of 'from' which 'into' doesn't set itself
+void mergeConfigure(XConfigureRequestEvent &into, const XConfigureRequestEvent &from) {
+    unsigned long missing = from.value_mask & ~into.value_mask;
+    if (missing & CWX)
+        into.x = from.x;
+    if (missing & CWY)
+        into.y = from.y;
+    if (missing & CWWidth)
+        into.width = from.width;
+    if (missing & CWHeight)
+        into.height = from.height;
+    if (missing & CWBorderWidth)
+        into.border_width = from.border_width;
+    if (missing & CWStackMode) {
+        into.detail = from.detail;
+        into.above = from.above;
+        missing |= (from.value_mask & CWSibling);
+    } else
+        missing &= ~CWSibling;
+
+    into.value_mask |= missing;
+}
+
+void forgetWindow(Window win, WindowStates &windows, Properties &properties) {
+    windows.erase(win);
+    properties.erase(properties.lower_bound(std::make_pair(win, (Atom)0)),
+                     properties.upper_bound(std::make_pair(win, ~(Atom)0)));
+}
+
+} // anonymous namespace
+
+namespace FbTk {
+
+void EventCoalescer::coalesce() {
+
+    // handlers may have taken events of the last batch out of the queue
+    m_pending = std::min(m_pending, XQLength(m_display));
+    if (m_pending > 0)
+        return;
+
+    const int queued = XEventsQueued(m_display, QueuedAfterReading);
+    if (queued < 2)
+        return;
+
+    m_batch.resize(queued);
+    m_dropped.assign(queued, 0);
+    for (int i = 0; i < queued; ++i)
+        XNextEvent(m_display, &m_batch[i]);
+
+    WindowStates windows;
+    Properties properties;
+
+    // walk backwards, so the latest event of a kind is the one we keep
+    for (int i = queued - 1; i >= 0; --i) {
+        XEvent &ev = m_batch[i];
+        Window win = EventManager::getEventWindow(ev);
+
+        switch (ev.type) {
+        case MotionNotify: {
+            WindowState &state = windows[win];
+            if (state.motion >= 0 &&
+                m_batch[state.motion].xmotion.state == ev.xmotion.state) {
+                m_dropped[i] = 1;
+                ++m_stats.motion;
+            } else
+                state.motion = i;
+        }
+            break;
+        case Expose: {
+            WindowState &state = windows[win];
+            if (state.expose >= 0) {
+                mergeExpose(m_batch[state.expose].xexpose, ev.xexpose);
+                m_dropped[i] = 1;
+                ++m_stats.expose;
+            } else
+                state.expose = i;
+        }
+            break;
+        case ConfigureRequest: {
+            WindowState &state = windows[win];
+            if (state.configure >= 0) {
+                mergeConfigure(m_batch[state.configure].xconfigurerequest,
+                               ev.xconfigurerequest);
+                m_dropped[i] = 1;
+                ++m_stats.configure;
+            } else
+                state.configure = i;
+        }
+            break;
+        case PropertyNotify:
+            if (!properties.insert(std::make_pair(win, ev.xproperty.atom)).second) {
+                m_dropped[i] = 1;
+                ++m_stats.property;
+            }
+            break;
+        case KeyPress:
+        case KeyRelease:
+        case ButtonPress:
+        case ButtonRelease:
+        case EnterNotify:
+        case LeaveNotify:
+        case FocusIn:
+        case FocusOut: {
+            // the order of input events relative to each other matters
+            WindowStates::iterator it = windows.begin();
+            for (; it != windows.end(); ++it)
+                it->second.motion = -1;
+            forgetWindow(win, windows, properties);
+        }
+            break;
+        default:
+            forgetWindow(win, windows, properties);
+            break;
+        }
+    }
+
+    // XPutBackEvent puts the event in front of the queue
+    for (int i = queued - 1; i >= 0; --i) {
+        if (m_dropped[i])
+            continue;
+        XPutBackEvent(m_display, &m_batch[i]);
+        ++m_pending;
+    }
+
+    m_stats.dispatched += m_pending;
+}
+
+} // end namespace FbTk
@@ -0,0 +1,88 @@
+// EventCoalescer.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#ifndef FBTK_EVENTCOALESCER_HH
+#define FBTK_EVENTCOALESCER_HH
+
+#include "NotCopyable.hh"
+
+#include <X11/Xlib.h>
+#include <vector>
+
+namespace FbTk {
+
+/**
+   Folds redundant events in the X event queue before they are dispatched.
+
+   coalesce() reads everything that is already queued, drops events which
+   are superseded by a later event of the same kind and puts the rest back
+   into the Xlib queue, in their original order. Thus the events are still
+   visible to handlers peeking ahead in the queue (XCheckTypedWindowEvent
+   and friends).
+
+   Per window it
+    - keeps only the last of consecutive MotionNotify events with the same
+      button / modifier state
+    - merges Expose rectangles into the last Expose event
+    - merges ConfigureRequests into the last one
+    - keeps only the last PropertyNotify of every atom
+
+   Any other event of a window stops folding across it for that window,
+   input events stop folding of motion events for all windows.
+ */
+class EventCoalescer: private NotCopyable {
+public:
+    /// number of folded events, by kind
+    struct Stats {
+        Stats(): dispatched(0), motion(0), expose(0), configure(0), property(0) { }
+        unsigned long folded() const { return motion + expose + configure + property; }
+
+        unsigned long dispatched; ///< events handed back to the queue
+        unsigned long motion;
+        unsigned long expose;
+        unsigned long configure;
+        unsigned long property;
+    };
+
+    explicit EventCoalescer(Display *disp): m_display(disp), m_pending(0) { }
+
+    /**
+       folds the events queued so far. call this before XNextEvent();
+       it only does work once every event of the previous batch was
+       taken out of the queue.
+     */
+    void coalesce();
+    /// notify that one event was taken out of the queue
+    void eventTaken() { if (m_pending > 0) --m_pending; }
+
+    const Stats &stats() const { return m_stats; }
+
+private:
+    Display *m_display;
+    int m_pending; ///< events of the last batch which are still queued
+    std::vector<XEvent> m_batch;
+    std::vector<char> m_dropped;
+    Stats m_stats;
+};
+
+} // end namespace FbTk
+
+#endif // FBTK_EVENTCOALESCER_HH
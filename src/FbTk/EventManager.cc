@@ -23,6 +23,10 @@
 #include "EventHandler.hh"
 #include "FbWindow.hh"
 #include "App.hh"
+#include "EventStats.hh"
+#include "RequestStats.hh"
+#include "FbTime.hh"
+#include "RoundTrips.hh"
 
 #ifdef DEBUG
 #include <iostream>
@@ -54,7 +58,7 @@ void EventManager::add(EventHandler &ev, const FbWindow &win) {
 
 void EventManager::addParent(EventHandler &ev, const FbWindow &win) {
     if (win.window() != 0)
-        m_parent[win.window()] = &ev;
+        m_parent.insert(win.window(), &ev);
 }
 
 void EventManager::remove(const FbWindow &win) {
@@ -62,10 +66,11 @@ void EventManager::remove(const FbWindow &win) {
 }
 
 EventHandler *EventManager::find(Window win) {
-    return m_eventhandlers[win];
+    return m_eventhandlers.get(win);
 }
 
 bool EventManager::grabKeyboard(Window win) {
+    FBTK_ROUNDTRIP("EventManager::grabKeyboard");
     int ret = XGrabKeyboard(App::instance()->display(), win, False,
                             GrabModeAsync, GrabModeAsync, CurrentTime);
     return (ret == Success);
@@ -129,7 +134,7 @@ Window EventManager::getEventWindow(XEvent &ev) {
 
 void EventManager::registerEventHandler(EventHandler &ev, Window win) {
     if (win != None)
-        m_eventhandlers[win] = &ev;
+        m_eventhandlers.insert(win, &ev);
 }
 
 void EventManager::unregisterEventHandler(Window win) {
@@ -141,24 +146,26 @@ void EventManager::unregisterEventHandler(Window win) {
 
 void EventManager::dispatch(Window win, XEvent &ev, bool parent) {
     EventHandler *evhand = 0;
-    if (parent) {
-        EventHandlerMap::iterator it = m_parent.find(win);
-        if (it == m_parent.end())
-            return;
-        else
-            evhand = it->second;
-    } else {
+    if (parent)
+        evhand = m_parent.get(win);
+    else {
         win = getEventWindow(ev);
-        EventHandlerMap::iterator it = m_eventhandlers.find(win);
-        if (it == m_eventhandlers.end())
-            return;
-        else
-            evhand = it->second;
+        evhand = m_eventhandlers.get(win);
     }
 
     if (evhand == 0)
         return;
 
+    // the handler might delete itself, so remember what it is
+    EventStats &stats = EventStats::instance();
+    const std::type_info *handler_type = 0;
+    uint64_t start = 0;
+    if (stats.enabled()) {
+        handler_type = &typeid(*evhand);
+        start = FbTime::mono();
+    }
+    RequestStats::Widget widget(typeid(*evhand));
+
     switch (ev.type) {
     case KeyPress:
         evhand->keyPressEvent(ev.xkey);
@@ -193,10 +200,14 @@ void EventManager::dispatch(Window win, XEvent &ev, bool parent) {
     break;
     };
 
+    if (handler_type != 0)
+        stats.addHandler(*handler_type, FbTime::mono() - start);
+
     // find out which window is the parent and
     // dispatch event
     Window root, parent_win, *children = 0;
     unsigned int num_children;
+    FBTK_ROUNDTRIP("EventManager::dispatch");
     if (XQueryTree(FbTk::App::instance()->display(), win,
                    &root, &parent_win, &children, &num_children) != 0) {
         if (children != 0)
@@ -204,7 +215,7 @@ void EventManager::dispatch(Window win, XEvent &ev, bool parent) {
 
         if (parent_win != 0 &&
             parent_win != root) {
-            if (m_parent[parent_win] == 0)
+            if (m_parent.get(parent_win) == 0)
                 return;
 
             // dispatch event to parent
@@ -0,0 +1,225 @@
+// EventStats.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#include "EventStats.hh"
+#include "AllocStats.hh"
+#include "StringUtil.hh"
+
+#include <X11/X.h>
+
+#ifdef __GNUC__
+#include <cxxabi.h>
+#endif // __GNUC__
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace {
+
+void printHeader(std::ostream &os, const char *what) {
+    os<<std::left<<std::setw(32)<<what<<std::right
+      <<std::setw(10)<<"count"
+      <<std::setw(12)<<"total ms"
+      <<std::setw(10)<<"p50 us"
+      <<std::setw(10)<<"p99 us"
+      <<std::setw(10)<<"max us"<<std::endl;
+}
+
+void printLine(std::ostream &os, const std::string &name, const FbTk::LatencyHistogram &hist) {
+    os<<std::left<<std::setw(32)<<name<<std::right
+      <<std::setw(10)<<hist.count()
+      <<std::setw(12)<<std::fixed<<std::setprecision(3)<<hist.total() / 1000.0
+      <<std::setw(10)<<hist.percentile(0.50)
+      <<std::setw(10)<<hist.percentile(0.99)
+      <<std::setw(10)<<hist.max()<<std::endl;
+}
+
+} // anonymous namespace
+
+namespace FbTk {
+
+unsigned int LatencyHistogram::bucket(uint64_t usec) {
+    if (usec < 8)
+        return usec;
+    unsigned int msb = 3;
+    while (msb < 63 && (usec >> (msb + 1)) != 0)
+        ++msb;
+    return 8 + (msb - 3) * 4 + ((usec >> (msb - 2)) & 3);
+}
+
+uint64_t LatencyHistogram::bucketStart(unsigned int bucket) {
+    if (bucket < 8)
+        return bucket;
+    unsigned int msb = (bucket - 8) / 4 + 3;
+    uint64_t sub = (bucket - 8) % 4;
+    return (4 + sub) << (msb - 2);
+}
+
+void LatencyHistogram::add(uint64_t usec) {
+    ++m_count;
+    m_total += usec;
+    if (usec > m_max)
+        m_max = usec;
+    ++m_buckets[bucket(usec)];
+}
+
+void LatencyHistogram::reset() {
+    m_count = 0;
+    m_total = 0;
+    m_max = 0;
+    m_buckets.assign(NUM_BUCKETS, 0);
+}
+
+uint64_t LatencyHistogram::percentile(double fraction) const {
+    if (m_count == 0)
+        return 0;
+
+    uint64_t wanted = static_cast<uint64_t>(fraction * m_count + 0.5);
+    if (wanted == 0)
+        wanted = 1;
+
+    uint64_t seen = 0;
+    for (unsigned int i = 0; i < NUM_BUCKETS; ++i) {
+        seen += m_buckets[i];
+        if (seen < wanted)
+            continue;
+        if (i < 8)
+            return i;
+        // middle of the bucket, but never more than we've actually seen
+        uint64_t start = bucketStart(i);
+        uint64_t middle = start + (bucketStart(i + 1) - start) / 2;
+        return middle < m_max ? middle : m_max;
+    }
+    return m_max;
+}
+
+EventStats &EventStats::instance() {
+    static EventStats stats;
+    return stats;
+}
+
+void EventStats::addEvent(int type, uint64_t usec, unsigned long allocations) {
+    m_events[type].add(usec);
+    m_allocations[type] += allocations;
+}
+
+void EventStats::addHandler(const std::type_info &handler, uint64_t usec) {
+    m_handlers[&handler].add(usec);
+}
+
+void EventStats::reset() {
+    m_events.clear();
+    m_allocations.clear();
+    m_handlers.clear();
+}
+
+void EventStats::dump(std::ostream &os) const {
+
+    printHeader(os, "event");
+    EventHistograms::const_iterator eit = m_events.begin();
+    for (; eit != m_events.end(); ++eit) {
+        const char *name = eventName(eit->first);
+        if (name != 0)
+            printLine(os, name, eit->second);
+        else
+            printLine(os, "extension event " + StringUtil::number2String(eit->first),
+                      eit->second);
+    }
+
+    if (AllocStats::counting()) {
+        os<<std::endl<<std::left<<std::setw(32)<<"event"<<std::right
+          <<std::setw(14)<<"allocations"
+          <<std::setw(14)<<"per event"<<std::endl;
+        for (eit = m_events.begin(); eit != m_events.end(); ++eit) {
+            const char *name = eventName(eit->first);
+            unsigned long allocations = m_allocations.find(eit->first)->second;
+            os<<std::left<<std::setw(32)
+              <<(name ? std::string(name)
+                  : "extension event " + StringUtil::number2String(eit->first))
+              <<std::right<<std::setw(14)<<allocations
+              <<std::setw(14)<<std::fixed<<std::setprecision(2)
+              <<double(allocations) / eit->second.count()<<std::endl;
+        }
+    }
+
+    os<<std::endl;
+
+    printHeader(os, "handler");
+    HandlerHistograms::const_iterator hit = m_handlers.begin();
+    for (; hit != m_handlers.end(); ++hit)
+        printLine(os, className(*hit->first), hit->second);
+}
+
+void EventStats::writeJson(std::ostream &os) const {
+    os<<'{';
+    EventHistograms::const_iterator it = m_events.begin();
+    for (; it != m_events.end(); ++it) {
+        if (it != m_events.begin())
+            os<<',';
+        const char *name = eventName(it->first);
+        if (name != 0)
+            os<<'"'<<name<<'"';
+        else
+            os<<"\"extension event "<<it->first<<'"';
+        const LatencyHistogram &hist = it->second;
+        os<<":{\"count\":"<<hist.count()
+          <<",\"mean_us\":"<<(hist.count() ? hist.total() / hist.count() : 0)
+          <<",\"p99_us\":"<<hist.percentile(0.99)
+          <<",\"max_us\":"<<hist.max()<<'}';
+    }
+    os<<'}';
+}
+
+std::string EventStats::className(const std::type_info &type) {
+#ifdef __GNUC__
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(type.name(), 0, 0, &status);
+    if (demangled != 0) {
+        std::string name(demangled);
+        free(demangled);
+        return name;
+    }
+#endif // __GNUC__
+    return type.name();
+}
+
+const char *EventStats::eventName(int type) {
+    static const char *names[] = {
+        "<0>", "<1>", "KeyPress", "KeyRelease", "ButtonPress",
+        "ButtonRelease", "MotionNotify", "EnterNotify", "LeaveNotify",
+        "FocusIn", "FocusOut", "KeymapNotify", "Expose", "GraphicsExpose",
+        "NoExpose", "VisibilityNotify", "CreateNotify", "DestroyNotify",
+        "UnmapNotify", "MapNotify", "MapRequest", "ReparentNotify",
+        "ConfigureNotify", "ConfigureRequest", "GravityNotify",
+        "ResizeRequest", "CirculateNotify", "CirculateRequest",
+        "PropertyNotify", "SelectionClear", "SelectionRequest",
+        "SelectionNotify", "ColormapNotify", "ClientMessage",
+        "MappingNotify", "GenericEvent"
+    };
+
+    if (type >= 0 && type < static_cast<int>(sizeof(names) / sizeof(names[0])))
+        return names[type];
+    return 0;
+}
+
+} // end namespace FbTk
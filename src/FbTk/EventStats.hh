@@ -0,0 +1,122 @@
+// EventStats.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#ifndef FBTK_EVENTSTATS_HH
+#define FBTK_EVENTSTATS_HH
+
+#include "NotCopyable.hh"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#ifdef HAVE_INTTYPES_H
+#include <inttypes.h>
+#else
+#include <stdint.h>
+#endif // HAVE_INTTYPES_H
+
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+namespace FbTk {
+
+/// log-linear histogram of durations in micro-seconds
+class LatencyHistogram {
+public:
+    LatencyHistogram(): m_count(0), m_total(0), m_max(0), m_buckets(NUM_BUCKETS, 0) { }
+
+    void add(uint64_t usec);
+    void reset();
+
+    unsigned long count() const { return m_count; }
+    uint64_t total() const { return m_total; }
+    uint64_t max() const { return m_max; }
+    /// @return approximation (within 25%) of the duration below which
+    ///         'fraction' (0.0 - 1.0) of all samples are
+    uint64_t percentile(double fraction) const;
+
+private:
+    /// 8 exact buckets, then 4 buckets per power of two
+    enum { NUM_BUCKETS = 8 + 61 * 4 };
+
+    static unsigned int bucket(uint64_t usec);
+    static uint64_t bucketStart(unsigned int bucket);
+
+    unsigned long m_count;
+    uint64_t m_total;
+    uint64_t m_max;
+    std::vector<uint32_t> m_buckets;
+};
+
+/**
+   How long handling events takes, per event type and per class of the
+   EventHandler. Collecting is off by default, so the cost is a single
+   check per event.
+ */
+class EventStats: private NotCopyable {
+public:
+    static EventStats &instance();
+
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    bool enabled() const { return m_enabled; }
+
+    /// @param allocations made while handling it, see AllocStats
+    void addEvent(int type, uint64_t usec, unsigned long allocations = 0);
+    void addHandler(const std::type_info &handler, uint64_t usec);
+    void reset();
+
+    /// prints a table of all statistics
+    void dump(std::ostream &os) const;
+    /// writes the count, mean and p99 in micro-seconds per event type as
+    /// a JSON object on a single line
+    void writeJson(std::ostream &os) const;
+
+    /// @return readable name of the core X event type, 0 for others
+    static const char *eventName(int type);
+    /// @return readable name of the class, demangled if we can
+    static std::string className(const std::type_info &type);
+
+private:
+    EventStats(): m_enabled(false) { }
+
+    struct TypeInfoLess {
+        bool operator()(const std::type_info *a, const std::type_info *b) const {
+            return a->before(*b);
+        }
+    };
+
+    typedef std::map<int, LatencyHistogram> EventHistograms;
+    typedef std::map<int, unsigned long> EventAllocations;
+    typedef std::map<const std::type_info *, LatencyHistogram, TypeInfoLess> HandlerHistograms;
+
+    bool m_enabled;
+    EventHistograms m_events;
+    EventAllocations m_allocations;
+    HandlerHistograms m_handlers;
+};
+
+} // end namespace FbTk
+
+#endif // FBTK_EVENTSTATS_HH
@@ -22,6 +22,15 @@
 #include "FbDrawable.hh"
 
 #include "App.hh"
+#include "RequestStats.hh"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#ifdef USE_XFT
+#include "XftFontImp.hh"
+#endif // USE_XFT
 
 namespace FbTk {
 
@@ -34,12 +43,19 @@ FbDrawable::FbDrawable() {
     }
 }
 
+void FbDrawable::dropCaches(Drawable drawable) {
+#ifdef USE_XFT
+    XftFontImp::forgetDrawable(drawable);
+#endif // USE_XFT
+}
+
 void FbDrawable::copyArea(Drawable src, GC gc,
                           int src_x, int src_y,
                           int dest_x, int dest_y,
                           unsigned int width, unsigned int height) {
     if (drawable() == 0 || src == 0 || gc == 0)
         return;
+    RequestStats::count(RequestStats::COPY_AREA);
     XCopyArea(display(),
               src, drawable(), gc,
               src_x, src_y,
@@ -51,6 +67,7 @@ void FbDrawable::fillRectangle(GC gc, int x, int y,
                                unsigned int width, unsigned int height) {
     if (drawable() == 0 || gc == 0)
         return;
+    RequestStats::count(RequestStats::FILL_RECTANGLE);
     XFillRectangle(display(),
                    drawable(), gc,
                    x, y,
@@ -61,6 +78,7 @@ void FbDrawable::drawRectangle(GC gc, int x, int y,
                                unsigned int width, unsigned int height) {
     if (drawable() == 0 || gc == 0)
         return;
+    RequestStats::count(RequestStats::DRAW_OTHER);
     XDrawRectangle(display(),
                    drawable(), gc,
                    x, y,
@@ -71,6 +89,7 @@ void FbDrawable::drawLine(GC gc, int start_x, int start_y,
                           int end_x, int end_y) {
     if (drawable() == 0 || gc == 0)
         return;
+    RequestStats::count(RequestStats::DRAW_OTHER);
     XDrawLine(display(),
               drawable(),
               gc,
@@ -82,6 +101,7 @@ void FbDrawable::fillPolygon(GC gc, XPoint *points, int npoints,
                              int shape, int mode) {
     if (drawable() == 0 || gc == 0 || points == 0 || npoints == 0)
         return;
+    RequestStats::count(RequestStats::DRAW_OTHER);
     XFillPolygon(display(),
                  drawable(), gc, points, npoints,
                  shape, mode);
@@ -70,6 +70,9 @@ public:
     virtual unsigned int depth() const = 0;
     static Display *display() { return s_display; }
 protected:
+    /// drops what was cached for a drawable, call it before freeing one
+    static void dropCaches(Drawable drawable);
+
     static Display *s_display; // display connection
 };
 
@@ -25,11 +25,21 @@
 #include "Transparent.hh"
 #include "FbWindow.hh"
 #include "TextUtils.hh"
+#include "RoundTrips.hh"
+#include "AtomCache.hh"
+#include "MemoryAccount.hh"
+#include "RequestStats.hh"
+#include "WorkerPool.hh"
 
 #include <X11/Xutil.h>
 #include <X11/Xatom.h>
 #include <iostream>
 #include <vector>
+#ifdef HAVE_CSTDLIB
+  #include <cstdlib>
+#else
+  #include <stdlib.h>
+#endif
 #ifdef HAVE_CSTRING
   #include <cstring>
 #else
@@ -54,14 +64,129 @@ struct RootProps root_props[] = {
     { "_XSETROOT_ID", None }
 };
 
+AtomCache::Names queued_root_props(root_props,
+        sizeof(root_props)/sizeof(RootProps));
+
 void checkAtoms() {
 
-    Display* display = FbTk::App::instance()->display();
     for (size_t i = 0; i < sizeof(root_props)/sizeof(RootProps); ++i) {
         if (root_props[i].atom == None) {
-            root_props[i].atom = XInternAtom(display, root_props[i].name, False);
+            root_props[i].atom = AtomCache::instance().get(root_props[i].name);
+        }
+    }
+}
+
+/// the pixmap of the first root property set, in the order of root_props
+Pixmap readRootPixmap(int screen_num) {
+    Display *disp = App::instance()->display();
+    Atom real_type;
+    int real_format;
+    unsigned long items_read, items_left;
+    unsigned long *data;
+
+    static bool print_error = true; // print error_message only once
+
+    Pixmap root_pm = None;
+
+    unsigned int prop = 0;
+    for (prop = 0; prop < sizeof(root_props)/sizeof(RootProps); ++prop) {
+        FBTK_ROUNDTRIP("FbPixmap::getRootPixmap");
+        if (XGetWindowProperty(disp,
+                               RootWindow(disp, screen_num),
+                               root_props[prop].atom,
+                               0l, 1l,
+                               False, XA_PIXMAP,
+                               &real_type, &real_format,
+                               &items_read, &items_left,
+                               (unsigned char **) &data) == Success) {
+            if (real_format == 32 && items_read == 1) {
+                if (print_error && strcmp(root_props[prop].name, "_XSETROOT_ID") == 0) {
+                    static const char* error_message = {
+                        "\n\n !!! WARNING WARNING WARNING WARNING !!!!!\n"
+                        "   if you experience problems with transparency:\n"
+                        "   you are using a wallpapersetter that \n"
+                        "   uses _XSETROOT_ID .. which we do not support.\n"
+                        "   consult 'fbsetbg -i' or try any other wallpapersetter\n"
+                        "   that uses _XROOTPMAP_ID !\n"
+                        " !!! WARNING WARNING WARNING WARNING !!!!!!\n\n"
+                    };
+                    cerr<<error_message;
+                    print_error = false;
+                } else
+                    root_pm = (Pixmap) (*data);
+            }
+            XFree(data);
+            if (root_pm != None)
+                break;
+        }
+    }
+    return root_pm;
+}
+
+/// images smaller than this aren't worth waking the helper threads
+const unsigned int PARALLEL_MIN_PIXELS = 128 * 1024;
+
+/**
+ * Fills an image with pixels of another, scaled or rotated. Rows are split
+ * between the worker threads; XGetPixel and XPutPixel only touch the
+ * memory of the images.
+ */
+class CopyPixels: public WorkerPool::Job {
+public:
+    CopyPixels(XImage &src, XImage &dest, Orientation orient):
+        m_src(src), m_dest(dest), m_orient(orient), m_scale(orient == ROT0) { }
+
+    void run(unsigned int part, unsigned int parts) {
+        const unsigned int w = m_dest.width, h = m_dest.height;
+        const unsigned int src_w = m_src.width, src_h = m_src.height;
+        for (unsigned int y = h * part / parts; y < h * (part + 1) / parts; ++y) {
+            for (unsigned int x = 0; x < w; ++x) {
+                unsigned int src_x = x, src_y = y;
+                if (m_scale) {
+                    src_x = x * src_w / w;
+                    src_y = y * src_h / h;
+                } else if (m_orient == ROT90) {
+                    src_x = y;
+                    src_y = w - 1 - x;
+                } else if (m_orient == ROT180) {
+                    src_x = w - 1 - x;
+                    src_y = h - 1 - y;
+                } else if (m_orient == ROT270) {
+                    src_x = h - 1 - y;
+                    src_y = x;
+                }
+                XPutPixel(&m_dest, x, y, XGetPixel(&m_src, src_x, src_y));
+            }
         }
     }
+
+private:
+    XImage &m_src, &m_dest;
+    Orientation m_orient;
+    bool m_scale; ///< ROT0 means scale to the size of m_dest
+};
+
+/**
+ * Copies the pixels of src into a new image of the same format
+ * @param orient ROT0 scales src to width x height
+ * @return the image, 0 if there is no memory for it
+ */
+XImage *copyPixels(Display *disp, XImage &src, unsigned int width,
+                   unsigned int height, Orientation orient) {
+    XImage *dest = XCreateImage(disp, 0, src.depth, ZPixmap, 0, 0,
+                                width, height, src.bitmap_pad, 0);
+    if (dest == 0)
+        return 0;
+    dest->data = static_cast<char *>(malloc(dest->bytes_per_line * height));
+    if (dest->data == 0) {
+        XDestroyImage(dest);
+        return 0;
+    }
+
+    CopyPixels job(src, *dest, orient);
+    WorkerPool::instance().run(job, width * height < PARALLEL_MIN_PIXELS ?
+                               1 : WorkerPool::instance().threads());
+    return dest;
 }
 
 } // end of anonymous namespace
@@ -124,6 +249,7 @@ FbPixmap &FbPixmap::operator = (Pixmap pm) {
     Window root;
     int x, y;
     unsigned int border_width, bpp;
+    FBTK_ROUNDTRIP("FbPixmap::operator=");
     if (!XGetGeometry(display(),
                       pm,
                       &root,
@@ -177,6 +303,7 @@ void FbPixmap::copy(Pixmap pm, unsigned int depth, int screen_num) {
     unsigned int border_width, bpp;
     unsigned int new_width, new_height;
 
+    FBTK_ROUNDTRIP("FbPixmap::copy");
     if (!XGetGeometry(display(),
                       pm,
                       &root,
@@ -234,52 +361,14 @@ void FbPixmap::rotate(FbTk::Orientation orient) {
                                   ~0, // plane mask
                                   ZPixmap); // format
     if (src_image) {
-
-        GContext gc(drawable());
-
-        if (orient == ROT180) {
-            unsigned int srcx, srcy, destx, desty;
-            for (srcy = 0, desty = oldh; srcy < oldh; ++srcy, --desty) {
-                for (srcx = 0, destx = oldw; srcx < oldw; ++srcx, --destx) {
-                    gc.setForeground(XGetPixel(src_image, srcx, srcy));
-                    XDrawPoint(display(), new_pm.drawable(), gc.gc(), destx, desty);
-                }
-            }
-        } else {
-            // need to flip x and y
-
-            // set start, end and direction based on rotation
-            // NOTE that startx etc are in the direction of the OLD pixmap
-            unsigned int startx = 0, starty = 0;
-            int dirx = 0, diry = 0;
-            switch (orient) {
-            case ROT90:
-                startx = neww-1;
-                starty = 0;
-                dirx = -1;
-                diry = 1;
-                break;
-            case ROT270:
-                startx = 0;
-                starty = newh-1;
-                dirx = 1;
-                diry = -1;
-                break;
-            default: // kill warning
-                break;
-            }
-
-
-            // copy new area
-            unsigned int srcx, srcy, destx, desty;
-            for (srcy = 0, destx = startx; srcy < oldh; ++srcy, destx+=dirx) {
-                for (srcx = 0, desty = starty; srcx < oldw; ++srcx, desty+=diry) {
-                    gc.setForeground(XGetPixel(src_image, srcx, srcy));
-                    XDrawPoint(display(), new_pm.drawable(), gc.gc(), destx, desty);
-                }
-            }
+        // rotated on our side and uploaded in one request
+        XImage *dest_image = copyPixels(display(), *src_image, neww, newh, orient);
+        if (dest_image) {
+            GContext gc(new_pm);
+            XPutImage(display(), new_pm.drawable(), gc.gc(), dest_image,
+                      0, 0, 0, 0, neww, newh);
+            XDestroyImage(dest_image);
         }
-
         XDestroyImage(src_image);
     }
 
@@ -309,23 +398,15 @@ void FbPixmap::scale(unsigned int dest_width, unsigned int dest_height) {
     // create new pixmap with dest size
     FbPixmap new_pm(drawable(), dest_width, dest_height, depth());
 
-    GContext gc(drawable());
-    // calc zoom
-    float zoom_x = static_cast<float>(width())/static_cast<float>(dest_width);
-    float zoom_y = static_cast<float>(height())/static_cast<float>(dest_height);
-
-    // start scaling
-    float src_x = 0, src_y = 0;
-    for (unsigned int tx=0; tx < dest_width; ++tx, src_x += zoom_x) {
-        src_y = 0;
-        for (unsigned int ty=0; ty < dest_height; ++ty, src_y += zoom_y) {
-            gc.setForeground(XGetPixel(src_image,
-                                       static_cast<int>(src_x),
-                                       static_cast<int>(src_y)));
-            XDrawPoint(display(), new_pm.drawable(), gc.gc(), tx, ty);
-        }
+    // scaled on our side and uploaded in one request
+    XImage *dest_image = copyPixels(display(), *src_image,
+                                    dest_width, dest_height, ROT0);
+    if (dest_image) {
+        GContext gc(new_pm);
+        XPutImage(display(), new_pm.drawable(), gc.gc(), dest_image,
+                  0, 0, 0, 0, dest_width, dest_height);
+        XDestroyImage(dest_image);
     }
-
     XDestroyImage(src_image);
 
     // free old pixmap and set new from new_pm
@@ -364,8 +445,23 @@ void FbPixmap::resize(unsigned int width, unsigned int height) {
     *this = pm.release();
 }
 
+void FbPixmap::share(const FbPixmap &owner) {
+    if (&owner == this)
+        return;
+
+    free();
+    m_pm = owner.m_pm;
+    m_width = owner.m_width;
+    m_height = owner.m_height;
+    m_depth = owner.m_depth;
+    m_dont_free = true;
+}
+
 Pixmap FbPixmap::release() {
     Pixmap ret = m_pm;
+    // the new owner frees it behind our back
+    if (ret != 0)
+        dropCaches(ret);
     m_pm = 0;
     m_width = 0;
     m_height = 0;
@@ -373,41 +469,25 @@ Pixmap FbPixmap::release() {
     return ret;
 }
 
-// returns whether or not the background was changed
-bool FbPixmap::rootwinPropertyNotify(int screen_num, Atom atom) {
+bool FbPixmap::isRootPixmapProperty(Atom atom) {
     if (!FbTk::Transparent::haveRender())
         return false;
 
     checkAtoms();
     for (size_t i = 0; i < sizeof(root_props)/sizeof(RootProps); ++i) {
-        if (root_props[i].atom == atom) {
-            Pixmap root_pm = None;
-            Atom real_type;
-            int real_format;
-            unsigned long items_read, items_left;
-            unsigned long *data;
-
-            if (XGetWindowProperty(display(),
-                                   RootWindow(display(), screen_num),
-                                   root_props[i].atom,
-                                   0l, 1l,
-                                   False, XA_PIXMAP,
-                                   &real_type, &real_format,
-                                   &items_read, &items_left,
-                                   (unsigned char **) &data) == Success) {
-                if (real_format == 32 && items_read == 1) {
-                    root_pm = (Pixmap) (*data);
-                }
-                XFree(data);
-                if (root_pm != None)
-                    return setRootPixmap(screen_num, root_pm);
-            }
-            return false;
-        }
+        if (root_props[i].atom == atom)
+            return true;
     }
     return false;
 }
 
+void FbPixmap::updateRootPixmap(int screen_num) {
+    checkAtoms();
+    // wallpaper setters may draw into the pixmap they set before
+    if (!setRootPixmap(screen_num, readRootPixmap(screen_num)))
+        FbWindow::updatedAlphaBackground(screen_num);
+}
+
 // returns whether or not the background was changed
 bool FbPixmap::setRootPixmap(int screen_num, Pixmap pm) {
 
@@ -439,56 +519,17 @@ Pixmap FbPixmap::getRootPixmap(int screen_num, bool force_update) {
 
     // else setup pixmap cache
     int numscreens = ScreenCount(display());
-    for (int i=0; i < numscreens; ++i) {
-        Atom real_type;
-        int real_format;
-        unsigned long items_read, items_left;
-        unsigned long *data;
-
-        static bool print_error = true; // print error_message only once
-
-        Pixmap root_pm = None;
-
-        unsigned int prop = 0;
-        for (prop = 0; prop < sizeof(root_props)/sizeof(RootProps); ++prop) {
-            if (XGetWindowProperty(display(),
-                                   RootWindow(display(), i),
-                                   root_props[prop].atom,
-                                   0l, 1l,
-                                   False, XA_PIXMAP,
-                                   &real_type, &real_format,
-                                   &items_read, &items_left,
-                                   (unsigned char **) &data) == Success) {
-                if (real_format == 32 && items_read == 1) {
-                    if (print_error && strcmp(root_props[prop].name, "_XSETROOT_ID") == 0) {
-                        static const char* error_message = {
-                            "\n\n !!! WARNING WARNING WARNING WARNING !!!!!\n"
-                            "   if you experience problems with transparency:\n"
-                            "   you are using a wallpapersetter that \n"
-                            "   uses _XSETROOT_ID .. which we do not support.\n"
-                            "   consult 'fbsetbg -i' or try any other wallpapersetter\n"
-                            "   that uses _XROOTPMAP_ID !\n"
-                            " !!! WARNING WARNING WARNING WARNING !!!!!!\n\n"
-                        };
-                        cerr<<error_message;
-                        print_error = false;
-                    } else
-                        root_pm = (Pixmap) (*data);
-                }
-                XFree(data);
-                if (root_pm != None)
-                    break;
-            }
-        }
-        setRootPixmap(i, root_pm);
-    }
+    for (int i=0; i < numscreens; ++i)
+        setRootPixmap(i, readRootPixmap(i));
 
     return s_root_pixmaps[screen_num];
 }
 
 void FbPixmap::free() {
-    if (!m_dont_free && m_pm != 0)
-        XFreePixmap(display(), m_pm);
+    if (!m_dont_free && m_pm != 0) {
+        dropCaches(m_pm);
+        MemoryAccount::freePixmap(display(), m_pm);
+    }
 
     /* note: m_dont_free shouldnt be required anywhere else,
        because then free() isn't being called appropriately! */
@@ -505,7 +546,8 @@ void FbPixmap::create(Drawable src,
     if (src == 0)
         return;
 
-    m_pm = XCreatePixmap(display(),
+    RequestStats::count(RequestStats::CREATE_PIXMAP);
+    m_pm = MemoryAccount::createPixmap(display(),
                          src, width, height, depth);
     if (m_pm == 0)
         return;
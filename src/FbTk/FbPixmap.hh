@@ -55,6 +55,9 @@ public:
     void tile(unsigned int width, unsigned int height);
     /// drops pixmap and returns it
     Pixmap release();
+    /// uses the pixmap of 'owner' without copying it; 'owner' has to keep
+    /// it until this one is freed or reassigned
+    void share(const FbPixmap &owner);
 
     FbPixmap &operator = (const FbPixmap &copy);
     /// sets new pixmap
@@ -67,7 +70,12 @@ public:
 
     static Pixmap getRootPixmap(int screen_num, bool force_update=false);
     static bool setRootPixmap(int screen_num, Pixmap pm);
-    static bool rootwinPropertyNotify(int screen_num, Atom atom);
+    /// @return true if the root window property 'atom' names the root
+    ///         pixmap, which we only follow for transparency with RENDER
+    static bool isRootPixmapProperty(Atom atom);
+    /// re-reads the root pixmap and redraws the transparent windows of the
+    /// screen, even if the pixmap id stayed the same
+    static void updateRootPixmap(int screen_num);
 
     void create(Drawable src,
                 unsigned int width, unsigned int height,
@@ -48,8 +48,11 @@
 #include <locale.h>
 
 #include <iostream>
+#include <map>
 #include <vector>
 
+#include "StringUtil.hh"
+
 #ifndef HAVE_ICONV
 typedef int iconv_t;
 #endif // HAVE_ICONV
@@ -102,6 +105,16 @@ FbTk::FbString makeVisualFromLogical(const FbTk::FbString& src) {
     return result;
 }
 
+// true if no character of the utf-8 string src is at or above U+0590, the
+// first right-to-left block. such strings never get reordered, so fribidi
+// can be skipped
+bool isPlainLTR(const FbTk::FbString& src) {
+    for (size_t i = 0; i < src.size(); ++i)
+        if (static_cast<unsigned char>(src[i]) >= 0xD6)
+            return false;
+    return true;
+}
+
 #endif
 
 } // end of anonymous namespace
@@ -109,37 +122,54 @@ FbTk::FbString makeVisualFromLogical(const FbTk::FbString& src) {
 
 namespace FbTk {
 
-BiDiString::BiDiString(const FbString& logical) 
-#ifdef HAVE_FRIBIDI
-    : m_visual_dirty(false)
-#endif
-{
+BiDiString::BiDiString(const FbString& logical) {
     if (!logical.empty())
         setLogical(logical);
 }
 
+const FbString &BiDiString::emptyString() {
+    static const FbString s_empty;
+    return s_empty;
+}
+
 const FbString& BiDiString::setLogical(const FbString& logical) {
-    m_logical = logical;
-#if HAVE_FRIBIDI
-    if (m_logical.empty()) {
-        m_visual_dirty = false;
-        m_visual.clear();
-    } else {
-        m_visual_dirty = true;
+    // titles get set again with the same value all the time
+    if (logical == this->logical())
+        return this->logical();
+
+    if (logical.empty()) {
+        m_data.reset();
+        return emptyString();
     }
+
+    // the copies we share the old text with keep it
+    if (!m_data || m_data.useCount() > 1)
+        m_data.reset(new Data);
+    Data &data = *m_data;
+    data.logical = logical;
+#ifdef HAVE_FRIBIDI
+    data.visual_differs = false;
+    FbString().swap(data.visual);
+    data.visual_dirty = !::isPlainLTR(data.logical);
 #endif
-    return m_logical;
+    return data.logical;
 }
 
 const FbString& BiDiString::visual() const {
-#if HAVE_FRIBIDI
-    if (m_visual_dirty) {
-        m_visual = ::makeVisualFromLogical(logical());
+#ifdef HAVE_FRIBIDI
+    if (!m_data)
+        return emptyString();
+    Data &data = *m_data;
+    if (data.visual_dirty) {
+        data.visual = ::makeVisualFromLogical(data.logical);
+        data.visual_differs = data.visual != data.logical;
+        if (!data.visual_differs)
+            FbString().swap(data.visual);
+        data.visual_dirty = false;
     }
-    m_visual_dirty = false;
-    return m_visual;
+    return data.visual_differs ? data.visual : data.logical;
 #else
-    return m_logical;
+    return logical();
 #endif
 }
 
@@ -157,8 +187,41 @@ enum ConvType {
 
 static bool s_inited = false;
 static iconv_t s_iconv_convs[CONVSIZE];
+static bool s_ascii_convs[CONVSIZE];
 static std::string s_locale_codeset;
 
+/// iconv descriptors by (to, from), shared by every StringConvertor
+typedef std::map<std::pair<std::string, std::string>, iconv_t> ConvPool;
+static ConvPool s_conv_pool;
+
+/// @return true if 7-bit text means the same in the codeset as in ascii
+bool asciiCompatible(const std::string &codeset) {
+    static const char *incompatible[] = {
+        "UTF-16", "UTF16", "UTF-32", "UTF32", "UCS", "UTF-7", "UTF7",
+        "ISO-2022", "ISO2022", "UNICODE"
+    };
+    std::string upper = FbTk::StringUtil::toUpper(codeset);
+    for (size_t i = 0; i < sizeof(incompatible) / sizeof(incompatible[0]); ++i)
+        if (upper.compare(0, strlen(incompatible[i]), incompatible[i]) == 0)
+            return false;
+    return true;
+}
+
+/// @return a pooled descriptor from one codeset to another, ICONV_NULL if
+///         there is no such conversion
+iconv_t openConv(const std::string &to, const std::string &from) {
+#ifdef HAVE_ICONV
+    ConvPool::key_type key(to, from);
+    ConvPool::iterator it = s_conv_pool.find(key);
+    if (it == s_conv_pool.end())
+        it = s_conv_pool.insert(ConvPool::value_type(key,
+                    iconv_open(to.c_str(), from.c_str()))).first;
+    return it->second;
+#else
+    return ICONV_NULL;
+#endif // HAVE_ICONV
+}
+
 /// Initialise all of the iconv conversion descriptors
 void init() {
 
@@ -182,10 +245,14 @@ void init() {
     cerr << "FbTk::FbString: setup converts for local codeset = " << s_locale_codeset << endl;
 #endif // DEBUG
 
-    s_iconv_convs[FB2X] = iconv_open("ISO8859-1", "UTF-8");
-    s_iconv_convs[X2FB] = iconv_open("UTF-8", "ISO8859-1");
-    s_iconv_convs[FB2LOCALE] = iconv_open(s_locale_codeset.c_str(), "UTF-8");
-    s_iconv_convs[LOCALE2FB] = iconv_open("UTF-8", s_locale_codeset.c_str());
+    s_iconv_convs[FB2X] = openConv("ISO8859-1", "UTF-8");
+    s_iconv_convs[X2FB] = openConv("UTF-8", "ISO8859-1");
+    s_iconv_convs[FB2LOCALE] = openConv(s_locale_codeset, "UTF-8");
+    s_iconv_convs[LOCALE2FB] = openConv("UTF-8", s_locale_codeset);
+
+    bool locale_ascii = asciiCompatible(s_locale_codeset);
+    s_ascii_convs[FB2X] = s_ascii_convs[X2FB] = true;
+    s_ascii_convs[FB2LOCALE] = s_ascii_convs[LOCALE2FB] = locale_ascii;
 #else
     memset(s_iconv_convs, 0, sizeof(s_iconv_convs));
 #endif // HAVE_ICONV
@@ -194,10 +261,11 @@ void init() {
 
 void shutdown() {
 #ifdef HAVE_ICONV
-    int i;
-    for (i = 0; i < CONVSIZE; ++i)
-        if (s_iconv_convs[i] != ICONV_NULL)
-            iconv_close(s_iconv_convs[i]);
+    ConvPool::iterator it = s_conv_pool.begin();
+    for (; it != s_conv_pool.end(); ++it)
+        if (it->second != ICONV_NULL)
+            iconv_close(it->second);
+    s_conv_pool.clear();
 
     memset(s_iconv_convs, 0, sizeof(s_iconv_convs));
     s_inited = false;
@@ -205,17 +273,34 @@ void shutdown() {
 }
 
 
-
+/// @return true if none of the bytes has the high bit set
+bool isAscii(const char *src, size_t len) {
+    // a word at a time, memcpy keeps it legal for unaligned input
+    const unsigned long high_bits = ~0UL / 0xFF * 0x80;
+    size_t i = 0;
+    for (; i + sizeof(unsigned long) <= len; i += sizeof(unsigned long)) {
+        unsigned long word;
+        memcpy(&word, src + i, sizeof(word));
+        if (word & high_bits)
+            return false;
+    }
+    for (; i < len; ++i)
+        if (src[i] & 0x80)
+            return false;
+    return true;
+}
 
 /**
    Recodes the text from one encoding to another
    assuming cd is correct
    @param cd the iconv type
-   @param msg text to be converted, **NOT** necessarily NULL terminated
-   @param size number of BYTES to convert
-   @return the recoded string, or 0 on failure
+   @param ascii true if 7-bit text is the same in both encodings
+   @param in text to be converted, **NOT** necessarily NULL terminated
+   @param len number of BYTES to convert
+   @param out receives the recoded text, must not overlap in; its
+              memory is reused
 */
-std::string recode(iconv_t cd, const std::string &in) {
+void recode(iconv_t cd, bool ascii, const char *in, size_t len, std::string &out) {
 
 #ifdef HAVE_ICONV
 /**
@@ -227,24 +312,28 @@ std::string recode(iconv_t cd, const std::string &in) {
 */
 
     // If empty message, yes this can happen, return
-    if (in.empty())
-        return "";
+    if (len == 0) {
+        out.clear();
+        return;
+    }
 
-    if (cd == ICONV_NULL)
-        return in; // can't convert
+    // can't convert, or nothing to convert
+    if (cd == ICONV_NULL || (ascii && isAscii(in, len))) {
+        out.assign(in, len);
+        return;
+    }
 
-    size_t insize = in.size();
-    size_t outsize = insize;
-    std::vector<char> out(outsize);
+    size_t outsize = len;
+    out.resize(outsize);
     char* out_ptr = &out[0];
 
-    size_t inbytesleft = insize;
+    size_t inbytesleft = len;
     size_t outbytesleft = outsize;
 
 #ifdef HAVE_CONST_ICONV
-    const char* in_ptr = in.data();
+    const char* in_ptr = in;
 #else
-    char* in_ptr = const_cast<char*>(in.data());
+    char* in_ptr = const_cast<char*>(in);
 #endif
     size_t result = (size_t)(-1);
     bool again = true;
@@ -263,15 +352,16 @@ std::string recode(iconv_t cd, const std::string &in) {
                 again = true;
             case EINVAL:
                 break;
-            case E2BIG:
+            case E2BIG: {
                 // need more space!
-                outsize += insize;
+                size_t used = outsize - outbytesleft;
+                outsize += len;
                 out.resize(outsize);
-                if (out.capacity() != outsize)
-                    again = true;
-                outbytesleft += insize;
-                out_ptr = (&out[0] + outsize) - outbytesleft;
+                out_ptr = &out[0] + used;
+                outbytesleft = outsize - used;
+                again = true;
                 break;
+            }
             default:
                 // something else broke
                 perror("iconv");
@@ -280,35 +370,55 @@ std::string recode(iconv_t cd, const std::string &in) {
         }
     }
 
-    // copy to our return string
-    std::string ret;
-    ret.append(&out[0], outsize - outbytesleft);
+    out.resize(outsize - outbytesleft);
 
     // reset the conversion descriptor
     iconv(cd, NULL, NULL, NULL, NULL);
-
-    return ret;
 #else
-    return in;
+    out.assign(in, len);
 #endif // HAVE_ICONV
 }
 
+void XStrToFb(const char *src, size_t len, FbString &dest) {
+    recode(s_iconv_convs[X2FB], s_ascii_convs[X2FB], src, len, dest);
+}
+
+void FbStrToX(const char *src, size_t len, std::string &dest) {
+    recode(s_iconv_convs[FB2X], s_ascii_convs[FB2X], src, len, dest);
+}
+
+void LocaleStrToFb(const char *src, size_t len, FbString &dest) {
+    recode(s_iconv_convs[LOCALE2FB], s_ascii_convs[LOCALE2FB], src, len, dest);
+}
+
+void FbStrToLocale(const char *src, size_t len, std::string &dest) {
+    recode(s_iconv_convs[FB2LOCALE], s_ascii_convs[FB2LOCALE], src, len, dest);
+}
+
 FbString XStrToFb(const std::string &src) {
-    return recode(s_iconv_convs[X2FB], src);
+    FbString ret;
+    XStrToFb(src.data(), src.size(), ret);
+    return ret;
 }
 
 std::string FbStrToX(const FbString &src) {
-    return recode(s_iconv_convs[FB2X], src);
+    std::string ret;
+    FbStrToX(src.data(), src.size(), ret);
+    return ret;
 }
 
 
 /// Handle thislocale string encodings (strings coming from userspace)
 FbString LocaleStrToFb(const std::string &src) {
-    return recode(s_iconv_convs[LOCALE2FB], src);
+    FbString ret;
+    LocaleStrToFb(src.data(), src.size(), ret);
+    return ret;
 }
 
 std::string FbStrToLocale(const FbString &src) {
-    return recode(s_iconv_convs[FB2LOCALE], src);
+    std::string ret;
+    FbStrToLocale(src.data(), src.size(), ret);
+    return ret;
 }
 
 bool haveUTF8() {
@@ -324,7 +434,9 @@ bool haveUTF8() {
 } // end namespace StringUtil
 
 #ifdef HAVE_ICONV
-StringConvertor::StringConvertor(EncodingTarget target) : m_iconv(ICONV_NULL) {
+StringConvertor::StringConvertor(EncodingTarget target) :
+    m_iconv(ICONV_NULL),
+    m_ascii(true) {
     if (target == ToLocaleStr)
         m_destencoding = FbStringUtil::s_locale_codeset;
     else
@@ -346,13 +458,13 @@ bool StringConvertor::setSource(const std::string &encoding) {
         return true;
     }
 
-    iconv_t newiconv = iconv_open(m_destencoding.c_str(), tempenc.c_str());
+    iconv_t newiconv = FbStringUtil::openConv(m_destencoding, tempenc);
     if (newiconv == ICONV_NULL)
         return false;
     else {
-        if (m_iconv != ICONV_NULL)
-            iconv_close(m_iconv);
         m_iconv = newiconv;
+        m_ascii = FbStringUtil::asciiCompatible(m_destencoding) &&
+            FbStringUtil::asciiCompatible(tempenc);
         return true;
     }
 #else
@@ -361,18 +473,24 @@ bool StringConvertor::setSource(const std::string &encoding) {
 }
 
 FbString StringConvertor::recode(const std::string &src) {
+    FbString ret;
+    recode(src.data(), src.size(), ret);
+    return ret;
+}
+
+void StringConvertor::recode(const char *src, size_t len, FbString &dest) {
 #ifdef HAVE_ICONV
-    return FbStringUtil::recode(m_iconv, src);
+    FbStringUtil::recode(m_iconv, m_ascii, src, len, dest);
 #else
-    return src;
+    dest.assign(src, len);
 #endif
 }
 
 void StringConvertor::reset() {
 #ifdef HAVE_ICONV
-    if (m_iconv != ICONV_NULL)
-        iconv_close(m_iconv);
+    // the descriptor belongs to the pool
     m_iconv = ICONV_NULL;
+    m_ascii = true;
 #endif
 }
 
@@ -31,6 +31,7 @@
 #endif // HAVE_ICONV
 
 #include "NotCopyable.hh"
+#include "RefCount.hh"
 
 namespace FbTk {
 
@@ -38,23 +39,48 @@ namespace FbTk {
 // (or just plain whatever for now if no utf-8 available)
 typedef std::string FbString;
 
+/**
+   A text in logical order and, if they differ, in visual order. Copies
+   share the text, so a title copied to the frame label, the iconbar and
+   the client menu is kept once, and its visual order is made once.
+   Setting a text that others share leaves them their copy.
+ */
 class BiDiString {
 
 public:
 
     BiDiString(const FbString& logical = FbString());
 
-    const FbString& logical() const { return m_logical; }
+    const FbString& logical() const { return m_data ? m_data->logical : emptyString(); }
     const FbString& visual() const;
 
     const FbString& setLogical(const FbString& logical);
 
+    /// shared texts compare without looking at them
+    bool operator == (const BiDiString &other) const {
+        return m_data == other.m_data || logical() == other.logical();
+    }
+    bool operator != (const BiDiString &other) const { return !(*this == other); }
+
 private:
-    FbString m_logical;
+    struct Data: public RefCounted {
+        Data()
+#ifdef HAVE_FRIBIDI
+            : visual_dirty(false), visual_differs(false)
+#endif
+        { }
+
+        FbString logical;
 #ifdef HAVE_FRIBIDI
-    mutable FbString m_visual;
-    mutable bool m_visual_dirty;
+        FbString visual; ///< only set if it differs from logical
+        bool visual_dirty;
+        bool visual_differs;
 #endif
+    };
+
+    static const FbString &emptyString();
+
+    RefCount<Data> m_data; ///< none for the empty text
 };
 
 namespace FbStringUtil {
@@ -73,6 +99,13 @@ std::string FbStrToX(const FbString &src);
 FbString LocaleStrToFb(const std::string &src);
 std::string FbStrToLocale(const FbString &src);
 
+/// Same as above, but convert len bytes of src into dest, reusing its
+/// memory. 7-bit text is copied without going through iconv.
+void XStrToFb(const char *src, size_t len, FbString &dest);
+void FbStrToX(const char *src, size_t len, std::string &dest);
+void LocaleStrToFb(const char *src, size_t len, FbString &dest);
+void FbStrToLocale(const char *src, size_t len, std::string &dest);
+
 bool haveUTF8();
 
 } // namespace FbStringUtil
@@ -89,10 +122,13 @@ public:
     void reset();
 
     FbString recode(const FbString &src);
+    /// converts len bytes of src into dest, reusing its memory
+    void recode(const char *src, size_t len, FbString &dest);
 
 private:
 #ifdef HAVE_ICONV
-    iconv_t m_iconv;
+    iconv_t m_iconv; ///< owned by the descriptor pool
+    bool m_ascii; ///< 7-bit text is the same in both encodings
 #endif
     std::string m_destencoding;
 };
@@ -0,0 +1,61 @@
+// FbTime.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#include "FbTime.hh"
+
+#ifdef HAVE_CTIME
+  #include <ctime>
+#else
+  #include <time.h>
+#endif
+
+#include <sys/time.h>
+
+namespace FbTk {
+
+uint64_t FbTime::mono() {
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+    timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+        return ts.tv_sec * IN_SECONDS + ts.tv_nsec / 1000L;
+#endif // HAVE_CLOCK_GETTIME
+
+    // no monotonic clock available, fall back to the wall clock
+    return system();
+}
+
+uint64_t FbTime::monoNanoseconds() {
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+    timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+        return ts.tv_sec * IN_SECONDS * 1000L + ts.tv_nsec;
+#endif // HAVE_CLOCK_GETTIME
+
+    return system() * 1000L;
+}
+
+uint64_t FbTime::system() {
+    timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec * IN_SECONDS + tv.tv_usec;
+}
+
+} // end namespace FbTk
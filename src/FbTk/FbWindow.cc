@@ -27,6 +27,11 @@
 #include "Color.hh"
 #include "App.hh"
 #include "Transparent.hh"
+#include "RoundTrips.hh"
+#include "AtomCache.hh"
+#include "PropertyPrefetch.hh"
+#include "MemoryAccount.hh"
+#include "RequestStats.hh"
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -40,19 +45,38 @@
 #else
   #include <assert.h>
 #endif
+#ifdef HAVE_CSTRING
+  #include <cstring>
+#else
+  #include <string.h>
+#endif
 
+#include <algorithm>
 #include <limits>
+#include <utility>
+#include <vector>
 
 namespace FbTk {
 
+namespace {
+
+/// bumped whenever a root pixmap changes, in place or not
+unsigned int s_root_revision = 0;
+/// source of FbWindow::alphaGeneration(), unique over all windows
+unsigned int s_alpha_generation = 0;
+
+} // end anonymous namespace
+
 FbWindow::FbWindow():
     FbDrawable(),
     m_parent(0), m_screen_num(0), m_window(0),
     m_x(0), m_y(0), m_width(0), m_height(0),
     m_border_width(0), m_border_color(0),
-    m_depth(0), m_destroy(true),
+    m_depth(0), m_geometry_dirty(false), m_destroy(true),
     m_lastbg_color_set(false), m_lastbg_color(0), m_lastbg_pm(0),
-    m_renderer(0) {
+    m_border_color_set(false), m_server_bg_set(false),
+    m_server_bg_pm(0), m_server_bg_color(0),
+    m_renderer(0), m_double_buffered(false), m_buffer_pm(0), m_opacity(-1) {
 
 }
 
@@ -64,9 +88,12 @@ FbWindow::FbWindow(const FbWindow& the_copy):
     m_width(the_copy.width()), m_height(the_copy.height()),
     m_border_width(the_copy.borderWidth()),
     m_border_color(the_copy.borderColor()),
-    m_depth(the_copy.depth()), m_destroy(true),
+    m_depth(the_copy.depth()), m_geometry_dirty(the_copy.m_geometry_dirty),
+    m_destroy(true),
     m_lastbg_color_set(false), m_lastbg_color(0), m_lastbg_pm(0),
-    m_renderer(the_copy.m_renderer) {
+    m_border_color_set(false), m_server_bg_set(false),
+    m_server_bg_pm(0), m_server_bg_color(0),
+    m_renderer(the_copy.m_renderer), m_double_buffered(false), m_buffer_pm(0), m_opacity(-1) {
     the_copy.m_window = 0;
 }
 
@@ -88,10 +115,12 @@ FbWindow::FbWindow(int screen_num,
     m_border_width(0),
     m_border_color(0),
     m_depth(0),
+    m_geometry_dirty(false),
     m_destroy(true),
     m_lastbg_color_set(false),
     m_lastbg_color(0),
-    m_lastbg_pm(0), m_renderer(0) {
+    m_lastbg_pm(0), m_border_color_set(false), m_server_bg_set(false), m_server_bg_pm(0), m_server_bg_color(0), m_renderer(0),
+    m_double_buffered(false), m_buffer_pm(0), m_opacity(-1) {
 
     create(RootWindow(display(), screen_num),
            x, y, width, height, eventmask,
@@ -113,9 +142,11 @@ FbWindow::FbWindow(const FbWindow &parent,
     m_window(0),
     m_x(0), m_y(0),
     m_width(1), m_height(1),
+    m_depth(0), m_geometry_dirty(false),
     m_destroy(true),
     m_lastbg_color_set(false), m_lastbg_color(0),
-    m_lastbg_pm(0), m_renderer(0) {
+    m_lastbg_pm(0), m_border_color_set(false), m_server_bg_set(false), m_server_bg_pm(0), m_server_bg_color(0), m_renderer(0),
+    m_double_buffered(false), m_buffer_pm(0), m_opacity(-1) {
 
     create(parent.window(), x, y, width, height, eventmask,
            override_redirect, save_unders, depth, class_type, visual, cmap);
@@ -126,9 +157,12 @@ FbWindow::FbWindow(Window client):
     m_parent(0), m_screen_num(0), m_window(0),
     m_x(0), m_y(0), m_width(1), m_height(1),
     m_border_width(0), m_border_color(0),
-    m_depth(0), m_destroy(false), // don't destroy this window
+    m_depth(0), m_geometry_dirty(false),
+    m_destroy(false), // don't destroy this window
     m_lastbg_color_set(false), m_lastbg_color(0), m_lastbg_pm(0),
-    m_renderer(0) {
+    m_border_color_set(false), m_server_bg_set(false),
+    m_server_bg_pm(0), m_server_bg_color(0),
+    m_renderer(0), m_double_buffered(false), m_buffer_pm(0), m_opacity(-1) {
     setNew(client);
 }
 
@@ -139,12 +173,17 @@ FbWindow::~FbWindow() {
         removeAlphaWin(*this);
         m_transparent.reset(0);
     }
+    freeAlphaCache();
+    freeBuffer();
 
     if (m_window != 0) {
         // so we don't get any dangling eventhandler for this window
         FbTk::EventManager::instance()->remove(m_window);
-        if (m_destroy)
+        if (m_destroy) {
+            dropCaches(m_window);
             XDestroyWindow(display(), m_window);
+            MemoryAccount::destroyed(MemoryAccount::WINDOWS);
+        }
     }
 
 }
@@ -172,6 +211,89 @@ void FbWindow::setBackgroundPixmap(Pixmap bg_pixmap) {
 void FbWindow::invalidateBackground() {
     m_lastbg_pm = None;
     m_lastbg_color_set = false;
+    // the pixmap might be freed and its id reused, so send the next one
+    m_server_bg_set = false;
+    freeAlphaCache();
+}
+
+void FbWindow::releaseBackground() {
+    invalidateBackground();
+    if (m_window != 0)
+        XSetWindowBackgroundPixmap(display(), m_window, None);
+}
+
+void FbWindow::setDoubleBuffered(bool value) {
+    if (m_double_buffered == value)
+        return;
+    m_double_buffered = value;
+    if (!value)
+        freeBuffer();
+    updateBackground(false);
+}
+
+bool FbWindow::composesParent() const {
+    return m_lastbg_pm == ParentRelative && m_parent != 0 &&
+        (m_parent->m_double_buffered || m_parent->composesParent()) &&
+        (m_parent->composedBackground() != None || m_parent->m_lastbg_color_set);
+}
+
+Pixmap FbWindow::composedBackground() const {
+    if (m_buffer_pm != None)
+        return m_buffer_pm;
+    if (m_lastbg_pm != ParentRelative)
+        return m_lastbg_pm;
+    return None;
+}
+
+void FbWindow::composeFromParent() {
+    FbPixmap newpm(*this, width(), height(), depth());
+    GC gc = XCreateGC(display(), window(), 0, 0);
+
+    // the background of the parent starts inside its border, ours too
+    Pixmap parent_bg = m_parent->composedBackground();
+    if (parent_bg != None) {
+        newpm.copyArea(parent_bg, gc, x() + borderWidth(), y() + borderWidth(),
+                       0, 0, width(), height());
+    } else {
+        XSetForeground(display(), gc, m_parent->m_lastbg_color);
+        newpm.fillRectangle(gc, 0, 0, width(), height());
+    }
+    XFreeGC(display(), gc);
+
+    if (m_renderer)
+        m_renderer->renderForeground(*this, newpm);
+
+    RequestStats::count(RequestStats::SET_BACKGROUND);
+    XSetWindowBackgroundPixmap(display(), m_window, newpm.drawable());
+    m_server_bg_set = false;
+    if (m_buffer_pm != None)
+        MemoryAccount::freePixmap(display(), m_buffer_pm);
+    m_buffer_pm = newpm.release();
+    m_composed_wins.insert(this);
+}
+
+void FbWindow::rootPosition(int &root_x, int &root_y) const {
+    const FbWindow *root_parent = parent();
+    // our position in parent ("root")
+    root_x = x() + borderWidth();
+    root_y = y() + borderWidth();
+    for (; root_parent != 0; root_parent = root_parent->parent()) {
+        root_x += root_parent->x() + root_parent->borderWidth();
+        root_y += root_parent->y() + root_parent->borderWidth();
+    }
+}
+
+void FbWindow::freeAlphaCache() {
+    if (m_alpha_cache.pixmap != None)
+        MemoryAccount::freePixmap(display(), m_alpha_cache.pixmap);
+    m_alpha_cache.pixmap = None;
+}
+
+void FbWindow::freeBuffer() {
+    if (m_buffer_pm != None)
+        MemoryAccount::freePixmap(display(), m_buffer_pm);
+    m_buffer_pm = None;
+    m_composed_wins.erase(this);
 }
 
 void FbWindow::updateBackground(bool only_if_alpha) {
@@ -185,9 +307,20 @@ void FbWindow::updateBackground(bool only_if_alpha) {
     if (m_transparent.get() != 0)
         alpha = m_transparent->alpha();
 
-    if (only_if_alpha && alpha == 255) 
+    // a composed background depends on where we are, even when opaque
+    const bool compose = composesParent();
+    if (only_if_alpha && alpha == 255 && !compose)
         return;
 
+    if (compose) {
+        composeFromParent();
+        return;
+    }
+
+    // the parent doesn't buffer (anymore)
+    if (!m_double_buffered && m_buffer_pm != None)
+        freeBuffer();
+
     // still use bg buffer pixmap if not transparent
     // cause it does nice caching things, assuming we have a renderer
     if (m_lastbg_pm != ParentRelative && (m_renderer || alpha != 255)) {
@@ -200,63 +333,110 @@ void FbWindow::updateBackground(bool only_if_alpha) {
         free_newbg = true; // newpm gets released to newbg at end of block
         GC gc = XCreateGC(display(), window(), 0, 0);
 
-        if (m_lastbg_pm == None && m_lastbg_color_set) {
-            XSetForeground(display(), gc, m_lastbg_color);
-            newpm.fillRectangle(gc, 0, 0, width(), height());
+        int root_x = 0, root_y = 0;
+        if (alpha != 255)
+            rootPosition(root_x, root_y);
+
+        // a window copying its own contents can't tell when they change
+        const bool cacheable = alpha != 255 &&
+            (m_lastbg_pm != None || m_lastbg_color_set);
+        const unsigned long bg_color = m_lastbg_color_set ? m_lastbg_color : 0;
+        AlphaCache &cache = m_alpha_cache;
+        if (cacheable && cache.pixmap != None &&
+            cache.alpha == alpha &&
+            cache.root_x == root_x && cache.root_y == root_y &&
+            cache.width == width() && cache.height == height() &&
+            cache.root_revision == s_root_revision &&
+            cache.bg_pm == m_lastbg_pm && cache.bg_color == bg_color) {
+            // nothing below us changed, skip the blending
+            newpm.copyArea(cache.pixmap, gc, 0, 0, 0, 0, width(), height());
         } else {
-            // copy from window if no color and no bg...
-            newpm.copyArea((m_lastbg_pm == None)?drawable():m_lastbg_pm, gc, 0, 0, 0, 0, width(), height());
-        }
-        XFreeGC(display(), gc);
+            if (m_lastbg_pm == None && m_lastbg_color_set) {
+                XSetForeground(display(), gc, m_lastbg_color);
+                newpm.fillRectangle(gc, 0, 0, width(), height());
+            } else {
+                // copy from window if no color and no bg...
+                newpm.copyArea((m_lastbg_pm == None)?drawable():m_lastbg_pm, gc, 0, 0, 0, 0, width(), height());
+            }
 
-        if (alpha != 255)
-            m_transparent->setDest(newpm.drawable(), screenNumber());
-
-        // get root position
-
-        const FbWindow *root_parent = parent();
-        // our position in parent ("root")
-        int root_x = x() + borderWidth(), root_y = y() + borderWidth();
-        if (root_parent != 0) {
-            root_x += root_parent->x() + root_parent->borderWidth();
-            root_y += root_parent->y() + root_parent->borderWidth();
-            while (root_parent->parent() != 0) {
-                root_parent = root_parent->parent();
-                root_x += root_parent->x() + root_parent->borderWidth();
-                root_y += root_parent->y() + root_parent->borderWidth();
+            // render background image from root pos to our window
+            if (alpha != 255) {
+                m_transparent->setDest(newpm.drawable(), screenNumber());
+                m_transparent->render(root_x, root_y,
+                                      0, 0,
+                                      width(), height());
+                m_transparent->freeDest(); // it's only temporary, don't leave it hanging around
             }
-        }
 
-        // render background image from root pos to our window
-        if (alpha != 255)
-            m_transparent->render(root_x, root_y,
-                                  0, 0,
-                                  width(), height());
+            freeAlphaCache();
+            if (cacheable) {
+                FbPixmap blended(*this, width(), height(), depth());
+                blended.copyArea(newpm.drawable(), gc, 0, 0, 0, 0, width(), height());
+                cache.pixmap = blended.release();
+                cache.alpha = alpha;
+                cache.root_x = root_x;
+                cache.root_y = root_y;
+                cache.width = width();
+                cache.height = height();
+                cache.root_revision = s_root_revision;
+                cache.bg_pm = m_lastbg_pm;
+                cache.bg_color = bg_color;
+            }
+            if (alpha != 255)
+                cache.generation = ++s_alpha_generation;
+        }
+        XFreeGC(display(), gc);
 
         // render any foreground items
         if (m_renderer)
             m_renderer->renderForeground(*this, newpm);
 
-        if (alpha != 255)
-            m_transparent->freeDest(); // it's only temporary, don't leave it hanging around
         newbg = newpm.release();
     }
 
-    if (newbg != None)
-        XSetWindowBackgroundPixmap(display(), m_window, newbg);
-    else if (m_lastbg_color_set)
-        XSetWindowBackground(display(), m_window, m_lastbg_color);
+    // skip the request if the server already has this background, temporary
+    // pixmaps are new every time
+    if (newbg != None) {
+        if (free_newbg || !m_server_bg_set || m_server_bg_pm != newbg) {
+            RequestStats::count(RequestStats::SET_BACKGROUND);
+            XSetWindowBackgroundPixmap(display(), m_window, newbg);
+        }
+        m_server_bg_set = !free_newbg;
+        m_server_bg_pm = newbg;
+    } else if (m_lastbg_color_set) {
+        if (!m_server_bg_set || m_server_bg_pm != None ||
+            m_server_bg_color != m_lastbg_color) {
+            RequestStats::count(RequestStats::SET_BACKGROUND);
+            XSetWindowBackground(display(), m_window, m_lastbg_color);
+        }
+        m_server_bg_set = true;
+        m_server_bg_pm = None;
+        m_server_bg_color = m_lastbg_color;
+    }
 
-    if (free_newbg)
-        XFreePixmap(display(), newbg);
+    // our children compose their backgrounds from it
+    if (m_double_buffered) {
+        if (m_buffer_pm != None && m_buffer_pm != newbg)
+            MemoryAccount::freePixmap(display(), m_buffer_pm);
+        m_buffer_pm = free_newbg ? newbg : None;
+    } else if (free_newbg)
+        MemoryAccount::freePixmap(display(), newbg);
 }
 
 void FbWindow::setBorderColor(const FbTk::Color &border_color) {
+    if (m_border_color_set && m_border_color == border_color.pixel())
+        return;
+
     XSetWindowBorder(display(), m_window, border_color.pixel());
     m_border_color = border_color.pixel();
+    m_border_color_set = true;
 }
 
 void FbWindow::setBorderWidth(unsigned int size) {
+    // m_border_width is always what the server has
+    if (m_border_width == size)
+        return;
+
     XSetWindowBorderWidth(display(), m_window, size);
     m_border_width = size;
 }
@@ -270,8 +450,9 @@ void FbWindow::setEventMask(long mask) {
 }
 
 void FbWindow::clear() {
+    RequestStats::count(RequestStats::CLEAR);
     XClearWindow(display(), m_window);
-    if (m_lastbg_pm == ParentRelative && m_renderer)
+    if (m_lastbg_pm == ParentRelative && m_renderer && m_buffer_pm == None)
         m_renderer->renderForeground(*this, *this);
 
 }
@@ -280,10 +461,12 @@ void FbWindow::clearArea(int x, int y,
                          unsigned int width, unsigned int height,
                          bool exposures) {
     // TODO: probably could call renderForeground here (with x,y,w,h)
-    if (m_lastbg_pm == ParentRelative && m_renderer)
+    if (m_lastbg_pm == ParentRelative && m_renderer && m_buffer_pm == None)
         FbWindow::clear();
-    else
+    else {
+        RequestStats::count(RequestStats::CLEAR);
         XClearArea(display(), window(), x, y, width, height, exposures);
+    }
 }
 
 // If override_is_offset, then dest_override is a pixmap located at the_x, the_y
@@ -326,21 +509,8 @@ void FbWindow::updateTransparent(int the_x, int the_y, unsigned int the_width, u
     if (m_transparent->dest() != dest_override)
         m_transparent->setDest(dest_override, screenNumber());
 
-    // get root position
-
-    const FbWindow *root_parent = parent();
-    // our position in parent ("root")
-    int root_x = x() + borderWidth(), root_y = y() + borderWidth();
-    if (root_parent != 0) {
-        root_x += root_parent->x() + root_parent->borderWidth();
-        root_y += root_parent->y() + root_parent->borderWidth();
-        while (root_parent->parent() != 0) {
-            root_parent = root_parent->parent();
-            root_x += root_parent->x() + root_parent->borderWidth();
-            root_y += root_parent->y() + root_parent->borderWidth();
-        }
-
-    } // else toplevel window so we already have x, y set
+    int root_x, root_y;
+    rootPosition(root_x, root_y);
 
     // render background image from root pos to our window
     m_transparent->render(root_x + the_x, root_y + the_y,
@@ -351,10 +521,11 @@ void FbWindow::updateTransparent(int the_x, int the_y, unsigned int the_width, u
 
 void FbWindow::setAlpha(int alpha) {
 #ifdef HAVE_XRENDER
-    if (FbTk::Transparent::haveComposite()) {
+    if (FbTk::Transparent::useComposite(screenNumber())) {
         if (m_transparent.get() != 0) {
             removeAlphaWin(*this);
             m_transparent.reset(0);
+            freeAlphaCache();
         }
 
         // don't setOpaque, let controlling objects do that
@@ -371,6 +542,7 @@ void FbWindow::setAlpha(int alpha) {
         else if (alpha == 255) {
             removeAlphaWin(*this);
             m_transparent.reset(0); // destroy transparent object
+            freeAlphaCache();
         }
     }
 #endif // HAVE_XRENDER
@@ -394,7 +566,11 @@ FbWindow &FbWindow::operator = (const FbWindow &win) {
     m_height = win.height();
     m_border_width = win.borderWidth();
     m_border_color = win.borderColor();
+    m_border_color_set = win.m_border_color_set;
+    m_server_bg_set = false;
+    m_opacity = win.m_opacity;
     m_depth = win.depth();
+    m_geometry_dirty = win.m_geometry_dirty;
     // take over this window
     win.m_window = 0;
     return *this;
@@ -407,16 +583,24 @@ FbWindow &FbWindow::operator = (Window win) {
 
 void FbWindow::setNew(Window win) {
 
-    if (m_window != 0 && m_destroy)
+    if (m_window != 0 && m_destroy) {
+        dropCaches(m_window);
         XDestroyWindow(display(), m_window);
+        MemoryAccount::destroyed(MemoryAccount::WINDOWS);
+    }
 
     m_window = win;
+    m_border_color_set = false;
+    m_server_bg_set = false;
+    m_opacity = -1;
 
     if (m_window != 0) {
-        updateGeometry();
+        // the attributes hold the geometry too
+        m_geometry_dirty = false;
         XWindowAttributes attr;
         attr.screen = 0;
         //get screen number
+        FBTK_ROUNDTRIP("FbWindow::setNew");
         if (XGetWindowAttributes(display(),
                                  m_window,
                                  &attr) != 0 && attr.screen != 0) {
@@ -471,8 +655,11 @@ void FbWindow::setCursor(Cursor cur) {
 void FbWindow::reparent(const FbWindow &parent, int x, int y, bool continuing) {
     XReparentWindow(display(), window(), parent.window(), x, y);
     m_parent = &parent;
-    if (continuing) // we will continue managing this window after reparent
-        updateGeometry();
+    if (continuing) { // we will continue managing this window after reparent
+        // the size stays, the position is what we asked for
+        m_x = x;
+        m_y = y;
+    }
 }
 
 namespace {
@@ -513,10 +700,16 @@ FbTk::FbString FbWindow::textProperty(Atom prop,bool*exists) const {
     int count = 0;
     FbTk::FbString ret;
 
-    static const Atom utf8string = XInternAtom(display(), "UTF8_STRING", False);
+    static const Atom utf8string = AtomCache::instance().get("UTF8_STRING");
 
     if (exists) *exists=false;
-    if (XGetTextProperty(display(), window(), &text_prop, prop) == 0 || text_prop.value == 0 || text_prop.nitems == 0) {
+    // like XGetTextProperty(), but the property may be prefetched
+    unsigned long bytes_after = 0;
+    text_prop.value = 0;
+    if (!property(prop, 0, 1000000L, False, AnyPropertyType,
+                  &text_prop.encoding, &text_prop.format, &text_prop.nitems,
+                  &bytes_after, &text_prop.value) ||
+        text_prop.value == 0 || text_prop.nitems == 0) {
         return "";
     }
 
@@ -525,7 +718,7 @@ FbTk::FbString FbWindow::textProperty(Atom prop,bool*exists) const {
         if (XTextPropertyToStringList(&text_prop, &stringlist, &count) == 0 || count == 0) {
             return "";
         }
-        ret = FbStringUtil::XStrToFb(stringlist[0]);
+        FbStringUtil::XStrToFb(stringlist[0], strlen(stringlist[0]), ret);
     } else if (text_prop.encoding == utf8string && text_prop.format == 8) {
 #ifdef X_HAVE_UTF8_STRING
         Xutf8TextPropertyToTextList(display(), &text_prop, &stringlist, &count);
@@ -544,7 +737,7 @@ FbTk::FbString FbWindow::textProperty(Atom prop,bool*exists) const {
         if (count == 0 || stringlist == 0) {
             return "";
         }
-        ret = FbStringUtil::LocaleStrToFb(stringlist[0]);
+        FbStringUtil::LocaleStrToFb(stringlist[0], strlen(stringlist[0]), ret);
     }
 
     // they all use stringlist
@@ -564,6 +757,13 @@ bool FbWindow::property(Atom prop,
                         unsigned long *nitems_return,
                         unsigned long *bytes_after_return,
                         unsigned char **prop_return) const {
+    if (PropertyPrefetch::lookup(window(), prop, long_offset, long_length,
+                                 do_delete, req_type, actual_type_return,
+                                 actual_format_return, nitems_return,
+                                 bytes_after_return, prop_return))
+        return true;
+
+    FBTK_ROUNDTRIP("FbWindow::property");
     if (XGetWindowProperty(display(), window(),
                            prop, long_offset, long_length, do_delete,
                            req_type, actual_type_return,
@@ -580,12 +780,14 @@ void FbWindow::changeProperty(Atom prop, Atom type,
                               unsigned char *data,
                               int nelements) {
 
+    PropertyPrefetch::forget(m_window, prop);
     XChangeProperty(display(), m_window, prop, type,
                     format, mode,
                     data, nelements);
 }
 
 void FbWindow::deleteProperty(Atom prop) {
+    PropertyPrefetch::forget(m_window, prop);
     XDeleteProperty(display(), m_window, prop);
 }
 
@@ -603,6 +805,7 @@ int FbWindow::screenNumber() const {
 
 long FbWindow::eventMask() const {
     XWindowAttributes attrib;
+    FBTK_ROUNDTRIP("FbWindow::eventMask");
     XGetWindowAttributes(display(), window(),
                          &attrib);
     return attrib.your_event_mask;
@@ -611,7 +814,11 @@ long FbWindow::eventMask() const {
 
 void FbWindow::setOpaque(int alpha) {
 #ifdef HAVE_XRENDER
-    static const Atom alphaatom = XInternAtom(display(), "_NET_WM_WINDOW_OPACITY", False);
+    // focus changes set the same opacity over and over
+    if (alpha == m_opacity)
+        return;
+    m_opacity = alpha;
+    static const Atom alphaatom = AtomCache::instance().get("_NET_WM_WINDOW_OPACITY");
     unsigned long opacity = alpha * 0x1010101;
     changeProperty(alphaatom, XA_CARDINAL, 32, PropModeReplace, (unsigned char *) &opacity, 1l);
 #endif // HAVE_XRENDER
@@ -626,14 +833,30 @@ bool FbWindow::updateGeometry() {
 
     Window root;
     unsigned int border_width, depth;
+    FBTK_ROUNDTRIP("FbWindow::updateGeometry");
     if (XGetGeometry(display(), m_window, &root, &m_x, &m_y,
                      &m_width, &m_height, &border_width, &depth))
         m_depth = depth;
+    m_geometry_dirty = false;
 
     return (old_x != m_x || old_y != m_y || old_width != m_width ||
             old_height != m_height);
 }
 
+bool FbWindow::updateGeometry(const XConfigureEvent &event) {
+    m_geometry_dirty = false;
+    if (event.x == m_x && event.y == m_y &&
+        static_cast<unsigned int>(event.width) == m_width &&
+        static_cast<unsigned int>(event.height) == m_height)
+        return false;
+
+    m_x = event.x;
+    m_y = event.y;
+    m_width = event.width;
+    m_height = event.height;
+    return true;
+}
+
 void FbWindow::create(Window parent, int x, int y,
                       unsigned int width, unsigned int height,
                       long eventmask, bool override_redirect,
@@ -641,6 +864,9 @@ void FbWindow::create(Window parent, int x, int y,
                       Visual *visual, Colormap cmap) {
     m_border_width = 0;
     m_border_color = 0;
+    m_border_color_set = false;
+    m_server_bg_set = false;
+    m_opacity = -1;
 
     long valmask = CWEventMask;
     XSetWindowAttributes values;
@@ -672,8 +898,22 @@ void FbWindow::create(Window parent, int x, int y,
                              &values); // create atrribs
 
     assert(m_window);
-
-    updateGeometry();
+    MemoryAccount::created(MemoryAccount::WINDOWS);
+
+    // the server takes what we asked for, no need to ask it back
+    m_x = x;
+    m_y = y;
+    m_width = width;
+    m_height = height;
+    if (class_type == InputOnly)
+        m_depth = 0;
+    else if (depth != CopyFromParent)
+        m_depth = depth;
+    else if (m_parent != 0)
+        m_depth = m_parent->depth();
+    else
+        m_depth = DefaultDepth(display(), m_screen_num);
+    m_geometry_dirty = false;
 }
 
 
@@ -700,6 +940,7 @@ void FbWindow::sendConfigureNotify(int x, int y,
 }
 
 FbWindow::FbWinList FbWindow::m_alpha_wins;
+FbWindow::FbWinList FbWindow::m_composed_wins;
 
 void FbWindow::addAlphaWin(FbWindow &win) {
     m_alpha_wins.insert(&win);
@@ -712,6 +953,7 @@ void FbWindow::removeAlphaWin(FbWindow &win) {
 }
 
 void FbWindow::updatedAlphaBackground(int screen) {
+    ++s_root_revision;
     FbWinList::iterator it = m_alpha_wins.begin();
     FbWinList::iterator it_end = m_alpha_wins.end();
     for (; it != it_end; ++it) {
@@ -720,6 +962,23 @@ void FbWindow::updatedAlphaBackground(int screen) {
             (*it)->clear();
         }
     }
+
+    // copy the new backgrounds down to the children composing from them,
+    // parents first
+    std::vector<std::pair<int, FbWindow *> > composed;
+    for (it = m_composed_wins.begin(); it != m_composed_wins.end(); ++it) {
+        if ((*it)->screenNumber() != screen)
+            continue;
+        int depth = 0;
+        for (const FbWindow *win = (*it)->parent(); win != 0; win = win->parent())
+            ++depth;
+        composed.push_back(std::make_pair(depth, *it));
+    }
+    std::sort(composed.begin(), composed.end());
+    for (size_t i = 0; i < composed.size(); ++i) {
+        composed[i].second->updateBackground(false);
+        composed[i].second->clear();
+    }
 }
 
 bool operator == (Window win, const FbWindow &fbwin) {
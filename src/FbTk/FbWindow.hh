@@ -24,6 +24,7 @@
 
 #include "FbDrawable.hh"
 #include "FbString.hh"
+#include "RequestStats.hh"
 #include <memory>
 #include <string>
 #include <set>
@@ -77,6 +78,9 @@ public:
     virtual void setBackgroundPixmap(Pixmap bg_pixmap);
     // call when background is freed, and new one not ready yet
     virtual void invalidateBackground();
+    /// invalidates the background and lets the server free its pixmap,
+    /// for hidden windows
+    void releaseBackground();
     virtual void setBorderColor(const FbTk::Color &border_color);
     virtual void setBorderWidth(unsigned int size);
     /// set window name ("title")
@@ -110,6 +114,7 @@ public:
     virtual void move(int x, int y) {
         if (x == m_x && y == m_y)
             return;
+        RequestStats::count(RequestStats::MOVE_RESIZE);
         XMoveWindow(display(), m_window, x, y);
         m_x = x;
         m_y = y;
@@ -119,6 +124,7 @@ public:
     virtual void resize(unsigned int width, unsigned int height) {
         if (width == m_width && height == m_height)
             return;
+        RequestStats::count(RequestStats::MOVE_RESIZE);
         XResizeWindow(display(), m_window, width, height);
         m_width = width;
         m_height = height;
@@ -128,6 +134,7 @@ public:
     virtual void moveResize(int x, int y, unsigned int width, unsigned int height) {
         if (x == m_x && y == m_y && width == m_width && height == m_height)
             return;
+        RequestStats::count(RequestStats::MOVE_RESIZE);
         XMoveResizeWindow(display(), m_window, x, y, width, height);
         m_x = x;
         m_y = y;
@@ -196,6 +203,16 @@ public:
     void setOpaque(int alpha);
 
     void setRenderer(FbWindowRenderer &renderer) { m_renderer = &renderer; }
+    /// ParentRelative children compose their background, foreground
+    /// included, from a copy of ours instead of drawing on themselves
+    /// after every clear
+    void setDoubleBuffered(bool value);
+    bool doubleBuffered() const { return m_double_buffered; }
+    /// the composed background the server shows, or None
+    Pixmap backgroundBuffer() const { return m_buffer_pm; }
+    /// changes whenever the translucent background is blended anew, so
+    /// what was drawn over it stays valid until then
+    unsigned int alphaGeneration() const { return m_alpha_cache.generation; }
     void sendConfigureNotify(int x, int y, unsigned int width,
                              unsigned int height, unsigned int bw = 0);
 
@@ -204,8 +221,26 @@ public:
 
     static void updatedAlphaBackground(int screen);
 
-    /// updates x,y, width, height and screen num from X window
+    // The cached geometry is what we set or were told in a ConfigureNotify,
+    // x(), y(), width() and height() never ask the server. Windows that
+    // others change behind our back are invalidated, and fetched again
+    // with syncGeometry().
+
+    /// updates x,y, width, height and depth from X window
+    /// @return true if the geometry changed
     bool updateGeometry();
+    /// takes the geometry of a ConfigureNotify of this window
+    /// @return true if the geometry changed
+    bool updateGeometry(const XConfigureEvent &event);
+    /// marks the cached geometry as stale
+    void invalidateGeometry() { m_geometry_dirty = true; }
+    bool geometryDirty() const { return m_geometry_dirty; }
+    /// fetches the geometry if it is stale
+    /// @return true if the geometry changed
+    bool syncGeometry() { return m_geometry_dirty && updateGeometry(); }
+    /// the position of our inside in the root window, from the cached
+    /// geometry of this window and its FbWindow parents
+    void rootPosition(int &root_x, int &root_y) const;
 
 protected:
     /// creates a window with x window client (m_window = client)
@@ -226,6 +261,14 @@ private:
                 Visual *visual,
                 Colormap cmap);
 
+    /// whether our background is a composed copy of the parent's one
+    bool composesParent() const;
+    /// what children compose their background from, or None for a color
+    Pixmap composedBackground() const;
+    void composeFromParent();
+    void freeBuffer();
+    void freeAlphaCache();
+
     const FbWindow *m_parent; ///< parent FbWindow
     int m_screen_num;  ///< screen num on which this window exist
     mutable Window m_window; ///< the X window
@@ -234,19 +277,43 @@ private:
     unsigned int m_border_width; ///< border size
     unsigned long m_border_color; ///< border color
     unsigned int m_depth; ///< bit depth
+    bool m_geometry_dirty; ///< the server may know better than m_x..m_height
     bool m_destroy; ///< wheter the x window was created before
     std::auto_ptr<FbTk::Transparent> m_transparent;
     bool m_lastbg_color_set;
     unsigned long m_lastbg_color;
     Pixmap m_lastbg_pm;
 
+    // what the server has, to skip requests that change nothing
+    bool m_border_color_set; ///< m_border_color is known
+    bool m_server_bg_set; ///< m_server_bg_pm or m_server_bg_color is known
+    Pixmap m_server_bg_pm;
+    unsigned long m_server_bg_color;
+
     FbWindowRenderer *m_renderer;
+    bool m_double_buffered;
+    Pixmap m_buffer_pm; ///< our composed background, kept for the children
+    int m_opacity; ///< what setOpaque() wrote last, -1 if unknown
+
+    /// the last translucent background without the foreground, reused
+    /// until what it was blended from changes
+    struct AlphaCache {
+        AlphaCache(): pixmap(None), generation(0) { }
+        Pixmap pixmap;
+        unsigned int generation;
+        int alpha, root_x, root_y;
+        unsigned int width, height;
+        unsigned int root_revision;
+        Pixmap bg_pm;
+        unsigned long bg_color;
+    } m_alpha_cache;
 
     static void addAlphaWin(FbWindow &win);
     static void removeAlphaWin(FbWindow &win);
 
     typedef std::set<FbWindow *> FbWinList;
     static FbWinList m_alpha_wins;
+    static FbWinList m_composed_wins; ///< windows composing their parent's background
 };
 
 bool operator == (Window win, const FbWindow &fbwin);
@@ -23,9 +23,18 @@
 
 #include <sys/stat.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <cstdio>
+#include <cstdlib>
 
 #include <iostream>
 #include <fstream>
+#include <iterator>
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#include <fcntl.h>
+#endif // HAVE_SYS_MMAN_H
 
 using std::ifstream;
 using std::ofstream;
@@ -88,6 +97,33 @@ bool FileUtil::copyFile(const char* from, const char* to) {
     return false;
 }
 
+std::string FileUtil::realPath(const std::string &filename) {
+    char *real_path = realpath(filename.c_str(), 0);
+    if (real_path == 0)
+        return filename;
+    std::string result(real_path);
+    free(real_path);
+    return result;
+}
+
+bool FileUtil::replaceFile(const std::string &tmpfile, const std::string &filename) {
+    // the new file was created with the umask, keep what the user had
+    struct stat buf;
+    if (stat(filename.c_str(), &buf) == 0) {
+        int fd = ::open(tmpfile.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            fchmod(fd, buf.st_mode & 07777);
+            ::close(fd);
+        }
+    }
+
+    if (rename(tmpfile.c_str(), filename.c_str()) != 0) {
+        remove(tmpfile.c_str());
+        return false;
+    }
+    return true;
+}
+
 Directory::Directory(const char *dir):m_dir(0),
 m_num_entries(0) {
     if (dir != 0)
@@ -149,5 +185,60 @@ bool Directory::open(const char *dir) {
     return true;
 }
 
+MappedFile::MappedFile(const char *filename):
+    m_data(""), m_size(0), m_mapped(false) {
+    if (filename != 0)
+        open(filename);
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const char *filename) {
+    close();
+    if (filename == 0)
+        return false;
+
+#ifdef HAVE_SYS_MMAN_H
+    int fd = ::open(filename, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *map = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            m_data = static_cast<const char *>(map);
+            m_size = st.st_size;
+            m_mapped = true;
+        }
+    }
+    ::close(fd);
+    if (m_mapped)
+        return true;
+#endif // HAVE_SYS_MMAN_H
+
+    // empty, special or unmappable files are just read
+    ifstream file(filename);
+    if (file.fail())
+        return false;
+    m_buffer.assign(std::istreambuf_iterator<char>(file),
+                    std::istreambuf_iterator<char>());
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+    return true;
+}
+
+void MappedFile::close() {
+#ifdef HAVE_SYS_MMAN_H
+    if (m_mapped)
+        munmap(const_cast<char *>(m_data), m_size);
+#endif // HAVE_SYS_MMAN_H
+    m_buffer.clear();
+    m_data = "";
+    m_size = 0;
+    m_mapped = false;
+}
 
 } // end namespace FbTk
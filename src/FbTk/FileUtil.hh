@@ -58,6 +58,16 @@ namespace FileUtil {
     /// copies file 'from' to 'to'
     bool copyFile(const char* from, const char* to);
 
+    /// @return the file a path names, after all links, or the path itself
+    /// if it can't be resolved, e.g. because the file doesn't exist yet
+    std::string realPath(const std::string &filename);
+
+    /// moves the newly written 'tmpfile' over 'filename' in one go, giving
+    /// it the permissions of the file it replaces; 'tmpfile' is removed
+    /// if that fails
+    /// @return false on failure
+    bool replaceFile(const std::string &tmpfile, const std::string &filename);
+
 } // end of File namespace
 
 ///  Wrapper class for DIR * routines
@@ -87,6 +97,26 @@ private:
     size_t m_num_entries; ///< number of file entries in directory
 };
 
+/// Wrapper class for reading a whole file through mmap()
+class MappedFile : private FbTk::NotCopyable {
+public:
+    explicit MappedFile(const char *filename = 0);
+    ~MappedFile();
+    /// maps the file, or reads it if it can't be mapped
+    /// @return false if the file can't be read
+    bool open(const char *filename);
+    void close();
+    /// the contents of the file, not 0-terminated
+    const char *data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    const char *m_data;
+    size_t m_size;
+    bool m_mapped; ///< m_data is mapped, otherwise it points into m_buffer
+    std::string m_buffer;
+};
+
 } // end namespace FbTk
 
 #endif // FBTK_FILEUTIL_HH
@@ -0,0 +1,212 @@
+// FileWatcher.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#include "FileWatcher.hh"
+
+#include "AutoReloadHelper.hh"
+#include "FileUtil.hh"
+#include "Reactor.hh"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <stdlib.h>
+#endif // HAVE_SYS_INOTIFY_H
+
+#include <set>
+
+namespace {
+
+#ifdef HAVE_SYS_INOTIFY_H
+
+/// changes of an entry in a watched directory
+const unsigned int DIR_MASK = IN_ATTRIB | IN_MODIFY | IN_CLOSE_WRITE |
+    IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MASK_ADD;
+
+/// changes of the set of entries of a watched directory itself
+const unsigned int SELF_MASK = IN_ATTRIB | IN_CREATE | IN_DELETE |
+    IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_MASK_ADD;
+
+struct ReadNotifications {
+    void operator()(int fd, int events) const {
+        FbTk::FileWatcher::instance().update();
+    }
+};
+
+void splitPath(const std::string &path, std::string &dir, std::string &name) {
+    std::string::size_type pos = path.find_last_of('/');
+    if (pos == std::string::npos) {
+        dir = ".";
+        name = path;
+    } else {
+        dir = pos == 0 ? "/" : path.substr(0, pos);
+        name = path.substr(pos + 1);
+    }
+}
+
+#endif // HAVE_SYS_INOTIFY_H
+
+} // anonymous namespace
+
+namespace FbTk {
+
+FileWatcher &FileWatcher::instance() {
+    static FileWatcher watcher;
+    return watcher;
+}
+
+FileWatcher::FileWatcher(): m_fd(-1) {
+#ifdef HAVE_SYS_INOTIFY_H
+    m_fd = inotify_init();
+    if (m_fd != -1) {
+        fcntl(m_fd, F_SETFD, FD_CLOEXEC);
+        fcntl(m_fd, F_SETFL, O_NONBLOCK);
+        Reactor::instance().addFunctor(m_fd, Reactor::READ, ReadNotifications());
+    }
+#endif // HAVE_SYS_INOTIFY_H
+}
+
+FileWatcher::~FileWatcher() {
+#ifdef HAVE_SYS_INOTIFY_H
+    if (m_fd != -1) {
+        Reactor::instance().remove(m_fd);
+        close(m_fd);
+    }
+#endif // HAVE_SYS_INOTIFY_H
+}
+
+bool FileWatcher::add(const std::string &filename, AutoReloadHelper &helper) {
+#ifdef HAVE_SYS_INOTIFY_H
+    if (m_fd == -1)
+        return false;
+
+    std::string dir, name;
+    splitPath(filename, dir, name);
+    if (!addWatch(dir, name, filename, DIR_MASK, helper))
+        return false;
+
+    // editing the target of a symlink doesn't touch the link's directory
+    char resolved[PATH_MAX];
+    if (realpath(filename.c_str(), resolved) != 0 && filename != resolved) {
+        splitPath(resolved, dir, name);
+        if (!addWatch(dir, name, filename, DIR_MASK, helper))
+            return false;
+    }
+
+    if (FileUtil::isDirectory(filename.c_str()))
+        return addWatch(filename, "", filename, SELF_MASK, helper);
+
+    return true;
+#else
+    return false;
+#endif // HAVE_SYS_INOTIFY_H
+}
+
+bool FileWatcher::addWatch(const std::string &path, const std::string &name,
+                           const std::string &filename, unsigned int mask,
+                           AutoReloadHelper &helper) {
+#ifdef HAVE_SYS_INOTIFY_H
+    int wd = inotify_add_watch(m_fd, path.c_str(), mask);
+    if (wd == -1)
+        return false;
+
+    Entry entry;
+    entry.helper = &helper;
+    entry.name = name;
+    entry.filename = filename;
+    m_entries.insert(std::make_pair(wd, entry));
+    return true;
+#else
+    return false;
+#endif // HAVE_SYS_INOTIFY_H
+}
+
+void FileWatcher::remove(AutoReloadHelper &helper) {
+#ifdef HAVE_SYS_INOTIFY_H
+    std::set<int> touched;
+    Entries::iterator it = m_entries.begin();
+    while (it != m_entries.end()) {
+        if (it->second.helper == &helper) {
+            touched.insert(it->first);
+            m_entries.erase(it++);
+        } else
+            ++it;
+    }
+
+    // drop the watches nobody is interested in anymore
+    std::set<int>::const_iterator wd = touched.begin();
+    for (; wd != touched.end(); ++wd) {
+        if (m_entries.find(*wd) == m_entries.end())
+            inotify_rm_watch(m_fd, *wd);
+    }
+#endif // HAVE_SYS_INOTIFY_H
+}
+
+void FileWatcher::update() {
+#ifdef HAVE_SYS_INOTIFY_H
+    if (m_fd == -1)
+        return;
+
+    char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    ssize_t len;
+
+    while ((len = read(m_fd, buf, sizeof(buf))) > 0) {
+        for (char *ptr = buf; ptr < buf + len; ) {
+            const inotify_event *ev = reinterpret_cast<const inotify_event *>(ptr);
+            ptr += sizeof(inotify_event) + ev->len;
+
+            if (ev->mask & IN_Q_OVERFLOW) {
+                // we lost track, everybody has to check everything
+                Entries::iterator it = m_entries.begin();
+                for (; it != m_entries.end(); ++it)
+                    it->second.helper->markAllDirty();
+                continue;
+            }
+
+            std::pair<Entries::iterator, Entries::iterator> range =
+                m_entries.equal_range(ev->wd);
+
+            // the kernel removed the watch (e.g. the directory was deleted),
+            // so the helpers have to poll until they add their files again
+            if (ev->mask & IN_IGNORED) {
+                for (Entries::iterator it = range.first; it != range.second; ++it)
+                    it->second.helper->watchLost();
+                m_entries.erase(range.first, range.second);
+                continue;
+            }
+
+            for (Entries::iterator it = range.first; it != range.second; ++it) {
+                const Entry &entry = it->second;
+                if (entry.name.empty() || (ev->len > 0 && entry.name == ev->name))
+                    entry.helper->markDirty(entry.filename);
+            }
+        }
+    }
+#endif // HAVE_SYS_INOTIFY_H
+}
+
+} // end namespace FbTk
@@ -0,0 +1,80 @@
+// FileWatcher.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#ifndef FBTK_FILEWATCHER_HH
+#define FBTK_FILEWATCHER_HH
+
+#include "NotCopyable.hh"
+
+#include <map>
+#include <string>
+
+namespace FbTk {
+
+class AutoReloadHelper;
+
+/**
+   Tells AutoReloadHelpers which of their files might have changed, so
+   they don't have to stat() all of them on every checkReload().
+
+   Uses inotify, watching the directory of every file (editors tend to
+   replace files instead of writing them) and directories themselves.
+   Notifications are read when the Reactor reports the inotify descriptor
+   readable or when update() is called.
+ */
+class FileWatcher: private NotCopyable {
+public:
+    static FileWatcher &instance();
+
+    /**
+       watch 'filename' on behalf of 'helper'
+       @return false if the file can't be watched, the helper has to fall
+               back to polling then
+     */
+    bool add(const std::string &filename, AutoReloadHelper &helper);
+    /// stop all watches of 'helper'
+    void remove(AutoReloadHelper &helper);
+
+    /// reads pending notifications without blocking
+    void update();
+
+private:
+    FileWatcher();
+    ~FileWatcher();
+
+    bool addWatch(const std::string &path, const std::string &name,
+                  const std::string &filename, unsigned int mask,
+                  AutoReloadHelper &helper);
+
+    struct Entry {
+        AutoReloadHelper *helper;
+        std::string name; ///< entry of a watched directory, empty matches all
+        std::string filename; ///< what we report to the helper
+    };
+    typedef std::multimap<int, Entry> Entries; ///< by watch descriptor
+
+    int m_fd;
+    Entries m_entries;
+};
+
+} // end namespace FbTk
+
+#endif // FBTK_FILEWATCHER_HH
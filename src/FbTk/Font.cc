@@ -23,7 +23,10 @@
 #include "stringstream.hh"
 #include "Font.hh"
 #include "FontImp.hh"
+#include "RotatedTextCache.hh"
 #include "App.hh"
+#include "RequestStats.hh"
+#include "StartupProfile.hh"
 
 #ifdef    HAVE_CONFIG_H
 #include "config.h"
@@ -69,6 +72,10 @@
 
 #include <errno.h>
 
+#if defined(USE_XFT) && defined(HAVE_PTHREAD)
+#include <pthread.h>
+#endif // USE_XFT && HAVE_PTHREAD
+
 using std::string;
 using std::map;
 using std::list;
@@ -90,6 +97,44 @@ typedef map<string, FbTk::FontImp* > FontCache;
 typedef FontCache::iterator FontCacheIt;
 FontCache font_cache;
 
+// number of Font objects using each fontimp, unused ones are freed by
+// Font::evictUnused
+typedef map<FbTk::FontImp*, int> FontRefs;
+FontRefs font_refs;
+
+void acquire(FbTk::FontImp *imp) {
+    if (imp)
+        ++font_refs[imp];
+}
+
+void release(FbTk::FontImp *imp) {
+    FontRefs::iterator it = font_refs.find(imp);
+    if (it != font_refs.end() && it->second > 0)
+        --it->second;
+}
+
+
+#if defined(USE_XFT) && defined(HAVE_PTHREAD)
+// reads the fontconfig configuration and caches while fluxbox connects to
+// the display; with cold caches that is the slow part of the first font
+pthread_t preload_thread;
+bool preload_running = false;
+
+void *preloadFontconfig(void *) {
+    FcInit();
+    return 0;
+}
+#endif // USE_XFT && HAVE_PTHREAD
+
+// fontconfig is only used from one thread at a time
+void waitForPreload() {
+#if defined(USE_XFT) && defined(HAVE_PTHREAD)
+    if (preload_running) {
+        pthread_join(preload_thread, 0);
+        preload_running = false;
+    }
+#endif // USE_XFT && HAVE_PTHREAD
+}
 
 void resetEffects(FbTk::Font& font) {
     font.setHalo(false);
@@ -110,8 +155,17 @@ bool Font::s_multibyte = false;
 bool Font::s_utf8mode = false;
 
 
+void Font::preload() {
+#if defined(USE_XFT) && defined(HAVE_PTHREAD)
+    if (!preload_running)
+        preload_running =
+            pthread_create(&preload_thread, 0, preloadFontconfig, 0) == 0;
+#endif // USE_XFT && HAVE_PTHREAD
+}
+
 void Font::shutdown() {
 
+    waitForPreload();
     FontCacheIt fit;
     for (fit = font_cache.begin(); fit != font_cache.end(); fit++) {
         FontImp* font = fit->second;
@@ -123,6 +177,39 @@ void Font::shutdown() {
             delete font;
         }
     }
+    font_cache.clear();
+    font_refs.clear();
+    RotatedTextCache::freeGCs();
+    lookup_map.clear();
+}
+
+void Font::evictUnused() {
+    FontCacheIt it = font_cache.begin();
+    while (it != font_cache.end()) {
+        FontRefs::iterator ref = font_refs.find(it->second);
+        if (ref != font_refs.end() && ref->second > 0) {
+            ++it;
+            continue;
+        }
+
+        // forget the namelists that resolved to this font
+        StringMapIt lookup = lookup_map.begin();
+        while (lookup != lookup_map.end()) {
+            if (lookup->second == it->first)
+                lookup_map.erase(lookup++);
+            else
+                ++lookup;
+        }
+
+        if (ref != font_refs.end())
+            font_refs.erase(ref);
+        delete it->second;
+        font_cache.erase(it++);
+    }
+}
+
+size_t Font::cacheEntries() {
+    return font_cache.size();
 }
 
 Font::Font(const char *name):
@@ -154,7 +241,37 @@ Font::Font(const char *name):
 
 }
 
+Font::Font(const Font &other):
+    m_fontimp(other.m_fontimp),
+    m_fontstr(other.m_fontstr),
+    m_shadow(other.m_shadow), m_shadow_color(other.m_shadow_color),
+    m_shadow_offx(other.m_shadow_offx), m_shadow_offy(other.m_shadow_offy),
+    m_halo(other.m_halo), m_halo_color(other.m_halo_color) {
+    acquire(m_fontimp);
+}
+
+Font &Font::operator = (const Font &other) {
+    if (this != &other) {
+        setFontImp(other.m_fontimp);
+        m_fontstr = other.m_fontstr;
+        m_shadow = other.m_shadow;
+        m_shadow_color = other.m_shadow_color;
+        m_shadow_offx = other.m_shadow_offx;
+        m_shadow_offy = other.m_shadow_offy;
+        m_halo = other.m_halo;
+        m_halo_color = other.m_halo_color;
+    }
+    return *this;
+}
+
 Font::~Font() {
+    release(m_fontimp);
+}
+
+void Font::setFontImp(FontImp *imp) {
+    acquire(imp);
+    release(m_fontimp);
+    m_fontimp = imp;
 }
 
 bool Font::load(const string &name) {
@@ -169,11 +286,13 @@ bool Font::load(const string &name) {
     if ((lookup_entry = lookup_map.find(name)) != lookup_map.end() &&
             (cache_entry = font_cache.find(lookup_entry->second)) != font_cache.end()) {
         m_fontstr = cache_entry->first;
-        m_fontimp = cache_entry->second;
+        setFontImp(cache_entry->second);
         resetEffects(*this);
         return true;
      }
 
+    StartupProfile::Phase phase("fonts");
+
     // split up the namelist
     typedef list<string> StringList;
     typedef StringList::iterator StringListIt;
@@ -187,7 +306,7 @@ bool Font::load(const string &name) {
 
         if ((cache_entry = font_cache.find(*name_it)) != font_cache.end()) {
             m_fontstr = cache_entry->first;
-            m_fontimp = cache_entry->second;
+            setFontImp(cache_entry->second);
             lookup_map[name] = m_fontstr;
             resetEffects(*this);
             return true;
@@ -213,6 +332,8 @@ bool Font::load(const string &name) {
             if (*name_it == "__DEFAULT__")
                 realname = "monospace";
 
+            waitForPreload();
+
             tmp_font = new XftFontImp(0, s_utf8mode);
         }
 #endif // USE_XFT
@@ -234,7 +355,7 @@ bool Font::load(const string &name) {
 
         if (tmp_font && tmp_font->load(realname.c_str())) {
             lookup_map[name] = (*name_it);
-            m_fontimp = tmp_font;
+            setFontImp(tmp_font);
             font_cache[(*name_it)] = tmp_font;
             m_fontstr = name;
             resetEffects(*this);
@@ -278,17 +399,20 @@ void Font::drawText(const FbDrawable &w, int screen, GC gc,
     if (m_shadow) {
         FbTk::GContext shadow_gc(w);
         shadow_gc.setForeground(m_shadow_color);
+        RequestStats::count(RequestStats::DRAW_TEXT);
         m_fontimp->drawText(w, screen, shadow_gc.gc(), text, len,
                  x + m_shadow_offx, y + m_shadow_offy, orient);
     } else if (m_halo) {
         FbTk::GContext halo_gc(w);
         halo_gc.setForeground(m_halo_color);
+        RequestStats::count(RequestStats::DRAW_TEXT, 4);
         m_fontimp->drawText(w, screen, halo_gc.gc(), text, len, x + 1, y + 1, orient);
         m_fontimp->drawText(w, screen, halo_gc.gc(), text, len, x - 1, y + 1, orient);
         m_fontimp->drawText(w, screen, halo_gc.gc(), text, len, x - 1, y - 1, orient);
         m_fontimp->drawText(w, screen, halo_gc.gc(), text, len, x + 1, y - 1, orient);
     }
 
+    RequestStats::count(RequestStats::DRAW_TEXT);
     m_fontimp->drawText(w, screen, gc, text, len, x, y, orient);
 
 
@@ -43,8 +43,15 @@ class FbDrawable;
 class Font {
 public:
 
+    /// starts initializing fontconfig in the background, the first font
+    /// load waits for it
+    static void preload();
     /// called at FbTk::App destruction time, cleans up cache
     static void shutdown();
+    /// frees the cached fonts no Font uses anymore, e.g. after a style change
+    static void evictUnused();
+    /// @return number of loaded fonts in the cache
+    static size_t cacheEntries();
 
     /// @return true if multibyte is enabled, else false
     static bool multibyte() { return s_multibyte; }
@@ -54,6 +61,8 @@ public:
 
 
     explicit Font(const char *name = "__DEFAULT__");
+    Font(const Font &other);
+    Font &operator = (const Font &other);
     virtual ~Font();
     /**
         Load a font
@@ -115,6 +124,8 @@ public:
     bool hasShadow() const { return m_shadow; }
     bool hasHalo() const { return m_halo; }
 private:
+    /// switches to imp, keeping the reference counts right
+    void setFontImp(FontImp *imp);
 
     FbTk::FontImp* m_fontimp; ///< font implementation
     std::string m_fontstr; ///< font name
@@ -26,6 +26,7 @@
 #include "FbPixmap.hh"
 #include "Color.hh"
 #include "Font.hh"
+#include "MemoryAccount.hh"
 
 namespace FbTk {
 
@@ -37,6 +38,7 @@ GContext::GContext(const FbTk::FbDrawable &drawable):
     if (m_display == 0)
         m_display = drawable.display();
 
+    MemoryAccount::created(MemoryAccount::GCS);
     setGraphicsExposure(false);
 }
 
@@ -46,6 +48,7 @@ GContext::GContext(Drawable drawable):
                    0, 0)) {
     if (m_display == 0)
         m_display = FbTk::App::instance()->display();
+    MemoryAccount::created(MemoryAccount::GCS);
     setGraphicsExposure(false);
 }
 
@@ -55,13 +58,16 @@ GContext::GContext(Drawable d, const GContext &gc):
                    0, 0)) {
     if (m_display == 0)
         m_display = FbTk::App::instance()->display();
+    MemoryAccount::created(MemoryAccount::GCS);
     setGraphicsExposure(false);
     copy(gc);
 }
 
 GContext::~GContext() {
-    if (m_gc)
+    if (m_gc) {
         XFreeGC(m_display, m_gc);
+        MemoryAccount::destroyed(MemoryAccount::GCS);
+    }
 }
 
 /// not implemented!
@@ -0,0 +1,71 @@
+// GlyphAdvances.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#ifndef FBTK_GLYPHADVANCES_HH
+#define FBTK_GLYPHADVANCES_HH
+
+#include "XIDMap.hh"
+
+#include <algorithm>
+
+namespace FbTk {
+
+/**
+   Remembers the advance width of the characters of a font, so that
+   the width of a string can be summed up without asking the font
+   library. Latin-1 lives in a dense table, everything else in a hash.
+ */
+class GlyphAdvances {
+public:
+    GlyphAdvances() { clear(); }
+
+    /// @return advance of character ch or -1 if it isn't known yet
+    int find(unsigned long ch) const {
+        if (ch < DENSE)
+            return m_dense[ch];
+        const int *advance = m_others.find(ch);
+        return advance ? *advance : -1;
+    }
+
+    void insert(unsigned long ch, int advance) {
+        if (ch < DENSE)
+            m_dense[ch] = advance;
+        else
+            m_others.insert(ch, advance);
+    }
+
+    /// forgets all advances, e.g. after loading another font
+    void clear() {
+        std::fill(m_dense, m_dense + DENSE, -1);
+        m_others.clear();
+    }
+
+private:
+    enum { DENSE = 256 };
+
+    int m_dense[DENSE];
+    XIDMap<int> m_others;
+};
+
+} // end namespace FbTk
+
+#endif // FBTK_GLYPHADVANCES_HH
@@ -0,0 +1,310 @@
+// GradientKernels.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "GradientKernels.hh"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define FBTK_GRADIENT_SSE2
+#endif // __SSE2__
+
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define FBTK_GRADIENT_AVX2
+#endif // gcc >= 4.9 on x86
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define FBTK_GRADIENT_NEON
+#endif // __ARM_NEON
+
+namespace FbTk {
+
+namespace GradientKernels {
+
+namespace {
+
+// the scalar versions, also used for the last bytes of a row by the others
+
+void combineScalar(unsigned char *out, const unsigned char *xtab,
+                   unsigned int num, Op op, unsigned char y,
+                   unsigned char base, bool negate) {
+    for (unsigned int i = 0; i < num; ++i) {
+        unsigned char v = xtab[i];
+        if (op == MAX)
+            v = 2 * (v > y ? v : y);
+        else if (op == MIN)
+            v = 2 * (v < y ? v : y);
+        out[i] = negate ? base - v : base + v;
+    }
+}
+
+void darkenScalar(unsigned char *row, unsigned int num) {
+    for (unsigned int i = 0; i < num; ++i)
+        row[i] = (row[i] >> 1) + (row[i] >> 2);
+}
+
+void brightenScalar(unsigned char *row, unsigned int num) {
+    for (unsigned int i = 0; i < num; ++i) {
+        unsigned int c = row[i] + (row[i] >> 3);
+        row[i] = c > 255 ? 255 : c;
+    }
+}
+
+const Impl s_scalar = { "scalar", combineScalar, darkenScalar, brightenScalar };
+
+#ifdef FBTK_GRADIENT_SSE2
+
+// there are no byte shifts in sse2, shift words and mask the bits that
+// came from the neighbour byte
+inline __m128i shiftRight(__m128i v, int bits, __m128i mask) {
+    return _mm_and_si128(_mm_srli_epi16(v, bits), mask);
+}
+
+void combineSSE2(unsigned char *out, const unsigned char *xtab,
+                 unsigned int num, Op op, unsigned char y,
+                 unsigned char base, bool negate) {
+    const __m128i yv = _mm_set1_epi8(static_cast<char>(y));
+    const __m128i bv = _mm_set1_epi8(static_cast<char>(base));
+    unsigned int i = 0;
+    for (; i + 16 <= num; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(xtab + i));
+        if (op == MAX) {
+            v = _mm_max_epu8(v, yv);
+            v = _mm_add_epi8(v, v);
+        } else if (op == MIN) {
+            v = _mm_min_epu8(v, yv);
+            v = _mm_add_epi8(v, v);
+        }
+        v = negate ? _mm_sub_epi8(bv, v) : _mm_add_epi8(bv, v);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), v);
+    }
+    combineScalar(out + i, xtab + i, num - i, op, y, base, negate);
+}
+
+void darkenSSE2(unsigned char *row, unsigned int num) {
+    const __m128i mask1 = _mm_set1_epi8(0x7f);
+    const __m128i mask2 = _mm_set1_epi8(0x3f);
+    unsigned int i = 0;
+    for (; i + 16 <= num; i += 16) {
+        __m128i *p = reinterpret_cast<__m128i *>(row + i);
+        __m128i c = _mm_loadu_si128(p);
+        c = _mm_add_epi8(shiftRight(c, 1, mask1), shiftRight(c, 2, mask2));
+        _mm_storeu_si128(p, c);
+    }
+    darkenScalar(row + i, num - i);
+}
+
+void brightenSSE2(unsigned char *row, unsigned int num) {
+    const __m128i mask3 = _mm_set1_epi8(0x1f);
+    unsigned int i = 0;
+    for (; i + 16 <= num; i += 16) {
+        __m128i *p = reinterpret_cast<__m128i *>(row + i);
+        __m128i c = _mm_loadu_si128(p);
+        _mm_storeu_si128(p, _mm_adds_epu8(c, shiftRight(c, 3, mask3)));
+    }
+    brightenScalar(row + i, num - i);
+}
+
+const Impl s_sse2 = { "sse2", combineSSE2, darkenSSE2, brightenSSE2 };
+
+#endif // FBTK_GRADIENT_SSE2
+
+#ifdef FBTK_GRADIENT_AVX2
+
+#define FBTK_AVX2 __attribute__((target("avx2")))
+
+FBTK_AVX2 inline __m256i shiftRight256(__m256i v, int bits, __m256i mask) {
+    return _mm256_and_si256(_mm256_srli_epi16(v, bits), mask);
+}
+
+FBTK_AVX2 void combineAVX2(unsigned char *out, const unsigned char *xtab,
+                           unsigned int num, Op op, unsigned char y,
+                           unsigned char base, bool negate) {
+    const __m256i yv = _mm256_set1_epi8(static_cast<char>(y));
+    const __m256i bv = _mm256_set1_epi8(static_cast<char>(base));
+    unsigned int i = 0;
+    for (; i + 32 <= num; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(xtab + i));
+        if (op == MAX) {
+            v = _mm256_max_epu8(v, yv);
+            v = _mm256_add_epi8(v, v);
+        } else if (op == MIN) {
+            v = _mm256_min_epu8(v, yv);
+            v = _mm256_add_epi8(v, v);
+        }
+        v = negate ? _mm256_sub_epi8(bv, v) : _mm256_add_epi8(bv, v);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), v);
+    }
+    combineScalar(out + i, xtab + i, num - i, op, y, base, negate);
+}
+
+FBTK_AVX2 void darkenAVX2(unsigned char *row, unsigned int num) {
+    const __m256i mask1 = _mm256_set1_epi8(0x7f);
+    const __m256i mask2 = _mm256_set1_epi8(0x3f);
+    unsigned int i = 0;
+    for (; i + 32 <= num; i += 32) {
+        __m256i *p = reinterpret_cast<__m256i *>(row + i);
+        __m256i c = _mm256_loadu_si256(p);
+        c = _mm256_add_epi8(shiftRight256(c, 1, mask1), shiftRight256(c, 2, mask2));
+        _mm256_storeu_si256(p, c);
+    }
+    darkenScalar(row + i, num - i);
+}
+
+FBTK_AVX2 void brightenAVX2(unsigned char *row, unsigned int num) {
+    const __m256i mask3 = _mm256_set1_epi8(0x1f);
+    unsigned int i = 0;
+    for (; i + 32 <= num; i += 32) {
+        __m256i *p = reinterpret_cast<__m256i *>(row + i);
+        __m256i c = _mm256_loadu_si256(p);
+        _mm256_storeu_si256(p, _mm256_adds_epu8(c, shiftRight256(c, 3, mask3)));
+    }
+    brightenScalar(row + i, num - i);
+}
+
+#undef FBTK_AVX2
+
+const Impl s_avx2 = { "avx2", combineAVX2, darkenAVX2, brightenAVX2 };
+
+#endif // FBTK_GRADIENT_AVX2
+
+#ifdef FBTK_GRADIENT_NEON
+
+void combineNEON(unsigned char *out, const unsigned char *xtab,
+                 unsigned int num, Op op, unsigned char y,
+                 unsigned char base, bool negate) {
+    const uint8x16_t yv = vdupq_n_u8(y);
+    const uint8x16_t bv = vdupq_n_u8(base);
+    unsigned int i = 0;
+    for (; i + 16 <= num; i += 16) {
+        uint8x16_t v = vld1q_u8(xtab + i);
+        if (op == MAX) {
+            v = vmaxq_u8(v, yv);
+            v = vaddq_u8(v, v);
+        } else if (op == MIN) {
+            v = vminq_u8(v, yv);
+            v = vaddq_u8(v, v);
+        }
+        vst1q_u8(out + i, negate ? vsubq_u8(bv, v) : vaddq_u8(bv, v));
+    }
+    combineScalar(out + i, xtab + i, num - i, op, y, base, negate);
+}
+
+void darkenNEON(unsigned char *row, unsigned int num) {
+    unsigned int i = 0;
+    for (; i + 16 <= num; i += 16) {
+        uint8x16_t c = vld1q_u8(row + i);
+        vst1q_u8(row + i, vaddq_u8(vshrq_n_u8(c, 1), vshrq_n_u8(c, 2)));
+    }
+    darkenScalar(row + i, num - i);
+}
+
+void brightenNEON(unsigned char *row, unsigned int num) {
+    unsigned int i = 0;
+    for (; i + 16 <= num; i += 16) {
+        uint8x16_t c = vld1q_u8(row + i);
+        vst1q_u8(row + i, vqaddq_u8(c, vshrq_n_u8(c, 3)));
+    }
+    brightenScalar(row + i, num - i);
+}
+
+const Impl s_neon = { "neon", combineNEON, darkenNEON, brightenNEON };
+
+#endif // FBTK_GRADIENT_NEON
+
+/// available implementations, slowest first
+struct Available {
+    Available(): num(0) {
+        impls[num++] = &s_scalar;
+#ifdef FBTK_GRADIENT_SSE2
+        impls[num++] = &s_sse2;
+#endif // FBTK_GRADIENT_SSE2
+#ifdef FBTK_GRADIENT_AVX2
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            impls[num++] = &s_avx2;
+#endif // FBTK_GRADIENT_AVX2
+#ifdef FBTK_GRADIENT_NEON
+        impls[num++] = &s_neon;
+#endif // FBTK_GRADIENT_NEON
+    }
+
+    const Impl *impls[4];
+    unsigned int num;
+};
+
+const Available &available() {
+    static Available s_available;
+    return s_available;
+}
+
+} // anonymous namespace
+
+void combineRows(const Impl &impl, const Tables &tables,
+                 unsigned int y_begin, unsigned int y_end) {
+    const unsigned int width = tables.width;
+    for (unsigned int y = y_begin; y < y_end; y++) {
+        const int *s = (tables.interlaced && (y & 1)) ? tables.odd_sign : tables.sign;
+        for (unsigned int c = 0; c < 3; c++) {
+            unsigned char *out = tables.out[c] + y * width;
+            unsigned char yval = (unsigned char) tables.ytable[y * 3 + c];
+            unsigned char base;
+            if (tables.op != SUM)
+                base = (unsigned char) tables.to[c];
+            else if (s[c] == 0)
+                base = yval;
+            else
+                base = (unsigned char) (tables.to[c] - s[c] * yval);
+
+            impl.combine(out, tables.xplanes + c * width, width,
+                         tables.op, yval, base, s[c] > 0);
+
+            if (tables.interlaced) {
+                // faked interlacing effect
+                if (y & 1)
+                    impl.darken(out, width);
+                else
+                    impl.brighten(out, width);
+            }
+        }
+    }
+}
+
+const Impl &best() {
+    const Available &avail = available();
+    return *avail.impls[avail.num - 1];
+}
+
+unsigned int count() {
+    return available().num;
+}
+
+const Impl &get(unsigned int index) {
+    const Available &avail = available();
+    return *avail.impls[index < avail.num ? index : 0];
+}
+
+} // end namespace GradientKernels
+
+} // end namespace FbTk
@@ -0,0 +1,86 @@
+// GradientKernels.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#ifndef FBTK_GRADIENTKERNELS_HH
+#define FBTK_GRADIENTKERNELS_HH
+
+namespace FbTk {
+
+/**
+   Row operations of the two-dimensional gradients in TextureRender.
+   Every implementation produces exactly the same bytes as the scalar one,
+   best() picks the fastest one the cpu supports.
+ */
+namespace GradientKernels {
+
+enum Op {
+    SUM, ///< v = x
+    MAX, ///< v = 2 * max(x, y)
+    MIN  ///< v = 2 * min(x, y)
+};
+
+struct Impl {
+    const char *name;
+    /// out[i] = base + v or base - v (if negate), modulo 256, where v is
+    /// calculated from x = xtab[i] and y according to op
+    void (*combine)(unsigned char *out, const unsigned char *xtab,
+                    unsigned int num, Op op, unsigned char y,
+                    unsigned char base, bool negate);
+    /// row[i] = row[i] / 2 + row[i] / 4, the dark lines of interlacing
+    void (*darken)(unsigned char *row, unsigned int num);
+    /// row[i] = min(255, row[i] + row[i] / 8), the bright lines of interlacing
+    void (*brighten)(unsigned char *row, unsigned int num);
+};
+
+/**
+   A two-dimensional gradient before its x and y tables are combined.
+   A sign of 0 adds x and y, otherwise each channel is to - sign * v.
+ */
+struct Tables {
+    bool interlaced;
+    unsigned int width;
+    unsigned char *out[3]; ///< the red, green and blue planes
+    const unsigned char *xplanes; ///< the x table, width bytes per channel
+    const unsigned int *ytable; ///< red, green and blue of each row
+    Op op;
+    const unsigned int *to; ///< red, green and blue
+    const int *sign; ///< per channel
+    const int *odd_sign; ///< of the odd rows, if interlaced
+};
+
+/// fills rows y_begin to y_end - 1 of the planes with 'impl'
+void combineRows(const Impl &impl, const Tables &tables,
+                 unsigned int y_begin, unsigned int y_end);
+
+/// @return fastest implementation for this cpu
+const Impl &best();
+
+/// @return number of implementations usable on this cpu
+unsigned int count();
+/// @return implementation number 'index', 0 is the plain C++ one
+const Impl &get(unsigned int index);
+
+} // end namespace GradientKernels
+
+} // end namespace FbTk
+
+#endif // FBTK_GRADIENTKERNELS_HH
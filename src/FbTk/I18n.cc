@@ -120,6 +120,9 @@ I18n *I18n::instance() {
 }
 
 void I18n::openCatalog(const char *catalog) {
+    m_messages[0].clear();
+    m_messages[1].clear();
+
 #if defined(NLS) && defined(HAVE_CATOPEN)
 
     string catalog_filename = LOCALEPATH;
@@ -166,33 +169,60 @@ void I18n::openCatalog(const char *catalog) {
 }
 
 
+bool I18n::lookup(int set_number, int message_number, bool translate_fb,
+                  FbString &text) const {
+#if defined(NLS) && defined(HAVE_CATGETS)
+    const char *ret = catgets(m_catalog_fd, set_number, message_number, 0);
+    // can't translate, leave it in raw ascii (utf-8 compatible)
+    if (ret == NULL)
+        return false;
+
+    if (!m_utf8_translate && translate_fb)
+        // Local input, UTF-8 output
+        text = FbStringUtil::LocaleStrToFb(ret);
+    else if (m_utf8_translate && !translate_fb)
+        // UTF-8 input, local output
+        text = FbStringUtil::FbStrToLocale(ret);
+    else
+        // UTF-8 input, UTF-8 output OR
+        // local input, local output
+        text = ret;
+    return true;
+#else // !NLS || !HAVE_CATGETS
+    return false;
+#endif // NLS && HAVE_CATGETS
+}
+
 // Translate_FB means it'll become an FbString that goes to X for Fonts, 
 // No translate means it stays in the local encoding, for printing to the
 // console.
 FbString I18n::getMessage(int set_number, int message_number, 
                              const char *default_message, bool translate_fb) const {
 
-#if defined(NLS) && defined(HAVE_CATGETS)
-    if (m_catalog_fd != (nl_catd)-1) {
-        const char *ret = catgets(m_catalog_fd, set_number, message_number, default_message);
-        // can't translate, leave it in raw ascii (utf-8 compatible)
-        if (ret == default_message || ret == NULL)
-            return default_message;
-
-        if (!m_utf8_translate && translate_fb) 
-            // Local input, UTF-8 output
-            return FbStringUtil::LocaleStrToFb(ret);
-        else if (m_utf8_translate && !translate_fb)
-            // UTF-8 input, local output
-            return FbStringUtil::FbStrToLocale(ret);
-        else 
-            // UTF-8 input, UTF-8 output OR
-            // local input, local output
-            return ret;
-    }
-    else
-#endif // NLS && HAVE_CATGETS
+    if (m_catalog_fd == (nl_catd)-1)
         return default_message;
+
+    if (set_number < 0 || message_number < 0) {
+        FbString text;
+        return lookup(set_number, message_number, translate_fb, text) ?
+            text : FbString(default_message);
+    }
+
+    // every message is asked for again and again, so ask the catalog
+    // and convert the encoding only the first time
+    std::vector<Messages> &sets = m_messages[translate_fb ? 1 : 0];
+    if (sets.size() <= (size_t)set_number)
+        sets.resize(set_number + 1);
+    Messages &messages = sets[set_number];
+    if (messages.size() <= (size_t)message_number)
+        messages.resize(message_number + 1);
+    Message &message = messages[message_number];
+    if (!message.looked_up) {
+        message.found = lookup(set_number, message_number, translate_fb,
+                               message.text);
+        message.looked_up = true;
+    }
+    return message.found ? message.text : FbString(default_message);
 }
 
 } // end namespace FbTk
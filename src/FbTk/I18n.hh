@@ -30,6 +30,8 @@
 
 #include "FbString.hh"
 
+#include <vector>
+
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif // HAVE_CONFIG_H
@@ -114,10 +116,24 @@ public:
 private:
     I18n();
     ~I18n();
+
+    /// a message of the catalog, already converted for X or the console
+    struct Message {
+        Message(): looked_up(false), found(false) { }
+        bool looked_up, found;
+        FbString text;
+    };
+    typedef std::vector<Message> Messages;
+
+    /// @return false if the catalog doesn't have the message
+    bool lookup(int set_number, int message_number, bool translate_fb,
+                FbString &text) const;
+
     std::string m_locale;
     bool m_multibyte, m_utf8_translate;
     nl_catd m_catalog_fd;
-
+    /// indexed by set and message number, for the console and for X
+    mutable std::vector<Messages> m_messages[2];
 
 };
 
@@ -32,6 +32,12 @@
 
 namespace FbTk {
 
+/// how TypeAhead matches the typed text
+enum TypeAheadMode {
+    TYPEAHEAD_PREFIX, ///< the strings starting with it
+    TYPEAHEAD_SUBSTRING ///< the strings containing it
+};
+
 // abstract base class providing access and validation
 class ITypeAheadable {
 public:
@@ -0,0 +1,244 @@
+// IconCache.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "IconCache.hh"
+
+#include "FileUtil.hh"
+#include "Image.hh"
+#include "MemoryAccount.hh"
+#include "PixmapWithMask.hh"
+
+#include <climits>
+
+namespace FbTk {
+
+bool IconCache::Key::operator < (const Key &other) const {
+    if (size != other.size)
+        return size < other.size;
+    if (screen_num != other.screen_num)
+        return screen_num < other.screen_num;
+    if (timestamp != other.timestamp)
+        return timestamp < other.timestamp;
+    return filename < other.filename;
+}
+
+bool IconCache::DataKey::operator < (const DataKey &other) const {
+    if (hash != other.hash)
+        return hash < other.hash;
+    if (width != other.width)
+        return width < other.width;
+    if (height != other.height)
+        return height < other.height;
+    return screen_num < other.screen_num;
+}
+
+IconCache &IconCache::instance() {
+    static IconCache cache;
+    return cache;
+}
+
+IconCache::IconCache():
+    m_bytes(0),
+    m_max_bytes(1024 * 1024),
+    m_hits(0),
+    m_misses(0) {
+}
+
+RefCount<PixmapWithMask> IconCache::get(const std::string &filename,
+                                        int screen_num, unsigned int size) {
+    MemoryAccount::Scope account(MemoryAccount::IN_ICON);
+    Key key;
+    key.filename = Image::locateFile(filename);
+    if (key.filename.empty())
+        key.filename = filename;
+    key.timestamp = FileUtil::getLastStatusChangeTimestamp(key.filename.c_str());
+    key.screen_num = screen_num;
+    key.size = size;
+
+    Entries::iterator it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        ++m_hits;
+        m_order.splice(m_order.begin(), m_order, it->second.used);
+        return it->second.icon;
+    }
+
+    ++m_misses;
+    // files that can't be loaded are remembered too, as 0
+    RefCount<PixmapWithMask> icon(Image::load(key.filename, screen_num));
+    size_t bytes = 0;
+    if (icon) {
+        if (size != 0 && (icon->width() != size || icon->height() != size))
+            icon->scale(size, size);
+        bytes = IconCache::bytes(*icon);
+    }
+
+    m_order.push_front(key);
+    Entry &entry = m_entries[key];
+    entry.icon = icon;
+    entry.bytes = bytes;
+    entry.used = m_order.begin();
+    m_bytes += bytes;
+
+    shrink();
+    return icon;
+}
+
+bool IconCache::has(const std::string &path, int screen_num,
+                    unsigned int size) const {
+    Key key;
+    key.filename = path;
+    key.timestamp = FileUtil::getLastStatusChangeTimestamp(path.c_str());
+    key.screen_num = screen_num;
+    key.size = size;
+    if (screen_num >= 0)
+        return m_entries.find(key) != m_entries.end();
+
+    // ordered by size and screen first, the screens of 'size' are in a row
+    key.screen_num = INT_MIN;
+    Entries::const_iterator it = m_entries.lower_bound(key);
+    for (; it != m_entries.end() && it->first.size == size; ++it) {
+        if (it->first.filename == path && it->first.timestamp == key.timestamp)
+            return true;
+    }
+    return false;
+}
+
+RefCount<PixmapWithMask> IconCache::findData(uint64_t hash, unsigned int width,
+                                             unsigned int height, int screen_num) {
+    DataKey key = { hash, width, height, screen_num };
+    DataEntries::iterator it = m_data.find(key);
+    if (it == m_data.end()) {
+        ++m_misses;
+        return RefCount<PixmapWithMask>();
+    }
+
+    ++m_hits;
+    m_data_order.splice(m_data_order.begin(), m_data_order, it->second.used);
+    return it->second.icon;
+}
+
+void IconCache::insertData(uint64_t hash, unsigned int width, unsigned int height,
+                           int screen_num, const RefCount<PixmapWithMask> &icon) {
+    DataKey key = { hash, width, height, screen_num };
+    if (!icon || m_data.find(key) != m_data.end())
+        return;
+
+    m_data_order.push_front(key);
+    DataEntry &entry = m_data[key];
+    entry.icon = icon;
+    entry.bytes = bytes(*icon);
+    entry.used = m_data_order.begin();
+    m_sources[icon->pixmap().drawable()] = key;
+    m_bytes += entry.bytes;
+    // shared by all windows of the application from now on
+    MemoryAccount &account = MemoryAccount::instance();
+    account.setOwner(icon->pixmap().drawable(), MemoryAccount::IN_ICON);
+    account.setOwner(icon->mask().drawable(), MemoryAccount::IN_ICON);
+
+    shrink();
+}
+
+RefCount<PixmapWithMask> IconCache::scaled(const PixmapWithMask &icon,
+                                           unsigned int width, unsigned int height) {
+    MemoryAccount::Scope account(MemoryAccount::IN_ICON);
+    Sources::iterator source = m_sources.find(icon.pixmap().drawable());
+    if (source == m_sources.end())
+        return RefCount<PixmapWithMask>();
+
+    DataEntries::iterator it = m_data.find(source->second);
+    DataEntry &entry = it->second;
+    m_data_order.splice(m_data_order.begin(), m_data_order, entry.used);
+    if (width == entry.icon->width() && height == entry.icon->height())
+        return entry.icon;
+
+    RefCount<PixmapWithMask> variant = entry.variants[std::make_pair(width, height)];
+    if (variant) {
+        ++m_hits;
+        return variant;
+    }
+
+    ++m_misses;
+    variant.reset(new PixmapWithMask());
+    variant->pixmap().copy(entry.icon->pixmap());
+    variant->mask().copy(entry.icon->mask());
+    variant->scale(width, height);
+    entry.variants[std::make_pair(width, height)] = variant;
+
+    size_t variant_bytes = bytes(*variant);
+    entry.bytes += variant_bytes;
+    m_bytes += variant_bytes;
+    // the icon is in use, it stays
+    shrink();
+    return variant;
+}
+
+void IconCache::setMaxBytes(size_t bytes) {
+    m_max_bytes = bytes;
+    shrink();
+}
+
+void IconCache::shrink() {
+    Order::iterator it = m_order.end();
+    while (m_bytes > m_max_bytes && it != m_order.begin()) {
+        --it;
+        Entries::iterator entry = m_entries.find(*it);
+        // freeing icons still in use wouldn't free anything
+        if (entry->second.icon.useCount() > 1)
+            continue;
+        m_bytes -= entry->second.bytes;
+        m_entries.erase(entry);
+        it = m_order.erase(it);
+    }
+
+    DataOrder::iterator data_it = m_data_order.end();
+    while (m_bytes > m_max_bytes && data_it != m_data_order.begin()) {
+        --data_it;
+        DataEntries::iterator entry = m_data.find(*data_it);
+        if (inUse(entry->second))
+            continue;
+        m_bytes -= entry->second.bytes;
+        m_sources.erase(entry->second.icon->pixmap().drawable());
+        m_data.erase(entry);
+        data_it = m_data_order.erase(data_it);
+    }
+}
+
+size_t IconCache::bytes(const PixmapWithMask &icon) {
+    const FbPixmap &pm = icon.pixmap();
+    size_t bytes = pm.width() * pm.height() * ((pm.depth() + 7) / 8);
+    if (icon.mask().drawable() != 0)
+        bytes += icon.mask().height() * ((icon.mask().width() + 7) / 8);
+    return bytes;
+}
+
+bool IconCache::inUse(const DataEntry &entry) {
+    if (entry.icon.useCount() > 1)
+        return true;
+    Variants::const_iterator it = entry.variants.begin();
+    for (; it != entry.variants.end(); ++it) {
+        if (it->second.useCount() > 1)
+            return true;
+    }
+    return false;
+}
+
+} // end namespace FbTk
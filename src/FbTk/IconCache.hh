@@ -0,0 +1,157 @@
+// IconCache.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#ifndef FBTK_ICONCACHE_HH
+#define FBTK_ICONCACHE_HH
+
+#include "NotCopyable.hh"
+#include "RefCount.hh"
+
+#include <sys/types.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#ifdef HAVE_INTTYPES_H
+#include <inttypes.h>
+#else
+#include <stdint.h>
+#endif // HAVE_INTTYPES_H
+
+#include <list>
+#include <map>
+#include <string>
+
+namespace FbTk {
+
+class PixmapWithMask;
+
+/**
+   Shares the icons of menu items and windows and the pixmaps of styles.
+   An image file is loaded and scaled once for each size and screen (and
+   with that, depth) it is asked for, and loaded again only when the file
+   changes. Files are found by their path in the image search path, so
+   styles with pixmaps of the same name don't share them.
+
+   Icons that windows give as data, like _NET_WM_ICON, are found by a hash
+   of that data, so windows of the same application share one pixmap, and
+   each size it is shown at is scaled only once.
+
+   Icons no one uses anymore are kept until the cache grows beyond
+   maxBytes(), then the least recently asked for go first.
+ */
+class IconCache: private NotCopyable {
+public:
+    static IconCache &instance();
+
+    /**
+       @param size the icon is scaled to size x size, 0 keeps the size of
+                   the image
+       @return the image of 'filename', 0 if it can't be loaded
+    */
+    RefCount<PixmapWithMask> get(const std::string &filename,
+                                 int screen_num, unsigned int size);
+
+    /**
+       @param path a file as found by Image::locateFile()
+       @param screen_num < 0 for any screen
+       @return true if get() would find the unchanged file without loading it
+    */
+    bool has(const std::string &path, int screen_num, unsigned int size) const;
+
+    /// @return the icon inserted for this hash of its data, 0 if none
+    RefCount<PixmapWithMask> findData(uint64_t hash, unsigned int width,
+                                      unsigned int height, int screen_num);
+    /// shares 'icon', decoded from data with this hash
+    void insertData(uint64_t hash, unsigned int width, unsigned int height,
+                    int screen_num, const RefCount<PixmapWithMask> &icon);
+    /**
+       @return 'icon' scaled to width x height, scaled only the first time,
+               0 if 'icon' (or a pixmap sharing it) isn't from insertData()
+     */
+    RefCount<PixmapWithMask> scaled(const PixmapWithMask &icon,
+                                    unsigned int width, unsigned int height);
+
+    void setMaxBytes(size_t bytes);
+    size_t maxBytes() const { return m_max_bytes; }
+    /// @return size of the cached pixmaps and masks
+    size_t bytes() const { return m_bytes; }
+    size_t entries() const { return m_entries.size() + m_data.size(); }
+    unsigned long hits() const { return m_hits; }
+    unsigned long misses() const { return m_misses; }
+
+private:
+    IconCache();
+
+    struct Key {
+        std::string filename;
+        time_t timestamp;
+        int screen_num;
+        unsigned int size;
+
+        bool operator < (const Key &other) const;
+    };
+    typedef std::list<Key> Order;
+    struct Entry {
+        RefCount<PixmapWithMask> icon;
+        size_t bytes;
+        Order::iterator used; ///< place in m_order
+    };
+    typedef std::map<Key, Entry> Entries;
+
+    struct DataKey {
+        uint64_t hash;
+        unsigned int width, height;
+        int screen_num;
+
+        bool operator < (const DataKey &other) const;
+    };
+    typedef std::list<DataKey> DataOrder;
+    typedef std::map<std::pair<unsigned int, unsigned int>,
+                     RefCount<PixmapWithMask> > Variants;
+    struct DataEntry {
+        RefCount<PixmapWithMask> icon;
+        Variants variants; ///< scaled copies of the icon, by size
+        size_t bytes; ///< of the icon and its variants
+        DataOrder::iterator used; ///< place in m_data_order
+    };
+    typedef std::map<DataKey, DataEntry> DataEntries;
+    /// the pixmap ids of the icons from data
+    typedef std::map<unsigned long, DataKey> Sources;
+
+    static size_t bytes(const PixmapWithMask &icon);
+    static bool inUse(const DataEntry &entry);
+    void shrink();
+
+    Entries m_entries;
+    Order m_order; ///< the most recently used first
+    DataEntries m_data;
+    DataOrder m_data_order; ///< the most recently used first
+    Sources m_sources;
+    size_t m_bytes, m_max_bytes;
+    unsigned long m_hits, m_misses;
+};
+
+} // end namespace FbTk
+
+#endif // FBTK_ICONCACHE_HH
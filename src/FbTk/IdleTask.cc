@@ -0,0 +1,74 @@
+// IdleTask.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "IdleTask.hh"
+
+#include <algorithm>
+
+namespace FbTk {
+
+IdleTask::Queue IdleTask::s_queue;
+
+IdleTask::IdleTask():
+    m_scheduled(false) {
+}
+
+IdleTask::IdleTask(const RefCount<Slot<void> > &handler):
+    m_handler(handler),
+    m_scheduled(false) {
+}
+
+IdleTask::~IdleTask() {
+    cancel();
+}
+
+void IdleTask::schedule() {
+    if (m_scheduled)
+        return;
+
+    m_scheduled = true;
+    s_queue.push_back(this);
+}
+
+void IdleTask::cancel() {
+    if (!m_scheduled)
+        return;
+
+    m_scheduled = false;
+    s_queue.erase(std::find(s_queue.begin(), s_queue.end(), this));
+}
+
+void IdleTask::runAll() {
+    // a handler may schedule other tasks (or itself), those run next time
+    Queue::size_type count = s_queue.size();
+    while (count-- > 0 && !s_queue.empty()) {
+        IdleTask *task = s_queue.front();
+        s_queue.pop_front();
+        task->m_scheduled = false;
+        // keep the slot alive even if the handler replaces it
+        RefCount<Slot<void> > handler = task->m_handler;
+        if (handler)
+            (*handler)();
+    }
+}
+
+} // end namespace FbTk
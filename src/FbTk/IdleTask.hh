@@ -0,0 +1,74 @@
+// IdleTask.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#ifndef FBTK_IDLETASK_HH
+#define FBTK_IDLETASK_HH
+
+#include "RefCount.hh"
+#include "Slot.hh"
+
+#include <deque>
+
+namespace FbTk {
+
+/**
+   Defers work until the event queue is empty.
+
+   A task is scheduled at most once, no matter how often schedule() is
+   called before it runs, so a widget that keeps a task for its redraw
+   gets repainted only once per burst of events.
+   The main loop calls runAll() whenever XPending() returns zero.
+*/
+class IdleTask {
+public:
+    IdleTask();
+    explicit IdleTask(const RefCount<Slot<void> > &handler);
+    ~IdleTask();
+
+    void setCommand(const RefCount<Slot<void> > &cmd) { m_handler = cmd; }
+    template<typename Functor>
+    void setFunctor(const Functor &functor)
+    { setCommand(RefCount<Slot<void> >(new SlotImpl<Functor, void>(functor))); }
+
+    /// queue the task, does nothing if it is already queued
+    void schedule();
+    /// remove the task from the queue
+    void cancel();
+    bool isScheduled() const { return m_scheduled; }
+
+    /// run the tasks that are queued, tasks scheduled meanwhile wait
+    /// for the next call
+    static void runAll();
+    /// @return true if there are queued tasks
+    static bool pending() { return !s_queue.empty(); }
+
+private:
+    typedef std::deque<IdleTask *> Queue;
+    static Queue s_queue; ///< scheduled tasks, in order of scheduling
+
+    RefCount<Slot<void> > m_handler;
+    bool m_scheduled;
+};
+
+} // end namespace FbTk
+
+#endif // FBTK_IDLETASK_HH
@@ -22,6 +22,8 @@
 #include "Image.hh"
 #include "StringUtil.hh"
 #include "FileUtil.hh"
+#include "IconCache.hh"
+#include "WorkerPool.hh"
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -35,6 +37,13 @@
 #include "ImageImlib2.hh"
 #endif // HAVE_IMLIB2
 
+#ifdef HAVE_CSTDIO
+  #include <cstdio>
+#else
+  #include <stdio.h>
+#endif
+
+#include <algorithm>
 #include <list>
 #include <set>
 
@@ -50,6 +59,8 @@ typedef std::list<std::string> StringList;
 
 ImageMap s_image_map;
 StringList s_search_paths;
+/// the paths locateFile() found, by the names it was given
+std::map<std::string, std::string> s_located;
 
 #ifdef HAVE_IMLIB2
 FbTk::ImageImlib2 imlib2_loader;
@@ -58,6 +69,27 @@ FbTk::ImageImlib2 imlib2_loader;
 FbTk::ImageXPM xpm_loader;
 #endif
 
+/// reads files into the page cache, the image loaders aren't thread safe
+class ReadFiles: public FbTk::WorkerPool::Job {
+public:
+    explicit ReadFiles(const std::vector<string> &paths): m_paths(paths) { }
+
+    void run(unsigned int part, unsigned int parts) {
+        char buffer[16384];
+        for (size_t i = part; i < m_paths.size(); i += parts) {
+            FILE *file = fopen(m_paths[i].c_str(), "rb");
+            if (file == 0)
+                continue;
+            while (fread(buffer, 1, sizeof(buffer), file) == sizeof(buffer))
+                ;
+            fclose(file);
+        }
+    }
+
+private:
+    const std::vector<string> &m_paths;
+};
+
 
 } // end of anonymous namespace
 
@@ -84,18 +116,57 @@ PixmapWithMask *Image::load(const string &filename, int screen_num) {
 }
 
 string Image::locateFile(const string &filename) {
+    std::map<string, string>::const_iterator located = s_located.find(filename);
+    if (located != s_located.end())
+        return located->second;
+
     string path = StringUtil::expandFilename(filename);
-    if (FileUtil::isRegularFile(path.c_str()))
-        return path;
-    string base = StringUtil::basename(filename);
-    StringList::iterator it = s_search_paths.begin();
-    StringList::iterator it_end = s_search_paths.end();
-    for (; it != it_end; ++it) {
-        path = StringUtil::expandFilename(*it) + "/" + base;
-        if (FileUtil::isRegularFile(path.c_str()))
-            return path;
+    if (!FileUtil::isRegularFile(path.c_str())) {
+        string base = StringUtil::basename(filename);
+        StringList::iterator it = s_search_paths.begin();
+        StringList::iterator it_end = s_search_paths.end();
+        for (path.clear(); it != it_end && path.empty(); ++it) {
+            path = StringUtil::expandFilename(*it) + "/" + base;
+            if (!FileUtil::isRegularFile(path.c_str()))
+                path.clear();
+        }
+    }
+    // files that aren't there yet are searched again next time
+    if (!path.empty()) {
+        s_located[filename] = path;
+        s_located[path] = path;
+    }
+    return path;
+}
+
+void Image::prefetch(const std::vector<string> &filenames, int screen_num) {
+    // a new style, or the old one reloaded since its files changed
+    s_located.clear();
+
+    WorkerPool &pool = WorkerPool::instance();
+    if (pool.threads() < 2)
+        return;
+
+    const IconCache &cache = IconCache::instance();
+    set<string> seen;
+    std::vector<string> paths;
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        string filename(filenames[i]);
+        StringUtil::removeFirstWhitespace(filename);
+        StringUtil::removeTrailingWhitespace(filename);
+        string extension(StringUtil::toUpper(StringUtil::findExtension(filename)));
+        if (filename.empty() || s_image_map.find(extension) == s_image_map.end() ||
+            !seen.insert(filename).second)
+            continue;
+        string path = locateFile(filename);
+        if (!path.empty() && !cache.has(path, screen_num, 0))
+            paths.push_back(path);
+    }
+
+    if (paths.size() > 1) {
+        ReadFiles job(paths);
+        pool.run(job, std::min<size_t>(paths.size(), pool.threads()));
     }
-    return "";
 }
 
 bool Image::registerType(const string &type, ImageBase &base) {
@@ -133,14 +204,17 @@ void Image::remove(ImageBase &base) {
 
 void Image::addSearchPath(const string &search_path) {
     s_search_paths.push_back(search_path);
+    s_located.clear();
 }
 
 void Image::removeSearchPath(const string &search_path) {
     s_search_paths.remove(search_path);
+    s_located.clear();
 }
 
 void Image::removeAllSearchPaths() {
     s_search_paths.clear();
+    s_located.clear();
 }
 
 } // end namespace FbTk
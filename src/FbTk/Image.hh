@@ -25,6 +25,7 @@
 #include <string>
 #include <list>
 #include <map>
+#include <vector>
 
 namespace FbTk {
 
@@ -48,8 +49,13 @@ namespace Image {
     void removeSearchPath(const std::string &search_path);
     /// adds a path to search images from
     void removeAllSearchPaths();
-    /// locates an image in the search path
+    /// locates an image in the search path, each name is searched for once
+    /// until the search path changes or the next prefetch()
     std::string locateFile(const std::string &filename);
+    /// reads the image files among 'filenames' in parallel, so loading
+    /// them one after another doesn't wait for the disk each time; files
+    /// the IconCache holds for 'screen_num' (any screen if < 0) are skipped
+    void prefetch(const std::vector<std::string> &filenames, int screen_num);
 }
 
 /// common interface for all image classes
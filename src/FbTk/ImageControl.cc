@@ -29,6 +29,8 @@
 #include "App.hh"
 #include "SimpleCommand.hh"
 #include "I18n.hh"
+#include "RoundTrips.hh"
+#include "MemoryAccount.hh"
 
 //use GNU extensions
 #ifndef _GNU_SOURCE
@@ -55,11 +57,24 @@
   #include <stdio.h>
 #endif
 
+#include <X11/Xutil.h>
+
+#ifdef HAVE_XSHM
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/extensions/XShm.h>
+#endif // HAVE_XSHM
+
+#ifdef HAVE_CSTRING
+  #include <cstring>
+#else
+  #include <string.h>
+#endif
+
 #include <iostream>
 
 using std::cerr;
 using std::endl;
-using std::list;
 
 namespace FbTk {
 
@@ -164,20 +179,101 @@ void allocateUnallocatedColors(std::vector<XColor> colors, Display* dpy, Colorma
 }
 
 
+#ifdef HAVE_XSHM
+
+/// smaller images are cheaper to send than to synchronize for
+const unsigned long SHM_MIN_BYTES = 64 * 1024;
+
+bool s_shm_error = false;
+int s_shm_opcode = 0;
+XErrorHandler s_old_handler = 0;
+
+/// notes errors of MIT-SHM requests, passes on all others
+int handleShmError(Display *disp, XErrorEvent *event) {
+    if (event->request_code == s_shm_opcode) {
+        s_shm_error = true;
+        return 0;
+    }
+    return s_old_handler != 0 ? s_old_handler(disp, event) : 0;
+}
+
+/// MIT-SHM only works if client and server share the memory
+bool isLocalDisplay(Display *disp) {
+    const char *name = DisplayString(disp);
+    return name != 0 && (name[0] == ':' || name[0] == '/' ||
+                         strncmp(name, "unix:", 5) == 0);
+}
+
+#endif // HAVE_XSHM
+
 } // end anonymous namespace
 
+#ifdef HAVE_XSHM
+struct ImageControl::ShmSegment {
+    XShmSegmentInfo info;
+    unsigned long size;
+};
+#else
+struct ImageControl::ShmSegment { };
+#endif // HAVE_XSHM
+
 struct ImageControl::Cache {
     Pixmap pixmap;
     Pixmap texture_pixmap;
     Orientation orient;
     unsigned int count, width, height;
     unsigned long pixel1, pixel2, texture;
+    unsigned long hash; ///< of the fields above, except pixmap and count
+    Cache *next; ///< next entry with the same hash
+    unsigned long bytes; ///< size of pixmap on the server
+    uint64_t released; ///< when count dropped to zero, see FbTime::mono()
+    CacheList::iterator pos; ///< in the cache list, least recently used first
+
+    /// sets the key fields that searchCache compares
+    void setKey(unsigned int w, unsigned int h,
+                const Texture &text, Orientation o) {
+        texture_pixmap = text.pixmap().drawable();
+        orient = o;
+        width = w;
+        height = h;
+        texture = text.type();
+        // colors of pixmap textures don't matter
+        pixel1 = pixel2 = 0l;
+        if (texture_pixmap == None) {
+            pixel1 = text.color().pixel();
+            if (texture & FbTk::Texture::GRADIENT)
+                pixel2 = text.colorTo().pixel();
+        }
+
+        unsigned long values[] = { texture_pixmap, orient, width, height,
+                                   texture, pixel1, pixel2 };
+        hash = 0;
+        for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i)
+            hash = (hash ^ values[i]) * 2654435769UL + (hash >> 16);
+        if (hash == None) // None is no valid key of XIDMap
+            hash = 1;
+    }
+
+    bool sameKey(const Cache &other) const {
+        return texture_pixmap == other.texture_pixmap &&
+            orient == other.orient &&
+            width == other.width &&
+            height == other.height &&
+            texture == other.texture &&
+            pixel1 == other.pixel1 &&
+            pixel2 == other.pixel2;
+    }
 };
 
 ImageControl::ImageControl(int screen_num,
                            int cpc, unsigned long cache_timeout, unsigned long cmax):
     m_colors_per_channel(cpc),
-    m_screen_num(screen_num) {
+    m_screen_num(screen_num),
+    m_stats(),
+    m_shm(0),
+    m_shm_usable(true),
+    m_shm_bytes(0),
+    m_socket_bytes(0) {
 
     Display *disp = FbTk::App::instance()->display();
 
@@ -185,7 +281,9 @@ ImageControl::ImageControl(int screen_num,
     m_visual = DefaultVisual(disp, screen_num);
     m_colormap = DefaultColormap(disp, screen_num);
 
-    cache_max = cmax;
+    m_cache_budget = cmax * 1024;
+    m_cache_bytes = 0;
+    m_cache_life = static_cast<uint64_t>(cache_timeout) * FbTime::IN_MILLISECONDS;
 
     if (cache_timeout && s_timed_cache) {
         m_timer.setTimeout(cache_timeout);
@@ -202,6 +300,8 @@ ImageControl::~ImageControl() {
 
     Display *disp = FbTk::App::instance()->display();
 
+    releaseShm();
+
     if (!m_colors.empty()) {
         std::vector<unsigned long> pixels(m_colors.size());
 
@@ -215,7 +315,7 @@ ImageControl::~ImageControl() {
         CacheList::iterator it = cache.begin();
         CacheList::iterator it_end = cache.end();
         for (; it != it_end; ++it) {
-            XFreePixmap(disp, (*it)->pixmap);
+            MemoryAccount::freePixmap(disp, (*it)->pixmap);
             delete (*it);
         }
     }
@@ -225,54 +325,82 @@ ImageControl::~ImageControl() {
 Pixmap ImageControl::searchCache(unsigned int width, unsigned int height,
                                  const Texture &text, FbTk::Orientation orient) const {
 
-    if (text.pixmap().drawable() != None) {
-        // do comparsion with width/height and texture_pixmap
-        CacheList::iterator it = cache.begin();
-        CacheList::iterator it_end = cache.end();
-        for (; it != it_end; ++it) {
-            if ((*it)->texture_pixmap == text.pixmap().drawable() &&
-                (*it)->orient == orient &&
-                (*it)->width == width &&
-                (*it)->height == height &&
-                (*it)->texture == text.type()) {
-                (*it)->count++;
-                return (*it)->pixmap;
-            }
+    Cache key;
+    key.setKey(width, height, text, orient);
+
+    Cache *entry = m_cache_index.get(key.hash);
+    for (; entry != 0; entry = entry->next) {
+        if (entry->sameKey(key)) {
+            entry->count++;
+            // move it to the most recently used end
+            cache.splice(cache.end(), cache, entry->pos);
+            return entry->pixmap;
+        }
+    }
+
+    return None;
+}
+
+void ImageControl::addCache(Cache *entry) {
+    entry->next = m_cache_index.get(entry->hash);
+    m_cache_index.insert(entry->hash, entry);
+    m_cache_pixmaps.insert(entry->pixmap, entry);
+    entry->pos = cache.insert(cache.end(), entry);
+    m_cache_bytes += entry->bytes;
+}
+
+void ImageControl::unindexCache(Cache *entry) {
+    m_cache_pixmaps.erase(entry->pixmap);
+
+    Cache **link = m_cache_index.find(entry->hash);
+    if (link == 0)
+        return;
+    if (*link == entry) {
+        if (entry->next != 0)
+            *link = entry->next;
+        else
+            m_cache_index.erase(entry->hash);
+        return;
+    }
+    for (Cache *prev = *link; prev->next != 0; prev = prev->next) {
+        if (prev->next == entry) {
+            prev->next = entry->next;
+            return;
         }
-        return None;
     }
+}
 
-    /*    Cache tmp;
-    tmp.texture_pixmap = text.pixmap().drawable();
-    tmp.width = width;
-    tmp.height = height;
-    tmp.texture = text.type();
-    tmp.pixel1 = text.color().pixel();
-    tmp.pixel2 = text.colorTo().pixel();
-    */
+void ImageControl::freeCache(Cache *entry) {
+    unindexCache(entry);
+    cache.erase(entry->pos);
+    m_cache_bytes -= entry->bytes;
+    MemoryAccount::freePixmap(FbTk::App::instance()->display(), entry->pixmap);
+    delete entry;
+}
 
+void ImageControl::trimCache() {
+    const MemoryAccount &account = MemoryAccount::instance();
     CacheList::iterator it = cache.begin();
-    CacheList::iterator it_end = cache.end();
-    for (; it != it_end; ++it) {
-        if (((*it)->width == width) &&
-            ((*it)->orient == orient) &&
-            ((*it)->height == height) &&
-            ((*it)->texture == text.type()) &&
-            ((*it)->pixel1 == text.color().pixel())) {
-            if (text.type() & FbTk::Texture::GRADIENT) {
-                if ((*it)->pixel2 == text.colorTo().pixel()) {
-                    (*it)->count++;
-                    return (*it)->pixmap;
-                }
-            } else {
-                (*it)->count++;
-                return (*it)->pixmap;
-            }
+    while ((m_cache_bytes > m_cache_budget || account.overBudget()) &&
+           it != cache.end()) {
+        Cache *entry = *it;
+        ++it;
+        if (entry->count == 0) {
+            freeCache(entry);
+            ++m_stats.evictions;
         }
     }
+}
 
-    return None;
+void ImageControl::addRender(RenderKind kind, unsigned long pixels, uint64_t usec) {
+    ++m_stats.renders[kind];
+    m_stats.render_usec[kind] += usec;
+    m_stats.rendered_bytes += static_cast<uint64_t>(pixels) * bits_per_pixel / 8;
+}
 
+const char *ImageControl::renderKindName(RenderKind kind) {
+    static const char *names[NUM_RENDER_KINDS] = { "pixmap", "solid", "gradient" };
+    return names[kind];
 }
 
 
@@ -293,10 +421,12 @@ Pixmap ImageControl::renderImage(unsigned int width, unsigned int height,
     // search cache first
     Pixmap pixmap = searchCache(width, height, texture, orient);
     if (pixmap) {
+        ++m_stats.hits;
         return pixmap; // return cache item
     }
 
     // render new image
+    ++m_stats.misses;
 
     TextureRender image(*this, width, height, orient);
     pixmap = image.render(texture);
@@ -307,23 +437,13 @@ Pixmap ImageControl::renderImage(unsigned int width, unsigned int height,
         Cache *tmp = new Cache;
 
         tmp->pixmap = pixmap;
-        tmp->texture_pixmap = texture.pixmap().drawable();
-        tmp->orient = orient;
-        tmp->width = width;
-        tmp->height = height;
         tmp->count = 1;
-        tmp->texture = texture.type();
-        tmp->pixel1 = texture.color().pixel();
-
-        if (texture.type() & FbTk::Texture::GRADIENT)
-            tmp->pixel2 = texture.colorTo().pixel();
-        else
-            tmp->pixel2 = 0l;
-
-        cache.push_back(tmp);
+        tmp->setKey(width, height, texture, orient);
+        tmp->bytes = width * height * static_cast<unsigned long>(bits_per_pixel) / 8;
+        tmp->released = 0;
 
-        if (cache.size() > cache_max)
-            cleanCache();
+        addCache(tmp);
+        trimCache();
 
         return pixmap;
     }
@@ -336,26 +456,162 @@ void ImageControl::removeImage(Pixmap pixmap) {
     if (!pixmap)
         return;
 
-    CacheList::iterator it = cache.begin();
-    CacheList::iterator it_end = cache.end();
-    for (; it != it_end; ++it) {
-        if ((*it)->pixmap == pixmap) {
-            if ((*it)->count) {
-                (*it)->count--;
-                if (s_timed_cache) {
-                    cleanCache();
-                    return;
-                }
-            }
+    Cache *entry = m_cache_pixmaps.get(pixmap);
+    if (entry == 0)
+        return;
+
+    if (entry->count > 0 && --entry->count == 0) {
+        // keep it around for reuse, as long as the budget allows
+        entry->released = FbTime::mono();
+        trimCache();
+    }
+}
 
-            if ((*it)->count <= 0)
-                cleanCache();
 
-            return;
+XImage *ImageControl::createImage(unsigned int width, unsigned int height) {
+    Display *disp = FbTk::App::instance()->display();
+
+#ifdef HAVE_XSHM
+    if (m_shm_usable) {
+        XImage *image = XShmCreateImage(disp, m_visual, m_screen_depth, ZPixmap,
+                                        0, 0, width, height);
+        if (image != 0) {
+            unsigned long size = image->bytes_per_line * height;
+            if (size >= SHM_MIN_BYTES && reserveShm(size)) {
+                image->obdata = reinterpret_cast<char *>(&m_shm->info);
+                image->data = m_shm->info.shmaddr;
+                return image;
+            }
+            XDestroyImage(image);
         }
     }
+#endif // HAVE_XSHM
+
+    XImage *image = XCreateImage(disp, m_visual, m_screen_depth, ZPixmap, 0, 0,
+                                 width, height, 32, 0);
+    if (image != 0)
+        image->data = new char[image->bytes_per_line * (height + 1)];
+    return image;
+}
+
+void ImageControl::putImage(Drawable drawable, XImage *image) {
+    Display *disp = FbTk::App::instance()->display();
+    GC gc = DefaultGC(disp, m_screen_num);
+    unsigned long size = image->bytes_per_line * image->height;
+
+#ifdef HAVE_XSHM
+    if (m_shm != 0 && image->data == m_shm->info.shmaddr) {
+        XShmPutImage(disp, drawable, gc, image, 0, 0, 0, 0,
+                     image->width, image->height, False);
+        // the server reads the segment later, wait before it is reused
+        FBTK_ROUNDTRIP("ImageControl::putImage");
+        XSync(disp, False);
+        m_shm_bytes += size;
+        destroyImage(image);
+        return;
+    }
+#endif // HAVE_XSHM
+
+    XPutImage(disp, drawable, gc, image, 0, 0, 0, 0,
+              image->width, image->height);
+    m_socket_bytes += size;
+    destroyImage(image);
 }
 
+void ImageControl::destroyImage(XImage *image) {
+    if (image == 0)
+        return;
+
+    bool in_shm = false;
+#ifdef HAVE_XSHM
+    in_shm = m_shm != 0 && image->data == m_shm->info.shmaddr;
+#endif // HAVE_XSHM
+
+    if (!in_shm)
+        delete [] image->data;
+    image->data = 0;
+    XDestroyImage(image);
+}
+
+bool ImageControl::reserveShm(unsigned long size) {
+#ifdef HAVE_XSHM
+    if (m_shm != 0 && m_shm->size >= size)
+        return true;
+
+    Display *disp = FbTk::App::instance()->display();
+    int event_base, error_base;
+    if (m_shm == 0 && (!isLocalDisplay(disp) ||
+                       !XQueryExtension(disp, "MIT-SHM", &s_shm_opcode,
+                                        &event_base, &error_base))) {
+        m_shm_usable = false;
+        return false;
+    }
+
+    releaseShm();
+
+    // grow in big steps, so that a few sizes are enough for all textures
+    unsigned long new_size = 256 * 1024;
+    while (new_size < size)
+        new_size *= 2;
+
+    ShmSegment *shm = new ShmSegment;
+    shm->size = new_size;
+    shm->info.shmid = shmget(IPC_PRIVATE, new_size, IPC_CREAT | 0600);
+    if (shm->info.shmid < 0) {
+        delete shm;
+        m_shm_usable = false;
+        return false;
+    }
+    shm->info.shmaddr = static_cast<char *>(shmat(shm->info.shmid, 0, 0));
+    shm->info.readOnly = True;
+    if (shm->info.shmaddr == reinterpret_cast<char *>(-1)) {
+        shmctl(shm->info.shmid, IPC_RMID, 0);
+        delete shm;
+        m_shm_usable = false;
+        return false;
+    }
+
+    // attaching fails with an X error, for example when the server can't
+    // reach our memory
+    s_shm_error = false;
+    s_old_handler = XSetErrorHandler(handleShmError);
+    XShmAttach(disp, &shm->info);
+    FBTK_ROUNDTRIP("ImageControl::reserveShm");
+    XSync(disp, False);
+    XSetErrorHandler(s_old_handler);
+    s_old_handler = 0;
+
+    // the segment goes away once both sides have detached
+    shmctl(shm->info.shmid, IPC_RMID, 0);
+
+    if (s_shm_error) {
+        shmdt(shm->info.shmaddr);
+        delete shm;
+        m_shm_usable = false;
+        return false;
+    }
+
+    m_shm = shm;
+    return true;
+#else
+    return false;
+#endif // HAVE_XSHM
+}
+
+void ImageControl::releaseShm() {
+#ifdef HAVE_XSHM
+    if (m_shm == 0)
+        return;
+
+    Display *disp = FbTk::App::instance()->display();
+    XShmDetach(disp, &m_shm->info);
+    FBTK_ROUNDTRIP("ImageControl::releaseShm");
+    XSync(disp, False);
+    shmdt(m_shm->info.shmaddr);
+#endif // HAVE_XSHM
+    delete m_shm;
+    m_shm = 0;
+}
 
 void ImageControl::colorTables(const unsigned char **rmt, const unsigned char **gmt,
                                const unsigned char **bmt,
@@ -419,26 +675,16 @@ void ImageControl::installRootColormap() {
 
 
 void ImageControl::cleanCache() {
-    Display *disp = FbTk::App::instance()->display();
-    list<CacheList::iterator> deadlist;
+    uint64_t now = FbTime::mono();
     CacheList::iterator it = cache.begin();
-    CacheList::iterator it_end = cache.end();
-    for (; it != it_end; ++it) {
-        Cache *tmp = (*it);
-        if (tmp->count <= 0) {
-            XFreePixmap(disp, tmp->pixmap);
-            deadlist.push_back(it);
-            delete tmp;
-            tmp=0;
+    while (it != cache.end()) {
+        Cache *entry = *it;
+        ++it;
+        if (entry->count == 0 && now - entry->released >= m_cache_life) {
+            freeCache(entry);
+            ++m_stats.expired;
         }
     }
-
-    list<CacheList::iterator>::iterator dead_it = deadlist.begin();
-    list<CacheList::iterator>::iterator dead_it_end = deadlist.end();
-    for (; dead_it != dead_it_end; ++dead_it) {
-        cache.erase(*dead_it);
-    }
-
 }
 
 void ImageControl::createColorTable() {
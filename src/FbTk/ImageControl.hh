@@ -27,7 +27,10 @@
 
 #include "Orientation.hh"
 #include "Timer.hh"
+#include "FbTime.hh"
 #include "NotCopyable.hh"
+#include "MemoryAccount.hh"
+#include "XIDMap.hh"
 
 #include <X11/Xlib.h> // for Visual* etc
 
@@ -39,8 +42,13 @@ namespace FbTk {
 class Texture;
 
 /// Holds screen info, color tables and caches textures
-class ImageControl: private NotCopyable {
+class ImageControl: public MemoryAccount::Reclaimable, private NotCopyable {
 public:
+    /**
+       @param cache_timeout milliseconds an unused pixmap may stay in the cache
+       @param cache_max KB of pixmap memory the cache may hold, unused
+                        pixmaps are freed least recently used first
+    */
     ImageControl(int screen_num, int colors_per_channel = 4,
                   unsigned long cache_timeout = 300000l, unsigned long cache_max = 200l);
     virtual ~ImageControl();
@@ -73,7 +81,51 @@ public:
     void getGradientBuffers(unsigned int, unsigned int,
                             unsigned int **, unsigned int **);
 
+    /// frees unused pixmaps that are older than the cache timeout
     void cleanCache();
+    /// frees unused pixmaps while we are over the pixmap budget
+    void reclaim() { trimCache(); }
+
+    /**
+       Creates an image of the screen's depth and visual to render into.
+       Big images are placed in a shared memory segment when the X server
+       is local and supports MIT-SHM.
+       @return image with allocated data, give it to putImage or destroyImage
+    */
+    XImage *createImage(unsigned int width, unsigned int height);
+    /// uploads an image from createImage to drawable and destroys it
+    void putImage(Drawable drawable, XImage *image);
+    /// destroys an image from createImage
+    void destroyImage(XImage *image);
+
+    /// @return bytes uploaded through shared memory
+    unsigned long shmBytes() const { return m_shm_bytes; }
+    /// @return bytes uploaded through the connection to the X server
+    unsigned long socketBytes() const { return m_socket_bytes; }
+
+    /// @return number of cached pixmaps
+    size_t cacheEntries() const { return cache.size(); }
+    /// @return bytes of server memory used by cached pixmaps
+    unsigned long cacheBytes() const { return m_cache_bytes; }
+
+    /// what TextureRender rendered
+    enum RenderKind { RENDER_PIXMAP, RENDER_SOLID, RENDER_GRADIENT, NUM_RENDER_KINDS };
+
+    /// counters since start, for tuning the cache resources
+    struct Stats {
+        unsigned long hits;      ///< renderImage calls answered from the cache
+        unsigned long misses;    ///< renderImage calls that had to render
+        unsigned long evictions; ///< unused pixmaps freed for the budget
+        unsigned long expired;   ///< unused pixmaps freed after the cache life
+        unsigned long renders[NUM_RENDER_KINDS];
+        uint64_t render_usec[NUM_RENDER_KINDS];
+        uint64_t rendered_bytes;
+    };
+    const Stats &stats() const { return m_stats; }
+    /// called by TextureRender for each texture it rendered
+    void addRender(RenderKind kind, unsigned long pixels, uint64_t usec);
+    /// @return readable name of the kind
+    static const char *renderKindName(RenderKind kind);
 private:
     /** 
         Search cache for a specific pixmap
@@ -81,6 +133,17 @@ private:
     */
     Pixmap searchCache(unsigned int width, unsigned int height, const Texture &text, Orientation orient) const;
 
+    struct Cache;
+    /// add entry to the cache list and the indices
+    void addCache(Cache *entry);
+    /// remove entry from the indices, the caller removes it from the list
+    void unindexCache(Cache *entry);
+    /// free the pixmap of an unused entry and forget about it
+    void freeCache(Cache *entry);
+    /// free least recently used pixmaps until the cache fits into its
+    /// budget, and we into the pixmap budget
+    void trimCache();
+
     void createColorTable();
     bool m_dither;
     Timer m_timer;
@@ -106,11 +169,26 @@ private:
     std::vector<unsigned int> grad_xbuffer;
     std::vector<unsigned int> grad_ybuffer;
 
-    struct Cache;
     typedef std::list<Cache *> CacheList;
 
     mutable CacheList cache;
-    unsigned long cache_max;
+    /// entries by hash of their key, collisions are chained in Cache::next
+    XIDMap<Cache *> m_cache_index;
+    /// entries by their rendered pixmap, for removeImage
+    XIDMap<Cache *> m_cache_pixmaps;
+    unsigned long m_cache_budget; ///< in bytes
+    unsigned long m_cache_bytes; ///< bytes of all cached pixmaps
+    uint64_t m_cache_life; ///< in micro-seconds
+    Stats m_stats;
+
+    struct ShmSegment;
+    /// @return true if the shared memory segment can hold size bytes
+    bool reserveShm(unsigned long size);
+    void releaseShm();
+
+    ShmSegment *m_shm; ///< reused for all uploads, grows when needed
+    bool m_shm_usable; ///< false after MIT-SHM failed once
+    unsigned long m_shm_bytes, m_socket_bytes;
 };
 
 } // end namespace FbTk
@@ -69,7 +69,8 @@ KeyUtil &KeyUtil::instance() {
 
 
 KeyUtil::KeyUtil()
-    : m_modmap(0), m_numlock(0), m_scrolllock(0)
+    : m_modmap(0), m_numlock(0), m_scrolllock(0),
+      m_clean_mask((1<<13) - 1), m_num_lock_variants(0)
 {
     init();
 }
@@ -88,6 +89,8 @@ void KeyUtil::loadModmap() {
         XFreeModifiermap(m_modmap);
 
     m_modmap = XGetModifierMapping(App::instance()->display());
+    m_numlock = m_scrolllock = 0;
+    memset(m_keycode_mods, 0, sizeof(m_keycode_mods));
 
     // find modifiers and set them
     for (int i=0, realkey=0; i<8; ++i) {
@@ -96,6 +99,10 @@ void KeyUtil::loadModmap() {
             if (m_modmap->modifiermap[realkey] == 0)
                 continue;
 
+            // the first modifier wins, as in the search this replaces
+            if (m_keycode_mods[m_modmap->modifiermap[realkey]] == 0)
+                m_keycode_mods[m_modmap->modifiermap[realkey]] = modlist[i].mask;
+
             KeySym ks = XKeycodeToKeysym(App::instance()->display(),
                     m_modmap->modifiermap[realkey], 0);
 
@@ -112,6 +119,20 @@ void KeyUtil::loadModmap() {
             }
         }
     }
+
+    m_clean_mask = ~(capslock() | numlock() | scrolllock()) & ((1<<13) - 1);
+
+    // without numlock or scrolllock, several combinations are the same
+    m_num_lock_variants = 0;
+    for (int i = 0; i < 8; i++) {
+        unsigned int variant = (i & 1 ? LockMask : 0) |
+            (i & 2 ? m_numlock : 0) | (i & 4 ? m_scrolllock : 0);
+        int v = 0;
+        while (v < m_num_lock_variants && m_lock_variants[v] != variant)
+            ++v;
+        if (v == m_num_lock_variants)
+            m_lock_variants[m_num_lock_variants++] = variant;
+    }
 }
 
 
@@ -121,13 +142,11 @@ void KeyUtil::loadModmap() {
 */
 void KeyUtil::grabKey(unsigned int key, unsigned int mod, Window win) {
     Display *display = App::instance()->display();
-    const unsigned int nummod = instance().numlock();
-    const unsigned int scrollmod = instance().scrolllock();
+    const KeyUtil &keyutil = instance();
 
     // Grab with numlock, capslock and scrlock
-    for (int i = 0; i < 8; i++) {
-        XGrabKey(display, key, mod | (i & 1 ? LockMask : 0) |
-                 (i & 2 ? nummod : 0) | (i & 4 ? scrollmod : 0),
+    for (int i = 0; i < keyutil.m_num_lock_variants; i++) {
+        XGrabKey(display, key, mod | keyutil.m_lock_variants[i],
                  win, True, GrabModeAsync, GrabModeAsync);
     }
 
@@ -136,13 +155,11 @@ void KeyUtil::grabKey(unsigned int key, unsigned int mod, Window win) {
 void KeyUtil::grabButton(unsigned int button, unsigned int mod, Window win,
                          unsigned int event_mask, Cursor cursor) {
     Display *display = App::instance()->display();
-    const unsigned int nummod = instance().numlock();
-    const unsigned int scrollmod = instance().scrolllock();
+    const KeyUtil &keyutil = instance();
 
     // Grab with numlock, capslock and scrlock
-    for (int i = 0; i < 8; i++) {
-        XGrabButton(display, button, mod | (i & 1 ? LockMask : 0) |
-                    (i & 2 ? nummod : 0) | (i & 4 ? scrollmod : 0),
+    for (int i = 0; i < keyutil.m_num_lock_variants; i++) {
+        XGrabButton(display, button, mod | keyutil.m_lock_variants[i],
                     win, False, event_mask, GrabModeAsync, GrabModeAsync,
                     None, cursor);
     }
@@ -196,24 +213,19 @@ void KeyUtil::ungrabButtons(Window win) {
     XUngrabButton(display, AnyButton, AnyModifier, win);
 }
 
-unsigned int KeyUtil::keycodeToModmask(unsigned int keycode) {
-    XModifierKeymap *modmap = instance().m_modmap;
+void KeyUtil::ungrabKey(unsigned int key, unsigned int mod, Window win) {
+    Display *display = App::instance()->display();
+    const KeyUtil &keyutil = instance();
 
-    if (!modmap)
-        return 0;
+    for (int i = 0; i < keyutil.m_num_lock_variants; i++)
+        XUngrabKey(display, key, mod | keyutil.m_lock_variants[i], win);
+}
 
-    // search through modmap for this keycode
-    for (int mod=0; mod < 8; mod++) {
-        for (int key=0; key < modmap->max_keypermod; ++key) {
-            // modifiermap is an array with 8 sets of keycodes
-            // each max_keypermod long, but in a linear array.
-            if (modmap->modifiermap[modmap->max_keypermod*mod + key] == keycode) {
-                return modlist[mod].mask;
-            }
-        }
-    }
-    // no luck
-    return 0;
+unsigned int KeyUtil::keycodeToModmask(unsigned int keycode) {
+    // keycodes are 8 bit, the table is filled from the modifier map
+    if (keycode >= sizeof(instance().m_keycode_mods))
+        return 0;
+    return instance().m_keycode_mods[keycode];
 }
 
 
@@ -60,22 +60,24 @@ public:
      */
     static void ungrabKeys(Window win);
     static void ungrabButtons(Window win);
+    /// ungrabs what grabKey() grabbed
+    static void ungrabKey(unsigned int key, unsigned int mod, Window win);
 
     /** 
         Strip out modifiers we want to ignore
         @return the cleaned state number
     */
-    unsigned int cleanMods(unsigned int mods) {
+    unsigned int cleanMods(unsigned int mods) const {
         // remove numlock, capslock, and scrolllock
         // and anything beyond Button5Mask
-        return mods & ~(capslock() | numlock() | scrolllock()) & ((1<<13) - 1);
+        return mods & m_clean_mask;
     }
 
     /** 
        strip away everything which is actually not a modifier
        eg, xkb-keyboardgroups are encoded as bit 13 and 14
     */
-    unsigned int isolateModifierMask(unsigned int mods) {
+    unsigned int isolateModifierMask(unsigned int mods) const {
         return mods & (ShiftMask|LockMask|ControlMask|Mod1Mask|Mod2Mask|Mod3Mask|Mod4Mask|Mod5Mask); 
     }
 
@@ -93,6 +95,14 @@ private:
 
     XModifierKeymap *m_modmap;
     int m_numlock, m_scrolllock;
+
+    // all derived from the modifier mapping, so they're only computed when
+    // it changes
+    unsigned int m_clean_mask; ///< what cleanMods() keeps
+    /// the combinations of the lock modifiers a grab has to cover
+    unsigned int m_lock_variants[8];
+    int m_num_lock_variants;
+    unsigned char m_keycode_mods[256]; ///< keycodeToModmask() by keycode
     static std::auto_ptr<KeyUtil> s_keyutil;
 };
 
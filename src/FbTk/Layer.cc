@@ -83,6 +83,41 @@ void restack(const FbTk::Layer::ItemList& items, LayerItem* temp_raised) {
         XRestackWindows(FbTk::App::instance()->display(), &stack[0], stack.size());
 }
 
+/**
+ * Stacks @stack, highest first, right above @sibling with sibling relative
+ * requests, this doesn't touch any other window.
+ */
+void stackAbove(std::vector<Window> &stack, Window sibling) {
+
+    Display *disp = FbTk::App::instance()->display();
+    XWindowChanges changes;
+    changes.sibling = sibling;
+    changes.stack_mode = Above;
+    XConfigureWindow(disp, stack[0], CWSibling | CWStackMode, &changes);
+
+    // the rest goes right below the first one
+    if (stack.size() > 1)
+        XRestackWindows(disp, &stack[0], stack.size());
+}
+
+/// @return the highest window of the items other than @item, or 0
+Window topWindow(const FbTk::Layer::ItemList &items, const LayerItem &item) {
+    FbTk::Layer::ItemList::const_iterator it = items.begin();
+    FbTk::Layer::ItemList::const_iterator it_end = items.end();
+    for (; it != it_end; ++it) {
+        if (*it == &item)
+            continue;
+
+        LayerItem::Windows::const_iterator win = (*it)->getWindows().begin();
+        LayerItem::Windows::const_iterator win_end = (*it)->getWindows().end();
+        for (; win != win_end; ++win) {
+            if ((*win)->window())
+                return (*win)->window();
+        }
+    }
+    return 0;
+}
+
 } // end of anonymous namespace
 
 
@@ -91,7 +126,7 @@ void Layer::restack(const std::vector<Layer*>& layers) {
     std::vector<Window> stack;
     std::vector<Layer*>::const_iterator l;
     for (l = layers.begin(); l != layers.end(); ++l) {
-        extract_windows_to_stack((*l)->itemList(), 0, stack);
+        extract_windows_to_stack((*l)->m_items, 0, stack);
     }
 
     if (!stack.empty())
@@ -108,17 +143,17 @@ Layer::~Layer() {
 
 void Layer::restack() {
     if (m_manager.isUpdatable()) {
-        ::restack(itemList(), 0);
+        ::restack(m_items, 0);
         m_needs_restack = false;
     }
 }
 
 void Layer::restackAndTempRaise(LayerItem &item) {
-    ::restack(itemList(), &item);
+    ::restack(m_items, &item);
 }
 
 int Layer::countWindows() {
-    return ::count_windows(itemList());
+    return ::count_windows(m_items);
 }
 
 
@@ -127,24 +162,34 @@ void Layer::stackBelowItem(LayerItem &item, LayerItem *above) {
     if (!m_manager.isUpdatable())
         return;
 
-    // if there are no windows provided for above us,
-    // then we must restack the entire layer
-    // we can't do XRaiseWindow because a restack then causes OverrideRedirect
-    // windows to get pushed to the bottom
-    if (!above || m_needs_restack) { // must need to go right to top
+    if (m_needs_restack) {
         restack();
         return;
     }
 
     std::vector<Window> stack;
+    extract_windows_to_stack(item.getWindows(), stack);
+    if (stack.empty()) // nothing to stack
+        return;
+
+    // if there are no windows provided for above us, we go right above the
+    // highest window of this layer, and only restack the entire layer if
+    // there is none
+    // we can't do XRaiseWindow because a restack then causes OverrideRedirect
+    // windows to get pushed to the bottom
+    if (!above) { // must need to go right to top
+        Window sibling = topWindow(m_items, item);
+        if (sibling)
+            stackAbove(stack, sibling);
+        else
+            restack();
+        return;
+    }
 
     // We do have a window to stack below
     // so we put it on top, and fill the rest of the array with the ones to go below it.
     // assume that above's window exists
-    stack.push_back(above->getWindows().back()->window());
-
-    // fill the rest of the array
-    extract_windows_to_stack(item.getWindows(), stack);
+    stack.insert(stack.begin(), above->getWindows().back()->window());
 
     XRestackWindows(FbTk::App::instance()->display(), &stack[0], stack.size());
 }
@@ -152,7 +197,7 @@ void Layer::stackBelowItem(LayerItem &item, LayerItem *above) {
 // We can't just use Restack here, because it won't do anything if they're
 // already in the same relative order excluding other windows
 void Layer::alignItem(LayerItem &item) {
-    if (itemList().front() == &item) {
+    if (m_items.front() == &item) {
         stackBelowItem(item, m_manager.getLowestItemAboveLayer(m_layernum));
         return;
     }
@@ -160,17 +205,16 @@ void Layer::alignItem(LayerItem &item) {
     // Note: some other things effectively assume that the window list is
     // sorted from highest to lowest
     // get our item
-    iterator myit = std::find(itemList().begin(), itemList().end(), &item);
-    iterator it = myit;
+    iterator it = item.m_layer_pos;
 
     // go to the one above it in our layer (top is front, so we decrement)
     --it;
 
     // keep going until we find one that is currently visible to the user
-    while (it != itemList().begin() && !(*it)->visible())
+    while (it != m_items.begin() && !(*it)->visible())
         --it;
 
-    if (it == itemList().begin() && !(*it)->visible())
+    if (it == m_items.begin() && !(*it)->visible())
         // reached front item, but it wasn't visible, therefore it was already raised
         stackBelowItem(item, m_manager.getLowestItemAboveLayer(m_layernum));
     else
@@ -185,56 +229,56 @@ Layer::iterator Layer::insert(LayerItem &item, unsigned int pos) {
         cerr<<__FILE__<<"("<<__LINE__<<"): Insert using non-zero position not valid in Layer"<<endl;
 #endif // DEBUG
 
-    itemList().push_front(&item);
+    m_items.push_front(&item);
+    item.m_layer_pos = m_items.begin();
     // restack below next window up
     stackBelowItem(item, m_manager.getLowestItemAboveLayer(m_layernum));
-    return itemList().begin();
+    m_manager.stackingSig().emit();
+    return m_items.begin();
 }
 
 void Layer::remove(LayerItem &item) {
-    iterator it = itemList().begin();
-    iterator it_end = itemList().end();
-    for (; it != it_end; ++it) {
-        if (*it == &item) {
-            itemList().erase(it);
-            break;
-        }
+    if (item.m_layer != this) {
+#ifdef DEBUG
+        cerr<<__FILE__<<"("<<__LINE__<<"): WARNING: remove on item not in layer["<<m_layernum<<"]"<<endl;
+#endif // DEBUG
+        return;
     }
+
+    m_items.erase(item.m_layer_pos);
+    m_manager.stackingSig().emit();
 }
 
 void Layer::raise(LayerItem &item) {
     // assume it is already in this layer
 
-    if (&item == itemList().front()) {
+    if (&item == m_items.front()) {
         if (m_needs_restack)
             restack();
         return; // nothing to do
     }
 
-
-    iterator it = std::find(itemList().begin(), itemList().end(), &item);
-    if (it != itemList().end())
-        itemList().erase(it);
-    else {
+    if (item.m_layer != this) {
 #ifdef DEBUG
         cerr<<__FILE__<<"("<<__LINE__<<"): WARNING: raise on item not in layer["<<m_layernum<<"]"<<endl;
 #endif // DEBUG
         return;
     }
 
-    itemList().push_front(&item);
+    // moving the node keeps the item's iterator valid
+    m_items.splice(m_items.begin(), m_items, item.m_layer_pos);
     stackBelowItem(item, m_manager.getLowestItemAboveLayer(m_layernum));
+    m_manager.stackingSig().emit();
 
 }
 
 void Layer::tempRaise(LayerItem &item) {
     // assume it is already in this layer
 
-    if (!m_needs_restack && &item == itemList().front())
+    if (!m_needs_restack && &item == m_items.front())
         return; // nothing to do
 
-    iterator it = std::find(itemList().begin(), itemList().end(), &item);
-    if (it == itemList().end()) {
+    if (item.m_layer != this) {
 #ifdef DEBUG
         cerr<<__FILE__<<"("<<__LINE__<<"): WARNING: raise on item not in layer["<<m_layernum<<"]"<<endl;
 #endif // DEBUG
@@ -253,39 +297,36 @@ void Layer::lower(LayerItem &item) {
     // assume already in this layer
 
     // is it already the lowest?
-    if (&item == itemList().back()) {
+    if (&item == m_items.back()) {
         if (m_needs_restack)
             restack();
         return; // nothing to do
     }
 
-    iterator it = std::find(itemList().begin(), itemList().end(), &item);
-    if (it != itemList().end())
-        // remove this item
-        itemList().erase(it);
+    if (item.m_layer != this) {
 #ifdef DEBUG
-    else {
         cerr<<__FILE__<<"("<<__LINE__<<"): WARNING: lower on item not in layer"<<endl;
+#endif // DEBUG
         return;
     }
-#endif // DEBUG
 
     // add it to the bottom
-    itemList().push_back(&item);
+    m_items.splice(m_items.end(), m_items, item.m_layer_pos);
 
     // find the item we need to stack below
     // start at the end
-    it = itemList().end();
+    iterator it = m_items.end();
 
     // go up one so we have an object (which must exist, since at least this item is in the layer)
     it--;
 
     // go down another one
-    // must exist, otherwise our item must == itemList().back()
+    // must exist, otherwise our item must == m_items.back()
     it--;
 
     // and restack our window below that one.
     stackBelowItem(item, *it);
+    m_manager.stackingSig().emit();
 }
 
 void Layer::raiseLayer(LayerItem &item) {
@@ -302,9 +343,9 @@ void Layer::moveToLayer(LayerItem &item, int layernum) {
 
 
 LayerItem *Layer::getLowestItem() {
-    if (itemList().empty())
+    if (m_items.empty())
         return 0;
     else
-        return itemList().back();
+        return m_items.back();
 }
 
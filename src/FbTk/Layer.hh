@@ -49,8 +49,8 @@ public:
     int countWindows();
     void stackBelowItem(LayerItem &item, LayerItem *above);
     LayerItem *getLowestItem();
+    // the items know where they are in the list, so only the layer changes it
     const ItemList &itemList() const { return m_items; }
-    ItemList &itemList() { return m_items; }
 
     // we redefine these as Layer has special optimisations, and X restacking needs
     iterator insert(LayerItem &item, unsigned int pos=0);
@@ -71,7 +71,10 @@ public:
     size_t numWindows() const { return m_windows.size(); }
 
 private:
+    friend class Layer;
+
     Layer *m_layer;
+    Layer::iterator m_layer_pos; ///< where the item is in m_layer's item list
     Windows m_windows;
 };
 
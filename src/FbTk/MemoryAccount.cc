@@ -0,0 +1,179 @@
+// MemoryAccount.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#include "MemoryAccount.hh"
+
+namespace FbTk {
+
+namespace {
+
+/// @return bytes of a pixmap in the server, which pads pixels of more
+///         than one byte to 2 or 4 bytes and rows of bitmaps to 32 bits
+unsigned long pixmapBytes(unsigned int width, unsigned int height,
+                          unsigned int depth) {
+    if (depth == 1)
+        return (width + 31) / 32 * 4 * (unsigned long)height;
+    unsigned int bytes = depth <= 8 ? 1 : depth <= 16 ? 2 : 4;
+    return (unsigned long)width * height * bytes;
+}
+
+const char *const NAMES[] = {
+    "other", "frame", "iconbar", "toolbar", "menu", "slit", "root", "icon", "font"
+};
+
+} // anonymous namespace
+
+MemoryAccount::Scope::Scope(Subsystem subsystem, const void *owner) {
+    MemoryAccount &account = instance();
+    m_subsystem = account.m_subsystem;
+    m_owner = account.m_owner;
+    account.m_subsystem = subsystem;
+    account.m_owner = owner;
+}
+
+MemoryAccount::Scope::~Scope() {
+    MemoryAccount &account = instance();
+    account.m_subsystem = m_subsystem;
+    account.m_owner = m_owner;
+}
+
+MemoryAccount::Reclaimable::Reclaimable() {
+    Reclaimables &list = instance().m_reclaimables;
+    m_pos = list.insert(list.end(), this);
+}
+
+MemoryAccount::Reclaimable::~Reclaimable() {
+    instance().m_reclaimables.erase(m_pos);
+}
+
+void MemoryAccount::Reclaimable::touch() {
+    Reclaimables &list = instance().m_reclaimables;
+    list.splice(list.end(), list, m_pos);
+}
+
+MemoryAccount &MemoryAccount::instance() {
+    static MemoryAccount s_account;
+    return s_account;
+}
+
+Pixmap MemoryAccount::createPixmap(Display *disp, Drawable d,
+                                   unsigned int width, unsigned int height,
+                                   unsigned int depth) {
+    Pixmap pm = XCreatePixmap(disp, d, width, height, depth);
+    if (pm == None)
+        return None;
+
+    MemoryAccount &account = instance();
+    Entry entry;
+    entry.bytes = pixmapBytes(width, height, depth);
+    entry.subsystem = account.m_subsystem;
+    entry.owner = account.m_owner;
+    // ids get reused once the server has freed a pixmap
+    Pixmaps::iterator it = account.m_pixmaps.find(pm);
+    if (it != account.m_pixmaps.end())
+        account.remove(it->second);
+    account.m_pixmaps[pm] = entry;
+    account.add(entry);
+    if (account.overBudget())
+        account.m_pressure = true;
+    return pm;
+}
+
+void MemoryAccount::freePixmap(Display *disp, Pixmap pm) {
+    if (pm == None)
+        return;
+    XFreePixmap(disp, pm);
+
+    MemoryAccount &account = instance();
+    Pixmaps::iterator it = account.m_pixmaps.find(pm);
+    if (it == account.m_pixmaps.end())
+        return;
+    account.remove(it->second);
+    account.m_pixmaps.erase(it);
+}
+
+void MemoryAccount::setOwner(Pixmap pm, Subsystem subsystem, const void *owner) {
+    Pixmaps::iterator it = m_pixmaps.find(pm);
+    if (it == m_pixmaps.end())
+        return;
+    remove(it->second);
+    it->second.subsystem = subsystem;
+    it->second.owner = owner;
+    add(it->second);
+}
+
+void MemoryAccount::setBudget(unsigned long bytes) {
+    if (bytes == m_budget)
+        return;
+    m_budget = bytes;
+    m_pressure = overBudget();
+}
+
+void MemoryAccount::relieve() {
+    m_pressure = false;
+    Reclaimables::iterator it = m_reclaimables.begin();
+    while (overBudget() && it != m_reclaimables.end()) {
+        Reclaimable *reclaimable = *it;
+        ++it;
+        reclaimable->reclaim();
+    }
+}
+
+void MemoryAccount::add(const Entry &entry) {
+    ++m_total.pixmaps;
+    m_total.bytes += entry.bytes;
+    Usage &usage = m_subsystems[entry.subsystem];
+    ++usage.pixmaps;
+    usage.bytes += entry.bytes;
+    if (entry.owner) {
+        Usage &owned = m_owners[entry.owner];
+        ++owned.pixmaps;
+        owned.bytes += entry.bytes;
+    }
+}
+
+void MemoryAccount::remove(const Entry &entry) {
+    --m_total.pixmaps;
+    m_total.bytes -= entry.bytes;
+    Usage &usage = m_subsystems[entry.subsystem];
+    --usage.pixmaps;
+    usage.bytes -= entry.bytes;
+    if (entry.owner) {
+        Owners::iterator it = m_owners.find(entry.owner);
+        if (it == m_owners.end())
+            return;
+        --it->second.pixmaps;
+        it->second.bytes -= entry.bytes;
+        if (it->second.pixmaps == 0)
+            m_owners.erase(it);
+    }
+}
+
+MemoryAccount::Usage MemoryAccount::usage(const void *owner) const {
+    Owners::const_iterator it = m_owners.find(owner);
+    return it != m_owners.end() ? it->second : Usage();
+}
+
+const char *MemoryAccount::name(Subsystem subsystem) {
+    return NAMES[subsystem];
+}
+
+} // end namespace FbTk
@@ -0,0 +1,178 @@
+// MemoryAccount.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#ifndef FBTK_MEMORYACCOUNT_HH
+#define FBTK_MEMORYACCOUNT_HH
+
+#include "NotCopyable.hh"
+
+#include <X11/Xlib.h>
+
+#include <map>
+#include <list>
+
+namespace FbTk {
+
+/**
+   Keeps account of the pixmaps we create in the X server: who created
+   them, and how much memory they take there. Pixmaps are accounted to
+   the subsystem and owner of the innermost Scope when they are created;
+   a pixmap of the image cache that other windows share later stays
+   with the one that rendered it first.
+
+   With a budget set, creating pixmaps beyond it puts us under pressure;
+   relieve() then asks the Reclaimables, least recently used first, to
+   free the pixmaps they can render again, until we fit again.
+ */
+class MemoryAccount: private NotCopyable {
+public:
+    /// what the pixmaps are for, prefixed as config.h defines SLIT
+    enum Subsystem {
+        IN_OTHER,
+        IN_FRAME,
+        IN_ICONBAR,
+        IN_TOOLBAR,
+        IN_MENU,
+        IN_SLIT,
+        IN_ROOT,
+        IN_ICON,
+        IN_FONT,
+        NUM_SUBSYSTEMS
+    };
+
+    /// the other resources we count, so leaks in the X server show
+    enum Resource {
+        WINDOWS,
+        GCS,
+        PICTURES,
+        NAMED_PIXMAPS, ///< the server made them for us, e.g. of composited windows
+        NUM_RESOURCES
+    };
+
+    struct Usage {
+        Usage(): pixmaps(0), bytes(0) { }
+        unsigned long pixmaps;
+        unsigned long bytes;
+    };
+
+    /// accounts the pixmaps created while it lives to 'subsystem' and 'owner'
+    class Scope: private NotCopyable {
+    public:
+        Scope(Subsystem subsystem, const void *owner = 0);
+        ~Scope();
+    private:
+        Subsystem m_subsystem;
+        const void *m_owner;
+    };
+
+    /**
+       Something that holds pixmaps it can render again on demand, like a
+       cache or the decorations of a hidden window
+     */
+    class Reclaimable {
+    public:
+        Reclaimable();
+        virtual ~Reclaimable();
+        /// frees the pixmaps it can render again, must not create any
+        virtual void reclaim() = 0;
+    protected:
+        /// marks it as the most recently used
+        void touch();
+    private:
+        Reclaimable(const Reclaimable &);
+        Reclaimable &operator = (const Reclaimable &);
+
+        friend class MemoryAccount;
+        std::list<Reclaimable *>::iterator m_pos;
+    };
+
+    static MemoryAccount &instance();
+
+    /// XCreatePixmap(), accounted to the current scope
+    static Pixmap createPixmap(Display *disp, Drawable d,
+                               unsigned int width, unsigned int height,
+                               unsigned int depth);
+    /// XFreePixmap(), for accounted pixmaps and others
+    static void freePixmap(Display *disp, Pixmap pm);
+
+    /// accounts 'pm' to another subsystem and owner, e.g. when a cache
+    /// takes it over
+    void setOwner(Pixmap pm, Subsystem subsystem, const void *owner = 0);
+
+    const Usage &usage(Subsystem subsystem) const { return m_subsystems[subsystem]; }
+    /// @return the pixmaps of 'owner', in all subsystems
+    Usage usage(const void *owner) const;
+    const Usage &total() const { return m_total; }
+
+    /// sets the bytes our pixmaps may take, 0 for no limit
+    void setBudget(unsigned long bytes);
+    unsigned long budget() const { return m_budget; }
+    bool overBudget() const { return m_budget && m_total.bytes > m_budget; }
+    /// @return true if pixmaps were created beyond the budget since the
+    ///         last relieve()
+    bool underPressure() const { return m_pressure; }
+    /// reclaims pixmaps until we are within the budget, or nothing is left
+    void relieve();
+
+    static const char *name(Subsystem subsystem);
+
+    /// counts a resource created in the X server
+    static void created(Resource resource) { ++instance().m_resources[resource]; }
+    /// counts a resource freed in the X server
+    static void destroyed(Resource resource) { --instance().m_resources[resource]; }
+    /// @return the resources we created and didn't free
+    long count(Resource resource) const { return m_resources[resource]; }
+
+private:
+    MemoryAccount():
+        m_subsystem(IN_OTHER), m_owner(0), m_budget(0), m_pressure(false) {
+        for (int i = 0; i < NUM_RESOURCES; ++i)
+            m_resources[i] = 0;
+    }
+
+    struct Entry {
+        unsigned long bytes;
+        Subsystem subsystem;
+        const void *owner;
+    };
+    typedef std::map<Pixmap, Entry> Pixmaps;
+    typedef std::map<const void *, Usage> Owners;
+    /// least recently used first
+    typedef std::list<Reclaimable *> Reclaimables;
+
+    void add(const Entry &entry);
+    void remove(const Entry &entry);
+
+    Pixmaps m_pixmaps;
+    Usage m_subsystems[NUM_SUBSYSTEMS];
+    Owners m_owners;
+    Usage m_total;
+    Subsystem m_subsystem;
+    const void *m_owner;
+    Reclaimables m_reclaimables;
+    unsigned long m_budget;
+    bool m_pressure;
+    long m_resources[NUM_RESOURCES];
+};
+
+} // end namespace FbTk
+
+#endif // FBTK_MEMORYACCOUNT_HH
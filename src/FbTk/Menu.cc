@@ -41,8 +41,13 @@
 #include "App.hh"
 #include "EventManager.hh"
 #include "Transparent.hh"
+#include "MemoryAccount.hh"
+#include "RequestStats.hh"
+#include "Tracer.hh"
 #include "SimpleCommand.hh"
 #include "FbPixmap.hh"
+#include "TextBatch.hh"
+#include "FbTime.hh"
 
 #include <X11/Xutil.h>
 #include <X11/Xatom.h>
@@ -89,6 +94,33 @@ void renderMenuPixmap(Pixmap& pm, FbTk::FbWindow* win, int width, int height, co
     }
 }
 
+/// source of Menu::m_strip_generation, unique over all menus
+unsigned int s_strip_generation = 0;
+
+bool stripMatches(FbTk::MenuItem &item, unsigned int generation,
+                  unsigned int background, unsigned int width) {
+    const FbTk::MenuItem::Strip &strip = item.highlightStrip();
+    return strip.pixmap.drawable() != None &&
+        strip.generation == generation &&
+        strip.background == background &&
+        strip.width == width &&
+        strip.enabled == item.isEnabled() &&
+        strip.selected == item.isSelected() &&
+        strip.icon == item.icon() &&
+        strip.label == item.label().logical();
+}
+
+/// adds the time from its construction to its destruction to 'timing'
+class ScopedTiming {
+public:
+    explicit ScopedTiming(FbTk::Menu::Stats::Timing &timing):
+        m_timing(timing), m_start(FbTk::FbTime::mono()) { }
+    ~ScopedTiming() { m_timing.add(FbTk::FbTime::mono() - m_start); }
+private:
+    FbTk::Menu::Stats::Timing &m_timing;
+    uint64_t m_start;
+};
+
 } // end of anonymous namespace
 
 
@@ -98,6 +130,15 @@ Menu *Menu::shown = 0;
 
 Menu *Menu::s_focused = 0;
 
+Menu::Stats Menu::s_stats = { { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 } };
+
+void Menu::Stats::Timing::add(uint64_t duration) {
+    ++count;
+    total += duration;
+    if (duration > max)
+        max = duration;
+}
+
 Menu::Menu(FbTk::ThemeProxy<MenuTheme> &tm, ImageControl &imgctrl):
     m_theme(tm),
     m_parent(0),
@@ -109,7 +150,9 @@ Menu::Menu(FbTk::ThemeProxy<MenuTheme> &tm, ImageControl &imgctrl):
     m_alignment(ALIGNDONTCARE),
     m_active_index(-1),
     m_shape(0),
-    m_need_update(true) {
+    m_shown_at(0),
+    m_need_update(true),
+    m_strip_generation(++s_strip_generation) {
     // setup timers
 
     RefCount<Command<void> > show_cmd(new SimpleCommand<Menu>(*this, &Menu::openSubmenu));
@@ -121,6 +164,8 @@ Menu::Menu(FbTk::ThemeProxy<MenuTheme> &tm, ImageControl &imgctrl):
     m_hide_timer.setCommand(hide_cmd);
     m_hide_timer.fireOnce(true);
 
+    m_update_task.setFunctor(MemFun(*this, &Menu::updateMenu));
+
     // make sure we get updated when the theme is reloaded
     m_tracker.join(tm.reconfigSig(), MemFun(*this, &Menu::themeReconfigured));
 
@@ -149,7 +194,9 @@ Menu::Menu(FbTk::ThemeProxy<MenuTheme> &tm, ImageControl &imgctrl):
 
     m_columns =
         m_rows_per_column =
-        m_min_columns = 0;
+        m_min_columns =
+        m_first_item = 0;
+    m_scrolling = false;
 
     FbTk::EventManager &evm = *FbTk::EventManager::instance();
     long event_mask = ButtonPressMask | ButtonReleaseMask |
@@ -237,13 +284,16 @@ int Menu::insert(MenuItem *item, int pos) {
     if (pos == -1) {
         item->setIndex(menuitems.size());
         menuitems.push_back(item);
+        m_item_widths.push_back(0);
     } else {
         menuitems.insert(menuitems.begin() + pos, item);
+        m_item_widths.insert(m_item_widths.begin() + pos, 0);
         fixMenuItemIndices();
         if (m_active_index >= pos)
             m_active_index++;
     }
     m_need_update = true; // we need to redraw the menu
+    m_type_ahead.invalidate();
     return menuitems.size();
 }
 
@@ -270,6 +320,7 @@ int Menu::remove(unsigned int index) {
         if (!m_matches.empty())
             resetTypeAhead();
         menuitems.erase(it);
+        m_item_widths.erase(m_item_widths.begin() + index);
         // avoid O(n^2) algorithm with removeAll()
         if (index != menuitems.size())
             fixMenuItemIndices();
@@ -299,6 +350,7 @@ int Menu::remove(unsigned int index) {
         m_active_index--;
 
     m_need_update = true; // we need to redraw the menu
+    m_type_ahead.invalidate();
 
     return menuitems.size();
 }
@@ -358,6 +410,7 @@ void Menu::setActiveIndex(int new_index) {
     // clear the items and close any open submenus
     int old_active_index = m_active_index;
     m_active_index = new_index;
+    scrollToItem(new_index);
     if (validIndex(old_active_index) &&
         menuitems[old_active_index] != 0) {
         if (menuitems[old_active_index]->submenu()) {
@@ -378,6 +431,7 @@ void Menu::enterSubmenu() {
     if (submenu == 0)
         return;
 
+    submenu->populate();
     if (submenu->menuitems.size() == 0)
         return;
 
@@ -396,6 +450,15 @@ void Menu::enableTitle() {
 }
 
 void Menu::updateMenu() {
+    MemoryAccount::Scope account(MemoryAccount::IN_MENU);
+    RequestStats::Widget widget(typeid(*this));
+    ScopedTiming timing(s_stats.update);
+    Tracer::Span span("menu", "Menu::updateMenu", "items", menuitems.size());
+    m_update_task.cancel();
+
+    // labels might have changed
+    m_type_ahead.invalidate();
+
     if (m_title_vis) {
         m_item_w = theme()->titleFont().textWidth(m_label);
         m_item_w += (theme()->bevelWidth() * 2);
@@ -417,17 +480,6 @@ void Menu::updateMenu() {
         }
     }
 
-    unsigned int ii = 0;
-    Menuitems::iterator it = menuitems.begin();
-    Menuitems::iterator it_end = menuitems.end();
-    for (; it != it_end; ++it) {
-        ii = (*it)->width(theme());
-        m_item_w = (ii > m_item_w ? ii : m_item_w);
-    }
-
-    if (m_item_w < 1)
-        m_item_w = 1;
-
     if (!menuitems.empty()) {
         m_columns = 1;
 
@@ -439,13 +491,40 @@ void Menu::updateMenu() {
         if (m_columns < m_min_columns)
             m_columns = m_min_columns;
 
-        m_rows_per_column = menuitems.size() / m_columns;
-        if (menuitems.size() % m_columns) m_rows_per_column++;
+        m_scrolling = theme()->maxColumns() > 0 &&
+            m_columns > theme()->maxColumns() && m_columns > m_min_columns;
+        if (m_scrolling) {
+            // as many rows as the loop above allows for one column
+            int rows = static_cast<int>(m_screen_height - theme()->titleHeight() -
+                                        theme()->borderWidth()) /
+                static_cast<int>(theme()->itemHeight()) - 1;
+            m_columns = 1;
+            m_rows_per_column = rows < 1 ? 1 : rows;
+            m_first_item = std::max(0, std::min(m_first_item,
+                static_cast<int>(menuitems.size()) - m_rows_per_column));
+        } else {
+            m_rows_per_column = menuitems.size() / m_columns;
+            if (menuitems.size() % m_columns) m_rows_per_column++;
+            m_first_item = 0;
+        }
     } else {
         m_columns = 0;
         m_rows_per_column = 0;
+        m_scrolling = false;
+        m_first_item = 0;
     }
 
+    // measure what is shown again, the labels might have changed; the
+    // other items of a scrolling menu keep the width they had when shown
+    int shown_end = endOfShownItems();
+    for (int i = m_first_item; i < shown_end; ++i)
+        m_item_widths[i] = menuitems[i]->width(theme());
+    for (size_t i = 0; i < m_item_widths.size(); ++i)
+        m_item_w = std::max(m_item_w, m_item_widths[i]);
+
+    if (m_item_w < 1)
+        m_item_w = 1;
+
     int itmp = (theme()->itemHeight() * m_rows_per_column);
     m_frame_h = itmp < 1 ? 1 : itmp;
 
@@ -478,6 +557,7 @@ void Menu::updateMenu() {
     renderMenuPixmap(m_hilite_pixmap, NULL,
             m_item_w, theme()->itemHeight(),
             theme()->hiliteTexture(), m_image_ctrl);
+    m_strip_generation = ++s_strip_generation;
 
 
     if (!theme()->selectedPixmap().pixmap().drawable()) {
@@ -529,11 +609,98 @@ void Menu::updateMenu() {
 }
 
 
+void Menu::updateItem(unsigned int index, unsigned int old_width) {
+    if (!validIndex(index))
+        return;
+
+    // all items are as wide as the widest one; a pending update measures
+    // everything again anyway when the menu gets shown
+    unsigned int width = menuitems[index]->width(theme());
+    m_item_widths[index] = width;
+    m_type_ahead.invalidate();
+    if (width > m_item_w ||
+        (old_width >= m_item_w && width < old_width)) {
+        updateMenuLater();
+        return;
+    }
+
+    if (isVisible())
+        clearItem(index);
+}
+
+void Menu::scrollTo(int first) {
+    if (!m_scrolling)
+        return;
+
+    first = std::max(0, std::min(first,
+        static_cast<int>(menuitems.size()) - m_rows_per_column));
+    if (first == m_first_item)
+        return;
+
+    // the submenu would point at an item that might not be shown anymore
+    if (validIndex(m_which_sub)) {
+        Menu *submenu = menuitems[m_which_sub]->submenu();
+        if (submenu && submenu->isVisible() && !submenu->isTorn())
+            submenu->internal_hide(false);
+        m_which_sub = -1;
+    }
+
+    m_first_item = first;
+    if (measureShownItems())
+        updateMenu();
+    else if (isVisible())
+        clearWindow();
+}
+
+void Menu::scrollToItem(int index) {
+    if (!m_scrolling || !validIndex(index))
+        return;
+
+    if (index < m_first_item)
+        scrollTo(index);
+    else if (index >= m_first_item + m_rows_per_column)
+        scrollTo(index - m_rows_per_column + 1);
+}
+
+void Menu::pageItems(bool reverse) {
+    if (menuitems.empty() || m_rows_per_column == 0)
+        return;
+
+    int step = reverse ? -m_rows_per_column : m_rows_per_column;
+    int index = std::max(0, std::min(m_active_index + step,
+                                     static_cast<int>(menuitems.size()) - 1));
+    // walk back towards the active item until we find one to select
+    while (index != m_active_index && validIndex(index) &&
+           !isItemSelectable(index))
+        index += reverse ? 1 : -1;
+
+    if (index != m_active_index && validIndex(index))
+        setActiveIndex(index);
+}
+
+bool Menu::measureShownItems() {
+    bool wider = false;
+    int shown_end = endOfShownItems();
+    for (int i = m_first_item; i < shown_end; ++i) {
+        if (m_item_widths[i] == 0)
+            m_item_widths[i] = menuitems[i]->width(theme());
+        if (m_item_widths[i] > m_item_w)
+            wider = true;
+    }
+    return wider;
+}
+
 void Menu::show() {
 
-    if (isVisible() || menuitems.empty())
+    if (isVisible())
+        return;
+
+    populate();
+    if (menuitems.empty())
         return;
 
+    ScopedTiming timing(s_stats.show);
+    m_shown_at = FbTime::mono();
     m_visible = true;
 
     if (m_need_update)
@@ -571,6 +738,23 @@ void Menu::hide(bool force) {
 
 }
 
+void Menu::reclaim() {
+    if (isVisible())
+        return;
+
+    Pixmap *pixmaps[] = { &m_title_pixmap, &m_frame_pixmap, &m_hilite_pixmap };
+    for (size_t i = 0; i < sizeof(pixmaps) / sizeof(pixmaps[0]); ++i) {
+        m_image_ctrl.removeImage(*pixmaps[i]);
+        *pixmaps[i] = None;
+    }
+    for (size_t i = 0; i < menuitems.size(); ++i)
+        menuitems[i]->highlightStrip().pixmap = None;
+
+    m_title.releaseBackground();
+    m_frame.releaseBackground();
+    m_need_update = true;
+}
+
 void Menu::grabInputFocus() {
     // if there's a submenu open, focus it instead
     if (validIndex(m_which_sub) &&
@@ -591,14 +775,20 @@ void Menu::clearWindow() {
     m_frame.clear();
 
     // clear foreground bits of frame items
-    for (size_t i = 0; i < menuitems.size(); i++) {
-        clearItem(i, false);   // no clear
+    {
+        TextBatch batch(m_frame);
+        int shown_end = endOfShownItems();
+        for (int i = m_first_item; i < shown_end; i++) {
+            clearItem(i, false);   // no clear
+        }
     }
     m_shape->update();
 }
 
 void Menu::redrawFrame(FbDrawable &drawable) {
-    for (size_t i = 0; i < menuitems.size(); i++) {
+    TextBatch batch(drawable);
+    int shown_end = endOfShownItems();
+    for (int i = m_first_item; i < shown_end; i++) {
         drawItem(drawable, i);
     }
 
@@ -626,6 +816,8 @@ void Menu::internal_hide(bool first) {
     }
 
     m_torn = m_visible = m_closing = false;
+    m_shown_at = 0;
+    touch();
     m_which_sub = -1;
 
     if (first && m_parent && m_parent->isVisible() &&
@@ -649,7 +841,8 @@ void Menu::move(int x, int y) {
     if (!isVisible())
         return;
 
-    if (alpha() < 255)
+    // with composite, the compositor blends the menu wherever it is
+    if (alpha() < 255 && !Transparent::useComposite(screenNumber()))
         clearWindow();
 
     if (validIndex(m_which_sub) &&
@@ -702,20 +895,16 @@ void Menu::drawSubmenu(unsigned int index) {
         if (item->submenu()->m_parent != this)
             item->submenu()->m_parent = this;
 
+        // its size is needed to place it
+        item->submenu()->populate();
+
         item->submenu()->setScreen(m_screen_x, m_screen_y, m_screen_width, m_screen_height);
 
-        // ensure we do not divide by 0 and thus cause a SIGFPE
-        if (m_rows_per_column == 0) {
-#if DEBUG
-            cerr << __FILE__ << "(" << __LINE__
-                 << ") Error: m_rows_per_column == 0 in FbTk::Menu::drawSubmenu()\n";
-#endif
+        int item_x, item_y;
+        if (!itemPosition(index, item_x, item_y))
             return;
-        }
 
-        int column = index / m_rows_per_column;
-        int row = index - (column * m_rows_per_column);
-        int new_x = x() + ((m_item_w * (column + 1)) + m_window.borderWidth());
+        int new_x = x() + item_x + m_item_w + m_window.borderWidth();
         int new_y;
 
         if (m_alignment == ALIGNTOP) {
@@ -723,7 +912,7 @@ void Menu::drawSubmenu(unsigned int index) {
                      ((item->submenu()->m_title_vis) ?
                       item->submenu()->theme()->titleHeight() + m_window.borderWidth() : 0));
         } else {
-            new_y = (y() + (theme()->itemHeight() * row) +
+            new_y = (y() + item_y +
                      ((m_title_vis) ? theme()->titleHeight() + m_window.borderWidth() : 0) -
                      ((item->submenu()->m_title_vis) ?
                       item->submenu()->theme()->titleHeight() + m_window.borderWidth() : 0));
@@ -773,26 +962,15 @@ void Menu::drawSubmenu(unsigned int index) {
 int Menu::drawItem(FbDrawable &drawable, unsigned int index,
                    bool highlight, bool exclusive_drawable) {
 
-    if (index >= menuitems.size() || menuitems.size() == 0 ||
-        m_rows_per_column == 0)
+    if (index >= menuitems.size())
         return 0;
 
     MenuItem *item = menuitems[index];
     if (! item) return 0;
 
-    // ensure we do not divide by 0 and thus cause a SIGFPE
-    if (m_rows_per_column == 0) {
-#if DEBUG
-        cerr << __FILE__ << "(" << __LINE__
-             << ") Error: m_rows_per_column == 0 in FbTk::Menu::drawItem()\n";
-#endif
+    int item_x, item_y;
+    if (!itemPosition(index, item_x, item_y))
         return 0;
-    }
-
-    int column = index / m_rows_per_column;
-    int row = index - (column * m_rows_per_column);
-    int item_x = (column * m_item_w);
-    int item_y = (row * theme()->itemHeight());
 
     if (exclusive_drawable)
         item_x = item_y = 0;
@@ -885,11 +1063,13 @@ void Menu::buttonPressEvent(XButtonEvent &be) {
     } else
         m_closing = false;
 
-    if (be.window == m_frame && m_item_w != 0) {
+    if (be.window == m_frame && m_scrolling &&
+        (be.button == 4 || be.button == 5)) {
+        // the wheel scrolls a few items at a time
+        scrollTo(m_first_item + (be.button == 4 ? -3 : 3));
+    } else if (be.window == m_frame && m_item_w != 0) {
 
-        int column = (be.x / m_item_w);
-        int i = (be.y / theme()->itemHeight());
-        int w = (column * m_rows_per_column) + i;
+        int w = itemAt(be.x, be.y);
 
         if (validIndex(w) && isItemSelectable(static_cast<unsigned int>(w))) {
             MenuItem *item = menuitems[w];
@@ -915,7 +1095,7 @@ void Menu::buttonReleaseEvent(XButtonEvent &re) {
                     menuitems[m_which_sub]->submenu()->isVisible())
                 drawSubmenu(m_which_sub);
 
-            if (alpha() < 255) {
+            if (alpha() < 255 && !Transparent::useComposite(screenNumber())) {
                 // update these since we've (probably) moved
                 m_title.parentMoved();
                 m_frame.parentMoved();
@@ -926,15 +1106,14 @@ void Menu::buttonReleaseEvent(XButtonEvent &re) {
         if (re.button == 3 && m_closing)
             internal_hide();
 
-    } else if (re.window == m_frame) {
+    } else if (re.window == m_frame &&
+               !(m_scrolling && (re.button == 4 || re.button == 5))) {
 
-        int column = (re.x / m_item_w);
-        int i = (re.y / theme()->itemHeight());
-        int ix = column * m_item_w;
-        int iy = i * theme()->itemHeight();
-        int w = (column * m_rows_per_column) + i;
+        int w = itemAt(re.x, re.y);
+        int ix = 0, iy = 0;
 
-        if (validIndex(w) && isItemSelectable(static_cast<unsigned int>(w))) {
+        if (validIndex(w) && isItemSelectable(static_cast<unsigned int>(w)) &&
+            itemPosition(w, ix, iy)) {
             if (m_active_index == w && isItemEnabled(w) &&
                 re.x > ix && re.x < (signed) (ix + m_item_w) &&
                 re.y > iy && re.y < (signed) (iy + theme()->itemHeight())) {
@@ -974,9 +1153,7 @@ void Menu::motionNotifyEvent(XMotionEvent &me) {
 
     } else if (!(me.state & Button1Mask) && me.window == m_frame) {
         stopHide();
-        int column = (me.x / m_item_w);
-        int i = (me.y / theme()->itemHeight());
-        int w = (column * m_rows_per_column) + i;
+        int w = itemAt(me.x, me.y);
 
         if (w == m_active_index || !validIndex(w))
             return;
@@ -1045,24 +1222,20 @@ void Menu::exposeEvent(XExposeEvent &ee) {
         // then we see how many items down to redraw
         int id_d = ((ee.y + ee.height) / theme()->itemHeight());
 
-        if (id_d > m_rows_per_column)
-            id_d = m_rows_per_column;
+        if (id_d >= m_rows_per_column)
+            id_d = m_rows_per_column - 1;
 
         // draw the columns and the number of items the exposure spans
-        int i, ii;
-        for (i = column; i <= column_d; i++) {
-            // set the iterator to the first item in the column needing redrawing
-            int index = id + i * m_rows_per_column;
-
-            if (index < static_cast<int>(menuitems.size()) && index >= 0) {
-                Menuitems::iterator it = menuitems.begin() + index;
-                Menuitems::iterator it_end = menuitems.end();
-                for (ii = id; ii <= id_d && it != it_end; ++it, ii++) {
-                    int index = ii + (i * m_rows_per_column);
-                    // redraw the item
-                    clearItem(index);
-                }
-            }
+        TextBatch batch(m_frame);
+        for (int i = column; i <= column_d; i++) {
+            for (int ii = id; ii <= id_d; ii++)
+                clearItem(m_first_item + i * m_rows_per_column + ii);
+        }
+
+        // the items are on the screen now
+        if (m_shown_at != 0 && ee.count == 0) {
+            s_stats.expose.add(FbTime::mono() - m_shown_at);
+            m_shown_at = 0;
         }
     }
 }
@@ -1107,6 +1280,22 @@ void Menu::keyPressEvent(XKeyEvent &event) {
         } else
             enterSubmenu();
         break;
+    case XK_Prior:
+    case XK_Next:
+        resetTypeAhead();
+        pageItems(ks == XK_Prior);
+        break;
+    case XK_Home:
+    case XK_End: {
+        resetTypeAhead();
+        int step = (ks == XK_Home) ? 1 : -1;
+        int index = (ks == XK_Home) ? 0 : static_cast<int>(menuitems.size()) - 1;
+        while (validIndex(index) && !isItemSelectable(index))
+            index += step;
+        if (validIndex(index))
+            setActiveIndex(index);
+        break;
+    }
     case XK_Escape: // close menu
         m_type_ahead.reset();
         m_torn = false;
@@ -1150,6 +1339,7 @@ void Menu::keyPressEvent(XKeyEvent &event) {
         drawTypeAheadItems();
         break;
     default:
+        m_type_ahead.setMode(theme()->searchMode());
         m_type_ahead.putCharacter(keychar[0]);
         // if current item doesn't match new search string, find the next one
         drawTypeAheadItems();
@@ -1175,9 +1365,11 @@ void Menu::leaveNotifyEvent(XCrossingEvent &ce) {
 }
 
 void Menu::reconfigure() {
+    MemoryAccount::Scope account(MemoryAccount::IN_MENU);
+    RequestStats::Widget widget(typeid(*this));
     m_shape->setPlaces(theme()->shapePlaces());
 
-    if (FbTk::Transparent::haveComposite()) {
+    if (FbTk::Transparent::useComposite(screenNumber())) {
         m_window.setOpaque(alpha());
         m_title.setAlpha(255);
         m_frame.setAlpha(255);
@@ -1242,6 +1434,9 @@ void Menu::themeReconfigured() {
     for (; it != it_end; ++it) {
         (*it)->updateTheme(theme());
     }
+    // the font might have changed
+    m_item_widths.assign(menuitems.size(), 0);
+    m_strip_generation = ++s_strip_generation;
     reconfigure();
 }
 
@@ -1254,6 +1449,7 @@ void Menu::setScreen(int x, int y, int w, int h) {
 
 // Render the foreground objects of given window onto given pixmap
 void Menu::renderForeground(FbWindow &win, FbDrawable &drawable) {
+    ScopedTiming timing(s_stats.render);
     if (&win == &m_frame) {
         redrawFrame(drawable);
     } else if (&win == &m_title) {
@@ -1266,24 +1462,12 @@ void Menu::renderForeground(FbWindow &win, FbDrawable &drawable) {
 // nothing in here should be rendered transparently
 // (unless you use a caching pixmap, which I think we should avoid)
 void Menu::clearItem(int index, bool clear, int search_index) {
-    if (!validIndex(index))
-        return;
-
-    // ensure we do not divide by 0 and thus cause a SIGFPE
-    if (m_rows_per_column == 0) {
-#if DEBUG
-        cerr << __FILE__ << "(" << __LINE__
-             << ") Error: m_rows_per_column == 0 in FbTk::Menu::clearItem()\n";
-#endif
+    int item_x, item_y;
+    if (!validIndex(index) || !itemPosition(index, item_x, item_y))
         return;
-    }
 
-    int column = index / m_rows_per_column;
-    int row = index - (column * m_rows_per_column);
     unsigned int item_w = m_item_w;
     unsigned int item_h = theme()->itemHeight();
-    int item_x = (column * item_w);
-    int item_y = (row * item_h);
     bool highlight = (index == m_active_index && isItemSelectable(index));
 
     if (search_index < 0)
@@ -1314,25 +1498,30 @@ void Menu::clearItem(int index, bool clear, int search_index) {
 // Area must have been cleared before calling highlight
 void Menu::highlightItem(int index) {
 
-    // ensure we do not divide by 0 and thus cause a SIGFPE
-    if (m_rows_per_column == 0) {
-#if DEBUG
-        cerr << __FILE__ << "(" << __LINE__
-             << ") Error: m_rows_per_column == 0 in FbTk::Menu::highlightItem()\n";
-#endif
+    int item_x, item_y;
+    if (!itemPosition(index, item_x, item_y))
         return;
-    }
 
-    int column = index / m_rows_per_column;
-    int row = index - (column * m_rows_per_column);
     unsigned int item_w = m_item_w;
     unsigned int item_h = theme()->itemHeight();
-    int item_x = (column * m_item_w);
-    int item_y = (row * item_h);
+
+    bool parent_rel = m_hilite_pixmap == ParentRelative;
+    // a translucent strip is blended with what is below the menu, it lasts
+    // as long as the background of the frame
+    unsigned int background = m_frame.alpha() == 255 ? 0 : m_frame.alphaGeneration();
+    bool cache = !parent_rel && (m_frame.alpha() == 255 || background != 0);
+    MenuItem &item = *menuitems[index];
+    if (cache && stripMatches(item, m_strip_generation, background, item_w)) {
+        m_frame.copyArea(item.highlightStrip().pixmap.drawable(),
+                         theme()->hiliteGC().gc(),
+                         0, 0,
+                         item_x, item_y,
+                         item_w, item_h);
+        return;
+    }
 
     FbPixmap buffer = FbPixmap(m_frame, item_w, item_h, m_frame.depth());
 
-    bool parent_rel = m_hilite_pixmap == ParentRelative;
     Pixmap pixmap = parent_rel ? m_frame_pixmap : m_hilite_pixmap;
     int pixmap_x = parent_rel ? item_x : 0, pixmap_y = parent_rel ? item_y : 0;
     if (pixmap) {
@@ -1353,6 +1542,17 @@ void Menu::highlightItem(int index) {
                         item_x, item_y,
                         item_w, item_h);
 
+    if (cache) {
+        MenuItem::Strip &strip = item.highlightStrip();
+        strip.pixmap = buffer.release();
+        strip.generation = m_strip_generation;
+        strip.background = background;
+        strip.width = item_w;
+        strip.enabled = item.isEnabled();
+        strip.selected = item.isSelected();
+        strip.icon = item.icon();
+        strip.label = item.label().logical();
+    }
 }
 
 void Menu::resetTypeAhead() {
@@ -1377,25 +1577,43 @@ void Menu::drawTypeAheadItems() {
 
 // underline menuitem[index] with respect to matchstringsize size
 void Menu::drawLine(int index, int size){
-    if (!validIndex(index))
+    int item_x, item_y;
+    if (!validIndex(index) || !itemPosition(index, item_x, item_y))
         return;
 
+    FbTk::MenuItem *item = find(index);
+    item->drawLine(m_frame, theme(), size, item_x, item_y, m_item_w,
+                   m_type_ahead.matchStart(*item));
+}
+
+bool Menu::itemPosition(int index, int &item_x, int &item_y) const {
     // ensure we do not divide by 0 and thus cause a SIGFPE
-    if (m_rows_per_column == 0) {
-#if DEBUG
-        cerr << __FILE__ << "(" << __LINE__
-             << ") Error: m_rows_per_column == 0 in FbTk::Menu::drawLine()\n";
-#endif
-        return;
-    }
+    if (m_rows_per_column == 0)
+        return false;
+
+    int shown = index - m_first_item;
+    if (shown < 0 || shown >= m_rows_per_column * m_columns)
+        return false;
 
-    int column = index / m_rows_per_column;
-    int row = index - (column * m_rows_per_column);
-    int item_x = (column * m_item_w);
-    int item_y = (row * theme()->itemHeight());
+    int column = shown / m_rows_per_column;
+    int row = shown - (column * m_rows_per_column);
+    item_x = column * m_item_w;
+    item_y = row * theme()->itemHeight();
+    return true;
+}
 
-    FbTk::MenuItem *item = find(index);
-    item->drawLine(m_frame, theme(), size, item_x, item_y, m_item_w);
+int Menu::itemAt(int x, int y) const {
+    if (m_item_w == 0 || theme()->itemHeight() == 0)
+        return -1;
+
+    int column = x / static_cast<int>(m_item_w);
+    int row = y / static_cast<int>(theme()->itemHeight());
+    return m_first_item + (column * m_rows_per_column) + row;
+}
+
+int Menu::endOfShownItems() const {
+    return std::min(static_cast<int>(menuitems.size()),
+                    m_first_item + m_rows_per_column * m_columns);
 }
 
 void Menu::hideShownMenu() {
@@ -33,7 +33,9 @@
 #include "EventHandler.hh"
 #include "MenuTheme.hh"
 #include "Timer.hh"
+#include "IdleTask.hh"
 #include "TypeAhead.hh"
+#include "MemoryAccount.hh"
 
 namespace FbTk {
 
@@ -43,7 +45,8 @@ class ImageControl;
 template <typename T> class RefCount;
 
 ///   Base class for menus
-class Menu: public FbTk::EventHandler, FbTk::FbWindowRenderer {
+class Menu: public FbTk::EventHandler, FbTk::FbWindowRenderer,
+            public MemoryAccount::Reclaimable {
 public:
     enum Alignment{ ALIGNDONTCARE = 1, ALIGNTOP, ALIGNBOTTOM };
     enum { RIGHT = 1, LEFT };
@@ -53,6 +56,20 @@ public:
     */
     enum { EMPTY = 0, SQUARE, TRIANGLE, DIAMOND };
 
+    /// how long all menus took for their work, in micro-seconds
+    struct Stats {
+        struct Timing {
+            unsigned long count;
+            uint64_t total, max;
+            void add(uint64_t duration);
+        };
+        Timing show; ///< show()
+        Timing update; ///< updateMenu()
+        Timing render; ///< renderForeground()
+        Timing expose; ///< from show() until its first expose event was handled
+    };
+    static const Stats &stats() { return s_stats; }
+
     Menu(FbTk::ThemeProxy<MenuTheme> &tm, ImageControl &imgctrl);
     virtual ~Menu();
 
@@ -111,15 +128,33 @@ public:
     /// move menu to x,y
     virtual void move(int x, int y);
     virtual void updateMenu();
+    /**
+     * Lays the menu out once the event queue is empty, so a burst of
+     * inserted, removed or relabeled items costs a single updateMenu().
+     */
+    void updateMenuLater() { m_update_task.schedule(); }
+    /**
+     * Redraws the item at @index after its label changed. The menu is only
+     * laid out again if the item changes the width of the menu.
+     * @param old_width the width of the item before it changed
+     */
+    void updateItem(unsigned int index, unsigned int old_width);
     void setItemSelected(unsigned int index, bool val);
     void setItemEnabled(unsigned int index, bool val);
     void setMinimumColumns(int columns) { m_min_columns = columns; }
+    /**
+     * Scrolls a menu that needs more than theme()->maxColumns() columns so
+     * 'first' becomes its first shown item.
+     */
+    void scrollTo(int first);
     virtual void drawSubmenu(unsigned int index);
     /// show menu
     virtual void show();
     /// hide menu
     virtual void hide(bool force = false);
     virtual void clearWindow();
+    /// frees the pixmaps of a hidden menu, the next show renders them again
+    void reclaim();
     /*@}*/
 
     /**
@@ -129,6 +164,7 @@ public:
     bool isTorn() const { return m_torn; }
     bool isVisible() const { return m_visible; }
     bool isMoving() const { return m_moving; }
+    bool isScrolling() const { return m_scrolling; }
     int screenNumber() const { return m_window.screenNumber(); }
     Window window() const { return m_window.window(); }
     FbWindow &fbwindow() { return m_window; }
@@ -186,8 +222,28 @@ protected:
 
     virtual void internal_hide(bool first = true);
 
+    /**
+     * Called before the menu is shown or its size is needed, so subclasses
+     * can build their items only once somebody opens them.
+     */
+    virtual void populate() { }
+
 private:
 
+    /// @return false if item 'index' isn't shown, else its position in the frame
+    bool itemPosition(int index, int &item_x, int &item_y) const;
+    /// @return the index of the item at x, y in the frame
+    int itemAt(int x, int y) const;
+    /// @return one past the last shown item
+    int endOfShownItems() const;
+    /// measures the shown items that weren't measured yet
+    /// @return true if one of them is wider than the menu
+    bool measureShownItems();
+    /// scrolls so item 'index' is shown
+    void scrollToItem(int index);
+    /// moves the active index a page up or down
+    void pageItems(bool reverse);
+
     void openSubmenu();
     void closeMenu();
     void startHide();
@@ -244,8 +300,14 @@ private:
     int m_columns;
     int m_rows_per_column;
     int m_min_columns;
+    // a menu needing more than theme()->maxColumns() columns instead shows
+    // the 'm_rows_per_column' items from 'm_first_item' in one column
+    bool m_scrolling;
+    int m_first_item;
 
     unsigned int m_item_w;
+    /// the width of each item, 0 if it wasn't measured yet
+    std::vector<unsigned int> m_item_widths;
 
     int m_active_index; ///< current highlighted index
 
@@ -255,7 +317,12 @@ private:
     Drawable m_root_pm;
     static Menu *shown; ///< used for determining if there's a menu open at all
     static Menu *s_focused; ///< holds current input focused menu, so one can determine if a menu is focused
+    static Stats s_stats;
+    uint64_t m_shown_at; ///< FbTime::mono() of show() until the first expose, else 0
     bool m_need_update;
+    /// changes whenever the highlighted strips of the items become invalid
+    unsigned int m_strip_generation;
+    IdleTask m_update_task; ///< the deferred updateMenu()
     Timer m_submenu_timer;
     Timer m_hide_timer;
 
@@ -24,7 +24,7 @@
 #include "GContext.hh"
 #include "MenuTheme.hh"
 #include "PixmapWithMask.hh"
-#include "Image.hh"
+#include "IconCache.hh"
 #include "App.hh"
 #include "StringUtil.hh"
 #include "Menu.hh"
@@ -44,7 +44,8 @@ void MenuItem::click(int button, int time, unsigned int mods) {
 
 void MenuItem::drawLine(FbDrawable &draw,
                         const FbTk::ThemeProxy<MenuTheme> &theme, size_t size,
-                        int text_x, int text_y, unsigned int width) const {
+                        int text_x, int text_y, unsigned int width,
+                        size_t start) const {
 
     unsigned int height = theme->itemHeight();
     int bevelW = theme->bevelWidth();
@@ -58,8 +59,15 @@ void MenuItem::drawLine(FbDrawable &draw,
     int text_w = theme->frameFont().textWidth(label());
 
     const FbString& visual = m_label.visual();
-    BiDiString search_string(FbString(visual, 0, size > visual.size() ? visual.size() : size));
-    int search_string_w = theme->frameFont().textWidth(search_string);
+    if (start > visual.size())
+        start = visual.size();
+    if (size > visual.size() - start)
+        size = visual.size() - start;
+    // the match might not be at the start of the label
+    int start_w = start == 0 ? 0 :
+        theme->frameFont().textWidth(BiDiString(FbString(visual, 0, start)));
+    BiDiString search_string(FbString(visual, 0, start + size));
+    int search_string_w = theme->frameFont().textWidth(search_string) - start_w;
 
     // pay attention to the text justification
     switch(theme->frameFontJustify()) {
@@ -77,7 +85,8 @@ void MenuItem::drawLine(FbDrawable &draw,
     // avoid drawing an ugly dot
     if (size != 0)
         draw.drawLine(theme->frameUnderlineGC().gc(),
-                      text_x, text_y, text_x + search_string_w, text_y);
+                      text_x + start_w, text_y,
+                      text_x + start_w + search_string_w, text_y);
 
 }
 
@@ -95,33 +104,44 @@ void MenuItem::draw(FbDrawable &draw,
     // Icon
     //
     if (draw_background) {
-        if (icon() != 0) {
-            // copy pixmap, so we don't resize the original
+        const unsigned int icon_size = height - 2*theme->bevelWidth();
+        // file icons come scaled from the cache, once per size
+        if (m_icon.get() != 0 && m_icon->size != icon_size) {
+            m_icon->pixmap = IconCache::instance().get(m_icon->filename,
+                                                       m_icon->screen_num,
+                                                       icon_size);
+            m_icon->size = icon_size;
+        }
+
+        const PixmapWithMask *pm = icon();
+        if (pm != 0 && pm->pixmap().drawable() != 0) {
+            // scale a copy of any other icon, so we don't resize the original
             FbPixmap tmp_pixmap, tmp_mask;
-            tmp_pixmap.copy(icon()->pixmap());
-            tmp_mask.copy(icon()->mask());
-
-            // scale pixmap to right size
-            if (height - 2*theme->bevelWidth() != tmp_pixmap.height()) {
-                unsigned int scale_size = height - 2*theme->bevelWidth();
-                tmp_pixmap.scale(scale_size, scale_size);
-                tmp_mask.scale(scale_size, scale_size);
+            const FbPixmap *pixmap = &pm->pixmap();
+            const FbPixmap *mask = &pm->mask();
+            if (pm->height() != icon_size || pm->width() != icon_size) {
+                tmp_pixmap.copy(pm->pixmap());
+                tmp_mask.copy(pm->mask());
+                tmp_pixmap.scale(icon_size, icon_size);
+                tmp_mask.scale(icon_size, icon_size);
+                pixmap = &tmp_pixmap;
+                mask = &tmp_mask;
             }
 
-            if (tmp_pixmap.drawable() != 0) {
+            if (pixmap->drawable() != 0) {
                 GC gc = theme->frameTextGC().gc();
                 int icon_x = x + theme->bevelWidth();
                 int icon_y = y + theme->bevelWidth();
                 // enable clip mask
-                XSetClipMask(disp, gc, tmp_mask.drawable());
+                XSetClipMask(disp, gc, mask->drawable());
                 XSetClipOrigin(disp, gc, icon_x, icon_y);
 
-                if (draw.depth() == tmp_pixmap.depth()) {
-                    draw.copyArea(tmp_pixmap.drawable(),
+                if (draw.depth() == pixmap->depth()) {
+                    draw.copyArea(pixmap->drawable(),
                                   gc,
                                   0, 0,
                                   icon_x, icon_y,
-                                  tmp_pixmap.width(), tmp_pixmap.height());
+                                  pixmap->width(), pixmap->height());
                 } else { // TODO: wrong in soon-to-be-common circumstances
                     XGCValues backup;
                     XGetGCValues(draw.display(), gc, GCForeground|GCBackground,
@@ -130,9 +150,9 @@ void MenuItem::draw(FbDrawable &draw,
                                    Color("black", theme->screenNum()).pixel());
                     XSetBackground(draw.display(), gc,
                                    Color("white", theme->screenNum()).pixel());
-                    XCopyPlane(draw.display(), tmp_pixmap.drawable(),
+                    XCopyPlane(draw.display(), pixmap->drawable(),
                                draw.drawable(), gc,
-                               0, 0, tmp_pixmap.width(), tmp_pixmap.height(),
+                               0, 0, pixmap->width(), pixmap->height(),
                                icon_x, icon_y, 1);
                     XSetForeground(draw.display(), gc, backup.foreground);
                     XSetBackground(draw.display(), gc, backup.background);
@@ -318,9 +338,11 @@ void MenuItem::setIcon(const std::string &filename, int screen_num) {
     if (m_icon.get() == 0)
         m_icon.reset(new Icon);
 
+    // loaded when the item is drawn, in the size it needs then
     m_icon->filename = FbTk::StringUtil::expandFilename(filename);
-    m_icon->pixmap.reset(Image::load(m_icon->filename.c_str(),
-                         screen_num));
+    m_icon->screen_num = screen_num;
+    m_icon->pixmap.reset(0);
+    m_icon->size = 0;
 }
 
 unsigned int MenuItem::height(const FbTk::ThemeProxy<MenuTheme> &theme) const {
@@ -339,9 +361,10 @@ void MenuItem::updateTheme(const FbTk::ThemeProxy<MenuTheme> &theme) {
     if (m_icon.get() == 0)
         return;
 
-    m_icon->pixmap.reset(Image::load(m_icon->filename.c_str(), theme->screenNum()));
-
-
+    // the next drawLine() asks the cache, the file might have changed
+    m_icon->screen_num = theme->screenNum();
+    m_icon->pixmap.reset(0);
+    m_icon->size = 0;
 }
 
 void MenuItem::showSubmenu() {
@@ -120,7 +120,8 @@ public:
                       const FbTk::ThemeProxy<MenuTheme> &theme,
                       size_t size,
                       int text_x, int text_y,
-                      unsigned int width) const;
+                      unsigned int width,
+                      size_t start = 0) const;
 
     virtual unsigned int width(const FbTk::ThemeProxy<MenuTheme> &theme) const;
     virtual unsigned int height(const FbTk::ThemeProxy<MenuTheme> &theme) const;
@@ -147,6 +148,20 @@ public:
     void setMenu(Menu &menu) { m_menu = &menu; }
     Menu *menu() { return m_menu; }
 
+    /// the item as its menu rendered it highlighted the last time, with
+    /// what it depended on, so the menu can tell when it is still valid
+    struct Strip {
+        Strip(): generation(0), background(0), width(0), enabled(false), selected(false), icon(0) { }
+        FbPixmap pixmap;
+        unsigned int generation; ///< of the menu's rendering
+        unsigned int background; ///< alphaGeneration() of the translucent frame
+        unsigned int width;
+        FbString label;
+        bool enabled, selected;
+        const PixmapWithMask *icon;
+    };
+    Strip &highlightStrip() { return m_highlight_strip; }
+
 private:
     BiDiString m_label; ///< label of this item
     Menu *m_menu; ///< the menu we live in
@@ -157,10 +172,13 @@ private:
     int m_index;
 
     struct Icon {
-        std::auto_ptr<PixmapWithMask> pixmap;
+        RefCount<PixmapWithMask> pixmap; ///< shared, from the IconCache
         std::string filename;
+        int screen_num;
+        unsigned int size; ///< the pixmap is size x size, 0 if not loaded
     };
     std::auto_ptr<Icon> m_icon;
+    Strip m_highlight_strip;
 
 };
 
@@ -73,6 +73,8 @@ MenuTheme::MenuTheme(int screen_num):
     hilite_gc(RootWindow(m_display, screen_num)),
     m_alpha(255),
     m_delay(0), // no delay as default
+    m_max_columns(0),
+    m_search_mode(TYPEAHEAD_PREFIX),
     m_real_title_height(*m_title_height),
     m_real_item_height(*m_item_height)
 {
@@ -29,6 +29,7 @@
 #include "Texture.hh"
 #include "PixmapWithMask.hh"
 #include "GContext.hh"
+#include "ITypeAheadable.hh"
 
 namespace FbTk {
 
@@ -107,12 +108,25 @@ public:
     unsigned int bevelWidth() const { return *m_bevel_width; }
 
     unsigned char alpha() const { return m_alpha; }
-    void setAlpha(int alpha) { m_alpha = alpha; }
+    void setAlpha(int alpha) {
+        if (alpha != m_alpha)
+            setChanged();
+        m_alpha = alpha;
+    }
     // this isn't actually a theme item
     // but we'll let it be here for now, until there's a better way to
     // get resources into menu
     void setDelay(int msec) { m_delay = msec; }
     int getDelay() const { return m_delay; }
+    /// menus that need more columns scroll instead, 0 for no limit
+    void setMaxColumns(int columns) {
+        if (columns != m_max_columns)
+            setChanged();
+        m_max_columns = columns;
+    }
+    int maxColumns() const { return m_max_columns; }
+    void setSearchMode(TypeAheadMode mode) { m_search_mode = mode; }
+    TypeAheadMode searchMode() const { return m_search_mode; }
 
     const Color &borderColor() const { return *m_border_color; }
     Shape::ShapePlace shapePlaces() const { return *m_shapeplace; }
@@ -155,6 +169,8 @@ private:
 
     int m_alpha;
     unsigned int m_delay; ///< in msec
+    int m_max_columns;
+    TypeAheadMode m_search_mode;
     unsigned int m_real_title_height; ///< the calculated item height (from font and menu.titleHeight)
     unsigned int m_real_item_height; ///< the calculated item height (from font and menu.itemHeight)
 };
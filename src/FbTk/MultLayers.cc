@@ -59,7 +59,11 @@ LayerItem *MultLayers::getLowestItemAboveLayer(int layernum) {
 
 void MultLayers::addToTop(LayerItem &item, int layernum) {
     layernum = FbTk::Util::clamp(layernum, 0, static_cast<signed>(m_layers.size()) - 1);
-    m_layers[layernum]->insert(item);
+    // the item is always in a layer, inserting it again would list it twice
+    if (&item.getLayer() == m_layers[layernum])
+        item.raise();
+    else
+        item.setLayer(*m_layers[layernum]);
     restack();
 }
 
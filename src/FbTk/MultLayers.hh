@@ -23,6 +23,8 @@
 #ifndef FBTK_MULTLAYERS_HH
 #define FBTK_MULTLAYERS_HH
 
+#include "Signal.hh"
+
 #include <vector>
 #include <cstdlib> // size_t
 
@@ -56,6 +58,11 @@ public:
 
     Layer *getLayer(size_t num);
     const Layer *getLayer(size_t num) const;
+    /// number of layers, 0 is the top one
+    size_t numLayers() const { return m_layers.size(); }
+
+    /// emitted when items were added, removed or reordered
+    Signal<> &stackingSig() { return m_stacking_sig; }
 
     bool isUpdatable() const { return m_lock == 0; }
     void lock() { ++m_lock; }
@@ -66,6 +73,7 @@ private:
 
     std::vector<Layer *> m_layers;
     int m_lock;
+    Signal<> m_stacking_sig;
 };
 
 }
@@ -0,0 +1,156 @@
+// ObjectPool.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#include "ObjectPool.hh"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#ifdef __GNUC__
+#include <cxxabi.h>
+#endif // __GNUC__
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+
+namespace FbTk {
+
+namespace {
+
+std::vector<ObjectPool *> &pools() {
+    static std::vector<ObjectPool *> *s_pools = new std::vector<ObjectPool *>();
+    return *s_pools;
+}
+
+std::string className(const std::type_info &type) {
+#ifdef __GNUC__
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(type.name(), 0, 0, &status);
+    if (demangled != 0) {
+        std::string name(demangled);
+        free(demangled);
+        return name;
+    }
+#endif // __GNUC__
+    return type.name();
+}
+
+struct MostLive {
+    bool operator()(const ObjectPool *a, const ObjectPool *b) const {
+        return a->live() > b->live();
+    }
+};
+
+} // anonymous namespace
+
+ObjectPool::ObjectPool(const std::type_info &type, size_t size):
+    m_type(type),
+    m_object_size(size),
+    m_size(size),
+    m_free(0),
+    m_live(0), m_peak(0), m_other(0) {
+
+    // every object has to be aligned like the blocks are
+    const size_t align = sizeof(double) > sizeof(void *) ? sizeof(double) : sizeof(void *);
+    m_size = (std::max(m_size, sizeof(FreeObject)) + align - 1) / align * align;
+    m_block_size = std::max<size_t>(8, 4096 / m_size);
+    pools().push_back(this);
+}
+
+void *ObjectPool::allocate(size_t size) {
+    if (size != m_object_size) {
+        ++m_other;
+        return ::operator new(size);
+    }
+    ++m_live;
+    m_peak = std::max(m_peak, m_live);
+
+#ifdef DEBUG
+    return ::operator new(size);
+#else
+    if (m_free == 0)
+        grow();
+    FreeObject *object = m_free;
+    m_free = object->next;
+    return object;
+#endif // DEBUG
+}
+
+void ObjectPool::deallocate(void *p, size_t size) {
+    if (p == 0)
+        return;
+    if (size != m_object_size) {
+        --m_other;
+        ::operator delete(p);
+        return;
+    }
+    --m_live;
+
+#ifdef DEBUG
+    ::operator delete(p);
+#else
+    FreeObject *object = static_cast<FreeObject *>(p);
+    object->next = m_free;
+    m_free = object;
+#endif // DEBUG
+}
+
+void ObjectPool::grow() {
+    char *block = static_cast<char *>(::operator new(m_block_size * m_size));
+    m_blocks.push_back(block);
+    // hand out the block from its start
+    for (size_t i = m_block_size; i-- > 0; ) {
+        FreeObject *object = reinterpret_cast<FreeObject *>(block + i * m_size);
+        object->next = m_free;
+        m_free = object;
+    }
+}
+
+void ObjectPool::dump(std::ostream &os) {
+    std::vector<ObjectPool *> sorted = pools();
+    std::sort(sorted.begin(), sorted.end(), MostLive());
+
+    os<<std::left<<std::setw(40)<<"pooled objects"<<std::right
+      <<std::setw(8)<<"size"
+      <<std::setw(10)<<"live"
+      <<std::setw(10)<<"peak"
+      <<std::setw(10)<<"KB"
+      <<std::setw(10)<<"derived"<<std::endl;
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        const ObjectPool &pool = *sorted[i];
+        std::string name = className(pool.m_type);
+        if (name.size() > 39)
+            name = name.substr(0, 36) + "...";
+        os<<std::left<<std::setw(40)<<name<<std::right
+          <<std::setw(8)<<pool.m_size
+          <<std::setw(10)<<pool.m_live
+          <<std::setw(10)<<pool.m_peak
+          <<std::setw(10)<<pool.bytes() / 1024
+          <<std::setw(10)<<pool.m_other<<std::endl;
+    }
+}
+
+} // end namespace FbTk
@@ -0,0 +1,97 @@
+// ObjectPool.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#ifndef FBTK_OBJECTPOOL_HH
+#define FBTK_OBJECTPOOL_HH
+
+#include "NotCopyable.hh"
+
+#include <cstddef>
+#include <iosfwd>
+#include <typeinfo>
+#include <vector>
+
+namespace FbTk {
+
+/**
+   Hands out the memory for the objects of one class from blocks of many
+   objects, and keeps the memory of deleted objects for the next ones.
+   Objects that come and go with windows then don't scatter small holes
+   over the heap of a long running session.
+
+   Objects of a larger derived class get their memory from operator new.
+   With DEBUG every object does, so memory checkers see each of them, and
+   the pools only count.
+ */
+class ObjectPool: private NotCopyable {
+public:
+    ObjectPool(const std::type_info &type, size_t size);
+
+    void *allocate(size_t size);
+    void deallocate(void *p, size_t size);
+
+    size_t live() const { return m_live; }
+    size_t peak() const { return m_peak; }
+    /// @return bytes of the blocks
+    size_t bytes() const { return m_blocks.size() * m_block_size * m_size; }
+
+    /// prints the objects of all pools
+    static void dump(std::ostream &os);
+
+private:
+    struct FreeObject {
+        FreeObject *next;
+    };
+
+    void grow();
+
+    const std::type_info &m_type;
+    size_t m_object_size; ///< sizeof the class
+    size_t m_size; ///< of an object in a block, aligned
+    size_t m_block_size; ///< objects per block
+    FreeObject *m_free;
+    std::vector<char *> m_blocks;
+    size_t m_live, m_peak;
+    size_t m_other; ///< live objects of derived classes
+};
+
+/**
+   Derive T from Pooled<T> to take the objects of T from a pool. Only
+   one class in a hierarchy can do so, the operators of two would be
+   ambiguous.
+ */
+template <typename T>
+class Pooled {
+public:
+    static void *operator new(size_t size) { return pool().allocate(size); }
+    static void operator delete(void *p, size_t size) { pool().deallocate(p, size); }
+
+private:
+    static ObjectPool &pool() {
+        // never deleted, some objects go away with other statics
+        static ObjectPool *s_pool = new ObjectPool(typeid(T), sizeof(T));
+        return *s_pool;
+    }
+};
+
+} // end namespace FbTk
+
+#endif // FBTK_OBJECTPOOL_HH
@@ -0,0 +1,316 @@
+// PropertyPrefetch.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "PropertyPrefetch.hh"
+#include "App.hh"
+#include "RoundTrips.hh"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#ifdef HAVE_XCB
+#include <X11/Xlib-xcb.h>
+#include <xcb/xcb.h>
+#include <xcb/xcbext.h> // xcb_poll_for_reply
+#endif // HAVE_XCB
+
+#ifdef HAVE_INTTYPES_H
+#include <inttypes.h>
+#else
+#include <stdint.h>
+#endif
+
+#include <cstdlib>
+#include <cstring>
+
+namespace FbTk {
+
+namespace {
+
+/// in 32 bit units, as much as XGetTextProperty() asks for
+const unsigned long MAX_LENGTH = 1000000;
+/// in 32 bit units, what a cache keeps of a property; icons are larger
+const unsigned long CACHE_LENGTH = 1024;
+
+} // end anonymous namespace
+
+struct PropertyPrefetch::Reply {
+#ifdef HAVE_XCB
+    xcb_get_property_cookie_t cookie;
+#endif // HAVE_XCB
+    bool pending; ///< not read from the connection yet
+    bool valid; ///< the request succeeded
+    Atom type;
+    int format;
+    unsigned long bytes_after; ///< what didn't fit into MAX_LENGTH
+    std::vector<unsigned char> data; ///< as the server sent it
+};
+
+PropertyPrefetch::Prefetches PropertyPrefetch::s_prefetches;
+
+PropertyPrefetch::PropertyPrefetch(Window win, const std::vector<Atom> &atoms):
+    m_window(win), m_previous(0), m_cache(false) {
+
+    link();
+
+#ifdef HAVE_XCB
+    xcb_connection_t *conn = XGetXCBConnection(App::instance()->display());
+    for (size_t i = 0; i < atoms.size(); ++i) {
+        // the outer prefetches answer for what they asked already
+        if (m_previous && m_previous->requested(atoms[i]))
+            continue;
+        Reply *&reply = m_replies[atoms[i]];
+        if (reply != 0)
+            continue;
+        reply = new Reply;
+        reply->cookie = xcb_get_property(conn, 0, win, atoms[i],
+                                         XCB_GET_PROPERTY_TYPE_ANY, 0, MAX_LENGTH);
+        reply->pending = true;
+        reply->valid = false;
+    }
+    // the server answers while we do other things
+    xcb_flush(conn);
+#endif // HAVE_XCB
+}
+
+PropertyPrefetch::PropertyPrefetch(Window win):
+    m_window(win), m_previous(0), m_cache(true) {
+
+    link();
+}
+
+PropertyPrefetch::~PropertyPrefetch() {
+    Replies::iterator it = m_replies.begin();
+    for (; it != m_replies.end(); ++it)
+        discard(it->second);
+
+    // a cache usually outlives the prefetches beneath it
+    PropertyPrefetch *&top = s_prefetches[m_window];
+    if (top == this) {
+        if (m_previous)
+            top = m_previous;
+        else
+            s_prefetches.erase(m_window);
+        return;
+    }
+    for (PropertyPrefetch *prefetch = top; prefetch != 0;
+         prefetch = prefetch->m_previous) {
+        if (prefetch->m_previous == this) {
+            prefetch->m_previous = m_previous;
+            break;
+        }
+    }
+}
+
+void PropertyPrefetch::link() {
+    Prefetches::iterator it = s_prefetches.find(m_window);
+    if (it != s_prefetches.end())
+        m_previous = it->second;
+    s_prefetches[m_window] = this;
+}
+
+void PropertyPrefetch::discard(Reply *reply) {
+#ifdef HAVE_XCB
+    // don't leave the reply in the connection
+    if (reply->pending)
+        xcb_discard_reply(XGetXCBConnection(App::instance()->display()),
+                          reply->cookie.sequence);
+#endif // HAVE_XCB
+    delete reply;
+}
+
+bool PropertyPrefetch::requested(Atom property) const {
+    return m_replies.find(property) != m_replies.end() ||
+        (m_previous && m_previous->requested(property));
+}
+
+PropertyPrefetch::Reply *PropertyPrefetch::fetch(Atom property) {
+    Atom type = None;
+    int format = 0;
+    unsigned long nitems = 0, bytes_after = 0;
+    unsigned char *data = 0;
+    FBTK_ROUNDTRIP("PropertyPrefetch::fetch");
+    if (XGetWindowProperty(App::instance()->display(), m_window, property,
+                           0, CACHE_LENGTH, False, AnyPropertyType,
+                           &type, &format, &nitems, &bytes_after,
+                           &data) != Success)
+        return 0;
+
+    Reply *reply = new Reply;
+    reply->pending = false;
+    reply->valid = true;
+    reply->type = type;
+    reply->format = format;
+    reply->bytes_after = bytes_after;
+    if (format == 32) {
+        // back to what the server sent, Xlib made longs of them
+        reply->data.resize(nitems * 4);
+        for (unsigned long i = 0; i < nitems; ++i) {
+            int32_t value = reinterpret_cast<long *>(data)[i];
+            memcpy(&reply->data[i * 4], &value, 4);
+        }
+    } else if (format != 0)
+        reply->data.assign(data, data + nitems * (format / 8));
+    if (data)
+        XFree(data);
+    return reply;
+}
+
+PropertyPrefetch::Reply *PropertyPrefetch::reply(Atom property) {
+    Replies::iterator it = m_replies.find(property);
+    if (it == m_replies.end()) {
+        Reply *outer = m_previous ? m_previous->reply(property) : 0;
+        if (!m_cache)
+            return outer;
+        if (outer && outer->data.size() > CACHE_LENGTH * 4)
+            return outer; // not worth keeping
+
+        Reply *reply = outer ? new Reply(*outer) : fetch(property);
+        if (reply)
+            m_replies[property] = reply;
+        return reply;
+    }
+
+    Reply &reply = *it->second;
+#ifdef HAVE_XCB
+    if (reply.pending) {
+        reply.pending = false;
+        xcb_connection_t *conn = XGetXCBConnection(App::instance()->display());
+        void *raw = 0;
+        xcb_generic_error_t *error = 0;
+        // only the first reply should have to be waited for
+        if (!xcb_poll_for_reply(conn, reply.cookie.sequence, &raw, &error)) {
+            FBTK_ROUNDTRIP("PropertyPrefetch::reply");
+            raw = xcb_get_property_reply(conn, reply.cookie, &error);
+        }
+
+        xcb_get_property_reply_t *prop = static_cast<xcb_get_property_reply_t *>(raw);
+        if (prop) {
+            const unsigned char *value =
+                static_cast<const unsigned char *>(xcb_get_property_value(prop));
+            reply.valid = true;
+            reply.type = prop->type;
+            reply.format = prop->format;
+            reply.bytes_after = prop->bytes_after;
+            reply.data.assign(value, value + prop->value_len * (prop->format / 8));
+            free(prop);
+        }
+        free(error);
+    }
+#endif // HAVE_XCB
+
+    return reply.valid ? &reply : 0;
+}
+
+bool PropertyPrefetch::lookup(Window win, Atom property,
+                              long long_offset, long long_length,
+                              bool do_delete, Atom req_type,
+                              Atom *actual_type_return,
+                              int *actual_format_return,
+                              unsigned long *nitems_return,
+                              unsigned long *bytes_after_return,
+                              unsigned char **prop_return) {
+
+    Prefetches::iterator it = s_prefetches.find(win);
+    if (it == s_prefetches.end() || do_delete ||
+        long_offset < 0 || long_length < 0)
+        return false;
+
+    Reply *reply = it->second->reply(property);
+    if (reply == 0)
+        return false;
+
+    // below, it's what XGetWindowProperty() would return
+    unsigned long size = reply->data.size();
+    unsigned long start = static_cast<unsigned long>(long_offset) * 4;
+    if (reply->type != None && start > size)
+        return false; // an error, or beyond what we have
+
+    *actual_type_return = reply->type;
+    *actual_format_return = reply->format;
+    *nitems_return = 0;
+    *prop_return = 0;
+
+    if (reply->type == None) {
+        *actual_format_return = 0;
+        *bytes_after_return = 0;
+        return true;
+    }
+
+    if (req_type != AnyPropertyType && req_type != reply->type) {
+        *bytes_after_return = size + reply->bytes_after;
+        return true;
+    }
+
+    unsigned long bytes = size - start;
+    if (static_cast<unsigned long>(long_length) < (bytes + 3) / 4)
+        bytes = static_cast<unsigned long>(long_length) * 4;
+    else if (reply->bytes_after != 0)
+        return false; // wants more than we have
+
+    unsigned int unit = reply->format / 8;
+    unsigned long nitems = bytes / unit;
+    size_t alloc = nitems;
+    if (reply->format == 32)
+        alloc *= sizeof(long);
+    else if (reply->format == 16)
+        alloc *= sizeof(short);
+
+    unsigned char *data = static_cast<unsigned char *>(malloc(alloc + 1));
+    if (data == 0)
+        return false;
+
+    const unsigned char *src = nitems ? &reply->data[start] : 0;
+    if (reply->format == 32) {
+        // Xlib sign extends 32 bit values to long
+        long *dest = reinterpret_cast<long *>(data);
+        for (unsigned long i = 0; i < nitems; ++i) {
+            int32_t value;
+            memcpy(&value, src + i * 4, 4);
+            dest[i] = value;
+        }
+    } else if (nitems) {
+        memcpy(data, src, alloc);
+    }
+    data[alloc] = 0;
+
+    *nitems_return = nitems;
+    // including what didn't fit into the prefetch
+    *bytes_after_return = size - start - bytes + reply->bytes_after;
+    *prop_return = data;
+    return true;
+}
+
+void PropertyPrefetch::forget(Window win, Atom property) {
+    Prefetches::iterator it = s_prefetches.find(win);
+    for (PropertyPrefetch *prefetch = it != s_prefetches.end() ? it->second : 0;
+         prefetch != 0; prefetch = prefetch->m_previous) {
+        Replies::iterator reply = prefetch->m_replies.find(property);
+        if (reply == prefetch->m_replies.end())
+            continue;
+        discard(reply->second);
+        prefetch->m_replies.erase(reply);
+    }
+}
+
+} // end namespace FbTk
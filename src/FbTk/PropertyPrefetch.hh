@@ -0,0 +1,100 @@
+// PropertyPrefetch.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#ifndef FBTK_PROPERTYPREFETCH_HH
+#define FBTK_PROPERTYPREFETCH_HH
+
+#include "NotCopyable.hh"
+
+#include <X11/Xlib.h>
+
+#include <map>
+#include <vector>
+
+namespace FbTk {
+
+/**
+   Requests a set of properties of a window at once, so reading them costs
+   one round-trip instead of one each. While the prefetch exists,
+   FbWindow::property() and the other readers that call lookup() get the
+   replies from it. Keep it only as long as the properties can't have
+   changed in between, e.g. while a new window is set up.
+
+   Prefetches of the same window nest: an inner one only asks for what
+   the outer ones don't have, and answers with their replies too.
+
+   Needs XCB, without it lookup() never finds anything and the properties
+   are read one by one as before.
+
+   A cache of a window, made with the constructor without atoms, keeps
+   every property that is read while it exists, up to CACHE_LENGTH. Those
+   who keep one must forget() the properties of each PropertyNotify.
+*/
+class PropertyPrefetch: private NotCopyable {
+public:
+    PropertyPrefetch(Window win, const std::vector<Atom> &atoms);
+    /// a cache of the properties of 'win'
+    explicit PropertyPrefetch(Window win);
+    ~PropertyPrefetch();
+
+    /**
+       Answers an XGetWindowProperty() from the prefetch of 'win', if there
+       is one with 'property'. The reply is allocated like Xlib does, so
+       free it with XFree().
+       @return true if the request was answered
+    */
+    static bool lookup(Window win, Atom property,
+                       long long_offset, long long_length,
+                       bool do_delete, Atom req_type,
+                       Atom *actual_type_return,
+                       int *actual_format_return,
+                       unsigned long *nitems_return,
+                       unsigned long *bytes_after_return,
+                       unsigned char **prop_return);
+
+    /// 'property' of 'win' changed, it is read from the server again
+    static void forget(Window win, Atom property);
+
+private:
+    struct Reply;
+    typedef std::map<Atom, Reply *> Replies;
+    typedef std::map<Window, PropertyPrefetch *> Prefetches;
+
+    void link();
+    /// reads 'property' into the cache
+    Reply *fetch(Atom property);
+    /// @return true if this or an outer prefetch asks for 'property'
+    bool requested(Atom property) const;
+    /// @return the reply for 'property', 0 if it wasn't requested or failed
+    Reply *reply(Atom property);
+    static void discard(Reply *reply);
+
+    Window m_window;
+    Replies m_replies;
+    PropertyPrefetch *m_previous; ///< of the same window
+    bool m_cache;
+    static Prefetches s_prefetches;
+};
+
+} // end namespace FbTk
+
+#endif // FBTK_PROPERTYPREFETCH_HH
@@ -0,0 +1,289 @@
+// Reactor.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#include "Reactor.hh"
+
+#ifdef HAVE_CERRNO
+  #include <cerrno>
+#else
+  #include <errno.h>
+#endif
+
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#include <fcntl.h>
+#endif // HAVE_SYS_EPOLL_H
+
+#include <poll.h>
+#include <unistd.h>
+#include <limits.h>
+
+namespace FbTk {
+
+/// the os specific part of the reactor
+class Reactor::Backend {
+public:
+    virtual ~Backend() { }
+    virtual bool add(int fd, int events) = 0;
+    virtual void modify(int fd, int events) = 0;
+    virtual void remove(int fd) = 0;
+    /// fills 'ready' with the descriptors which are ready
+    /// @return -1 on error, number of ready descriptors else
+    virtual int wait(int timeout_ms, std::vector<std::pair<int, int> > &ready) = 0;
+    virtual const char *name() const = 0;
+};
+
+namespace {
+
+/// plain poll(2), rebuilds the pollfd array when the set of watches changed
+class PollBackend: public Reactor::Backend {
+public:
+    PollBackend(): m_dirty(false) { }
+
+    bool add(int fd, int events) {
+        m_events[fd] = events;
+        m_dirty = true;
+        return true;
+    }
+
+    void modify(int fd, int events) {
+        add(fd, events);
+    }
+
+    void remove(int fd) {
+        m_events.erase(fd);
+        m_dirty = true;
+    }
+
+    int wait(int timeout_ms, std::vector<std::pair<int, int> > &ready) {
+        if (m_dirty) {
+            m_fds.clear();
+            std::map<int, int>::const_iterator it = m_events.begin();
+            for (; it != m_events.end(); ++it) {
+                pollfd pfd;
+                pfd.fd = it->first;
+                pfd.events = (it->second & Reactor::READ ? POLLIN : 0) |
+                             (it->second & Reactor::WRITE ? POLLOUT : 0);
+                pfd.revents = 0;
+                m_fds.push_back(pfd);
+            }
+            m_dirty = false;
+        }
+
+        int num = poll(m_fds.empty() ? 0 : &m_fds[0], m_fds.size(), timeout_ms);
+        if (num <= 0)
+            return num;
+
+        for (size_t i = 0; i < m_fds.size(); ++i) {
+            short revents = m_fds[i].revents;
+            if (revents == 0)
+                continue;
+            int events = 0;
+            // a closed descriptor would come back from every poll()
+            if (revents & POLLNVAL) {
+                ready.push_back(std::make_pair(m_fds[i].fd, int(Reactor::INVALID)));
+                continue;
+            }
+            // errors and hangups are reported as readable too, so that the
+            // handler notices them on its next read()
+            if (revents & (POLLIN | POLLERR | POLLHUP))
+                events |= Reactor::READ;
+            if (revents & POLLOUT)
+                events |= Reactor::WRITE;
+            if (revents & POLLERR)
+                events |= Reactor::INVALID;
+            ready.push_back(std::make_pair(m_fds[i].fd, events));
+        }
+        return ready.size();
+    }
+
+    const char *name() const { return "poll"; }
+
+private:
+    std::map<int, int> m_events;
+    std::vector<pollfd> m_fds;
+    bool m_dirty;
+};
+
+#ifdef HAVE_SYS_EPOLL_H
+
+class EpollBackend: public Reactor::Backend {
+public:
+    EpollBackend(int epoll_fd): m_epoll_fd(epoll_fd) { }
+    ~EpollBackend() { close(m_epoll_fd); }
+
+    /// @return 0 if epoll isn't available
+    static EpollBackend *create() {
+        int fd = epoll_create(16);
+        if (fd == -1)
+            return 0;
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        return new EpollBackend(fd);
+    }
+
+    bool add(int fd, int events) {
+        epoll_event ev = makeEvent(fd, events);
+        return epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &ev) == 0;
+    }
+
+    void modify(int fd, int events) {
+        epoll_event ev = makeEvent(fd, events);
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+    }
+
+    void remove(int fd) {
+        // the event argument is ignored, but old kernels want one
+        epoll_event ev = makeEvent(fd, 0);
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, &ev);
+    }
+
+    int wait(int timeout_ms, std::vector<std::pair<int, int> > &ready) {
+        epoll_event events[32];
+        int num = epoll_wait(m_epoll_fd, events, sizeof(events)/sizeof(events[0]), timeout_ms);
+        for (int i = 0; i < num; ++i) {
+            int ev = 0;
+            if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+                ev |= Reactor::READ;
+            if (events[i].events & EPOLLOUT)
+                ev |= Reactor::WRITE;
+            if (events[i].events & EPOLLERR)
+                ev |= Reactor::INVALID;
+            int fd = events[i].data.fd;
+            ready.push_back(std::make_pair(fd, ev));
+        }
+        return num;
+    }
+
+    const char *name() const { return "epoll"; }
+
+private:
+    static epoll_event makeEvent(int fd, int events) {
+        epoll_event ev;
+        ev.events = 0;
+        if (events & Reactor::READ)
+            ev.events |= EPOLLIN;
+        if (events & Reactor::WRITE)
+            ev.events |= EPOLLOUT;
+        ev.data.u64 = 0;
+        ev.data.fd = fd;
+        return ev;
+    }
+
+    int m_epoll_fd;
+};
+
+#endif // HAVE_SYS_EPOLL_H
+
+} // anonymous namespace
+
+Reactor &Reactor::instance() {
+    static Reactor reactor;
+    return reactor;
+}
+
+Reactor::Reactor() {
+#ifdef HAVE_SYS_EPOLL_H
+    m_backend.reset(EpollBackend::create());
+#endif // HAVE_SYS_EPOLL_H
+    if (m_backend.get() == 0)
+        m_backend.reset(new PollBackend());
+}
+
+Reactor::~Reactor() {
+}
+
+void Reactor::add(int fd, int events, const RefCount<Handler> &handler) {
+    if (fd < 0 || !handler)
+        return;
+
+    Watches::iterator it = m_watches.find(fd);
+    if (it != m_watches.end()) {
+        it->second.handler = handler;
+        if (it->second.events != events) {
+            it->second.events = events;
+            m_backend->modify(fd, events);
+        }
+        return;
+    }
+
+    if (!m_backend->add(fd, events))
+        return;
+
+    Watch &watch = m_watches[fd];
+    watch.events = events;
+    watch.handler = handler;
+}
+
+void Reactor::setEvents(int fd, int events) {
+    Watches::iterator it = m_watches.find(fd);
+    if (it == m_watches.end() || it->second.events == events)
+        return;
+    it->second.events = events;
+    m_backend->modify(fd, events);
+}
+
+void Reactor::remove(int fd) {
+    Watches::iterator it = m_watches.find(fd);
+    if (it == m_watches.end())
+        return;
+    m_backend->remove(fd);
+    m_watches.erase(it);
+}
+
+int Reactor::wait(int64_t timeout) {
+
+    int timeout_ms = -1;
+    if (timeout >= 0) {
+        // round up, waking up too early just means another round
+        timeout = (timeout + 999) / 1000;
+        timeout_ms = timeout > INT_MAX ? INT_MAX : static_cast<int>(timeout);
+    }
+
+    m_ready.clear();
+    int num = m_backend->wait(timeout_ms, m_ready);
+    if (num < 0)
+        return errno == EINTR ? -1 : 0;
+
+    int called = 0;
+    for (size_t i = 0; i < m_ready.size(); ++i) {
+        // a handler might have removed any of the watches
+        Watches::iterator it = m_watches.find(m_ready[i].first);
+        if (it == m_watches.end())
+            continue;
+        // keep the handler alive, even if it removes itself
+        RefCount<Handler> handler = it->second.handler;
+        if (m_ready[i].second & INVALID) {
+            // it would be ready again right away, forever
+            m_backend->remove(it->first);
+            m_watches.erase(it);
+        }
+        (*handler)(m_ready[i].first, m_ready[i].second);
+        ++called;
+    }
+
+    return called;
+}
+
+const char *Reactor::backendName() const {
+    return m_backend->name();
+}
+
+} // end namespace FbTk
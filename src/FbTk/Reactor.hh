@@ -0,0 +1,109 @@
+// Reactor.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#ifndef FBTK_REACTOR_HH
+#define FBTK_REACTOR_HH
+
+#include "NotCopyable.hh"
+#include "RefCount.hh"
+#include "Slot.hh"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#ifdef HAVE_INTTYPES_H
+#include <inttypes.h>
+#else
+#include <stdint.h>
+#endif // HAVE_INTTYPES_H
+
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace FbTk {
+
+/**
+   Waits for several file descriptors at once and calls the handler of
+   every descriptor which became ready.
+
+   Uses epoll where available and poll(2) everywhere else. Timers are not
+   handled here, see Timer::updateTimers(), which sleeps in wait().
+ */
+class Reactor: private NotCopyable {
+public:
+    enum Events {
+        READ = 1,
+        WRITE = 2,
+        /// the descriptor is closed or broken; it isn't watched anymore
+        /// when the handler gets this, so it won't be reported again
+        INVALID = 4
+    };
+
+    /// called with the descriptor and the Events it is ready for
+    typedef Slot<void, int, int> Handler;
+
+    class Backend;
+
+    static Reactor &instance();
+
+    /// watch 'fd' for 'events', replaces earlier handlers of 'fd'
+    void add(int fd, int events, const RefCount<Handler> &handler);
+    template <typename Functor>
+    void addFunctor(int fd, int events, const Functor &functor) {
+        add(fd, events, RefCount<Handler>(new SlotImpl<Functor, void, int, int>(functor)));
+    }
+    /// change the events 'fd' is watched for
+    void setEvents(int fd, int events);
+    /// stop watching 'fd', call this before closing it
+    void remove(int fd);
+
+    /**
+       waits until at least one of the descriptors is ready
+       @param timeout in micro-seconds, negative means no timeout
+       @return number of called handlers, 0 on timeout, -1 if interrupted
+     */
+    int wait(int64_t timeout);
+
+    bool isWatching(int fd) const { return m_watches.find(fd) != m_watches.end(); }
+    size_t numWatches() const { return m_watches.size(); }
+    /// @return name of the backend in use
+    const char *backendName() const;
+
+private:
+    Reactor();
+    ~Reactor();
+
+    struct Watch {
+        int events;
+        RefCount<Handler> handler;
+    };
+    typedef std::map<int, Watch> Watches;
+
+    Watches m_watches;
+    std::auto_ptr<Backend> m_backend;
+    std::vector<std::pair<int, int> > m_ready; ///< fd and ready events
+};
+
+} // end namespace FbTk
+
+#endif // FBTK_REACTOR_HH
@@ -24,7 +24,29 @@
 
 namespace FbTk {
 
+/**
+ * A base for classes that count their RefCounts themselves. A RefCount
+ * to one of them needs no counter of its own, so creating it allocates
+ * nothing and copies of it only touch the object.
+ * RefCounts of such a class can only be converted to RefCounts of
+ * classes that are RefCounted too.
+ */
+class RefCounted {
+protected:
+    RefCounted(): m_refcount(0) { }
+    // a copy is referenced by nobody yet
+    RefCounted(const RefCounted &): m_refcount(0) { }
+    RefCounted &operator = (const RefCounted &) { return *this; }
+    ~RefCounted() { }
+
+private:
+    template <typename Pointer>
+    friend class RefCount;
+    mutable unsigned int m_refcount;
+};
+
 /// holds a pointer with reference counting, similar to std:auto_ptr
+/// an empty RefCount has no counter and allocates nothing
 template <typename Pointer>
 class RefCount {
     typedef Pointer* RefCount::*bool_type;
@@ -41,10 +63,23 @@ public:
     Pointer *operator -> () const { return get(); }
     Pointer *get() const { return m_data; }
     void reset(Pointer *p = 0);
+    /// @return how many RefCounts share the pointer
+    unsigned int useCount() const { return m_refcount ? *m_refcount : 0; }
     /// conversion to "bool"
     operator bool_type() const { return m_data ? &RefCount::m_data : 0; }
 
 private:
+    /// @return the counter of 'p', 0 if it needs one of its own
+    static unsigned int *counterOf(const volatile RefCounted *p) {
+        return &const_cast<RefCounted *>(p)->m_refcount;
+    }
+    static unsigned int *counterOf(const volatile void *) { return 0; }
+    /// to tell at compile time if Pointer is RefCounted
+    static char (&isIntrusive(const volatile RefCounted *))[2];
+    static char isIntrusive(const volatile void *);
+
+    /// @return a counter for 'p', 0 for no pointer
+    static unsigned int *newCounter(Pointer *p);
     /// increase reference count
     void incRefCount();
     /// decrease reference count
@@ -60,8 +95,7 @@ private:
 // implementation
 
 template <typename Pointer>
-RefCount<Pointer>::RefCount():m_data(0), m_refcount(new unsigned int(0)) {
-    incRefCount(); // it really counts how many things are storing m_refcount
+RefCount<Pointer>::RefCount():m_data(0), m_refcount(0) {
 }
 
 template <typename Pointer>
@@ -69,11 +103,15 @@ template <typename Pointer2>
 RefCount<Pointer>::RefCount(const RefCount<Pointer2> &copy):
     m_data(copy.m_data),
     m_refcount(copy.m_refcount) {
+    // both have to agree on where the counter is
+    typedef char same_counting[sizeof(isIntrusive(static_cast<Pointer *>(0))) ==
+                               sizeof(isIntrusive(static_cast<Pointer2 *>(0))) ? 1 : -1];
+    (void)sizeof(same_counting);
     incRefCount();
 }
 
 template <typename Pointer>
-RefCount<Pointer>::RefCount(Pointer *p):m_data(p), m_refcount(new unsigned int(0)) {
+RefCount<Pointer>::RefCount(Pointer *p):m_data(p), m_refcount(newCounter(p)) {
     incRefCount();
 }
 
@@ -91,10 +129,11 @@ RefCount<Pointer>::~RefCount() {
 
 template <typename Pointer>
 RefCount<Pointer> &RefCount<Pointer>::operator = (const RefCount<Pointer> &copy) {
+    if (copy.m_refcount)
+        ++(*copy.m_refcount); // first, in case it's the last one to us
     decRefCount(); // dec current ref count
     m_refcount = copy.m_refcount; // set new ref count
     m_data = copy.m_data; // set new data pointer
-    incRefCount(); // inc new ref count 
     return *this;
 }
 
@@ -102,27 +141,36 @@ template <typename Pointer>
 void RefCount<Pointer>::reset(Pointer *p) {
     decRefCount();
     m_data = p; // set data pointer
-    m_refcount = new unsigned int(0); // create new counter
+    m_refcount = newCounter(p); // create new counter
     incRefCount();
 }
 
+template <typename Pointer>
+unsigned int *RefCount<Pointer>::newCounter(Pointer *p) {
+    // where the counter is can't be told without the whole type
+    typedef char complete_type[sizeof(Pointer) ? 1 : -1];
+    (void)sizeof(complete_type);
+    if (p == 0)
+        return 0;
+    unsigned int *counter = counterOf(p);
+    return counter ? counter : new unsigned int(0);
+}
+
 template <typename Pointer>
 void RefCount<Pointer>::decRefCount() {
+    typedef char complete_type[sizeof(Pointer) ? 1 : -1];
+    (void)sizeof(complete_type);
     if (m_refcount == 0)
         return;
-    if (*m_refcount == 0) { // already zero, then delete refcount
-        delete m_refcount;
-        m_refcount = 0;
-        return;
-    }
     (*m_refcount)--;
     if (*m_refcount == 0) { // destroy m_data and m_refcount if nobody else is using this
-        if (m_data != 0)
-            delete m_data;
-        m_data = 0;
-        delete m_refcount;
-        m_refcount = 0;
+        // the counter of a RefCounted goes with it
+        if (sizeof(isIntrusive(m_data)) == 1)
+            delete m_refcount;
+        delete m_data;
     }
+    m_data = 0;
+    m_refcount = 0;
 }
 
 template <typename Pointer>
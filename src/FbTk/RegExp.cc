@@ -29,11 +29,37 @@
 
 #include <iostream>
 
+#ifdef USE_REGEXP
+#include <cstring>
+#endif // USE_REGEXP
+
 using std::string;
 
 #ifdef USE_REGEXP
 using std::cerr;
 using std::endl;
+
+namespace {
+
+bool isMeta(char c) {
+    return c != '\0' && strchr("\\^$.[]|()*+?{}", c) != 0;
+}
+
+// only ascii, a case class in the pattern is exactly those two chars
+char lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+bool equalFolded(const char *str, const string &literal, const string &fold) {
+    for (size_t i = 0; i < literal.size(); ++i) {
+        char c = fold[i] ? lower(str[i]) : str[i];
+        if (c != literal[i])
+            return false;
+    }
+    return true;
+}
+
+} // end anonymous namespace
 #endif // USE_REGEXP
 
 namespace FbTk {
@@ -42,7 +68,11 @@ namespace FbTk {
 // or just a substring. Substrings aren't supported if not HAVE_REGEXP
 RegExp::RegExp(const string &str, bool full_match):
 #ifdef USE_REGEXP
-m_regex(0) {
+m_regex(0),
+m_kind(REGEX) {
+    if (parseLiteral(str, full_match))
+        return;
+
     string match;
     if (full_match) {
         match = "^";
@@ -74,6 +104,8 @@ RegExp::~RegExp() {
 
 bool RegExp::match(const string &str) const {
 #ifdef USE_REGEXP
+    if (m_kind != REGEX)
+        return matchLiteral(str.c_str(), str.size());
     if (m_regex)
         return regexec(m_regex, str.c_str(), 0, 0, 0) == 0;
     else
@@ -86,10 +118,106 @@ bool RegExp::match(const string &str) const {
 
 bool RegExp::error() const {
 #ifdef USE_REGEXP
-    return m_regex == 0;
+    return m_kind == REGEX && m_regex == 0;
 #else
     return m_str == "";
 #endif // USE_REGEXP
 }
 
+#ifdef USE_REGEXP
+bool RegExp::parseLiteral(const string &str, bool full_match) {
+
+    bool anchor_start = full_match, anchor_end = full_match;
+    size_t begin = 0, end = str.size();
+
+    if (str.compare(0, 1, "^") == 0) {
+        anchor_start = true;
+        begin = 1;
+    } else if (str.compare(0, 2, ".*") == 0) {
+        anchor_start = false;
+        begin = 2;
+    }
+    if (end > begin && str[end - 1] == '$') {
+        anchor_end = true;
+        end -= 1;
+    } else if (end >= begin + 2 && str.compare(end - 2, 2, ".*") == 0) {
+        anchor_end = false;
+        end -= 2;
+    }
+
+    // what's left must be plain characters, escaped meta characters or
+    // case classes like [Xx]
+    string literal, fold;
+    bool folded = false;
+    for (size_t i = begin; i < end; ++i) {
+        char c = str[i];
+        if (c == '\\') {
+            if (i + 1 >= end || !isMeta(str[i + 1]))
+                return false;
+            literal += str[++i];
+            fold += '\0';
+        } else if (c == '[') {
+            if (i + 3 >= end || str[i + 3] != ']')
+                return false;
+            char a = str[i + 1], b = str[i + 2];
+            if (a == b || lower(a) != lower(b))
+                return false;
+            literal += lower(a);
+            fold += '\1';
+            folded = true;
+            i += 3;
+        } else if (isMeta(c)) {
+            return false;
+        } else {
+            literal += c;
+            fold += '\0';
+        }
+    }
+
+    m_literal = literal;
+    if (folded)
+        m_fold = fold;
+    if (anchor_start)
+        m_kind = anchor_end ? EQUAL : PREFIX;
+    else
+        m_kind = anchor_end ? SUFFIX : CONTAINS;
+    return true;
+}
+
+bool RegExp::matchLiteral(const char *str, size_t len) const {
+
+    const size_t size = m_literal.size();
+    if (len < size)
+        return false;
+
+    if (m_fold.empty()) {
+        switch (m_kind) {
+        case EQUAL:
+            return len == size && memcmp(str, m_literal.data(), size) == 0;
+        case PREFIX:
+            return memcmp(str, m_literal.data(), size) == 0;
+        case SUFFIX:
+            return memcmp(str + len - size, m_literal.data(), size) == 0;
+        default:
+            return memmem(str, len, m_literal.data(), size) != 0;
+        }
+    }
+
+    switch (m_kind) {
+    case EQUAL:
+        return len == size && equalFolded(str, m_literal, m_fold);
+    case PREFIX:
+        return equalFolded(str, m_literal, m_fold);
+    case SUFFIX:
+        return equalFolded(str + len - size, m_literal, m_fold);
+    default:
+        for (size_t i = 0; i + size <= len; ++i) {
+            if (equalFolded(str + i, m_literal, m_fold))
+                return true;
+        }
+        return false;
+    }
+}
+#endif // USE_REGEXP
+
 } // end namespace FbTk
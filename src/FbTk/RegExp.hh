@@ -43,6 +43,12 @@
 
 namespace FbTk {
 
+/**
+ * A POSIX extended regular expression.
+ * Patterns that are only a literal, maybe anchored with '^' or '$' or
+ * open ended with '.*', and maybe with case classes like '[Xx]', are
+ * matched with plain string compares instead of regexec.
+ */
 class RegExp: private NotCopyable {
 public:
     RegExp(const std::string &str, bool full_match = true);
@@ -54,7 +60,24 @@ public:
 
 private:
 #ifdef USE_REGEXP
+    /// how the pattern is matched
+    enum Kind {
+        REGEX,    ///< regexec
+        EQUAL,    ///< the string is m_literal
+        PREFIX,   ///< the string starts with m_literal
+        SUFFIX,   ///< the string ends with m_literal
+        CONTAINS  ///< the string contains m_literal
+    };
+
+    /// sets up a literal kind if the pattern is one, @return true if so
+    bool parseLiteral(const std::string &str, bool full_match);
+    bool matchLiteral(const char *str, size_t len) const;
+
     regex_t* m_regex;
+    Kind m_kind;
+    std::string m_literal;
+    /// for each char in m_literal, whether it matches either case, or empty
+    std::string m_fold;
 #else // notdef USE_REGEXP
     std::string m_str;
 #endif // USE_REGEXP
@@ -0,0 +1,100 @@
+// RequestStats.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#include "RequestStats.hh"
+#include "EventStats.hh"
+
+#include <iomanip>
+#include <iostream>
+
+namespace FbTk {
+
+RequestStats::Widget::Widget(const std::type_info &type):
+    m_active(false), m_counts(0) {
+    RequestStats &stats = RequestStats::instance();
+    if (!stats.m_enabled)
+        return;
+    m_active = true;
+    m_counts = stats.m_current;
+    stats.m_current = stats.m_widgets[&type].requests;
+}
+
+RequestStats::Widget::~Widget() {
+    if (m_active)
+        RequestStats::instance().m_current = m_counts;
+}
+
+RequestStats::Counts::Counts() {
+    for (int i = 0; i < NUM_REQUESTS; ++i)
+        requests[i] = 0;
+}
+
+RequestStats::RequestStats(): m_enabled(false), m_current(m_other.requests) { }
+
+RequestStats &RequestStats::instance() {
+    static RequestStats s_instance;
+    return s_instance;
+}
+
+const char *RequestStats::requestName(Request request) {
+    static const char *names[NUM_REQUESTS] = {
+        "copy_area", "fill_rectangle", "draw_other", "draw_text",
+        "clear", "set_background", "move_resize", "create_pixmap"
+    };
+    return names[request];
+}
+
+void RequestStats::dump(std::ostream &os) const {
+    os<<std::left<<std::setw(32)<<"widget"<<std::right;
+    for (int r = 0; r < NUM_REQUESTS; ++r)
+        os<<std::setw(15)<<requestName(Request(r));
+    os<<std::endl;
+
+    WidgetCounts::const_iterator it = m_widgets.begin();
+    for (; it != m_widgets.end(); ++it) {
+        os<<std::left<<std::setw(32)<<EventStats::className(*it->first)<<std::right;
+        for (int r = 0; r < NUM_REQUESTS; ++r)
+            os<<std::setw(15)<<it->second.requests[r];
+        os<<std::endl;
+    }
+    os<<std::left<<std::setw(32)<<"other"<<std::right;
+    for (int r = 0; r < NUM_REQUESTS; ++r)
+        os<<std::setw(15)<<m_other.requests[r];
+    os<<std::endl;
+}
+
+void RequestStats::writeJson(std::ostream &os) const {
+    os<<'{';
+    WidgetCounts::const_iterator it = m_widgets.begin();
+    for (; it != m_widgets.end(); ++it) {
+        os<<'"'<<EventStats::className(*it->first)<<"\":{";
+        for (int r = 0; r < NUM_REQUESTS; ++r)
+            os<<(r ? "," : "")<<'"'<<requestName(Request(r))<<"\":"
+              <<it->second.requests[r];
+        os<<"},";
+    }
+    os<<"\"other\":{";
+    for (int r = 0; r < NUM_REQUESTS; ++r)
+        os<<(r ? "," : "")<<'"'<<requestName(Request(r))<<"\":"<<m_other.requests[r];
+    os<<"}}";
+}
+
+} // end namespace FbTk
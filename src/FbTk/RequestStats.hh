@@ -0,0 +1,107 @@
+// RequestStats.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#ifndef FBTK_REQUESTSTATS_HH
+#define FBTK_REQUESTSTATS_HH
+
+#include "NotCopyable.hh"
+
+#include <iosfwd>
+#include <map>
+#include <typeinfo>
+
+namespace FbTk {
+
+/**
+   Counts the drawing and window requests we send, per class of the widget
+   that sends them: the innermost Widget scope, which the EventManager
+   opens around the handler of each event and the widgets around their
+   redraws. Requests sent outside of any scope count as "other".
+   Counting is off by default, so a request costs a single check.
+ */
+class RequestStats: private NotCopyable {
+public:
+    enum Request {
+        COPY_AREA,
+        FILL_RECTANGLE,
+        DRAW_OTHER,     ///< rectangles, lines and polygons
+        DRAW_TEXT,
+        CLEAR,
+        SET_BACKGROUND,
+        MOVE_RESIZE,
+        CREATE_PIXMAP,
+        NUM_REQUESTS
+    };
+
+    /// attributes the requests sent while it lives to 'type'
+    class Widget: private NotCopyable {
+    public:
+        explicit Widget(const std::type_info &type);
+        ~Widget();
+    private:
+        bool m_active;
+        unsigned long *m_counts; ///< of the enclosing scope
+    };
+
+    static RequestStats &instance();
+
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    bool enabled() const { return m_enabled; }
+
+    /// counts 'num' requests to the current widget
+    static void count(Request request, unsigned long num = 1) {
+        RequestStats &stats = instance();
+        if (stats.m_enabled)
+            stats.m_current[request] += num;
+    }
+
+    /// prints a table of the requests per widget class
+    void dump(std::ostream &os) const;
+    /// writes the requests per widget class as a JSON object on a single line
+    void writeJson(std::ostream &os) const;
+
+    static const char *requestName(Request request);
+
+private:
+    RequestStats();
+
+    struct Counts {
+        Counts();
+        unsigned long requests[NUM_REQUESTS];
+    };
+
+    struct TypeInfoLess {
+        bool operator()(const std::type_info *a, const std::type_info *b) const {
+            return a->before(*b);
+        }
+    };
+
+    typedef std::map<const std::type_info *, Counts, TypeInfoLess> WidgetCounts;
+
+    bool m_enabled;
+    WidgetCounts m_widgets;
+    Counts m_other;
+    unsigned long *m_current; ///< the counts of the innermost scope
+};
+
+} // end namespace FbTk
+
+#endif // FBTK_REQUESTSTATS_HH
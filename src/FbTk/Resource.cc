@@ -23,6 +23,22 @@
 #include "Resource.hh"
 #include "I18n.hh"
 #include "StringUtil.hh"
+#include "FileUtil.hh"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#ifdef HAVE_CSTDIO
+  #include <cstdio>
+#else
+  #include <stdio.h>
+#endif
+#ifdef HAVE_CSTRING
+  #include <cstring>
+#else
+  #include <string.h>
+#endif
 
 #include <iostream>
 #ifdef HAVE_CASSERT
@@ -150,40 +166,70 @@ bool ResourceManager::save(const char *filename, const char *mergefilename) {
         }
 
         XrmMergeDatabases(*database, &**m_database); // merge databases
-        XrmPutFileDatabase(**m_database, filename); // save database to file
+        putFileDatabase(**m_database, filename); // save database to file
 
         // don't try to destroy the database (XrmMergeDatabases destroys it)
         *database = 0;
         unlock();
     } else // save database to file
-        XrmPutFileDatabase(*database, filename);
+        putFileDatabase(*database, filename);
 
     m_filename = filename;
     return true;
 }
 
-Resource_base *ResourceManager::findResource(const string &resname) {
-   // find resource name
-    ResourceList::iterator i = m_resourcelist.begin();
-    ResourceList::iterator i_end = m_resourcelist.end();
-    for (; i != i_end; ++i) {
-        if ((*i)->name() == resname ||
-            (*i)->altName() == resname)
-            return *i;
+bool ResourceManager::putFileDatabase(XrmDatabase database, const string &filename) {
+    // a rename would replace a link instead of the file it points to
+    string realfile = FileUtil::realPath(filename);
+    string tmpfile = realfile + ".tmp";
+    XrmPutFileDatabase(database, tmpfile.c_str());
+
+    MappedFile written, current;
+    if (!written.open(tmpfile.c_str()))
+        return false;
+    if (current.open(realfile.c_str()) && current.size() == written.size() &&
+        memcmp(current.data(), written.data(), written.size()) == 0) {
+        remove(tmpfile.c_str());
+        return true;
     }
-    return 0;
+
+    return FileUtil::replaceFile(tmpfile, realfile);
 }
 
-const Resource_base *ResourceManager::findResource(const string &resname) const {
-   // find resource name
-    ResourceList::const_iterator i = m_resourcelist.begin();
-    ResourceList::const_iterator i_end = m_resourcelist.end();
-    for (; i != i_end; ++i) {
-        if ((*i)->name() == resname ||
-            (*i)->altName() == resname)
-            return *i;
+void ResourceManager::indexResource(Resource_base &r) {
+    // insert keeps the older one, like a search through the list would
+    m_index.insert(std::make_pair(r.name(), &r));
+    m_index.insert(std::make_pair(r.altName(), &r));
+}
+
+void ResourceManager::unindexResource(Resource_base &r) {
+    const string *names[] = { &r.name(), &r.altName() };
+    for (size_t n = 0; n < sizeof(names) / sizeof(names[0]); ++n) {
+        ResourceIndex::iterator it = m_index.find(*names[n]);
+        if (it == m_index.end() || it->second != &r)
+            continue;
+        m_index.erase(it);
+
+        // another resource may have the same name
+        ResourceList::iterator i = m_resourcelist.begin();
+        ResourceList::iterator i_end = m_resourcelist.end();
+        for (; i != i_end; ++i) {
+            if ((*i)->name() == *names[n] || (*i)->altName() == *names[n]) {
+                m_index[*names[n]] = *i;
+                break;
+            }
+        }
     }
-    return 0;
+}
+
+Resource_base *ResourceManager::findResource(const string &resname) {
+    ResourceIndex::iterator it = m_index.find(resname);
+    return it != m_index.end() ? it->second : 0;
+}
+
+const Resource_base *ResourceManager::findResource(const string &resname) const {
+    ResourceIndex::const_iterator it = m_index.find(resname);
+    return it != m_index.end() ? it->second : 0;
 }
 
 string ResourceManager::resourceValue(const string &resname) const {
@@ -27,6 +27,7 @@
 
 #include <string>
 #include <list>
+#include <map>
 #include <iostream>
 
 #include <exception>
@@ -93,6 +94,10 @@ public:
     /// @return true on success
     virtual bool save(const char *filename, const char *mergefilename=0);
 
+    /// writes 'database' through a temporary file, so nobody reads half
+    /// of it, and not at all if 'filename' already has the same contents
+    /// @return true on success
+    static bool putFileDatabase(XrmDatabase database, const std::string &filename);
 
 
     /// Add resource to list, only used in Resource<T>
@@ -103,6 +108,7 @@ public:
     template <class T>
     void removeResource(Resource<T> &r) {
         m_resourcelist.remove(&r);
+        unindexResource(r);
     }
 
     /// searches for the resource with the resourcename
@@ -143,8 +149,15 @@ protected:
     int m_db_lock;
 
 private:
+    /// makes r findable by its names, unless an older resource has them
+    void indexResource(Resource_base &r);
+    /// call after removing r from m_resourcelist
+    void unindexResource(Resource_base &r);
 
     ResourceList m_resourcelist;
+    /// the first resource of m_resourcelist with a name or alt name
+    typedef std::map<std::string, Resource_base *> ResourceIndex;
+    ResourceIndex m_index;
 
     XrmDatabaseHelper *m_database;
 
@@ -199,6 +212,7 @@ template <class T>
 void ResourceManager::addResource(Resource<T> &r) {
     m_resourcelist.push_back(&r);
     m_resourcelist.unique();
+    indexResource(r);
 
     // lock ensures that the database is loaded.
     lock();
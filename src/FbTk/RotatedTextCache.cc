@@ -0,0 +1,124 @@
+// RotatedTextCache.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "RotatedTextCache.hh"
+#include "FbDrawable.hh"
+#include "App.hh"
+#include "MemoryAccount.hh"
+
+#include <map>
+#include <utility>
+
+namespace {
+
+/// stippling gcs by screen and depth, a gc only works on drawables
+/// with the root and depth of the one it was created for
+typedef std::map<std::pair<int, unsigned int>, GC> GCs;
+GCs s_gcs;
+
+} // anonymous namespace
+
+namespace FbTk {
+
+RotatedTextCache::RotatedTextCache():
+    m_clock(0) {
+}
+
+RotatedTextCache::~RotatedTextCache() {
+    clear();
+}
+
+const RotatedTextCache::Label *RotatedTextCache::find(const char *text, size_t len,
+                                                      Orientation orient,
+                                                      int a, int b, int c, int d) {
+    for (int i = 0; i < SIZE; ++i) {
+        Entry &e = m_entries[i];
+        if (e.label.bitmap != None && e.orient == orient &&
+            e.key[0] == a && e.key[1] == b && e.key[2] == c && e.key[3] == d &&
+            e.text.size() == len && e.text.compare(0, len, text, len) == 0) {
+            e.used = ++m_clock;
+            return &e.label;
+        }
+    }
+    return 0;
+}
+
+const RotatedTextCache::Label &RotatedTextCache::insert(const char *text, size_t len,
+                                                        Orientation orient,
+                                                        const Label &label,
+                                                        int a, int b, int c, int d) {
+    Entry *oldest = m_entries;
+    for (int i = 1; i < SIZE && oldest->used != 0; ++i)
+        if (m_entries[i].used < oldest->used)
+            oldest = &m_entries[i];
+
+    if (oldest->label.bitmap != None)
+        MemoryAccount::freePixmap(App::instance()->display(), oldest->label.bitmap);
+
+    oldest->text.assign(text, len);
+    oldest->orient = orient;
+    oldest->key[0] = a;
+    oldest->key[1] = b;
+    oldest->key[2] = c;
+    oldest->key[3] = d;
+    oldest->label = label;
+    oldest->used = ++m_clock;
+    // the label outlives the text it was drawn for, it is the font's
+    MemoryAccount::instance().setOwner(label.bitmap, MemoryAccount::IN_FONT, this);
+    return oldest->label;
+}
+
+void RotatedTextCache::clear() {
+    for (int i = 0; i < SIZE; ++i) {
+        Entry &e = m_entries[i];
+        if (e.label.bitmap != None)
+            MemoryAccount::freePixmap(App::instance()->display(), e.label.bitmap);
+        e = Entry();
+    }
+    m_clock = 0;
+}
+
+void RotatedTextCache::draw(const FbDrawable &d, int screen, GC gc,
+                            const Label &label, int x, int y) {
+    Display *dpy = App::instance()->display();
+
+    GC &stipple_gc = s_gcs[std::make_pair(screen, d.depth())];
+    if (stipple_gc == 0) {
+        stipple_gc = XCreateGC(dpy, d.drawable(), 0, 0);
+        XSetFillStyle(dpy, stipple_gc, FillStippled);
+    }
+
+    XCopyGC(dpy, gc, GCForeground|GCBackground, stipple_gc);
+    XSetStipple(dpy, stipple_gc, label.bitmap);
+    XSetTSOrigin(dpy, stipple_gc, x + label.x, y + label.y);
+    XFillRectangle(dpy, d.drawable(), stipple_gc, x + label.x, y + label.y,
+                   label.width, label.height);
+}
+
+void RotatedTextCache::freeGCs() {
+    Display *dpy = App::instance()->display();
+    for (GCs::iterator it = s_gcs.begin(); it != s_gcs.end(); ++it)
+        XFreeGC(dpy, it->second);
+    s_gcs.clear();
+}
+
+} // end namespace FbTk
@@ -0,0 +1,98 @@
+// RotatedTextCache.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#ifndef FBTK_ROTATEDTEXTCACHE_HH
+#define FBTK_ROTATEDTEXTCACHE_HH
+
+#include "NotCopyable.hh"
+#include "Orientation.hh"
+
+#include <X11/Xlib.h>
+#include <string>
+
+namespace FbTk {
+
+class FbDrawable;
+
+/**
+   Remembers rotated text that a font implementation had to render in
+   software, as depth 1 bitmaps. Drawing a label again is then a single
+   stippled fill with the foreground of the gc, so one entry serves every
+   color, e.g. the focused and unfocused title of a vertical tab.
+
+   The key is the text, the orientation and four numbers, which the font
+   implementation sets to whatever else its rendering depends on.
+ */
+class RotatedTextCache: private NotCopyable {
+public:
+    enum { SIZE = 64 };
+
+    /// a rendered label, drawn at (x, y) relative to the text position
+    struct Label {
+        Label(): bitmap(None), x(0), y(0), width(0), height(0) { }
+
+        Pixmap bitmap;
+        int x, y;
+        unsigned int width, height;
+    };
+
+    RotatedTextCache();
+    ~RotatedTextCache();
+
+    /// @return the label or 0 if it isn't cached
+    const Label *find(const char *text, size_t len, Orientation orient,
+                      int a = 0, int b = 0, int c = 0, int d = 0);
+
+    /// stores a label, replacing the least recently used one;
+    /// the cache owns the bitmap from now on
+    const Label &insert(const char *text, size_t len, Orientation orient,
+                        const Label &label,
+                        int a = 0, int b = 0, int c = 0, int d = 0);
+
+    /// frees all labels, needed when the font changes
+    void clear();
+
+    /// fills the label with the foreground of gc, the text being at (x, y)
+    static void draw(const FbDrawable &d, int screen, GC gc,
+                     const Label &label, int x, int y);
+
+    /// frees the gcs draw() keeps, before the display is closed
+    static void freeGCs();
+
+private:
+    struct Entry {
+        Entry(): orient(ROT0), used(0) { key[0] = key[1] = key[2] = key[3] = 0; }
+
+        std::string text;
+        Orientation orient;
+        int key[4];
+        Label label;
+        unsigned long used;
+    };
+
+    Entry m_entries[SIZE];
+    unsigned long m_clock;
+};
+
+} // end namespace FbTk
+
+#endif // FBTK_ROTATEDTEXTCACHE_HH
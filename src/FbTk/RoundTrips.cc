@@ -0,0 +1,92 @@
+// RoundTrips.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "RoundTrips.hh"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+struct MoreHits {
+    bool operator()(const FbTk::RoundTrips::Site *a,
+                    const FbTk::RoundTrips::Site *b) const {
+        return a->count() > b->count();
+    }
+};
+
+} // anonymous namespace
+
+namespace FbTk {
+
+RoundTrips::Site::Site(const char *name):
+    m_name(name), m_count(0) {
+    RoundTrips::instance().m_sites.push_back(this);
+}
+
+void RoundTrips::Site::hit() {
+    ++m_count;
+    RoundTrips &trips = RoundTrips::instance();
+    ++trips.m_total;
+    if (trips.m_audit)
+        std::cerr<<"round-trip: "<<m_name<<std::endl;
+}
+
+RoundTrips &RoundTrips::instance() {
+    static RoundTrips s_instance;
+    return s_instance;
+}
+
+unsigned long RoundTrips::count(const std::string &name) const {
+    unsigned long num = 0;
+    std::vector<Site *>::const_iterator it = m_sites.begin();
+    for (; it != m_sites.end(); ++it) {
+        if (name == (*it)->name())
+            num += (*it)->count();
+    }
+    return num;
+}
+
+void RoundTrips::reset() {
+    m_total = 0;
+    std::vector<Site *>::iterator it = m_sites.begin();
+    for (; it != m_sites.end(); ++it)
+        (*it)->m_count = 0;
+}
+
+void RoundTrips::dump(std::ostream &os) const {
+    std::vector<Site *> sites(m_sites);
+    std::stable_sort(sites.begin(), sites.end(), MoreHits());
+
+    os<<std::left<<std::setw(42)<<"round-trip"<<std::right
+      <<std::setw(10)<<"count"<<std::endl;
+    std::vector<Site *>::const_iterator it = sites.begin();
+    for (; it != sites.end() && (*it)->count() != 0; ++it) {
+        os<<std::left<<std::setw(42)<<(*it)->name()<<std::right
+          <<std::setw(10)<<(*it)->count()<<std::endl;
+    }
+    os<<std::left<<std::setw(42)<<"total"<<std::right
+      <<std::setw(10)<<m_total<<std::endl;
+}
+
+} // end namespace FbTk
@@ -0,0 +1,91 @@
+// RoundTrips.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#ifndef FBTK_ROUNDTRIPS_HH
+#define FBTK_ROUNDTRIPS_HH
+
+#include "NotCopyable.hh"
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace FbTk {
+
+/**
+   Counts synchronous requests to the X server (XSync, XGetWindowProperty,
+   XQueryTree, ...) per call site. Every call site that waits for a reply
+   is marked with FBTK_ROUNDTRIP("Class::function").
+
+   In audit mode each round-trip is reported on stderr as it happens, which
+   helps to find the code path that caused it.
+ */
+class RoundTrips: private NotCopyable {
+public:
+    /// a single call site, registers itself on construction
+    class Site {
+    public:
+        explicit Site(const char *name);
+
+        void hit();
+
+        const char *name() const { return m_name; }
+        unsigned long count() const { return m_count; }
+
+    private:
+        friend class RoundTrips;
+        const char *m_name;
+        unsigned long m_count;
+    };
+
+    static RoundTrips &instance();
+
+    void setAudit(bool audit) { m_audit = audit; }
+    bool audit() const { return m_audit; }
+
+    /// @return number of round-trips since start or last reset
+    unsigned long total() const { return m_total; }
+    /// @return number of round-trips of all sites called 'name'
+    unsigned long count(const std::string &name) const;
+    void reset();
+
+    /// prints the sites that caused round-trips, most expensive first
+    void dump(std::ostream &os) const;
+
+private:
+    RoundTrips(): m_audit(false), m_total(0) { }
+
+    bool m_audit;
+    unsigned long m_total;
+    std::vector<Site *> m_sites;
+};
+
+} // end namespace FbTk
+
+/// marks a call that waits for a reply from the X server
+#define FBTK_ROUNDTRIP(name) \
+    do { \
+        static FbTk::RoundTrips::Site fbtk_roundtrip_site(name); \
+        fbtk_roundtrip_site.hit(); \
+    } while (0)
+
+#endif // FBTK_ROUNDTRIPS_HH
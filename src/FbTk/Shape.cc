@@ -23,8 +23,6 @@
 
 #include "FbWindow.hh"
 #include "App.hh"
-#include "GContext.hh"
-#include "FbPixmap.hh"
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -49,113 +47,108 @@
 #endif // SHAPE
 
 #include <algorithm>
-#include <vector>
 #include <iostream>
+#include <vector>
 
 using std::min;
 
 namespace FbTk {
 
 namespace {
-/* rows is an array of 8 bytes, i.e. 8x8 bits */
-Pixmap makePixmap(Display* disp, int screen_nr, Window parent, const unsigned char rows[]) {
-
-    const size_t data_size = 8 * 8;
-    // we use malloc here so we get consistent C alloc/free with XDestroyImage
-    // and no warnings in valgrind :)
-    char *data = (char *)malloc(data_size * sizeof (char));
-    if (data == 0)
-        return 0;
-
-    memset(data, 0xFF, data_size);
-
-    XImage *ximage = XCreateImage(disp,
-                                  DefaultVisual(disp, screen_nr),
-                                  1,
-                                  XYPixmap, 0,
-                                  data,
-                                  8, 8,
-                                  32, 0);
-    if (ximage == 0) {
-        free(data);
-        return 0;
-    }
 
-    XInitImage(ximage);
+/* rows of the 8x8 corners, set bits are kept and cleared bits cut away */
+const unsigned char s_topleft_bits[] = { 0xc0, 0xf8, 0xfc, 0xfe, 0xfe, 0xfe, 0xff, 0xff };
+const unsigned char s_topright_bits[] = { 0x03, 0x1f, 0x3f, 0x7f, 0x7f, 0x7f, 0xff, 0xff};
+const unsigned char s_botleft_bits[] = { 0xff, 0xff, 0xfe, 0xfe, 0xfe, 0xfc, 0xf8, 0xc0 };
+const unsigned char s_botright_bits[] = { 0xff, 0xff, 0x7f, 0x7f, 0x7f, 0x3f, 0x1f, 0x03 };
 
-    for (int y=0; y<8; y++) {
-        for (int x=0; x<8; x++) {
-            XPutPixel(ximage, x, y, (rows[y] & (0x01 << x)) ? 0 : 1); // inverted, it is subtracted
+/// adds the cut away part of a corner at x, y to region, one rectangle per run
+void addCorner(Region region, const unsigned char rows[], int x, int y) {
+    XRectangle rect;
+    rect.height = 1;
+    for (int row = 0; row < 8; ++row) {
+        int start = -1;
+        for (int col = 0; col <= 8; ++col) {
+            bool cut = col < 8 && !(rows[row] & (0x01 << col));
+            if (cut && start < 0) {
+                start = col;
+            } else if (!cut && start >= 0) {
+                rect.x = x + start;
+                rect.y = y + row;
+                rect.width = col - start;
+                XUnionRectWithRegion(&rect, region, region);
+                start = -1;
+            }
         }
     }
-
-    FbPixmap pm(parent, 8, 8, 1);
-    GContext gc(pm);
-
-    XPutImage(disp, pm.drawable(), gc.gc(), ximage, 0, 0, 0, 0,
-              8, 8);
-
-    XDestroyImage(ximage);
-
-    return pm.release();
 }
 
-struct CornerPixmaps {
-    CornerPixmaps() : do_create(true) { }
-
-    FbPixmap topleft;
-    FbPixmap topright;
-    FbPixmap botleft;
-    FbPixmap botright;
-
-    bool do_create;
-};
-
-// unfortunately, we need a separate pixmap per screen
-std::vector<CornerPixmaps> s_corners;
-
-unsigned long nr_shapes = 0;
-
-void initCorners(int screen) {
-
-    Display* disp = App::instance()->display();
-    if (s_corners.empty())
-        s_corners.resize(ScreenCount(disp));
-
-
-    if (screen < 0 || screen > static_cast<int>(s_corners.size())) {
-        std::cerr << "FbTk/Shape.cc:initCorners(), invalid argument: " << screen << "\n";
-        return;
-    }
-
-    static const unsigned char left_bits[] = { 0xc0, 0xf8, 0xfc, 0xfe, 0xfe, 0xfe, 0xff, 0xff };
-    static const unsigned char right_bits[] = { 0x03, 0x1f, 0x3f, 0x7f, 0x7f, 0x7f, 0xff, 0xff};
-    static const unsigned char bottom_left_bits[] = { 0xff, 0xff, 0xfe, 0xfe, 0xfe, 0xfc, 0xf8, 0xc0 };
-    static const unsigned char bottom_right_bits[] = { 0xff, 0xff, 0x7f, 0x7f, 0x7f, 0x3f, 0x1f, 0x03 };
+/// columns cut from the outer side of a corner row, -1 if the row is
+/// more than one run, e.g. 0xf8 cuts 3 from the left edge
+int cutFromLeft(unsigned char row) {
+    int cut = 0;
+    while (cut < 8 && !(row & (0x01 << cut)))
+        ++cut;
+    return row == ((0xff << cut) & 0xff) ? cut : -1;
+}
 
-    CornerPixmaps& corners = s_corners[screen];
-    if (corners.do_create) {
+int cutFromRight(unsigned char row) {
+    int cut = 0;
+    while (cut < 8 && !(row & (0x80 >> cut)))
+        ++cut;
+    return row == (0xff >> cut) ? cut : -1;
+}
 
-        Window root = RootWindow(disp, screen);
-        corners.topleft = makePixmap(disp, screen, root, left_bits);
-        corners.topright = makePixmap(disp, screen, root, right_bits);
-        corners.botleft = makePixmap(disp, screen, root, bottom_left_bits);
-        corners.botright = makePixmap(disp, screen, root, bottom_right_bits);
-        corners.do_create = false;
+/// adds the row band y..y+height of a shape with width at x, growing the
+/// previous rectangle when it is the same band
+void addBand(std::vector<XRectangle> &rects, int x, int y, int width,
+             int height, int left, int right) {
+    XRectangle rect;
+    rect.x = x + left;
+    rect.y = y;
+    rect.width = width - left - right;
+    rect.height = height;
+    if (!rects.empty()) {
+        XRectangle &last = rects.back();
+        if (last.x == rect.x && last.width == rect.width &&
+            last.y + last.height == rect.y) {
+            last.height += rect.height;
+            return;
+        }
     }
-
-    nr_shapes++; // refcounting
+    rects.push_back(rect);
 }
 
-void cleanCorners() {
-
-    if (nr_shapes == 1) {
-        s_corners.clear();
+/**
+ * Lists the rectangle at x, y with the corners of places cut away, one
+ * rectangle per band in YXBanded order, so the server gets the shape
+ * without any region arithmetic on our side.
+ * @return false if the corners overlap or a corner row is not one run
+ */
+bool cornerRectangles(std::vector<XRectangle> &rects, int x, int y,
+                      int width, int height, int places) {
+    rects.clear();
+    if (width < 16 || height < 16)
+        return false;
+
+    int top_left[8], top_right[8], bottom_left[8], bottom_right[8];
+    for (int row = 0; row < 8; ++row) {
+        top_left[row] = (places & Shape::TOPLEFT) ? cutFromLeft(s_topleft_bits[row]) : 0;
+        top_right[row] = (places & Shape::TOPRIGHT) ? cutFromRight(s_topright_bits[row]) : 0;
+        bottom_left[row] = (places & Shape::BOTTOMLEFT) ? cutFromLeft(s_botleft_bits[row]) : 0;
+        bottom_right[row] = (places & Shape::BOTTOMRIGHT) ? cutFromRight(s_botright_bits[row]) : 0;
+        if (top_left[row] < 0 || top_right[row] < 0 ||
+            bottom_left[row] < 0 || bottom_right[row] < 0)
+            return false;
     }
 
-    if (nr_shapes > 0) {
-        nr_shapes--; // refcounting
-    }
+    for (int row = 0; row < 8; ++row)
+        addBand(rects, x, y + row, width, 1, top_left[row], top_right[row]);
+    addBand(rects, x, y + 8, width, height - 16, 0, 0);
+    for (int row = 0; row < 8; ++row)
+        addBand(rects, x, y + height - 8 + row, width, 1,
+                bottom_left[row], bottom_right[row]);
+    return true;
 }
 
 } // end of anonymous namespace
@@ -165,11 +158,11 @@ Shape::Shape(FbWindow &win, int shapeplaces):
     m_shapesource(0),
     m_shapesource_xoff(0),
     m_shapesource_yoff(0),
-    m_shapeplaces(shapeplaces) {
-
-#ifdef SHAPE
-    initCorners(win.screenNumber());
-#endif
+    m_shapeplaces(shapeplaces),
+    m_last_valid(false),
+    m_last_window(0),
+    m_last_width(0), m_last_height(0), m_last_bw(0),
+    m_last_places(0) {
 
     update();
 }
@@ -192,13 +185,12 @@ Shape::~Shape() {
                           0,
                           ShapeSet);
     }
-
-    cleanCorners();
 #endif // SHAPE
 }
 
 void Shape::setPlaces(int shapeplaces) {
     m_shapeplaces = shapeplaces;
+    m_last_valid = false;
 }
 
 void Shape::update() {
@@ -215,6 +207,22 @@ void Shape::update() {
     int width = m_win->width();
     int height = m_win->height();
 
+    // without a shape source the shape only depends on the geometry, so
+    // there is nothing to send if that didn't change
+    if (m_shapesource == 0) {
+        if (m_last_valid && m_last_window == m_win->window() &&
+            m_last_width == width && m_last_height == height &&
+            m_last_bw == bw && m_last_places == m_shapeplaces)
+            return;
+        m_last_valid = true;
+        m_last_window = m_win->window();
+        m_last_width = width;
+        m_last_height = height;
+        m_last_bw = bw;
+        m_last_places = m_shapeplaces;
+    } else
+        m_last_valid = false;
+
     if (m_shapesource == 0 && m_shapeplaces == 0) {
         /* clear the shape and return */
         XShapeCombineMask(display,
@@ -228,6 +236,25 @@ void Shape::update() {
         return;
     }
 
+    if (m_shapesource == 0) {
+        std::vector<XRectangle> clip_rects, bound_rects;
+        if (cornerRectangles(clip_rects, 0, 0, width, height, m_shapeplaces) &&
+            cornerRectangles(bound_rects, -bw, -bw, width + 2*bw, height + 2*bw,
+                             m_shapeplaces)) {
+            XShapeCombineRectangles(display,
+                                    m_win->window(), ShapeClip,
+                                    0, 0, // offsets
+                                    &clip_rects[0], clip_rects.size(),
+                                    ShapeSet, YXBanded);
+            XShapeCombineRectangles(display,
+                                    m_win->window(), ShapeBounding,
+                                    0, 0, // offsets
+                                    &bound_rects[0], bound_rects.size(),
+                                    ShapeSet, YXBanded);
+            return;
+        }
+    }
+
     Region clip = XCreateRegion();
     Region bound = XCreateRegion();
 
@@ -246,6 +273,36 @@ void Shape::update() {
 
     XUnionRectWithRegion(&rect, bound, bound);
 
+    Region clip_corners = XCreateRegion();
+    Region bound_corners = XCreateRegion();
+
+    /**
+     * Set the top corners if the y offset is nonzero.
+     */
+    if (m_shapesource == 0 || m_shapesource_yoff != 0) {
+        if (m_shapeplaces & TOPLEFT) {
+            addCorner(clip_corners, s_topleft_bits, 0, 0);
+            addCorner(bound_corners, s_topleft_bits, -bw, -bw);
+        }
+        if (m_shapeplaces & TOPRIGHT) {
+            addCorner(clip_corners, s_topright_bits, width-8, 0);
+            addCorner(bound_corners, s_topright_bits, width+bw-8, -bw);
+        }
+    }
+
+    // note that the bottom corners y-vals are offset by 8 (the height of the corners)
+    if (m_shapesource == 0 || (m_shapesource_yoff+(signed) m_shapesource->height()) < height
+        || m_shapesource_yoff >= height /* shaded */) {
+        if (m_shapeplaces & BOTTOMLEFT) {
+            addCorner(clip_corners, s_botleft_bits, 0, height-8);
+            addCorner(bound_corners, s_botleft_bits, -bw, height+bw-8);
+        }
+        if (m_shapeplaces & BOTTOMRIGHT) {
+            addCorner(clip_corners, s_botright_bits, width-8, height-8);
+            addCorner(bound_corners, s_botright_bits, width+bw-8, height+bw-8);
+        }
+    }
+
     if (m_shapesource != 0) {
 
         /*
@@ -290,7 +347,22 @@ void Shape::update() {
                             m_win->window(), ShapeBounding,
                             0, 0, // offsets
                             bound, ShapeUnion);
+
+        // the corners may overlap the copied shape, so cut them afterwards
+        if (!XEmptyRegion(clip_corners))
+            XShapeCombineRegion(display,
+                                m_win->window(), ShapeClip,
+                                0, 0, // offsets
+                                clip_corners, ShapeSubtract);
+        if (!XEmptyRegion(bound_corners))
+            XShapeCombineRegion(display,
+                                m_win->window(), ShapeBounding,
+                                0, 0, // offsets
+                                bound_corners, ShapeSubtract);
     } else {
+        XSubtractRegion(clip, clip_corners, clip);
+        XSubtractRegion(bound, bound_corners, bound);
+
         XShapeCombineRegion(display,
                             m_win->window(), ShapeClip,
                             0, 0, // offsets
@@ -303,42 +375,8 @@ void Shape::update() {
 
     XDestroyRegion(clip);
     XDestroyRegion(bound);
-
-   const CornerPixmaps &corners = s_corners[m_win->screenNumber()];
-#define SHAPECORNER(corner, x, y, shapekind)            \
-    XShapeCombineMask(App::instance()->display(), \
-                      m_win->window(),                  \
-                      shapekind,                        \
-                      x, y,                             \
-                      corners.corner.drawable(),      \
-                      ShapeSubtract); 
-
-    /**
-     * Set the top corners if the y offset is nonzero.
-     */
-    if (m_shapesource == 0 || m_shapesource_yoff != 0) {
-        if (m_shapeplaces & TOPLEFT) {
-            SHAPECORNER(topleft, 0, 0, ShapeClip);
-            SHAPECORNER(topleft, -bw, -bw, ShapeBounding);
-        }
-        if (m_shapeplaces & TOPRIGHT) {
-            SHAPECORNER(topright, width-8, 0, ShapeClip);
-            SHAPECORNER(topright, width+bw-8, -bw, ShapeBounding);
-        }
-    }
-
-    // note that the bottom corners y-vals are offset by 8 (the height of the corner pixmaps)
-    if (m_shapesource == 0 || (m_shapesource_yoff+(signed) m_shapesource->height()) < height
-        || m_shapesource_yoff >= height /* shaded */) {
-        if (m_shapeplaces & BOTTOMLEFT) {
-            SHAPECORNER(botleft, 0, height-8, ShapeClip);
-            SHAPECORNER(botleft, -bw, height+bw-8, ShapeBounding);
-        }
-        if (m_shapeplaces & BOTTOMRIGHT) {
-            SHAPECORNER(botright, width-8, height-8, ShapeClip);
-            SHAPECORNER(botright, width+bw-8, height+bw-8, ShapeBounding);
-        }
-    }
+    XDestroyRegion(clip_corners);
+    XDestroyRegion(bound_corners);
 
 #endif // SHAPE
 
@@ -346,6 +384,7 @@ void Shape::update() {
 
 void Shape::setWindow(FbWindow &win) {
     m_win = &win;
+    m_last_valid = false;
     update();
 }
 
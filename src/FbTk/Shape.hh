@@ -64,6 +64,12 @@ private:
     int m_shapesource_xoff, m_shapesource_yoff;
 
     int m_shapeplaces; ///< places to shape
+
+    /// geometry of the last update without a shape source
+    bool m_last_valid;
+    Window m_last_window;
+    int m_last_width, m_last_height, m_last_bw;
+    int m_last_places;
 };
 
 } // end namespace FbTk
@@ -24,10 +24,8 @@
 
 #include "RefCount.hh"
 #include "Slot.hh"
-#include <algorithm>
-#include <list>
+#include "SmallVector.hh"
 #include <map>
-#include <set>
 
 namespace FbTk {
 
@@ -38,11 +36,13 @@ namespace SigImpl {
  * Parent class for all \c Signal template classes.
  * It handles the disconnect and holds all the slots. The connect must be
  * handled by the child class so it can do the type checking.
+ * Most signals have a few slots and trackers, they are kept in the
+ * holder itself.
  */
 class SignalHolder {
 protected:
     typedef RefCount<SlotBase> SlotPtr;
-    typedef std::list<SlotPtr> SlotList;
+    typedef SmallVector<SlotPtr, 4> SlotList;
 
 public:
     /// Special tracker interface used by SignalTracker.
@@ -53,69 +53,71 @@ public:
         virtual void disconnect(SignalHolder& signal) = 0;
     };
 
-    typedef SlotList::iterator Iterator;
-    typedef Iterator SlotID;
-    typedef SlotList::const_iterator ConstIterator;
+    /// the slot itself identifies a connection
+    typedef const SlotBase *SlotID;
 
     SignalHolder() : m_emitting(0) {}
 
     ~SignalHolder() {
         // Disconnect this holder from all trackers.
-        for (Trackers::iterator it = m_trackers.begin(),
-                 it_end = m_trackers.end();
-             it != it_end; ++it ) {
-            (*it)->disconnect(*this);
-        }
+        for (size_t i = 0; i < m_trackers.size(); ++i)
+            m_trackers[i]->disconnect(*this);
     }
 
     /// Remove a specific slot \c id from this signal
-    void disconnect(SlotID slotIt) const {
+    void disconnect(SlotID id) const {
+        size_t i = 0;
+        while (i < m_slots.size() && m_slots[i].get() != id)
+            ++i;
+        if (i == m_slots.size())
+            return;
         if(m_emitting) {
             // if we are emitting, we must not erase the actual element, as that would
-            // invalidate iterators in the emit() function
-            *slotIt = SlotPtr();
+            // move the slots under the emit() function
+            m_slots[i] = SlotPtr();
         } else
-            m_slots.erase( slotIt );
+            m_slots.erase(i);
     }
 
 
     /// Removes all slots connected to this
     void clear() {
-        if(m_emitting)
-            std::fill(m_slots.begin(), m_slots.end(), SlotPtr());
-        else
+        if(m_emitting) {
+            for (size_t i = 0; i < m_slots.size(); ++i)
+                m_slots[i] = SlotPtr();
+        } else
             m_slots.clear();
     }
 
     void connectTracker(SignalHolder::Tracker& tracker) const {
-        m_trackers.insert(&tracker);
+        if (m_trackers.find(&tracker) == m_trackers.size())
+            m_trackers.push_back(&tracker);
     }
 
     void disconnectTracker(SignalHolder::Tracker& tracker) const {
-        m_trackers.erase(&tracker);
+        m_trackers.remove(&tracker);
     }
 
 protected:
-    ConstIterator begin() const { return m_slots.begin(); }
-    ConstIterator end() const { return m_slots.end(); }
-
-    Iterator begin() { return m_slots.begin(); }
-    Iterator end() { return m_slots.end(); }
+    size_t slots() const { return m_slots.size(); }
+    /// @return the slot at 'i', empty if it was disconnected while emitting
+    const SlotPtr &slot(size_t i) const { return m_slots[i]; }
 
     /// Connect a slot to this signal. Must only be called by child classes.
     SlotID connect(const SlotPtr& slot) const {
-        return m_slots.insert(m_slots.end(), slot);
+        m_slots.push_back(slot);
+        return slot.get();
     }
 
     void begin_emitting() { ++m_emitting; }
     void end_emitting() {
         if(--m_emitting == 0) {
             // remove elements which belonged slots that detached themselves
-            m_slots.erase(std::remove(m_slots.begin(), m_slots.end(), SlotPtr()), m_slots.end());
+            m_slots.remove(SlotPtr());
         }
     }
 private:
-    typedef std::set<Tracker*> Trackers;
+    typedef SmallVector<Tracker*, 4> Trackers;
     mutable SlotList m_slots; ///< all slots connected to a signal
     mutable Trackers m_trackers; ///< all instances that tracks this signal.
     unsigned m_emitting;
@@ -130,9 +132,12 @@ class Signal: public SigImpl::SignalHolder {
 public:
     void emit(Arg1 arg1, Arg2 arg2, Arg3 arg3) {
         begin_emitting();
-        for ( Iterator it = begin(); it != end(); ++it ) {
-            if(*it)
-                static_cast<Slot<void, Arg1, Arg2, Arg3> &>(**it)(arg1, arg2, arg3);
+        // slots connected while emitting get called too
+        for (size_t i = 0; i < slots(); ++i) {
+            // keeps the slot alive even if it disconnects itself
+            SlotPtr current = slot(i);
+            if(current)
+                static_cast<Slot<void, Arg1, Arg2, Arg3> &>(*current)(arg1, arg2, arg3);
         }
         end_emitting();
     }
@@ -155,9 +160,12 @@ class Signal<Arg1, Arg2, SigImpl::EmptyArg>: public SigImpl::SignalHolder {
 public:
     void emit(Arg1 arg1, Arg2 arg2) {
         begin_emitting();
-        for ( Iterator it = begin(); it != end(); ++it ) {
-            if(*it)
-                static_cast<Slot<void, Arg1, Arg2> &>(**it)(arg1, arg2);
+        // slots connected while emitting get called too
+        for (size_t i = 0; i < slots(); ++i) {
+            // keeps the slot alive even if it disconnects itself
+            SlotPtr current = slot(i);
+            if(current)
+                static_cast<Slot<void, Arg1, Arg2> &>(*current)(arg1, arg2);
         }
         end_emitting();
     }
@@ -180,9 +188,12 @@ class Signal<Arg1, SigImpl::EmptyArg, SigImpl::EmptyArg>: public SigImpl::Signal
 public:
     void emit(Arg1 arg) {
         begin_emitting();
-        for ( Iterator it = begin(); it != end(); ++it ) {
-            if(*it)
-                static_cast<Slot<void, Arg1> &>(**it)(arg);
+        // slots connected while emitting get called too
+        for (size_t i = 0; i < slots(); ++i) {
+            // keeps the slot alive even if it disconnects itself
+            SlotPtr current = slot(i);
+            if(current)
+                static_cast<Slot<void, Arg1> &>(*current)(arg);
         }
         end_emitting();
     }
@@ -205,9 +216,12 @@ class Signal<SigImpl::EmptyArg, SigImpl::EmptyArg, SigImpl::EmptyArg>: public Si
 public:
     void emit() {
         begin_emitting();
-        for ( Iterator it = begin(); it != end(); ++it ) {
-            if(*it)
-                static_cast<Slot<void> &>(**it)();
+        // slots connected while emitting get called too
+        for (size_t i = 0; i < slots(); ++i) {
+            // keeps the slot alive even if it disconnects itself
+            SlotPtr current = slot(i);
+            if(current)
+                static_cast<Slot<void> &>(*current)();
         }
         end_emitting();
     }
@@ -23,12 +23,14 @@
 #define FBTK_SIMPLECOMMAND_HH
 
 #include "Command.hh"
+#include "ObjectPool.hh"
 
 namespace FbTk {
 
-/// a simple command
+/// a simple command, windows make several of them
 template <typename Receiver, typename ReturnType=void>
-class SimpleCommand: public Command<ReturnType> {
+class SimpleCommand: public Command<ReturnType>,
+                     public Pooled<SimpleCommand<Receiver, ReturnType> > {
 public:
     typedef ReturnType (Receiver::* Action)();
     SimpleCommand(Receiver &r, Action a):
@@ -23,6 +23,7 @@
 #define FBTK_SLOT_HH
 
 #include "NotCopyable.hh"
+#include "RefCount.hh"
 
 namespace FbTk {
 
@@ -32,9 +33,9 @@ namespace SigImpl {
 struct EmptyArg {};
 
 /** A base class for all slots. It's purpose is to provide a virtual destructor and to enable the
- * Signal class to hold a pointer to a generic slot.
+ * Signal class to hold a pointer to a generic slot. Slots count their own references.
  */
-class SlotBase: private FbTk::NotCopyable {
+class SlotBase: public FbTk::RefCounted, private FbTk::NotCopyable {
 public:
     virtual ~SlotBase() {}
 };
@@ -0,0 +1,105 @@
+// SmallVector.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#ifndef FBTK_SMALLVECTOR_HH
+#define FBTK_SMALLVECTOR_HH
+
+#include <vector>
+#include <cstddef>
+
+namespace FbTk {
+
+/**
+   A vector that keeps its first N elements in itself, so it allocates
+   nothing until it holds more than N. All N elements are constructed
+   with it, so T should be cheap to construct and assign, like a pointer
+   or an empty RefCount.
+ */
+template <typename T, size_t N>
+class SmallVector {
+public:
+    SmallVector(): m_size(0) { }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    T &operator [] (size_t i) { return i < N ? m_items[i] : m_more[i - N]; }
+    const T &operator [] (size_t i) const { return i < N ? m_items[i] : m_more[i - N]; }
+
+    void push_back(const T &value) {
+        if (m_size < N)
+            m_items[m_size] = value;
+        else
+            m_more.push_back(value);
+        ++m_size;
+    }
+
+    /// removes the element at 'i', the ones after it move down
+    void erase(size_t i) {
+        for (; i + 1 < m_size; ++i)
+            (*this)[i] = (*this)[i + 1];
+        pop_back();
+    }
+
+    void pop_back() {
+        --m_size;
+        if (m_size < N)
+            m_items[m_size] = T();
+        else
+            m_more.pop_back();
+    }
+
+    /// @return index of the first element equal to 'value', size() if none is
+    size_t find(const T &value) const {
+        size_t i = 0;
+        while (i < m_size && !((*this)[i] == value))
+            ++i;
+        return i;
+    }
+
+    /// removes all elements equal to 'value'
+    void remove(const T &value) {
+        size_t to = 0;
+        for (size_t from = 0; from < m_size; ++from) {
+            if (!((*this)[from] == value)) {
+                if (to != from)
+                    (*this)[to] = (*this)[from];
+                ++to;
+            }
+        }
+        while (m_size > to)
+            pop_back();
+    }
+
+    void clear() {
+        while (m_size > 0)
+            pop_back();
+    }
+
+private:
+    T m_items[N];
+    std::vector<T> m_more;
+    size_t m_size;
+};
+
+} // end namespace FbTk
+
+#endif // FBTK_SMALLVECTOR_HH
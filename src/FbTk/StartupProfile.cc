@@ -0,0 +1,117 @@
+// StartupProfile.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#include "StartupProfile.hh"
+#include "FbTime.hh"
+#include "StringUtil.hh"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+namespace FbTk {
+
+StartupProfile::Phase::Phase(const char *name, int number):
+    m_active(false), m_outermost(false), m_index(0), m_start(0) {
+    StartupProfile &profile = StartupProfile::instance();
+    if (!profile.m_enabled)
+        return;
+
+    std::string key(name);
+    if (number >= 0)
+        key += " " + StringUtil::number2String(number);
+
+    std::map<std::string, size_t>::iterator it = profile.m_index.find(key);
+    if (it == profile.m_index.end()) {
+        Entry entry = { key, profile.m_depth, 0, 0, 0, 0 };
+        it = profile.m_index.insert(std::make_pair(key, profile.m_entries.size())).first;
+        profile.m_entries.push_back(entry);
+    }
+
+    m_active = true;
+    m_outermost = (profile.m_depth == 0);
+    m_index = it->second;
+    Entry &entry = profile.m_entries[m_index];
+    ++entry.count;
+    // the time of a phase within one of the same name is counted already
+    if (entry.open++ == 0)
+        m_start = FbTime::mono();
+    ++profile.m_depth;
+}
+
+StartupProfile::Phase::~Phase() {
+    StartupProfile &profile = StartupProfile::instance();
+    if (!m_active || !profile.m_enabled)
+        return;
+
+    Entry &entry = profile.m_entries[m_index];
+    --entry.open;
+    --profile.m_depth;
+    if (m_start != 0) {
+        uint64_t usec = FbTime::mono() - m_start;
+        entry.usec += usec;
+        if (m_outermost)
+            entry.outermost_usec += usec;
+    }
+}
+
+StartupProfile &StartupProfile::instance() {
+    static StartupProfile profile;
+    return profile;
+}
+
+void StartupProfile::start() {
+    m_enabled = true;
+    m_start = FbTime::mono();
+    m_depth = 0;
+    m_entries.clear();
+    m_index.clear();
+}
+
+void StartupProfile::finish(std::ostream &os) {
+    if (!m_enabled)
+        return;
+    m_enabled = false;
+
+    const uint64_t total = FbTime::mono() - m_start;
+    uint64_t phases = 0;
+
+    os<<"startup profile (ms):"<<std::endl<<std::fixed<<std::setprecision(1);
+    for (size_t i = 0; i < m_entries.size(); ++i) {
+        const Entry &entry = m_entries[i];
+        const unsigned int indent = std::min(2 * entry.depth, 24u);
+        os<<"  "<<std::string(indent, ' ')
+          <<std::left<<std::setw(36 - indent)<<entry.name
+          <<std::right<<std::setw(10)<<entry.usec / 1000.0;
+        if (entry.count > 1)
+            os<<"  ("<<entry.count<<" times)";
+        os<<std::endl;
+        phases += entry.outermost_usec;
+    }
+    os<<"  "<<std::left<<std::setw(36)<<"other"
+      <<std::right<<std::setw(10)<<(total > phases ? total - phases : 0) / 1000.0<<std::endl
+      <<"  "<<std::left<<std::setw(36)<<"until the first idle moment"
+      <<std::right<<std::setw(10)<<total / 1000.0<<std::endl;
+    os.unsetf(std::ios::floatfield);
+    os<<std::setprecision(6);
+}
+
+} // end namespace FbTk
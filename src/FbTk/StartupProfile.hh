@@ -0,0 +1,96 @@
+// StartupProfile.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#ifndef FBTK_STARTUPPROFILE_HH
+#define FBTK_STARTUPPROFILE_HH
+
+#include "NotCopyable.hh"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#ifdef HAVE_INTTYPES_H
+#include <inttypes.h>
+#else
+#include <stdint.h>
+#endif // HAVE_INTTYPES_H
+
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace FbTk {
+
+/**
+   Where the time from start to the first idle moment of the event loop
+   goes: the phases of startup add up their time under their name, and
+   the table is printed once. Profiling is off unless started, so a phase
+   costs a single check.
+ */
+class StartupProfile: private NotCopyable {
+public:
+    /// adds the time from its construction to its destruction to 'name',
+    /// or to "name number" if number isn't negative
+    class Phase: private NotCopyable {
+    public:
+        explicit Phase(const char *name, int number = -1);
+        ~Phase();
+    private:
+        bool m_active; ///< if we were profiling when it started
+        bool m_outermost; ///< if it isn't nested in any other phase
+        size_t m_index;
+        uint64_t m_start; ///< 0 when nested in a phase of the same name
+    };
+
+    static StartupProfile &instance();
+
+    /// starts profiling, the time until finish() is the total
+    void start();
+    bool enabled() const { return m_enabled; }
+
+    /// prints the phases in the order they started, nested phases
+    /// indented below the one they started in, and stops profiling
+    void finish(std::ostream &os);
+
+private:
+    StartupProfile(): m_enabled(false), m_start(0), m_depth(0) { }
+
+    struct Entry {
+        std::string name;
+        unsigned int depth; ///< nesting when it first started
+        unsigned int open;  ///< phases of this name running now
+        unsigned long count;
+        uint64_t usec;
+        uint64_t outermost_usec; ///< of the phases not nested in others
+    };
+
+    bool m_enabled;
+    uint64_t m_start;
+    unsigned int m_depth;
+    std::vector<Entry> m_entries;
+    std::map<std::string, size_t> m_index;
+};
+
+} // end namespace FbTk
+
+#endif // FBTK_STARTUPPROFILE_HH
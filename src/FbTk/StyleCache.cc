@@ -0,0 +1,288 @@
+// StyleCache.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "StyleCache.hh"
+
+#include "FileUtil.hh"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#ifdef HAVE_SYS_STAT_H
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif // HAVE_SYS_STAT_H
+
+#ifdef HAVE_CSTDIO
+  #include <cstdio>
+#else
+  #include <stdio.h>
+#endif
+#ifdef HAVE_CSTRING
+  #include <cstring>
+#else
+  #include <string.h>
+#endif
+
+#include <fstream>
+
+using std::string;
+
+namespace {
+
+const char MAGIC[] = "fluxbox style cache 1\n";
+/// styles kept in the file, the most recently used ones
+const size_t MAX_STYLES = 32;
+
+// the cache is only ever read by the fluxbox that wrote it, so numbers
+// are in the byte order of the machine
+
+void put(string &out, uint64_t value) {
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void put(string &out, const string &value) {
+    put(out, uint64_t(value.size()));
+    out.append(value);
+}
+
+class Reader {
+public:
+    Reader(const char *data, size_t size): m_pos(data), m_end(data + size) { }
+
+    bool get(uint64_t &value) {
+        if (size_t(m_end - m_pos) < sizeof(value))
+            return false;
+        memcpy(&value, m_pos, sizeof(value));
+        m_pos += sizeof(value);
+        return true;
+    }
+
+    bool get(string &value) {
+        uint64_t size;
+        if (!get(size) || size > size_t(m_end - m_pos))
+            return false;
+        value.assign(m_pos, size);
+        m_pos += size;
+        return true;
+    }
+
+    bool done() const { return m_pos == m_end; }
+
+private:
+    const char *m_pos, *m_end;
+};
+
+} // anonymous namespace
+
+namespace FbTk {
+
+StyleCache &StyleCache::instance() {
+    static StyleCache cache;
+    return cache;
+}
+
+StyleCache::StyleCache(): m_selected(0), m_clock(0), m_changed(false) { }
+
+string StyleCache::key(const string &first, const string &second) {
+    // neither file names nor resource names hold a newline
+    return first + '\n' + second;
+}
+
+bool StyleCache::stamp(const string &filename, Stamp &stamp) {
+    stamp = Stamp();
+#ifdef HAVE_SYS_STAT_H
+    struct stat st;
+    if (filename.empty() || stat(filename.c_str(), &st) != 0)
+        return false;
+    stamp.mtime = st.st_mtime;
+    stamp.size = st.st_size;
+    stamp.inode = st.st_ino;
+    return true;
+#else
+    return false;
+#endif // HAVE_SYS_STAT_H
+}
+
+void StyleCache::open(const string &filename) {
+    m_filename = filename;
+    m_entries.clear();
+    m_selected = 0;
+    m_clock = 0;
+    m_changed = false;
+
+    MappedFile file;
+    if (filename.empty() || !file.open(filename.c_str()) ||
+        file.size() < sizeof(MAGIC) - 1 ||
+        memcmp(file.data(), MAGIC, sizeof(MAGIC) - 1) != 0)
+        return;
+
+    Reader reader(file.data() + sizeof(MAGIC) - 1, file.size() - sizeof(MAGIC) + 1);
+    while (!reader.done()) {
+        string style;
+        Entry entry;
+        uint64_t count;
+        if (!reader.get(style) ||
+            !reader.get(entry.style.mtime) || !reader.get(entry.style.size) ||
+            !reader.get(entry.style.inode) ||
+            !reader.get(entry.overlay.mtime) || !reader.get(entry.overlay.size) ||
+            !reader.get(entry.overlay.inode) ||
+            !reader.get(entry.used) || !reader.get(count)) {
+            m_entries.clear(); // broken, start over
+            return;
+        }
+        for (uint64_t i = 0; i < count; ++i) {
+            string name;
+            uint64_t set;
+            Value value;
+            if (!reader.get(name) || !reader.get(set) || !reader.get(value.value)) {
+                m_entries.clear();
+                return;
+            }
+            value.set = set != 0;
+            entry.values[name] = value;
+        }
+        if (entry.used > m_clock)
+            m_clock = entry.used;
+        m_entries[style] = entry;
+    }
+}
+
+void StyleCache::save() {
+    if (m_filename.empty() || !m_changed)
+        return;
+
+    // forget the styles that weren't used for the longest time
+    while (m_entries.size() > MAX_STYLES) {
+        Entries::iterator oldest = m_entries.begin();
+        Entries::iterator it = m_entries.begin();
+        for (; it != m_entries.end(); ++it) {
+            if (it->second.used < oldest->second.used)
+                oldest = it;
+        }
+        if (&oldest->second == m_selected)
+            m_selected = 0;
+        m_entries.erase(oldest);
+    }
+
+    string out(MAGIC);
+    Entries::const_iterator it = m_entries.begin();
+    for (; it != m_entries.end(); ++it) {
+        const Entry &entry = it->second;
+        put(out, it->first);
+        put(out, entry.style.mtime);
+        put(out, entry.style.size);
+        put(out, entry.style.inode);
+        put(out, entry.overlay.mtime);
+        put(out, entry.overlay.size);
+        put(out, entry.overlay.inode);
+        put(out, entry.used);
+        put(out, uint64_t(entry.values.size()));
+        Values::const_iterator value = entry.values.begin();
+        for (; value != entry.values.end(); ++value) {
+            put(out, value->first);
+            put(out, uint64_t(value->second.set));
+            put(out, value->second.value);
+        }
+    }
+
+    // nobody sees a half written cache
+    string tmpfile = m_filename + ".tmp";
+    std::ofstream file(tmpfile.c_str(), std::ios::binary);
+    if (!file)
+        return;
+    file.write(out.data(), out.size());
+    file.close();
+    if (!file || rename(tmpfile.c_str(), m_filename.c_str()) != 0)
+        remove(tmpfile.c_str());
+    else
+        m_changed = false;
+}
+
+bool StyleCache::cached(const string &style, const string &overlay) {
+    Entries::iterator it = m_entries.find(key(style, overlay));
+    if (it == m_entries.end())
+        return false;
+
+    Stamp style_stamp, overlay_stamp;
+    // the overlay may well not exist
+    stamp(overlay, overlay_stamp);
+    if (stamp(style, style_stamp) && style_stamp == it->second.style &&
+        overlay_stamp == it->second.overlay)
+        return true;
+
+    if (&it->second == m_selected)
+        m_selected = 0;
+    m_entries.erase(it);
+    m_changed = true;
+    return false;
+}
+
+void StyleCache::select(const string &style, const string &overlay) {
+    m_selected = 0;
+    Stamp style_stamp;
+    if (!stamp(style, style_stamp))
+        return;
+
+    if (!cached(style, overlay)) {
+        Entry &entry = m_entries[key(style, overlay)];
+        entry.style = style_stamp;
+        stamp(overlay, entry.overlay);
+    }
+    m_selected = &m_entries[key(style, overlay)];
+    m_selected->used = ++m_clock;
+}
+
+bool StyleCache::find(const string &name, const string &altname,
+                      bool &set, string &value) const {
+    if (m_selected == 0)
+        return false;
+    Values::const_iterator it = m_selected->values.find(key(name, altname));
+    if (it == m_selected->values.end())
+        return false;
+    set = it->second.set;
+    value = it->second.value;
+    return true;
+}
+
+void StyleCache::values(std::vector<string> &values) const {
+    if (m_selected == 0)
+        return;
+    Values::const_iterator it = m_selected->values.begin();
+    for (; it != m_selected->values.end(); ++it) {
+        if (it->second.set)
+            values.push_back(it->second.value);
+    }
+}
+
+void StyleCache::store(const string &name, const string &altname,
+                       const char *value) {
+    if (m_selected == 0)
+        return;
+    Value &cached = m_selected->values[key(name, altname)];
+    cached.set = value != 0;
+    cached.value = value ? value : "";
+    m_changed = true;
+}
+
+} // end namespace FbTk
@@ -0,0 +1,118 @@
+// StyleCache.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#ifndef FBTK_STYLECACHE_HH
+#define FBTK_STYLECACHE_HH
+
+#include "NotCopyable.hh"
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace FbTk {
+
+/**
+   Keeps the values the themes looked up in a style in a file between
+   runs, so switching to a style that was used before neither parses the
+   style file nor asks an XrmDatabase for each value.
+
+   The values are kept for a style file together with its overlay and are
+   dropped as soon as one of the two files changed. Only the looked up
+   values are kept, a lookup the cache can't answer still needs the
+   database of the style.
+ */
+class StyleCache: private NotCopyable {
+public:
+    static StyleCache &instance();
+
+    /// reads the cache file, empty for none
+    void open(const std::string &filename);
+    /// writes the values of the most recently used styles back to the file
+    void save();
+
+    /**
+       Drops the values of a style if it or its overlay changed since
+       @return true if the values of the style are cached
+    */
+    bool cached(const std::string &style, const std::string &overlay);
+    /// lookups go to the values of this style from now on
+    void select(const std::string &style, const std::string &overlay);
+
+    /**
+       Gets a value of the selected style
+       @param set false if the style doesn't set the value
+       @return true if the lookup is cached
+    */
+    bool find(const std::string &name, const std::string &altname,
+              bool &set, std::string &value) const;
+    /// adds the values the selected style sets to 'values'
+    void values(std::vector<std::string> &values) const;
+    /// caches a lookup in the selected style, value is 0 if it's unset
+    void store(const std::string &name, const std::string &altname,
+               const char *value);
+
+private:
+    /// what tells us a file didn't change
+    struct Stamp {
+        Stamp(): mtime(0), size(0), inode(0) { }
+        bool operator == (const Stamp &other) const {
+            return mtime == other.mtime && size == other.size &&
+                inode == other.inode;
+        }
+        uint64_t mtime, size, inode;
+    };
+
+    struct Value {
+        Value(): set(false) { }
+        bool set;
+        std::string value;
+    };
+    /// by name and altname
+    typedef std::map<std::string, Value> Values;
+
+    struct Entry {
+        Entry(): used(0) { }
+        Stamp style, overlay;
+        uint64_t used; ///< when it was selected last
+        Values values;
+    };
+    /// by style and overlay
+    typedef std::map<std::string, Entry> Entries;
+
+    StyleCache();
+
+    static std::string key(const std::string &first, const std::string &second);
+    /// @return false if the file can't be stat()ed
+    static bool stamp(const std::string &filename, Stamp &stamp);
+
+    std::string m_filename;
+    Entries m_entries;
+    Entry *m_selected;
+    uint64_t m_clock; ///< counts the selections
+    bool m_changed; ///< the file misses values
+};
+
+} // end namespace FbTk
+
+#endif // FBTK_STYLECACHE_HH
@@ -1,5 +1,5 @@
-// SearchResult.cc for FbTk - Fluxbox Toolkit
-// Copyright (c) 2007 Fluxbox Team (fluxgen at fluxbox dot org)
+// TextBatch.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
 //
 // Permission is hereby granted, free of charge, to any person obtaining a
 // copy of this software and associated documentation files (the "Software"),
@@ -19,33 +19,45 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
 // DEALINGS IN THE SOFTWARE.
 
-#include "SearchResult.hh"
-#include "ITypeAheadable.hh"
+
+#include "TextBatch.hh"
+
+#include "FbDrawable.hh"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#ifdef USE_XFT
+#include "XftFontImp.hh"
+#endif // USE_XFT
 
 namespace FbTk {
 
-void SearchResult::seek() {
-    switch (m_results.size()) {
-    case 0:
-        break;
-    case 1:
-        m_seeked_string = m_results[0]->iTypeString();
-        break;
-    default:
-        bool seekforward = true;
-        for (size_t i=1; i < m_results.size() && seekforward &&
-            m_results[0]->iTypeCheckStringSize(m_seeked_string.size()); i++) {
-            if (!m_results[i]->iTypeCompareChar(
-                    m_results[0]->iTypeChar(m_seeked_string.size()),
-                    m_seeked_string.size())) {
-                seekforward = false;
-            } else if (i == m_results.size() - 1) {
-                m_seeked_string += m_results[0]->iTypeChar(m_seeked_string.size());
-                i = 0;
-            }
-        }
-        break;
+TextBatch *TextBatch::s_innermost = 0;
+
+TextBatch::TextBatch(const FbDrawable &drawable):
+    m_drawable(drawable.drawable()),
+    m_outer(s_innermost) {
+    s_innermost = this;
+}
+
+TextBatch::~TextBatch() {
+    s_innermost = m_outer;
+    // an enclosing batch for the same drawable sends it all
+    if (!collecting(m_drawable)) {
+#ifdef USE_XFT
+        XftFontImp::flushText(m_drawable);
+#endif // USE_XFT
+    }
+}
+
+bool TextBatch::collecting(Drawable drawable) {
+    for (TextBatch *batch = s_innermost; batch != 0; batch = batch->m_outer) {
+        if (batch->m_drawable == drawable)
+            return drawable != 0;
     }
+    return false;
 }
 
 } // end namespace FbTk
@@ -0,0 +1,66 @@
+// TextBatch.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#ifndef FBTK_TEXTBATCH_HH
+#define FBTK_TEXTBATCH_HH
+
+#include "NotCopyable.hh"
+
+#include <X11/Xlib.h>
+
+namespace FbTk {
+
+class FbDrawable;
+
+/**
+   Collects the text drawn to one drawable while it exists and draws it
+   with as few requests as possible when it goes out of scope, e.g.
+   around drawing all items of a menu:
+
+   {
+       TextBatch batch(frame);
+       for (...)
+           item->draw(frame, ...);
+   } // all labels are sent here
+
+   Only font implementations that can draw several strings at once
+   (Xft) collect text, the others draw right away. Collected text is
+   drawn after everything else drawn in the scope, so use it only
+   where labels don't get painted over.
+ */
+class TextBatch: private NotCopyable {
+public:
+    explicit TextBatch(const FbDrawable &drawable);
+    ~TextBatch();
+
+    /// @return true if text drawn to drawable should be collected
+    static bool collecting(Drawable drawable);
+
+private:
+    Drawable m_drawable;
+    TextBatch *m_outer; ///< enclosing batch, if any
+    static TextBatch *s_innermost;
+};
+
+} // end namespace FbTk
+
+#endif // FBTK_TEXTBATCH_HH
@@ -82,8 +82,10 @@ bool TextButton::setOrientation(FbTk::Orientation orient) {
 }
 
 void TextButton::setText(const FbTk::BiDiString &text) {
-    if (m_text.logical() != text.logical()) {
-        m_text = text;
+    bool changed = m_text != text;
+    // share the text even if it's the same, rather than keep a copy
+    m_text = text;
+    if (changed) {
         updateBackground(false);
         clear();
     }
@@ -120,7 +122,8 @@ void TextButton::clearArea(int x, int y,
                            unsigned int width, unsigned int height,
                            bool exposure) {
     Button::clearArea(x, y, width, height, exposure);
-    if (backgroundPixmap() == ParentRelative) 
+    // a composed background has the text already
+    if (backgroundPixmap() == ParentRelative && backgroundBuffer() == None)
         drawText(0, 0, this);
 }
 
@@ -24,8 +24,41 @@
 #include "Font.hh"
 #include "Theme.hh"
 
+#include <string>
 #include <strings.h>
 
+namespace {
+
+/// remembers how far recently drawn labels had to be shortened
+struct TruncateCache {
+    enum { SIZE = 64 };
+
+    struct Entry {
+        Entry(): font(0), width(0), max_width(0), newlen(0), newwidth(0), used(0) { }
+
+        const FbTk::Font *font;
+        std::string text;
+        int width, max_width;
+        unsigned int newlen;
+        int newwidth;
+        unsigned long used;
+    };
+
+    TruncateCache(): clock(0) { }
+
+    Entry entries[SIZE];
+    unsigned long clock;
+};
+
+TruncateCache s_truncate_cache;
+
+/// @return true if pos doesn't split a character
+bool isCharStart(const char *text, unsigned int pos) {
+    return !FbTk::Font::utf8() || (text[pos] & 0xc0) != 0x80;
+}
+
+} // anonymous namespace
+
 namespace FbTk {
 
 int doAlignment(int max_width, int bevel, FbTk::Justify justify,
@@ -39,11 +72,59 @@ int doAlignment(int max_width, int bevel, FbTk::Justify justify,
     unsigned int dlen = textlen;
     int dx = bevel;
     if (l > max_width) {
-        for (; dlen > 0; dlen--) {
-            l = font.textWidth(text, dlen) + bevel;
-            if (l<=max_width)
+        // the full width is part of the key, so a reloaded font misses
+        const int width = l;
+        TruncateCache &cache = s_truncate_cache;
+        TruncateCache::Entry *entry = 0, *oldest = cache.entries;
+        for (int i = 0; i < TruncateCache::SIZE; ++i) {
+            TruncateCache::Entry &e = cache.entries[i];
+            if (e.font == &font && e.width == width && e.max_width == max_width &&
+                e.text.size() == textlen && e.text.compare(0, textlen, text, textlen) == 0) {
+                entry = &e;
                 break;
+            }
+            if (e.used < oldest->used)
+                oldest = &e;
+        }
+
+        if (entry) {
+            dlen = entry->newlen;
+            l = entry->newwidth;
+        } else {
+            // longest prefix that fits, searching on character boundaries;
+            // [lo, hi) holds the answer, lo always fits
+            unsigned int lo = 0, hi = textlen;
+            l = bevel;
+            while (hi - lo > 1) {
+                unsigned int mid = lo + (hi - lo) / 2;
+                while (mid > lo && !isCharStart(text, mid))
+                    --mid;
+                if (mid == lo) {
+                    // no boundary below the middle, try above it
+                    mid = lo + (hi - lo) / 2 + 1;
+                    while (mid < hi && !isCharStart(text, mid))
+                        ++mid;
+                    if (mid == hi)
+                        break;
+                }
+                int w = font.textWidth(text, mid) + bevel;
+                if (w <= max_width) {
+                    lo = mid;
+                    l = w;
+                } else
+                    hi = mid;
+            }
+            dlen = lo;
+
+            entry = oldest;
+            entry->font = &font;
+            entry->text.assign(text, textlen);
+            entry->width = width;
+            entry->max_width = max_width;
+            entry->newlen = dlen;
+            entry->newwidth = l;
         }
+        entry->used = ++cache.clock;
     }
 
     newlen = dlen;
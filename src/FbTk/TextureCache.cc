@@ -0,0 +1,329 @@
+// TextureCache.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "TextureCache.hh"
+
+#include "Texture.hh"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <algorithm>
+
+#ifdef HAVE_CSTDIO
+  #include <cstdio>
+#else
+  #include <stdio.h>
+#endif
+#ifdef HAVE_CSTRING
+  #include <cstring>
+#else
+  #include <string.h>
+#endif
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // HAVE_SYS_MMAN_H
+
+namespace {
+
+/// "FBTC"
+const unsigned int MAGIC = 0x46425443;
+/// bump this whenever the output of a gradient renderer changes
+const unsigned int VERSION = 2;
+/// entries not used for this many runs are dropped
+const unsigned int MAX_AGE = 3;
+/// smaller buffers are cheaper to render than to look up
+const unsigned int MIN_PIXELS = 4096;
+
+enum { TYPE, COLOR, COLOR_TO, WIDTH, HEIGHT, NUM_VALUES };
+
+struct FileHeader {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int key_size;
+    unsigned int count;
+};
+
+struct FileEntry {
+    unsigned int key[NUM_VALUES];
+    unsigned int offset;
+    unsigned int age;
+};
+
+unsigned int packColor(const FbTk::Color &color) {
+    return ((color.red() & 0xff) << 16) | ((color.green() & 0xff) << 8) |
+        (color.blue() & 0xff);
+}
+
+size_t pixels(const FbTk::TextureCache::Key &key) {
+    return static_cast<size_t>(key.values[WIDTH]) * key.values[HEIGHT];
+}
+
+struct Candidate {
+    FbTk::TextureCache::Key key;
+    const unsigned char *data;
+    unsigned int age;
+};
+
+/// entries used in this run first, then the most recently used ones
+struct Fresher {
+    bool operator()(const Candidate &a, const Candidate &b) const {
+        return a.age < b.age;
+    }
+};
+
+} // anonymous namespace
+
+namespace FbTk {
+
+TextureCache::Key::Key() {
+    std::fill(values, values + NUM_VALUES, 0);
+}
+
+TextureCache::Key::Key(const Texture &texture,
+                       unsigned int width, unsigned int height) {
+    values[TYPE] = texture.type();
+    values[COLOR] = packColor(texture.color());
+    values[COLOR_TO] = packColor(texture.colorTo());
+    values[WIDTH] = width;
+    values[HEIGHT] = height;
+}
+
+bool TextureCache::Key::operator < (const Key &other) const {
+    return std::lexicographical_compare(values, values + NUM_VALUES,
+                                        other.values, other.values + NUM_VALUES);
+}
+
+TextureCache &TextureCache::instance() {
+    static TextureCache s_instance;
+    return s_instance;
+}
+
+TextureCache::TextureCache():
+    m_max_bytes(0),
+    m_map(0), m_map_size(0),
+    m_bytes(0),
+    m_hits(0), m_misses(0) {
+}
+
+TextureCache::~TextureCache() {
+    unmap();
+}
+
+void TextureCache::unmap() {
+    for (Entries::iterator it = m_entries.begin(); it != m_entries.end(); ) {
+        if (it->second.mapped)
+            m_entries.erase(it++);
+        else
+            ++it;
+    }
+
+#ifdef HAVE_SYS_MMAN_H
+    if (m_map)
+        munmap(m_map, m_map_size);
+#endif // HAVE_SYS_MMAN_H
+    m_map = 0;
+    m_map_size = 0;
+}
+
+void TextureCache::open(const std::string &filename, size_t max_bytes) {
+    unmap();
+    m_entries.clear();
+    m_bytes = 0;
+    m_filename = filename;
+    m_max_bytes = max_bytes;
+
+#ifdef HAVE_SYS_MMAN_H
+    if (m_filename.empty() || m_max_bytes == 0)
+        return;
+
+    int fd = ::open(m_filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(FileHeader) &&
+        static_cast<size_t>(st.st_size) <= m_max_bytes) {
+        m_map_size = st.st_size;
+        m_map = mmap(0, m_map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m_map == MAP_FAILED) {
+            m_map = 0;
+            m_map_size = 0;
+        }
+    }
+    ::close(fd);
+
+    if (m_map == 0)
+        return;
+
+    const unsigned char *base = static_cast<const unsigned char *>(m_map);
+    const FileHeader *header = reinterpret_cast<const FileHeader *>(base);
+    const FileEntry *entries = reinterpret_cast<const FileEntry *>(header + 1);
+
+    if (header->magic != MAGIC || header->version != VERSION ||
+        header->key_size != sizeof(FileEntry) ||
+        header->count > (m_map_size - sizeof(FileHeader)) / sizeof(FileEntry)) {
+        unmap();
+        return;
+    }
+
+    const size_t data_start = sizeof(FileHeader) + header->count * sizeof(FileEntry);
+    for (unsigned int i = 0; i < header->count; ++i) {
+        const FileEntry &file_entry = entries[i];
+        Key key;
+        memcpy(key.values, file_entry.key, sizeof(key.values));
+        size_t size = pixels(key) * 3;
+        // ignore anything that doesn't fit into the file
+        if (size == 0 || file_entry.offset < data_start ||
+            file_entry.offset > m_map_size || size > m_map_size - file_entry.offset)
+            continue;
+
+        Entry &entry = m_entries[key];
+        entry.mapped = base + file_entry.offset;
+        entry.age = file_entry.age;
+    }
+#endif // HAVE_SYS_MMAN_H
+}
+
+void TextureCache::save() {
+    if (m_filename.empty() || m_max_bytes == 0) {
+        unmap();
+        return;
+    }
+
+    std::vector<Candidate> candidates;
+    for (Entries::iterator it = m_entries.begin(); it != m_entries.end(); ++it) {
+        Entry &entry = it->second;
+        Candidate candidate;
+        candidate.key = it->first;
+        candidate.data = entry.mapped ? entry.mapped : &entry.stored[0];
+        candidate.age = entry.used ? 0 : entry.age + 1;
+        if (candidate.age <= MAX_AGE)
+            candidates.push_back(candidate);
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), Fresher());
+
+    // keep as many as fit
+    size_t size = sizeof(FileHeader);
+    size_t count = 0;
+    for (; count < candidates.size(); ++count) {
+        size_t entry_size = sizeof(FileEntry) + pixels(candidates[count].key) * 3;
+        if (size + entry_size > m_max_bytes)
+            break;
+        size += entry_size;
+    }
+
+    // write a new file and move it over the old one, which is still mapped
+    std::string tmpname = m_filename + ".new";
+    FILE *file = fopen(tmpname.c_str(), "wb");
+    if (file == 0) {
+        unmap();
+        return;
+    }
+
+    FileHeader header;
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.key_size = sizeof(FileEntry);
+    header.count = count;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    size_t offset = sizeof(FileHeader) + count * sizeof(FileEntry);
+    for (size_t i = 0; ok && i < count; ++i) {
+        FileEntry file_entry;
+        memcpy(file_entry.key, candidates[i].key.values, sizeof(file_entry.key));
+        file_entry.offset = offset;
+        file_entry.age = candidates[i].age;
+        ok = fwrite(&file_entry, sizeof(file_entry), 1, file) == 1;
+        offset += pixels(candidates[i].key) * 3;
+    }
+
+    for (size_t i = 0; ok && i < count; ++i) {
+        size_t data_size = pixels(candidates[i].key) * 3;
+        ok = fwrite(candidates[i].data, 1, data_size, file) == data_size;
+    }
+
+    if (fclose(file) != 0)
+        ok = false;
+
+    if (ok)
+        ok = rename(tmpname.c_str(), m_filename.c_str()) == 0;
+    if (!ok)
+        remove(tmpname.c_str());
+
+    unmap();
+}
+
+bool TextureCache::load(const Key &key, unsigned char *red,
+                        unsigned char *green, unsigned char *blue) {
+    if (m_max_bytes == 0 || pixels(key) < MIN_PIXELS)
+        return false;
+
+    Entries::iterator it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        ++m_misses;
+        return false;
+    }
+
+    Entry &entry = it->second;
+    const size_t size = pixels(key);
+    const unsigned char *data = entry.mapped ? entry.mapped : &entry.stored[0];
+    memcpy(red, data, size);
+    memcpy(green, data + size, size);
+    memcpy(blue, data + 2 * size, size);
+
+    if (!entry.used) {
+        entry.used = true;
+        m_bytes += 3 * size;
+    }
+    ++m_hits;
+    return true;
+}
+
+void TextureCache::store(const Key &key, const unsigned char *red,
+                         const unsigned char *green,
+                         const unsigned char *blue) {
+    const size_t size = pixels(key);
+    if (m_max_bytes == 0 || size < MIN_PIXELS ||
+        m_bytes + 3 * size > m_max_bytes)
+        return;
+
+    Entry &entry = m_entries[key];
+    if (entry.used)
+        return;
+    // replaces an unused mapped entry, too
+    entry.mapped = 0;
+    entry.age = 0;
+    entry.used = true;
+    entry.stored.resize(3 * size);
+    memcpy(&entry.stored[0], red, size);
+    memcpy(&entry.stored[size], green, size);
+    memcpy(&entry.stored[2 * size], blue, size);
+    m_bytes += 3 * size;
+}
+
+} // end namespace FbTk
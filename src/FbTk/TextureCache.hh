@@ -0,0 +1,115 @@
+// TextureCache.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#ifndef FBTK_TEXTURECACHE_HH
+#define FBTK_TEXTURECACHE_HH
+
+#include "NotCopyable.hh"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace FbTk {
+
+class Texture;
+
+/**
+   Keeps the rgb buffers of rendered gradients in a file between runs, so
+   that a (re)start of the window manager maps them instead of computing
+   them again.
+
+   The file is read through mmap() when it is opened and rewritten by
+   save(): entries used in this run come first, entries that weren't used
+   for MAX_AGE runs are dropped and the file never exceeds its size limit.
+
+   The buffers are independent of the visual, so all ImageControls share
+   them: on a multi-screen setup each gradient is rendered only once, with
+   or without a cache file.
+ */
+class TextureCache: private NotCopyable {
+public:
+    /// describes a rendered gradient buffer
+    struct Key {
+        Key();
+        Key(const Texture &texture, unsigned int width, unsigned int height);
+
+        bool operator < (const Key &other) const;
+
+        /// texture type, colors, width, height
+        unsigned int values[5];
+    };
+
+    static TextureCache &instance();
+
+    /**
+       Maps the cache file
+       @param filename file to load from and save to, empty for none
+       @param max_bytes size limit of the file, 0 disables the cache
+    */
+    void open(const std::string &filename, size_t max_bytes);
+    /// writes in-use entries back to the file and unmaps it
+    void save();
+
+    /**
+       Copies the buffers for key, if cached
+       @return true on a hit
+    */
+    bool load(const Key &key, unsigned char *red, unsigned char *green,
+              unsigned char *blue);
+    /// caches the rendered buffers for key
+    void store(const Key &key, const unsigned char *red,
+               const unsigned char *green, const unsigned char *blue);
+
+    unsigned long hits() const { return m_hits; }
+    unsigned long misses() const { return m_misses; }
+    /// @return bytes of the buffers used in this run
+    size_t bytes() const { return m_bytes; }
+
+private:
+    struct Entry {
+        Entry(): mapped(0), age(0), used(false) { }
+
+        const unsigned char *mapped;       ///< data in the mapped file
+        std::vector<unsigned char> stored; ///< or data rendered in this run
+        unsigned int age;                  ///< runs since the last use
+        bool used;                         ///< used in this run
+    };
+    typedef std::map<Key, Entry> Entries;
+
+    TextureCache();
+    ~TextureCache();
+
+    void unmap();
+
+    std::string m_filename;
+    size_t m_max_bytes;
+    void *m_map;
+    size_t m_map_size;
+    Entries m_entries;
+    size_t m_bytes;
+    unsigned long m_hits, m_misses;
+};
+
+} // end namespace FbTk
+
+#endif // FBTK_TEXTURECACHE_HH
@@ -32,10 +32,22 @@
 #include "GContext.hh"
 #include "I18n.hh"
 #include "StringUtil.hh"
+#include "GradientKernels.hh"
+#include "WorkerPool.hh"
+#include "TextureCache.hh"
+#include "MemoryAccount.hh"
+#include "Transparent.hh"
+#include "RoundTrips.hh"
+#include "Tracer.hh"
+#include "FbTime.hh"
 
 #include <X11/Xutil.h>
+#ifdef HAVE_XRENDER_GRADIENTS
+#include <X11/extensions/Xrender.h>
+#endif // HAVE_XRENDER_GRADIENTS
 
 #include <iostream>
+#include <vector>
 
 #ifdef HAVE_CSTDIO
   #include <cstdio>
@@ -348,6 +360,75 @@ void renderBevel2(bool interlaced,
 
 
 
+/// textures with fewer pixels are not worth waking up the worker threads
+const unsigned int PARALLEL_MIN_PIXELS = 128 * 1024;
+
+/// @return number of parts to split a texture of 'pixels' into
+unsigned int renderParts(unsigned int pixels) {
+    if (pixels < PARALLEL_MIN_PIXELS)
+        return 1;
+    return FbTk::WorkerPool::instance().threads();
+}
+
+/**
+   Combines the x and y tables of a two-dimensional gradient, see
+   GradientKernels::combineRows(). The rows are split between the threads
+   of the WorkerPool.
+ */
+class CombineTables: public FbTk::WorkerPool::Job {
+public:
+    CombineTables(bool interlaced,
+            unsigned int width, unsigned int height,
+            unsigned char* r, unsigned char* g, unsigned char* b,
+            const unsigned int* xtable, const unsigned int* ytable,
+            FbTk::GradientKernels::Op op, const unsigned int to[3],
+            const int sign[3], const int odd_sign[3]):
+        m_height(height),
+        m_planes(width * 3) {
+
+        // the kernels want one byte per channel and pixel
+        for (unsigned int x = 0; x < width; x++) {
+            for (unsigned int c = 0; c < 3; c++)
+                m_planes[c * width + x] = (unsigned char) xtable[x * 3 + c];
+        }
+
+        m_tables.interlaced = interlaced;
+        m_tables.width = width;
+        m_tables.out[0] = r;
+        m_tables.out[1] = g;
+        m_tables.out[2] = b;
+        m_tables.xplanes = width ? &m_planes[0] : 0;
+        m_tables.ytable = ytable;
+        m_tables.op = op;
+        m_tables.to = to;
+        m_tables.sign = sign;
+        m_tables.odd_sign = odd_sign;
+    }
+
+    void run(unsigned int part, unsigned int parts) {
+        FbTk::GradientKernels::combineRows(FbTk::GradientKernels::best(), m_tables,
+                                           m_height * part / parts,
+                                           m_height * (part + 1) / parts);
+    }
+
+private:
+    unsigned int m_height;
+    std::vector<unsigned char> m_planes;
+    FbTk::GradientKernels::Tables m_tables;
+};
+
+void combineTables(bool interlaced,
+        unsigned int width, unsigned int height,
+        unsigned char* r, unsigned char* g, unsigned char* b,
+        const unsigned int* xtable, const unsigned int* ytable,
+        FbTk::GradientKernels::Op op, const unsigned int to[3],
+        const int sign[3], const int odd_sign[3]) {
+
+    CombineTables job(interlaced, width, height, r, g, b, xtable, ytable,
+                      op, to, sign, odd_sign);
+    FbTk::WorkerPool::instance().run(job, renderParts(width * height));
+}
+
 void invertRGB(unsigned int w, unsigned int h,
         unsigned char* r, unsigned char* g, unsigned char* b) {
 
@@ -609,60 +690,10 @@ void renderPGradient(bool interlaced,
     }
 
     // Combine tables to create gradient
-
-
-    if (! interlaced) {
-
-        // normal pgradient
-        for (yt = ytable, y = 0; y < height; y++, yt += 3) {
-            for (xt = xtable, x = 0; x < width; x++) {
-                *(r++) = (unsigned char) (tr - (rsign * (*(xt++) + *(yt))));
-                *(g++) = (unsigned char) (tg - (gsign * (*(xt++) + *(yt + 1))));
-                *(b++) = (unsigned char) (tb - (bsign * (*(xt++) + *(yt + 2))));
-            }
-        }
-
-    } else {
-        // faked interlacing effect
-        unsigned char channel, channel2;
-
-        for (yt = ytable, y = 0; y < height; y++, yt += 3) {
-            for (xt = xtable, x = 0; x < width; x++) {
-                if (y & 1) {
-                    channel = (unsigned char) (tr - (rsign * (*(xt++) + *(yt))));
-                    channel2 = (channel >> 1) + (channel >> 2);
-                    if (channel2 > channel) channel2 = 0;
-                    *(r++) = channel2;
-
-                    channel = (unsigned char) (tg - (gsign * (*(xt++) + *(yt + 1))));
-                    channel2 = (channel >> 1) + (channel >> 2);
-                    if (channel2 > channel) channel2 = 0;
-                    *(g++) = channel2;
-
-                    channel = (unsigned char) (tb - (bsign * (*(xt++) + *(yt + 2))));
-                    channel2 = (channel >> 1) + (channel >> 2);
-                    if (channel2 > channel) channel2 = 0;
-                    *(b++) = channel2;
-                } else {
-                    channel = (unsigned char) (tr - (rsign * (*(xt++) + *(yt))));
-                    channel2 = channel + (channel >> 3);
-                    if (channel2 < channel) channel2 = ~0;
-                    *(r++) = channel2;
-
-                    channel = (unsigned char) (tg - (gsign * (*(xt++) + *(yt + 1))));
-                    channel2 = channel + (channel >> 3);
-                    if (channel2 < channel) channel2 = ~0;
-                    *(g++) = channel2;
-
-                    channel = (unsigned char) (tb - (bsign * (*(xt++) + *(yt + 2))));
-                    channel2 = channel + (channel >> 3);
-                    if (channel2 < channel) channel2 = ~0;
-                    *(b++) = channel2;
-                }
-            }
-        }
-    }
-
+    const unsigned int to_rgb[3] = { tr, tg, tb };
+    const int signs[3] = { rsign, gsign, bsign };
+    combineTables(interlaced, width, height, r, g, b, xtable, ytable,
+                  FbTk::GradientKernels::SUM, to_rgb, signs, signs);
 }
 
 
@@ -733,59 +764,10 @@ void renderRGradient(bool interlaced,
     }
 
     // Combine tables to create gradient
-
-
-    if (! interlaced) {
-
-        // normal rgradient
-        for (yt = ytable, y = 0; y < height; y++, yt += 3) {
-            for (xt = xtable, x = 0; x < width; x++) {
-                *(r++) = (unsigned char) (tr - (rsign * max(*(xt++), *(yt))));
-                *(g++) = (unsigned char) (tg - (gsign * max(*(xt++), *(yt + 1))));
-                *(b++) = (unsigned char) (tb - (bsign * max(*(xt++), *(yt + 2))));
-            }
-        }
-
-    } else {
-        // faked interlacing effect
-        unsigned char channel, channel2;
-
-        for (yt = ytable, y = 0; y < height; y++, yt += 3) {
-            for (xt = xtable, x = 0; x < width; x++) {
-                if (y & 1) {
-                    channel = (unsigned char) (tr - (rsign * max(*(xt++), *(yt))));
-                    channel2 = (channel >> 1) + (channel >> 2);
-                    if (channel2 > channel) channel2 = 0;
-                    *(r++) = channel2;
-
-                    channel = (unsigned char) (tg - (gsign * max(*(xt++), *(yt + 1))));
-                    channel2 = (channel >> 1) + (channel >> 2);
-                    if (channel2 > channel) channel2 = 0;
-                    *(g++) = channel2;
-
-                    channel = (unsigned char) (tb - (bsign * max(*(xt++), *(yt + 2))));
-                    channel2 = (channel >> 1) + (channel >> 2);
-                    if (channel2 > channel) channel2 = 0;
-                    *(b++) = channel2;
-                } else {
-                    channel = (unsigned char) (tr - (rsign * max(*(xt++), *(yt))));
-                    channel2 = channel + (channel >> 3);
-                    if (channel2 < channel) channel2 = ~0;
-                    *(r++) = channel2;
-
-                    channel = (unsigned char) (tg - (gsign * max(*(xt++), *(yt + 1))));
-                    channel2 = channel + (channel >> 3);
-                    if (channel2 < channel) channel2 = ~0;
-                    *(g++) = channel2;
-
-                    channel = (unsigned char) (tb - (bsign * max(*(xt++), *(yt + 2))));
-                    channel2 = channel + (channel >> 3);
-                    if (channel2 < channel) channel2 = ~0;
-                    *(b++) = channel2;
-                }
-            }
-        }
-    }
+    const unsigned int to_rgb[3] = { tr, tg, tb };
+    const int signs[3] = { rsign, gsign, bsign };
+    combineTables(interlaced, width, height, r, g, b, xtable, ytable,
+                  FbTk::GradientKernels::MAX, to_rgb, signs, signs);
 }
 
 
@@ -851,59 +833,10 @@ void renderDGradient(bool interlaced,
     }
 
     // Combine tables to create gradient
-    if (! interlaced) {
-
-        // normal dgradient
-        for (yt = ytable, y = 0; y < height; y++, yt += 3) {
-            for (xt = xtable, x = 0; x < width; x++) {
-                *(r++) = *(xt++) + *(yt);
-                *(g++) = *(xt++) + *(yt + 1);
-                *(b++) = *(xt++) + *(yt + 2);
-            }
-        }
-
-    } else {
-        // faked interlacing effect
-        unsigned char channel, channel2;
-
-        for (yt = ytable, y = 0; y < height; y++, yt += 3) {
-            for (xt = xtable, x = 0; x < width; x++) {
-                if (y & 1) {
-                    channel = *(xt++) + *(yt);
-                    channel2 = (channel >> 1) + (channel >> 2);
-                    if (channel2 > channel) channel2 = 0;
-                    *(r++) = channel2;
-
-                    channel = *(xt++) + *(yt + 1);
-                    channel2 = (channel >> 1) + (channel >> 2);
-                    if (channel2 > channel) channel2 = 0;
-                    *(g++) = channel2;
-
-                    channel = *(xt++) + *(yt + 2);
-                    channel2 = (channel >> 1) + (channel >> 2);
-                    if (channel2 > channel) channel2 = 0;
-                    *(b++) = channel2;
-                } else {
-                    channel = *(xt++) + *(yt);
-                    channel2 = channel + (channel >> 3);
-                    if (channel2 < channel) channel2 = ~0;
-                    *(r++) = channel2;
-
-                    channel = *(xt++) + *(yt + 1);
-                    channel2 = channel + (channel >> 3);
-                    if (channel2 < channel) channel2 = ~0;
-                    *(g++) = channel2;
-
-                    channel = *(xt++) + *(yt + 2);
-                    channel2 = channel + (channel >> 3);
-                    if (channel2 < channel) channel2 = ~0;
-                    *(b++) = channel2;
-                }
-            }
-        }
-    }
-
-
+    const unsigned int to_rgb[3] = { 0, 0, 0 };
+    const int signs[3] = { 0, 0, 0 };
+    combineTables(interlaced, width, height, r, g, b, xtable, ytable,
+                  FbTk::GradientKernels::SUM, to_rgb, signs, signs);
 }
 
 
@@ -1108,57 +1041,12 @@ void renderPCGradient(bool interlaced,
     }
 
     // Combine tables to create gradient
-    if (! interlaced) {
-
-        // normal pcgradient
-        for (yt = ytable, y = 0; y < height; y++, yt += 3) {
-            for (xt = xtable, x = 0; x < width; x++) {
-                *(r++) = (unsigned char) (tr - (rsign * min(*(xt++), *(yt))));
-                *(g++) = (unsigned char) (tg - (gsign * min(*(xt++), *(yt + 1))));
-                *(b++) = (unsigned char) (tb - (bsign * min(*(xt++), *(yt + 2))));
-            }
-        }
-
-    } else {
-        // faked interlacing effect
-        unsigned char channel, channel2;
-
-        for (yt = ytable, y = 0; y < height; y++, yt += 3) {
-            for (xt = xtable, x = 0; x < width; x++) {
-                if (y & 1) {
-                    channel = (unsigned char) (tr - (rsign * min(*(xt++), *(yt))));
-                    channel2 = (channel >> 1) + (channel >> 2);
-                    if (channel2 > channel) channel2 = 0;
-                    *(r++) = channel2;
-
-                    channel = (unsigned char) (tg - (bsign * min(*(xt++), *(yt + 1))));
-                    channel2 = (channel >> 1) + (channel >> 2);
-                    if (channel2 > channel) channel2 = 0;
-                    *(g++) = channel2;
-
-                    channel = (unsigned char) (tb - (gsign * min(*(xt++), *(yt + 2))));
-                    channel2 = (channel >> 1) + (channel >> 2);
-                    if (channel2 > channel) channel2 = 0;
-                    *(b++) = channel2;
-                } else {
-                    channel = (unsigned char) (tr - (rsign * min(*(xt++), *(yt))));
-                    channel2 = channel + (channel >> 3);
-                    if (channel2 < channel) channel2 = ~0;
-                    *(r++) = channel2;
-
-                    channel = (unsigned char) (tg - (gsign * min(*(xt++), *(yt + 1))));
-                    channel2 = channel + (channel >> 3);
-                    if (channel2 < channel) channel2 = ~0;
-                    *(g++) = channel2;
-
-                    channel = (unsigned char) (tb - (bsign * min(*(xt++), *(yt + 2))));
-                    channel2 = channel + (channel >> 3);
-                    if (channel2 < channel) channel2 = ~0;
-                    *(b++) = channel2;
-                }
-            }
-        }
-    }
+    const unsigned int to_rgb[3] = { tr, tg, tb };
+    const int signs[3] = { rsign, gsign, bsign };
+    // the dark lines have always used the signs of green and blue swapped
+    const int odd_signs[3] = { rsign, bsign, gsign };
+    combineTables(interlaced, width, height, r, g, b, xtable, ytable,
+                  FbTk::GradientKernels::MIN, to_rgb, signs, odd_signs);
 }
 
 
@@ -1222,57 +1110,10 @@ void renderCDGradient(bool interlaced,
     }
 
     // Combine tables to create gradient
-
-    if (! interlaced) {
-        // normal cdgradient
-        for (yt = ytable, y = 0; y < height; y++, yt += 3) {
-            for (xt = xtable, x = 0; x < width; x++) {
-                *(r++) = *(xt++) + *(yt);
-                *(g++) = *(xt++) + *(yt + 1);
-                *(b++) = *(xt++) + *(yt + 2);
-            }
-        }
-
-    } else {
-        // faked interlacing effect
-        unsigned char channel, channel2;
-
-        for (yt = ytable, y = 0; y < height; y++, yt += 3) {
-            for (xt = xtable, x = 0; x < width; x++) {
-                if (y & 1) {
-                    channel = *(xt++) + *(yt);
-                    channel2 = (channel >> 1) + (channel >> 2);
-                    if (channel2 > channel) channel2 = 0;
-                    *(r++) = channel2;
-
-                    channel = *(xt++) + *(yt + 1);
-                    channel2 = (channel >> 1) + (channel >> 2);
-                    if (channel2 > channel) channel2 = 0;
-                    *(g++) = channel2;
-
-                    channel = *(xt++) + *(yt + 2);
-                    channel2 = (channel >> 1) + (channel >> 2);
-                    if (channel2 > channel) channel2 = 0;
-                    *(b++) = channel2;
-                } else {
-                    channel = *(xt++) + *(yt);
-                    channel2 = channel + (channel >> 3);
-                    if (channel2 < channel) channel2 = ~0;
-                    *(r++) = channel2;
-
-                    channel = *(xt++) + *(yt + 1);
-                    channel2 = channel + (channel >> 3);
-                    if (channel2 < channel) channel2 = ~0;
-                    *(g++) = channel2;
-
-                    channel = *(xt++) + *(yt + 2);
-                    channel2 = channel + (channel >> 3);
-                    if (channel2 < channel) channel2 = ~0;
-                    *(b++) = channel2;
-                }
-            }
-        }
-    }
+    const unsigned int to_rgb[3] = { 0, 0, 0 };
+    const int signs[3] = { 0, 0, 0 };
+    combineTables(interlaced, width, height, r, g, b, xtable, ytable,
+                  FbTk::GradientKernels::SUM, to_rgb, signs, signs);
 }
 
 
@@ -1301,6 +1142,182 @@ const RendererActions render_bevel_actions[] = {
     { FbTk::Texture::BEVEL2, renderBevel2 }
 };
 
+#ifdef HAVE_XRENDER_GRADIENTS
+
+/// @return true if the server can draw gradients (RENDER 0.10)
+bool haveServerGradients() {
+    static int s_have = -1;
+    if (s_have < 0) {
+        int major = 0, minor = 0;
+        FBTK_ROUNDTRIP("TextureRender::haveServerGradients");
+        s_have = FbTk::Transparent::haveRender() &&
+            XRenderQueryVersion(FbTk::App::instance()->display(), &major, &minor) &&
+            (major > 0 || minor >= 10);
+    }
+    return s_have;
+}
+
+XRenderColor renderColor(const FbTk::Color &color) {
+    XRenderColor rcolor;
+    rcolor.red = color.red() * 0x101;
+    rcolor.green = color.green() * 0x101;
+    rcolor.blue = color.blue() * 0x101;
+    rcolor.alpha = 0xffff;
+    return rcolor;
+}
+
+/**
+   Draws horizontal, vertical, diagonal, crossdiagonal and elliptic
+   gradients with the RENDER extension, so nothing is rasterized or
+   uploaded by us. The gradient is set up in the coordinates of the
+   unrotated texture and sampled at the same points as the software
+   renderers; the picture transform takes care of the rotation.
+   @param width width of the rotated pixmap
+   @param height height of the rotated pixmap
+   @return rendered pixmap, or None if the software renderers are needed
+*/
+Pixmap renderServerGradient(FbTk::ImageControl &control, unsigned long type,
+                            unsigned int width, unsigned int height,
+                            FbTk::Orientation orientation,
+                            const FbTk::Color &from, const FbTk::Color &to,
+                            bool inverted) {
+    using FbTk::Texture;
+
+    if ((type & (Texture::INTERLACED | Texture::BEVEL1 | Texture::BEVEL2)) ||
+        !haveServerGradients())
+        return None;
+
+    // same precedence as render_gradient_actions
+    unsigned long shape = 0;
+    for (size_t i = 0; i < sizeof(render_gradient_actions)/sizeof(RendererActions); ++i) {
+        if (render_gradient_actions[i].type & type) {
+            shape = render_gradient_actions[i].type;
+            break;
+        }
+    }
+    if (!(shape & (Texture::HORIZONTAL | Texture::VERTICAL | Texture::DIAGONAL |
+                   Texture::CROSSDIAGONAL | Texture::ELLIPTIC)))
+        return None;
+
+    Display *disp = FbTk::App::instance()->display();
+    XRenderPictFormat *format = XRenderFindVisualFormat(disp, control.visual());
+    if (format == 0)
+        return None;
+
+    // unrotated size
+    unsigned int w = width, h = height;
+    FbTk::translateSize(orientation, w, h);
+    const double dw = w, dh = h;
+
+    // maps the centers of the pixmap's pixels to the unrotated texture,
+    // like FbPixmap::rotate does
+    double m[3][3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+    switch (orientation) {
+    case FbTk::ROT90:
+        m[0][0] = 0; m[0][1] = 1;
+        m[1][0] = -1; m[1][1] = 0; m[1][2] = width;
+        break;
+    case FbTk::ROT180:
+        m[0][0] = -1; m[0][2] = width;
+        m[1][1] = -1; m[1][2] = height;
+        break;
+    case FbTk::ROT270:
+        m[0][0] = 0; m[0][1] = -1; m[0][2] = height;
+        m[1][0] = 1; m[1][1] = 0;
+        break;
+    default:
+        break;
+    }
+
+    XFixed stops[2] = { XDoubleToFixed(0), XDoubleToFixed(1) };
+    XRenderColor colors[2];
+    Picture gradient = None;
+
+    if (shape == Texture::ELLIPTIC) {
+        // the software renderer goes from 'to' in the center to the mean
+        // of both colors on the edges; scale the ellipse to a circle of
+        // radius s / 2 around the origin
+        const double s = max(dw, dh);
+        const double sx = s / dw, sy = s / dh;
+        for (int i = 0; i < 3; ++i) {
+            m[0][i] *= sx;
+            m[1][i] *= sy;
+        }
+        m[0][2] -= (dw + 1) / 2 * sx;
+        m[1][2] -= (dh + 1) / 2 * sy;
+
+        XRadialGradient radial;
+        radial.inner.x = radial.inner.y = radial.outer.x = radial.outer.y = 0;
+        radial.inner.radius = 0;
+        radial.outer.radius = XDoubleToFixed(s);
+        // symmetric, inverting doesn't change it
+        colors[0] = renderColor(to);
+        colors[1] = renderColor(from);
+        gradient = XRenderCreateRadialGradient(disp, &radial, stops, colors, 2);
+    } else {
+        // the software renderers give pixel x the color at x / w
+        double x1 = 0, y1 = 0, x2 = 0, y2 = 0;
+        if (shape == Texture::HORIZONTAL) {
+            x1 = 0.5;
+            x2 = dw + 0.5;
+        } else if (shape == Texture::VERTICAL) {
+            y1 = 0.5;
+            y2 = dh + 0.5;
+        } else {
+            // the mean of a horizontal and a vertical gradient, the
+            // direction is chosen so that the projection gives
+            // (x / w + y / h) / 2
+            const double k = 2 / (1 / (dw * dw) + 1 / (dh * dh));
+            x1 = 0.5;
+            y1 = 0.5;
+            x2 = x1 + k / dw;
+            y2 = y1 + k / dh;
+            if (shape == Texture::CROSSDIAGONAL) {
+                x1 = dw - 0.5;
+                x2 = x1 - k / dw;
+            }
+        }
+
+        XLinearGradient linear;
+        linear.p1.x = XDoubleToFixed(x1);
+        linear.p1.y = XDoubleToFixed(y1);
+        linear.p2.x = XDoubleToFixed(x2);
+        linear.p2.y = XDoubleToFixed(y2);
+        // inverting a linear gradient swaps its colors
+        colors[0] = renderColor(inverted ? to : from);
+        colors[1] = renderColor(inverted ? from : to);
+        gradient = XRenderCreateLinearGradient(disp, &linear, stops, colors, 2);
+    }
+
+    if (gradient == None)
+        return None;
+
+    XTransform transform;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j)
+            transform.matrix[i][j] = XDoubleToFixed(m[i][j]);
+    }
+    XRenderSetPictureTransform(disp, gradient, &transform);
+
+    XRenderPictureAttributes attr;
+    attr.repeat = RepeatPad;
+    XRenderChangePicture(disp, gradient, CPRepeat, &attr);
+
+    Pixmap pixmap = FbTk::MemoryAccount::createPixmap(disp,
+                                  RootWindow(disp, control.screenNumber()),
+                                  width, height, control.depth());
+    Picture dest = XRenderCreatePicture(disp, pixmap, format, 0, 0);
+    XRenderComposite(disp, PictOpSrc, gradient, None, dest,
+                     0, 0, 0, 0, 0, 0, width, height);
+
+    XRenderFreePicture(disp, dest);
+    XRenderFreePicture(disp, gradient);
+
+    return pixmap;
+}
+
+#endif // HAVE_XRENDER_GRADIENTS
+
 }
 
 namespace FbTk {
@@ -1348,21 +1365,30 @@ TextureRender::~TextureRender() {
 
 
 Pixmap TextureRender::render(const FbTk::Texture &texture) {
+    Tracer::Span span("render", "TextureRender::render", "pixels",
+                      static_cast<unsigned long>(width) * height);
 
+    ImageControl::RenderKind kind;
     if (width == 0 || height == 0)
         return None;
     else if (texture.pixmap().drawable() != 0)
-        return renderPixmap(texture);
+        kind = ImageControl::RENDER_PIXMAP;
     else if (texture.type() & FbTk::Texture::PARENTRELATIVE)
         return ParentRelative;
     else if (texture.type() & FbTk::Texture::SOLID)
-        return renderSolid(texture);
-    else if (texture.type() & FbTk::Texture::GRADIENT) {
-        allocateColorTables();
-        return renderGradient(texture);
-    }
+        kind = ImageControl::RENDER_SOLID;
+    else if (texture.type() & FbTk::Texture::GRADIENT)
+        kind = ImageControl::RENDER_GRADIENT;
+    else
+        return None;
 
-    return None;
+    uint64_t start = FbTime::mono();
+    Pixmap pixmap = (kind == ImageControl::RENDER_PIXMAP ? renderPixmap(texture) :
+                     kind == ImageControl::RENDER_SOLID ? renderSolid(texture) :
+                     renderGradient(texture));
+    control.addRender(kind, static_cast<unsigned long>(width) * height,
+                      FbTime::mono() - start);
+    return pixmap;
 }
 
 void TextureRender::allocateColorTables() {
@@ -1453,9 +1479,6 @@ Pixmap TextureRender::renderSolid(const FbTk::Texture &texture) {
 
 Pixmap TextureRender::renderGradient(const FbTk::Texture &texture) {
 
-    // invert our width and height if necessary
-    translateSize(orientation, width, height);
-
     bool inverted = texture.type() & Texture::INVERT;
     const Color* from = &(texture.color());
     const Color* to = &(texture.colorTo());
@@ -1465,32 +1488,86 @@ Pixmap TextureRender::renderGradient(const FbTk::Texture &texture) {
         inverted = !inverted;
     }
 
-    size_t i;
-    // draw gradient
-    for (i = 0; i < sizeof(render_gradient_actions)/sizeof(RendererActions); ++i) {
-        if (render_gradient_actions[i].type & texture.type()) {
-            render_gradient_actions[i].render(texture.type() & Texture::INTERLACED,
-                width, height, red, green, blue, from, to, control);
-            break;
-        }
+#ifdef HAVE_XRENDER_GRADIENTS
+    Pixmap server = renderServerGradient(control, texture.type(),
+                                         width, height, orientation,
+                                         *from, *to, inverted);
+    if (server != None)
+        return server;
+#endif // HAVE_XRENDER_GRADIENTS
+
+    // invert our width and height if necessary
+    translateSize(orientation, width, height);
+
+    // horizontal and vertical gradients change only along one axis, so a
+    // single line of them is rendered and tiled over the pixmap
+    const unsigned int full_width = width, full_height = height;
+    if (!(texture.type() & (Texture::BEVEL1 | Texture::BEVEL2))) {
+        if ((texture.type() & Texture::HORIZONTAL) &&
+            !(texture.type() & Texture::INTERLACED))
+            height = 1;
+        else if (texture.type() & Texture::VERTICAL)
+            width = 1;
     }
 
-    // draw bevel
-    for (i = 0; i < sizeof(render_bevel_actions)/sizeof(RendererActions); ++i) {
-        if (render_bevel_actions[i].type & texture.type()) {
-            render_bevel_actions[i].render(texture.type() & Texture::INTERLACED,
-                width, height, red, green, blue, from, to, control);
-            break;
+    allocateColorTables();
+
+    TextureCache &cache = TextureCache::instance();
+    TextureCache::Key key(texture, width, height);
+    if (!cache.load(key, red, green, blue)) {
+        size_t i;
+        // draw gradient
+        for (i = 0; i < sizeof(render_gradient_actions)/sizeof(RendererActions); ++i) {
+            if (render_gradient_actions[i].type & texture.type()) {
+                render_gradient_actions[i].render(texture.type() & Texture::INTERLACED,
+                    width, height, red, green, blue, from, to, control);
+                break;
+            }
+        }
+
+        // draw bevel
+        for (i = 0; i < sizeof(render_bevel_actions)/sizeof(RendererActions); ++i) {
+            if (render_bevel_actions[i].type & texture.type()) {
+                render_bevel_actions[i].render(texture.type() & Texture::INTERLACED,
+                    width, height, red, green, blue, from, to, control);
+                break;
+            }
         }
+
+        if (inverted)
+            invertRGB(width, height, red, green, blue);
+
+        cache.store(key, red, green, blue);
     }
 
-    if (inverted)
-        invertRGB(width, height, red, green, blue);
+    if (width != full_width || height != full_height)
+        return renderTiled(full_width, full_height);
 
     return renderPixmap();
 
 }
 
+Pixmap TextureRender::renderTiled(unsigned int full_width, unsigned int full_height) {
+    // the line is rotated before it is tiled, which is much cheaper than
+    // rotating the whole pixmap
+    Pixmap line = renderPixmap();
+    if (line == None)
+        return None;
+
+    translateSize(orientation, full_width, full_height);
+    FbPixmap pixmap(line, full_width, full_height, control.depth());
+    if (pixmap.drawable() != None) {
+        GContext gc(pixmap);
+        gc.setTile(line);
+        gc.setFillStyle(FillTiled);
+        pixmap.fillRectangle(gc.gc(), 0, 0, full_width, full_height);
+    }
+
+    FbTk::MemoryAccount::freePixmap(FbTk::App::instance()->display(), line);
+
+    return pixmap.release();
+}
+
 Pixmap TextureRender::renderPixmap(const FbTk::Texture &src_texture) {
     unsigned int tmpw = width, tmph = height;
     // we are given width and height in rotated form, we
@@ -1518,12 +1595,25 @@ Pixmap TextureRender::renderPixmap(const FbTk::Texture &src_texture) {
     return pm_copy.release();
 }
 
+/// converts rows of the rgb buffers to pixels, split between threads
+class TextureRender::ConvertJob: public WorkerPool::Job {
+public:
+    ConvertJob(const TextureRender &render, XImage &image):
+        m_render(render), m_image(image) { }
+
+    void run(unsigned int part, unsigned int parts) {
+        unsigned int height = m_render.height;
+        m_render.convertRows(m_image, height * part / parts,
+                             height * (part + 1) / parts);
+    }
+
+private:
+    const TextureRender &m_render;
+    XImage &m_image;
+};
+
 XImage *TextureRender::renderXImage() {
-    Display *disp = FbTk::App::instance()->display();
-    XImage *image =
-        XCreateImage(disp,
-                     DefaultVisual(disp, control.screenNumber()), control.depth(), ZPixmap, 0, 0,
-                     width, height, 32, 0);
+    XImage *image = control.createImage(width, height);
 
     if (! image) {
         _FB_USES_NLS;
@@ -1531,22 +1621,45 @@ XImage *TextureRender::renderXImage() {
         return 0;
     }
 
-    image->data = 0;
+    switch (control.visual()->c_class) {
+    case StaticColor:
+    case PseudoColor:
+    case TrueColor:
+    case StaticGray:
+    case GrayScale:
+        break;
 
-    unsigned char *d = new unsigned char[image->bytes_per_line * (height + 1)];
+    default:
+        _FB_USES_NLS;
+        cerr << "TextureRender::renderXImage(): " <<
+            _FBTK_CONSOLETEXT(Error, UnsupportedVisual, "Unsupported visual", "A visual is a technical term in X") << endl;
+        control.destroyImage(image);
+        return (XImage *) 0;
+    }
+
+    ConvertJob job(*this, *image);
+    WorkerPool::instance().run(job, renderParts(width * height));
+
+    return image;
+}
+
+void TextureRender::convertRows(XImage &image,
+                                unsigned int y_begin, unsigned int y_end) const {
     register unsigned int x, y, r, g, b, o, offset;
 
-    unsigned char *pixel_data = d, *ppixel_data = d;
+    unsigned char *ppixel_data = reinterpret_cast<unsigned char *>(image.data) +
+        y_begin * image.bytes_per_line;
+    unsigned char *pixel_data = ppixel_data;
     unsigned long pixel;
 
-    o = image->bits_per_pixel + ((image->byte_order == MSBFirst) ? 1 : 0);
+    o = image.bits_per_pixel + ((image.byte_order == MSBFirst) ? 1 : 0);
 
     switch (control.visual()->c_class) {
     case StaticColor:
     case PseudoColor:
         {
-                int cpccpc = cpc * cpc;
-            for (y = 0, offset = 0; y < height; y++) {
+            int cpccpc = cpc * cpc;
+            for (y = y_begin, offset = y_begin * width; y < y_end; y++) {
                 for (x = 0; x < width; x++, offset++) {
                     r = red_table[red[offset]];
                     g = green_table[green[offset]];
@@ -1556,13 +1669,13 @@ XImage *TextureRender::renderXImage() {
                     *pixel_data++ = control.colors()[pixel].pixel;
                 }
 
-                pixel_data = (ppixel_data += image->bytes_per_line);
+                pixel_data = (ppixel_data += image.bytes_per_line);
             }
         }
         break;
 
     case TrueColor:
-        for (y = 0, offset = 0; y < height; y++) {
+        for (y = y_begin, offset = y_begin * width; y < y_end; y++) {
             for (x = 0; x < width; x++, offset++) {
                 r = red_table[red[offset]];
                 g = green_table[green[offset]];
@@ -1613,14 +1726,14 @@ XImage *TextureRender::renderXImage() {
                 }
             }
 
-            pixel_data = (ppixel_data += image->bytes_per_line);
+            pixel_data = (ppixel_data += image.bytes_per_line);
         }
 
         break;
 
     case StaticGray:
     case GrayScale:
-        for (y = 0, offset = 0; y < height; y++) {
+        for (y = y_begin, offset = y_begin * width; y < y_end; y++) {
             for (x = 0; x < width; x++, offset++) {
                 r = *(red_table + *(red + offset));
                 g = *(green_table + *(green + offset));
@@ -1630,22 +1743,11 @@ XImage *TextureRender::renderXImage() {
                 *pixel_data++ = control.colors()[g].pixel;
             }
 
-            pixel_data = (ppixel_data += image->bytes_per_line);
+            pixel_data = (ppixel_data += image.bytes_per_line);
         }
 
         break;
-
-    default:
-        _FB_USES_NLS;
-        cerr << "TextureRender::renderXImage(): " <<
-            _FBTK_CONSOLETEXT(Error, UnsupportedVisual, "Unsupported visual", "A visual is a technical term in X") << endl;
-        delete [] d;
-        XDestroyImage(image);
-        return (XImage *) 0;
     }
-
-    image->data = (char *) d;
-    return image;
 }
 
 
@@ -1665,20 +1767,11 @@ Pixmap TextureRender::renderPixmap() {
     if (! image) {
         return None;
     } else if (! image->data) {
-        XDestroyImage(image);
+        control.destroyImage(image);
         return None;
     }
 
-    XPutImage(disp, pixmap.drawable(),
-              DefaultGC(disp, control.screenNumber()),
-              image, 0, 0, 0, 0, width, height);
-
-    if (image->data != 0) {
-        delete [] image->data;
-        image->data = 0;
-    }
-
-    XDestroyImage(image);
+    control.putImage(pixmap.drawable(), image);
 
     pixmap.rotate(orientation);
 
@@ -59,11 +59,20 @@ private:
        @return rendered pixmap
     */
     Pixmap renderPixmap();
+    /**
+       Render the one line high (or wide) gradient in the buffers and
+       fill a pixmap of the given size with it
+       @return rendered pixmap
+    */
+    Pixmap renderTiled(unsigned int full_width, unsigned int full_height);
     /**
        Render to XImage
        @returns allocated and rendered XImage, user is responsible to deallocate
     */
     XImage *renderXImage();
+    /// converts rows y_begin to y_end - 1 of the rgb buffers into image
+    void convertRows(XImage &image, unsigned int y_begin, unsigned int y_end) const;
+    class ConvertJob;
 
     ImageControl &control;
 
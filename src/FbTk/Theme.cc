@@ -28,6 +28,9 @@
 #include "I18n.hh"
 #include "Image.hh"
 #include "STLUtil.hh"
+#include "Font.hh"
+#include "StyleCache.hh"
+#include "StartupProfile.hh"
 
 #ifdef HAVE_CSTDIO
   #include <cstdio>
@@ -37,6 +40,7 @@
 #include <memory>
 #include <iostream>
 #include <algorithm>
+#include <vector>
 
 using std::cerr;
 using std::endl;
@@ -44,6 +48,17 @@ using std::string;
 
 namespace FbTk {
 
+namespace {
+
+Bool collectValue(XrmDatabase *, XrmBindingList, XrmQuarkList,
+                  XrmRepresentation *, XrmValue *value, XPointer values) {
+    if (value->addr != 0)
+        reinterpret_cast<std::vector<string> *>(values)->push_back(value->addr);
+    return False;
+}
+
+} // anonymous namespace
+
 struct LoadThemeHelper {
     LoadThemeHelper():m_tm(ThemeManager::instance()) {}
     void operator ()(Theme *tm) {
@@ -52,10 +67,13 @@ struct LoadThemeHelper {
     void operator ()(ThemeManager::ThemeList &tmlist) {
 
         STLUtil::forAll(tmlist, *this);
-        // send reconfiguration signal to theme and listeners
+        // send reconfiguration signal to the changed themes and listeners
         ThemeManager::ThemeList::iterator it = tmlist.begin();
         ThemeManager::ThemeList::iterator it_end = tmlist.end();
         for (; it != it_end; ++it) {
+            if (!(*it)->changed())
+                continue;
+            (*it)->setChanged(false);
             (*it)->reconfigSig().emit();
         }
     }
@@ -63,7 +81,7 @@ struct LoadThemeHelper {
     ThemeManager &m_tm;
 };
 
-Theme::Theme(int screen_num):m_screen_num(screen_num) {
+Theme::Theme(int screen_num):m_screen_num(screen_num), m_changed(true) {
     ThemeManager::instance().registerTheme(*this);
 }
 
@@ -81,7 +99,9 @@ ThemeManager::ThemeManager():
     // without having a display connection
     m_max_screens(-1),
     m_verbose(false),
-    m_themelocation("") {
+    m_database_loaded(true),
+    m_themelocation(""),
+    m_loading(0) {
 
 }
 
@@ -115,6 +135,7 @@ bool ThemeManager::unregisterTheme(Theme &tm) {
 
 bool ThemeManager::load(const string &filename,
                         const string &overlay_filename, int screen_num) {
+    StartupProfile::Phase phase("style");
     string location = FbTk::StringUtil::expandFilename(filename);
     StringUtil::removeTrailingWhitespace(location);
     StringUtil::removeFirstWhitespace(location);
@@ -137,22 +158,19 @@ bool ThemeManager::load(const string &filename,
         prefix = location.substr(0, location.find_last_of('/'));
     }
 
-    if (!m_database.load(location.c_str()))
-        return false;
+    string overlay_location;
+    if (!overlay_filename.empty())
+        overlay_location = FbTk::StringUtil::expandFilename(overlay_filename);
 
-
-    if (!overlay_filename.empty()) {
-        string overlay_location = FbTk::StringUtil::expandFilename(overlay_filename);
-        if (FileUtil::isRegularFile(overlay_location.c_str())) {
-            XrmDatabaseHelper overlay_db;
-            if (overlay_db.load(overlay_location.c_str())) {
-                // after a merge the src_db is destroyed
-                // so, make sure XrmDatabaseHelper::m_database == 0
-                XrmMergeDatabases(*overlay_db, &(*m_database));
-                *overlay_db = 0;
-            }
-        }
-    }
+    // a cached style is only parsed if a lookup misses the cache
+    StyleCache &cache = StyleCache::instance();
+    const bool cached = cache.cached(location, overlay_location);
+    if (!cached && !loadDatabase(location, overlay_location))
+        return false;
+    m_database_loaded = !cached;
+    m_style_location = location;
+    m_overlay_location = overlay_location;
+    cache.select(location, overlay_location);
 
     // relies on the fact that load_rc clears search paths each time
     if (m_themelocation != "") {
@@ -168,6 +186,17 @@ bool ThemeManager::load(const string &filename,
     location.append("/pixmaps");
     Image::addSearchPath(location);
 
+    // the themes load the images one by one
+    std::vector<string> values;
+    if (m_database_loaded) {
+        XrmName name = NULLQUARK;
+        XrmClass class_name = NULLQUARK;
+        XrmEnumerateDatabase(*m_database, &name, &class_name, XrmEnumAllLevels,
+                             collectValue, reinterpret_cast<XPointer>(&values));
+    } else
+        cache.values(values);
+    Image::prefetch(values, screen_num <= m_max_screens ? screen_num : -1);
+
     LoadThemeHelper load_theme_helper;
 
     // get list and go throu all the resources and load them
@@ -178,10 +207,44 @@ bool ThemeManager::load(const string &filename,
         load_theme_helper(m_themes[screen_num]);
     }
 
+    // the old style's fonts aren't needed anymore
+    Font::evictUnused();
+
+    return true;
+}
+
+bool ThemeManager::loadDatabase(const string &location,
+                                const string &overlay_location) {
+    XrmDatabaseHelper database;
+    if (!database.load(location.c_str()))
+        return false;
+
+    if (!overlay_location.empty() &&
+        FileUtil::isRegularFile(overlay_location.c_str())) {
+        XrmDatabaseHelper overlay_db;
+        if (overlay_db.load(overlay_location.c_str())) {
+            // after a merge the src_db is destroyed
+            // so, make sure XrmDatabaseHelper::m_database == 0
+            XrmMergeDatabases(*overlay_db, &(*database));
+            *overlay_db = 0;
+        }
+    }
+
+    m_database = *database;
+    *database = 0;
     return true;
 }
 
 void ThemeManager::loadTheme(Theme &tm) {
+    StartupProfile::Phase phase("style");
+    // fallbacks may load other themes
+    Theme *loading = m_loading;
+    string values;
+    m_loading = &tm;
+    m_values.swap(values);
+    // the pixmaps are searched for in the style's directory
+    addValue("location", m_themelocation.c_str());
+
     Theme::ItemList::iterator i = tm.itemList().begin();
     Theme::ItemList::iterator i_end = tm.itemList().end();
     for (; i != i_end; ++i) {
@@ -197,7 +260,14 @@ void ThemeManager::loadTheme(Theme &tm) {
             }
         }
     }
-    // send reconfiguration signal to theme and listeners
+
+    // the listeners only need to hear about the theme if a value changed
+    if (m_values != tm.m_values) {
+        tm.m_values.swap(m_values);
+        tm.setChanged();
+    }
+    m_loading = loading;
+    m_values.swap(values);
 }
 
 bool ThemeManager::loadItem(ThemeItem_base &resource) {
@@ -206,26 +276,54 @@ bool ThemeManager::loadItem(ThemeItem_base &resource) {
 
 /// handles resource item loading with specific name/altname
 bool ThemeManager::loadItem(ThemeItem_base &resource, const string &name, const string &alt_name) {
-    XrmValue value;
-    char *value_type;
-    if (XrmGetResource(*m_database, name.c_str(),
-                       alt_name.c_str(), &value_type, &value)) {
-        resource.setFromString(value.addr);
-        resource.load(&name, &alt_name); // load additional stuff by the ThemeItem
-    } else
+    string value;
+    if (!lookup(name, alt_name, value))
         return false;
 
+    resource.setFromString(value.c_str());
+    resource.load(&name, &alt_name); // load additional stuff by the ThemeItem
     return true;
 }
 
 string ThemeManager::resourceValue(const string &name, const string &altname) {
-    XrmValue value;
-    char *value_type;
-    if (*m_database != 0 && XrmGetResource(*m_database, name.c_str(),
-                                           altname.c_str(), &value_type, &value) && value.addr != 0)
-        return string(value.addr);
+    string value;
+    lookup(name, altname, value);
+    return value;
+}
+
+bool ThemeManager::lookup(const string &name, const string &altname,
+                          string &value) {
+    StyleCache &cache = StyleCache::instance();
+    bool set = false;
+    if (!cache.find(name, altname, set, value)) {
+        if (!m_database_loaded) {
+            m_database_loaded = true;
+            loadDatabase(m_style_location, m_overlay_location);
+        }
+
+        XrmValue xrm_value;
+        char *value_type;
+        set = *m_database != 0 && XrmGetResource(*m_database, name.c_str(),
+                                                 altname.c_str(), &value_type,
+                                                 &xrm_value) &&
+            xrm_value.addr != 0;
+        value = set ? xrm_value.addr : "";
+        cache.store(name, altname, set ? value.c_str() : 0);
+    }
+
+    addValue(name, set ? value.c_str() : 0);
+    return set;
+}
 
-    return "";
+void ThemeManager::addValue(const string &name, const char *value) {
+    if (m_loading == 0)
+        return;
+    m_values.append(name);
+    if (value) {
+        m_values.append(1, ':');
+        m_values.append(value);
+    }
+    m_values.append(1, '\n');
 }
 
 /*
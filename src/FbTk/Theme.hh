@@ -108,9 +108,17 @@ public:
     void remove(ThemeItem<T> &item);
     virtual bool fallback(ThemeItem_base &) { return false; }
     Signal<> &reconfigSig() { return m_reconfig_sig; }
+    /// @return true if the reconfigure signal is due
+    bool changed() const { return m_changed; }
+    /// for values of the theme that aren't read from the style
+    void setChanged(bool changed = true) { m_changed = changed; }
 
 private:
+    friend class ThemeManager; // keeps the values of the last load
     const int m_screen_num;
+    bool m_changed;
+    /// the style values read by the last load
+    std::string m_values;
 
     ItemList m_themeitems;
     Signal<> m_reconfig_sig;
@@ -163,6 +171,14 @@ private:
     bool registerTheme(FbTk::Theme &tm);
     /// @return false if theme isn't registred in the manager
     bool unregisterTheme(FbTk::Theme &tm);
+    /// reads the style file and its overlay into m_database
+    bool loadDatabase(const std::string &location,
+                      const std::string &overlay_location);
+    /// @return false if the style doesn't set the value
+    bool lookup(const std::string &name, const std::string &altname,
+                std::string &value);
+    /// remembers a value read for the theme being loaded, 0 if it's unset
+    void addValue(const std::string &name, const char *value);
     /// map each theme manager to a screen
 
     ScreenThemeVector m_themes;
@@ -170,7 +186,13 @@ private:
     XrmDatabaseHelper m_database;
     bool m_verbose;
 
+    std::string m_style_location, m_overlay_location;
+    /// false while the values of a style come from the StyleCache
+    bool m_database_loaded;
+
     std::string m_themelocation;
+    Theme *m_loading; ///< the theme loadTheme reads the values of
+    std::string m_values; ///< the values read for m_loading
 };
 
 
@@ -34,7 +34,7 @@
 #include "Font.hh"
 #include "GContext.hh"
 #include "PixmapWithMask.hh"
-#include "Image.hh"
+#include "IconCache.hh"
 #include "Shape.hh"
 #include "StringUtil.hh"
 
@@ -56,7 +56,6 @@
 #endif
 
 #include <iostream>
-#include <memory>
 
 namespace FbTk {
 
@@ -227,16 +226,17 @@ void ThemeItem<Texture>::load(const string *o_name, const string *o_altname) {
         return;
     }
 
-    std::auto_ptr<PixmapWithMask> pm(Image::load(pixmap_name, m_tm.screenNum()));
+    // styles load the same pixmaps again on each screen and reload
+    RefCount<PixmapWithMask> pm(IconCache::instance().get(pixmap_name, m_tm.screenNum(), 0));
 
-    if (pm.get() == 0) {
+    if (!pm) {
         if (ThemeManager::instance().verbose()) {
             cerr<<"Resource("<<m_name+".pixmap"
                 <<"): Failed to load image: "<<pixmap_name<<endl;
         }
         m_value.pixmap() = 0;
     } else
-        m_value.pixmap() = pm->pixmap().release();
+        m_value.pixmap().copy(pm->pixmap());
 
 }
 
@@ -277,12 +277,12 @@ setFromString(const char *str) {
         StringUtil::removeFirstWhitespace(filename);
         StringUtil::removeTrailingWhitespace(filename);
 
-        std::auto_ptr<PixmapWithMask> pm(Image::load(filename, m_tm.screenNum()));
-        if (pm.get() == 0)
+        RefCount<PixmapWithMask> pm(IconCache::instance().get(filename, m_tm.screenNum(), 0));
+        if (!pm)
             setDefaultValue();
         else {
-            (*this)->pixmap() = pm->pixmap().release();
-            (*this)->mask() = pm->mask().release();
+            (*this)->pixmap().copy(pm->pixmap());
+            (*this)->mask().copy(pm->mask());
         }
     }
 }
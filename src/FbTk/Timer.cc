@@ -25,7 +25,10 @@
 #include "Timer.hh"
 
 #include "CommandParser.hh"
+#include "Reactor.hh"
 #include "StringUtil.hh"
+#include "Tracer.hh"
+#include "Watchdog.hh"
 
 //use GNU extensions
 #ifndef	_GNU_SOURCE
@@ -42,24 +45,96 @@
   #include <assert.h>
 #endif
 
-// sys/select.h on solaris wants to use memset()
-#ifdef HAVE_CSTRING
-#  include <cstring>
-#else
-#  include <string.h>
+#ifdef HAVE_SYS_TIMERFD_H
+#  include <sys/timerfd.h>
+#  include <fcntl.h>
 #endif
 
-#ifdef HAVE_SYS_SELECT_H
-#  include <sys/select.h>
-#elif defined(_WIN32)
-#  include <winsock.h>
-#endif
+namespace {
+
+/// the descriptor passed to updateTimers() only has to wake us up,
+/// whoever passed it in reads from it
+struct IgnoreFd {
+    void operator()(int fd, int events) const { }
+};
+
+#ifdef HAVE_SYS_TIMERFD_H
+
+// with a timerfd the kernel wakes us up at the absolute (monotonic)
+// deadline of the next timer, so the reactor needs no timeout at all
+
+int s_timerfd = -2; ///< -2: not yet created, -1: not available
+uint64_t s_armed = 0; ///< deadline the timerfd is currently armed for
+
+struct ReadTimerFd {
+    void operator()(int fd, int events) const {
+        if (events & FbTk::Reactor::INVALID) {
+            // the reactor dropped it, fall back to timeouts
+            s_timerfd = -1;
+            s_armed = 0;
+            return;
+        }
+        uint64_t expirations;
+        if (read(fd, &expirations, sizeof(expirations)) < 0) {
+            // nothing to do, the timers are checked anyway
+        }
+        s_armed = 0;
+    }
+};
+
+int timerFd() {
+    if (s_timerfd == -2) {
+        s_timerfd = timerfd_create(CLOCK_MONOTONIC, 0);
+        if (s_timerfd != -1) {
+            fcntl(s_timerfd, F_SETFD, FD_CLOEXEC);
+            fcntl(s_timerfd, F_SETFL, O_NONBLOCK);
+            FbTk::Reactor::instance().addFunctor(s_timerfd, FbTk::Reactor::READ, ReadTimerFd());
+        }
+    }
+    return s_timerfd;
+}
+
+/// (re)arms the timerfd, if needed
+/// @return false if no timerfd is available
+bool armTimerFd(uint64_t end) {
+    if (timerFd() < 0)
+        return false;
+
+    if (s_armed == end)
+        return true;
+
+    itimerspec its;
+    its.it_interval.tv_sec = 0;
+    its.it_interval.tv_nsec = 0;
+    its.it_value.tv_sec = end / FbTk::FbTime::IN_SECONDS;
+    its.it_value.tv_nsec = (end % FbTk::FbTime::IN_SECONDS) * 1000L;
+
+    if (timerfd_settime(s_timerfd, TFD_TIMER_ABSTIME, &its, 0) != 0) {
+        FbTk::Reactor::instance().remove(s_timerfd);
+        close(s_timerfd);
+        s_timerfd = -1;
+        return false;
+    }
+
+    s_armed = end;
+    return true;
+}
+
+#endif // HAVE_SYS_TIMERFD_H
+
+} // anonymous namespace
 
 namespace FbTk {
 
 Timer::TimerList Timer::m_timerlist;
 
-Timer::Timer():m_timing(false), m_once(false), m_interval(0) {
+Timer::Timer():
+    m_timing(false),
+    m_once(false),
+    m_interval(0),
+    m_start(0),
+    m_timeout(0),
+    m_end(0) {
 
 }
 
@@ -67,7 +142,10 @@ Timer::Timer(const RefCount<Slot<void> > &handler):
     m_handler(handler),
     m_timing(false),
     m_once(false),
-    m_interval(0) {
+    m_interval(0),
+    m_start(0),
+    m_timeout(0),
+    m_end(0) {
 }
 
 
@@ -77,21 +155,16 @@ Timer::~Timer() {
 
 
 void Timer::setTimeout(time_t t) {
-    m_timeout.tv_sec = t / 1000;
-    m_timeout.tv_usec = t;
-    m_timeout.tv_usec -= (m_timeout.tv_sec * 1000);
-    m_timeout.tv_usec *= 1000;
+    m_timeout = t * FbTime::IN_MILLISECONDS;
 }
 
 
 void Timer::setTimeout(const timeval &t) {
-    m_timeout.tv_sec = t.tv_sec;
-    m_timeout.tv_usec = t.tv_usec;
+    m_timeout = t.tv_sec * FbTime::IN_SECONDS + t.tv_usec;
 }
 
 void Timer::setTimeout(unsigned int secs, unsigned int usecs) {
-    m_timeout.tv_sec = secs;
-    m_timeout.tv_usec = usecs;
+    m_timeout = secs * FbTime::IN_SECONDS + usecs;
 }
 
 void Timer::setCommand(const RefCount<Slot<void> > &cmd) {
@@ -99,13 +172,19 @@ void Timer::setCommand(const RefCount<Slot<void> > &cmd) {
 }
 
 void Timer::start() {
-    gettimeofday(&m_start, 0);
+    // a running timer is restarted, so take it out of the set before
+    // its trigger time changes
+    if (m_timing)
+        removeTimer(this);
+
+    m_start = FbTime::mono();
 
     // only add Timers that actually DO something
-    if ((! m_timing || m_interval != 0) && m_handler) {
+    if (m_handler) {
         m_timing = true;
         addTimer(this); //add us to the list
-    }
+    } else
+        m_timing = false;
 }
 
 
@@ -114,157 +193,99 @@ void Timer::stop() {
     removeTimer(this); //remove us from the list
 }
 
-void Timer::makeEndTime(timeval &tm) const {
-    tm.tv_sec = m_start.tv_sec + m_timeout.tv_sec;
-    tm.tv_usec = m_start.tv_usec + m_timeout.tv_usec;
-    if (tm.tv_usec >= 1000000) {
-        tm.tv_usec -= 1000000;
-        tm.tv_sec++;
-    }
-}
-
 
 void Timer::fireTimeout() {
+    Tracer::Span span("timer", "Timer::fireTimeout", "timeout ms",
+                      m_timeout / FbTime::IN_MILLISECONDS);
     if (m_handler)
         (*m_handler)();
 }
 
 void Timer::updateTimers(int fd) {
-    fd_set rfds;
-    timeval now, tm, *timeout = 0;
 
-    FD_ZERO(&rfds);
-    FD_SET(fd, &rfds);
+    Reactor &reactor = Reactor::instance();
+    if (!reactor.isWatching(fd))
+        reactor.addFunctor(fd, Reactor::READ, IgnoreFd());
 
-    bool overdue = false;
+    int64_t timeout = -1; // wait forever
 
     // see, if the first timer in the
     // list is overdue
     if (!m_timerlist.empty()) {
-        gettimeofday(&now, 0);
-
-        Timer *timer = m_timerlist.front();
-
-        timer->makeEndTime(tm);
-
-        tm.tv_sec -= now.tv_sec;
-        tm.tv_usec -= now.tv_usec;
-
-        while (tm.tv_usec < 0) {
-            if (tm.tv_sec > 0) {
-                tm.tv_sec--;
-                tm.tv_usec += 1000000;
-            } else {
-                overdue = true;
-                tm.tv_usec = 0;
-                break;
-            }
-        }
-
-        if (tm.tv_sec < 0) { // usec zero-ed above if negative
-            tm.tv_sec = 0;
-            tm.tv_usec = 0;
-            overdue = true;
-        }
-
-        timeout = &tm;
+        uint64_t now = FbTime::mono();
+        uint64_t end = (*m_timerlist.begin())->m_end;
+
+        if (end <= now)
+            timeout = 0;
+#ifdef HAVE_SYS_TIMERFD_H
+        else if (armTimerFd(end))
+            timeout = -1;
+#endif // HAVE_SYS_TIMERFD_H
+        else
+            timeout = end - now;
     }
 
-    // if not overdue, wait for the next xevent via the blocking
-    // select(), so OS sends fluxbox to sleep. the select() will
-    // time out when the next timer has to be handled
-    if (!overdue && select(fd + 1, &rfds, 0, 0, timeout) != 0)
-        // didn't time out! x events are pending
-        return;
-
-    TimerList::iterator it;
+    // if not overdue, wait for the next xevent (or any other watched
+    // descriptor), so OS sends fluxbox to sleep. the wait will time out
+    // (or the timerfd triggers) when the next timer has to be handled
+    if (timeout != 0)
+        reactor.wait(timeout);
 
     // check for timer timeout
-    gettimeofday(&now, 0);
-
-    // someone set the date of the machine BACK
-    // so we have to adjust the start_time
-    static time_t last_time = 0;
-    if (now.tv_sec < last_time) {
+    uint64_t now = FbTime::mono();
 
-        time_t delta = last_time - now.tv_sec;
+    // every timer that is due fires at most once per call, even if it
+    // restarts itself with a zero timeout
+    size_t pending = m_timerlist.size();
 
-        for (it = m_timerlist.begin(); it != m_timerlist.end(); it++) {
-            (*it)->m_start.tv_sec -= delta;
-        }
-    }
-    last_time = now.tv_sec;
+    while (!m_timerlist.empty() && pending-- > 0) {
 
+        Timer *t = *m_timerlist.begin();
 
-    //must check end ...the timer might remove
-    //it self from the list (should be fixed in the future)
-    for(it = m_timerlist.begin(); it != m_timerlist.end(); ) {
-        //This is to make sure we don't get an invalid iterator
-        //when we do fireTimeout
-        Timer &t = *(*it);
+        if (now < t->m_end)
+            break;
 
-        t.makeEndTime(tm);
+        // take it out of the set before the handler runs, so the handler
+        // may freely stop() or start() this or any other timer
+        m_timerlist.erase(m_timerlist.begin());
 
-        if (((now.tv_sec < tm.tv_sec) ||
-             (now.tv_sec == tm.tv_sec && now.tv_usec < tm.tv_usec)))
-            break;
+        {
+            Watchdog::Guard guard("timer");
+            t->fireTimeout();
+        }
 
-        t.fireTimeout();
-        // restart the current timer so that the start time is updated
-        if (! t.doOnce()) {
-            // must erase so that it's put into the right place in the list
-            it = m_timerlist.erase(it);
-            t.m_timing = false;
-            t.start();
-        } else {
-            // Since the default stop behaviour results in the timer
-            // being removed, we must remove it here, so that the iterator
-            // lives well. Another option would be to add it to another
-            // list, and then just go through that list and stop them all.
-            it = m_timerlist.erase(it);
-            t.stop();
+        // the handler did neither stop() nor restart the timer
+        if (t->m_timing && m_timerlist.find(t) == m_timerlist.end()) {
+            if (t->doOnce())
+                t->m_timing = false;
+            else
+                t->start(); // restart, so that the start time is updated
         }
     }
 
 }
 
+bool Timer::TimerCompare::operator()(const Timer *a, const Timer *b) const {
+    if (a->m_end != b->m_end)
+        return a->m_end < b->m_end;
+    return a < b;
+}
+
 void Timer::addTimer(Timer *timer) {
     assert(timer);
     int interval = timer->getInterval();
     // interval timers have their timeout change every time they are started!
-    timeval tm;
+    // they trigger at the next multiple of 'interval' seconds of the wall clock
     if (interval != 0) {
-        tm.tv_sec = timer->getStartTime().tv_sec;
-        tm.tv_usec = timer->getStartTime().tv_usec;
-
-        // now convert to interval
-        tm.tv_sec = interval - (tm.tv_sec % interval) - 1;
-        tm.tv_usec = 1000000 - tm.tv_usec;
-        if (tm.tv_usec == 1000000) {
-            tm.tv_usec = 0;
-            tm.tv_sec += 1;
-        }
-        timer->setTimeout(tm);
+        uint64_t i = interval * FbTime::IN_SECONDS;
+        timer->m_timeout = i - (FbTime::system() % i);
     }
 
-    // set timeval to the time-of-trigger
-    timer->makeEndTime(tm);
-
-    // timer list is sorted by trigger time (i.e. start plus timeout)
-    TimerList::iterator it = m_timerlist.begin();
-    TimerList::iterator it_end = m_timerlist.end();
-    for (; it != it_end; ++it) {
-        timeval trig;
-        (*it)->makeEndTime(trig);
-
-        if ((trig.tv_sec > tm.tv_sec) ||
-            (trig.tv_sec == tm.tv_sec &&
-             trig.tv_usec >= tm.tv_usec)) {
-            break;
-        }
-    }
-    m_timerlist.insert(it, timer); 
+    // the monotonic time-of-trigger
+    timer->m_end = timer->m_start + timer->m_timeout;
 
+    // timer set is sorted by trigger time (i.e. start plus timeout)
+    m_timerlist.insert(timer);
 }
 
 Command<void> *DelayedCmd::parse(const std::string &command,
@@ -309,7 +330,7 @@ void DelayedCmd::execute() {
 
 void Timer::removeTimer(Timer *timer) {
     assert(timer);
-    m_timerlist.remove(timer);
+    m_timerlist.erase(timer);
 }
 	
 } // end namespace FbTk
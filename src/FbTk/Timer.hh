@@ -27,13 +27,14 @@
 
 #include "RefCount.hh"
 #include "Command.hh"
+#include "FbTime.hh"
 
 #ifdef HAVE_CTIME
   #include <ctime>
 #else
   #include <time.h>
 #endif
-#include <list>
+#include <set>
 #include <string>
 
 #ifdef HAVE_CONFIG_H
@@ -74,17 +75,23 @@ public:
     void start();
     /// stop timing
     void stop();
-    /// update all timers
+    /// sleep until the next timer is due or any descriptor watched by the
+    /// Reactor (including file_descriptor) is ready, then fire due timers
     static void updateTimers(int file_descriptor);
+    /// @return number of running timers
+    static size_t armed() { return m_timerlist.size(); }
 
     int isTiming() const { return m_timing; }
     int getInterval() const { return m_interval; }
 
     int doOnce() const { return m_once; }
 
-    const timeval &getTimeout() const { return m_timeout; }
-    const timeval &getStartTime() const { return m_start; }
-    void makeEndTime(timeval &tm) const;
+    /// @return timeout in micro-seconds
+    uint64_t getTimeout() const { return m_timeout; }
+    /// @return monotonic start time, see FbTime::mono()
+    uint64_t getStartTime() const { return m_start; }
+    /// @return monotonic time of trigger, only valid while the timer is running
+    uint64_t getEndTime() const { return m_end; }
 
 protected:
     /// force a timeout
@@ -96,8 +103,13 @@ private:
     /// remove a timer from the static list
     static void removeTimer(Timer *timer);
 
-    typedef std::list<Timer *> TimerList;
-    static TimerList m_timerlist; ///< list of all timers, sorted by next trigger time (start + timeout)
+    /// orders timers by their trigger time, ties are broken by address
+    struct TimerCompare {
+        bool operator()(const Timer *a, const Timer *b) const;
+    };
+
+    typedef std::set<Timer *, TimerCompare> TimerList;
+    static TimerList m_timerlist; ///< set of all running timers, sorted by next trigger time (start + timeout)
 
     RefCount<Slot<void> > m_handler; ///< what to do on a timeout
 
@@ -106,8 +118,9 @@ private:
     int m_interval; ///< Is an interval-only timer (e.g. clock)
     // note that intervals only take note of the seconds, not microseconds
 
-    timeval m_start;    ///< start time
-    timeval m_timeout; ///< time length
+    uint64_t m_start;   ///< start time, monotonic micro-seconds
+    uint64_t m_timeout; ///< time length in micro-seconds
+    uint64_t m_end;     ///< trigger time, fixed while the timer is in m_timerlist
 };
 
 /// executes a command after a specified timeout
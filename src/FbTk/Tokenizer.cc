@@ -0,0 +1,123 @@
+// Tokenizer.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "Tokenizer.hh"
+
+#include "FileUtil.hh"
+
+#ifdef HAVE_CSTRING
+  #include <cstring>
+#else
+  #include <string.h>
+#endif
+
+namespace FbTk {
+
+Tokenizer::Tokenizer(const char *data, size_t size):
+    m_pos(data), m_end(data + size), m_row(0), m_eof(false) {
+}
+
+Tokenizer::Tokenizer(const MappedFile &file):
+    m_pos(file.data()), m_end(file.data() + file.size()),
+    m_row(0), m_eof(false) {
+}
+
+bool Tokenizer::nextLine() {
+    if (m_eof)
+        return false;
+    if (m_pos == m_end) {
+        m_eof = true;
+        m_line = Range(m_end, m_end);
+        return false;
+    }
+
+    const char *eol = static_cast<const char *>(memchr(m_pos, '\n', m_end - m_pos));
+    if (eol == 0) {
+        m_line = Range(m_pos, m_end);
+        m_pos = m_end;
+        m_eof = true;
+    } else {
+        m_line = Range(m_pos, eol);
+        m_pos = eol + 1;
+    }
+    ++m_row;
+    return true;
+}
+
+Tokenizer::Range Tokenizer::strip(Range range) {
+    while (range.begin != range.end &&
+           (*range.begin == ' ' || *range.begin == '\t' || *range.begin == '\r'))
+        ++range.begin;
+    while (range.end != range.begin &&
+           (range.end[-1] == ' ' || range.end[-1] == '\t' || range.end[-1] == '\r'))
+        --range.end;
+    return range;
+}
+
+const char *Tokenizer::between(const Range &range, char first, char last,
+                               std::string &out, const char *ok_chars,
+                               bool allow_nesting) {
+    const char *start = range.begin;
+    while (start != range.end && strchr(ok_chars, *start) != 0 && *start != 0)
+        ++start;
+    if (start == range.end || *start != first)
+        return 0;
+
+    // the escaping backslashes removed so far, getStringBetween() counts
+    // its positions without them
+    size_t removed = 0;
+    std::string token;
+    const char *copied = start + 1; ///< what's before is in 'token'
+    const char *end = start;
+    int nesting = 0;
+    while (true) {
+        const char *open = static_cast<const char *>(
+            memchr(end + 1, first, range.end - end - 1));
+        end = static_cast<const char *>(memchr(end + 1, last, range.end - end - 1));
+        if (end == 0)
+            return 0;
+
+        if (allow_nesting && open != 0 && open < end && open[-1] != '\\') {
+            nesting++;
+            end = open;
+            continue;
+        }
+        size_t pos = end - range.begin - removed;
+        if (pos > 1 && end[-1] != '\\') {
+            if (allow_nesting && nesting > 0)
+                nesting--;
+            else
+                break;
+        } else if (pos > 1 && !allow_nesting) {
+            // drop the backslash, keep 'last'
+            token.append(copied, end - 1);
+            copied = end;
+            removed++;
+        }
+    }
+
+    token.append(copied, end);
+    out.swap(token);
+    return end + 1;
+}
+
+} // end namespace FbTk
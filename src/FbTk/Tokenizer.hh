@@ -0,0 +1,92 @@
+// Tokenizer.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#ifndef FBTK_TOKENIZER_HH
+#define FBTK_TOKENIZER_HH
+
+#include <string>
+
+namespace FbTk {
+
+class MappedFile;
+
+/**
+   Reads a text line by line without copying it, like a MappedFile or the
+   output of a command. Lines and tokens are ranges of the text, so the
+   text has to outlive them; only what is handed out as a string is
+   copied.
+ */
+class Tokenizer {
+public:
+    /// a part of the text, not 0-terminated
+    struct Range {
+        Range(): begin(0), end(0) { }
+        Range(const char *b, const char *e): begin(b), end(e) { }
+
+        bool empty() const { return begin == end; }
+        size_t size() const { return end - begin; }
+        std::string str() const { return std::string(begin, end); }
+        void assignTo(std::string &out) const { out.assign(begin, end); }
+
+        const char *begin, *end;
+    };
+
+    Tokenizer(const char *data, size_t size);
+    explicit Tokenizer(const MappedFile &file);
+
+    /// moves to the next line
+    /// @return false if there is none
+    bool nextLine();
+    /// @return the current line, without its newline
+    const Range &line() const { return m_line; }
+    /// @return number of the current line, from 1
+    int row() const { return m_row; }
+    /// @return column of 'pos' in the current line, from 1
+    int column(const char *pos) const { return pos - m_line.begin + 1; }
+    /// @return true once a line ended at the end of the text, like an
+    ///         istream after getline()
+    bool eof() const { return m_eof; }
+
+    /// @return 'range' without leading and trailing whitespace
+    static Range strip(Range range);
+
+    /**
+       Reads the text between 'first' and 'last' at the start of 'range',
+       like StringUtil::getStringBetween(): leading 'ok_chars' are skipped
+       and a 'last' after a backslash doesn't end the text, it's copied
+       without the backslash.
+       @return the position after 'last', 0 if there is no such text
+    */
+    static const char *between(const Range &range, char first, char last,
+                               std::string &out, const char *ok_chars = " \t\n",
+                               bool allow_nesting = false);
+
+private:
+    const char *m_pos, *m_end;
+    Range m_line;
+    int m_row;
+    bool m_eof;
+};
+
+} // end namespace FbTk
+
+#endif // FBTK_TOKENIZER_HH
@@ -0,0 +1,121 @@
+// Tracer.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#include "Tracer.hh"
+#include "FbTime.hh"
+
+#include <iostream>
+#include <unistd.h>
+
+namespace FbTk {
+
+namespace {
+
+/// writes 'str' as a JSON string, our names need no escapes but the
+/// class names of the handlers might
+void writeString(std::ostream &os, const char *str) {
+    os<<'"';
+    for (; *str; ++str) {
+        if (*str == '"' || *str == '\\')
+            os<<'\\';
+        if (static_cast<unsigned char>(*str) >= 0x20)
+            os<<*str;
+    }
+    os<<'"';
+}
+
+} // anonymous namespace
+
+Tracer::Span::Span(const char *category, const char *name,
+                   const char *arg_name, unsigned long arg):
+    m_category(category), m_name(name), m_arg_name(arg_name), m_arg(arg),
+    m_start(0) {
+    if (Tracer::instance().enabled())
+        m_start = FbTime::mono();
+}
+
+Tracer::Span::~Span() {
+    // recording might have started or stopped within the span
+    Tracer &tracer = Tracer::instance();
+    if (m_start == 0 || !tracer.enabled())
+        return;
+
+    Record record;
+    record.category = m_category;
+    record.name = m_name;
+    record.arg_name = m_arg_name;
+    record.arg = m_arg;
+    record.start = m_start;
+    record.duration = FbTime::mono() - m_start;
+    tracer.add(record);
+}
+
+Tracer &Tracer::instance() {
+    static Tracer s_tracer;
+    return s_tracer;
+}
+
+void Tracer::start(size_t capacity) {
+    if (capacity == 0)
+        capacity = 1;
+    m_spans.clear();
+    m_spans.resize(capacity);
+    m_next = 0;
+    m_wrapped = false;
+    m_enabled = true;
+}
+
+void Tracer::add(const Record &record) {
+    if (m_spans.empty())
+        return;
+    m_spans[m_next] = record;
+    if (++m_next == m_spans.size()) {
+        m_next = 0;
+        m_wrapped = true;
+    }
+}
+
+void Tracer::write(std::ostream &os) const {
+    const int pid = getpid();
+    os<<"{\"traceEvents\":[";
+    const size_t count = size();
+    // the oldest span is the next one to be overwritten
+    size_t index = m_wrapped ? m_next : 0;
+    for (size_t i = 0; i < count; ++i, index = (index + 1) % m_spans.size()) {
+        const Record &record = m_spans[index];
+        os<<(i ? ",\n" : "\n")<<"{\"name\":";
+        writeString(os, record.name);
+        os<<",\"cat\":";
+        writeString(os, record.category);
+        os<<",\"ph\":\"X\",\"ts\":"<<record.start
+          <<",\"dur\":"<<record.duration
+          <<",\"pid\":"<<pid<<",\"tid\":"<<pid;
+        if (record.arg_name) {
+            os<<",\"args\":{";
+            writeString(os, record.arg_name);
+            os<<':'<<record.arg<<'}';
+        }
+        os<<'}';
+    }
+    os<<"\n],\"displayTimeUnit\":\"ms\"}"<<std::endl;
+}
+
+} // end namespace FbTk
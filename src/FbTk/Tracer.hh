@@ -0,0 +1,96 @@
+// Tracer.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#ifndef FBTK_TRACER_HH
+#define FBTK_TRACER_HH
+
+#include "NotCopyable.hh"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#ifdef HAVE_INTTYPES_H
+#include <inttypes.h>
+#else
+#include <stdint.h>
+#endif // HAVE_INTTYPES_H
+
+#include <iosfwd>
+#include <vector>
+
+namespace FbTk {
+
+/**
+   Records spans of work, like handling an event or rendering a texture,
+   into a ring buffer and writes them as trace-event JSON, which
+   chrome://tracing and Perfetto show as a timeline. Recording is off
+   by default, so a span costs a single check.
+ */
+class Tracer: private NotCopyable {
+public:
+    /// records the time from its construction to its destruction
+    class Span: private NotCopyable {
+    public:
+        /// the strings must outlive the tracer, e.g. literals
+        Span(const char *category, const char *name,
+             const char *arg_name = 0, unsigned long arg = 0);
+        ~Span();
+    private:
+        const char *m_category, *m_name, *m_arg_name;
+        unsigned long m_arg;
+        uint64_t m_start; ///< 0 if we aren't recording
+    };
+
+    static Tracer &instance();
+
+    /// starts recording, the oldest spans make room once 'capacity' are recorded
+    void start(size_t capacity);
+    /// stops recording, the spans stay until the next start()
+    void stop() { m_enabled = false; }
+    bool enabled() const { return m_enabled; }
+
+    /// @return number of recorded spans
+    size_t size() const { return m_wrapped ? m_spans.size() : m_next; }
+
+    /// writes the recorded spans, oldest first
+    void write(std::ostream &os) const;
+
+private:
+    Tracer(): m_enabled(false), m_next(0), m_wrapped(false) { }
+
+    struct Record {
+        const char *category, *name, *arg_name;
+        unsigned long arg;
+        uint64_t start, duration;
+    };
+
+    void add(const Record &record);
+
+    bool m_enabled;
+    std::vector<Record> m_spans;
+    size_t m_next; ///< where the next span goes
+    bool m_wrapped; ///< if older spans were overwritten
+};
+
+} // end namespace FbTk
+
+#endif // FBTK_TRACER_HH
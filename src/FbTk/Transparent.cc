@@ -22,6 +22,7 @@
 #include "Transparent.hh"
 #include "App.hh"
 #include "I18n.hh"
+#include "MemoryAccount.hh"
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -32,6 +33,8 @@
 #endif // HAVE_XRENDER
 
 #include <iostream>
+#include <map>
+#include <set>
 #include <stdio.h>
 
 
@@ -63,7 +66,7 @@ Picture createAlphaPic(Window drawable, int alpha) {
     }
 
     // create one pixel pixmap with depth 8 for alpha
-    Pixmap alpha_pm = XCreatePixmap(disp, drawable,
+    Pixmap alpha_pm = FbTk::MemoryAccount::createPixmap(disp, drawable,
                                     1, 1, 8);
     if (alpha_pm == 0) {
         cerr<<"FbTk::Transparent: "<<_FBTK_CONSOLETEXT(Error, NoRenderPixmap,
@@ -78,12 +81,13 @@ Picture createAlphaPic(Window drawable, int alpha) {
     Picture alpha_pic = XRenderCreatePicture(disp, alpha_pm,
                                              format, CPRepeat, &attr);
     if (alpha_pic == 0) {
-        XFreePixmap(disp, alpha_pm);
+        FbTk::MemoryAccount::freePixmap(disp, alpha_pm);
         cerr<<"FbTk::Transparent: "<<_FBTK_CONSOLETEXT(Error, NoRenderPicture,
                                                        "Warning: Failed to create alpha picture.",
                                                        "XRenderCreatePicture failed")<<endl;
         return 0;
     }
+    FbTk::MemoryAccount::created(FbTk::MemoryAccount::PICTURES);
 
     // finaly set alpha and fill with it
     XRenderColor color;
@@ -98,11 +102,87 @@ Picture createAlphaPic(Window drawable, int alpha) {
     XRenderFillRectangle(disp, PictOpSrc, alpha_pic, &color,
                          0, 0, 1, 1);
 
-    XFreePixmap(disp, alpha_pm);
+    FbTk::MemoryAccount::freePixmap(disp, alpha_pm);
 
     return alpha_pic;
 }
+
+/// a Picture and the number of Transparents using it
+struct SharedPicture {
+    SharedPicture(): picture(0), users(0) { }
+    Picture picture;
+    unsigned int users;
+};
+
+typedef std::map<unsigned long, SharedPicture> SharedPictures;
+
+/// alpha masks by alphaKey(); there are at most 256 per screen
+SharedPictures s_alpha_pics;
+/// source and destination pictures by drawable; the root pixmap is the
+/// source of every pseudo transparent window
+SharedPictures s_drawable_pics;
+
+unsigned long alphaKey(int screen_num, int alpha) {
+    return screen_num * 256 + (alpha & 0xff);
+}
+
+Picture acquireAlphaPic(int screen_num, int alpha) {
+    SharedPicture &shared = s_alpha_pics[alphaKey(screen_num, alpha)];
+    if (shared.picture == 0) {
+        Display *disp = FbTk::App::instance()->display();
+        shared.picture = createAlphaPic(RootWindow(disp, screen_num), alpha);
+        if (shared.picture == 0) {
+            s_alpha_pics.erase(alphaKey(screen_num, alpha));
+            return 0;
+        }
+    }
+    ++shared.users;
+    return shared.picture;
+}
+
+Picture acquireDrawablePic(Drawable drawable, int screen_num) {
+    SharedPicture &shared = s_drawable_pics[drawable];
+    if (shared.picture == 0) {
+        Display *disp = FbTk::App::instance()->display();
+        XRenderPictFormat *format =
+            XRenderFindVisualFormat(disp, DefaultVisual(disp, screen_num));
+        if (format != 0)
+            shared.picture = XRenderCreatePicture(disp, drawable, format, 0, 0);
+        if (shared.picture != 0)
+            FbTk::MemoryAccount::created(FbTk::MemoryAccount::PICTURES);
+        else {
+            s_drawable_pics.erase(drawable);
+            if (format == 0) {
+                _FB_USES_NLS;
+                cerr<<"FbTk::Transparent: ";
+                fprintf(stderr,
+                        _FBTK_CONSOLETEXT(Error, NoRenderVisualFormat,
+                                          "Failed to find format for screen(%d)",
+                                          "XRenderFindVisualFormat failed... include %d for screen number").
+                        c_str(), screen_num);
+                cerr<<endl;
+            }
+            return 0;
+        }
+    }
+    ++shared.users;
+    return shared.picture;
+}
+
+void releasePic(SharedPictures &pics, unsigned long key) {
+    SharedPictures::iterator it = pics.find(key);
+    if (it == pics.end() || --it->second.users > 0)
+        return;
+    XRenderFreePicture(FbTk::App::instance()->display(), it->second.picture);
+    FbTk::MemoryAccount::destroyed(FbTk::MemoryAccount::PICTURES);
+    pics.erase(it);
+}
+
 #endif //  HAVE_XRENDER
+
+/// screens forced to pseudo transparency, whatever the display supports
+std::set<int> s_pseudo_screens;
+
 }
 
 namespace FbTk {
@@ -139,6 +219,17 @@ void Transparent::usePseudoTransparent(bool force) {
     s_use_composite = (!force && s_composite);
 }
 
+void Transparent::usePseudoTransparent(int screen_num, bool force) {
+    if (force)
+        s_pseudo_screens.insert(screen_num);
+    else
+        s_pseudo_screens.erase(screen_num);
+}
+
+bool Transparent::useComposite(int screen_num) {
+    return haveComposite() && s_pseudo_screens.count(screen_num) == 0;
+}
+
 bool Transparent::haveComposite(bool for_real) {
     if (!s_init)
         init();
@@ -151,9 +242,7 @@ bool Transparent::haveComposite(bool for_real) {
 
 Transparent::Transparent(Drawable src, Drawable dest, int alpha, int screen_num):
     m_alpha_pic(0), m_src_pic(0), m_dest_pic(0),
-    m_source(src), m_dest(dest), m_alpha(alpha) {
-
-    Display *disp = FbTk::App::instance()->display();
+    m_source(src), m_dest(dest), m_alpha(alpha), m_screen_num(screen_num) {
 
     // check for Extension support
     if (!s_init)
@@ -165,19 +254,11 @@ Transparent::Transparent(Drawable src, Drawable dest, int alpha, int screen_num)
 
     allocAlpha(m_alpha);
 
-    XRenderPictFormat *format =
-        XRenderFindVisualFormat(disp,
-                                DefaultVisual(disp, screen_num));
+    if (src != 0)
+        m_src_pic = acquireDrawablePic(src, screen_num);
 
-    if (src != 0 && format != 0) {
-        m_src_pic = XRenderCreatePicture(disp, src, format,
-                                         0, 0);
-    }
-
-    if (dest != 0 && format != 0) {
-        m_dest_pic = XRenderCreatePicture(disp, dest, format,
-                                          0, 0);
-    }
+    if (dest != 0)
+        m_dest_pic = acquireDrawablePic(dest, screen_num);
 #endif // HAVE_XRENDER
 }
 
@@ -186,13 +267,11 @@ Transparent::~Transparent() {
     if (m_alpha_pic != 0 && s_render)
         freeAlpha();
 
-    Display *disp = FbTk::App::instance()->display();
-
     if (m_dest_pic != 0 && s_render)
-        XRenderFreePicture(disp, m_dest_pic);
+        releasePic(s_drawable_pics, m_dest);
 
     if (m_src_pic != 0  && s_render)
-        XRenderFreePicture(disp, m_src_pic);
+        releasePic(s_drawable_pics, m_source);
 #endif // HAVE_XRENDER
 }
 
@@ -207,8 +286,7 @@ void Transparent::setAlpha(int alpha) {
 void Transparent::freeDest() {
 #ifdef HAVE_XRENDER
     if (m_dest_pic != 0) {
-        Display *disp = FbTk::App::instance()->display();
-        XRenderFreePicture(disp, m_dest_pic);
+        releasePic(s_drawable_pics, m_dest);
         m_dest_pic = 0;
     }
     m_dest = None;
@@ -220,30 +298,10 @@ void Transparent::setDest(Drawable dest, int screen_num) {
     if (m_dest == dest || !s_render)
         return;
 
-    Display *disp = FbTk::App::instance()->display();
-
     freeDest();
     // create new dest pic if we have a valid dest drawable
-    if (dest != 0) {
-
-        XRenderPictFormat *format =
-            XRenderFindVisualFormat(disp,
-                                    DefaultVisual(disp, screen_num));
-        if (format == 0) {
-            _FB_USES_NLS;
-            cerr<<"FbTk::Transparent: ";
-            fprintf(stderr,
-                    _FBTK_CONSOLETEXT(Error, NoRenderVisualFormat,
-                                      "Failed to find format for screen(%d)",
-                                      "XRenderFindVisualFormat failed... include %d for screen number").
-                    c_str(), screen_num);
-
-            cerr<<endl;
-        } else {
-            m_dest_pic = XRenderCreatePicture(disp, dest, format, 0, 0);
-        }
-
-    }
+    if (dest != 0)
+        m_dest_pic = acquireDrawablePic(dest, screen_num);
     m_dest = dest;
 #endif // HAVE_XRENDER
 }
@@ -252,44 +310,28 @@ void Transparent::setSource(Drawable source, int screen_num) {
 #ifdef HAVE_XRENDER
     if (m_source == source || !s_render)
         return;
-    // save old alpha value so we can recreate new later
-    // with the same value
-    int old_alpha = m_alpha;
-    if (m_alpha_pic != 0)
-        freeAlpha();
-
-    Display *disp = FbTk::App::instance()->display();
 
     if (m_src_pic != 0) {
-        XRenderFreePicture(disp, m_src_pic);
+        releasePic(s_drawable_pics, m_source);
         m_src_pic = 0;
     }
 
     m_source = source;
 
     // create new source pic if we have a valid source drawable
-    if (m_source != 0) {
-
-        XRenderPictFormat *format =
-            XRenderFindVisualFormat(disp,
-                                    DefaultVisual(disp, screen_num));
-        if (format == 0) {
-            _FB_USES_NLS;
-            cerr<<"FbTk::Transparent: ";
-            fprintf(stderr, _FBTK_CONSOLETEXT(Error, NoRenderVisualFormat,
-                                              "Failed to find format for screen(%d)",
-                                              "XRenderFindVisualFormat failed... include %d for screen number").
-                    c_str(), screen_num);
-            cerr<<endl;
-        } else {
-            m_src_pic = XRenderCreatePicture(disp, m_source, format,
-                                             0, 0);
-        }
+    if (m_source != 0)
+        m_src_pic = acquireDrawablePic(m_source, screen_num);
+
+    // the alpha mask belongs to the screen, and there is none without a
+    // source; save the old alpha value so we can recreate it
+    if (m_alpha_pic == 0 || screen_num != m_screen_num) {
+        int old_alpha = m_alpha;
+        if (m_alpha_pic != 0)
+            freeAlpha();
+        m_screen_num = screen_num;
+        allocAlpha(old_alpha);
     }
 
-    // recreate new alpha
-    allocAlpha(old_alpha);
-
 #endif // HAVE_XRENDER
 }
 
@@ -321,7 +363,7 @@ void Transparent::allocAlpha(int alpha) {
     if (m_alpha_pic != 0)
         freeAlpha();
 
-    m_alpha_pic = createAlphaPic(m_source, alpha);
+    m_alpha_pic = acquireAlphaPic(m_screen_num, alpha);
     m_alpha = alpha;
 #endif // HAVE_XRENDER
 }
@@ -329,7 +371,7 @@ void Transparent::allocAlpha(int alpha) {
 void Transparent::freeAlpha() {
 #ifdef HAVE_XRENDER
     if (s_render && m_alpha_pic != 0)
-        XRenderFreePicture(FbTk::App::instance()->display(), m_alpha_pic);
+        releasePic(s_alpha_pics, alphaKey(m_screen_num, m_alpha));
 #endif // HAVE_XRENDER
     m_alpha_pic = 0;
     m_alpha = 255;
@@ -26,7 +26,11 @@
 
 namespace FbTk {
 
-/// renders to drawable together with an alpha mask
+/**
+ * renders to drawable together with an alpha mask
+ * The pictures are shared between all instances: alpha masks by screen
+ * and alpha value, the others by drawable, each freed with its last user.
+ */
 class Transparent {
 public:
     Transparent(Drawable source, Drawable dest, int alpha, int screen_num);
@@ -52,6 +56,12 @@ public:
     static bool haveComposite(bool for_real = false);
     static bool haveRender() { if (!s_init) init(); return s_render; }
     static void usePseudoTransparent(bool force);
+    /// forces pseudo transparency on one screen only, e.g. one whose
+    /// compositing is too slow
+    static void usePseudoTransparent(int screen_num, bool force);
+    /// @return true if translucency on the screen is left to a
+    ///         compositing manager, which then blends with the opacity
+    static bool useComposite(int screen_num);
 
 private:
     void freeAlpha();
@@ -61,6 +71,7 @@ private:
     unsigned long m_dest_pic;
     Drawable m_source, m_dest;
     unsigned char m_alpha;
+    int m_screen_num; ///< of the alpha mask
     
     static bool s_init;
     static bool s_render; ///< wheter we have RENDER support
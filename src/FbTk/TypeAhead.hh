@@ -23,151 +23,275 @@
 #define FBTK_TYPEAHEAD_HH
 
 #include "ITypeAheadable.hh"
-#include "SearchResult.hh"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
 
 namespace FbTk {
 
+/**
+   Narrows a list of ITypeAheadables down to those matching the typed text,
+   ignoring case and disabled items.
+
+   The strings are indexed when the first character is typed after the
+   items changed: sorted, so the items starting with the text are a range
+   found by binary search, or, to find the text anywhere, by the items each
+   character and pair of characters occurs in. Every character then only
+   looks at the items that matched the text before it.
+ */
 template <typename Items, typename Item_Type>
 class TypeAhead {
-#if 0
-
-// a class template can't be split into separate interface + implementation files, an interface summary is given here:
-
-public:
-    void init(Items const &items);
-
-// accessors:
-    int stringSize() const { return m_searchstr.size(); }
-    Items matched() const;
-
-// modifiers:
-    Items putCharacter(char ch);
-    void putBackSpace();
-    void reset()
-
-private:
-    SearchResults m_search_results;
-    std::string m_searchstr;
-    Items const *m_ref;
-
-// helper
-    void fillValues(BaseItems const &search, ValueVec &fillin) const;
-
-// reverts to searchstate before current
-    void revert();
-
-// search performs iteration and sets state
-    void search(char char_to_test);
-    void doSearch(char to_test,
-            Items const &items,
-            SearchResult &mySearchResult) const;
-    void doSearch(char to_test,
-            BaseItems const &search,
-            SearchResult &mySearchResult) const;
-#endif
-
 public:
-    typedef std::vector < ITypeAheadable* > BaseItems;
-    typedef BaseItems::const_iterator BaseItemscIt;
-    typedef std::vector < SearchResult > SearchResults;
-    typedef typename Items::const_iterator ItemscIt;
-
-    void init(Items const &items) { m_ref = &items; }
+    TypeAhead(): m_ref(0), m_mode(TYPEAHEAD_PREFIX), m_dirty(true) { }
+
+    void init(Items const &items) { m_ref = &items; m_dirty = true; }
+    /// the items or their strings changed, the index is rebuilt when needed
+    void invalidate() { m_dirty = true; }
+
+    void setMode(TypeAheadMode mode) {
+        if (mode == m_mode)
+            return;
+        m_mode = mode;
+        m_dirty = true;
+        reset();
+    }
+    TypeAheadMode mode() const { return m_mode; }
 
     size_t stringSize() const { return m_searchstr.size(); }
 
+    /// completes the text as far as all matching items agree
     void seek() {
-        if (!m_search_results.empty())
-            m_searchstr = m_search_results.back().seekedString();
+        if (!m_states.empty())
+            m_searchstr = m_states.back().seeked;
     }
 
-    Items putCharacter(char ch) {
-        if (isprint(ch))
-            search(ch);
-        return matched();
+    /// @return false if no item matches the text with 'ch'
+    bool putCharacter(char ch) {
+        if (!isprint(ch))
+            return false;
+        update();
+        State state;
+        if (!find(m_searchstr + lower(ch), state))
+            return false;
+        m_searchstr = state.query;
+        m_states.push_back(state);
+        return true;
     }
 
     void putBackSpace() {
-        if (!m_search_results.empty())
-            revert();
+        if (m_states.empty())
+            return;
+        m_states.pop_back();
+        m_searchstr = m_states.empty() ? std::string() : m_states.back().query;
     }
 
     void reset() {
         m_searchstr.clear();
-        m_search_results.clear();
+        m_states.clear();
     }
 
-    Items matched() const {
-        Items last_matched;
-
-        if (!m_search_results.empty())
-            fillValues(m_search_results.back().result(), last_matched);
-        else
+    /// @return the matching items in their order, all if nothing was typed
+    Items matched() {
+        update();
+        if (m_states.empty())
             return *m_ref;
-        return last_matched;
+
+        const State &state = m_states.back();
+        Positions sorted;
+        const Positions *positions = &state.positions;
+        if (m_mode == TYPEAHEAD_PREFIX) {
+            for (size_t i = state.lo; i < state.hi; ++i) {
+                if (enabled(m_keys[i].pos))
+                    sorted.push_back(m_keys[i].pos);
+            }
+            std::sort(sorted.begin(), sorted.end());
+            positions = &sorted;
+        }
+
+        Items items;
+        items.reserve(positions->size());
+        for (size_t i = 0; i < positions->size(); ++i)
+            items.push_back((*m_ref)[(*positions)[i]]);
+        return items;
     }
 
-private:
-    SearchResults m_search_results;
-    std::string m_searchstr;
-    Items const *m_ref; // reference to vector we are operating on
+    /// @return where the typed text starts in the string of 'item'
+    size_t matchStart(const ITypeAheadable &item) const {
+        if (m_mode == TYPEAHEAD_PREFIX || m_searchstr.empty())
+            return 0;
+        size_t start = lower(item.iTypeString()).find(m_searchstr);
+        return start == std::string::npos ? 0 : start;
+    }
 
-    void fillValues(BaseItems const &search, Items &fillin) const {
-        for (BaseItemscIt it = search.begin(); it != search.end(); it++) {
-            Item_Type tmp = dynamic_cast<Item_Type>(*it);
-            if (tmp)
-                fillin.push_back(tmp);
+private:
+    typedef std::vector<size_t> Positions;
+
+    struct Key {
+        std::string text; ///< the string in lower case
+        size_t pos; ///< of the item in *m_ref
+    };
+    typedef std::vector<Key> Keys;
+
+    struct KeyLess {
+        bool operator()(const Key &a, const Key &b) const { return a.text < b.text; }
+    };
+
+    /// orders keys against the keys starting with 'prefix'
+    struct PrefixLess {
+        explicit PrefixLess(const std::string &prefix): m_prefix(prefix) { }
+        bool operator()(const Key &key, const std::string &) const {
+            return key.text.compare(0, m_prefix.size(), m_prefix) < 0;
+        }
+        bool operator()(const std::string &, const Key &key) const {
+            return key.text.compare(0, m_prefix.size(), m_prefix) > 0;
         }
+        const std::string &m_prefix;
+    };
+
+    struct State {
+        std::string query; ///< the text in lower case
+        std::string seeked; ///< what all matching items start with
+        size_t lo, hi; ///< prefix: the range of m_keys starting with query
+        Positions positions; ///< substring: the items containing query
+    };
+
+    static char lower(char ch) {
+        return tolower(static_cast<unsigned char>(ch));
     }
 
-    void revert() {
-        m_search_results.pop_back();
-        if (m_search_results.empty())
-            m_searchstr.clear();
-        else
-            m_searchstr = m_search_results.back().seekedString();
+    static std::string lower(const std::string &str) {
+        std::string result(str);
+        for (size_t i = 0; i < result.size(); ++i)
+            result[i] = lower(result[i]);
+        return result;
     }
 
-    void search(char char_to_test) {
-        SearchResult mySearchResult(m_searchstr + char_to_test);
-        size_t num_items = m_ref->size();
+    /// a character is a gram on its own, a pair is one above 255
+    static unsigned int gram(const std::string &str, size_t i, bool pair) {
+        unsigned int first = static_cast<unsigned char>(str[i]);
+        if (!pair)
+            return first;
+        return 0x100 + (first << 8) + static_cast<unsigned char>(str[i + 1]);
+    }
 
-        // check if we have already a searched set
-        if (m_search_results.empty())
-            doSearch(char_to_test, *m_ref, mySearchResult);
-        else {
-            num_items = m_search_results.back().size();
-            doSearch(char_to_test, m_search_results.back().result(),
-                     mySearchResult);
+    bool enabled(size_t pos) const {
+        return pos < m_ref->size() && (*m_ref)[pos]->isEnabled();
+    }
+
+    /// builds the index if needed and searches the typed text again
+    void update() {
+        if (!m_dirty)
+            return;
+        m_dirty = false;
+
+        m_keys.resize(m_ref->size());
+        for (size_t i = 0; i < m_keys.size(); ++i) {
+            m_keys[i].text = lower((*m_ref)[i]->iTypeString());
+            m_keys[i].pos = i;
         }
 
-        if (mySearchResult.size() > 0 ) {
-            if (mySearchResult.size() < num_items) {
-                mySearchResult.seek();
-                m_search_results.push_back(mySearchResult);
+        m_grams.clear();
+        if (m_mode == TYPEAHEAD_PREFIX)
+            std::sort(m_keys.begin(), m_keys.end(), KeyLess());
+        else {
+            std::vector<unsigned int> grams;
+            for (size_t i = 0; i < m_keys.size(); ++i) {
+                const std::string &text = m_keys[i].text;
+                grams.clear();
+                for (size_t j = 0; j < text.size(); ++j) {
+                    grams.push_back(gram(text, j, false));
+                    if (j + 1 < text.size())
+                        grams.push_back(gram(text, j, true));
+                }
+                std::sort(grams.begin(), grams.end());
+                grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+                for (size_t j = 0; j < grams.size(); ++j)
+                    m_grams[grams[j]].push_back(i);
             }
-            m_searchstr += char_to_test;
         }
-    }
 
-    // iteration based on original list of items
-    void doSearch(char to_test, Items const &items,
-                  SearchResult &mySearchResult) const {
-        for (ItemscIt it = items.begin(); it != items.end(); it++) {
-            if ((*it)->iTypeCompareChar(to_test, stringSize()) && (*it)->isEnabled())
-                mySearchResult.add(*it);
+        // the old states point into the old index
+        std::vector<State> states;
+        states.swap(m_states);
+        for (size_t i = 0; i < states.size(); ++i) {
+            State state;
+            if (!find(states[i].query, state))
+                break;
+            m_states.push_back(state);
         }
+        if (m_states.size() < states.size())
+            m_searchstr = m_states.empty() ? std::string() : m_states.back().query;
     }
 
-    // iteration based on last SearchResult
-    void doSearch(char to_test, BaseItems const &search,
-                  SearchResult &mySearchResult) const {
-        for (BaseItemscIt it = search.begin(); it != search.end(); it++) {
-            if ((*it)->iTypeCompareChar(to_test, stringSize()) && (*it)->isEnabled())
-                mySearchResult.add(*it);
+    /// narrows the last state down to 'query'
+    /// @return false if no enabled item matches
+    bool find(const std::string &query, State &state) const {
+        const State *last = m_states.empty() ? 0 : &m_states.back();
+        state.query = state.seeked = query;
+
+        if (m_mode == TYPEAHEAD_PREFIX) {
+            PrefixLess less(query);
+            typename Keys::const_iterator first = m_keys.begin() + (last ? last->lo : 0);
+            typename Keys::const_iterator end = m_keys.begin() + (last ? last->hi : m_keys.size());
+            first = std::lower_bound(first, end, query, less);
+            end = std::upper_bound(first, end, query, less);
+            state.lo = first - m_keys.begin();
+            state.hi = end - m_keys.begin();
+
+            // sorted, so the first and last enabled key have in common
+            // what all of them have in common
+            const Key *a = 0, *b = 0;
+            for (; first != end; ++first) {
+                if (enabled(first->pos)) {
+                    if (a == 0)
+                        a = &*first;
+                    b = &*first;
+                }
+            }
+            if (a == 0)
+                return false;
+            size_t common = query.size();
+            while (common < a->text.size() && common < b->text.size() &&
+                   a->text[common] == b->text[common])
+                ++common;
+            state.seeked = a->text.substr(0, common);
+            return true;
+        }
+
+        // the candidates are the items that matched before, or those with
+        // the rarest gram of the query
+        const Positions *candidates = last ? &last->positions : 0;
+        for (size_t i = 0; last == 0 && i < query.size(); ++i) {
+            for (int pair = 0; pair < 2 && (!pair || i + 1 < query.size()); ++pair) {
+                Grams::const_iterator it = m_grams.find(gram(query, i, pair));
+                if (it == m_grams.end())
+                    return false;
+                if (candidates == 0 || it->second.size() < candidates->size())
+                    candidates = &it->second;
+            }
+        }
+        if (candidates == 0)
+            return false;
+
+        for (size_t i = 0; i < candidates->size(); ++i) {
+            size_t pos = (*candidates)[i];
+            if (enabled(pos) && m_keys[pos].text.find(query) != std::string::npos)
+                state.positions.push_back(pos);
         }
+        return !state.positions.empty();
     }
 
+    typedef std::map<unsigned int, Positions> Grams;
+
+    Items const *m_ref; // reference to vector we are operating on
+    TypeAheadMode m_mode;
+    bool m_dirty; ///< the index has to be rebuilt
+    Keys m_keys; ///< sorted by text for prefixes, else by position
+    Grams m_grams; ///< for substrings, the items each gram occurs in
+    std::vector<State> m_states; ///< one for each typed character
+    std::string m_searchstr;
 }; // end Class TypeAhead
 
 } // end namespace FbTk
@@ -0,0 +1,164 @@
+// Watchdog.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#include "Watchdog.hh"
+#include "FbTime.hh"
+
+#ifdef HAVE_EXECINFO_H
+#include <execinfo.h>
+#endif // HAVE_EXECINFO_H
+
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sys/time.h>
+#include <unistd.h>
+
+using std::cerr;
+using std::endl;
+
+namespace {
+
+/// at most one report per this many microseconds
+const uint64_t REPORT_INTERVAL = 10 * FbTk::FbTime::IN_SECONDS;
+const int MAX_FRAMES = 32;
+
+/// what the alarm handler leaves for the guard
+volatile sig_atomic_t s_fired = 0;
+void *s_frames[MAX_FRAMES];
+volatile sig_atomic_t s_num_frames = 0;
+
+void alarmHandler(int) {
+    s_fired = 1;
+#ifdef HAVE_EXECINFO_H
+    s_num_frames = backtrace(s_frames, MAX_FRAMES);
+#endif // HAVE_EXECINFO_H
+}
+
+void setAlarm(unsigned int msec) {
+    itimerval value;
+    memset(&value, 0, sizeof(value));
+    value.it_value.tv_sec = msec / 1000;
+    value.it_value.tv_usec = (msec % 1000) * 1000;
+    setitimer(ITIMER_REAL, &value, 0);
+}
+
+/// guards running now, only the outermost one watches
+unsigned int s_depth = 0;
+
+} // anonymous namespace
+
+namespace FbTk {
+
+Watchdog::Guard::Guard(const char *what, unsigned long window):
+    m_what(what), m_window(window), m_counted(false), m_start(0) {
+    Watchdog &watchdog = Watchdog::instance();
+    if (watchdog.m_deadline == 0)
+        return;
+    m_counted = true;
+    if (s_depth++ > 0)
+        return;
+
+    s_fired = 0;
+    s_num_frames = 0;
+    m_start = FbTime::mono();
+    setAlarm(watchdog.m_deadline);
+}
+
+Watchdog::Guard::~Guard() {
+    if (!m_counted)
+        return;
+    --s_depth;
+    if (m_start == 0)
+        return;
+    setAlarm(0);
+    if (s_fired)
+        Watchdog::instance().report(m_what, m_window, FbTime::mono() - m_start);
+}
+
+Watchdog &Watchdog::instance() {
+    static Watchdog s_instance;
+    return s_instance;
+}
+
+void Watchdog::setDeadline(unsigned int msec) {
+    if (msec == m_deadline)
+        return;
+    m_deadline = msec;
+    if (msec == 0 || m_installed)
+        return;
+
+#ifdef HAVE_EXECINFO_H
+    // the first call loads what backtrace() needs, so that it doesn't
+    // allocate in the alarm handler
+    void *frame;
+    backtrace(&frame, 1);
+#endif // HAVE_EXECINFO_H
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = alarmHandler;
+    sigemptyset(&action.sa_mask);
+    // the handlers we interrupt wait on the X server, let them go on
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGALRM, &action, 0);
+    m_installed = true;
+}
+
+void Watchdog::report(const char *what, unsigned long window, uint64_t usec) {
+    uint64_t now = FbTime::mono();
+    if (m_last_report != 0 && now - m_last_report < REPORT_INTERVAL) {
+        ++m_suppressed;
+        return;
+    }
+    m_last_report = now;
+
+    cerr<<"fluxbox: watchdog: "<<what;
+    if (window != 0) {
+        cerr<<" for 0x"<<std::hex<<window<<std::dec;
+        if (m_describe) {
+            std::string description = m_describe(window);
+            if (!description.empty())
+                cerr<<" ("<<description<<")";
+        }
+    }
+    cerr<<" took "<<usec / 1000<<" ms, the deadline is "<<m_deadline<<" ms";
+    if (m_suppressed > 0)
+        cerr<<", "<<m_suppressed<<" more stalls since the last report";
+    cerr<<endl;
+    m_suppressed = 0;
+
+#ifdef HAVE_EXECINFO_H
+    if (s_num_frames > 0) {
+        cerr<<"fluxbox: watchdog: where it was at the deadline:"<<endl;
+        // skip the frames of the alarm handler
+        char **symbols = backtrace_symbols(s_frames, s_num_frames);
+        if (symbols) {
+            for (int i = 2; i < s_num_frames; ++i)
+                cerr<<"  "<<symbols[i]<<endl;
+            free(symbols);
+        }
+    }
+#endif // HAVE_EXECINFO_H
+}
+
+} // end namespace FbTk
@@ -0,0 +1,90 @@
+// Watchdog.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#ifndef FBTK_WATCHDOG_HH
+#define FBTK_WATCHDOG_HH
+
+#include "NotCopyable.hh"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#ifdef HAVE_INTTYPES_H
+#include <inttypes.h>
+#else
+#include <stdint.h>
+#endif // HAVE_INTTYPES_H
+
+#include <string>
+
+namespace FbTk {
+
+/**
+   Catches handlers that stall the event loop: a guard around handling an
+   event or firing a timer arms an alarm with the deadline, and if it goes
+   off before the guard ends, the alarm records where the main thread is.
+   The guard then logs what it was doing, how long it took and that
+   backtrace, at most once per ten seconds. Off by default, so a guard
+   costs a single check; while on, it costs two setitimer calls.
+ */
+class Watchdog: private NotCopyable {
+public:
+    /// @return a description of 'window' for the log, e.g. its class and title
+    typedef std::string (*Describe)(unsigned long window);
+
+    /// watches from its construction to its destruction, not nested guards
+    class Guard: private NotCopyable {
+    public:
+        /// 'what' must outlive the guard, e.g. a literal
+        explicit Guard(const char *what, unsigned long window = 0);
+        ~Guard();
+    private:
+        const char *m_what;
+        unsigned long m_window;
+        bool m_counted; ///< if the watchdog was on when it started
+        uint64_t m_start; ///< 0 unless it is the outermost guard
+    };
+
+    static Watchdog &instance();
+
+    /// @param msec how long a handler may take, 0 turns the watchdog off
+    void setDeadline(unsigned int msec);
+    unsigned int deadline() const { return m_deadline; }
+
+    void setDescribe(Describe describe) { m_describe = describe; }
+
+private:
+    Watchdog(): m_deadline(0), m_installed(false), m_describe(0),
+                m_last_report(0), m_suppressed(0) { }
+
+    void report(const char *what, unsigned long window, uint64_t usec);
+
+    unsigned int m_deadline;
+    bool m_installed; ///< if the alarm handler is installed
+    Describe m_describe;
+    uint64_t m_last_report;
+    unsigned long m_suppressed; ///< stalls not logged since the last report
+};
+
+} // end namespace FbTk
+
+#endif // FBTK_WATCHDOG_HH
@@ -0,0 +1,166 @@
+// WorkerPool.cc for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "WorkerPool.hh"
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif // HAVE_UNISTD_H
+
+namespace FbTk {
+
+namespace {
+
+/// more threads don't help with the small pixmaps of a window manager
+const unsigned int MAX_HELPERS = 7;
+
+} // anonymous namespace
+
+WorkerPool &WorkerPool::instance() {
+    static WorkerPool s_pool;
+    return s_pool;
+}
+
+WorkerPool::WorkerPool():
+    m_job(0),
+    m_parts(0),
+    m_next(0),
+    m_done(0),
+    m_generation(0),
+    m_shutdown(false) {
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_init(&m_mutex, 0);
+    pthread_cond_init(&m_job_cond, 0);
+    pthread_cond_init(&m_done_cond, 0);
+
+    long cpus = 1;
+#ifdef _SC_NPROCESSORS_ONLN
+    cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif // _SC_NPROCESSORS_ONLN
+    unsigned int helpers = cpus > 1 ? cpus - 1 : 0;
+    if (helpers > MAX_HELPERS)
+        helpers = MAX_HELPERS;
+
+    for (unsigned int i = 0; i < helpers; ++i) {
+        pthread_t thread;
+        if (pthread_create(&thread, 0, threadMain, this) != 0)
+            break;
+        m_threads.push_back(thread);
+    }
+#endif // HAVE_PTHREAD
+}
+
+WorkerPool::~WorkerPool() {
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&m_mutex);
+    m_shutdown = true;
+    pthread_cond_broadcast(&m_job_cond);
+    pthread_mutex_unlock(&m_mutex);
+
+    for (size_t i = 0; i < m_threads.size(); ++i)
+        pthread_join(m_threads[i], 0);
+
+    pthread_cond_destroy(&m_done_cond);
+    pthread_cond_destroy(&m_job_cond);
+    pthread_mutex_destroy(&m_mutex);
+#endif // HAVE_PTHREAD
+}
+
+unsigned int WorkerPool::threads() const {
+#ifdef HAVE_PTHREAD
+    return m_threads.size() + 1;
+#else
+    return 1;
+#endif // HAVE_PTHREAD
+}
+
+void WorkerPool::run(Job &job, unsigned int parts) {
+#ifdef HAVE_PTHREAD
+    if (!m_threads.empty() && parts > 1) {
+        pthread_mutex_lock(&m_mutex);
+        m_job = &job;
+        m_parts = parts;
+        m_next = 0;
+        m_done = 0;
+        ++m_generation;
+        pthread_cond_broadcast(&m_job_cond);
+        pthread_mutex_unlock(&m_mutex);
+
+        work();
+
+        pthread_mutex_lock(&m_mutex);
+        while (m_done < m_parts)
+            pthread_cond_wait(&m_done_cond, &m_mutex);
+        m_job = 0;
+        pthread_mutex_unlock(&m_mutex);
+        return;
+    }
+#endif // HAVE_PTHREAD
+
+    for (unsigned int part = 0; part < parts; ++part)
+        job.run(part, parts);
+}
+
+#ifdef HAVE_PTHREAD
+
+void *WorkerPool::threadMain(void *data) {
+    WorkerPool *pool = static_cast<WorkerPool *>(data);
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool->m_mutex);
+    while (true) {
+        while (!pool->m_shutdown && pool->m_generation == seen)
+            pthread_cond_wait(&pool->m_job_cond, &pool->m_mutex);
+        if (pool->m_shutdown)
+            break;
+        seen = pool->m_generation;
+
+        pthread_mutex_unlock(&pool->m_mutex);
+        pool->work();
+        pthread_mutex_lock(&pool->m_mutex);
+    }
+    pthread_mutex_unlock(&pool->m_mutex);
+
+    return 0;
+}
+
+void WorkerPool::work() {
+    pthread_mutex_lock(&m_mutex);
+    while (m_job != 0 && m_next < m_parts) {
+        Job *job = m_job;
+        unsigned int part = m_next++;
+        unsigned int parts = m_parts;
+        pthread_mutex_unlock(&m_mutex);
+
+        job->run(part, parts);
+
+        pthread_mutex_lock(&m_mutex);
+        if (++m_done == m_parts)
+            pthread_cond_signal(&m_done_cond);
+    }
+    pthread_mutex_unlock(&m_mutex);
+}
+
+#endif // HAVE_PTHREAD
+
+} // end namespace FbTk
@@ -0,0 +1,89 @@
+// WorkerPool.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#ifndef FBTK_WORKERPOOL_HH
+#define FBTK_WORKERPOOL_HH
+
+#include "NotCopyable.hh"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <vector>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif // HAVE_PTHREAD
+
+namespace FbTk {
+
+/**
+   A few threads that help the main thread with cpu bound work on client
+   side buffers, like rendering textures. Jobs must not call Xlib or touch
+   anything but their own data. Without pthreads all parts run in the
+   calling thread.
+ */
+class WorkerPool: private NotCopyable {
+public:
+    /// work that can be split into independent parts
+    class Job {
+    public:
+        virtual ~Job() { }
+        /// does part number 'part' of 'parts', parts run concurrently
+        virtual void run(unsigned int part, unsigned int parts) = 0;
+    };
+
+    static WorkerPool &instance();
+
+    /// @return number of threads that work on a job, including the caller
+    unsigned int threads() const;
+
+    /// runs all parts of job and returns when they are done
+    void run(Job &job, unsigned int parts);
+
+private:
+    WorkerPool();
+    ~WorkerPool();
+
+#ifdef HAVE_PTHREAD
+    static void *threadMain(void *pool);
+    /// runs parts of the current job until there are none left
+    void work();
+
+    pthread_mutex_t m_mutex;
+    pthread_cond_t m_job_cond; ///< signaled when a job starts or on shutdown
+    pthread_cond_t m_done_cond; ///< signaled when the last part is done
+    std::vector<pthread_t> m_threads; ///< the helpers
+#endif // HAVE_PTHREAD
+
+    Job *m_job;
+    unsigned int m_parts; ///< of the current job
+    unsigned int m_next;  ///< next part to start
+    unsigned int m_done;  ///< parts that are finished
+    unsigned long m_generation; ///< counts jobs, to wake each helper once
+    bool m_shutdown;
+};
+
+} // end namespace FbTk
+
+#endif // FBTK_WORKERPOOL_HH
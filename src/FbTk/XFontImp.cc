@@ -24,6 +24,7 @@
 #include "GContext.hh"
 #include "FbPixmap.hh"
 #include "I18n.hh"
+#include "MemoryAccount.hh"
 
 #include <X11/Xutil.h>
 
@@ -41,6 +42,8 @@
 #endif
 
 #include <algorithm>
+#include <climits>
+#include <vector>
 
 
 using std::cerr;
@@ -85,6 +88,7 @@ bool XFontImp::load(const string &fontname) {
         XFreeFont(App::instance()->display(), m_fontstruct);
 
     m_fontstruct = font; //set new font
+    m_rotcache.clear();
 
     for (int i = ROT0; i <= ROT270; ++i) {
         m_rotfonts_loaded[i] = false;
@@ -102,11 +106,12 @@ void XFontImp::drawText(const FbDrawable &w, int screen, GC gc, const char* text
     if (!text || !*text || m_fontstruct == 0)
         return;
 
-    std::string localestr = FbStringUtil::FbStrToLocale(FbString(text, len));
+    static std::string localestr;
+    FbStringUtil::FbStrToLocale(text, len, localestr);
 
     // use roated font functions?
     if (orient != ROT0 && validOrientation(orient)) {
-        drawRotText(w.drawable(), screen, gc, localestr.c_str(), localestr.size(), x, y, orient);
+        drawRotText(w, screen, gc, localestr.c_str(), localestr.size(), x, y, orient);
         return;
     }
 
@@ -119,7 +124,8 @@ unsigned int XFontImp::textWidth(const char* text, unsigned int size) const {
     if (!text || !*text || m_fontstruct == 0)
         return 0;
 
-    std::string localestr = FbStringUtil::FbStrToLocale(FbString(text, size));
+    static std::string localestr;
+    FbStringUtil::FbStrToLocale(text, size, localestr);
 
     return XTextWidth(m_fontstruct, localestr.data(), localestr.size());
 }
@@ -137,6 +143,7 @@ void XFontImp::rotate(FbTk::Orientation orient) {
         return;
 
     _FB_USES_NLS;
+    MemoryAccount::Scope account(MemoryAccount::IN_FONT, this);
 
     // X system default vars
     Display *dpy = App::instance()->display();
@@ -306,7 +313,7 @@ void XFontImp::rotate(FbTk::Orientation orient) {
 
         // create this character's bitmap
         rotfont->per_char[ichar-32].glyph.bm =
-            XCreatePixmap(dpy, rootwin, bit_w, bit_h, 1);
+            MemoryAccount::createPixmap(dpy, rootwin, bit_w, bit_h, 1);
 
         // put the image into the bitmap
         XPutImage(dpy, rotfont->per_char[ichar-32].glyph.bm,
@@ -323,31 +330,43 @@ void XFontImp::freeRotFont(XRotFontStruct *rotfont) {
     // loop through each character and free its pixmap
     for (int ichar = rotfont->min_char - 32;
          ichar <= rotfont->max_char - 32; ++ichar) {
-        XFreePixmap(App::instance()->display(), rotfont->per_char[ichar].glyph.bm);
+        MemoryAccount::freePixmap(App::instance()->display(), rotfont->per_char[ichar].glyph.bm);
     }
 
     delete rotfont;
     rotfont = 0;
 }
 
-void XFontImp::drawRotText(Drawable w, int screen, GC gc, const char* text, size_t len, int x, int y, FbTk::Orientation orient) const {
+void XFontImp::drawRotText(const FbDrawable &w, int screen, GC gc, const char* text, size_t len, int x, int y, FbTk::Orientation orient) const {
 
     if (!text || !*text || len<1)
         return;
 
-    Display *dpy = App::instance()->display();
-    static GC my_gc = 0;
-    int xp, yp, ichar;
+    // labels get redrawn on every focus and highlight change, so keep the
+    // whole rotated text instead of drawing it glyph by glyph each time
+    const RotatedTextCache::Label *label = m_rotcache.find(text, len, orient);
+    if (label == 0)
+        label = &m_rotcache.insert(text, len, orient,
+                                   renderRotText(w.drawable(), text, len, orient));
 
-    XRotFontStruct *rotfont = m_rotfonts[orient];
+    if (label->bitmap != None)
+        RotatedTextCache::draw(w, screen, gc, *label, x, y);
+}
 
-    if (my_gc == 0)
-        my_gc = XCreateGC(dpy, w, 0, 0);
+RotatedTextCache::Label XFontImp::renderRotText(Drawable w, const char* text, size_t len, FbTk::Orientation orient) const {
 
-    XCopyGC(dpy, gc, GCForeground|GCBackground, my_gc);
+    RotatedTextCache::Label label;
+    XRotFontStruct *rotfont = m_rotfonts[orient];
+    if (rotfont == 0)
+        return label;
+
+    Display *dpy = App::instance()->display();
+    int x = 0, y = 0, xp, yp, ichar;
+    int min_x = INT_MAX, min_y = INT_MAX, max_x = INT_MIN, max_y = INT_MIN;
 
-    // vertical or upside down
-    XSetFillStyle(dpy, my_gc, FillStippled);
+    // glyph positions relative to the text position
+    static std::vector<int> glyphs;
+    glyphs.clear();
 
     // loop through each character in texting
     for (size_t i = 0; i<len; i++) {
@@ -367,14 +386,13 @@ void XFontImp::drawRotText(Drawable w, int screen, GC gc, const char* text, size
                 yp = y+rotfont->per_char[ichar].lbearing;
             }
 
-            // draw the glyph
-            XSetStipple(dpy, my_gc, rotfont->per_char[ichar].glyph.bm);
-
-            XSetTSOrigin(dpy, my_gc, xp, yp);
-
-            XFillRectangle(dpy, w, my_gc, xp, yp,
-                           rotfont->per_char[ichar].glyph.bit_w,
-                           rotfont->per_char[ichar].glyph.bit_h);
+            glyphs.push_back(ichar);
+            glyphs.push_back(xp);
+            glyphs.push_back(yp);
+            min_x = std::min(min_x, xp);
+            min_y = std::min(min_y, yp);
+            max_x = std::max(max_x, xp + rotfont->per_char[ichar].glyph.bit_w);
+            max_y = std::max(max_y, yp + rotfont->per_char[ichar].glyph.bit_h);
 
             // advance position
             if (orient == ROT270)
@@ -385,6 +403,36 @@ void XFontImp::drawRotText(Drawable w, int screen, GC gc, const char* text, size
                 y += rotfont->per_char[ichar].width;
         }
     }
+
+    if (glyphs.empty() || max_x <= min_x || max_y <= min_y)
+        return label;
+
+    label.x = min_x;
+    label.y = min_y;
+    label.width = max_x - min_x;
+    label.height = max_y - min_y;
+    label.bitmap = MemoryAccount::createPixmap(dpy, w, label.width, label.height, 1);
+
+    GC bitmap_gc = XCreateGC(dpy, label.bitmap, 0, 0);
+    XSetForeground(dpy, bitmap_gc, 0);
+    XFillRectangle(dpy, label.bitmap, bitmap_gc, 0, 0, label.width, label.height);
+
+    XSetForeground(dpy, bitmap_gc, 1);
+    XSetFillStyle(dpy, bitmap_gc, FillStippled);
+    for (size_t i = 0; i < glyphs.size(); i += 3) {
+        const BitmapStruct &glyph = rotfont->per_char[glyphs[i]].glyph;
+        xp = glyphs[i + 1] - min_x;
+        yp = glyphs[i + 2] - min_y;
+
+        // draw the glyph
+        XSetStipple(dpy, bitmap_gc, glyph.bm);
+        XSetTSOrigin(dpy, bitmap_gc, xp, yp);
+        XFillRectangle(dpy, label.bitmap, bitmap_gc, xp, yp,
+                       glyph.bit_w, glyph.bit_h);
+    }
+    XFreeGC(dpy, bitmap_gc);
+
+    return label;
 }
 
 
@@ -23,6 +23,7 @@
 #define FBTK_XFONTIMP_HH
 
 #include "FontImp.hh"
+#include "RotatedTextCache.hh"
 
 namespace FbTk {
 
@@ -72,11 +73,14 @@ private:
     void rotate(FbTk::Orientation orient);
 
     void freeRotFont(XRotFontStruct * rotfont);
-    void drawRotText(Drawable w, int screen, GC gc, const char* text, size_t len, int x, int y, FbTk::Orientation orient) const;
+    void drawRotText(const FbDrawable &w, int screen, GC gc, const char* text, size_t len, int x, int y, FbTk::Orientation orient) const;
+    /// renders the whole text from the rotated glyphs into one bitmap
+    RotatedTextCache::Label renderRotText(Drawable w, const char* text, size_t len, FbTk::Orientation orient) const;
 
     XRotFontStruct *m_rotfonts[4]; ///< rotated font structure (only 3 used)
     bool m_rotfonts_loaded[4]; // whether we've tried yet
     XFontStruct *m_fontstruct; ///< X font structure
+    mutable RotatedTextCache m_rotcache; ///< recently drawn rotated labels
 
 };
 
@@ -0,0 +1,175 @@
+// XIDMap.hh for FbTk - Fluxbox Toolkit
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#ifndef FBTK_XIDMAP_HH
+#define FBTK_XIDMAP_HH
+
+#include <X11/X.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace FbTk {
+
+/**
+   Hash table from X resource ids (windows, pixmaps, ...) to T.
+
+   Open addressing with linear probing and backward shift deletion, so
+   lookups touch only a few adjacent slots and never follow pointers.
+   The slot of the last key found is remembered, since events tend to
+   come in bursts for the same window.
+   None (0) can't be used as a key. Adding or erasing entries invalidates
+   pointers returned by find().
+ */
+template <typename T>
+class XIDMap {
+public:
+    XIDMap(): m_size(0), m_last_key(None), m_last_slot(0) { }
+
+    /// @return the value of 'key' or 0 if there is none
+    T *find(XID key) {
+        if (key == None || m_size == 0)
+            return 0;
+        if (key == m_last_key)
+            return &m_slots[m_last_slot].value;
+        for (size_t i = home(key); ; i = next(i)) {
+            if (m_slots[i].key == key) {
+                m_last_key = key;
+                m_last_slot = i;
+                return &m_slots[i].value;
+            }
+            if (m_slots[i].key == None)
+                return 0;
+        }
+    }
+
+    const T *find(XID key) const {
+        return const_cast<XIDMap *>(this)->find(key);
+    }
+
+    /// @return the value of 'key' or 'def' if there is none
+    T get(XID key, const T &def = T()) const {
+        const T *val = find(key);
+        return val ? *val : def;
+    }
+
+    /// adds 'key' or replaces its value
+    void insert(XID key, const T &value) {
+        if (key == None)
+            return;
+        // keep at least half of the slots free
+        if ((m_size + 1) * 2 > m_slots.size())
+            rehash(m_slots.empty() ? 16 : m_slots.size() * 2);
+
+        size_t i = home(key);
+        for (; m_slots[i].key != None; i = next(i)) {
+            if (m_slots[i].key == key) {
+                m_slots[i].value = value;
+                return;
+            }
+        }
+        m_slots[i].key = key;
+        m_slots[i].value = value;
+        ++m_size;
+    }
+
+    /// @return true if 'key' was in the map
+    bool erase(XID key) {
+        if (key == None || m_size == 0)
+            return false;
+
+        size_t i = home(key);
+        for (; m_slots[i].key != key; i = next(i)) {
+            if (m_slots[i].key == None)
+                return false;
+        }
+
+        // entries move, including maybe the last one found
+        m_last_key = None;
+
+        // move back entries of the same probe sequence into the hole
+        for (size_t j = next(i); m_slots[j].key != None; j = next(j)) {
+            size_t h = home(m_slots[j].key);
+            bool stays = i <= j ? (i < h && h <= j) : (i < h || h <= j);
+            if (stays)
+                continue;
+            m_slots[i] = m_slots[j];
+            i = j;
+        }
+        m_slots[i] = Slot();
+        --m_size;
+        return true;
+    }
+
+    void clear() {
+        m_slots.clear();
+        m_size = 0;
+        m_last_key = None;
+    }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    /// calls functor(key, value) for all entries, in no particular order
+    template <typename Functor>
+    void forEach(Functor functor) const {
+        for (size_t i = 0; i < m_slots.size(); ++i) {
+            if (m_slots[i].key != None)
+                functor(m_slots[i].key, m_slots[i].value);
+        }
+    }
+
+private:
+    struct Slot {
+        Slot(): key(None), value() { }
+        XID key;
+        T value;
+    };
+
+    size_t home(XID key) const {
+        // ids of a client are sequential, spread them with a
+        // multiplicative (fibonacci) hash
+        unsigned long h = static_cast<unsigned long>(key) * 2654435769UL;
+        return (h ^ (h >> 15)) & (m_slots.size() - 1);
+    }
+
+    size_t next(size_t i) const { return (i + 1) & (m_slots.size() - 1); }
+
+    void rehash(size_t capacity) {
+        std::vector<Slot> old(capacity);
+        old.swap(m_slots);
+        m_size = 0;
+        m_last_key = None;
+        for (size_t i = 0; i < old.size(); ++i) {
+            if (old[i].key != None)
+                insert(old[i].key, old[i].value);
+        }
+    }
+
+    std::vector<Slot> m_slots; ///< size is always a power of two
+    size_t m_size;
+    XID m_last_key; ///< the key last found, None if it may have moved
+    size_t m_last_slot; ///< the slot of m_last_key
+};
+
+} // end namespace FbTk
+
+#endif // FBTK_XIDMAP_HH
@@ -22,13 +22,88 @@
 #include "XftFontImp.hh"
 #include "App.hh"
 #include "FbDrawable.hh"
+#include "XIDMap.hh"
+#include "RoundTrips.hh"
+#include "TextBatch.hh"
 
+#include <map>
+#include <vector>
 #include <math.h>
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif //HAVE_CONFIG_H
 
+namespace {
+
+/// XftDraws for the drawables text was drawn to, see forgetDrawable
+FbTk::XIDMap<XftDraw *> s_draws;
+
+/// colors for the gc foregrounds used so far, per screen
+typedef std::map<std::pair<int, unsigned long>, XftColor> Colors;
+Colors s_colors;
+/// more than this many colors means somebody is cycling through them
+const size_t MAX_COLORS = 256;
+
+XftDraw *getDraw(const FbTk::FbDrawable &w, int screen) {
+    XftDraw **cached = s_draws.find(w.drawable());
+    if (cached)
+        return *cached;
+
+    XftDraw *draw = XftDrawCreate(w.display(), w.drawable(),
+                                  DefaultVisual(w.display(), screen),
+                                  DefaultColormap(w.display(), screen));
+    if (draw)
+        s_draws.insert(w.drawable(), draw);
+    return draw;
+}
+
+const XftColor &getColor(Display *disp, int screen, unsigned long pixel) {
+    Colors::key_type key(screen, pixel);
+    Colors::iterator it = s_colors.find(key);
+    if (it != s_colors.end())
+        return it->second;
+
+    Visual *visual = DefaultVisual(disp, screen);
+    Colormap colmap = DefaultColormap(disp, screen);
+
+    if (s_colors.size() >= MAX_COLORS) {
+        for (it = s_colors.begin(); it != s_colors.end(); ++it) {
+            XftColorFree(disp, DefaultVisual(disp, it->first.first),
+                         DefaultColormap(disp, it->first.first), &it->second);
+        }
+        s_colors.clear();
+    }
+
+    // get red, green, blue values, this is the only round-trip and it
+    // happens once per color
+    XColor xcol;
+    xcol.pixel = pixel;
+    FBTK_ROUNDTRIP("XftFontImp::drawText");
+    XQueryColor(disp, colmap, &xcol);
+
+    // convert xcolor to XftColor
+    XRenderColor rendcol;
+    rendcol.red = xcol.red;
+    rendcol.green = xcol.green;
+    rendcol.blue = xcol.blue;
+    rendcol.alpha = 0xFFFF;
+    XftColor &xftcolor = s_colors[key];
+    XftColorAllocValue(disp, visual, colmap, &rendcol, &xftcolor);
+    return xftcolor;
+}
+
+/// glyphs of one color, waiting for a TextBatch to end
+struct Run {
+    XftColor color;
+    std::vector<XftGlyphFontSpec> glyphs;
+};
+
+typedef std::map<Drawable, std::vector<Run> > Batches;
+Batches s_batches;
+
+} // anonymous namespace
+
 namespace FbTk {
 
 XftFontImp::XftFontImp(const char *name, bool utf8):
@@ -73,6 +148,7 @@ bool XftFontImp::load(const std::string &name) {
     m_xftfonts[ROT0] = newxftfont;
     m_xftfonts_loaded[ROT0] = true;
     m_name = name;
+    m_advances.clear();
 
     return true;
 }
@@ -101,53 +177,114 @@ void XftFontImp::drawText(const FbDrawable &w, int screen, GC gc, const char* te
         break;
     }
 
-    Visual* def_visual = DefaultVisual(w.display(), screen);
-    Colormap def_colmap = DefaultColormap(w.display(), screen);
-
     XftFont *font = m_xftfonts[orient];
-    XftDraw *draw = XftDrawCreate(w.display(), w.drawable(), def_visual, def_colmap);
+    XftDraw *draw = getDraw(w, screen);
+    if (draw == 0)
+        return;
 
+    // get foreground pixel value, Xlib knows it without asking the server
     XGCValues gc_val;
-
-    // get foreground pixel value and convert it to XRenderColor value
-    // TODO: we should probably check return status
     XGetGCValues(w.display(), gc, GCForeground, &gc_val);
+    const XftColor &xftcolor = getColor(w.display(), screen, gc_val.foreground);
 
-    // get red, green, blue values
-    XColor xcol;
-    xcol.pixel = gc_val.foreground;
-    XQueryColor(w.display(), def_colmap, &xcol);
-
-    // convert xcolor to XftColor
-    XRenderColor rendcol;
-    rendcol.red = xcol.red;
-    rendcol.green = xcol.green;
-    rendcol.blue = xcol.blue;
-    rendcol.alpha = 0xFFFF;
-    XftColor xftcolor;
-    XftColorAllocValue(w.display(), def_visual, def_colmap, &rendcol, &xftcolor);
-
-    // draw string
+    bool utf8 = false;
 #ifdef HAVE_XFT_UTF8_STRING
     if (m_utf8mode) {
         // check the string size,
         // if the size is zero we use the XftDrawString8 function instead.
         XGlyphInfo ginfo;
         XftTextExtentsUtf8(w.display(), m_xftfonts[ROT0], (XftChar8 *)text, len, &ginfo);
-        if (ginfo.xOff != 0) {
-            XftDrawStringUtf8(draw, &xftcolor, font, x, y, (XftChar8 *)text, len);
-            XftColorFree(w.display(), def_visual, def_colmap, &xftcolor);
-            XftDrawDestroy(draw);
-            return;
-        }
+        utf8 = ginfo.xOff != 0;
+    }
+#endif // HAVE_XFT_UTF8_STRING
+
+    if (TextBatch::collecting(w.drawable())) {
+        collectText(w, font, xftcolor, text, len, utf8, x, y);
+        return;
+    }
+
+    // draw string
+#ifdef HAVE_XFT_UTF8_STRING
+    if (utf8) {
+        XftDrawStringUtf8(draw, &xftcolor, font, x, y, (XftChar8 *)text, len);
+        return;
     }
 #endif // HAVE_XFT_UTF8_STRING
 
     XftDrawString8(draw, &xftcolor, font, x, y, (XftChar8 *)text, len);
+}
+
+void XftFontImp::collectText(const FbDrawable &w, XftFont *font,
+                             const XftColor &color, const char *text, size_t len,
+                             bool utf8, int x, int y) {
+
+    std::vector<Run> &runs = s_batches[w.drawable()];
+
+    // one run per color, in the order the colors were first used
+    Run *run = 0;
+    for (size_t i = 0; i < runs.size() && run == 0; ++i) {
+        if (runs[i].color.pixel == color.pixel)
+            run = &runs[i];
+    }
+    if (run == 0) {
+        runs.push_back(Run());
+        run = &runs.back();
+        run->color = color;
+    }
+
+    // place the glyphs like XftDrawString* does, the rotated fonts
+    // advance along y too
+    const FcChar8 *p = reinterpret_cast<const FcChar8 *>(text);
+    const FcChar8 *end = p + len;
+    while (p < end) {
+        FcChar32 ch = *p;
+        int bytes = 1;
+        if (utf8) {
+            bytes = FcUtf8ToUcs4(p, &ch, end - p);
+            if (bytes <= 0)
+                break;
+        }
+        p += bytes;
+
+        XftGlyphFontSpec spec;
+        spec.font = font;
+        spec.glyph = XftCharIndex(w.display(), font, ch);
+        spec.x = x;
+        spec.y = y;
+        run->glyphs.push_back(spec);
+
+        XGlyphInfo ginfo;
+        XftGlyphExtents(w.display(), font, &spec.glyph, 1, &ginfo);
+        x += ginfo.xOff;
+        y += ginfo.yOff;
+    }
+}
+
+void XftFontImp::flushText(Drawable drawable) {
+    Batches::iterator it = s_batches.find(drawable);
+    if (it == s_batches.end())
+        return;
 
+    XftDraw **draw = s_draws.find(drawable);
+    if (draw) {
+        std::vector<Run> &runs = it->second;
+        for (size_t i = 0; i < runs.size(); ++i) {
+            if (!runs[i].glyphs.empty())
+                XftDrawGlyphFontSpec(*draw, &runs[i].color,
+                                     &runs[i].glyphs[0], runs[i].glyphs.size());
+        }
+    }
 
-    XftColorFree(w.display(), def_visual, def_colmap, &xftcolor);
-    XftDrawDestroy(draw);
+    s_batches.erase(it);
+}
+
+void XftFontImp::forgetDrawable(Drawable drawable) {
+    s_batches.erase(drawable);
+    XftDraw **draw = s_draws.find(drawable);
+    if (draw) {
+        XftDrawDestroy(*draw);
+        s_draws.erase(drawable);
+    }
 }
 
 unsigned int XftFontImp::textWidth(const char* text, unsigned int len) const {
@@ -160,9 +297,13 @@ unsigned int XftFontImp::textWidth(const char* text, unsigned int len) const {
 
     XftFont *font = m_xftfonts[ROT0];
 
+    unsigned int width = 0;
 
 #ifdef HAVE_XFT_UTF8_STRING
     if (m_utf8mode) {
+        if (sumAdvances(text, len, true, width) && width != 0)
+            return width;
+
         XftTextExtentsUtf8(disp,
                            font,
                            (XftChar8 *)text, len,
@@ -174,14 +315,59 @@ unsigned int XftFontImp::textWidth(const char* text, unsigned int len) const {
     }
 #endif  //HAVE_XFT_UTF8_STRING
 
-    std::string localestr = FbStringUtil::FbStrToLocale(FbString(text, len));
+    // ascii is the same in every locale, skip the conversion
+    if (sumAdvances(text, len, false, width))
+        return width;
+
+    static std::string localestr;
+    FbStringUtil::FbStrToLocale(text, len, localestr);
+
+    // XftTextExtents8 takes the bytes as latin-1 characters
+    for (std::string::size_type i = 0; i < localestr.size(); ++i) {
+        unsigned char ch = localestr[i];
+        int advance = m_advances.find(ch);
+        if (advance < 0) {
+            XftTextExtents8(disp, font, &ch, 1, &ginfo);
+            advance = ginfo.xOff;
+            m_advances.insert(ch, advance);
+        }
+        width += advance;
+    }
 
-    XftTextExtents8(disp,
-                    font,
-                    (XftChar8 *)localestr.data(), localestr.size(),
-                    &ginfo);
+    return width;
+}
 
-    return ginfo.xOff;
+bool XftFontImp::sumAdvances(const char *text, unsigned int len, bool utf8,
+                             unsigned int &width) const {
+
+    // Xft doesn't kern, the width of a string is the sum of the advances
+    // of its glyphs
+    const FcChar8 *p = reinterpret_cast<const FcChar8 *>(text);
+    const FcChar8 *end = p + len;
+    width = 0;
+    while (p < end) {
+        FcChar32 ch = *p;
+        int bytes = 1;
+        if (ch >= 0x80) {
+            if (!utf8)
+                return false;
+            bytes = FcUtf8ToUcs4(p, &ch, end - p);
+            if (bytes <= 0)
+                return false;
+        }
+
+        int advance = m_advances.find(ch);
+        if (advance < 0) {
+            XGlyphInfo ginfo;
+            XftTextExtents32(App::instance()->display(), m_xftfonts[ROT0],
+                             &ch, 1, &ginfo);
+            advance = ginfo.xOff;
+            m_advances.insert(ch, advance);
+        }
+        width += advance;
+        p += bytes;
+    }
+    return true;
 }
 
 unsigned int XftFontImp::height() const {
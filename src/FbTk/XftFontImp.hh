@@ -23,6 +23,7 @@
 #define FBTK_XFTFONTIMP_HH
 
 #include "FontImp.hh"
+#include "GlyphAdvances.hh"
 
 #include <X11/Xft/Xft.h>
 
@@ -43,7 +44,23 @@ public:
     bool utf8() const { return m_utf8mode; }
     bool validOrientation(FbTk::Orientation orient);
 
+    /// frees what drawText cached for a drawable that is about to go away
+    static void forgetDrawable(Drawable drawable);
+    /// draws the text collected for drawable by a TextBatch
+    static void flushText(Drawable drawable);
+
 private:
+    /**
+       Sums the cached advances of the characters in text
+       @return false if text needs the font library (e.g. a conversion)
+    */
+    bool sumAdvances(const char *text, unsigned int len, bool utf8,
+                     unsigned int &width) const;
+    /// adds the glyphs of text to the batch of drawable
+    void collectText(const FbDrawable &w, XftFont *font,
+                     const XftColor &color, const char *text, size_t len,
+                     bool utf8, int x, int y);
+
     XftFont *m_xftfonts[4]; // 4 possible orientations
     bool m_xftfonts_loaded[4]; // whether we've tried loading the orientation
     // rotated xft fonts don't give proper extents info, so we keep the "real"
@@ -52,6 +69,7 @@ private:
 
     std::string m_name;
     int m_angle;
+    mutable GlyphAdvances m_advances; ///< of the unrotated font
 };
 
 } // end namespace FbTk
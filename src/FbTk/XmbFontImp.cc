@@ -185,6 +185,8 @@ bool XmbFontImp::load(const string &fontname) {
 
     m_fontset = set;
     m_setextents = XExtentsOfFontSet(m_fontset);
+    m_advances.clear();
+    m_rotcache.clear();
 
     return true;
 }
@@ -204,7 +206,8 @@ void XmbFontImp::drawText(const FbDrawable &d, int screen, GC main_gc, const cha
         } else
 #endif //X_HAVE_UTF8_STRING
             {
-                std::string localestr = FbStringUtil::FbStrToLocale(FbString(text, len));
+                static std::string localestr;
+                FbStringUtil::FbStrToLocale(text, len, localestr);
                 XmbDrawString(d.display(), d.drawable(), m_fontset,
                               main_gc, x, y,
                               localestr.data(), localestr.size());
@@ -212,6 +215,23 @@ void XmbFontImp::drawText(const FbDrawable &d, int screen, GC main_gc, const cha
         return;
     }
 
+    // the text is rendered upright over the whole drawable and then
+    // rotated, which is slow; keep the result for the next redraw
+    const RotatedTextCache::Label *label =
+        m_rotcache.find(text, len, orient, x, y, d.width(), d.height());
+    if (label == 0)
+        label = &m_rotcache.insert(text, len, orient,
+                                   renderRotText(d, text, len, x, y, orient),
+                                   x, y, d.width(), d.height());
+
+    if (label->bitmap != None)
+        RotatedTextCache::draw(d, screen, main_gc, *label, 0, 0);
+}
+
+RotatedTextCache::Label XmbFontImp::renderRotText(const FbDrawable &d, const char* text,
+                                                  size_t len, int x, int y,
+                                                  FbTk::Orientation orient) const {
+
     Display *dpy = App::instance()->display();
 
     int xpos = x, ypos = y;
@@ -241,7 +261,8 @@ void XmbFontImp::drawText(const FbDrawable &d, int screen, GC main_gc, const cha
     } else
 #endif //X_HAVE_UTF8_STRING
     {
-        std::string localestr = FbStringUtil::FbStrToLocale(FbString(text, len));
+        static std::string localestr;
+        FbStringUtil::FbStrToLocale(text, len, localestr);
         XmbDrawString(dpy, canvas.drawable(), m_fontset,
                            font_gc.gc(), xpos, ypos,
                            localestr.data(), localestr.size());
@@ -249,21 +270,11 @@ void XmbFontImp::drawText(const FbDrawable &d, int screen, GC main_gc, const cha
 
     canvas.rotate(orient);
 
-    GC my_gc = XCreateGC(dpy, d.drawable(), 0, 0);
-
-    XCopyGC(dpy, main_gc, GCForeground|GCBackground, my_gc);
-
-    // vertical or upside down
-    XSetFillStyle(dpy, my_gc, FillStippled);
-    XSetStipple(dpy, my_gc, canvas.drawable());
-    XSetTSOrigin(dpy, my_gc, 0, 0);
-
-    XFillRectangle(dpy, d.drawable(), my_gc, 0, 0,
-                   canvas.width(),
-                   canvas.height());
-
-    XFreeGC(dpy, my_gc);
-
+    RotatedTextCache::Label label;
+    label.width = canvas.width();
+    label.height = canvas.height();
+    label.bitmap = canvas.release();
+    return label;
 }
 
 unsigned int XmbFontImp::textWidth(const char* text, unsigned int len) const {
@@ -272,6 +283,22 @@ unsigned int XmbFontImp::textWidth(const char* text, unsigned int len) const {
         return 0;
 
     XRectangle ink, logical;
+
+    // ascii is the same in every locale and encoding, so its width is
+    // the sum of the cached advances
+    unsigned int width = 0, i = 0;
+    for (; i < len && (text[i] & 0x80) == 0; ++i) {
+        int advance = m_advances.find(text[i]);
+        if (advance < 0) {
+            XmbTextExtents(m_fontset, text + i, 1, &ink, &logical);
+            advance = logical.width;
+            m_advances.insert(text[i], advance);
+        }
+        width += advance;
+    }
+    if (i == len && width != 0)
+        return width;
+
 #ifdef X_HAVE_UTF8_STRING
     if (m_utf8mode) {
         Xutf8TextExtents(m_fontset, text, len, &ink, &logical);
@@ -280,7 +307,8 @@ unsigned int XmbFontImp::textWidth(const char* text, unsigned int len) const {
     }
 #endif // X_HAVE_UTF8_STRING
 
-    std::string localestr = FbStringUtil::FbStrToLocale(FbString(text, len));
+    static std::string localestr;
+    FbStringUtil::FbStrToLocale(text, len, localestr);
     XmbTextExtents(m_fontset, localestr.data(), localestr.size(),
                    &ink, &logical);
     return logical.width;
@@ -23,6 +23,8 @@
 #define FBTK_XMBFONTIMP_HH
 
 #include "FontImp.hh"
+#include "GlyphAdvances.hh"
+#include "RotatedTextCache.hh"
 
 namespace FbTk {
 
@@ -43,9 +45,16 @@ public:
     bool validOrientation(FbTk::Orientation orient) { return true; }; // rotated on demand
 
 private:
+    /// draws the text upright and rotates the whole drawable sized bitmap
+    RotatedTextCache::Label renderRotText(const FbDrawable &d, const char* text,
+                                          size_t len, int x, int y,
+                                          FbTk::Orientation orient) const;
+
     XFontSet m_fontset;
     XFontSetExtents *m_setextents;
     bool m_utf8mode;
+    mutable GlyphAdvances m_advances; ///< of ascii characters
+    RotatedTextCache m_rotcache; ///< recently drawn rotated labels
 };
 
 } // end namespace FbTk
@@ -30,6 +30,9 @@
 #include "FbTk/CompareEqual.hh"
 #include "FbTk/TextUtils.hh"
 #include "FbTk/STLUtil.hh"
+#include "FbTk/MemFun.hh"
+#include "FbTk/MemoryAccount.hh"
+#include "FbTk/RequestStats.hh"
 
 #include "FbWinFrameTheme.hh"
 #include "Screen.hh"
@@ -45,6 +48,28 @@ using std::string;
 
 using FbTk::STLUtil::forAll;
 
+namespace {
+
+bool sameBackground(Pixmap pm1, const FbTk::Color &color1,
+                    Pixmap pm2, const FbTk::Color &color2) {
+    return pm1 == pm2 && (pm1 != None || color1.pixel() == color2.pixel());
+}
+
+/// @return the index of a single bit
+int partIndex(unsigned int part) {
+    int index = 0;
+    while (part > 1) {
+        part >>= 1;
+        ++index;
+    }
+    return index;
+}
+
+} // anonymous namespace
+
+FbWinFrame::Stats FbWinFrame::s_stats = { 0, 0, 0, 0 };
+int FbWinFrame::s_defer_rendering = 0;
+
 FbWinFrame::FbWinFrame(BScreen &screen, unsigned int client_depth,
                        WindowState &state,
                        FocusableTheme<FbWinFrameTheme> &theme):
@@ -99,20 +124,36 @@ FbWinFrame::FbWinFrame(BScreen &screen, unsigned int client_depth,
     m_use_tabs(true),
     m_use_handle(true),
     m_visible(false),
+    m_prerendering(false),
     m_button_pm(0),
     m_tabmode(screen.getDefaultInternalTabs()?INTERNAL:EXTERNAL),
     m_active_orig_client_bw(0),
     m_need_render(true),
+    m_render_dirty(ALL_PARTS),
+    m_apply_dirty(ALL_PARTS),
     m_button_size(1),
     m_focused_alpha(AlphaAcc(*theme.focusedTheme(), &FbWinFrameTheme::alpha)),
     m_unfocused_alpha(AlphaAcc(*theme.unfocusedTheme(), &FbWinFrameTheme::alpha)),
     m_shape(m_window, theme->shapePlace()) {
+
+    for (int i = 0; i < NUM_PARTS; ++i) {
+        m_part_keys[i].width = m_part_keys[i].height = 0;
+        m_part_keys[i].variant = 0;
+    }
+    if (s_stats.frames++ == 0 && s_stats.since == 0)
+        s_stats.since = FbTk::FbTime::mono();
+
+    // before the window's handler, which reconfigures us
+    m_signals.join(theme.reconfigSig(), FbTk::MemFun(*this, &FbWinFrame::themeChanged));
+
     init();
 }
 
 FbWinFrame::~FbWinFrame() {
     removeEventHandler();
     removeAllButtons();
+    releasePixmaps();
+    --s_stats.frames;
 }
 
 bool FbWinFrame::setTabMode(TabMode tabmode) {
@@ -188,15 +229,69 @@ void FbWinFrame::hide() {
         m_tab_container.hide();
 
     m_visible = false;
+    touch();
+
+    // frames with the same size and style share their pixmaps through the
+    // image cache; don't hold on to them while hidden. windows that are
+    // hidden only briefly (workspace switches) keep them for a while
+    int delay = m_screen.getDecorationReleaseDelay();
+    if (delay > 0) {
+        m_release_timer.setTimeout(delay, 0);
+        m_release_timer.start();
+    } else
+        releaseHidden();
+}
+
+void FbWinFrame::reclaim() {
+    if (isVisible())
+        return;
+
+    m_release_timer.stop();
+    releaseHidden();
+
+    // the windows would keep the pixmaps alive in the server
+    m_titlebar.releaseBackground();
+    m_label.releaseBackground();
+    m_tab_container.releaseBackground();
+    m_handle.releaseBackground();
+    m_grip_left.releaseBackground();
+    m_grip_right.releaseBackground();
+    for (size_t i = 0; i < m_buttons_left.size(); ++i)
+        m_buttons_left[i]->releaseBackground();
+    for (size_t i = 0; i < m_buttons_right.size(); ++i)
+        m_buttons_right[i]->releaseBackground();
+}
+
+void FbWinFrame::prerender() {
+    if (isVisible() || !m_need_render || m_state.fullscreen)
+        return;
+
+    FbTk::MemoryAccount::Scope account(FbTk::MemoryAccount::IN_FRAME, this);
+    FbTk::RequestStats::Widget widget(typeid(*this));
+    m_release_timer.stop();
+    m_prerendering = true;
+    renderAll();
+    // the backgrounds show when the windows get mapped
+    applyAll();
+    m_prerendering = false;
+    touch();
+}
+
+void FbWinFrame::releaseHidden() {
+    if (isVisible())
+        return;
+
+    releasePixmaps();
+    m_need_render = true;
 }
 
 void FbWinFrame::show() {
     m_visible = true;
+    m_release_timer.stop();
 
     if (m_need_render) {
         renderAll();
-         applyAll();
-        clearAll();
+        clearParts(applyAll());
     }
 
     if (m_tabmode == EXTERNAL && m_use_tabs)
@@ -236,6 +331,8 @@ void FbWinFrame::resizeForClient(unsigned int width, unsigned int height,
 }
 
 void FbWinFrame::moveResize(int x, int y, unsigned int width, unsigned int height, bool move, bool resize) {
+    FbTk::MemoryAccount::Scope account(FbTk::MemoryAccount::IN_FRAME, this);
+    FbTk::RequestStats::Widget widget(typeid(*this));
     if (move && x == window().x() && y == window().y())
         move = false;
 
@@ -442,9 +539,10 @@ void FbWinFrame::alignTabs() {
 }
 
 void FbWinFrame::notifyMoved(bool clear) {
-    // not important if no alpha...
+    // not important if no alpha, nor if the compositor blends the frame
+    // as a whole; our decorations are opaque then and go along unchanged
     int alpha = getAlpha(m_state.focused);
-    if (alpha == 255)
+    if (alpha == 255 || FbTk::Transparent::useComposite(m_window.screenNumber()))
         return;
 
     if ((m_tabmode == EXTERNAL && m_use_tabs) || m_use_titlebar) {
@@ -475,22 +573,40 @@ void FbWinFrame::notifyMoved(bool clear) {
 }
 
 void FbWinFrame::clearAll() {
+    clearParts(ALL_PARTS);
+}
+
+void FbWinFrame::clearParts(unsigned int parts) {
+
+    // parent relative children show their parent
+    if (parts & TITLE_PART)
+        parts |= LABEL_PART | BUTTON_PART | TAB_PART;
+    if (parts & HANDLE_PART)
+        parts |= GRIP_PART;
 
     if  (m_use_titlebar) {
-        redrawTitlebar();
-        forAll(m_buttons_left, mem_fun(&FbTk::Button::clear));
-        forAll(m_buttons_right, mem_fun(&FbTk::Button::clear));
-    } else if (m_tabmode == EXTERNAL && m_use_tabs)
+        if (parts & (TITLE_PART | LABEL_PART | TAB_PART))
+            redrawTitlebar();
+        if (parts & BUTTON_PART) {
+            forAll(m_buttons_left, mem_fun(&FbTk::Button::clear));
+            forAll(m_buttons_right, mem_fun(&FbTk::Button::clear));
+        }
+    } else if (m_tabmode == EXTERNAL && m_use_tabs && (parts & TAB_PART))
         m_tab_container.clear();
 
     if (m_use_handle) {
-        m_handle.clear();
-        m_grip_left.clear();
-        m_grip_right.clear();
+        if (parts & HANDLE_PART)
+            m_handle.clear();
+        if (parts & GRIP_PART) {
+            m_grip_left.clear();
+            m_grip_right.clear();
+        }
     }
 }
 
 void FbWinFrame::setFocus(bool newvalue) {
+    FbTk::MemoryAccount::Scope account(FbTk::MemoryAccount::IN_FRAME, this);
+    FbTk::RequestStats::Widget widget(typeid(*this));
     if (m_state.focused == newvalue)
         return;
 
@@ -499,10 +615,10 @@ void FbWinFrame::setFocus(bool newvalue) {
     if (FbTk::Transparent::haveRender() && 
         getAlpha(true) != getAlpha(false)) { // different alpha for focused and unfocused
         int alpha = getAlpha(m_state.focused);
-        if (FbTk::Transparent::haveComposite()) {
-            m_tab_container.setAlpha(255);
+        // the compositor blends the frame as a whole, nothing to redraw
+        if (FbTk::Transparent::useComposite(m_window.screenNumber()))
             m_window.setOpaque(alpha);
-        } else {
+        else {
             m_tab_container.setAlpha(alpha);
             m_window.setOpaque(255);
         }
@@ -510,8 +626,33 @@ void FbWinFrame::setFocus(bool newvalue) {
 
     setBorderWidth();
 
-    applyAll();
-    clearAll();
+    m_apply_dirty |= focusDependentParts();
+    clearParts(applyAll());
+}
+
+unsigned int FbWinFrame::focusDependentParts() const {
+    // with a compositor the alpha is only the opacity of the frame
+    if (getAlpha(true) != getAlpha(false) &&
+        !FbTk::Transparent::useComposite(m_window.screenNumber()))
+        return ALL_PARTS;
+
+    // the label text and button pictures use the focused or unfocused gc,
+    // the tabs also follow the focus
+    unsigned int parts = LABEL_PART | BUTTON_PART | TAB_PART;
+    if (!sameBackground(m_title_focused_pm, m_title_focused_color,
+                        m_title_unfocused_pm, m_title_unfocused_color))
+        parts |= TITLE_PART;
+    if (!sameBackground(m_handle_focused_pm, m_handle_focused_color,
+                        m_handle_unfocused_pm, m_handle_unfocused_color))
+        parts |= HANDLE_PART;
+    if (!sameBackground(m_grip_focused_pm, m_grip_focused_color,
+                        m_grip_unfocused_pm, m_grip_unfocused_color))
+        parts |= GRIP_PART;
+    return parts;
+}
+
+void FbWinFrame::themeChanged() {
+    m_render_dirty = m_apply_dirty = ALL_PARTS;
 }
 
 void FbWinFrame::applyState() {
@@ -563,13 +704,15 @@ void FbWinFrame::setAlpha(bool focused, int alpha) {
 }
 
 void FbWinFrame::applyAlpha() {
+    FbTk::MemoryAccount::Scope account(FbTk::MemoryAccount::IN_FRAME, this);
+    FbTk::RequestStats::Widget widget(typeid(*this));
     int alpha = getAlpha(m_state.focused);
-    if (FbTk::Transparent::haveComposite())
+    if (FbTk::Transparent::useComposite(m_window.screenNumber()))
         m_window.setOpaque(alpha);
     else {
         // don't need to setAlpha, since apply updates them anyway
-        applyAll();
-        clearAll();
+        m_apply_dirty = ALL_PARTS;
+        clearParts(applyAll());
     }
 }
 
@@ -624,11 +767,13 @@ void FbWinFrame::createTab(FbTk::Button &button) {
     FbTk::EventManager::instance()->add(button, button.window());
 
     m_tab_container.insertItem(&button);
+    m_apply_dirty |= TAB_PART;
 }
 
 void FbWinFrame::removeTab(IconButton *btn) {
     if (m_tab_container.removeItem(btn))
         delete btn;
+    m_apply_dirty |= TAB_PART;
 }
 
 
@@ -880,6 +1025,8 @@ void FbWinFrame::configureNotifyEvent(XConfigureEvent &event) {
 }
 
 void FbWinFrame::reconfigure() {
+    FbTk::MemoryAccount::Scope account(FbTk::MemoryAccount::IN_FRAME, this);
+    FbTk::RequestStats::Widget widget(typeid(*this));
     if (m_tab_container.empty())
         return;
 
@@ -982,24 +1129,11 @@ void FbWinFrame::reconfigure() {
         move(grav_x + x(), grav_y + y());
 
     // render the theme
-    if (isVisible()) {
-        // update transparency settings
-        if (FbTk::Transparent::haveRender()) {
-            int alpha = getAlpha(m_state.focused);
-            if (FbTk::Transparent::haveComposite()) {
-                m_tab_container.setAlpha(255);
-                m_window.setOpaque(alpha);
-            } else {
-                m_tab_container.setAlpha(alpha);
-                m_window.setOpaque(255);
-            }
-        }
-        renderAll();
-        applyAll();
-        clearAll();
-    } else {
-        m_need_render = true;
-    }
+    m_need_render = true;
+    if (isVisible() && s_defer_rendering > 0)
+        m_deferred_render.schedule();
+    else
+        renderDeferred();
 
     m_shape.setPlaces(getShape());
     m_shape.setShapeOffsets(0, titlebarHeight());
@@ -1020,7 +1154,7 @@ unsigned int FbWinFrame::buttonHeight() const {
 /**
    aligns and redraws title
 */
-void FbWinFrame::redrawTitlebar() {
+void FbWinFrame::drawTitlebar() {
     if (!m_use_titlebar || m_tab_container.empty())
         return;
 
@@ -1106,7 +1240,44 @@ void FbWinFrame::reconfigureTitlebar() {
     m_titlebar.raise(); // always on top
 }
 
+void FbWinFrame::deferRendering(bool defer) {
+    if (defer)
+        ++s_defer_rendering;
+    else if (s_defer_rendering > 0)
+        --s_defer_rendering;
+}
+
+void FbWinFrame::renderDeferred() {
+    FbTk::MemoryAccount::Scope account(FbTk::MemoryAccount::IN_FRAME, this);
+    FbTk::RequestStats::Widget widget(typeid(*this));
+    m_deferred_render.cancel();
+
+    if (!m_need_render || !isVisible())
+        return;
+
+    // update transparency settings
+    if (FbTk::Transparent::haveRender()) {
+        int alpha = getAlpha(m_state.focused);
+        if (FbTk::Transparent::useComposite(m_window.screenNumber())) {
+            m_tab_container.setAlpha(255);
+            m_window.setOpaque(alpha);
+        } else {
+            m_tab_container.setAlpha(alpha);
+            m_window.setOpaque(255);
+        }
+    }
+    // the client covers the whole frame, the decorations come back
+    // with the resize that ends fullscreen
+    if (m_state.fullscreen)
+        return;
+
+    renderAll();
+    clearParts(applyAll());
+}
+
 void FbWinFrame::renderAll() {
+    FbTk::MemoryAccount::Scope account(FbTk::MemoryAccount::IN_FRAME, this);
+    FbTk::RequestStats::Widget widget(typeid(*this));
     m_need_render = false;
 
     renderTitlebar();
@@ -1114,44 +1285,76 @@ void FbWinFrame::renderAll() {
     renderTabContainer();
 }
 
-void FbWinFrame::applyAll() {
-    applyTitlebar();
-    applyHandles();
-    applyTabContainer();
+unsigned int FbWinFrame::applyAll() {
+    // pseudo transparent parts show what's behind them, which changes
+    // without us noticing
+    if (FbTk::Transparent::haveRender() &&
+        !FbTk::Transparent::useComposite(m_window.screenNumber()) &&
+        getAlpha(m_state.focused) != 255)
+        m_apply_dirty = ALL_PARTS;
+
+    unsigned int parts = m_apply_dirty;
+    if (parts & (TITLE_PART | LABEL_PART | BUTTON_PART))
+        applyTitlebar(parts);
+    if (parts & (HANDLE_PART | GRIP_PART))
+        applyHandles(parts);
+    if (parts & TAB_PART)
+        applyTabContainer();
+    m_apply_dirty = 0;
+    return parts;
+}
+
+bool FbWinFrame::needRender(DecorPart part, unsigned int width, unsigned int height,
+                            int variant) {
+    PartKey &key = m_part_keys[partIndex(part)];
+    if ((m_render_dirty & part) == 0 && key.width == width &&
+        key.height == height && key.variant == variant)
+        return false;
+
+    m_render_dirty &= ~part;
+    key.width = width;
+    key.height = height;
+    key.variant = variant;
+    m_apply_dirty |= part;
+    return true;
 }
 
 void FbWinFrame::renderTitlebar() {
     if (!m_use_titlebar)
         return;
 
-    if (!isVisible()) {
+    if (!canRender()) {
         m_need_render = true;
         return;
     }
 
     // render pixmaps
-    render(theme().focusedTheme()->titleTexture(), m_title_focused_color,
-           m_title_focused_pm,
-           m_titlebar.width(), m_titlebar.height());
-
-    render(theme().unfocusedTheme()->titleTexture(), m_title_unfocused_color,
-           m_title_unfocused_pm,
-           m_titlebar.width(), m_titlebar.height());
+    if (needRender(TITLE_PART, m_titlebar.width(), m_titlebar.height())) {
+        render(theme().focusedTheme()->titleTexture(), m_title_focused_color,
+               m_title_focused_pm,
+               m_titlebar.width(), m_titlebar.height());
+
+        render(theme().unfocusedTheme()->titleTexture(), m_title_unfocused_color,
+               m_title_unfocused_pm,
+               m_titlebar.width(), m_titlebar.height());
+    }
 
     //!! TODO: don't render label if internal tabs
 
-    render(theme().focusedTheme()->iconbarTheme()->texture(),
-           m_label_focused_color, m_label_focused_pm,
-           m_label.width(), m_label.height());
+    if (needRender(LABEL_PART, m_label.width(), m_label.height())) {
+        render(theme().focusedTheme()->iconbarTheme()->texture(),
+               m_label_focused_color, m_label_focused_pm,
+               m_label.width(), m_label.height());
 
-    render(theme().unfocusedTheme()->iconbarTheme()->texture(),
-           m_label_unfocused_color, m_label_unfocused_pm,
-           m_label.width(), m_label.height());
+        render(theme().unfocusedTheme()->iconbarTheme()->texture(),
+               m_label_unfocused_color, m_label_unfocused_pm,
+               m_label.width(), m_label.height());
+    }
 
 }
 
 void FbWinFrame::renderTabContainer() {
-    if (!isVisible()) {
+    if (!canRender() || m_state.fullscreen) {
         m_need_render = true;
         return;
     }
@@ -1164,19 +1367,23 @@ void FbWinFrame::renderTabContainer() {
     if (m_tabmode == EXTERNAL && tc_unfocused->type() & FbTk::Texture::PARENTRELATIVE)
         tc_unfocused = &theme().unfocusedTheme()->titleTexture();
 
-    render(*tc_focused, m_tabcontainer_focused_color,
-           m_tabcontainer_focused_pm,
-           m_tab_container.width(), m_tab_container.height(), m_tab_container.orientation());
+    // the textures depend on the tab mode
+    if (needRender(TAB_PART, m_tab_container.width(), m_tab_container.height(),
+                   m_tab_container.orientation() * 4 + m_tabmode)) {
+        render(*tc_focused, m_tabcontainer_focused_color,
+               m_tabcontainer_focused_pm,
+               m_tab_container.width(), m_tab_container.height(), m_tab_container.orientation());
 
-    render(*tc_unfocused, m_tabcontainer_unfocused_color,
-           m_tabcontainer_unfocused_pm,
-           m_tab_container.width(), m_tab_container.height(), m_tab_container.orientation());
+        render(*tc_unfocused, m_tabcontainer_unfocused_color,
+               m_tabcontainer_unfocused_pm,
+               m_tab_container.width(), m_tab_container.height(), m_tab_container.orientation());
+    }
 
     renderButtons();
 
 }
 
-void FbWinFrame::applyTitlebar() {
+void FbWinFrame::applyTitlebar(unsigned int parts) {
 
     // set up pixmaps for titlebar windows
     Pixmap label_pm = None;
@@ -1187,25 +1394,36 @@ void FbWinFrame::applyTitlebar() {
                           label_color, title_color);
 
     int alpha = getAlpha (m_state.focused);
-    m_titlebar.setAlpha(alpha);
-    m_label.setAlpha(alpha);
 
-    if (m_tabmode != INTERNAL) {
-        m_label.setGC(theme()->iconbarTheme()->text().textGC());
-        m_label.setJustify(theme()->iconbarTheme()->text().justify());
+    if (parts & LABEL_PART) {
+        ++s_stats.applies;
+        m_label.setAlpha(alpha);
+
+        if (m_tabmode != INTERNAL) {
+            m_label.setGC(theme()->iconbarTheme()->text().textGC());
+            m_label.setJustify(theme()->iconbarTheme()->text().justify());
 
-        if (label_pm != 0)
-            m_label.setBackgroundPixmap(label_pm);
+            if (label_pm != 0)
+                m_label.setBackgroundPixmap(label_pm);
+            else
+                m_label.setBackgroundColor(label_color);
+        }
+    }
+
+    if (parts & TITLE_PART) {
+        ++s_stats.applies;
+        m_titlebar.setAlpha(alpha);
+
+        if (title_pm != 0)
+            m_titlebar.setBackgroundPixmap(title_pm);
         else
-            m_label.setBackgroundColor(label_color);
+            m_titlebar.setBackgroundColor(title_color);
     }
 
-    if (title_pm != 0)
-        m_titlebar.setBackgroundPixmap(title_pm);
-    else
-        m_titlebar.setBackgroundColor(title_color);
+    if (parts & BUTTON_PART)
+        applyButtons();
 
-    applyButtons();
+    m_apply_dirty &= ~(parts & (TITLE_PART | LABEL_PART | BUTTON_PART));
 }
 
 
@@ -1213,78 +1431,79 @@ void FbWinFrame::renderHandles() {
     if (!m_use_handle)
         return;
 
-    if (!isVisible()) {
+    if (!canRender()) {
         m_need_render = true;
         return;
     }
 
-    render(theme().focusedTheme()->handleTexture(), m_handle_focused_color,
-           m_handle_focused_pm,
-           m_handle.width(), m_handle.height());
+    if (needRender(HANDLE_PART, m_handle.width(), m_handle.height())) {
+        render(theme().focusedTheme()->handleTexture(), m_handle_focused_color,
+               m_handle_focused_pm,
+               m_handle.width(), m_handle.height());
 
-    render(theme().unfocusedTheme()->handleTexture(), m_handle_unfocused_color,
-           m_handle_unfocused_pm,
-           m_handle.width(), m_handle.height());
+        render(theme().unfocusedTheme()->handleTexture(), m_handle_unfocused_color,
+               m_handle_unfocused_pm,
+               m_handle.width(), m_handle.height());
+    }
 
-    render(theme().focusedTheme()->gripTexture(), m_grip_focused_color,
-           m_grip_focused_pm,
-           m_grip_left.width(), m_grip_left.height());
+    if (needRender(GRIP_PART, m_grip_left.width(), m_grip_left.height())) {
+        render(theme().focusedTheme()->gripTexture(), m_grip_focused_color,
+               m_grip_focused_pm,
+               m_grip_left.width(), m_grip_left.height());
 
-    render(theme().unfocusedTheme()->gripTexture(), m_grip_unfocused_color,
-           m_grip_unfocused_pm,
-           m_grip_left.width(), m_grip_left.height());
+        render(theme().unfocusedTheme()->gripTexture(), m_grip_unfocused_color,
+               m_grip_unfocused_pm,
+               m_grip_left.width(), m_grip_left.height());
+    }
 
 }
 
-void FbWinFrame::applyHandles() {
+void FbWinFrame::applyHandles(unsigned int parts) {
 
     int alpha = getAlpha(m_state.focused);
-    m_handle.setAlpha(alpha);
-    m_grip_left.setAlpha(alpha);
-    m_grip_right.setAlpha(alpha);
-
-    if (m_state.focused) {
 
-        if (m_handle_focused_pm) {
-            m_handle.setBackgroundPixmap(m_handle_focused_pm);
-        } else {
-            m_handle.setBackgroundColor(m_handle_focused_color);
-        }
+    if (parts & HANDLE_PART) {
+        ++s_stats.applies;
+        m_handle.setAlpha(alpha);
 
-        if (m_grip_focused_pm) {
-            m_grip_left.setBackgroundPixmap(m_grip_focused_pm);
-            m_grip_right.setBackgroundPixmap(m_grip_focused_pm);
-        } else {
-            m_grip_left.setBackgroundColor(m_grip_focused_color);
-            m_grip_right.setBackgroundColor(m_grip_focused_color);
-        }
+        Pixmap pm = m_state.focused ? m_handle_focused_pm : m_handle_unfocused_pm;
+        if (pm)
+            m_handle.setBackgroundPixmap(pm);
+        else
+            m_handle.setBackgroundColor(m_state.focused ? m_handle_focused_color
+                                                        : m_handle_unfocused_color);
+    }
 
-    } else {
+    if (parts & GRIP_PART) {
+        ++s_stats.applies;
+        m_grip_left.setAlpha(alpha);
+        m_grip_right.setAlpha(alpha);
 
-        if (m_handle_unfocused_pm) {
-            m_handle.setBackgroundPixmap(m_handle_unfocused_pm);
+        Pixmap pm = m_state.focused ? m_grip_focused_pm : m_grip_unfocused_pm;
+        if (pm) {
+            m_grip_left.setBackgroundPixmap(pm);
+            m_grip_right.setBackgroundPixmap(pm);
         } else {
-            m_handle.setBackgroundColor(m_handle_unfocused_color);
-        }
-
-        if (m_grip_unfocused_pm) {
-            m_grip_left.setBackgroundPixmap(m_grip_unfocused_pm);
-            m_grip_right.setBackgroundPixmap(m_grip_unfocused_pm);
-        } else {
-            m_grip_left.setBackgroundColor(m_grip_unfocused_color);
-            m_grip_right.setBackgroundColor(m_grip_unfocused_color);
+            const FbTk::Color &color = m_state.focused ? m_grip_focused_color
+                                                       : m_grip_unfocused_color;
+            m_grip_left.setBackgroundColor(color);
+            m_grip_right.setBackgroundColor(color);
         }
     }
 
+    m_apply_dirty &= ~(parts & (HANDLE_PART | GRIP_PART));
 }
 
 void FbWinFrame::renderButtons() {
 
-    if (!isVisible()) {
+    if (!canRender() || m_state.fullscreen) {
         m_need_render = true;
         return;
     }
 
+    if (!needRender(BUTTON_PART, m_button_size, m_button_size))
+        return;
+
     render(theme().focusedTheme()->buttonTexture(), m_button_color,
            m_button_pm,
            m_button_size, m_button_size);
@@ -1299,6 +1518,7 @@ void FbWinFrame::renderButtons() {
 }
 
 void FbWinFrame::applyButtons() {
+    ++s_stats.applies;
     // setup left and right buttons
     for (size_t i=0; i < m_buttons_left.size(); ++i)
         applyButton(*m_buttons_left[i]);
@@ -1309,6 +1529,11 @@ void FbWinFrame::applyButtons() {
 
 void FbWinFrame::init() {
 
+    m_redraw_titlebar.setFunctor(FbTk::MemFun(*this, &FbWinFrame::drawTitlebar));
+    m_deferred_render.setFunctor(FbTk::MemFun(*this, &FbWinFrame::renderDeferred));
+    m_release_timer.fireOnce(true);
+    m_release_timer.setFunctor(FbTk::MemFun(*this, &FbWinFrame::releaseHidden));
+
     if (theme()->handleWidth() == 0)
         m_use_handle = false;
 
@@ -1366,6 +1591,7 @@ void FbWinFrame::applyButton(FbTk::Button &btn) {
 void FbWinFrame::render(const FbTk::Texture &tex, FbTk::Color &col, Pixmap &pm,
                         unsigned int w, unsigned int h, FbTk::Orientation orient) {
 
+    ++s_stats.renders;
     Pixmap tmp = pm;
     if (!tex.usePixmap()) {
         pm = None;
@@ -1379,6 +1605,39 @@ void FbWinFrame::render(const FbTk::Texture &tex, FbTk::Color &col, Pixmap &pm,
 
 }
 
+void FbWinFrame::releasePixmaps() {
+    Pixmap *pixmaps[] = {
+        &m_title_focused_pm, &m_title_unfocused_pm,
+        &m_label_focused_pm, &m_label_unfocused_pm,
+        &m_tabcontainer_focused_pm, &m_tabcontainer_unfocused_pm,
+        &m_handle_focused_pm, &m_handle_unfocused_pm,
+        &m_button_pm, &m_button_unfocused_pm, &m_button_pressed_pm,
+        &m_grip_focused_pm, &m_grip_unfocused_pm
+    };
+
+    for (size_t i = 0; i < sizeof(pixmaps) / sizeof(pixmaps[0]); ++i) {
+        if (*pixmaps[i] != None) {
+            m_imagectrl.removeImage(*pixmaps[i]);
+            *pixmaps[i] = None;
+        }
+    }
+
+    // the windows must not refer to pixmaps that may be gone, e.g. when
+    // they update their transparency
+    m_titlebar.invalidateBackground();
+    m_label.invalidateBackground();
+    m_tab_container.invalidateBackground();
+    m_handle.invalidateBackground();
+    m_grip_left.invalidateBackground();
+    m_grip_right.invalidateBackground();
+    for (size_t i = 0; i < m_buttons_left.size(); ++i)
+        m_buttons_left[i]->invalidateBackground();
+    for (size_t i = 0; i < m_buttons_right.size(); ++i)
+        m_buttons_right[i]->invalidateBackground();
+
+    m_render_dirty = m_apply_dirty = ALL_PARTS;
+}
+
 void FbWinFrame::getCurrentFocusPixmap(Pixmap &label_pm, Pixmap &title_pm,
                                        FbTk::Color &label_color, FbTk::Color &title_color) {
     if (m_state.focused) {
@@ -1405,6 +1664,8 @@ void FbWinFrame::getCurrentFocusPixmap(Pixmap &label_pm, Pixmap &title_pm,
 }
 
 void FbWinFrame::applyTabContainer() {
+    ++s_stats.applies;
+    m_apply_dirty &= ~TAB_PART;
     m_tab_container.setAlpha(getAlpha(m_state.focused));
 
     // do the parent container
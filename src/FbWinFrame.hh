@@ -34,6 +34,10 @@
 #include "FbTk/Container.hh"
 #include "FbTk/Shape.hh"
 #include "FbTk/Signal.hh"
+#include "FbTk/IdleTask.hh"
+#include "FbTk/Timer.hh"
+#include "FbTk/FbTime.hh"
+#include "FbTk/MemoryAccount.hh"
 
 #include <vector>
 #include <memory>
@@ -52,11 +56,21 @@ class Texture;
 
 /// holds a window frame with a client window
 /// (see: <a href="fluxbox_fbwinframe.png">image</a>)
-class FbWinFrame:public FbTk::EventHandler {
+class FbWinFrame:public FbTk::EventHandler,
+                 public FbTk::MemoryAccount::Reclaimable {
 public:
     // STRICTINTERNAL means it doesn't go external automatically when no titlebar
     enum TabMode { NOTSET = 0, INTERNAL = 1, EXTERNAL };
 
+    /// decoration work of all frames, see Fluxbox::dumpStats
+    struct Stats {
+        unsigned long renders; ///< pixmaps rendered
+        unsigned long applies; ///< decoration parts that got their background set
+        unsigned long frames; ///< frames that exist
+        uint64_t since; ///< FbTime::mono() when the first frame was created
+    };
+    static const Stats &stats() { return s_stats; }
+
    /// Toolbar placement on the screen
     enum TabPlacement{
         // top and bottom placement
@@ -85,6 +99,11 @@ public:
     void hide();
     void show();
     bool isVisible() const { return m_visible; }
+    /// releases the pixmaps of a hidden frame now, not after the delay
+    void reclaim();
+    /// renders the decorations of a hidden frame ahead, so showing it only
+    /// maps it. They are kept until the pixmap budget needs them
+    void prerender();
 
     void move(int x, int y);
     void resize(unsigned int width, unsigned int height);
@@ -180,6 +199,15 @@ public:
     //@}
 
     void reconfigure();
+
+    /**
+     * While rendering is deferred, frames don't render on reconfigure but
+     * when the event queue is empty or renderDeferred() gets called, so a
+     * batch of changes renders each frame once. Calls nest.
+     */
+    static void deferRendering(bool defer);
+    /// renders the frame now if it is shown and needs it
+    void renderDeferred();
     void setShapingClient(FbTk::FbWindow *win, bool always_update);
     void updateShape() { m_shape.update(); }
 
@@ -239,7 +267,9 @@ public:
     //@}
 
 private:
-    void redrawTitlebar();
+    /// schedules drawTitlebar for when the event queue is empty
+    void redrawTitlebar() { m_redraw_titlebar.schedule(); }
+    void drawTitlebar();
 
     /// reposition titlebar items
     void reconfigureTitlebar();
@@ -258,6 +288,37 @@ private:
     void render(const FbTk::Texture &tex, FbTk::Color &col, Pixmap &pm,
                 unsigned int width, unsigned int height, FbTk::Orientation orient = FbTk::ROT0);
 
+    /// hands the decoration pixmaps back to the image cache, so frames that
+    /// aren't shown don't keep them alive; the next show renders them again
+    void releasePixmaps();
+    /// releases the pixmaps, if the frame is still hidden
+    void releaseHidden();
+    /// @return true if the decorations should be rendered now
+    bool canRender() const { return m_visible || m_prerendering; }
+
+    /// parts of the decoration, as bits. A part is only rendered and applied
+    /// again when something it depends on changed.
+    enum DecorPart {
+        TITLE_PART = 1 << 0,
+        LABEL_PART = 1 << 1,
+        BUTTON_PART = 1 << 2,
+        HANDLE_PART = 1 << 3,
+        GRIP_PART = 1 << 4,
+        TAB_PART = 1 << 5,
+        NUM_PARTS = 6,
+        ALL_PARTS = (1 << NUM_PARTS) - 1
+    };
+
+    /// @return true if the pixmaps of part must be rendered for this size
+    ///         and variant, i.e. anything else the rendering depends on
+    bool needRender(DecorPart part, unsigned int width, unsigned int height,
+                    int variant = 0);
+    /// @return the parts that look different when focused
+    unsigned int focusDependentParts() const;
+    /// redraws the windows of the parts
+    void clearParts(unsigned int parts);
+    void themeChanged();
+
     //@}
 
     // these return true/false for if something changed
@@ -276,9 +337,10 @@ private:
        @name apply pixmaps depending on focus
     */
     //@{
-    void applyAll();
-    void applyTitlebar();
-    void applyHandles();
+    /// applies the parts that changed, @return the parts applied
+    unsigned int applyAll();
+    void applyTitlebar(unsigned int parts = ALL_PARTS);
+    void applyHandles(unsigned int parts = ALL_PARTS);
     void applyTabContainer(); // and label buttons
     void applyButtons(); // only called within applyTitlebar
 
@@ -318,6 +380,9 @@ private:
     //@}
 
     FbTk::Signal<> m_frame_extent_sig;
+    FbTk::IdleTask m_redraw_titlebar; ///< deferred redraw of the titlebar
+    FbTk::IdleTask m_deferred_render; ///< render held back by deferRendering
+    FbTk::Timer m_release_timer; ///< releases the pixmaps of a hidden frame
 
     typedef std::vector<FbTk::Button *> ButtonList;
     ButtonList m_buttons_left, ///< buttons to the left
@@ -328,6 +393,7 @@ private:
     bool m_use_tabs; ///< if we should use tabs (turns them off in external mode only)
     bool m_use_handle; ///< if we should use handle
     bool m_visible; ///< if we are currently showing
+    bool m_prerendering; ///< renders while hidden, see prerender()
     ///< do we use screen or window alpha settings ? (0 = window, 1 = default, 2 = default and window never set)
 
     /**
@@ -371,6 +437,14 @@ private:
     unsigned int m_active_orig_client_bw;
 
     bool m_need_render;
+    /// what the pixmaps of each part were rendered for
+    struct PartKey {
+        unsigned int width, height;
+        int variant;
+    };
+    PartKey m_part_keys[NUM_PARTS];
+    unsigned int m_render_dirty; ///< DecorParts to render regardless of size
+    unsigned int m_apply_dirty; ///< DecorParts whose windows need updating
     int m_button_size; ///< size for all titlebar buttons
     /// alpha values
     typedef FbTk::ConstObjectAccessor<int, FbWinFrameTheme> AlphaAcc;
@@ -378,6 +452,10 @@ private:
     FbTk::DefaultValue<int, AlphaAcc> m_unfocused_alpha;
 
     FbTk::Shape m_shape;
+    FbTk::SignalTracker m_signals;
+
+    static Stats s_stats;
+    static int s_defer_rendering; ///< nesting depth of deferRendering(true)
 };
 
 #endif // FBWINFRAME_HH
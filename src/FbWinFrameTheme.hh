@@ -75,7 +75,11 @@ public:
     unsigned int handleWidth() const { return *m_handle_width; }
 
     int alpha() const { return m_alpha; }
-    void setAlpha(int alpha) { m_alpha = alpha; }
+    void setAlpha(int alpha) {
+        if (alpha != m_alpha)
+            setChanged();
+        m_alpha = alpha;
+    }
 
     IconbarTheme &iconbarTheme() { return m_iconbar_theme; }
 
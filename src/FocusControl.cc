@@ -31,6 +31,8 @@
 #include "Debug.hh"
 
 #include "FbTk/EventManager.hh"
+#include "FbTk/MemFun.hh"
+#include "FbTk/RoundTrips.hh"
 
 #include <string>
 #include <iostream>
@@ -61,6 +63,21 @@ bool doSkipWindow(const Focusable &win, const ClientPattern *pat) {
     return false; // else don't skip
 }
 
+/// @return the num-th window from 'it' that may get the focus, or the
+///         last one if there are fewer
+template <typename Iterator>
+Focusable *windowNumber(Iterator it, Iterator it_end, int num,
+                        const ClientPattern *pat) {
+    Focusable *win = 0;
+    for (; num && it != it_end; ++it) {
+        if (!doSkipWindow(**it, pat) && (*it)->acceptsFocus()) {
+            --num;
+            win = *it;
+        }
+    }
+    return win;
+}
+
 } // end anonymous namespace
 
 FocusControl::FocusControl(BScreen &screen):
@@ -78,13 +95,13 @@ FocusControl::FocusControl(BScreen &screen):
                 screen.altName()+".FocusNewWindows"),
     m_focused_list(screen), m_creation_order_list(screen),
     m_focused_win_list(screen), m_creation_order_win_list(screen),
+    m_cycling_pos(0),
+    m_cycling_pat(0),
     m_cycling_list(0),
     m_was_iconic(0),
     m_cycling_last(0),
     m_ignore_mouse_x(-1), m_ignore_mouse_y(-1) {
 
-    m_cycling_window = m_focused_list.clientList().end();
-
 }
 
 void FocusControl::cycleFocus(const FocusableList &window_list,
@@ -96,37 +113,46 @@ void FocusControl::cycleFocus(const FocusableList &window_list,
             m_cycling_list = &window_list;
         m_was_iconic = 0;
         m_cycling_last = 0;
-    } else if (m_cycling_list != &window_list)
+        takeCyclingSnapshot(window_list, pat);
+    } else if (m_cycling_list != &window_list || m_cycling_pat != pat) {
         m_cycling_list = &window_list;
+        takeCyclingSnapshot(window_list, pat);
+    }
 
-    Focusables::const_iterator it_begin = window_list.clientList().begin();
-    Focusables::const_iterator it_end = window_list.clientList().end();
-
-    // too many things can go wrong with remembering this
-    m_cycling_window = find(it_begin, it_end, s_focused_window);
-    if (m_cycling_window == it_end)
-        m_cycling_window = find(it_begin, it_end, s_focused_fbwindow);
+    const size_t end = m_cycling_windows.size();
+
+    // the focus can have moved by other means since the last step
+    if (m_cycling_pos == end ||
+        (m_cycling_windows[m_cycling_pos] != s_focused_window &&
+         m_cycling_windows[m_cycling_pos] != s_focused_fbwindow)) {
+        m_cycling_pos = find(m_cycling_windows.begin(), m_cycling_windows.end(),
+                             s_focused_window) - m_cycling_windows.begin();
+        if (m_cycling_pos == end)
+            m_cycling_pos = find(m_cycling_windows.begin(), m_cycling_windows.end(),
+                                 s_focused_fbwindow) - m_cycling_windows.begin();
+    }
 
-    Focusables::const_iterator it = m_cycling_window;
+    size_t pos = m_cycling_pos;
     FluxboxWindow *fbwin = 0;
     WinClient *last_client = 0;
     WinClient *was_iconic = 0;
 
     // find the next window in the list that works
     while (true) {
-        if (cycle_reverse && it == it_begin)
-            it = it_end;
-        else if (!cycle_reverse && it == it_end)
-            it = it_begin;
+        if (cycle_reverse && pos == 0)
+            pos = end;
+        else if (!cycle_reverse && pos == end)
+            pos = 0;
         else
-            cycle_reverse ? --it : ++it;
+            cycle_reverse ? --pos : ++pos;
         // give up [do nothing] if we reach the current focused again
-        if (it == m_cycling_window)
+        if (pos == m_cycling_pos)
             return;
-        if (it == it_end)
+        if (pos == end || m_cycling_windows[pos] == 0)
             continue;
 
-        fbwin = (*it)->fbwindow();
+        Focusable &win = *m_cycling_windows[pos];
+        fbwin = win.fbwindow();
         if (!fbwin)
             continue;
 
@@ -134,11 +160,14 @@ void FocusControl::cycleFocus(const FocusableList &window_list,
         last_client = &fbwin->winClient();
         was_iconic = (fbwin->isIconic() ? last_client : 0);
 
+        if (m_cycling_skip[pos] == -1)
+            m_cycling_skip[pos] = doSkipWindow(win, m_cycling_pat);
+
         // now we actually try to focus the window
-        if (!doSkipWindow(**it, pat) && (*it)->focus())
+        if (!m_cycling_skip[pos] && win.focus())
             break;
     }
-    m_cycling_window = it;
+    m_cycling_pos = pos;
 
     // if we're still in the same fbwin, there's nothing else to do
     if (m_cycling_last && m_cycling_last->fbwindow() == fbwin)
@@ -164,21 +193,39 @@ void FocusControl::cycleFocus(const FocusableList &window_list,
 
 }
 
+void FocusControl::takeCyclingSnapshot(const FocusableList &winlist,
+                                       const ClientPattern *pat) {
+    const Focusables &list = winlist.clientList();
+    m_cycling_windows.assign(list.begin(), list.end());
+    m_cycling_skip.assign(m_cycling_windows.size(), -1);
+    m_cycling_pos = m_cycling_windows.size();
+    m_cycling_pat = pat;
+
+    // a single step doesn't need to follow the list
+    m_cycling_tracker.leaveAll();
+    if (m_cycling_list)
+        m_cycling_tracker.join(winlist.addSig(),
+                               FbTk::MemFun(*this, &FocusControl::cyclingWindowAdded));
+}
+
+void FocusControl::cyclingWindowAdded(Focusable *win) {
+    m_cycling_windows.push_back(win);
+    m_cycling_skip.push_back(-1);
+}
+
+void FocusControl::removeCyclingWindow(Focusable &win) {
+    std::vector<Focusable *>::iterator it =
+        find(m_cycling_windows.begin(), m_cycling_windows.end(), &win);
+    if (it != m_cycling_windows.end())
+        *it = 0;
+}
+
 void FocusControl::goToWindowNumber(const FocusableList &winlist, int num,
                                     const ClientPattern *pat) {
-    Focusables list = winlist.clientList();
-    if (num < 0) {
-        list.reverse();
-        num = -num;
-    }
-    Focusable *win = 0;
-    Focusables::const_iterator it = list.begin(), it_end = list.end();
-    for (; num && it != it_end; ++it) {
-        if (!doSkipWindow(**it, pat) && (*it)->acceptsFocus()) {
-            --num;
-            win = *it;
-        }
-    }
+    const Focusables &list = winlist.clientList();
+    Focusable *win = num < 0 ?
+        windowNumber(list.rbegin(), list.rend(), -num, pat) :
+        windowNumber(list.begin(), list.end(), num, pat);
     if (win) {
         win->focus();
         if (win->fbwindow())
@@ -206,6 +253,16 @@ void FocusControl::addFocusWinFront(Focusable &win) {
     m_creation_order_win_list.pushBack(win);
 }
 
+void FocusControl::setFocusOrder(const std::vector<WinClient *> &order) {
+    // last to front first
+    std::vector<WinClient *>::const_reverse_iterator it = order.rbegin();
+    for (; it != order.rend(); ++it) {
+        m_focused_list.moveToFront(**it);
+        if ((*it)->fbwindow())
+            m_focused_win_list.moveToFront(*(*it)->fbwindow());
+    }
+}
+
 // move all clients in given window to back of focused list
 void FocusControl::setFocusBack(FluxboxWindow &fbwin) {
     // do nothing if there are no windows open
@@ -231,6 +288,10 @@ void FocusControl::stopCyclingFocus() {
 
     m_cycling_last = 0;
     m_cycling_list = 0;
+    m_cycling_windows.clear();
+    m_cycling_skip.clear();
+    m_cycling_pos = 0;
+    m_cycling_tracker.leaveAll();
 
     // put currently focused window to top
     if (s_focused_window) {
@@ -318,15 +379,14 @@ void FocusControl::dirFocus(FluxboxWindow &win, FocusDir dir) {
     Workspace::Windows &wins = m_screen.currentWorkspace()->windowList();
     Workspace::Windows::iterator it = wins.begin();
     for (; it != wins.end(); ++it) {
-        if ((*it) == &win
-            || (*it)->isIconic()
-            || (*it)->isFocusHidden()
-            || !(*it)->acceptsFocus())
+        if ((*it) == &win)
             continue; // skip self
 
         // we check things against an edge, and within the bounds (draw a picture)
         int edge=0, upper=0, lower=0, oedge=0, oupper=0, olower=0;
 
+        // the geometry is cached, so rule out the windows in the wrong
+        // direction before asking about their state
         int otop = (*it)->y() + borderW,
             // 2 * border = border on each side
             obottom = (*it)->y() + (*it)->height() + borderW,
@@ -373,6 +433,15 @@ void FocusControl::dirFocus(FluxboxWindow &win, FocusDir dir) {
         if (oedge < edge)
             continue; // not in the right direction
 
+        // anything beyond the best one so far can't win
+        if (oedge - edge > weight)
+            continue;
+
+        if ((*it)->isIconic()
+            || (*it)->isFocusHidden()
+            || !(*it)->acceptsFocus())
+            continue;
+
         if (olower <= upper || oupper >= lower) {
             // outside our horz bounds, get a heavy weight penalty
             int myweight = 100000 + oedge - edge + abs(upper-oupper)+abs(lower-olower);
@@ -406,6 +475,7 @@ void FocusControl::ignoreAtPointer(bool force)
     unsigned int ignore_ui;
     Window ignore_w;
 
+    FBTK_ROUNDTRIP("FocusControl::ignoreAtPointer");
     XQueryPointer(m_screen.rootWindow().display(),
         m_screen.rootWindow().window(), &ignore_w, &ignore_w,
         &ignore_x, &ignore_y,
@@ -435,31 +505,31 @@ void FocusControl::removeClient(WinClient &client) {
     if (client.screen().isShuttingdown())
         return;
 
-    if (isCycling() && m_cycling_window != m_cycling_list->clientList().end() &&
-        *m_cycling_window == &client) {
-        m_cycling_window = m_cycling_list->clientList().end();
+    if (isCycling() && m_cycling_pos < m_cycling_windows.size() &&
+        m_cycling_windows[m_cycling_pos] == &client) {
         stopCyclingFocus();
     } else if (m_cycling_last == &client)
         m_cycling_last = 0;
+    removeCyclingWindow(client);
 
     m_focused_list.remove(client);
     m_creation_order_list.remove(client);
-    client.screen().clientListSig().emit(client.screen());
+    client.screen().clientListChanged();
 }
 
 void FocusControl::removeWindow(Focusable &win) {
     if (win.screen().isShuttingdown())
         return;
 
-    if (isCycling() && m_cycling_window != m_cycling_list->clientList().end() &&
-        *m_cycling_window == &win) {
-        m_cycling_window = m_cycling_list->clientList().end();
+    if (isCycling() && m_cycling_pos < m_cycling_windows.size() &&
+        m_cycling_windows[m_cycling_pos] == &win) {
         stopCyclingFocus();
     }
+    removeCyclingWindow(win);
 
     m_focused_win_list.remove(win);
     m_creation_order_win_list.remove(win);
-    win.screen().clientListSig().emit(win.screen());
+    win.screen().clientListChanged();
 }
 
 void FocusControl::shutdown() {
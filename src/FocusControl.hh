@@ -23,8 +23,10 @@
 #define FOCUSCONTROL_HH
 
 #include <list>
+#include <vector>
 
 #include "FbTk/Resource.hh"
+#include "FbTk/Signal.hh"
 #include "FocusableList.hh"
 
 class ClientPattern;
@@ -118,6 +120,8 @@ public:
     void addFocusWinBack(Focusable &win);
     void addFocusWinFront(Focusable &win);
     void setFocusBack(FluxboxWindow &fbwin);
+    /// puts 'order' in front of the focus lists, e.g. after a restart
+    void setFocusOrder(const std::vector<WinClient *> &order);
     /// @return main focus model
     FocusModel focusModel() const { return *m_focus_model; }
     /// @return tab focus model
@@ -155,6 +159,11 @@ public:
     static FluxboxWindow *focusedFbWindow() { return s_focused_fbwindow; }
     static WinClient *expectingFocus() { return s_expecting_focus; }
 private:
+    /// takes the windows a cycle goes through, see m_cycling_windows
+    void takeCyclingSnapshot(const FocusableList &winlist, const ClientPattern *pat);
+    void cyclingWindowAdded(Focusable *win);
+    /// takes a closed window out of the cycle
+    void removeCyclingWindow(Focusable &win);
 
     BScreen &m_screen;
 
@@ -169,7 +178,17 @@ private:
     FocusableList m_focused_win_list;
     FocusableList m_creation_order_win_list;
 
-    Focusables::const_iterator m_cycling_window;
+    /**
+     * The windows of the cycling list when the cycle started, so the order
+     * stays the same and each step only tests the windows it passes.
+     * Closed windows are set to 0, new ones are added at the end.
+     */
+    std::vector<Focusable *> m_cycling_windows;
+    /// whether the cycle skips each window, -1 until it is tested
+    std::vector<int> m_cycling_skip;
+    size_t m_cycling_pos; ///< the current window, or the end if none
+    const ClientPattern *m_cycling_pat;
+    FbTk::SignalTracker m_cycling_tracker;
     const FocusableList *m_cycling_list;
     Focusable *m_was_iconic;
     WinClient *m_cycling_last;
@@ -42,6 +42,29 @@
 using std::string;
 using std::vector;
 
+namespace {
+
+typedef ClientPattern CP;
+
+// the properties a window's state and layer signals can change
+const unsigned int STATE_PROPERTIES =
+    CP::propertyBit(CP::MAXIMIZED) | CP::propertyBit(CP::MINIMIZED) |
+    CP::propertyBit(CP::SHADED) | CP::propertyBit(CP::STUCK) |
+    CP::propertyBit(CP::FOCUSHIDDEN) | CP::propertyBit(CP::ICONHIDDEN) |
+    CP::propertyBit(CP::URGENT) | CP::propertyBit(CP::LAYER);
+const unsigned int LAYER_PROPERTIES = CP::propertyBit(CP::LAYER);
+const unsigned int WORKSPACE_PROPERTIES =
+    CP::propertyBit(CP::WORKSPACE) | CP::propertyBit(CP::WORKSPACENAME) |
+    CP::propertyBit(CP::STUCK);
+// the title signal stays for everything that has no signal of its own
+const unsigned int TITLE_PROPERTIES =
+    CP::propertyBit(CP::TITLE) | CP::propertyBit(CP::CLASS) |
+    CP::propertyBit(CP::NAME) | CP::propertyBit(CP::ROLE) |
+    CP::propertyBit(CP::TRANSIENT) | CP::propertyBit(CP::HEAD) |
+    CP::propertyBit(CP::SCREEN) | CP::propertyBit(CP::XPROP);
+
+} // end anonymous namespace
+
 void FocusableList::parseArgs(const string &in, int &opts, string &pat) {
     string options;
     int err = FbTk::StringUtil::getStringBetween(options, in.c_str(), '{', '}',
@@ -151,7 +174,7 @@ void FocusableList::parentWindowRemoved(Focusable *win) {
 void FocusableList::checkUpdate(Focusable &win) {
     if (contains(win)) {
         if (!m_pat->match(win)) {
-            m_list.remove(&win);
+            erase(win);
             m_pat->removeMatch();
             m_removesig.emit(&win);
         }
@@ -164,7 +187,7 @@ void FocusableList::checkUpdate(Focusable &win) {
 
 // returns whether or not the window was moved
 bool FocusableList::insertFromParent(Focusable &win) {
-    const Focusables list = m_parent->clientList();
+    const Focusables &list = m_parent->clientList();
     Focusables::const_iterator p_it = list.begin(), p_it_end = list.end();
     Focusables::iterator our_it = m_list.begin(), our_it_end = m_list.end();
     // walk through our list looking for corresponding entries in
@@ -173,15 +196,30 @@ bool FocusableList::insertFromParent(Focusable &win) {
         if (*p_it == &win) {
             if (*our_it == &win) // win didn't move in our list
                 return false;
-            m_list.remove(&win);
-            m_list.insert(our_it, &win);
+            insertBefore(our_it, win);
             return true;
         }
         if (*p_it == *our_it)
             ++our_it;
     }
-    m_list.remove(&win);
-    m_list.push_back(&win);
+    insertBefore(m_list.end(), win);
+    return true;
+}
+
+void FocusableList::insertBefore(Focusables::iterator pos, Focusable &win) {
+    Positions::iterator it = m_positions.find(&win);
+    if (it == m_positions.end())
+        m_positions[&win] = m_list.insert(pos, &win);
+    else if (it->second != pos)
+        m_list.splice(pos, m_list, it->second);
+}
+
+bool FocusableList::erase(Focusable &win) {
+    Positions::iterator it = m_positions.find(&win);
+    if (it == m_positions.end())
+        return false;
+    m_list.erase(it->second);
+    m_positions.erase(it);
     return true;
 }
 
@@ -189,11 +227,11 @@ void FocusableList::addMatching() {
     if (!m_parent)
         return;
 
-    const Focusables list = m_parent->clientList();
+    const Focusables &list = m_parent->clientList();
     Focusables::const_iterator it = list.begin(), it_end = list.end();
     for (; it != it_end; ++it) {
         if (m_pat->match(**it)) {
-            m_list.push_back(*it);
+            insertBefore(m_list.end(), **it);
             m_pat->addMatch();
         }
         attachSignals(**it);
@@ -201,13 +239,13 @@ void FocusableList::addMatching() {
 }
 
 void FocusableList::pushFront(Focusable &win) {
-    m_list.push_front(&win);
+    insertBefore(m_list.begin(), win);
     attachSignals(win);
     m_addsig.emit(&win);
 }
 
 void FocusableList::pushBack(Focusable &win) {
-    m_list.push_back(&win);
+    insertBefore(m_list.end(), win);
     attachSignals(win);
     m_addsig.emit(&win);
 }
@@ -217,8 +255,7 @@ void FocusableList::moveToFront(Focusable &win) {
     if (!contains(win))
         return;
 
-    m_list.remove(&win);
-    m_list.push_front(&win);
+    insertBefore(m_list.begin(), win);
     m_ordersig.emit(&win);
 }
 
@@ -227,20 +264,16 @@ void FocusableList::moveToBack(Focusable &win) {
     if (!contains(win))
         return;
 
-    m_list.remove(&win);
-    m_list.push_back(&win);
+    insertBefore(m_list.end(), win);
     m_ordersig.emit(&win);
 }
 
 void FocusableList::remove(Focusable &win) {
     // if the window isn't already in this list, we could send a bad signal
-    bool contained = contains(win);
-
     m_signal_map.erase(&win);
-    if (!contained) {
+    if (!erase(win)) {
         return;
     }
-    m_list.remove(&win);
     m_removesig.emit(&win);
 }
 
@@ -260,12 +293,17 @@ void FocusableList::attachSignals(Focusable &win) {
     if (! tracker) {
         // we have not attached to this window yet
         tracker.reset(new SignalTracker);
-        tracker->join(win.titleSig(), MemFunSelectArg1(*this, &FocusableList::updateTitle));
+        // only the signals that can change whether the pattern matches
+        if (m_pat->dependsOn(TITLE_PROPERTIES))
+            tracker->join(win.titleSig(), MemFunSelectArg1(*this, &FocusableList::updateTitle));
         tracker->join(win.dieSig(), MemFun(*this, &FocusableList::remove));
         if(fbwin) {
-            tracker->join(fbwin->workspaceSig(), MemFun(*this, &FocusableList::windowUpdated));
-            tracker->join(fbwin->stateSig(), MemFun(*this, &FocusableList::windowUpdated));
-            tracker->join(fbwin->layerSig(), MemFun(*this, &FocusableList::windowUpdated));
+            if (m_pat->dependsOn(WORKSPACE_PROPERTIES))
+                tracker->join(fbwin->workspaceSig(), MemFun(*this, &FocusableList::windowUpdated));
+            if (m_pat->dependsOn(STATE_PROPERTIES))
+                tracker->join(fbwin->stateSig(), MemFun(*this, &FocusableList::windowUpdated));
+            if (m_pat->dependsOn(LAYER_PROPERTIES))
+                tracker->join(fbwin->layerSig(), MemFun(*this, &FocusableList::windowUpdated));
             // TODO: can't watch (head=...) yet
         }
     }
@@ -274,6 +312,7 @@ void FocusableList::attachSignals(Focusable &win) {
 void FocusableList::reset() {
     m_signal_map.clear();
     m_list.clear();
+    m_positions.clear();
     m_pat->resetMatches();
     if (m_parent)
         addMatching();
@@ -281,9 +320,7 @@ void FocusableList::reset() {
 }
 
 bool FocusableList::contains(const Focusable &win) const {
-    Focusables::const_iterator it = m_list.begin(), it_end = m_list.end();
-    it = std::find(it, it_end, &win);
-    return (it != it_end);
+    return m_positions.find(const_cast<Focusable *>(&win)) != m_positions.end();
 }
 
 Focusable *FocusableList::find(const ClientPattern &pat) const {
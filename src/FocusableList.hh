@@ -29,6 +29,7 @@
 #include "ClientPattern.hh"
 
 #include <list>
+#include <map>
 #include <string>
 #include <memory>
 
@@ -63,7 +64,7 @@ public:
     void moveToBack(Focusable &win);
     void remove(Focusable &win);
 
-    /// accessor for list
+    /// accessor for list, only change it through the functions above
     Focusables &clientList() { return m_list; }
     const Focusables &clientList() const { return m_list; }
 
@@ -100,12 +101,18 @@ private:
     void parentWindowAdded(Focusable* win);
     void parentWindowRemoved(Focusable* win);
     void windowUpdated(FluxboxWindow &fbwin);
+    /// moves or inserts @win before @pos
+    void insertBefore(Focusables::iterator pos, Focusable &win);
+    /// @return false if @win wasn't in the list
+    bool erase(Focusable &win);
 
 
     std::auto_ptr<ClientPattern> m_pat;
     const FocusableList *m_parent;
     BScreen &m_screen;
     std::list<Focusable *> m_list;
+    typedef std::map<Focusable *, Focusables::iterator> Positions;
+    Positions m_positions; ///< where each window is in m_list
 
     FbTk::Signal<Focusable *> m_ordersig, m_addsig, m_removesig;
     FbTk::Signal<> m_resetsig;
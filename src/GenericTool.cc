@@ -22,6 +22,7 @@
 #include "GenericTool.hh"
 #include "FbTk/FbWindow.hh"
 #include "FbTk/MemFun.hh"
+#include "FbTk/RequestStats.hh"
 #include "ToolTheme.hh"
 
 #include <string>
@@ -77,6 +78,7 @@ unsigned int GenericTool::borderWidth() const {
 }
 
 void GenericTool::renderTheme(int alpha) {
+    FbTk::RequestStats::Widget widget(typeid(*this));
     m_window->setAlpha(alpha);
     m_window->clear();
 }
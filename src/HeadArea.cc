@@ -30,7 +30,8 @@ HeadArea::HeadArea() : m_available_workspace_area(new Strut(0,0,0,0,0)) {
 
 Strut *HeadArea::requestStrut(int head, int left, int right, int top, int bottom, Strut* next) {
     Strut *str = new Strut(head, left, right, top, bottom, next);
-    m_strutlist.push_back(str);
+    m_struts.insert(str);
+    updateSizes(*str, true);
     return str;
 }
 
@@ -38,50 +39,47 @@ void HeadArea::clearStrut(Strut *str) {
     if (str == 0)
         return;
     // find strut and erase it
-    std::list<Strut *>::iterator pos = std::find(m_strutlist.begin(),
-                                                 m_strutlist.end(),
-                                                 str);
-    if (pos == m_strutlist.end()) {
+    if (m_struts.erase(str) == 0) {
         std::cerr << "clearStrut() failed because the strut was not found" << std::endl;
         return;
     }
 
-    m_strutlist.erase(pos);
+    updateSizes(*str, false);
     delete str;
 }
 
-/// helper class for for_each in HeadArea::updateAvailableWorkspaceArea()
 namespace {
-class MaxArea {
-public:
-    MaxArea(Strut &max_area):m_available_workspace_area(max_area) { }
-    void operator ()(const Strut *str) {
-        static int left, right, bottom, top;
-        left = std::max(m_available_workspace_area.left(), str->left());
-        right = std::max(m_available_workspace_area.right(), str->right());
-        bottom = std::max(m_available_workspace_area.bottom(), str->bottom());
-        top = std::max(m_available_workspace_area.top(), str->top());
-        m_available_workspace_area = Strut(0, left, right, top, bottom);
-    }
-private:
-    Strut &m_available_workspace_area;
-};
+
+void updateSize(std::multiset<int> &sizes, int size, bool add) {
+    if (add)
+        sizes.insert(size);
+    else
+        sizes.erase(sizes.find(size));
+}
+
+int maxSize(const std::multiset<int> &sizes) {
+    return sizes.empty() ? 0 : std::max(0, *sizes.rbegin());
+}
 
 } // end anonymous namespace
 
-bool HeadArea::updateAvailableWorkspaceArea() {
-    // find max of left, right, top and bottom and set avaible workspace area
+void HeadArea::updateSizes(const Strut &str, bool add) {
+    updateSize(m_left, str.left(), add);
+    updateSize(m_right, str.right(), add);
+    updateSize(m_top, str.top(), add);
+    updateSize(m_bottom, str.bottom(), add);
+}
 
-    // clear old area
-    Strut oldarea = *(m_available_workspace_area.get());
-    m_available_workspace_area.reset(new Strut(0, 0, 0, 0, 0));
-    
-    // calculate max area
-    std::for_each(m_strutlist.begin(),
-             m_strutlist.end(),
-             MaxArea(*m_available_workspace_area.get()));
+bool HeadArea::updateAvailableWorkspaceArea() {
+    // the max of left, right, top and bottom is the available workspace
+    // area, the sizes are kept sorted as struts come and go
+    Strut area(0, maxSize(m_left), maxSize(m_right),
+               maxSize(m_top), maxSize(m_bottom));
 
     // only notify if the area changed
-    return !(oldarea == *(m_available_workspace_area.get()));
-}
+    if (area == *(m_available_workspace_area.get()))
+        return false;
 
+    *m_available_workspace_area = area;
+    return true;
+}
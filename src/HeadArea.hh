@@ -24,7 +24,7 @@
 
 #include "FbTk/NotCopyable.hh"
 #include <memory>
-#include <list>
+#include <set>
 
 class Strut;
 
@@ -40,8 +40,15 @@ public:
     }
 
 private:
+    typedef std::multiset<int> Sizes;
+
+    /// adds (or removes) the sides of @str to the ones the area is made of
+    void updateSizes(const Strut &str, bool add);
+
     std::auto_ptr<Strut> m_available_workspace_area;
-    std::list<Strut*> m_strutlist;
+    std::set<Strut*> m_struts;
+    /// the sizes of all struts for each side, the largest one counts
+    Sizes m_left, m_right, m_top, m_bottom;
 };
 
 #endif // HEADAREA_HH
@@ -0,0 +1,106 @@
+// HeadMap.cc
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "HeadMap.hh"
+
+#include <algorithm>
+
+namespace {
+
+void makeUnique(std::vector<int> &values) {
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+}
+
+} // end anonymous namespace
+
+HeadMap::HeadMap() {
+    clear();
+}
+
+void HeadMap::clear() {
+    m_heads.clear();
+    m_xs.clear();
+    m_ys.clear();
+    m_cells.clear();
+    // an empty cell never matches
+    m_last.left = m_last.top = m_last.right = m_last.bottom = 0;
+    m_last.head = 0;
+}
+
+void HeadMap::add(int x, int y, int width, int height) {
+    Head head = { x, y, width, height };
+    m_heads.push_back(head);
+}
+
+void HeadMap::build() {
+    m_xs.clear();
+    m_ys.clear();
+    for (size_t h = 0; h < m_heads.size(); ++h) {
+        m_xs.push_back(m_heads[h].x);
+        m_xs.push_back(m_heads[h].x + m_heads[h].width);
+        m_ys.push_back(m_heads[h].y);
+        m_ys.push_back(m_heads[h].y + m_heads[h].height);
+    }
+    makeUnique(m_xs);
+    makeUnique(m_ys);
+
+    // no head has an edge inside a cell, so the corner tells for the cell
+    const size_t ny = m_ys.size();
+    m_cells.assign(m_xs.size() * ny, 0);
+    for (size_t i = 0; i + 1 < m_xs.size(); ++i) {
+        for (size_t j = 0; j + 1 < ny; ++j) {
+            for (size_t h = 0; h < m_heads.size(); ++h) {
+                const Head &head = m_heads[h];
+                if (m_xs[i] >= head.x && m_xs[i] < head.x + head.width &&
+                    m_ys[j] >= head.y && m_ys[j] < head.y + head.height) {
+                    m_cells[i * ny + j] = h + 1;
+                    break;
+                }
+            }
+        }
+    }
+
+    m_last.left = m_last.top = m_last.right = m_last.bottom = 0;
+    m_last.head = 0;
+}
+
+int HeadMap::find(int x, int y) const {
+    if (x >= m_last.left && x < m_last.right &&
+        y >= m_last.top && y < m_last.bottom)
+        return m_last.head;
+
+    if (m_xs.empty() || x < m_xs.front() || x >= m_xs.back() ||
+        y < m_ys.front() || y >= m_ys.back())
+        return 0;
+
+    size_t i = std::upper_bound(m_xs.begin(), m_xs.end(), x) - m_xs.begin() - 1;
+    size_t j = std::upper_bound(m_ys.begin(), m_ys.end(), y) - m_ys.begin() - 1;
+
+    m_last.left = m_xs[i];
+    m_last.right = m_xs[i + 1];
+    m_last.top = m_ys[j];
+    m_last.bottom = m_ys[j + 1];
+    m_last.head = m_cells[i * m_ys.size() + j];
+
+    return m_last.head;
+}
@@ -0,0 +1,63 @@
+// HeadMap.hh
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#ifndef HEADMAP_HH
+#define HEADMAP_HH
+
+#include <vector>
+
+/**
+ * Finds the head at a point without going through all heads: the head
+ * edges split the screen into cells, and each cell knows its head.
+ * The cell of the last lookup is kept, since lookups tend to come in runs
+ * for the same area.
+ */
+class HeadMap {
+public:
+    HeadMap();
+
+    void clear();
+    /// adds the next head, where heads overlap the one added first wins
+    void add(int x, int y, int width, int height);
+    /// makes the cells, call after adding all heads
+    void build();
+
+    /// @return the number of the head at x, y starting from 1, or 0 for none
+    int find(int x, int y) const;
+
+private:
+    struct Head {
+        int x, y, width, height;
+    };
+
+    std::vector<Head> m_heads;
+    std::vector<int> m_xs, m_ys; ///< the sorted distinct head edges
+    std::vector<int> m_cells; ///< head of the cell right and below m_xs[i], m_ys[j]
+
+    struct Cell {
+        int left, top, right, bottom;
+        int head;
+    };
+    mutable Cell m_last; ///< the cell of the last lookup
+};
+
+#endif // HEADMAP_HH
@@ -29,8 +29,12 @@
 #include "FbTk/App.hh"
 #include "FbTk/Command.hh"
 #include "FbTk/EventManager.hh"
+#include "FbTk/IconCache.hh"
 #include "FbTk/ImageControl.hh"
+#include "FbTk/MemoryAccount.hh"
+#include "FbTk/RequestStats.hh"
 #include "FbTk/TextUtils.hh"
+#include "FbTk/Texture.hh"
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -53,7 +57,10 @@ IconButton::IconButton(const FbTk::FbWindow &parent,
     m_use_pixmap(true),
     m_has_tooltip(false),
     m_theme(win, focused_theme, unfocused_theme),
-    m_pm(win.screen().imageControl()) {
+    m_pm(win.screen().imageControl()),
+    m_backgrounds(0) {
+
+    m_title_update.setFunctor(FbTk::MemFun(*this, &IconButton::updateTitle));
 
     m_signals.join(m_win.titleSig(),
                    MemFunIgnoreArgs(*this, &IconButton::clientTitleChanged));
@@ -96,6 +103,8 @@ void IconButton::leaveNotifyEvent(XCrossingEvent &ev) {
 
 void IconButton::moveResize(int x, int y,
                             unsigned int width, unsigned int height) {
+    FbTk::MemoryAccount::Scope account(FbTk::MemoryAccount::IN_ICONBAR, &m_win);
+    FbTk::RequestStats::Widget widget(typeid(*this));
 
     FbTk::TextButton::moveResize(x, y, width, height);
 
@@ -107,6 +116,8 @@ void IconButton::moveResize(int x, int y,
 }
 
 void IconButton::resize(unsigned int width, unsigned int height) {
+    FbTk::MemoryAccount::Scope account(FbTk::MemoryAccount::IN_ICONBAR, &m_win);
+    FbTk::RequestStats::Widget widget(typeid(*this));
     FbTk::TextButton::resize(width, height);
     if (m_icon_window.width() != FbTk::Button::width() ||
         m_icon_window.height() != FbTk::Button::height()) {
@@ -145,18 +156,26 @@ void IconButton::setPixmap(bool use) {
 }
 
 void IconButton::reconfigTheme() {
+    FbTk::MemoryAccount::Scope account(FbTk::MemoryAccount::IN_ICONBAR, &m_win);
+    FbTk::RequestStats::Widget widget(typeid(*this));
 
-    if (m_theme->texture().usePixmap())
+    Pixmap pm = None;
+    if (m_theme->texture().usePixmap() && m_backgrounds) {
+        m_pm.reset(0);
+        pm = m_backgrounds->get(m_theme->texture(), width(), height(),
+                                orientation());
+    } else if (m_theme->texture().usePixmap()) {
         m_pm.reset(m_win.screen().imageControl().renderImage(
                            width(), height(), m_theme->texture(),
                            orientation()));
-    else
+        pm = m_pm;
+    } else
         m_pm.reset(0);
 
     setAlpha(parent()->alpha());
 
-    if (m_pm != 0)
-        setBackgroundPixmap(m_pm);
+    if (pm != 0)
+        setBackgroundPixmap(pm);
     else
         setBackgroundColor(m_theme->texture().color());
 
@@ -176,6 +195,8 @@ void IconButton::reconfigAndClear() {
 }
 
 void IconButton::refreshEverything(bool setup) {
+    FbTk::MemoryAccount::Scope account(FbTk::MemoryAccount::IN_ICONBAR, &m_win);
+    FbTk::RequestStats::Widget widget(typeid(*this));
 
     Display *display = FbTk::App::instance()->display();
     int screen = m_win.screen().screenNumber();
@@ -201,13 +222,25 @@ void IconButton::refreshEverything(bool setup) {
 
         m_icon_window.moveResize(iconx, icony, neww, newh);
 
-        m_icon_pixmap.copy(m_win.icon().pixmap().drawable(),
-                           DefaultDepth(display, screen), screen);
-        m_icon_pixmap.scale(m_icon_window.width(), m_icon_window.height());
-
-        // rotate the icon or not?? lets go not for now, and see what they say...
-        // need to rotate mask too if we do do this
-        m_icon_pixmap.rotate(orientation());
+        // windows showing the same icon share its scaled versions
+        m_icon_source = FbTk::IconCache::instance().scaled(m_win.icon(),
+                                                           m_icon_window.width(),
+                                                           m_icon_window.height());
+        if (m_icon_source && orientation() == FbTk::ROT0) {
+            m_icon_pixmap.share(m_icon_source->pixmap());
+        } else {
+            if (m_icon_source) {
+                m_icon_pixmap.copy(m_icon_source->pixmap());
+            } else {
+                m_icon_pixmap.copy(m_win.icon().pixmap().drawable(),
+                                   DefaultDepth(display, screen), screen);
+                m_icon_pixmap.scale(m_icon_window.width(), m_icon_window.height());
+            }
+
+            // rotate the icon or not?? lets go not for now, and see what they say...
+            // need to rotate mask too if we do do this
+            m_icon_pixmap.rotate(orientation());
+        }
 
         m_icon_window.setBackgroundPixmap(m_icon_pixmap.drawable());
     } else {
@@ -215,12 +248,21 @@ void IconButton::refreshEverything(bool setup) {
         m_icon_window.move(0, 0);
         m_icon_window.hide();
         m_icon_pixmap = 0;
+        m_icon_source = FbTk::RefCount<FbTk::PixmapWithMask>();
     }
 
     if(m_icon_pixmap.drawable() && m_win.icon().mask().drawable() != None) {
-        m_icon_mask.copy(m_win.icon().mask().drawable(), 0, 0);
-        m_icon_mask.scale(m_icon_pixmap.width(), m_icon_pixmap.height());
-        m_icon_mask.rotate(orientation());
+        if (m_icon_source && orientation() == FbTk::ROT0) {
+            m_icon_mask.share(m_icon_source->mask());
+        } else {
+            if (m_icon_source) {
+                m_icon_mask.copy(m_icon_source->mask());
+            } else {
+                m_icon_mask.copy(m_win.icon().mask().drawable(), 0, 0);
+                m_icon_mask.scale(m_icon_pixmap.width(), m_icon_pixmap.height());
+            }
+            m_icon_mask.rotate(orientation());
+        }
     } else
         m_icon_mask = 0;
 
@@ -245,6 +287,11 @@ void IconButton::refreshEverything(bool setup) {
 }
 
 void IconButton::clientTitleChanged() {
+    // some clients change their title many times in a row
+    m_title_update.schedule();
+}
+
+void IconButton::updateTitle() {
     refreshEverything(true);
 
     if (m_has_tooltip)
@@ -282,3 +329,63 @@ bool IconButton::setOrientation(FbTk::Orientation orient) {
     }
 }
 
+
+IconButtonBackgrounds::~IconButtonBackgrounds() {
+    Entries::iterator it = m_entries.begin();
+    for (; it != m_entries.end(); ++it)
+        m_ctrl.removeImage(it->second.pixmap);
+}
+
+bool IconButtonBackgrounds::Key::operator < (const Key &other) const {
+    if (texture_pixmap != other.texture_pixmap)
+        return texture_pixmap < other.texture_pixmap;
+    if (pixel1 != other.pixel1)
+        return pixel1 < other.pixel1;
+    if (pixel2 != other.pixel2)
+        return pixel2 < other.pixel2;
+    if (type != other.type)
+        return type < other.type;
+    if (width != other.width)
+        return width < other.width;
+    if (height != other.height)
+        return height < other.height;
+    return orient < other.orient;
+}
+
+Pixmap IconButtonBackgrounds::get(const FbTk::Texture &texture,
+                                  unsigned int width, unsigned int height,
+                                  FbTk::Orientation orient) {
+    // what the texture looks like, the theme may reload the same object
+    Key key;
+    key.texture_pixmap = texture.pixmap().drawable();
+    key.pixel1 = key.pixel2 = 0;
+    if (key.texture_pixmap == None) {
+        key.pixel1 = texture.color().pixel();
+        if (texture.type() & FbTk::Texture::GRADIENT)
+            key.pixel2 = texture.colorTo().pixel();
+    }
+    key.type = texture.type();
+    key.width = width;
+    key.height = height;
+    key.orient = orient;
+
+    Entries::iterator it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        Entry entry;
+        entry.pixmap = m_ctrl.renderImage(width, height, texture, orient);
+        it = m_entries.insert(Entries::value_type(key, entry)).first;
+    }
+    it->second.pass = m_pass;
+    return it->second.pixmap;
+}
+
+void IconButtonBackgrounds::endPass() {
+    Entries::iterator it = m_entries.begin();
+    while (it != m_entries.end()) {
+        if (it->second.pass != m_pass) {
+            m_ctrl.removeImage(it->second.pixmap);
+            m_entries.erase(it++);
+        } else
+            ++it;
+    }
+}
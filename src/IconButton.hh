@@ -28,15 +28,62 @@
 #include "FbTk/CachedPixmap.hh"
 #include "FbTk/FbPixmap.hh"
 #include "FbTk/TextButton.hh"
+#include "FbTk/NotCopyable.hh"
+#include "FbTk/ObjectPool.hh"
 #include "FbTk/Signal.hh"
+#include "FbTk/IdleTask.hh"
+#include "FbTk/PixmapWithMask.hh"
+#include "FbTk/RefCount.hh"
+
+#include <map>
 
 class IconbarTheme;
 
 namespace FbTk {
 template <class T> class ThemeProxy;
+class ImageControl;
+class Texture;
 }
 
-class IconButton: public FbTk::TextButton {
+/// the backgrounds of the buttons of one iconbar, each texture rendered
+/// once per size and shared by all buttons showing it
+class IconButtonBackgrounds: private FbTk::NotCopyable {
+public:
+    explicit IconButtonBackgrounds(FbTk::ImageControl &ctrl):
+        m_ctrl(ctrl), m_pass(0) { }
+    ~IconButtonBackgrounds();
+
+    Pixmap get(const FbTk::Texture &texture, unsigned int width,
+               unsigned int height, FbTk::Orientation orient);
+
+    /// all buttons get their backgrounds again until endPass()
+    void startPass() { ++m_pass; }
+    /// releases the backgrounds no button asked for since startPass()
+    void endPass();
+
+private:
+    struct Key {
+        bool operator < (const Key &other) const;
+
+        Pixmap texture_pixmap;
+        unsigned long pixel1, pixel2;
+        int type;
+        unsigned int width, height;
+        FbTk::Orientation orient;
+    };
+    struct Entry {
+        Pixmap pixmap;
+        unsigned int pass; ///< when it was last asked for
+    };
+    typedef std::map<Key, Entry> Entries;
+
+    FbTk::ImageControl &m_ctrl;
+    Entries m_entries;
+    unsigned int m_pass;
+};
+
+class IconButton: public FbTk::TextButton,
+                  public FbTk::Pooled<IconButton> {
 public:
     IconButton(const FbTk::FbWindow &parent,
                FbTk::ThemeProxy<IconbarTheme> &focused_theme,
@@ -58,6 +105,8 @@ public:
     void reconfigTheme();
 
     void setPixmap(bool use);
+    /// share the backgrounds with other buttons, 0 to render our own
+    void setBackgrounds(IconButtonBackgrounds *backgrounds) { m_backgrounds = backgrounds; }
 
     Focusable &win() { return m_win; }
     const Focusable &win() const { return m_win; }
@@ -76,11 +125,15 @@ private:
     void refreshEverything(bool setup);
     /// Called when client title changed.
     void clientTitleChanged();
+    /// Redraws the title, deferred by clientTitleChanged
+    void updateTitle();
 
     Focusable &m_win;
     FbTk::FbWindow m_icon_window;
     FbTk::FbPixmap m_icon_pixmap;
     FbTk::FbPixmap m_icon_mask;
+    /// the cached icon m_icon_pixmap and m_icon_mask may share
+    FbTk::RefCount<FbTk::PixmapWithMask> m_icon_source;
     bool m_use_pixmap;
     /// whether or not this instance has the tooltip attention 
     /// i.e if it got enter notify
@@ -88,7 +141,10 @@ private:
     FocusableTheme<IconbarTheme> m_theme;
     // cached pixmaps
     FbTk::CachedPixmap m_pm;
+    IconButtonBackgrounds *m_backgrounds;
     FbTk::SignalTracker m_signals;
+    /// coalesces title changes into one redraw when idle
+    FbTk::IdleTask m_title_update;
 };
 
 #endif // ICONBUTTON_HH
@@ -45,6 +45,8 @@
 #include "FbTk/RefCount.hh"
 #include "FbTk/SimpleCommand.hh"
 #include "FbTk/ImageControl.hh"
+#include "FbTk/MemoryAccount.hh"
+#include "FbTk/RequestStats.hh"
 #include "FbTk/MacroCommand.hh"
 #include "FbTk/MenuSeparator.hh"
 #include "FbTk/Util.hh"
@@ -253,6 +255,7 @@ IconbarTool::IconbarTool(const FbTk::FbWindow &parent, IconbarTheme &theme,
     m_focused_theme(focused_theme),
     m_unfocused_theme(unfocused_theme),
     m_empty_pm( screen.imageControl() ),
+    m_backgrounds(screen.imageControl()),
     m_winlist(new FocusableList(screen)),
     m_mode("none"),
     m_rc_mode(screen.resourceManager(), "{static groups} (workspace)",
@@ -269,6 +272,8 @@ IconbarTool::IconbarTool(const FbTk::FbWindow &parent, IconbarTheme &theme,
            *screen.layerManager().getLayer(ResourceLayer::MENU)),
     m_alpha(255) {
 
+    m_relayout.setFunctor(FbTk::MemFun(*this, &IconbarTool::updateLayout));
+
     // setup mode menu
     setupModeMenu(m_menu, *this);
     _FB_USES_NLS;
@@ -308,16 +313,28 @@ void IconbarTool::move(int x, int y) {
 }
 
 void IconbarTool::resize(unsigned int width, unsigned int height) {
-    m_icon_container.resize(width, height);
-    m_icon_container.setMaxTotalSize(m_icon_container.orientation() == FbTk::ROT0 || m_icon_container.orientation() == FbTk::ROT180 ? width : height);
-    renderTheme();
+    if (m_icon_container.width() == width && m_icon_container.height() == height)
+        return;
+    // just the window, the buttons follow when idle
+    m_icon_container.FbTk::FbWindow::resize(width, height);
+    m_relayout.schedule();
 }
 
 void IconbarTool::moveResize(int x, int y,
                              unsigned int width, unsigned int height) {
 
-    m_icon_container.moveResize(x, y, width, height);
-    m_icon_container.setMaxTotalSize(m_icon_container.orientation() == FbTk::ROT0 || m_icon_container.orientation() == FbTk::ROT180 ? width : height);
+    if (m_icon_container.width() == width && m_icon_container.height() == height) {
+        m_icon_container.move(x, y);
+        return;
+    }
+    m_icon_container.FbTk::FbWindow::moveResize(x, y, width, height);
+    m_relayout.schedule();
+}
+
+void IconbarTool::updateLayout() {
+    m_icon_container.update();
+    m_icon_container.setMaxTotalSize(m_icon_container.orientation() == FbTk::ROT0 || m_icon_container.orientation() == FbTk::ROT180 ?
+                                     m_icon_container.width() : m_icon_container.height());
     renderTheme();
 }
 
@@ -392,6 +409,7 @@ void IconbarTool::themeReconfigured() {
 }
 
 void IconbarTool::update(UpdateReason reason, Focusable *win) {
+    FbTk::RequestStats::Widget widget(typeid(*this));
     // ignore updates if we're shutting down
     if (m_screen.isShuttingdown()) {
         if (!m_icons.empty())
@@ -461,11 +479,36 @@ void IconbarTool::insertWindow(Focusable &win, int pos) {
 }
 
 void IconbarTool::reset() {
-    deleteIcons();
-    updateList();
+    // only the windows that entered or left the list get or lose a button
+    IconMap old_icons;
+    old_icons.swap(m_icons);
+
+    FbTk::Container::ItemList buttons;
+    list<Focusable *>::iterator it = m_winlist->clientList().begin();
+    list<Focusable *>::iterator it_end = m_winlist->clientList().end();
+    for (; it != it_end; ++it) {
+        if (!(*it)->fbwindow())
+            continue;
+
+        IconButton *button = 0;
+        IconMap::iterator icon_it = old_icons.find(*it);
+        if (icon_it != old_icons.end()) {
+            button = icon_it->second;
+            m_icons.insert(*icon_it);
+            old_icons.erase(icon_it);
+        } else
+            button = makeButton(**it);
+        if (button)
+            buttons.push_back(button);
+    }
+
+    m_icon_container.setItems(buttons);
+    FbTk::STLUtil::destroyAndClearSecond(old_icons);
 }
 
 void IconbarTool::updateSizing() {
+    FbTk::MemoryAccount::Scope account(FbTk::MemoryAccount::IN_ICONBAR);
+    FbTk::RequestStats::Widget widget(typeid(*this));
     m_icon_container.setBorderWidth(m_theme.border().width());
     m_icon_container.setBorderColor(m_theme.border().color());
 
@@ -476,12 +519,16 @@ void IconbarTool::updateSizing() {
 }
 
 void IconbarTool::renderTheme(int alpha) {
+    FbTk::MemoryAccount::Scope account(FbTk::MemoryAccount::IN_ICONBAR);
+    FbTk::RequestStats::Widget widget(typeid(*this));
 
     m_alpha = alpha;
     renderTheme();
 }
 
 void IconbarTool::renderTheme() {
+    FbTk::MemoryAccount::Scope account(FbTk::MemoryAccount::IN_ICONBAR);
+    FbTk::RequestStats::Widget widget(typeid(*this));
 
     // update button sizes before we get max width per client!
     updateSizing();
@@ -500,11 +547,13 @@ void IconbarTool::renderTheme() {
 
     m_icon_container.setAlpha(m_alpha);
 
-    // update buttons
+    // update buttons, each background is rendered once for all of them
+    m_backgrounds.startPass();
     IconMap::iterator icon_it = m_icons.begin();
     const IconMap::iterator icon_it_end = m_icons.end();
     for (; icon_it != icon_it_end; ++icon_it)
         renderButton(*icon_it->second);
+    m_backgrounds.endPass();
 
 }
 
@@ -547,6 +596,7 @@ IconButton *IconbarTool::makeButton(Focusable &win) {
 
     IconButton *button = new IconButton(m_icon_container, m_focused_theme,
                                         m_unfocused_theme, win);
+    button->setBackgrounds(&m_backgrounds);
 
     RefCmd focus_cmd(new ::FocusCommand(win));
     RefCmd menu_cmd(new ::ShowMenu(*fbwin));
@@ -558,17 +608,6 @@ IconButton *IconbarTool::makeButton(Focusable &win) {
     return button;
 }
 
-void IconbarTool::updateList() {
-    list<Focusable *>::iterator it = m_winlist->clientList().begin();
-    list<Focusable *>::iterator it_end = m_winlist->clientList().end();
-    for (; it != it_end; ++it) {
-        if ((*it)->fbwindow())
-            insertWindow(**it, -1);
-    }
-
-    renderTheme();
-}
-
 void IconbarTool::setOrientation(FbTk::Orientation orient) {
     m_icon_container.setOrientation(orient);
     ToolbarItem::setOrientation(orient);
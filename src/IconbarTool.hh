@@ -25,16 +25,17 @@
 
 #include "ToolbarItem.hh"
 #include "FbMenu.hh"
+#include "IconButton.hh"
 
 #include "FbTk/Container.hh"
 #include "FbTk/CachedPixmap.hh"
+#include "FbTk/IdleTask.hh"
 #include "FbTk/Resource.hh"
 
 #include <map>
 
 class IconbarTheme;
 class BScreen;
-class IconButton;
 class Focusable;
 class FocusableList;
 
@@ -89,21 +90,23 @@ private:
     void removeWindow(Focusable &win);
     /// make a button for the window
     IconButton *makeButton(Focusable &win);
-    /// remove all windows and add again
+    /// show the windows of the list, keeping the buttons of those already shown
     void reset();
-    /// add icons to the list
-    void updateList();
 
     /// called when the list emits a signal
     void update(UpdateReason reason, Focusable *win);
 
     void themeReconfigured();
+    /// places and renders the buttons after a resize, deferred by
+    /// resize and moveResize
+    void updateLayout();
 
     BScreen &m_screen;
     FbTk::Container m_icon_container;
     IconbarTheme &m_theme;
     FbTk::ThemeProxy<IconbarTheme> &m_focused_theme, &m_unfocused_theme;
     FbTk::CachedPixmap m_empty_pm; ///< pixmap for empty container
+    IconButtonBackgrounds m_backgrounds; ///< shared by all buttons
 
     FbTk::SignalTracker m_tracker;
 
@@ -117,6 +120,8 @@ private:
     FbTk::Resource<bool> m_rc_use_pixmap; ///< if iconbar should use win pixmap or not
     FbMenu m_menu;
     int m_alpha;
+    /// coalesces the resizes of a toolbar rearrange into one relayout
+    FbTk::IdleTask m_relayout;
 };
 
 #endif // ICONBARTOOL_HH
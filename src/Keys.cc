@@ -27,9 +27,11 @@
 #include "WindowCmd.hh"
 #include "Debug.hh"
 
+#include "FbTk/AllocStats.hh"
 #include "FbTk/EventManager.hh"
 #include "FbTk/StringUtil.hh"
 #include "FbTk/FileUtil.hh"
+#include "FbTk/Tokenizer.hh"
 #include "FbTk/App.hh"
 #include "FbTk/Command.hh"
 #include "FbTk/RefCount.hh"
@@ -38,6 +40,9 @@
 #include "FbTk/I18n.hh"
 #include "FbTk/AutoReloadHelper.hh"
 #include "FbTk/STLUtil.hh"
+#include "FbTk/FbTime.hh"
+#include "FbTk/FbWindow.hh"
+#include "FbTk/EventHandler.hh"
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -93,8 +98,10 @@
 #include <X11/XKBlib.h>
 
 #include <iostream>
-#include <fstream>
+#include <sstream>
+#include <algorithm>
 #include <list>
+#include <map>
 #include <vector>
 #include <memory>
 
@@ -102,7 +109,6 @@ using std::cerr;
 using std::endl;
 using std::string;
 using std::vector;
-using std::ifstream;
 using std::pair;
 
 using FbTk::STLUtil::destroyAndClearSecond;
@@ -127,10 +133,61 @@ int extractKeyFromString(const std::string& in, const char* start_pattern, unsig
     return ret;
 }
 
+/// what the bindings of Keys::benchmark() run
+class CountCmd: public FbTk::Command<void> {
+public:
+    explicit CountCmd(unsigned long &count): m_count(count) { }
+    void execute() { ++m_count; }
+private:
+    unsigned long &m_count;
+};
+
+/// a reproducible sequence for Keys::benchmark()
+class Random {
+public:
+    Random(): m_state(12345) { }
+    unsigned int next(unsigned int range) {
+        m_state = m_state * 1103515245 + 12345;
+        return (m_state >> 16) % range;
+    }
+private:
+    unsigned int m_state;
+};
+
+const char *bench_keys[] = {
+    "a", "b", "c", "d", "e", "f", "g", "h", "i", "j", "k", "l", "m",
+    "n", "o", "p", "q", "r", "s", "t", "u", "v", "w", "x", "y", "z",
+    "F1", "F2", "F3", "F4", "F5", "F6", "F7", "F8", "F9", "F10", "F11", "F12"
+};
+const size_t NUM_BENCH_KEYS = sizeof(bench_keys) / sizeof(bench_keys[0]);
+
+const struct {
+    const char *name;
+    unsigned int mask;
+} bench_mods[] = {
+    { "None", 0 }, { "Mod1", Mod1Mask }, { "Control", ControlMask },
+    { "Shift", ShiftMask }, { "Control Mod1", ControlMask|Mod1Mask },
+    { "Mod4", Mod4Mask } // chain prefixes
+};
+const size_t NUM_BENCH_MODS = sizeof(bench_mods) / sizeof(bench_mods[0]);
+
+const struct {
+    const char *name;
+    int context;
+} bench_contexts[] = {
+    { "OnDesktop", Keys::ON_DESKTOP }, { "OnToolbar", Keys::ON_TOOLBAR },
+    { "OnWindow", Keys::ON_WINDOW }, { "OnTitlebar", Keys::ON_TITLEBAR },
+    { "OnWindowBorder", Keys::ON_WINDOWBORDER },
+    { "OnLeftGrip", Keys::ON_LEFTGRIP }, { "OnRightGrip", Keys::ON_RIGHTGRIP }
+};
+const size_t NUM_BENCH_CONTEXTS = sizeof(bench_contexts) / sizeof(bench_contexts[0]);
+
+const size_t NUM_BENCH_MODES = 8;
+
 } // end of anonymous namespace
 
 // helper class 'keytree'
-class Keys::t_key {
+class Keys::t_key: public FbTk::RefCounted {
 public:
 
     // typedefs
@@ -145,17 +202,42 @@ public:
                 int context_, bool isdouble_) {
         // t_key ctor sets context_ of 0 to GLOBAL, so we must here too
         context_ = context_ ? context_ : GLOBAL;
-        keylist_t::iterator it = keylist.begin(), it_end = keylist.end();
-        for (; it != it_end; it++) {
-            if (*it && (*it)->type == type_ && (*it)->key == key_ &&
-                ((*it)->context & context_) > 0 &&
-                isdouble_ == (*it)->isdouble && (*it)->mod ==
-                FbTk::KeyUtil::instance().isolateModifierMask(mod_))
+        index_t::const_iterator bucket = m_index.find(
+            Trigger(type_, FbTk::KeyUtil::instance().isolateModifierMask(mod_), key_));
+        if (bucket == m_index.end())
+            return RefKey();
+
+        // bindings that only differ in context or double click
+        std::vector<RefKey>::const_iterator it = bucket->second.begin();
+        std::vector<RefKey>::const_iterator it_end = bucket->second.end();
+        for (; it != it_end; ++it) {
+            if (((*it)->context & context_) > 0 && isdouble_ == (*it)->isdouble)
                 return *it;
         }
         return RefKey();
     }
 
+    /// appends a binding to this level of the tree
+    void add(const RefKey &k) {
+        keylist.push_back(k);
+        m_index[Trigger(k->type, k->mod, k->key)].push_back(k);
+        if (k->type >= 0 && k->type < LASTEvent)
+            m_bound_contexts[k->type] |= k->context;
+    }
+
+    /// @return the contexts of the bindings for event type_ on this level
+    int boundContexts(int type_) const {
+        return (type_ >= 0 && type_ < LASTEvent) ? m_bound_contexts[type_] : 0;
+    }
+
+    /// updates the index after the keys of the bindings changed
+    void reindex() {
+        m_index.clear();
+        keylist_t::iterator it = keylist.begin(), it_end = keylist.end();
+        for (; it != it_end; ++it)
+            m_index[Trigger((*it)->type, (*it)->mod, (*it)->key)].push_back(*it);
+    }
+
     // member variables
 
     int type; // KeyPress or ButtonPress
@@ -167,6 +249,29 @@ public:
     FbTk::RefCount<FbTk::Command<void> > m_command;
 
     keylist_t keylist;
+
+private:
+    /// what find() looks bindings up by
+    struct Trigger {
+        Trigger(int type_, unsigned int mod_, unsigned int key_):
+            type(type_), mod(mod_), key(key_) { }
+
+        bool operator < (const Trigger &other) const {
+            if (key != other.key)
+                return key < other.key;
+            if (type != other.type)
+                return type < other.type;
+            return mod < other.mod;
+        }
+
+        int type;
+        unsigned int mod;
+        unsigned int key;
+    };
+    typedef std::map<Trigger, std::vector<RefKey> > index_t;
+
+    index_t m_index; ///< the bindings of keylist, in the same order
+    int m_bound_contexts[LASTEvent]; ///< see boundContexts()
 };
 
 Keys::t_key::t_key(int type_, unsigned int mod_, unsigned int key_,
@@ -181,6 +286,7 @@ Keys::t_key::t_key(int type_, unsigned int mod_, unsigned int key_,
     m_command(0) {
 
     context = context_ ? context_ : GLOBAL;
+    std::fill(m_bound_contexts, m_bound_contexts + LASTEvent, 0);
 }
 
 
@@ -207,17 +313,6 @@ void Keys::deleteTree() {
     saved_keymode.reset();
 }
 
-// keys are only grabbed in global context
-void Keys::grabKey(unsigned int key, unsigned int mod) {
-    WindowMap::iterator it = m_window_map.begin();
-    WindowMap::iterator it_end = m_window_map.end();
-
-    for (; it != it_end; ++it) {
-        if ((it->second & Keys::GLOBAL) > 0)
-            FbTk::KeyUtil::grabKey(key, mod, it->first);
-    }
-}
-
 // keys are only grabbed in global context
 void Keys::ungrabKeys() {
     WindowMap::iterator it = m_window_map.begin();
@@ -227,18 +322,7 @@ void Keys::ungrabKeys() {
         if ((it->second & Keys::GLOBAL) > 0)
             FbTk::KeyUtil::ungrabKeys(it->first);
     }
-}
-
-// ON_DESKTOP context doesn't need to be grabbed
-void Keys::grabButton(unsigned int button, unsigned int mod, int context) {
-    WindowMap::iterator it = m_window_map.begin();
-    WindowMap::iterator it_end = m_window_map.end();
-
-    for (; it != it_end; ++it) {
-        if ((context & it->second & ~Keys::ON_DESKTOP) > 0)
-            FbTk::KeyUtil::grabButton(button, mod, it->first,
-                                      ButtonPressMask|ButtonReleaseMask|ButtonMotionMask);
-    }
+    m_grabs.clear();
 }
 
 void Keys::ungrabButtons() {
@@ -247,6 +331,7 @@ void Keys::ungrabButtons() {
 
     for (; it != it_end; ++it)
         FbTk::KeyUtil::ungrabButtons(it->first);
+    m_grabs.clear();
 }
 
 void Keys::grabWindow(Window win) {
@@ -258,23 +343,74 @@ void Keys::grabWindow(Window win) {
     if (win_it == m_window_map.end())
         return;
 
-    m_handler_map[win]->grabButtons();
-    t_key::keylist_t::iterator it = m_keylist->keylist.begin();
-    t_key::keylist_t::iterator it_end = m_keylist->keylist.end();
+    GrabSet needed;
+    neededGrabs(*m_keylist, win_it->second, needed);
+    updateGrabs(win, needed, true);
+}
+
+void Keys::neededGrabs(const t_key &keyMode, int context, GrabSet &grabs) const {
+    t_key::keylist_t::const_iterator it = keyMode.keylist.begin();
+    t_key::keylist_t::const_iterator it_end = keyMode.keylist.end();
     for (; it != it_end; ++it) {
         // keys are only grabbed in global context
-        if ((win_it->second & Keys::GLOBAL) > 0 && (*it)->type == KeyPress)
-            FbTk::KeyUtil::grabKey((*it)->key, (*it)->mod, win);
+        if ((context & Keys::GLOBAL) > 0 && (*it)->type == KeyPress)
+            grabs.insert(Grab(false, (*it)->key, (*it)->mod));
         // ON_DESKTOP buttons don't need to be grabbed
-        else if ((win_it->second & (*it)->context & ~Keys::ON_DESKTOP) > 0) {
+        else if ((context & (*it)->context & ~Keys::ON_DESKTOP) > 0) {
 
             if ((*it)->type == ButtonPress || (*it)->type == ButtonRelease || (*it)->type == MotionNotify) {
-                FbTk::KeyUtil::grabButton((*it)->key, (*it)->mod, win, ButtonPressMask|ButtonReleaseMask|ButtonMotionMask);
+                grabs.insert(Grab(true, (*it)->key, (*it)->mod));
             }
         }
     }
 }
 
+void Keys::updateGrabs(Window win, const GrabSet &needed, bool full) {
+    // windows registered before the first key mode haven't been set up yet
+    GrabMap::iterator found = m_grabs.find(win);
+    if (found == m_grabs.end()) {
+        found = m_grabs.insert(make_pair(win, GrabSet())).first;
+        full = true;
+    }
+    GrabSet &had = found->second;
+    if (!full && had.size() == needed.size() &&
+        std::equal(had.begin(), had.end(), needed.begin()))
+        return;
+
+    // single buttons can't be ungrabbed, as that would also take them from
+    // the window's own grabs (like Button1 for click to focus); so when a
+    // button goes away, the window gets all of them again
+    bool all_buttons = full;
+    GrabSet::const_iterator it = had.begin(), it_end = had.end();
+    for (; !full && it != it_end; ++it) {
+        if (needed.find(*it) != needed.end())
+            continue;
+        if (it->button)
+            all_buttons = true;
+        else
+            FbTk::KeyUtil::ungrabKey(it->code, it->mod, win);
+    }
+
+    if (full)
+        FbTk::KeyUtil::ungrabKeys(win);
+    if (all_buttons) {
+        FbTk::KeyUtil::ungrabButtons(win);
+        m_handler_map[win]->grabButtons();
+    }
+
+    for (it = needed.begin(), it_end = needed.end(); it != it_end; ++it) {
+        if ((it->button ? all_buttons : full) || had.find(*it) == had.end()) {
+            if (it->button)
+                FbTk::KeyUtil::grabButton(it->code, it->mod, win,
+                                          ButtonPressMask|ButtonReleaseMask|ButtonMotionMask);
+            else
+                FbTk::KeyUtil::grabKey(it->code, it->mod, win);
+        }
+    }
+
+    had = needed;
+}
+
 /**
     Load and grab keys
     TODO: error checking
@@ -296,8 +432,8 @@ void Keys::reload() {
     }
 
     // open the file
-    ifstream infile(m_filename.c_str());
-    if (!infile) {
+    FbTk::MappedFile infile;
+    if (!infile.open(m_filename.c_str())) {
         if (firstload)
             loadDefaults();
         return; // failed to open file
@@ -306,26 +442,28 @@ void Keys::reload() {
     // free memory of previous grabs
     deleteTree();
 
-    m_map["default:"] = FbTk::makeRef<t_key>();
-
-    unsigned int current_line = 0; //so we can tell the user where the fault is
-
-    while (!infile.eof()) {
-        string linebuffer;
+    // lines that didn't change keep their commands, so they aren't parsed
+    // again (which may load menus and the like)
+    m_old_commands.swap(m_commands);
+    m_commands.clear();
 
-        getline(infile, linebuffer);
+    m_map["default:"] = FbTk::makeRef<t_key>();
 
-        current_line++;
+    FbTk::Tokenizer lines(infile);
+    string linebuffer;
+    while (lines.nextLine()) {
+        lines.line().assignTo(linebuffer);
 
         if (!addBinding(linebuffer)) {
             _FB_USES_NLS;
             cerr<<_FB_CONSOLETEXT(Keys, InvalidKeyMod,
                           "Keys: Invalid key/modifier on line",
                           "A bad key/modifier string was found on line (number following)")<<" "<<
-                current_line<<"): "<<linebuffer<<endl;
+                lines.row()<<"): "<<linebuffer<<endl;
         }
-    } // end while eof
+    }
 
+    m_old_commands.clear();
     keyMode("default");
 }
 
@@ -336,6 +474,7 @@ void Keys::loadDefaults() {
     fbdbg<<"Loading default key bindings"<<endl;
 
     deleteTree();
+    m_commands.clear();
     m_map["default:"] = FbTk::makeRef<t_key>();
     addBinding("OnDesktop Mouse1 :HideMenus");
     addBinding("OnDesktop Mouse2 :WorkspaceMenu");
@@ -482,7 +621,7 @@ bool Keys::addBinding(const string &linebuffer) {
                 } else {
                     RefKey temp_key( new t_key(type, mod, key, key_str, context,
                                                 isdouble) );
-                    current_key->keylist.push_back(temp_key);
+                    current_key->add(temp_key);
                     current_key = temp_key;
                 }
                 mod = 0;
@@ -498,14 +637,19 @@ bool Keys::addBinding(const string &linebuffer) {
 
             const char *str = FbTk::StringUtil::strcasestr(linebuffer.c_str(),
                    val[argc].c_str());
-            if (str) // +1 to skip ':'
+            CommandMap::iterator old_command = m_old_commands.find(linebuffer);
+            if (old_command != m_old_commands.end())
+                current_key->m_command = old_command->second;
+            else if (str) // +1 to skip ':'
                 current_key->m_command.reset(FbTk::CommandParser<void>::instance().parse(str + 1));
 
             if (!str || current_key->m_command == 0 || mod)
                 return false;
 
+            m_commands[linebuffer] = current_key->m_command;
+
             // success
-            first_new_keylist->keylist.push_back(first_new_key);
+            first_new_keylist->add(first_new_key);
             return true;
         }  // end if
     } // end for
@@ -513,6 +657,15 @@ bool Keys::addBinding(const string &linebuffer) {
     return false;
 }
 
+bool Keys::isBound(int type, int context) const {
+    const RefKey &level = next_key ? next_key : m_keylist;
+    if (!level)
+        return false;
+    // same as in t_key::find()
+    context = context ? context : GLOBAL;
+    return (level->boundContexts(type) & context) != 0;
+}
+
 // return true if bound to a command, else false
 bool Keys::doAction(int type, unsigned int mods, unsigned int key,
                     int context, WinClient *current, Time time) {
@@ -605,6 +758,7 @@ void Keys::unregisterWindow(Window win) {
     FbTk::KeyUtil::ungrabButtons(win);
     m_handler_map.erase(win);
     m_window_map.erase(win);
+    m_grabs.erase(win);
 }
 
 /**
@@ -618,7 +772,157 @@ void Keys::reconfigure() {
 }
 
 void Keys::regrab() {
-    setKeyMode(m_keylist);
+    setKeyMode(m_keylist, true);
+}
+
+void Keys::benchmark(std::ostream &os, unsigned long events) {
+    Display *disp = FbTk::App::instance()->display();
+    Keys keys;
+    keys.m_map["default:"] = FbTk::makeRef<t_key>();
+
+    // the keys file, Raise is just something that parses
+    vector<string> lines;
+    for (size_t m = 0; m + 1 < NUM_BENCH_MODS; ++m) {
+        for (size_t k = 0; k < NUM_BENCH_KEYS; ++k)
+            lines.push_back(string(bench_mods[m].name) + " " + bench_keys[k] + " :Raise");
+    }
+    for (size_t k = 0; k < NUM_BENCH_KEYS; ++k) {
+        for (size_t k2 = 0; k2 < NUM_BENCH_KEYS; k2 += 4)
+            lines.push_back(string("Mod4 ") + bench_keys[k] + " " + bench_keys[k2] + " :Raise");
+    }
+    const char *mouse[] = { "Mouse", "Click", "Move" };
+    for (size_t c = 0; c < NUM_BENCH_CONTEXTS; ++c) {
+        for (unsigned int b = 1; b <= 5; ++b) {
+            for (size_t m = 0; m < 3; ++m) {
+                for (size_t t = 0; t < 3; ++t) {
+                    std::ostringstream line;
+                    line<<bench_contexts[c].name<<" "<<bench_mods[m].name<<" "
+                        <<mouse[t]<<b<<" :Raise";
+                    lines.push_back(line.str());
+                }
+            }
+        }
+        lines.push_back(string(bench_contexts[c].name) + " Double Mouse1 :Raise");
+    }
+    for (size_t mode = 0; mode < NUM_BENCH_MODES; ++mode) {
+        for (size_t k = 0; k < NUM_BENCH_KEYS; ++k) {
+            std::ostringstream line;
+            line<<"Mode"<<mode<<": "<<bench_mods[(mode + k) % (NUM_BENCH_MODS - 1)].name
+                <<" "<<bench_keys[k]<<" :Raise";
+            lines.push_back(line.str());
+        }
+    }
+
+    unsigned int failed = 0;
+    for (size_t i = 0; i < lines.size(); ++i)
+        failed += !keys.addBinding(lines[i]);
+
+    // the commands only count, so nothing happens
+    unsigned long executed = 0;
+    FbTk::RefCount<FbTk::Command<void> > count(new CountCmd(executed));
+    vector<t_key *> todo;
+    keyspace_t::iterator mode_it = keys.m_map.begin();
+    for (; mode_it != keys.m_map.end(); ++mode_it)
+        todo.push_back(mode_it->second.get());
+    while (!todo.empty()) {
+        t_key *k = todo.back();
+        todo.pop_back();
+        if (k->m_command)
+            k->m_command = count;
+        t_key::keylist_t::iterator it = k->keylist.begin();
+        for (; it != k->keylist.end(); ++it)
+            todo.push_back(it->get());
+    }
+
+    // a window registered like a frame, to measure the grabs
+    BScreen *screen = Fluxbox::instance()->keyScreen();
+    FbTk::FbWindow win(screen ? screen->screenNumber() : 0, -10, -10, 1, 1, 0,
+                       true, false, CopyFromParent, InputOnly);
+    FbTk::EventHandler handler;
+    keys.registerWindow(win.window(), handler,
+                        GLOBAL|ON_WINDOW|ON_TITLEBAR|ON_WINDOWBORDER|
+                        ON_LEFTGRIP|ON_RIGHTGRIP|ON_TAB);
+    keys.keyMode("default");
+    XSync(disp, False);
+
+    vector<unsigned int> keycodes;
+    for (size_t k = 0; k < NUM_BENCH_KEYS; ++k)
+        keycodes.push_back(FbTk::KeyUtil::getKey(bench_keys[k]));
+
+    // the same sequence every run, so results can be compared
+    const int types[] = { KeyPress, ButtonPress, ButtonRelease, MotionNotify };
+    const size_t NUM_TYPES = sizeof(types) / sizeof(types[0]);
+    uint64_t nsec[NUM_TYPES] = { 0 };
+    unsigned long counts[NUM_TYPES] = { 0 }, bound[NUM_TYPES] = { 0 };
+    unsigned long allocations[NUM_TYPES] = { 0 };
+    Random random;
+    Time time = 1;
+    for (unsigned long e = 0; e < events; ++e) {
+        // keys are half of the events
+        size_t t = random.next(2) ? 0 : 1 + random.next(NUM_TYPES - 1);
+        unsigned int mods = bench_mods[random.next(NUM_BENCH_MODS)].mask;
+        // now and then with NumLock on
+        if (random.next(8) == 0)
+            mods |= Mod2Mask;
+        unsigned int key;
+        int context;
+        if (types[t] == KeyPress) {
+            key = keycodes[random.next(NUM_BENCH_KEYS)];
+            context = GLOBAL;
+        } else {
+            key = 1 + random.next(5);
+            context = bench_contexts[random.next(NUM_BENCH_CONTEXTS)].context;
+        }
+        // some double clicks
+        time += random.next(4) ? 1000 : 10;
+
+        unsigned long allocated = FbTk::AllocStats::count();
+        uint64_t start = FbTk::FbTime::monoNanoseconds();
+        bound[t] += keys.doAction(types[t], mods, key, context, 0, time);
+        nsec[t] += FbTk::FbTime::monoNanoseconds() - start;
+        allocations[t] += FbTk::AllocStats::count() - allocated;
+        ++counts[t];
+    }
+    XSync(disp, False);
+
+    const char *type_names[] = { "KeyPress", "ButtonPress", "ButtonRelease", "MotionNotify" };
+    os<<"keys benchmark: "<<lines.size() - failed<<" bindings in "
+      <<keys.m_map.size()<<" modes";
+    if (failed > 0)
+        os<<" ("<<failed<<" failed to load)";
+    os<<endl;
+    for (size_t t = 0; t < NUM_TYPES; ++t) {
+        os<<type_names[t]<<": "<<counts[t]<<" events, "<<bound[t]<<" bound";
+        if (counts[t] > 0)
+            os<<", "<<nsec[t] / counts[t]<<" ns per event";
+        if (counts[t] > 0 && FbTk::AllocStats::counting())
+            os<<", "<<double(allocations[t]) / counts[t]<<" allocations per event";
+        os<<endl;
+    }
+    os<<"commands run: "<<executed<<endl;
+
+    // switching modes changes the grabs of every registered window
+    const unsigned int SWITCHES = 200;
+    uint64_t start = FbTk::FbTime::monoNanoseconds();
+    for (unsigned int i = 0; i < SWITCHES; ++i) {
+        std::ostringstream mode;
+        mode<<"Mode"<<i % NUM_BENCH_MODES;
+        keys.keyMode(i % 2 ? mode.str() : string("default"));
+    }
+    XSync(disp, False);
+    uint64_t switch_nsec = FbTk::FbTime::monoNanoseconds() - start;
+
+    start = FbTk::FbTime::monoNanoseconds();
+    for (unsigned int i = 0; i < SWITCHES; ++i)
+        keys.regrab();
+    XSync(disp, False);
+    uint64_t regrab_nsec = FbTk::FbTime::monoNanoseconds() - start;
+
+    os<<"keymode switch: "<<switch_nsec / SWITCHES / 1000<<" us per switch, "
+      <<"full regrab: "<<regrab_nsec / SWITCHES / 1000<<" us, "
+      <<"on one window"<<endl;
+
+    keys.unregisterWindow(win.window());
 }
 
 void Keys::keyMode(const string& keyMode) {
@@ -629,30 +933,30 @@ void Keys::keyMode(const string& keyMode) {
         setKeyMode(it->second);
 }
 
-void Keys::setKeyMode(const FbTk::RefCount<t_key> &keyMode) {
-    ungrabKeys();
-    ungrabButtons();
-
-    // notify handlers that their buttons have been ungrabbed
-    HandlerMap::iterator h_it = m_handler_map.begin(),
-                         h_it_end  = m_handler_map.end();
-    for (; h_it != h_it_end; ++h_it)
-        h_it->second->grabButtons();
-
+void Keys::setKeyMode(const FbTk::RefCount<t_key> &keyMode, bool full) {
+    bool keys_changed = false;
     t_key::keylist_t::iterator it = keyMode->keylist.begin();
     t_key::keylist_t::iterator it_end = keyMode->keylist.end();
     for (; it != it_end; ++it) {
         RefKey t = *it;
-        if (t->type == KeyPress) {
-            if (!t->key_str.empty()) {
-                int key = FbTk::KeyUtil::getKey(t->key_str.c_str());
-                t->key = key;
-            }
-            grabKey(t->key, t->mod);
-        } else {
-            grabButton(t->key, t->mod, t->context);
+        if (t->type == KeyPress && !t->key_str.empty()) {
+            unsigned int key = FbTk::KeyUtil::getKey(t->key_str.c_str());
+            keys_changed |= (t->key != key);
+            t->key = key;
         }
     }
+    // the keyboard mapping might have changed
+    if (keys_changed)
+        keyMode->reindex();
+
+    // only change the grabs that differ between the modes
+    WindowMap::iterator win_it = m_window_map.begin();
+    WindowMap::iterator win_it_end = m_window_map.end();
+    for (; win_it != win_it_end; ++win_it) {
+        GrabSet needed;
+        neededGrabs(*keyMode, win_it->second, needed);
+        updateGrabs(win_it->first, needed, full);
+    }
     m_keylist = keyMode;
 }
 
@@ -27,13 +27,16 @@
 
 #include <X11/Xlib.h>
 #include <string>
+#include <iosfwd>
 #include <map>
+#include <set>
 
 class WinClient;
 
 namespace FbTk {
     class EventHandler;
     class AutoReloadHelper;
+    template <typename Ret> class Command;
 }
 
 class Keys:private FbTk::NotCopyable  {
@@ -72,6 +75,13 @@ public:
     bool doAction(int type, unsigned int mods, unsigned int key, int context,
                   WinClient *current = 0, Time time = 0);
 
+    /**
+       Is anything bound to this type of event in one of the contexts, in
+       the current key mode or chain? Lets frequent events like motion
+       skip doAction(), which can't do anything for them otherwise.
+    */
+    bool isBound(int type, int context) const;
+
     /// register a window so that proper keys/buttons get grabbed on it
     void registerWindow(Window win, FbTk::EventHandler &handler, int context);
     /// unregister window
@@ -93,6 +103,14 @@ public:
 
     bool inKeychain() const { return saved_keymode != 0; }
 
+    /**
+       Replays 'events' generated key, button and motion events through
+       doAction() of a generated keys file with modes, chains and mouse
+       bindings in every context, and writes the time per event and per
+       key mode switch to 'os'. The real bindings and grabs are untouched.
+    */
+    static void benchmark(std::ostream &os, unsigned long events);
+
 private:
     class t_key; // helper class to build a 'keytree'
     typedef FbTk::RefCount<t_key> RefKey;
@@ -100,17 +118,48 @@ private:
     typedef std::map<Window, int> WindowMap;
     typedef std::map<Window, FbTk::EventHandler*> HandlerMap;
 
+    /// a key or button grabbed on a window, with all lock modifier variants
+    struct Grab {
+        Grab(bool button_, unsigned int code_, unsigned int mod_):
+            button(button_), code(code_), mod(mod_) { }
+
+        bool operator < (const Grab &other) const {
+            if (button != other.button)
+                return button < other.button;
+            if (code != other.code)
+                return code < other.code;
+            return mod < other.mod;
+        }
+        bool operator == (const Grab &other) const {
+            return button == other.button && code == other.code && mod == other.mod;
+        }
+
+        bool button;
+        unsigned int code;
+        unsigned int mod;
+    };
+    typedef std::set<Grab> GrabSet;
+    typedef std::map<Window, GrabSet> GrabMap;
+    typedef std::map<std::string, FbTk::RefCount<FbTk::Command<void> > > CommandMap;
+
     void deleteTree();
 
-    void grabKey(unsigned int key, unsigned int mod);
     void ungrabKeys();
-    void grabButton(unsigned int button, unsigned int mod, int context);
     void ungrabButtons();
     void grabWindow(Window win);
 
+    /// collects the grabs a window with the given context needs in keyMode
+    void neededGrabs(const t_key &keyMode, int context, GrabSet &grabs) const;
+    /**
+       Changes the grabs of a window to the needed ones
+       @param full regrab everything, not just what changed
+    */
+    void updateGrabs(Window win, const GrabSet &needed, bool full);
+
     // Load default keybindings for when there are errors loading the keys file
     void loadDefaults();
-    void setKeyMode(const FbTk::RefCount<t_key> &keyMode);
+    /// @param full regrab everything, e.g. after the modifier mapping changed
+    void setKeyMode(const FbTk::RefCount<t_key> &keyMode, bool full = false);
 
 
     // member variables
@@ -124,6 +173,12 @@ private:
 
     WindowMap m_window_map;
     HandlerMap m_handler_map;
+    GrabMap m_grabs; ///< what Keys grabbed on each window
+
+    /// the commands of the bindings by their line in the keys file
+    CommandMap m_commands;
+    /// m_commands of the previous file while reloading, to reuse them
+    CommandMap m_old_commands;
 };
 
 #endif // KEYS_HH
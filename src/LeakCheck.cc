@@ -0,0 +1,136 @@
+// LeakCheck.cc for Fluxbox Window Manager
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#include "LeakCheck.hh"
+
+#include "FbTk/App.hh"
+#include "FbTk/AtomCache.hh"
+#include "FbTk/MemFun.hh"
+#include "FbTk/RoundTrips.hh"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#ifdef HAVE_XRES
+#include <X11/extensions/XRes.h>
+#endif // HAVE_XRES
+
+#include <iostream>
+
+using std::cerr;
+using std::endl;
+using FbTk::MemoryAccount;
+
+#ifdef HAVE_XRES
+namespace {
+
+/// the names the X-Resource extension uses for the types
+const char *TYPE_NAMES[] = { "PIXMAP", "WINDOW", "GC", "PICTURE" };
+
+} // anonymous namespace
+#endif // HAVE_XRES
+
+LeakCheck::LeakCheck(Window window, unsigned int seconds):
+    m_window(window), m_first(true) {
+    for (int t = 0; t < NUM_TYPES; ++t)
+        m_server[t] = m_ours[t] = 0;
+    for (int s = 0; s < MemoryAccount::NUM_SUBSYSTEMS; ++s)
+        m_subsystems[s] = 0;
+    m_timer.setTimeout(seconds, 0);
+    m_timer.setFunctor(FbTk::MemFun(*this, &LeakCheck::check));
+    m_timer.start();
+}
+
+bool LeakCheck::supported() {
+#ifdef HAVE_XRES
+    int event_base, error_base;
+    return XResQueryExtension(FbTk::App::instance()->display(),
+                              &event_base, &error_base);
+#else
+    return false;
+#endif // HAVE_XRES
+}
+
+long LeakCheck::ours(Type type) {
+    const MemoryAccount &account = MemoryAccount::instance();
+    switch (type) {
+    case PIXMAP:
+        return account.total().pixmaps + account.count(MemoryAccount::NAMED_PIXMAPS);
+    case WINDOW:
+        return account.count(MemoryAccount::WINDOWS);
+    case GC:
+        return account.count(MemoryAccount::GCS);
+    case PICTURE:
+        return account.count(MemoryAccount::PICTURES);
+    default:
+        return 0;
+    }
+}
+
+void LeakCheck::check() {
+#ifdef HAVE_XRES
+    Display *disp = FbTk::App::instance()->display();
+    int num_types = 0;
+    XResType *types = 0;
+    FBTK_ROUNDTRIP("LeakCheck::check");
+    if (!XResQueryClientResources(disp, m_window, &num_types, &types))
+        return;
+
+    FbTk::AtomCache &atoms = FbTk::AtomCache::instance();
+    long server[NUM_TYPES] = { 0, 0, 0, 0 };
+    for (int i = 0; i < num_types; ++i) {
+        for (int t = 0; t < NUM_TYPES; ++t) {
+            if (types[i].resource_type == atoms.get(TYPE_NAMES[t]))
+                server[t] = types[i].count;
+        }
+    }
+    if (types)
+        XFree(types);
+
+    const MemoryAccount &account = MemoryAccount::instance();
+    for (int t = 0; t < NUM_TYPES; ++t) {
+        long own = ours(Type(t));
+        // the server may hold some we never see, only growth matters
+        long growth = (server[t] - own) - (m_server[t] - m_ours[t]);
+        if (!m_first && growth > 0) {
+            cerr<<"fluxbox: leak check: "<<TYPE_NAMES[t]<<": X server "
+                <<server[t]<<" ("<<std::showpos<<server[t] - m_server[t]
+                <<"), accounted "<<own<<" ("<<own - m_ours[t]
+                <<std::noshowpos<<"), "<<growth<<" more unaccounted";
+            if (t == PIXMAP) {
+                for (int s = 0; s < MemoryAccount::NUM_SUBSYSTEMS; ++s) {
+                    MemoryAccount::Subsystem subsystem = MemoryAccount::Subsystem(s);
+                    long grown = account.usage(subsystem).pixmaps - m_subsystems[s];
+                    if (grown > 0)
+                        cerr<<", "<<MemoryAccount::name(subsystem)<<" +"<<grown;
+                }
+            }
+            cerr<<endl;
+        }
+        m_server[t] = server[t];
+        m_ours[t] = own;
+    }
+    for (int s = 0; s < MemoryAccount::NUM_SUBSYSTEMS; ++s)
+        m_subsystems[s] = account.usage(MemoryAccount::Subsystem(s)).pixmaps;
+    m_first = false;
+#endif // HAVE_XRES
+}
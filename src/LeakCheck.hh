@@ -0,0 +1,64 @@
+// LeakCheck.hh for Fluxbox Window Manager
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#ifndef LEAKCHECK_HH
+#define LEAKCHECK_HH
+
+#include "FbTk/MemoryAccount.hh"
+#include "FbTk/NotCopyable.hh"
+#include "FbTk/Timer.hh"
+
+#include <X11/Xlib.h>
+
+/**
+ * Compares what the X server holds for us, as the X-Resource extension
+ * tells, with what we account for ourselves (MemoryAccount), every
+ * interval. When the difference of a resource type grows, something
+ * created it without ever freeing it, and we log the growth together with
+ * the subsystems whose pixmaps grew since the last check.
+ */
+class LeakCheck: private FbTk::NotCopyable {
+public:
+    /// @param window any window we created, it names our client
+    LeakCheck(Window window, unsigned int seconds);
+
+    /// @return true if the X server has the X-Resource extension
+    static bool supported();
+
+    /// queries the X server and logs resources that diverge
+    void check();
+
+private:
+    /// the resource types we compare
+    enum Type { PIXMAP, WINDOW, GC, PICTURE, NUM_TYPES };
+
+    /// @return what we think we hold of 'type'
+    static long ours(Type type);
+
+    FbTk::Timer m_timer;
+    Window m_window;
+    bool m_first;
+    long m_server[NUM_TYPES]; ///< at the last check
+    long m_ours[NUM_TYPES];   ///< at the last check
+    unsigned long m_subsystems[FbTk::MemoryAccount::NUM_SUBSYSTEMS]; ///< pixmaps at the last check
+};
+
+#endif // LEAKCHECK_HH
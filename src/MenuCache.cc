@@ -0,0 +1,355 @@
+// MenuCache.cc for Fluxbox Window Manager
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "MenuCache.hh"
+#include "FbMenuParser.hh"
+
+#include "FbTk/FileUtil.hh"
+#include "FbTk/Timer.hh"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#ifdef HAVE_SYS_STAT_H
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif // HAVE_SYS_STAT_H
+
+#ifdef HAVE_CSTDIO
+  #include <cstdio>
+#else
+  #include <stdio.h>
+#endif
+
+#ifdef HAVE_CSTRING
+  #include <cstring>
+#else
+  #include <string.h>
+#endif
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif // HAVE_PTHREAD
+
+#include <fstream>
+#include <map>
+#include <memory>
+#include <stdint.h>
+
+using std::string;
+
+namespace {
+
+const char MAGIC[] = "fluxbox menu cache 1\n";
+
+/// what tells us a file didn't change
+struct Stamp {
+    Stamp(): mtime(0), size(0), inode(0) { }
+
+    bool operator == (const Stamp &other) const {
+        return mtime == other.mtime && size == other.size && inode == other.inode;
+    }
+
+    uint64_t mtime, size, inode;
+};
+
+struct Entry {
+    Stamp stamp;
+    MenuCache::Items items;
+};
+
+typedef std::map<string, Entry> Entries;
+
+string s_cachefile;
+Entries s_entries;
+bool s_read = false; ///< s_entries holds what s_cachefile has
+std::auto_ptr<FbTk::Timer> s_save_timer;
+/// files preload() tokenized that aren't written to s_cachefile yet
+bool s_unsaved = false;
+
+#ifdef HAVE_PTHREAD
+std::vector<string> s_preload_files;
+pthread_t s_preload_thread;
+bool s_preloading = false;
+#endif // HAVE_PTHREAD
+
+/// the item types FbMenuParser gives, by their number in the cache
+const char *item_types[] = { "", "TYPE", "NAME", "ARGUMENT", "ICON" };
+const size_t NUM_ITEM_TYPES = sizeof(item_types) / sizeof(item_types[0]);
+
+bool getStamp(const string &filename, Stamp &stamp) {
+#ifdef HAVE_SYS_STAT_H
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0)
+        return false;
+    stamp.mtime = st.st_mtime;
+    stamp.size = st.st_size;
+    stamp.inode = st.st_ino;
+    return true;
+#else
+    return false;
+#endif // HAVE_SYS_STAT_H
+}
+
+// the cache is only ever read by the fluxbox that wrote it, so numbers
+// are in the byte order of the machine
+
+void put(string &out, uint64_t value) {
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void put(string &out, const string &value) {
+    put(out, uint64_t(value.size()));
+    out.append(value);
+}
+
+class Reader {
+public:
+    Reader(const char *data, size_t size): m_pos(data), m_end(data + size) { }
+
+    bool get(uint64_t &value) {
+        if (size_t(m_end - m_pos) < sizeof(value))
+            return false;
+        memcpy(&value, m_pos, sizeof(value));
+        m_pos += sizeof(value);
+        return true;
+    }
+
+    bool get(string &value) {
+        uint64_t size;
+        if (!get(size) || size > size_t(m_end - m_pos))
+            return false;
+        value.assign(m_pos, size);
+        m_pos += size;
+        return true;
+    }
+
+    bool done() const { return m_pos == m_end; }
+
+private:
+    const char *m_pos, *m_end;
+};
+
+void readCache() {
+    s_read = true;
+    s_entries.clear();
+
+    FbTk::MappedFile file;
+    if (!file.open(s_cachefile.c_str()) || file.size() < sizeof(MAGIC) - 1 ||
+        memcmp(file.data(), MAGIC, sizeof(MAGIC) - 1) != 0)
+        return;
+
+    Reader reader(file.data() + sizeof(MAGIC) - 1, file.size() - sizeof(MAGIC) + 1);
+    while (!reader.done()) {
+        string filename;
+        Entry entry;
+        uint64_t count;
+        if (!reader.get(filename) || !reader.get(entry.stamp.mtime) ||
+            !reader.get(entry.stamp.size) || !reader.get(entry.stamp.inode) ||
+            !reader.get(count)) {
+            s_entries.clear(); // broken, start over
+            return;
+        }
+        for (uint64_t i = 0; i < count; ++i) {
+            uint64_t type;
+            string value;
+            if (!reader.get(type) || type >= NUM_ITEM_TYPES || !reader.get(value)) {
+                s_entries.clear();
+                return;
+            }
+            entry.items.push_back(FbTk::Parser::Item(item_types[type], value));
+        }
+        s_entries[filename].items.swap(entry.items);
+        s_entries[filename].stamp = entry.stamp;
+    }
+}
+
+void writeCache() {
+    if (s_cachefile.empty())
+        return;
+
+    string out(MAGIC);
+    Entries::iterator it = s_entries.begin();
+    while (it != s_entries.end()) {
+        // forget files that are gone or changed since
+        Stamp stamp;
+        if (!getStamp(it->first, stamp) || !(stamp == it->second.stamp)) {
+            s_entries.erase(it++);
+            continue;
+        }
+        put(out, it->first);
+        put(out, stamp.mtime);
+        put(out, stamp.size);
+        put(out, stamp.inode);
+        put(out, uint64_t(it->second.items.size()));
+        MenuCache::Items::const_iterator item = it->second.items.begin();
+        for (; item != it->second.items.end(); ++item) {
+            uint64_t type = 0;
+            while (type < NUM_ITEM_TYPES && item->first != item_types[type])
+                ++type;
+            put(out, type < NUM_ITEM_TYPES ? type : 0);
+            put(out, item->second);
+        }
+        ++it;
+    }
+
+    // nobody sees a half written cache
+    string tmpfile = s_cachefile + ".tmp";
+    std::ofstream file(tmpfile.c_str(), std::ios::binary);
+    if (!file)
+        return;
+    file.write(out.data(), out.size());
+    file.close();
+    if (!file || rename(tmpfile.c_str(), s_cachefile.c_str()) != 0)
+        remove(tmpfile.c_str());
+}
+
+/// the way the menu code reads it, four items for each line
+bool tokenize(const string &filename, MenuCache::Items &items) {
+    FbMenuParser parser(filename);
+    if (!parser.isLoaded())
+        return false;
+    FbTk::Parser::Item item;
+    while (!parser.eof()) {
+        for (int i = 0; i < 4; ++i) {
+            parser>>item;
+            items.push_back(item);
+        }
+    }
+    return true;
+}
+
+void scheduleSave() {
+    // menus often read several files at once, write them together
+    if (s_save_timer.get() == 0) {
+        s_save_timer.reset(new FbTk::Timer());
+        s_save_timer->setTimeout(0, 500000);
+        s_save_timer->fireOnce(true);
+        s_save_timer->setFunctor(&writeCache);
+    }
+    if (!s_save_timer->isTiming())
+        s_save_timer->start();
+}
+
+/// brings the entries of files that changed up to date, without Xlib or
+/// timers, so it may run in a thread
+void preloadFiles(const std::vector<string> &filenames) {
+    if (!s_read)
+        readCache();
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        Stamp stamp;
+        if (!getStamp(filenames[i], stamp))
+            continue;
+        Entries::const_iterator it = s_entries.find(filenames[i]);
+        if (it != s_entries.end() && it->second.stamp == stamp)
+            continue;
+        MenuCache::Items items;
+        if (!tokenize(filenames[i], items))
+            continue;
+        Entry &entry = s_entries[filenames[i]];
+        entry.stamp = stamp;
+        entry.items.swap(items);
+        s_unsaved = true;
+    }
+}
+
+#ifdef HAVE_PTHREAD
+void *preloadMain(void *) {
+    preloadFiles(s_preload_files);
+    return 0;
+}
+#endif // HAVE_PTHREAD
+
+/// waits for preload(), everything that touches the entries calls this
+void finishPreload() {
+#ifdef HAVE_PTHREAD
+    if (s_preloading) {
+        pthread_join(s_preload_thread, 0);
+        s_preloading = false;
+        s_preload_files.clear();
+    }
+#endif // HAVE_PTHREAD
+    if (s_unsaved) {
+        s_unsaved = false;
+        scheduleSave();
+    }
+}
+
+} // end anonymous namespace
+
+namespace MenuCache {
+
+void setFile(const string &cachefile) {
+    finishPreload();
+    if (cachefile == s_cachefile)
+        return;
+    s_cachefile = cachefile;
+    s_read = false;
+    s_entries.clear();
+}
+
+void preload(const std::vector<string> &filenames) {
+    finishPreload();
+    if (s_cachefile.empty())
+        return;
+#ifdef HAVE_PTHREAD
+    s_preload_files = filenames;
+    s_preloading = pthread_create(&s_preload_thread, 0, preloadMain, 0) == 0;
+    if (s_preloading)
+        return;
+#endif // HAVE_PTHREAD
+    // do it now then, load() would do the same
+    preloadFiles(filenames);
+    finishPreload();
+}
+
+bool load(const string &filename, Items &items) {
+    finishPreload();
+    items.clear();
+
+    Stamp stamp;
+    bool stamped = getStamp(filename, stamp);
+    if (stamped && !s_cachefile.empty()) {
+        if (!s_read)
+            readCache();
+        Entries::const_iterator it = s_entries.find(filename);
+        if (it != s_entries.end() && it->second.stamp == stamp) {
+            items = it->second.items;
+            return true;
+        }
+    }
+
+    if (!tokenize(filename, items))
+        return false;
+
+    if (!stamped || s_cachefile.empty())
+        return true;
+
+    Entry &entry = s_entries[filename];
+    entry.stamp = stamp;
+    entry.items = items;
+    scheduleSave();
+    return true;
+}
+
+} // end namespace MenuCache
@@ -0,0 +1,86 @@
+// MenuCache.hh for Fluxbox Window Manager
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#ifndef MENUCACHE_HH
+#define MENUCACHE_HH
+
+#include "FbTk/Parser.hh"
+
+#include <string>
+#include <vector>
+
+/**
+ * Keeps the tokens of menu files in a binary cache file, so files that
+ * didn't change since they were last read aren't tokenized again. Every
+ * file, including those pulled in by [include], has its own entry, checked
+ * against the modification time, size and inode of the file.
+ */
+namespace MenuCache {
+
+    /// the items of a menu file, four per line like FbMenuParser gives them
+    typedef std::vector<FbTk::Parser::Item> Items;
+
+    /// where the cache is kept, none if empty
+    void setFile(const std::string &cachefile);
+
+    /**
+     * Tokenizes the files that changed since they were cached in a
+     * thread, while the caller goes on with work that waits for the
+     * X server. load() and setFile() wait for it.
+     */
+    void preload(const std::vector<std::string> &filenames);
+
+    /**
+     * Gets the items of a menu file, from the cache if it didn't change
+     * @return false if the file can't be read
+     */
+    bool load(const std::string &filename, Items &items);
+
+    /// gives back loaded items like a parser of the file would
+    class ItemParser: public FbTk::Parser {
+    public:
+        explicit ItemParser(const Items &items): m_items(items), m_pos(0) { }
+
+        bool open(const std::string &filename) { return false; }
+        void close() { }
+        bool eof() const { return m_pos >= m_items.size(); }
+        bool isLoaded() const { return true; }
+        int row() const { return m_pos / 4 + 1; }
+        std::string line() const { return std::string(); }
+        Parser &operator >> (Item &out) {
+            out = eof() ? s_empty_item : m_items[m_pos++];
+            return *this;
+        }
+        Item nextItem() {
+            Item item;
+            (*this)>>item;
+            return item;
+        }
+
+    private:
+        const Items &m_items;
+        size_t m_pos;
+    };
+
+} // end namespace MenuCache
+
+#endif // MENUCACHE_HH
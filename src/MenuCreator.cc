@@ -38,7 +38,10 @@
 #include "AlphaMenu.hh"
 #include "Layer.hh"
 
+#include "MenuCache.hh"
 #include "FbMenuParser.hh"
+#include "PipeMenu.hh"
+#include "DirScanner.hh"
 #include "StyleMenuItem.hh"
 #include "RootCmdMenuItem.hh"
 
@@ -52,6 +55,8 @@
 #include "FbTk/FileUtil.hh"
 #include "FbTk/MenuSeparator.hh"
 #include "FbTk/Transparent.hh"
+#include "FbTk/Tracer.hh"
+#include "FbTk/StartupProfile.hh"
 
 #include <iostream>
 #include <algorithm>
@@ -138,6 +143,79 @@ void endFile() {
 }
 
 
+/// inserts the styles in 'entries' at 'pos' of 'menu', -1 appends them
+/// @return the number of inserted items
+int insertStyles(FbTk::Menu &menu, int pos, const string &stylesdir,
+                  const DirScanner::Entries &entries) {
+    int inserted = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const DirScanner::Entry &entry = entries[i];
+        // add to menu only if the file is a regular file, and not a
+        // .file or a backup~ file
+        if ((entry.regular &&
+             (entry.name[0] != '.') &&
+             (entry.name[entry.name.length() - 1] != '~')) ||
+            entry.style) {
+            menu.insert(new StyleMenuItem(entry.name, stylesdir + '/' + entry.name), pos);
+            if (pos != -1)
+                ++pos;
+            ++inserted;
+        }
+    }
+    return inserted;
+}
+
+/// inserts the files in 'entries' at 'pos' of 'menu', -1 appends them
+/// @return the number of inserted items
+int insertRootCmds(FbTk::Menu &menu, int pos, const string &rootcmddir,
+                    const DirScanner::Entries &entries, const string &cmd) {
+    int inserted = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const DirScanner::Entry &entry = entries[i];
+        // add to menu only if the file is a regular file, and not a
+        // .file or a backup~ file
+        if (entry.regular &&
+            (entry.name[0] != '.') &&
+            (entry.name[entry.name.length() - 1] != '~')) {
+            menu.insert(new RootCmdMenuItem(entry.name, rootcmddir + '/' + entry.name, cmd), pos);
+            if (pos != -1)
+                ++pos;
+            ++inserted;
+        }
+    }
+    return inserted;
+}
+
+/**
+ * Holds the place of the entries of a directory in its menu while the
+ * DirScanner lists it, and replaces itself with them afterwards.
+ */
+class DirectoryItem: public FbTk::MenuItem, public DirScanner::Client {
+public:
+    DirectoryItem(FbTk::Menu &menu, const string &directory,
+                  bool styles, const string &cmd):
+        FbTk::MenuItem(FbTk::BiDiString("..."), menu),
+        m_directory(directory), m_styles(styles), m_cmd(cmd) {
+        setEnabled(false);
+    }
+
+    void scanned(const DirScanner::Entries &entries) {
+        FbTk::Menu &host = *menu();
+        int pos = getIndex();
+        int inserted = m_styles ?
+            insertStyles(host, pos, m_directory, entries) :
+            insertRootCmds(host, pos, m_directory, entries, m_cmd);
+        // deletes us
+        host.remove(pos + inserted);
+        host.updateMenu();
+    }
+
+private:
+    string m_directory;
+    bool m_styles;
+    string m_cmd;
+};
+
 void createStyleMenu(FbTk::Menu &parent, const string &label,
                      AutoReloadHelper *reloader, const string &directory) {
     // perform shell style ~ home directory expansion
@@ -149,28 +227,14 @@ void createStyleMenu(FbTk::Menu &parent, const string &label,
     if (reloader)
         reloader->addFile(stylesdir);
 
-    FbTk::Directory dir(stylesdir.c_str());
-
-    // create a vector of all the filenames in the directory
-    // add sort it
-    vector<string> filelist(dir.entries());
-    for (size_t file_index = 0; file_index < dir.entries(); ++file_index)
-        filelist[file_index] = dir.readFilename();
-
-    sort(filelist.begin(), filelist.end(), less<string>());
+    DirectoryItem *item = new DirectoryItem(parent, stylesdir, true, "");
+    const DirScanner::Entries *entries = DirScanner::instance().scan(stylesdir, *item);
+    if (entries) {
+        delete item;
+        insertStyles(parent, -1, stylesdir, *entries);
+    } else
+        parent.insert(item);
 
-    // for each file in directory add filename and path to menu
-    for (size_t file_index = 0; file_index < dir.entries(); file_index++) {
-        string style(stylesdir + '/' + filelist[file_index]);
-        // add to menu only if the file is a regular file, and not a
-        // .file or a backup~ file
-        if ((FbTk::FileUtil::isRegularFile(style.c_str()) &&
-             (filelist[file_index][0] != '.') &&
-             (style[style.length() - 1] != '~')) ||
-            FbTk::FileUtil::isRegularFile((style + "/theme.cfg").c_str()) ||
-            FbTk::FileUtil::isRegularFile((style + "/style.cfg").c_str()))
-            parent.insert(new StyleMenuItem(filelist[file_index], style));
-    }
     // update menu graphics
     parent.updateMenu();
 
@@ -189,27 +253,14 @@ void createRootCmdMenu(FbTk::Menu &parent, const string &label,
     if (reloader)
         reloader->addFile(rootcmddir);
 
-    FbTk::Directory dir(rootcmddir.c_str());
-
-    // create a vector of all the filenames in the directory
-    // add sort it
-    vector<string> filelist(dir.entries());
-    for (size_t file_index = 0; file_index < dir.entries(); ++file_index)
-        filelist[file_index] = dir.readFilename();
-
-    sort(filelist.begin(), filelist.end(), less<string>());
-
-    // for each file in directory add filename and path to menu
-    for (size_t file_index = 0; file_index < dir.entries(); file_index++) {
+    DirectoryItem *item = new DirectoryItem(parent, rootcmddir, false, cmd);
+    const DirScanner::Entries *entries = DirScanner::instance().scan(rootcmddir, *item);
+    if (entries) {
+        delete item;
+        insertRootCmds(parent, -1, rootcmddir, *entries, cmd);
+    } else
+        parent.insert(item);
 
-        string rootcmd(rootcmddir+ '/' + filelist[file_index]);
-        // add to menu only if the file is a regular file, and not a
-        // .file or a backup~ file
-        if ((FbTk::FileUtil::isRegularFile(rootcmd.c_str()) &&
-             (filelist[file_index][0] != '.') &&
-             (rootcmd[rootcmd.length() - 1] != '~')))
-            parent.insert(new RootCmdMenuItem(filelist[file_index], rootcmd, cmd));
-    }
     // update menu graphics
     parent.updateMenu();
 
@@ -253,6 +304,71 @@ void translateMenuItem(FbTk::Parser &parse, ParseItem &item,
                        FbTk::StringConvertor &labelconvertor,
                        AutoReloadHelper *reloader);
 
+void parseMenu(FbTk::Parser &pars, FbTk::Menu &menu,
+               FbTk::StringConvertor &label_convertor,
+               AutoReloadHelper *reloader);
+
+/**
+ * A [submenu] that only keeps the lines of its [submenu] ... [end] block
+ * until it is opened the first time, so large generated menus don't build
+ * items, commands, icons and nested menus nobody looks at.
+ */
+class LazyMenu: public FbMenu {
+public:
+    LazyMenu(BScreen &screen, AutoReloadHelper *reloader):
+        FbMenu(screen.menuTheme(), screen.imageControl(),
+               *screen.layerManager().getLayer(ResourceLayer::MENU)),
+        m_reloader(reloader) { }
+
+    /// takes the lines up to the matching [end] from the parser
+    void record(FbTk::Parser &parse, FbTk::StringConvertor &labelconvertor) {
+        int depth = 0;
+        FbTk::Parser::Item key, label, cmd, icon;
+        while (!parse.eof()) {
+            parse>>key>>label>>cmd>>icon;
+            // labels are recoded now, the encoding is known only here
+            label.second = labelconvertor.recode(label.second);
+            if (key.second == "encoding") {
+                startEncoding(cmd.second);
+                continue;
+            } else if (key.second == "endencoding") {
+                endEncoding();
+                continue;
+            } else if (key.second == "end") {
+                if (depth-- == 0)
+                    return;
+            } else if (key.second == "submenu")
+                ++depth;
+            else if (key.second.empty())
+                continue;
+            m_items.push_back(key);
+            m_items.push_back(label);
+            m_items.push_back(cmd);
+            m_items.push_back(icon);
+        }
+    }
+
+protected:
+    void populate() {
+        if (m_items.empty())
+            return;
+
+        vector<FbTk::Parser::Item> items;
+        items.swap(m_items);
+        MenuCache::ItemParser parser(items);
+        // already recoded
+        FbTk::StringConvertor convertor(FbTk::StringConvertor::ToFbString);
+        startFile();
+        parseMenu(parser, *this, convertor, m_reloader);
+        endFile();
+        updateMenu();
+    }
+
+private:
+    vector<FbTk::Parser::Item> m_items;
+    AutoReloadHelper *m_reloader; ///< owned by the menu at the top
+};
+
 
 void parseMenu(FbTk::Parser &pars, FbTk::Menu &menu,
                FbTk::StringConvertor &label_convertor,
@@ -352,20 +468,30 @@ void translateMenuItem(FbTk::Parser &parse, ParseItem &pitem,
     } // end of include
     else if (str_key == "submenu") {
 
-        FbTk::Menu *submenu = MenuCreator::createMenu("", screen_number);
-        if (submenu == 0)
+        BScreen *screen = Fluxbox::instance()->findScreen(screen_number);
+        if (screen == 0)
             return;
+        LazyMenu *submenu = new LazyMenu(*screen, reloader);
 
         if (!str_cmd.empty())
             submenu->setLabel(str_cmd);
         else
             submenu->setLabel(str_label);
 
-        parseMenu(parse, *submenu, labelconvertor, reloader);
-        submenu->updateMenu();
+        // the items are built when it is opened
+        submenu->record(parse, labelconvertor);
         menu.insert(str_label, submenu);
 
     } // end of submenu
+    else if (str_key == "pipemenu") {
+        BScreen *screen = Fluxbox::instance()->findScreen(screen_number);
+        if (screen == 0 || str_cmd.empty())
+            return;
+        PipeMenu *submenu = new PipeMenu(*screen, str_cmd);
+        submenu->setLabel(str_label);
+        // the command runs when it is opened
+        menu.insert(str_label, submenu);
+    } // end of pipemenu
     else if (str_key == "stylesdir" || str_key == "stylesmenu") {
         createStyleMenu(menu, str_label, reloader,
                         str_key == "stylesmenu" ? str_cmd : str_label);
@@ -417,7 +543,7 @@ void translateMenuItem(FbTk::Parser &parse, ParseItem &pitem,
     }
 }
 
-bool getStart(FbMenuParser &parser, string &label, FbTk::StringConvertor &labelconvertor) {
+bool getStart(FbTk::Parser &parser, string &label, FbTk::StringConvertor &labelconvertor) {
     ParseItem pitem(0);
     while (!parser.eof()) {
         // get first begin line
@@ -452,11 +578,15 @@ FbMenu *MenuCreator::createMenu(const string &label, int screen_number) {
 bool MenuCreator::createFromFile(const string &filename,
                                  FbTk::Menu &inject_into,
                                  AutoReloadHelper *reloader, bool begin) {
+    FbTk::Tracer::Span span("menu", "MenuCreator::createFromFile");
+    FbTk::StartupProfile::Phase phase("menus");
     string real_filename = FbTk::StringUtil::expandFilename(filename);
 
-    FbMenuParser parser(real_filename);
-    if (!parser.isLoaded())
+    // tokenized only if the file changed since it was cached
+    MenuCache::Items items;
+    if (!MenuCache::load(real_filename, items))
         return false;
+    MenuCache::ItemParser parser(items);
 
     startFile();
     if (begin) {
@@ -478,6 +608,15 @@ bool MenuCreator::createFromFile(const string &filename,
     return true;
 }
 
+void MenuCreator::createFromText(const string &text, FbTk::Menu &inject_into) {
+    FbMenuParser parser;
+    parser.openText(text);
+
+    startFile();
+    parseMenu(parser, inject_into, s_stringconvertor, 0);
+    endFile();
+}
+
 FbMenu *MenuCreator::createMenuType(const string &type, int screen_num) {
     BScreen *screen = Fluxbox::instance()->findScreen(screen_num);
     if (screen == 0)
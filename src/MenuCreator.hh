@@ -43,6 +43,8 @@ namespace MenuCreator {
                         FbTk::Menu &inject_into,
                         FbTk::AutoReloadHelper *reloader = NULL,
                         bool begin = true);
+    /// adds the items described by 'text', like a menu file without [begin]
+    void createFromText(const std::string &text, FbTk::Menu &inject_into);
     bool createWindowMenuItem(const std::string &type, const std::string &label, 
                                      FbTk::Menu &inject_into);
 };
@@ -25,36 +25,55 @@
 #include "FbWinFrameTheme.hh"
 
 #include "FbTk/ImageControl.hh"
+#include "FbTk/GContext.hh"
+#include "FbTk/MemFun.hh"
+
+OSDWindow::OSDWindow(const FbTk::FbWindow &parent, BScreen &screen,
+                     FbTk::ThemeProxy<FbWinFrameTheme> &theme):
+    FbTk::FbWindow(parent, 0, 0, 10, 10, 0, false, true),
+    m_screen(screen), m_theme(theme),
+    m_pixmap(None), m_visible(false),
+    m_redraw_interval(0), m_last_redraw(0) {
+
+    m_redraw_timer.setFunctor(FbTk::MemFun(*this, &OSDWindow::redraw));
+    m_redraw_timer.fireOnce(true);
+}
 
 void OSDWindow::reconfigTheme() {
 
     setBorderWidth(m_theme->border().width());
     setBorderColor(m_theme->border().color());
 
-    if (m_pixmap)
-        m_screen.imageControl().removeImage(m_pixmap);
+    Pixmap old_pm = m_pixmap;
+    const FbTk::Texture &texture = backgroundTexture();
+    if (!texture.usePixmap()) {
+        m_pixmap = None;
+        setBackgroundColor(texture.color());
+    } else {
+        m_pixmap = m_screen.imageControl().renderImage(width(), height(),
+                texture);
+        setBackgroundPixmap(m_pixmap);
+    }
+    if (old_pm)
+        m_screen.imageControl().removeImage(old_pm);
+
+}
 
+const FbTk::Texture &OSDWindow::backgroundTexture() {
     if (m_theme->iconbarTheme().texture().type() &
-        FbTk::Texture::PARENTRELATIVE) {
-        if (!m_theme->titleTexture().usePixmap()) {
-            m_pixmap = None;
-            setBackgroundColor(m_theme->titleTexture().color());
-        } else {
-            m_pixmap = m_screen.imageControl().renderImage(width(), height(),
-                    m_theme->titleTexture());
-            setBackgroundPixmap(m_pixmap);
-        }
+        FbTk::Texture::PARENTRELATIVE)
+        return m_theme->titleTexture();
+    return m_theme->iconbarTheme().texture();
+}
+
+void OSDWindow::drawBackground(FbTk::FbDrawable &drawable) {
+    FbTk::GContext gc(drawable);
+    if (m_pixmap != None) {
+        drawable.copyArea(m_pixmap, gc.gc(), 0, 0, 0, 0, width(), height());
     } else {
-        if (!m_theme->iconbarTheme().texture().usePixmap()) {
-            m_pixmap = None;
-            setBackgroundColor(m_theme->iconbarTheme().texture().color());
-        } else {
-            m_pixmap = m_screen.imageControl().renderImage(width(), height(),
-                    m_theme->iconbarTheme().texture());
-            setBackgroundPixmap(m_pixmap);
-        }
+        gc.setForeground(backgroundTexture().color());
+        drawable.fillRectangle(gc.gc(), 0, 0, width(), height());
     }
-
 }
 
 void OSDWindow::resize(const FbTk::BiDiString &text) {
@@ -66,10 +85,28 @@ void OSDWindow::resize(const FbTk::BiDiString &text) {
 }
 
 void OSDWindow::showText(const FbTk::BiDiString &text) {
+    // moves and resizes call this with every step, mostly with the same text
+    if (m_visible && text.visual() == m_text.visual())
+        return;
+
+    m_text = text;
     show();
+
+    uint64_t since = FbTk::FbTime::mono() - m_last_redraw;
+    if (since >= m_redraw_interval)
+        redraw();
+    else if (!m_redraw_timer.isTiming()) {
+        m_redraw_timer.setTimeout(0, static_cast<unsigned int>(m_redraw_interval - since));
+        m_redraw_timer.start();
+    }
+}
+
+void OSDWindow::redraw() {
+    m_redraw_timer.stop();
+    m_last_redraw = FbTk::FbTime::mono();
     clear();
     m_theme->font().drawText(*this, m_screen.screenNumber(),
-            m_theme->iconbarTheme().text().textGC(), text,
+            m_theme->iconbarTheme().text().textGC(), m_text,
             m_theme->bevelWidth(),
             m_theme->bevelWidth() + m_theme->font().ascent());
 }
@@ -90,5 +127,6 @@ void OSDWindow::hide() {
     if (!m_visible)
         return;
     m_visible = false;
+    m_redraw_timer.stop();
     FbTk::FbWindow::hide();
 }
@@ -23,27 +23,32 @@
 #define OSDWINDOW_HH
 
 #include "FbTk/FbWindow.hh"
+#include "FbTk/FbString.hh"
+#include "FbTk/Timer.hh"
 
 class BScreen;
 class FbWinFrameTheme;
 
 namespace FbTk {
 template <class T> class ThemeProxy;
-class BiDiString;
+class Texture;
 }
 
 class OSDWindow: public FbTk::FbWindow {
 public:
     OSDWindow(const FbTk::FbWindow &parent, BScreen &screen,
-              FbTk::ThemeProxy<FbWinFrameTheme> &theme):
-        FbTk::FbWindow(parent, 0, 0, 10, 10, 0, false, true),
-        m_screen(screen), m_theme(theme),
-        m_pixmap(None), m_visible(false) { }
+              FbTk::ThemeProxy<FbWinFrameTheme> &theme);
 
     void reconfigTheme();
     void resize(const FbTk::BiDiString &text);
+    /**
+     * Shows 'text', unless it is shown already. Redraws come at most once
+     * per redraw interval, the last text is drawn when the interval is over.
+     */
     void showText(const FbTk::BiDiString &text);
     void hide();
+    /// @param interval minimum time between two redraws in micro-seconds
+    void setRedrawInterval(uint64_t interval) { m_redraw_interval = interval; }
 
     bool isVisible() const { return m_visible; }
     BScreen &screen() const { return m_screen; }
@@ -53,14 +58,22 @@ protected:
     void setVisible(bool visible) {
         m_visible = visible;
     }
+    /// draws the background of the last reconfigTheme() onto 'drawable'
+    void drawBackground(FbTk::FbDrawable &drawable);
 
 private:
     void show();
+    void redraw();
+    const FbTk::Texture &backgroundTexture();
 
     BScreen &m_screen;
     FbTk::ThemeProxy<FbWinFrameTheme> &m_theme;
     Pixmap m_pixmap;
     bool m_visible;
+
+    FbTk::BiDiString m_text; ///< the text of showText()
+    FbTk::Timer m_redraw_timer; ///< draws m_text once the interval is over
+    uint64_t m_redraw_interval, m_last_redraw;
 };
 
 #endif // OSDWINDOW_HH
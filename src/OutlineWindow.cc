@@ -0,0 +1,79 @@
+// OutlineWindow.cc
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#include "OutlineWindow.hh"
+
+#include "FbWinFrameTheme.hh"
+#include "fluxbox.hh"
+
+#ifdef SHAPE
+#include <X11/extensions/shape.h>
+#endif // SHAPE
+
+OutlineWindow::OutlineWindow(const FbTk::FbWindow &parent,
+                             FbTk::ThemeProxy<FbWinFrameTheme> &theme):
+    FbTk::FbWindow(parent, 0, 0, 1, 1, 0, true, false),
+    m_theme(theme),
+    m_visible(false) { }
+
+bool OutlineWindow::isSupported() {
+#ifdef SHAPE
+    return Fluxbox::instance()->haveShape();
+#else
+    return false;
+#endif // SHAPE
+}
+
+void OutlineWindow::showOutline(int x, int y,
+                                unsigned int width, unsigned int height) {
+    bool reshape = width != this->width() || height != this->height();
+    moveResize(x, y, width, height);
+    if (reshape)
+        updateShape();
+
+    if (!m_visible) {
+        setBackgroundColor(m_theme->border().color());
+        clear();
+        show();
+        raise();
+        m_visible = true;
+    }
+}
+
+void OutlineWindow::hide() {
+    FbTk::FbWindow::hide();
+    m_visible = false;
+}
+
+void OutlineWindow::updateShape() {
+#ifdef SHAPE
+    // keep a one pixel wide frame, the same as the outline on the root window
+    unsigned short w = width(), h = height();
+    XRectangle rects[4] = {
+        { 0, 0, w, 1 },
+        { 0, static_cast<short>(h - 1), w, 1 },
+        { 0, 0, 1, h },
+        { static_cast<short>(w - 1), 0, 1, h }
+    };
+    XShapeCombineRectangles(display(), window(), ShapeBounding, 0, 0,
+                            rects, 4, ShapeSet, Unsorted);
+#endif // SHAPE
+}
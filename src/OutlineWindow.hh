@@ -0,0 +1,58 @@
+// OutlineWindow.hh
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#ifndef OUTLINEWINDOW_HH
+#define OUTLINEWINDOW_HH
+
+#include "FbTk/FbWindow.hh"
+
+class FbWinFrameTheme;
+
+namespace FbTk {
+template <class T> class ThemeProxy;
+}
+
+/**
+ * A shaped window that outlines a moving window. Unlike drawing the outline
+ * on the root window, moving it needs neither redraws nor a server grab.
+ */
+class OutlineWindow: public FbTk::FbWindow {
+public:
+    OutlineWindow(const FbTk::FbWindow &parent,
+                  FbTk::ThemeProxy<FbWinFrameTheme> &theme);
+
+    /// @return true if the server can shape the outline window
+    static bool isSupported();
+
+    /// outlines the given area, width and height include the borders
+    void showOutline(int x, int y, unsigned int width, unsigned int height);
+    void hide();
+
+    bool isVisible() const { return m_visible; }
+
+private:
+    void updateShape();
+
+    FbTk::ThemeProxy<FbWinFrameTheme> &m_theme;
+    bool m_visible;
+};
+
+#endif // OUTLINEWINDOW_HH
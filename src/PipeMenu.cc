@@ -0,0 +1,196 @@
+// PipeMenu.cc for Fluxbox Window Manager
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "PipeMenu.hh"
+
+#include "Screen.hh"
+#include "Layer.hh"
+#include "MenuCreator.hh"
+#include "fluxbox.hh"
+
+#include "FbTk/FbTime.hh"
+#include "FbTk/I18n.hh"
+#include "FbTk/MemFun.hh"
+#include "FbTk/MenuItem.hh"
+#include "FbTk/Reactor.hh"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#ifdef HAVE_CERRNO
+  #include <cerrno>
+#else
+  #include <errno.h>
+#endif
+
+#ifdef HAVE_CSTDLIB
+  #include <cstdlib>
+#else
+  #include <stdlib.h>
+#endif
+
+using std::string;
+
+namespace {
+
+/// seconds a command may take to write the menu
+const unsigned int PIPE_TIMEOUT = 10;
+
+struct ReadOutput {
+    explicit ReadOutput(PipeMenu &menu): m_menu(menu) { }
+    void operator()(int fd, int events) const {
+        m_menu.readOutput();
+    }
+    PipeMenu &m_menu;
+};
+
+} // end anonymous namespace
+
+PipeMenu::PipeMenu(BScreen &screen, const string &command):
+    FbMenu(screen.menuTheme(), screen.imageControl(),
+           *screen.layerManager().getLayer(ResourceLayer::MENU)),
+    m_command(command),
+    m_fd(-1),
+    m_pid(-1),
+    m_updated(0) {
+    m_timeout.setTimeout(PIPE_TIMEOUT, 0);
+    m_timeout.fireOnce(true);
+    m_timeout.setFunctor(FbTk::MemFun(*this, &PipeMenu::timeout));
+}
+
+PipeMenu::~PipeMenu() {
+    stop();
+}
+
+void PipeMenu::populate() {
+    if (m_fd != -1)
+        return;
+
+    uint64_t ttl = Fluxbox::instance()->getPipeMenuTTL() * FbTk::FbTime::IN_SECONDS;
+    if (m_updated != 0 && FbTk::FbTime::mono() - m_updated < ttl)
+        return;
+
+    run();
+    // the menu can't be opened without items
+    if (numberOfItems() == 0) {
+        insert(new FbTk::MenuItem(FbTk::BiDiString("..."), *this));
+        setItemEnabled(0, false);
+        updateMenu();
+    }
+}
+
+void PipeMenu::run() {
+    int fds[2];
+    if (pipe(fds) != 0)
+        return;
+
+    pid_t pid = fork();
+    if (pid == -1) {
+        close(fds[0]);
+        close(fds[1]);
+        return;
+    }
+
+    if (pid == 0) {
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+
+        const char *shell = getenv("SHELL");
+        if (!shell)
+            shell = "/bin/sh";
+
+        setsid();
+        execl(shell, shell, "-c", m_command.c_str(), static_cast<void*>(NULL));
+        _exit(EXIT_FAILURE);
+    }
+
+    // fluxbox reaps the child on SIGCHLD
+    close(fds[1]);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    m_fd = fds[0];
+    m_pid = pid;
+    m_output.clear();
+    FbTk::Reactor::instance().addFunctor(m_fd, FbTk::Reactor::READ, ReadOutput(*this));
+    m_timeout.start();
+}
+
+void PipeMenu::readOutput() {
+    char buf[4096];
+    ssize_t size;
+    while ((size = read(m_fd, buf, sizeof(buf))) > 0)
+        m_output.append(buf, size);
+
+    if (size == 0)
+        finish();
+    else if (errno != EAGAIN && errno != EINTR)
+        stop();
+}
+
+void PipeMenu::stop() {
+    if (m_fd == -1)
+        return;
+
+    m_timeout.stop();
+    FbTk::Reactor::instance().remove(m_fd);
+    close(m_fd);
+    m_fd = -1;
+    m_pid = -1;
+    // a command that still runs gets SIGPIPE once it writes again
+    m_output.clear();
+}
+
+void PipeMenu::finish() {
+    string output;
+    output.swap(m_output);
+    m_timeout.stop();
+    FbTk::Reactor::instance().remove(m_fd);
+    close(m_fd);
+    m_fd = -1;
+    m_pid = -1;
+    m_updated = FbTk::FbTime::mono();
+
+    // the old items stay until the new ones are there
+    removeAll();
+    MenuCreator::createFromText(output, *this);
+    updateMenu();
+    if (numberOfItems() == 0)
+        hide();
+}
+
+void PipeMenu::timeout() {
+    // the command and whatever it started, they share its session
+    if (m_pid > 0)
+        kill(-m_pid, SIGKILL);
+    stop();
+
+    _FB_USES_NLS;
+    removeAll();
+    insert(new FbTk::MenuItem(_FB_XTEXT(Menu, PipeTimeout,
+                                        "Command timed out",
+                                        "A [pipemenu] command wrote no menu in time"),
+                              *this));
+    setItemEnabled(0, false);
+    updateMenu();
+}
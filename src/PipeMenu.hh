@@ -0,0 +1,75 @@
+// PipeMenu.hh for Fluxbox Window Manager
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#ifndef PIPEMENU_HH
+#define PIPEMENU_HH
+
+#include "FbMenu.hh"
+
+#include "FbTk/Timer.hh"
+
+#include <sys/types.h>
+
+#ifdef HAVE_INTTYPES_H
+#include <inttypes.h>
+#else
+#include <stdint.h>
+#endif // HAVE_INTTYPES_H
+
+#include <string>
+
+class BScreen;
+
+/**
+ * A [pipemenu] whose items are what a command writes to its stdout, in the
+ * syntax of a menu file between [begin] and [end]. The command runs in the
+ * background when the menu is opened and its output is older than
+ * session.pipeMenuTTL seconds; meanwhile the menu shows the items of the
+ * previous run, or a disabled "..." the first time. A command that doesn't
+ * close its stdout within a while is killed and the menu shows an error.
+ */
+class PipeMenu: public FbMenu {
+public:
+    PipeMenu(BScreen &screen, const std::string &command);
+    ~PipeMenu();
+
+    /// reads what the command wrote, called by the reactor
+    void readOutput();
+
+protected:
+    void populate();
+
+private:
+    void run();
+    void stop();
+    void finish();
+    void timeout();
+
+    std::string m_command;
+    std::string m_output; ///< of the running command
+    int m_fd; ///< stdout of the running command, -1 if none runs
+    pid_t m_pid; ///< of the running command, also its process group
+    FbTk::Timer m_timeout;
+    uint64_t m_updated; ///< when the items were last read, 0 never
+};
+
+#endif // PIPEMENU_HH
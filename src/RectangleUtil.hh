@@ -68,6 +68,33 @@ bool overlapRectangles(const RectangleLikeA& a, const RectangleLikeB& b) {
             b.x(), b.y(), b.width(), b.height());
 }
 
+/*
+ * Determines how much of rectangle 'a' rectangle 'b' covers
+ * @returns the area 'a' and 'b' share, 0 if they don't overlap
+ */
+inline long long overlapArea(
+        int ax, int ay, int awidth, int aheight,
+        int bx, int by, int bwidth, int bheight) {
+
+    int left = ax > bx ? ax : bx;
+    int top = ay > by ? ay : by;
+    int right = ax + awidth < bx + bwidth ? ax + awidth : bx + bwidth;
+    int bottom = ay + aheight < by + bheight ? ay + aheight : by + bheight;
+
+    if (right <= left || bottom <= top)
+        return 0;
+    return (long long)(right - left) * (bottom - top);
+}
+
+
+template <typename RectangleLikeA, typename RectangleLikeB>
+long long overlapArea(const RectangleLikeA& a, const RectangleLikeB& b) {
+
+    return overlapArea(
+            a.x(), a.y(), a.width(), a.height(),
+            b.x(), b.y(), b.width(), b.height());
+}
+
 } // namespace RectangleUtil
 
 
@@ -35,6 +35,8 @@
 #include "FbTk/I18n.hh"
 #include "FbTk/StringUtil.hh"
 #include "FbTk/FileUtil.hh"
+#include "FbTk/Tokenizer.hh"
+#include "FbTk/StartupProfile.hh"
 #include "FbTk/MenuItem.hh"
 #include "FbTk/App.hh"
 #include "FbTk/stringstream.hh"
@@ -56,6 +58,17 @@
 
 #include <iostream>
 #include <set>
+#include <vector>
+#ifdef HAVE_CSTDIO
+  #include <cstdio>
+#else
+  #include <stdio.h>
+#endif
+#ifdef HAVE_CSTDLIB
+  #include <cstdlib>
+#else
+  #include <stdlib.h>
+#endif
 
 
 using std::cerr;
@@ -64,7 +77,6 @@ using std::string;
 using std::list;
 using std::set;
 using std::make_pair;
-using std::ifstream;
 using std::ofstream;
 using std::hex;
 using std::dec;
@@ -192,6 +204,9 @@ public:
     bool is_transient, is_grouped;
     FbTk::RefCount<ClientPattern> group_pattern;
 
+    /// what the apps file last got for this app, empty if it changed since
+    string saved;
+
 };
 
 
@@ -206,6 +221,7 @@ Application::Application(bool transient, bool grouped, ClientPattern *pat):
 }
 
 void Application::reset() {
+    saved.clear();
     decostate_remember =
         dimensions_remember =
         focushiddenstate_remember =
@@ -413,161 +429,185 @@ bool handleStartupItem(const string &line, int offset) {
 
 
 
-// returns number of lines read
+/// reads the next line of the apps file, without the surrounding whitespace
+/// @return false at the end of the file
+bool nextLine(FbTk::Tokenizer &file, string &line) {
+    if (!file.nextLine())
+        return false;
+    FbTk::Tokenizer::strip(file.line()).assignTo(line);
+    return true;
+}
+
+/// reads the [key] a (stripped) line starts with
+/// @return the position after the key, or 0 if there is none
+int getKey(const string &line, string &key) {
+    if (line.empty() || line[0] != '[')
+        return 0;
+    string::size_type end = line.find(']', 1);
+    if (end == string::npos)
+        return 0;
+    key.assign(line, 1, end - 1);
+    return end + 1;
+}
+
 // optionally can give a line to read before the first (lookahead line)
-int parseApp(ifstream &file, Application &app, string *first_line = 0) {
+void parseApp(FbTk::Tokenizer &file, Application &app, const string *first_line = 0) {
     string line;
     _FB_USES_NLS;
-    int row = 0;
-    while (! file.eof()) {
-        if (first_line || getline(file, line)) {
-            if (first_line) {
-                line = *first_line;
-                first_line = 0;
-            }
+    string str_key, str_option, str_label;
+    while (first_line || nextLine(file, line)) {
+        if (first_line) {
+            line = *first_line;
+            first_line = 0;
+        }
 
-            row++;
-            FbTk::StringUtil::removeFirstWhitespace(line);
-            FbTk::StringUtil::removeTrailingWhitespace(line);
-            if (line.size() == 0 || line[0] == '#')
-                continue;  //the line is commented or blank
-
-            int parse_pos = 0, err = 0;
-            string str_key, str_option, str_label;
-
-            err = FbTk::StringUtil::getStringBetween(str_key,
-                                                     line.c_str(),
-                                                     '[', ']');
-            if (err > 0) {
-                int tmp;
-                tmp= FbTk::StringUtil::getStringBetween(str_option,
-                                                        line.c_str() + err,
-                                                        '(', ')');
-                if (tmp>0)
-                    err += tmp;
-            }
-            if (err > 0 ) {
+        if (line.size() == 0 || line[0] == '#')
+            continue;  //the line is commented or blank
+
+        int parse_pos = 0, err = 0;
+        str_option.clear();
+        str_label.clear();
+
+        err = getKey(line, str_key);
+        if (err > 0) {
+            int tmp;
+            tmp= FbTk::StringUtil::getStringBetween(str_option,
+                                                    line.c_str() + err,
+                                                    '(', ')');
+            if (tmp>0)
+                err += tmp;
+        }
+        if (err > 0 ) {
+            parse_pos += err;
+            err = FbTk::StringUtil::getStringBetween(str_label,
+                                                     line.c_str() + parse_pos,
+                                                     '{', '}');
+            if (err>0) {
                 parse_pos += err;
-                err = FbTk::StringUtil::getStringBetween(str_label,
-                                                         line.c_str() + parse_pos,
-                                                         '{', '}');
-                if (err>0) {
-                    parse_pos += err;
-                }
-            } else
-                continue; //read next line
-
-            bool had_error = false;
-
-            if (str_key.empty())
-                continue; //read next line
-
-            str_key = FbTk::StringUtil::toLower(str_key);
-
-            if (str_key == "workspace") {
-                unsigned int w;
-                if (FbTk::StringUtil::extractNumber(str_label, w))
-                    app.rememberWorkspace(w);
-                else
-                    had_error = true;
-            } else if (str_key == "head") {
-                unsigned int h;
-                if (FbTk::StringUtil::extractNumber(str_label, h))
-                    app.rememberHead(h);
-                else
-                    had_error = true;
-            } else if (str_key == "layer") {
-                int l = ResourceLayer::getNumFromString(str_label);
-                had_error = (l == -1);
-                if (!had_error)
-                    app.rememberLayer(l);
-            } else if (str_key == "dimensions") {
-                unsigned int h,w;
-                if (sscanf(str_label.c_str(), "%u %u", &w, &h) == 2)
-                    app.rememberDimensions(w, h);
-                else
-                    had_error = true;
-            } else if (str_key == "position") {
-                FluxboxWindow::ReferenceCorner r = FluxboxWindow::LEFTTOP;
-                int x = 0, y = 0;
-                // more info about the parameter
-                // in ::rememberPosition
-
-                if (str_option.length())
-                    r = FluxboxWindow::getCorner(str_option);
-                had_error = (r == FluxboxWindow::ERROR);
-
-                if (!had_error && sscanf(str_label.c_str(), "%d %d", &x, &y) == 2)
-                    app.rememberPosition(x, y, r);
-                else
-                    had_error = true;
-            } else if (str_key == "shaded") {
-                app.rememberShadedstate((strcasecmp(str_label.c_str(), "yes") == 0));
-            } else if (str_key == "tab") {
-                app.rememberTabstate((strcasecmp(str_label.c_str(), "yes") == 0));
-            } else if (str_key == "focushidden") {
-                app.rememberFocusHiddenstate((strcasecmp(str_label.c_str(), "yes") == 0));
-            } else if (str_key == "iconhidden") {
-                app.rememberIconHiddenstate((strcasecmp(str_label.c_str(), "yes") == 0));
-            } else if (str_key == "hidden") {
-                app.rememberIconHiddenstate((strcasecmp(str_label.c_str(), "yes") == 0));
-                app.rememberFocusHiddenstate((strcasecmp(str_label.c_str(), "yes") == 0));
-            } else if (str_key == "deco") {
-                int deco = WindowState::getDecoMaskFromString(str_label);
-                if (deco == -1)
-                    had_error = 1;
-                else
-                    app.rememberDecostate((unsigned int)deco);
-            } else if (str_key == "alpha") {
-                int focused_a, unfocused_a;
-                switch (sscanf(str_label.c_str(), "%i %i", &focused_a, &unfocused_a)) {
-                case 1: // 'alpha <focus>'
-                    unfocused_a = focused_a;
-                case 2: // 'alpha <focus> <unfocus>'
-                    focused_a = FbTk::Util::clamp(focused_a, 0, 255);
-                    unfocused_a = FbTk::Util::clamp(unfocused_a, 0, 255);
-                    app.rememberAlpha(focused_a, unfocused_a);
-                    break;
-                default:
-                    had_error = true;
-                    break;
-                }
-            } else if (str_key == "sticky") {
-                app.rememberStuckstate((strcasecmp(str_label.c_str(), "yes") == 0));
-            } else if (str_key == "focusnewwindow") {
-                app.rememberFocusNewWindow((strcasecmp(str_label.c_str(), "yes") == 0));
-            } else if (str_key == "minimized") {
-                app.rememberMinimizedstate((strcasecmp(str_label.c_str(), "yes") == 0));
-            } else if (str_key == "maximized") {
-                if (strcasecmp(str_label.c_str(), "yes") == 0)
-                    app.rememberMaximizedstate(WindowState::MAX_FULL);
-                else if (strcasecmp(str_label.c_str(), "horz") == 0)
-                    app.rememberMaximizedstate(WindowState::MAX_HORZ);
-                else if (strcasecmp(str_label.c_str(), "vert") == 0)
-                    app.rememberMaximizedstate(WindowState::MAX_VERT);
-                else
-                    app.rememberMaximizedstate(WindowState::MAX_NONE);
-            } else if (str_key == "fullscreen") {
-                app.rememberFullscreenstate((strcasecmp(str_label.c_str(), "yes") == 0));
-            } else if (str_key == "jump") {
-                app.rememberJumpworkspace((strcasecmp(str_label.c_str(), "yes") == 0));
-            } else if (str_key == "close") {
-                app.rememberSaveOnClose((strcasecmp(str_label.c_str(), "yes") == 0));
-            } else if (str_key == "end") {
-                return row;
-            } else {
-                cerr << _FB_CONSOLETEXT(Remember, Unknown, "Unknown apps key", "apps entry type not known")<<" = " << str_key << endl;
             }
-            if (had_error) {
-                cerr<<"Error parsing apps entry: ("<<line<<")"<<endl;
+        } else
+            continue; //read next line
+
+        bool had_error = false;
+
+        if (str_key.empty())
+            continue; //read next line
+
+        str_key = FbTk::StringUtil::toLower(str_key);
+
+        if (str_key == "workspace") {
+            unsigned int w;
+            if (FbTk::StringUtil::extractNumber(str_label, w))
+                app.rememberWorkspace(w);
+            else
+                had_error = true;
+        } else if (str_key == "head") {
+            unsigned int h;
+            if (FbTk::StringUtil::extractNumber(str_label, h))
+                app.rememberHead(h);
+            else
+                had_error = true;
+        } else if (str_key == "layer") {
+            int l = ResourceLayer::getNumFromString(str_label);
+            had_error = (l == -1);
+            if (!had_error)
+                app.rememberLayer(l);
+        } else if (str_key == "dimensions") {
+            unsigned int h,w;
+            if (sscanf(str_label.c_str(), "%u %u", &w, &h) == 2)
+                app.rememberDimensions(w, h);
+            else
+                had_error = true;
+        } else if (str_key == "position") {
+            FluxboxWindow::ReferenceCorner r = FluxboxWindow::LEFTTOP;
+            int x = 0, y = 0;
+            // more info about the parameter
+            // in ::rememberPosition
+
+            if (str_option.length())
+                r = FluxboxWindow::getCorner(str_option);
+            had_error = (r == FluxboxWindow::ERROR);
+
+            if (!had_error && sscanf(str_label.c_str(), "%d %d", &x, &y) == 2)
+                app.rememberPosition(x, y, r);
+            else
+                had_error = true;
+        } else if (str_key == "shaded") {
+            app.rememberShadedstate((strcasecmp(str_label.c_str(), "yes") == 0));
+        } else if (str_key == "tab") {
+            app.rememberTabstate((strcasecmp(str_label.c_str(), "yes") == 0));
+        } else if (str_key == "focushidden") {
+            app.rememberFocusHiddenstate((strcasecmp(str_label.c_str(), "yes") == 0));
+        } else if (str_key == "iconhidden") {
+            app.rememberIconHiddenstate((strcasecmp(str_label.c_str(), "yes") == 0));
+        } else if (str_key == "hidden") {
+            app.rememberIconHiddenstate((strcasecmp(str_label.c_str(), "yes") == 0));
+            app.rememberFocusHiddenstate((strcasecmp(str_label.c_str(), "yes") == 0));
+        } else if (str_key == "deco") {
+            int deco = WindowState::getDecoMaskFromString(str_label);
+            if (deco == -1)
+                had_error = 1;
+            else
+                app.rememberDecostate((unsigned int)deco);
+        } else if (str_key == "alpha") {
+            int focused_a, unfocused_a;
+            switch (sscanf(str_label.c_str(), "%i %i", &focused_a, &unfocused_a)) {
+            case 1: // 'alpha <focus>'
+                unfocused_a = focused_a;
+            case 2: // 'alpha <focus> <unfocus>'
+                focused_a = FbTk::Util::clamp(focused_a, 0, 255);
+                unfocused_a = FbTk::Util::clamp(unfocused_a, 0, 255);
+                app.rememberAlpha(focused_a, unfocused_a);
+                break;
+            default:
+                had_error = true;
+                break;
             }
+        } else if (str_key == "sticky") {
+            app.rememberStuckstate((strcasecmp(str_label.c_str(), "yes") == 0));
+        } else if (str_key == "focusnewwindow") {
+            app.rememberFocusNewWindow((strcasecmp(str_label.c_str(), "yes") == 0));
+        } else if (str_key == "minimized") {
+            app.rememberMinimizedstate((strcasecmp(str_label.c_str(), "yes") == 0));
+        } else if (str_key == "maximized") {
+            if (strcasecmp(str_label.c_str(), "yes") == 0)
+                app.rememberMaximizedstate(WindowState::MAX_FULL);
+            else if (strcasecmp(str_label.c_str(), "horz") == 0)
+                app.rememberMaximizedstate(WindowState::MAX_HORZ);
+            else if (strcasecmp(str_label.c_str(), "vert") == 0)
+                app.rememberMaximizedstate(WindowState::MAX_VERT);
+            else
+                app.rememberMaximizedstate(WindowState::MAX_NONE);
+        } else if (str_key == "fullscreen") {
+            app.rememberFullscreenstate((strcasecmp(str_label.c_str(), "yes") == 0));
+        } else if (str_key == "jump") {
+            app.rememberJumpworkspace((strcasecmp(str_label.c_str(), "yes") == 0));
+        } else if (str_key == "close") {
+            app.rememberSaveOnClose((strcasecmp(str_label.c_str(), "yes") == 0));
+        } else if (str_key == "end") {
+            return;
+        } else {
+            cerr << _FB_CONSOLETEXT(Remember, Unknown, "Unknown apps key", "apps entry type not known")<<" = " << str_key << endl;
+        }
+        if (had_error) {
+            cerr<<"Error parsing apps entry: ("<<line<<")"<<endl;
         }
     }
-    return row;
 }
 
 
 
+/// the patterns of the previous apps file by their text, so reloading
+/// finds the ones still in the file without comparing against each of them
+typedef std::multimap<string, Remember::Patterns::iterator> OldPatterns;
+
+void indexOldPatterns(Remember::Patterns &patlist, OldPatterns &index) {
+    Remember::Patterns::iterator it = patlist.begin();
+    Remember::Patterns::iterator it_end = patlist.end();
+    for (; it != it_end; ++it)
+        index.insert(make_pair(it->first->toString(), it));
+}
+
 /*
   This function is used to search for old instances of the same pattern
   (when reloading apps file). More than one pattern might match, but only
@@ -576,12 +616,13 @@ int parseApp(ifstream &file, Application &app, string *first_line = 0) {
   effectively moved into the new
 */
 
-Application* findMatchingPatterns(ClientPattern *pat, Remember::Patterns *patlist, bool transient, bool is_group, ClientPattern *match_pat = 0) {
+Application* findMatchingPatterns(ClientPattern *pat, Remember::Patterns *patlist, OldPatterns &index, bool transient, bool is_group, ClientPattern *match_pat = 0) {
 
-    Remember::Patterns::iterator it = patlist->begin();
-    Remember::Patterns::iterator it_end = patlist->end();
+    std::pair<OldPatterns::iterator, OldPatterns::iterator> candidates =
+        index.equal_range(pat->toString());
 
-    for (; it != it_end; ++it) {
+    for (; candidates.first != candidates.second; ++candidates.first) {
+        Remember::Patterns::iterator it = candidates.first->second;
         if (*it->first == *pat && is_group == it->second->is_grouped &&
             transient == it->second->is_transient &&
             ((match_pat == 0 && it->second->group_pattern == 0) ||
@@ -603,10 +644,16 @@ Application* findMatchingPatterns(ClientPattern *pat, Remember::Patterns *patlis
             }
 
             // forward
+            Remember::Patterns::iterator group_begin = it;
+            Remember::Patterns::iterator it_end = patlist->end();
             for(; it != it_end && it->second == ret; ++it) {
+                OldPatterns::iterator old = index.lower_bound(it->first->toString());
+                while (old->second != it)
+                    ++old;
+                index.erase(old);
                 delete it->first;
             }
-            patlist->erase(patlist->begin(), it);
+            patlist->erase(group_begin, it);
 
             return ret;
         }
@@ -615,15 +662,220 @@ Application* findMatchingPatterns(ClientPattern *pat, Remember::Patterns *patlis
     return 0;
 }
 
+/**
+ * Writes the apps file entry for @a, @pat is its (first) pattern.
+ */
+void writeApp(std::ostream &out, const Application &a, const ClientPattern &pat,
+              const Remember::Patterns &pats) {
+
+    if (a.is_grouped) {
+        // output this whole group
+        out << "[group]";
+        if (a.group_pattern)
+            out << " " << a.group_pattern->toString();
+        out << endl;
+
+        Remember::Patterns::const_iterator git = pats.begin();
+        Remember::Patterns::const_iterator git_end = pats.end();
+        for (; git != git_end; git++) {
+            if (git->second == &a) {
+                out << (a.is_transient ? " [transient]" : " [app]") <<
+                    git->first->toString()<<endl;
+            }
+        }
+    } else {
+        out << (a.is_transient ? "[transient]" : "[app]") <<
+            pat.toString()<<endl;
+    }
+    if (a.workspace_remember) {
+        out << "  [Workspace]\t{" << a.workspace << "}" << endl;
+    }
+    if (a.head_remember) {
+        out << "  [Head]\t{" << a.head << "}" << endl;
+    }
+    if (a.dimensions_remember) {
+        out << "  [Dimensions]\t{" << a.w << " " << a.h << "}" << endl;
+    }
+    if (a.position_remember) {
+        out << "  [Position]\t(";
+        switch(a.refc) {
+        case FluxboxWindow::CENTER:
+            out << "CENTER";
+            break;
+        case FluxboxWindow::LEFTBOTTOM:
+            out << "LOWERLEFT";
+            break;
+        case FluxboxWindow::RIGHTBOTTOM:
+            out << "LOWERRIGHT";
+            break;
+        case FluxboxWindow::RIGHTTOP:
+            out << "UPPERRIGHT";
+            break;
+        case FluxboxWindow::LEFT:
+            out << "LEFT";
+            break;
+        case FluxboxWindow::RIGHT:
+            out << "RIGHT";
+            break;
+        case FluxboxWindow::TOP:
+            out << "TOP";
+            break;
+        case FluxboxWindow::BOTTOM:
+            out << "BOTTOM";
+            break;
+        default:
+            out << "UPPERLEFT";
+        }
+        out << ")\t{" << a.x << " " << a.y << "}" << endl;
+    }
+    if (a.shadedstate_remember) {
+        out << "  [Shaded]\t{" << ((a.shadedstate)?"yes":"no") << "}" << endl;
+    }
+    if (a.tabstate_remember) {
+        out << "  [Tab]\t\t{" << ((a.tabstate)?"yes":"no") << "}" << endl;
+    }
+    if (a.decostate_remember) {
+        switch (a.decostate) {
+        case (0) :
+            out << "  [Deco]\t{NONE}" << endl;
+            break;
+        case (0xffffffff):
+        case (WindowState::DECOR_NORMAL):
+            out << "  [Deco]\t{NORMAL}" << endl;
+            break;
+        case (WindowState::DECOR_TOOL):
+            out << "  [Deco]\t{TOOL}" << endl;
+            break;
+        case (WindowState::DECOR_TINY):
+            out << "  [Deco]\t{TINY}" << endl;
+            break;
+        case (WindowState::DECOR_BORDER):
+            out << "  [Deco]\t{BORDER}" << endl;
+            break;
+        case (WindowState::DECORM_TAB):
+            out << "  [Deco]\t{TAB}" << endl;
+            break;
+        default:
+            out << "  [Deco]\t{0x"<<hex<<a.decostate<<dec<<"}"<<endl;
+            break;
+        }
+    }
+
+    if (a.focushiddenstate_remember || a.iconhiddenstate_remember) {
+        if (a.focushiddenstate_remember && a.iconhiddenstate_remember &&
+            a.focushiddenstate == a.iconhiddenstate)
+            out << "  [Hidden]\t{" << ((a.focushiddenstate)?"yes":"no") << "}" << endl;
+        else if (a.focushiddenstate_remember) {
+            out << "  [FocusHidden]\t{" << ((a.focushiddenstate)?"yes":"no") << "}" << endl;
+        } else if (a.iconhiddenstate_remember) {
+            out << "  [IconHidden]\t{" << ((a.iconhiddenstate)?"yes":"no") << "}" << endl;
+        }
+    }
+    if (a.stuckstate_remember) {
+        out << "  [Sticky]\t{" << ((a.stuckstate)?"yes":"no") << "}" << endl;
+    }
+    if (a.focusnewwindow_remember) {
+        out << "  [FocusNewWindow]\t{" << ((a.focusnewwindow)?"yes":"no") << "}" << endl;
+    }
+    if (a.minimizedstate_remember) {
+        out << "  [Minimized]\t{" << ((a.minimizedstate)?"yes":"no") << "}" << endl;
+    }
+    if (a.maximizedstate_remember) {
+        out << "  [Maximized]\t{";
+        switch (a.maximizedstate) {
+        case WindowState::MAX_FULL:
+            out << "yes" << "}" << endl;
+            break;
+        case WindowState::MAX_HORZ:
+            out << "horz" << "}" << endl;
+            break;
+        case WindowState::MAX_VERT:
+            out << "vert" << "}" << endl;
+            break;
+        case WindowState::MAX_NONE:
+        default:
+            out << "no" << "}" << endl;
+            break;
+        }
+    }
+    if (a.fullscreenstate_remember) {
+        out << "  [Fullscreen]\t{" << ((a.fullscreenstate)?"yes":"no") << "}" << endl;
+    }
+    if (a.jumpworkspace_remember) {
+        out << "  [Jump]\t{" << ((a.jumpworkspace)?"yes":"no") << "}" << endl;
+    }
+    if (a.layer_remember) {
+        out << "  [Layer]\t{" << a.layer << "}" << endl;
+    }
+    if (a.save_on_close_remember) {
+        out << "  [Close]\t{" << ((a.save_on_close)?"yes":"no") << "}" << endl;
+    }
+    if (a.alpha_remember) {
+        if (a.focused_alpha == a.unfocused_alpha)
+            out << "  [Alpha]\t{" << a.focused_alpha << "}" << endl;
+        else 
+            out << "  [Alpha]\t{" << a.focused_alpha << " " << a.unfocused_alpha << "}" << endl;
+    }
+    out << "[end]" << endl;
+}
+
 } // end anonymous namespace
 
 /*------------------------------------------------------------------*\
 \*------------------------------------------------------------------*/
 
+/**
+ * Most patterns require an exact name, class or role, so a client can only
+ * match the few that require its own. Those are listed by that value, the
+ * other patterns have to be tried for every client. The numbers are the
+ * positions in m_pats, so find() can still try them in file order.
+ */
+struct Remember::PatternIndex {
+    typedef std::vector<size_t> Positions;
+    typedef std::map<string, Positions> Literals;
+
+    enum { NAME, CLASS, ROLE, NUM_KEYS };
+
+    void clear() {
+        patterns.clear();
+        for (int i = 0; i < NUM_KEYS; ++i)
+            literals[i].clear();
+        others.clear();
+    }
+
+    void add(Patterns::value_type &pat) {
+        static const ClientPattern::WinProperty props[NUM_KEYS] = {
+            ClientPattern::NAME, ClientPattern::CLASS, ClientPattern::ROLE
+        };
+
+        size_t pos = patterns.size();
+        patterns.push_back(&pat);
+
+        string literal;
+        for (int i = 0; i < NUM_KEYS; ++i) {
+            if (pat.first->getLiteral(props[i], literal)) {
+                literals[i][literal].push_back(pos);
+                return;
+            }
+        }
+        others.push_back(pos);
+    }
+
+    const Positions *find(int key, const string &value) const {
+        Literals::const_iterator it = literals[key].find(value);
+        return it == literals[key].end() ? 0 : &it->second;
+    }
+
+    std::vector<Patterns::value_type *> patterns;
+    Literals literals[NUM_KEYS];
+    Positions others;
+};
+
 Remember *Remember::s_instance = 0;
 
 Remember::Remember():
     m_pats(new Patterns()),
+    m_index(new PatternIndex()),
     m_reloader(new FbTk::AutoReloadHelper()) {
 
     setName("remember");
@@ -636,12 +888,22 @@ Remember::Remember():
 
     m_reloader->setReloadCmd(FbTk::RefCount<FbTk::Command<void> >(new FbTk::SimpleCommand<Remember>(*this, &Remember::reload)));
     reconfigure();
+
+    m_save_timer.setTimeout(0, 500000);
+    m_save_timer.fireOnce(true);
+    m_save_timer.setFunctor(FbTk::MemFun(*this, &Remember::writeAppsFile));
 }
 
 Remember::~Remember() {
 
     // free our resources
 
+    // don't lose changes that are still waiting to be saved
+    if (m_save_timer.isTiming()) {
+        m_save_timer.stop();
+        writeAppsFile();
+    }
+
     // the patterns free the "Application"s
     // the client mapping shouldn't need cleaning
     Patterns::iterator it;
@@ -665,19 +927,43 @@ Remember::~Remember() {
 
 Application* Remember::find(WinClient &winclient) {
     // if it is already associated with a application, return that one
-    // otherwise, check it against every pattern that we've got
+    // otherwise, check it against every pattern that could match
     Clients::iterator wc_it = m_clients.find(&winclient);
     if (wc_it != m_clients.end())
         return wc_it->second;
-    else {
-        Patterns::iterator it = m_pats->begin();
-        for (; it != m_pats->end(); it++)
-            if (it->first->match(winclient) &&
-                it->second->is_transient == winclient.isTransient()) {
-                it->first->addMatch();
-                m_clients[&winclient] = it->second;
-                return it->second;
-            }
+
+    // the candidates are in up to four lists, each in file order
+    const PatternIndex::Positions *lists[PatternIndex::NUM_KEYS + 1];
+    size_t next[PatternIndex::NUM_KEYS + 1];
+    int num_lists = 0;
+
+    lists[num_lists++] = m_index->find(PatternIndex::NAME, winclient.getWMClassName());
+    lists[num_lists++] = m_index->find(PatternIndex::CLASS, winclient.getWMClassClass());
+    if (!m_index->literals[PatternIndex::ROLE].empty())
+        lists[num_lists++] = m_index->find(PatternIndex::ROLE, winclient.getWMRole());
+    lists[num_lists++] = &m_index->others;
+
+    for (int i = 0; i < num_lists; ++i)
+        next[i] = 0;
+
+    while (true) {
+        int first = -1;
+        for (int i = 0; i < num_lists; ++i) {
+            if (lists[i] && next[i] < lists[i]->size() &&
+                (first < 0 || (*lists[i])[next[i]] < (*lists[first])[next[first]]))
+                first = i;
+        }
+        if (first < 0)
+            break;
+
+        Patterns::value_type &pat =
+            *m_index->patterns[(*lists[first])[next[first]++]];
+        if (pat.first->match(winclient) &&
+            pat.second->is_transient == winclient.isTransient()) {
+            pat.first->addMatch();
+            addClient(winclient, pat.second);
+            return pat.second;
+        }
     }
     // oh well, no matches
     return 0;
@@ -696,9 +982,10 @@ Application * Remember::add(WinClient &winclient) {
     p->addTerm(win_class, ClientPattern::CLASS);
     if (!win_role.empty())
         p->addTerm(win_role, ClientPattern::ROLE);
-    m_clients[&winclient] = app;
+    addClient(winclient, app);
     p->addMatch();
     m_pats->push_back(make_pair(p, app));
+    m_index->add(m_pats->back());
     return app;
 }
 
@@ -714,37 +1001,34 @@ void Remember::checkReload() {
 }
 
 void Remember::reload() {
+    FbTk::StartupProfile::Phase phase("apps");
     string apps_string = FbTk::StringUtil::expandFilename(Fluxbox::instance()->getAppsFilename());
 
 
     fbdbg<<"("<<__FUNCTION__<<"): Loading apps file ["<<apps_string<<"]"<<endl;
 
-    ifstream apps_file(apps_string.c_str());
+    FbTk::MappedFile apps_file;
 
     // we merge the old patterns with new ones
     Patterns *old_pats = m_pats.release();
+    OldPatterns old_index;
+    indexOldPatterns(*old_pats, old_index);
     set<Application *> reused_apps;
     m_pats.reset(new Patterns());
     m_startups.clear();
 
-    if (!apps_file.fail()) {
-        if (!apps_file.eof()) {
-            string line;
-            int row = 0;
+    if (apps_file.open(apps_string.c_str())) {
+        if (apps_file.size() > 0) {
+            FbTk::Tokenizer reader(apps_file);
+            string line, key;
             bool in_group = false;
             ClientPattern *pat = 0;
             list<ClientPattern *> grouped_pats;
-            while (getline(apps_file, line) && ! apps_file.eof()) {
-                row++;
-                FbTk::StringUtil::removeFirstWhitespace(line);
-                FbTk::StringUtil::removeTrailingWhitespace(line);
+            while (nextLine(reader, line)) {
                 if (line.size() == 0 || line[0] == '#')
                     continue;
-                string key;
                 int err=0;
-                int pos = FbTk::StringUtil::getStringBetween(key,
-                                                             line.c_str(),
-                                                             '[', ']');
+                int pos = getKey(line, key);
 
                 if (pos > 0 && (strcasecmp(key.c_str(), "app") == 0 ||
                                 strcasecmp(key.c_str(), "transient") == 0)) {
@@ -754,7 +1038,7 @@ void Remember::reload() {
                             bool transient = (strcasecmp(key.c_str(),
                                                          "transient") == 0);
                             Application *app = findMatchingPatterns(pat,
-                                                   old_pats, transient, false);
+                                                   old_pats, old_index, transient, false);
                             if (app) {
                                 app->reset();
                                 reused_apps.insert(app);
@@ -763,9 +1047,9 @@ void Remember::reload() {
                             }
 
                             m_pats->push_back(make_pair(pat, app));
-                            row += parseApp(apps_file, *app);
+                            parseApp(reader, *app);
                         } else {
-                            cerr<<"Error reading apps file at line "<<row<<", column "<<(err+pos)<<"."<<endl;
+                            cerr<<"Error reading apps file at line "<<reader.row()<<", column "<<(err+pos)<<"."<<endl;
                             delete pat; // since it didn't work
                         }
                     } else {
@@ -774,7 +1058,7 @@ void Remember::reload() {
                 } else if (pos > 0 && strcasecmp(key.c_str(), "startup") == 0 &&
                            Fluxbox::instance()->isStartup()) {
                     if (!handleStartupItem(line, pos)) {
-                        cerr<<"Error reading apps file at line "<<row<<"."<<endl;
+                        cerr<<"Error reading apps file at line "<<reader.row()<<"."<<endl;
                     }
                     // save the item even if it was bad (aren't we nice)
                     m_startups.push_back(line.substr(pos));
@@ -789,7 +1073,7 @@ void Remember::reload() {
                     list<ClientPattern *>::iterator it = grouped_pats.begin();
                     list<ClientPattern *>::iterator it_end = grouped_pats.end();
                     while (!app && it != it_end) {
-                        app = findMatchingPatterns(*it, old_pats, false,
+                        app = findMatchingPatterns(*it, old_pats, old_index, false,
                                                    in_group, pat);
                         ++it;
                     }
@@ -809,11 +1093,11 @@ void Remember::reload() {
                     // so finish it off with an empty application
                     // otherwise parse the app
                     if (!(pos>0 && strcasecmp(key.c_str(), "end") == 0)) {
-                        row += parseApp(apps_file, *app, &line);
+                        parseApp(reader, *app, &line);
                     }
                     in_group = false;
                 } else
-                    cerr<<"Error in apps file on line "<<row<<"."<<endl;
+                    cerr<<"Error in apps file on line "<<reader.row()<<"."<<endl;
 
             }
         } else {
@@ -838,33 +1122,49 @@ void Remember::reload() {
     }
 
     // now remove any client entries for the old apps
-    Clients::iterator cit = m_clients.begin();
-    Clients::iterator cit_end = m_clients.end();
-    while (cit != cit_end) {
-        if (old_apps.find(cit->second) != old_apps.end()) {
-            Clients::iterator tmpit = cit;
-            ++cit;
-            m_clients.erase(tmpit);
-        } else {
-            ++cit;
-        }
-    }
-
     set<Application *>::iterator ait = old_apps.begin(); // no duplicates
     for (; ait != old_apps.end(); ++ait) {
+        AppClients::iterator app_it = m_app_clients.find(*ait);
+        if (app_it != m_app_clients.end()) {
+            std::list<WinClient *>::iterator cit = app_it->second.begin();
+            for (; cit != app_it->second.end(); ++cit)
+                m_clients.erase(*cit);
+            m_app_clients.erase(app_it);
+        }
         delete (*ait);
     }
 
     delete old_pats;
+
+    buildIndex();
+}
+
+void Remember::buildIndex() {
+    m_index->clear();
+    Patterns::iterator it = m_pats->begin(), it_end = m_pats->end();
+    for (; it != it_end; ++it)
+        m_index->add(*it);
 }
 
 void Remember::save() {
+    if (!m_save_timer.isTiming())
+        m_save_timer.start();
+}
+
+void Remember::writeAppsFile() {
+
+    m_save_timer.stop();
 
     string apps_string = FbTk::StringUtil::expandFilename(Fluxbox::instance()->getAppsFilename());
 
+    // write next to the file a link points to, so the link stays
+    apps_string = FbTk::FileUtil::realPath(apps_string);
+
     fbdbg<<"("<<__FUNCTION__<<"): Saving apps file ["<<apps_string<<"]"<<endl;
 
-    ofstream apps_file(apps_string.c_str());
+    // the file is replaced in one go, it's never left half written
+    string tmp_string = apps_string + ".tmp";
+    ofstream apps_file(tmp_string.c_str());
 
     // first of all we output all the startup commands
     Startups::iterator sit = m_startups.begin();
@@ -880,161 +1180,28 @@ void Remember::save() {
 
     for (; it != it_end; ++it) {
         Application &a = *it->second;
-        if (a.is_grouped) {
-            // if already processed
-            if (grouped_apps.find(&a) != grouped_apps.end())
-                continue;
-            grouped_apps.insert(&a);
-            // otherwise output this whole group
-            apps_file << "[group]";
-            if (a.group_pattern)
-                apps_file << " " << a.group_pattern->toString();
-            apps_file << endl;
-
-            Patterns::iterator git = m_pats->begin();
-            Patterns::iterator git_end = m_pats->end();
-            for (; git != git_end; git++) {
-                if (git->second == &a) {
-                    apps_file << (a.is_transient ? " [transient]" : " [app]") <<
-                                 git->first->toString()<<endl;
-                }
-            }
-        } else {
-            apps_file << (a.is_transient ? "[transient]" : "[app]") <<
-                         it->first->toString()<<endl;
-        }
-        if (a.workspace_remember) {
-            apps_file << "  [Workspace]\t{" << a.workspace << "}" << endl;
-        }
-        if (a.head_remember) {
-            apps_file << "  [Head]\t{" << a.head << "}" << endl;
-        }
-        if (a.dimensions_remember) {
-            apps_file << "  [Dimensions]\t{" << a.w << " " << a.h << "}" << endl;
-        }
-        if (a.position_remember) {
-            apps_file << "  [Position]\t(";
-            switch(a.refc) {
-            case FluxboxWindow::CENTER:
-                apps_file << "CENTER";
-                break;
-            case FluxboxWindow::LEFTBOTTOM:
-                apps_file << "LOWERLEFT";
-                break;
-            case FluxboxWindow::RIGHTBOTTOM:
-                apps_file << "LOWERRIGHT";
-                break;
-            case FluxboxWindow::RIGHTTOP:
-                apps_file << "UPPERRIGHT";
-                break;
-            case FluxboxWindow::LEFT:
-                apps_file << "LEFT";
-                break;
-            case FluxboxWindow::RIGHT:
-                apps_file << "RIGHT";
-                break;
-            case FluxboxWindow::TOP:
-                apps_file << "TOP";
-                break;
-            case FluxboxWindow::BOTTOM:
-                apps_file << "BOTTOM";
-                break;
-            default:
-                apps_file << "UPPERLEFT";
-            }
-            apps_file << ")\t{" << a.x << " " << a.y << "}" << endl;
-        }
-        if (a.shadedstate_remember) {
-            apps_file << "  [Shaded]\t{" << ((a.shadedstate)?"yes":"no") << "}" << endl;
-        }
-        if (a.tabstate_remember) {
-            apps_file << "  [Tab]\t\t{" << ((a.tabstate)?"yes":"no") << "}" << endl;
-        }
-        if (a.decostate_remember) {
-            switch (a.decostate) {
-            case (0) :
-                apps_file << "  [Deco]\t{NONE}" << endl;
-                break;
-            case (0xffffffff):
-            case (WindowState::DECOR_NORMAL):
-                apps_file << "  [Deco]\t{NORMAL}" << endl;
-                break;
-            case (WindowState::DECOR_TOOL):
-                apps_file << "  [Deco]\t{TOOL}" << endl;
-                break;
-            case (WindowState::DECOR_TINY):
-                apps_file << "  [Deco]\t{TINY}" << endl;
-                break;
-            case (WindowState::DECOR_BORDER):
-                apps_file << "  [Deco]\t{BORDER}" << endl;
-                break;
-            case (WindowState::DECORM_TAB):
-                apps_file << "  [Deco]\t{TAB}" << endl;
-                break;
-            default:
-                apps_file << "  [Deco]\t{0x"<<hex<<a.decostate<<dec<<"}"<<endl;
-                break;
-            }
-        }
-
-        if (a.focushiddenstate_remember || a.iconhiddenstate_remember) {
-            if (a.focushiddenstate_remember && a.iconhiddenstate_remember &&
-                a.focushiddenstate == a.iconhiddenstate)
-                apps_file << "  [Hidden]\t{" << ((a.focushiddenstate)?"yes":"no") << "}" << endl;
-            else if (a.focushiddenstate_remember) {
-                apps_file << "  [FocusHidden]\t{" << ((a.focushiddenstate)?"yes":"no") << "}" << endl;
-            } else if (a.iconhiddenstate_remember) {
-                apps_file << "  [IconHidden]\t{" << ((a.iconhiddenstate)?"yes":"no") << "}" << endl;
-            }
-        }
-        if (a.stuckstate_remember) {
-            apps_file << "  [Sticky]\t{" << ((a.stuckstate)?"yes":"no") << "}" << endl;
-        }
-        if (a.focusnewwindow_remember) {
-            apps_file << "  [FocusNewWindow]\t{" << ((a.focusnewwindow)?"yes":"no") << "}" << endl;
-        }
-        if (a.minimizedstate_remember) {
-            apps_file << "  [Minimized]\t{" << ((a.minimizedstate)?"yes":"no") << "}" << endl;
-        }
-        if (a.maximizedstate_remember) {
-            apps_file << "  [Maximized]\t{";
-            switch (a.maximizedstate) {
-            case WindowState::MAX_FULL:
-                apps_file << "yes" << "}" << endl;
-                break;
-            case WindowState::MAX_HORZ:
-                apps_file << "horz" << "}" << endl;
-                break;
-            case WindowState::MAX_VERT:
-                apps_file << "vert" << "}" << endl;
-                break;
-            case WindowState::MAX_NONE:
-            default:
-                apps_file << "no" << "}" << endl;
-                break;
-            }
+        // a group is written once, with all its patterns
+        if (a.is_grouped && !grouped_apps.insert(&a).second)
+            continue;
+
+        // only the apps that changed since the last save need formatting
+        if (a.saved.empty()) {
+            FbTk_ostringstream out;
+            writeApp(out, a, *it->first, *m_pats);
+            a.saved = out.str();
         }
-        if (a.fullscreenstate_remember) {
-            apps_file << "  [Fullscreen]\t{" << ((a.fullscreenstate)?"yes":"no") << "}" << endl;
-        }
-        if (a.jumpworkspace_remember) {
-            apps_file << "  [Jump]\t{" << ((a.jumpworkspace)?"yes":"no") << "}" << endl;
-        }
-        if (a.layer_remember) {
-            apps_file << "  [Layer]\t{" << a.layer << "}" << endl;
-        }
-        if (a.save_on_close_remember) {
-            apps_file << "  [Close]\t{" << ((a.save_on_close)?"yes":"no") << "}" << endl;
-        }
-        if (a.alpha_remember) {
-            if (a.focused_alpha == a.unfocused_alpha)
-                apps_file << "  [Alpha]\t{" << a.focused_alpha << "}" << endl;
-            else 
-                apps_file << "  [Alpha]\t{" << a.focused_alpha << " " << a.unfocused_alpha << "}" << endl;
-        }
-        apps_file << "[end]" << endl;
+        apps_file << a.saved;
     }
     apps_file.close();
+
+    bool written = !apps_file.fail();
+    if (!written)
+        remove(tmp_string.c_str());
+    if (!written || !FbTk::FileUtil::replaceFile(tmp_string, apps_string)) {
+        cerr<<"Failed to save apps file "<<apps_string<<endl;
+        return;
+    }
+
     // update timestamp to avoid unnecessary reload
     m_reloader->addFile(Fluxbox::instance()->getAppsFilename());
 }
@@ -1110,6 +1277,7 @@ void Remember::rememberAttrib(WinClient &winclient, Attribute attrib) {
         app = add(winclient);
         if (!app) return;
     }
+    app->saved.clear(); // needs formatting on the next save
     switch (attrib) {
     case REM_WORKSPACE:
         app->rememberWorkspace(win->workspaceNumber());
@@ -1185,6 +1353,7 @@ void Remember::forgetAttrib(WinClient &winclient, Attribute attrib) {
         app = add(winclient);
         if (!app) return;
     }
+    app->saved.clear(); // needs formatting on the next save
     switch (attrib) {
     case REM_WORKSPACE:
         app->forgetWorkspace();
@@ -1360,14 +1529,17 @@ FluxboxWindow *Remember::findGroup(Application *app, BScreen &screen) {
     if (!app || !app->is_grouped)
         return 0;
 
+    AppClients::iterator app_it = m_app_clients.find(app);
+    if (app_it == m_app_clients.end())
+        return 0;
+
     // find the first client associated with the app and return its fbwindow
-    Clients::iterator it = m_clients.begin();
-    Clients::iterator it_end = m_clients.end();
+    std::list<WinClient *>::iterator it = app_it->second.begin();
+    std::list<WinClient *>::iterator it_end = app_it->second.end();
     for (; it != it_end; ++it) {
-        if (it->second == app && it->first->fbwindow() &&
-            &screen == &it->first->screen() &&
-            (!app->group_pattern || app->group_pattern->match(*it->first)))
-            return it->first->fbwindow();
+        if ((*it)->fbwindow() && &screen == &(*it)->screen() &&
+            (!app->group_pattern || app->group_pattern->match(**it)))
+            return (*it)->fbwindow();
     }
 
     // there weren't any open, but that's ok
@@ -1411,10 +1583,27 @@ void Remember::updateClientClose(WinClient &winclient) {
     // we need to get rid of references to this client
     Clients::iterator wc_it = m_clients.find(&winclient);
 
-    if (wc_it != m_clients.end()) {
-        m_clients.erase(wc_it);
-    }
+    if (wc_it != m_clients.end())
+        removeClient(wc_it);
+
+}
 
+void Remember::addClient(WinClient &winclient, Application *app) {
+    Clients::iterator it = m_clients.find(&winclient);
+    if (it != m_clients.end())
+        removeClient(it);
+    m_clients[&winclient] = app;
+    m_app_clients[app].push_back(&winclient);
+}
+
+void Remember::removeClient(Clients::iterator it) {
+    AppClients::iterator app_it = m_app_clients.find(it->second);
+    if (app_it != m_app_clients.end()) {
+        app_it->second.remove(it->first);
+        if (app_it->second.empty())
+            m_app_clients.erase(app_it);
+    }
+    m_clients.erase(it);
 }
 
 void Remember::initForScreen(BScreen &screen) {
@@ -29,6 +29,8 @@
 #include "AtomHandler.hh"
 #include "ClientPattern.hh"
 
+#include "FbTk/Timer.hh"
+
 
 #include <map>
 #include <list>
@@ -96,6 +98,8 @@ public:
     // We keep track of which app is assigned to a winclient
     // particularly useful to update counters etc on windowclose
     typedef std::map<WinClient *, Application *> Clients;
+    /// the clients of each app, oldest first, so grouping looks at them only
+    typedef std::map<Application *, std::list<WinClient *> > AppClients;
 
     // we have to remember any startups we did so that they are saved again
     typedef std::list<std::string> Startups;
@@ -110,6 +114,7 @@ public:
     void reconfigure();
     void checkReload();
     void reload();
+    /// saves the apps file after a moment, so a burst of changes is written once
     void save();
 
     bool isRemembered(WinClient &win, Attribute attrib);
@@ -151,14 +156,27 @@ public:
     static Remember &instance() { return *s_instance; }
 
 private:
+    struct PatternIndex;
+
+    /// (re)builds m_index from m_pats
+    void buildIndex();
+    /// writes the apps file now, see save()
+    void writeAppsFile();
+    /// remembers that winclient belongs to app
+    void addClient(WinClient &winclient, Application *app);
+    /// forgets the app of winclient
+    void removeClient(Clients::iterator it);
 
     std::auto_ptr<Patterns> m_pats;
+    std::auto_ptr<PatternIndex> m_index; ///< the patterns find() has to try
     Clients m_clients;
+    AppClients m_app_clients;
 
     Startups m_startups;
     static Remember *s_instance;
 
     FbTk::AutoReloadHelper* m_reloader;
+    FbTk::Timer m_save_timer; ///< pending save()
 };
 
 #endif // REMEMBER_HH
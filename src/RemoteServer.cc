@@ -0,0 +1,415 @@
+// RemoteServer.cc for Fluxbox Window Manager
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#include "RemoteServer.hh"
+
+#include "Debug.hh"
+#include "FocusControl.hh"
+#include "Screen.hh"
+#include "WinClient.hh"
+#include "Workspace.hh"
+#include "fluxbox.hh"
+
+#include "FbTk/Command.hh"
+#include "FbTk/CommandParser.hh"
+#include "FbTk/MemFun.hh"
+#include "FbTk/Reactor.hh"
+#include "FbTk/StringUtil.hh"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#ifdef HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // HAVE_SYS_SOCKET_H
+
+#ifdef HAVE_CERRNO
+  #include <cerrno>
+#else
+  #include <errno.h>
+#endif
+
+#ifdef HAVE_CSTRING
+  #include <cstring>
+#else
+  #include <string.h>
+#endif
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using std::string;
+using std::cerr;
+using std::endl;
+using std::ostringstream;
+
+namespace {
+
+/// don't let a client that never reads make us buffer without end
+const size_t MAX_OUTPUT = 1024 * 1024;
+
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL; // no SIGPIPE if the client is gone
+#else
+const int SEND_FLAGS = 0;
+#endif // MSG_NOSIGNAL
+
+struct EventName {
+    const char *name;
+    RemoteServer::Event event;
+};
+
+const EventName EVENT_NAMES[] = {
+    { "workspace", RemoteServer::WORKSPACE },
+    { "focus", RemoteServer::FOCUS },
+    { "clientlist", RemoteServer::CLIENT_LIST },
+    { "title", RemoteServer::TITLE }
+};
+
+// an event is one line, whatever the title holds
+string oneLine(const string &text) {
+    string line(text);
+    for (string::iterator c = line.begin(); c != line.end(); ++c) {
+        if (*c == '\n' || *c == '\r')
+            *c = ' ';
+    }
+    return line;
+}
+
+} // end anonymous namespace
+
+struct RemoteServer::Ready {
+    explicit Ready(RemoteServer &server): m_server(&server) { }
+
+    void operator()(int fd, int events) const {
+        if (fd == m_server->m_fd)
+            m_server->accept();
+        else
+            m_server->handle(fd, events);
+    }
+
+    RemoteServer *m_server;
+};
+
+RemoteServer::RemoteServer(const string &path):
+    m_path(path),
+    m_fd(-1),
+    m_subscribed(0) {
+
+#ifdef HAVE_SYS_SOCKET_H
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (m_path.size() >= sizeof(address.sun_path)) {
+        cerr<<"Fluxbox: socket path too long: "<<m_path<<endl;
+        return;
+    }
+    strcpy(address.sun_path, m_path.c_str());
+
+    m_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_fd == -1)
+        return;
+    fcntl(m_fd, F_SETFD, FD_CLOEXEC);
+    fcntl(m_fd, F_SETFL, O_NONBLOCK);
+
+    // a socket left behind by a crash or restart
+    unlink(m_path.c_str());
+
+    // only the user may connect
+    mode_t old_mask = umask(077);
+    int bound = bind(m_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+    umask(old_mask);
+
+    if (bound == -1 || listen(m_fd, 8) == -1) {
+        cerr<<"Fluxbox: can't listen on "<<m_path<<": "<<strerror(errno)<<endl;
+        ::close(m_fd);
+        m_fd = -1;
+        return;
+    }
+
+    FbTk::Reactor::instance().addFunctor(m_fd, FbTk::Reactor::READ, Ready(*this));
+    fbdbg<<"RemoteServer: listening on "<<m_path<<endl;
+#endif // HAVE_SYS_SOCKET_H
+}
+
+RemoteServer::~RemoteServer() {
+#ifdef HAVE_SYS_SOCKET_H
+    while (!m_connections.empty())
+        close(m_connections.begin()->first);
+
+    if (m_fd != -1) {
+        FbTk::Reactor::instance().remove(m_fd);
+        ::close(m_fd);
+        unlink(m_path.c_str());
+    }
+#endif // HAVE_SYS_SOCKET_H
+}
+
+void RemoteServer::watch(BScreen &screen) {
+    join(screen.currentWorkspaceSig(),
+         FbTk::MemFun(*this, &RemoteServer::workspaceChanged));
+    join(screen.focusedWindowSig(),
+         FbTk::MemFun(*this, &RemoteServer::focusChanged));
+    join(screen.clientListSig(),
+         FbTk::MemFun(*this, &RemoteServer::clientListChanged));
+    clientListChanged(screen);
+}
+
+string RemoteServer::execute(const string &line) {
+    string command(line);
+    FbTk::StringUtil::removeFirstWhitespace(command);
+    FbTk::StringUtil::removeTrailingWhitespace(command);
+    if (command.empty() || command[0] == '#')
+        return "ok";
+
+    if (command == "stats") {
+        std::ostringstream stats;
+        Fluxbox::instance()->writeStatsJson(stats);
+        return "stats " + stats.str();
+    }
+
+    FbTk::RefCount<FbTk::Command<void> > cmd(
+        FbTk::CommandParser<void>::instance().parseCached(command, false));
+    if (cmd == 0)
+        return "error: unknown or invalid command";
+    cmd->execute();
+    return "ok";
+}
+
+void RemoteServer::accept() {
+#ifdef HAVE_SYS_SOCKET_H
+    int fd;
+    while ((fd = ::accept(m_fd, 0, 0)) != -1) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        m_connections[fd].closing = false;
+        m_connections[fd].events = 0;
+        FbTk::Reactor::instance().addFunctor(fd, FbTk::Reactor::READ, Ready(*this));
+    }
+#endif // HAVE_SYS_SOCKET_H
+}
+
+void RemoteServer::handle(int fd, int events) {
+#ifdef HAVE_SYS_SOCKET_H
+    Connections::iterator it = m_connections.find(fd);
+    if (it == m_connections.end())
+        return;
+    Connection &connection = it->second;
+
+    if (events & FbTk::Reactor::INVALID) {
+        close(fd);
+        return;
+    }
+
+    if (events & FbTk::Reactor::READ) {
+        char buffer[4096];
+        ssize_t got;
+        while ((got = read(fd, buffer, sizeof(buffer))) > 0)
+            connection.input.append(buffer, got);
+        if (got == 0 || (got == -1 && errno != EAGAIN && errno != EINTR))
+            connection.closing = true;
+
+        // run all complete lines, answers go out in the same order
+        string::size_type start = 0, end;
+        string answer;
+        while ((end = connection.input.find('\n', start)) != string::npos) {
+            string line(connection.input, start, end - start);
+            if (!subscribe(connection, line, answer))
+                answer = execute(line);
+            connection.output += answer;
+            connection.output += '\n';
+            start = end + 1;
+        }
+        connection.input.erase(0, start);
+
+        // a last line without newline
+        if (connection.closing && !connection.input.empty()) {
+            if (!subscribe(connection, connection.input, answer))
+                answer = execute(connection.input);
+            connection.output += answer + '\n';
+            connection.input.clear();
+        }
+    }
+
+    flush(fd, connection);
+
+    if (connection.output.size() > MAX_OUTPUT ||
+        (connection.closing && connection.output.empty()))
+        close(fd);
+#endif // HAVE_SYS_SOCKET_H
+}
+
+bool RemoteServer::subscribe(Connection &connection, const string &line,
+                             string &answer) {
+    std::vector<string> words;
+    FbTk::StringUtil::stringtok(words, line);
+    if (words.empty())
+        return false;
+
+    if (words[0] == "unsubscribe" && words.size() == 1) {
+        connection.events = 0;
+    } else if (words[0] == "subscribe") {
+        unsigned int events = (words.size() == 1 ? ALL_EVENTS : 0);
+        for (size_t i = 1; i < words.size(); ++i) {
+            size_t e = 0;
+            for (; e < sizeof(EVENT_NAMES) / sizeof(EVENT_NAMES[0]); ++e) {
+                if (words[i] == EVENT_NAMES[e].name)
+                    break;
+            }
+            if (e == sizeof(EVENT_NAMES) / sizeof(EVENT_NAMES[0])) {
+                answer = "error: unknown event " + words[i];
+                return true;
+            }
+            events |= EVENT_NAMES[e].event;
+        }
+        connection.events |= events;
+    } else
+        return false;
+
+    m_subscribed = 0;
+    Connections::const_iterator it = m_connections.begin();
+    for (; it != m_connections.end(); ++it)
+        m_subscribed |= it->second.events;
+
+    answer = "ok";
+    return true;
+}
+
+void RemoteServer::broadcast(Event event, const string &line) {
+#ifdef HAVE_SYS_SOCKET_H
+    std::vector<int> done;
+    Connections::iterator it = m_connections.begin();
+    for (; it != m_connections.end(); ++it) {
+        Connection &connection = it->second;
+        if (!(connection.events & event) || connection.closing)
+            continue;
+        connection.output += line;
+        connection.output += '\n';
+        flush(it->first, connection);
+        if (connection.output.size() > MAX_OUTPUT ||
+            (connection.closing && connection.output.empty()))
+            done.push_back(it->first);
+    }
+    for (size_t i = 0; i < done.size(); ++i)
+        close(done[i]);
+#endif // HAVE_SYS_SOCKET_H
+}
+
+void RemoteServer::workspaceChanged(BScreen &screen) {
+    if (!(m_subscribed & WORKSPACE))
+        return;
+    ostringstream line;
+    line<<"event workspace "<<screen.screenNumber()<<" "
+        <<screen.currentWorkspaceID()<<" "
+        <<oneLine(screen.currentWorkspace()->name());
+    broadcast(WORKSPACE, line.str());
+}
+
+void RemoteServer::focusChanged(BScreen &screen, FluxboxWindow *fbwin,
+                                WinClient *client) {
+    if (!(m_subscribed & FOCUS))
+        return;
+    ostringstream line;
+    line<<"event focus "<<screen.screenNumber()<<" 0x"<<std::hex
+        <<(client ? client->window() : 0)<<std::dec;
+    if (client)
+        line<<" "<<oneLine(client->title().logical());
+    broadcast(FOCUS, line.str());
+}
+
+void RemoteServer::clientListChanged(BScreen &screen) {
+    // follow the titles of new clients
+    const FocusableList::Focusables &clients =
+        screen.focusControl().creationOrderList().clientList();
+    FocusableList::Focusables::const_iterator it = clients.begin();
+    for (; it != clients.end(); ++it) {
+        FbTk::RefCount<FbTk::SignalTracker> &tracker = m_clients[*it];
+        if (tracker)
+            continue;
+        tracker.reset(new FbTk::SignalTracker);
+        tracker->join((*it)->titleSig(),
+                      FbTk::MemFun(*this, &RemoteServer::titleChanged));
+        tracker->join((*it)->dieSig(),
+                      FbTk::MemFun(*this, &RemoteServer::clientDied));
+    }
+
+    if (!(m_subscribed & CLIENT_LIST))
+        return;
+    ostringstream line;
+    line<<"event clientlist "<<screen.screenNumber()<<" "<<clients.size();
+    broadcast(CLIENT_LIST, line.str());
+}
+
+void RemoteServer::titleChanged(const string &title, Focusable &client) {
+    WinClient *winclient = dynamic_cast<WinClient *>(&client);
+    if (!(m_subscribed & TITLE) || !winclient)
+        return;
+    ostringstream line;
+    line<<"event title 0x"<<std::hex<<winclient->window()<<std::dec
+        <<" "<<oneLine(title);
+    broadcast(TITLE, line.str());
+}
+
+void RemoteServer::clientDied(Focusable &client) {
+    m_clients.erase(&client);
+}
+
+void RemoteServer::flush(int fd, Connection &connection) {
+#ifdef HAVE_SYS_SOCKET_H
+    while (!connection.output.empty()) {
+        ssize_t written = send(fd, connection.output.data(),
+                               connection.output.size(), SEND_FLAGS);
+        if (written == -1 && errno != EAGAIN && errno != EINTR) {
+            // nobody is listening anymore
+            connection.output.clear();
+            connection.closing = true;
+        }
+        if (written <= 0)
+            break;
+        connection.output.erase(0, written);
+    }
+    // wait until the client takes the rest, there is nothing left to
+    // read after the client closed its end
+    int events = connection.closing ? 0 : FbTk::Reactor::READ;
+    if (!connection.output.empty())
+        events |= FbTk::Reactor::WRITE;
+    FbTk::Reactor::instance().setEvents(fd, events);
+#endif // HAVE_SYS_SOCKET_H
+}
+
+void RemoteServer::close(int fd) {
+#ifdef HAVE_SYS_SOCKET_H
+    FbTk::Reactor::instance().remove(fd);
+    ::close(fd);
+    m_connections.erase(fd);
+
+    m_subscribed = 0;
+    Connections::const_iterator it = m_connections.begin();
+    for (; it != m_connections.end(); ++it)
+        m_subscribed |= it->second.events;
+#endif // HAVE_SYS_SOCKET_H
+}
@@ -0,0 +1,121 @@
+// RemoteServer.hh for Fluxbox Window Manager
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#ifndef REMOTESERVER_HH
+#define REMOTESERVER_HH
+
+#include "FbTk/NotCopyable.hh"
+#include "FbTk/RefCount.hh"
+#include "FbTk/Signal.hh"
+
+#include <map>
+#include <string>
+
+class BScreen;
+class FluxboxWindow;
+class Focusable;
+class WinClient;
+
+/**
+ * Runs the commands written to a unix domain socket, one per line, and
+ * answers every line with "ok" or "error: <reason>". Clients can send any
+ * number of commands over one connection without waiting for the answers,
+ * and none of it goes through the X server, unlike the _FLUXBOX_ACTION
+ * property. This is what fluxbox-remote --batch talks to.
+ *
+ * Commands are untrusted, like those of the property.
+ *
+ * A client that sends "subscribe [workspace] [focus] [clientlist] [title]"
+ * (all of them without arguments) is pushed a line starting with "event"
+ * whenever one of those changes on a watched screen, until it sends
+ * "unsubscribe":
+ *   event workspace <screen> <number> <name>
+ *   event focus <screen> <window> <title>
+ *   event clientlist <screen> <number of clients>
+ *   event title <window> <title>
+ * Windows are client window ids in hex, 0x0 for no window.
+ *
+ * "stats" is answered with "stats <json>", a snapshot of the counters of
+ * Fluxbox::writeStatsJson() on a single line, for monitoring.
+ */
+class RemoteServer: private FbTk::NotCopyable, private FbTk::SignalTracker {
+public:
+    enum Event {
+        WORKSPACE = 0x01,
+        FOCUS = 0x02,
+        CLIENT_LIST = 0x04,
+        TITLE = 0x08,
+        ALL_EVENTS = 0x0f
+    };
+
+    /// listens on the socket 'path', replacing a stale socket
+    explicit RemoteServer(const std::string &path);
+    /// closes all connections and removes the socket
+    ~RemoteServer();
+
+    bool isListening() const { return m_fd != -1; }
+    const std::string &path() const { return m_path; }
+
+    /// sends the events of the screen to the subscribers
+    void watch(BScreen &screen);
+
+    /// runs one line, @return the answer without newline
+    static std::string execute(const std::string &line);
+
+private:
+    struct Ready;
+    friend struct Ready;
+
+    struct Connection {
+        std::string input;  ///< an incomplete line
+        std::string output; ///< answers the client didn't take yet
+        bool closing;       ///< the client is done sending
+        unsigned int events; ///< the events the client subscribed to
+    };
+    typedef std::map<int, Connection> Connections;
+    typedef std::map<Focusable *, FbTk::RefCount<FbTk::SignalTracker> > Clients;
+
+    /// handles (un)subscribe, @return false for other lines
+    bool subscribe(Connection &connection, const std::string &line,
+                   std::string &answer);
+    /// sends 'line' to all subscribers of 'event'
+    void broadcast(Event event, const std::string &line);
+
+    void workspaceChanged(BScreen &screen);
+    void focusChanged(BScreen &screen, FluxboxWindow *fbwin, WinClient *client);
+    void clientListChanged(BScreen &screen);
+    void titleChanged(const std::string &title, Focusable &client);
+    void clientDied(Focusable &client);
+
+    void accept();
+    void handle(int fd, int events);
+    /// writes what the socket takes
+    void flush(int fd, Connection &connection);
+    void close(int fd);
+
+    std::string m_path;
+    int m_fd;
+    Connections m_connections;
+    unsigned int m_subscribed; ///< the events anybody subscribed to
+    Clients m_clients; ///< clients whose title we follow
+};
+
+#endif // REMOTESERVER_HH
@@ -0,0 +1,160 @@
+// RestartState.cc for Fluxbox Window Manager
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#include "RestartState.hh"
+#include "Screen.hh"
+#include "Window.hh"
+#include "WinClient.hh"
+#include "FocusControl.hh"
+#include "fluxbox.hh"
+#include "Debug.hh"
+
+#include "FbTk/App.hh"
+
+#ifdef HAVE_UNISTD_H
+#include <sys/types.h>
+#include <unistd.h>
+#endif // HAVE_UNISTD_H
+
+#include <cstdio>
+#include <fstream>
+
+using std::string;
+using std::endl;
+
+namespace {
+
+const char *MAGIC = "fluxbox-restart";
+const int VERSION = 1;
+
+long processId() {
+#ifdef HAVE_GETPID
+    return getpid();
+#else
+    return 0;
+#endif // HAVE_GETPID
+}
+
+} // end anonymous namespace
+
+RestartState::RestartState(const string &filename):
+    m_filename(filename) {
+    setName("restartstate");
+    load();
+}
+
+void RestartState::load() {
+    if (m_filename.empty())
+        return;
+
+    std::ifstream file(m_filename.c_str());
+    if (!file)
+        return;
+    // it's of no use to anyone else
+    remove(m_filename.c_str());
+
+    string magic, display;
+    int version = 0;
+    long pid = -1;
+    file >> magic >> version >> pid >> display;
+    if (magic != MAGIC || version != VERSION || pid != processId() ||
+        display != DisplayString(FbTk::App::instance()->display()))
+        return;
+
+    unsigned long win;
+    Client client;
+    while (file >> client.screen >> win >> client.layer >> client.decorations
+           >> client.focus_hidden >> client.icon_hidden >> client.default_alpha
+           >> client.focused_alpha >> client.unfocused_alpha) {
+        m_clients[win] = client;
+        m_focus_order.push_back(win);
+    }
+
+    fbdbg<<"RestartState: "<<m_clients.size()<<" clients from "<<m_filename<<endl;
+}
+
+void RestartState::save(const std::list<BScreen *> &screens) {
+    if (m_filename.empty())
+        return;
+
+    std::ofstream file(m_filename.c_str());
+    if (!file)
+        return;
+
+    file << MAGIC << ' ' << VERSION << ' ' << processId() << ' '
+         << DisplayString(FbTk::App::instance()->display()) << '\n';
+
+    std::list<BScreen *>::const_iterator screen = screens.begin();
+    for (; screen != screens.end(); ++screen) {
+        const FocusableList::Focusables &focused =
+            (*screen)->focusControl().focusedOrderList().clientList();
+        FocusableList::Focusables::const_iterator it = focused.begin();
+        for (; it != focused.end(); ++it) {
+            WinClient *client = dynamic_cast<WinClient *>(*it);
+            FluxboxWindow *win = client ? client->fbwindow() : 0;
+            if (win == 0)
+                continue;
+            file << (*screen)->screenNumber() << ' ' << client->window() << ' '
+                 << win->layerNum() << ' ' << win->decorationMask() << ' '
+                 << win->isFocusHidden() << ' ' << win->isIconHidden() << ' '
+                 << win->getUseDefaultAlpha() << ' '
+                 << win->getFocusedAlpha() << ' '
+                 << win->getUnfocusedAlpha() << '\n';
+        }
+    }
+}
+
+void RestartState::setupFrame(FluxboxWindow &win) {
+    // window ids get reused once we run
+    if (!Fluxbox::instance()->isStartup())
+        return;
+
+    Clients::const_iterator it = m_clients.find(win.winClient().window());
+    if (it == m_clients.end())
+        return;
+
+    const Client &client = it->second;
+    win.moveToLayer(client.layer);
+    win.setDecorationMask(client.decorations);
+    win.setFocusHidden(client.focus_hidden);
+    win.setIconHidden(client.icon_hidden);
+    if (client.default_alpha)
+        win.setDefaultAlpha();
+    else {
+        win.setFocusedAlpha(client.focused_alpha);
+        win.setUnfocusedAlpha(client.unfocused_alpha);
+    }
+}
+
+void RestartState::initForScreen(BScreen &screen) {
+    if (!Fluxbox::instance()->isStartup())
+        return;
+
+    std::vector<WinClient *> order;
+    for (size_t i = 0; i < m_focus_order.size(); ++i) {
+        WinClient *client = Fluxbox::instance()->searchWindow(m_focus_order[i]);
+        if (client && client->window() == m_focus_order[i] &&
+            &client->screen() == &screen && client->fbwindow())
+            order.push_back(client);
+    }
+    if (!order.empty())
+        screen.focusControl().setFocusOrder(order);
+}
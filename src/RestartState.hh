@@ -0,0 +1,90 @@
+// RestartState.hh for Fluxbox Window Manager
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#ifndef RESTARTSTATE_HH
+#define RESTARTSTATE_HH
+
+#include "AtomHandler.hh"
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * Hands the window state over to the next fluxbox on restart. Workspace,
+ * geometry, maximization and tabs survive as properties of the clients,
+ * but focus order, layers, decorations, alpha and the hidden flags would
+ * be lost or guessed from the apps file.
+ *
+ * save() writes them to a file right before the exec. The new process
+ * reads it if it was written by the same process id for the same display,
+ * deletes it, and applies it to the windows it adopts at startup.
+ */
+class RestartState: public AtomHandler {
+public:
+    explicit RestartState(const std::string &filename);
+
+    /// writes the state of all windows, in focus order
+    void save(const std::list<BScreen *> &screens);
+
+    void setupFrame(FluxboxWindow &win);
+    /// restores the focus order, once the windows of 'screen' are adopted
+    void initForScreen(BScreen &screen);
+
+    void setupClient(WinClient &winclient) { }
+    void updateFocusedWindow(BScreen &, Window) { }
+    void updateClientList(BScreen &screen) { }
+    void updateWorkspaceNames(BScreen &screen) { }
+    void updateCurrentWorkspace(BScreen &screen) { }
+    void updateWorkspaceCount(BScreen &screen) { }
+    void updateWorkarea(BScreen &) { }
+
+    void updateFrameClose(FluxboxWindow &win) { }
+    void updateClientClose(WinClient &winclient) { }
+    void updateWorkspace(FluxboxWindow &win) { }
+    void updateState(FluxboxWindow &win) { }
+    void updateHints(FluxboxWindow &win) { }
+    void updateLayer(FluxboxWindow &win) { }
+
+    bool checkClientMessage(const XClientMessageEvent &ce,
+        BScreen * screen, WinClient * const winclient) { return false; }
+    bool propertyNotify(WinClient &winclient, Atom the_property) { return false; }
+
+private:
+    struct Client {
+        int screen;
+        int layer;
+        unsigned int decorations;
+        bool focus_hidden, icon_hidden;
+        bool default_alpha;
+        int focused_alpha, unfocused_alpha;
+    };
+    typedef std::map<Window, Client> Clients;
+
+    void load();
+
+    std::string m_filename;
+    Clients m_clients;
+    std::vector<Window> m_focus_order; ///< of all screens
+};
+
+#endif // RESTARTSTATE_HH
@@ -31,6 +31,7 @@
 #include "FbTk/Image.hh"
 #include "FbTk/ImageControl.hh"
 #include "FbTk/Resource.hh"
+#include "FbTk/MemoryAccount.hh"
 #include "FbTk/FileUtil.hh"
 #include "FbTk/StringUtil.hh"
 #include "FbTk/TextureRender.hh"
@@ -179,6 +180,7 @@ bool RootTheme::fallback(FbTk::ThemeItem_base &item) {
 }
 
 void RootTheme::reconfigTheme() {
+    FbTk::MemoryAccount::Scope account(FbTk::MemoryAccount::IN_ROOT);
     if (!m_background->loaded())
         return;
 
@@ -33,6 +33,10 @@
 #include "Layer.hh"
 #include "FocusControl.hh"
 #include "ScreenPlacement.hh"
+#include "FbTk/RoundTrips.hh"
+#include "FbTk/PropertyPrefetch.hh"
+#include "FbTk/AtomCache.hh"
+#include "FbTk/StartupProfile.hh"
 
 // menu items
 #include "FbTk/BoolMenuItem.hh"
@@ -56,7 +60,10 @@
 #include "RectangleUtil.hh"
 #include "FbCommands.hh"
 #include "SystemTray.hh"
+#include "OutlineWindow.hh"
+#include "Compositor.hh"
 #include "Debug.hh"
+#include "Xutil.hh"
 
 #include "FbTk/I18n.hh"
 #include "FbTk/FbWindow.hh"
@@ -140,6 +147,7 @@ extern  "C" {
 #include <algorithm>
 #include <functional>
 #include <stack>
+#include <set>
 #ifdef HAVE_CSTRING
   #include <cstring>
 #else
@@ -163,6 +171,36 @@ using std::dec;
 static bool running = true;
 namespace {
 
+/// the properties of a new window that its setup reads, asked for at once;
+/// not _NET_WM_ICON, which can be megabytes
+const char *const adoption_names[] = {
+    "WM_PROTOCOLS", "WM_HINTS", "WM_NORMAL_HINTS", "WM_CLASS",
+    "WM_NAME", "WM_TRANSIENT_FOR", "WM_WINDOW_ROLE", "WM_STATE",
+    "_MOTIF_WM_HINTS", "_FLUXBOX_GROUP_LEFT",
+    "_NET_WM_NAME", "_NET_WM_WINDOW_TYPE",
+    "_NET_WM_STATE", "_NET_WM_DESKTOP", "_NET_WM_STRUT",
+    "_NET_WM_SYNC_REQUEST_COUNTER",
+    "_KDE_NET_WM_SYSTEM_TRAY_WINDOW_FOR", "KWM_DOCKWINDOW"
+};
+const size_t num_adoption_names = sizeof(adoption_names) / sizeof(adoption_names[0]);
+
+const char *const screen_names[] = {
+    "_NET_SUPPORTING_WM_CHECK", "_NET_CURRENT_DESKTOP", "_FLUXBOX_ACTION"
+};
+
+FbTk::AtomCache::Names queued_adoption_names(adoption_names, num_adoption_names);
+FbTk::AtomCache::Names queued_screen_names(screen_names,
+        sizeof(screen_names) / sizeof(screen_names[0]));
+
+const vector<Atom> &adoptionAtoms() {
+    static vector<Atom> atoms;
+    if (atoms.empty()) {
+        atoms.resize(num_adoption_names);
+        FbTk::AtomCache::instance().get(adoption_names, &atoms[0], atoms.size());
+    }
+    return atoms;
+}
+
 int anotherWMRunning(Display *display, XErrorEvent *) {
     _FB_USES_NLS;
     cerr<<_FB_CONSOLETEXT(Screen, AnotherWMRunning,
@@ -267,7 +305,9 @@ BScreen::ScreenResource::ScreenResource(FbTk::ResourceManager &rm,
                                         const string &scrname,
                                         const string &altscrname):
     opaque_move(rm, true, scrname + ".opaqueMove", altscrname+".OpaqueMove"),
+    outline_window(rm, false, scrname + ".outlineWindow", altscrname+".OutlineWindow"),
     full_max(rm, false, scrname+".fullMaximization", altscrname+".FullMaximization"),
+    fullscreen_unredirect(rm, false, scrname+".fullscreenUnredirect", altscrname+".FullscreenUnredirect"),
     max_ignore_inc(rm, true, scrname+".maxIgnoreIncrement", altscrname+".MaxIgnoreIncrement"),
     max_disable_move(rm, false, scrname+".maxDisableMove", altscrname+".MaxDisableMove"),
     max_disable_resize(rm, false, scrname+".maxDisableResize", altscrname+".MaxDisableResize"),
@@ -275,16 +315,22 @@ BScreen::ScreenResource::ScreenResource(FbTk::ResourceManager &rm,
     show_window_pos(rm, false, scrname+".showwindowposition", altscrname+".ShowWindowPosition"),
     auto_raise(rm, true, scrname+".autoRaise", altscrname+".AutoRaise"),
     click_raises(rm, true, scrname+".clickRaises", altscrname+".ClickRaises"),
+    compositor(rm, false, scrname+".compositor", altscrname+".Compositor"),
+    force_pseudo_trans(rm, false, scrname+".forcePseudoTransparency", altscrname+".ForcePseudoTransparency"),
     default_deco(rm, "NORMAL", scrname+".defaultDeco", altscrname+".DefaultDeco"),
     tab_placement(rm, FbWinFrame::TOPLEFT, scrname+".tab.placement", altscrname+".Tab.Placement"),
     windowmenufile(rm, Fluxbox::instance()->getDefaultDataFilename("windowmenu"), scrname+".windowMenu", altscrname+".WindowMenu"),
+    menu_search(rm, "itemstart", scrname+".menuSearch", altscrname+".MenuSearch"),
     typing_delay(rm, 0, scrname+".noFocusWhileTypingDelay", altscrname+".NoFocusWhileTypingDelay"),
     workspaces(rm, 4, scrname+".workspaces", altscrname+".Workspaces"),
     edge_snap_threshold(rm, 10, scrname+".edgeSnapThreshold", altscrname+".EdgeSnapThreshold"),
+    opaque_move_rate(rm, 0, scrname+".opaqueMoveRate", altscrname+".OpaqueMoveRate"),
+    decoration_release_delay(rm, 10, scrname+".decorationReleaseDelay", altscrname+".DecorationReleaseDelay"),
     focused_alpha(rm, 255, scrname+".window.focus.alpha", altscrname+".Window.Focus.Alpha"),
     unfocused_alpha(rm, 255, scrname+".window.unfocus.alpha", altscrname+".Window.Unfocus.Alpha"),
     menu_alpha(rm, 255, scrname+".menu.alpha", altscrname+".Menu.Alpha"),
     menu_delay(rm, 200, scrname + ".menuDelay", altscrname+".MenuDelay"),
+    menu_max_columns(rm, 3, scrname + ".menuMaxColumns", altscrname+".MenuMaxColumns"),
     tab_width(rm, 64, scrname + ".tab.width", altscrname+".Tab.Width"),
     tooltip_delay(rm, 500, scrname + ".tooltipDelay", altscrname+".TooltipDelay"),
     allow_remote_actions(rm, false, scrname+".allowRemoteActions", altscrname+".AllowRemoteActions"),
@@ -315,6 +361,7 @@ BScreen::BScreen(FbTk::ResourceManager &rm,
     m_geom_window(new OSDWindow(m_root_window, *this, *m_focused_windowtheme)),
     m_pos_window(new OSDWindow(m_root_window, *this, *m_focused_windowtheme)),
     m_tooltip_window(new TooltipWindow(m_root_window, *this, *m_focused_windowtheme)),
+    m_outline_window(new OutlineWindow(m_root_window, *m_focused_windowtheme)),
     m_dummy_window(scrn, -1, -1, 1, 1, 0, true, false, CopyFromParent,
                    InputOnly),
     resource(rm, screenname, altscreenname),
@@ -324,9 +371,14 @@ BScreen::BScreen(FbTk::ResourceManager &rm,
     m_focus_control(new FocusControl(*this)),
     m_placement_strategy(new ScreenPlacement(*this)),
     m_cycling(false), m_cycle_opts(0),
+    m_xinerama_avail(false), m_xinerama_num_heads(0),
     m_xinerama_headinfo(0),
+    m_root_resized(false),
     m_restart(false),
-    m_shutdown(false) {
+    m_shutdown(false),
+    m_update_lock(0),
+    m_clientlist_changed(false),
+    m_iconlist_changed(false) {
 
 
     Display *disp = m_root_window.display();
@@ -368,7 +420,7 @@ BScreen::BScreen(FbTk::ResourceManager &rm,
 #endif // HAVE_GETPID
 
     // check if we're the first EWMH compliant window manager on this screen
-    Atom wm_check = XInternAtom(disp, "_NET_SUPPORTING_WM_CHECK", False);
+    Atom wm_check = FbTk::AtomCache::instance().get("_NET_SUPPORTING_WM_CHECK");
     Atom xa_ret_type;
     int ret_format;
     unsigned long ret_nitems, ret_bytes_after;
@@ -387,8 +439,14 @@ BScreen::BScreen(FbTk::ResourceManager &rm,
     // use old set randr event
     XRRScreenChangeSelectInput(disp, rootWindow().window(), True);
 #else
+    // outputs and crtcs that change without resizing the root window
+    // only tell about themselves
     XRRSelectInput(disp, rootWindow().window(),
-                   RRScreenChangeNotifyMask);
+                   RRScreenChangeNotifyMask
+#ifdef HAVE_RANDR1_2
+                   | RRCrtcChangeNotifyMask | RROutputChangeNotifyMask
+#endif // HAVE_RANDR1_2
+                   );
 #endif // X_RRScreenChangeSelectInput
 
 #endif // HAVE_RANDR
@@ -414,6 +472,7 @@ BScreen::BScreen(FbTk::ResourceManager &rm,
 
     // load this screens resources
     fluxbox->load_rc(*this);
+    FbTk::Transparent::usePseudoTransparent(screenNumber(), *resource.force_pseudo_trans);
 
     // setup image cache engine
     m_image_control.reset(new FbTk::ImageControl(scrn,
@@ -432,9 +491,28 @@ BScreen::BScreen(FbTk::ResourceManager &rm,
     clampMenuDelay(*resource.menu_delay);
 
     m_menutheme->setDelay(*resource.menu_delay);
+    m_menutheme->setMaxColumns(*resource.menu_max_columns);
+    m_menutheme->setSearchMode(*resource.menu_search == "somewhere" ?
+                               FbTk::TYPEAHEAD_SUBSTRING : FbTk::TYPEAHEAD_PREFIX);
 
     m_tracker.join(focusedWinFrameTheme()->reconfigSig(),
             FbTk::MemFun(*this, &BScreen::focusedWinFrameThemeReconfigured));
+    m_tracker.join(unfocusedWinFrameTheme()->reconfigSig(),
+            FbTk::MemFun(*this, &BScreen::scheduleFrameReconfigure));
+
+    m_switch_stats.switches = 0;
+    m_switch_stats.total = m_switch_stats.max = 0;
+
+    m_reconfigure_frames_timer.setTimeout(0);
+    m_reconfigure_frames_timer.fireOnce(true);
+    m_reconfigure_frames_timer.setFunctor(FbTk::MemFun(*this, &BScreen::reconfigureFrames));
+    m_workspace_area_task.setFunctor(FbTk::MemFun(*this, &BScreen::signalWorkspaceArea));
+    m_root_pixmap_task.setFunctor(FbTk::MemFun(*this, &BScreen::updateRootPixmap));
+    m_menu_task.setFunctor(FbTk::MemFun(*this, &BScreen::loadMenus));
+    m_menus_loaded = false;
+    m_prerender_task.setFunctor(FbTk::MemFun(*this, &BScreen::prerenderWorkspaces));
+    m_prerender_step = 0;
+    m_last_workspace = 0;
 
 
     renderGeomWindow();
@@ -461,13 +539,13 @@ BScreen::BScreen(FbTk::ResourceManager &rm,
 
     m_configmenu.reset(createMenu(_FB_XTEXT(Menu, Configuration,
                                   "Configuration", "Title of configuration menu")));
-    setupConfigmenu(*m_configmenu.get());
+    // filled by loadMenus()
     m_configmenu->setInternalMenu();
 
     // check which desktop we should start on
     unsigned int first_desktop = 0;
     if (m_restart) {
-        Atom net_desktop = XInternAtom(disp, "_NET_CURRENT_DESKTOP", False);
+        Atom net_desktop = FbTk::AtomCache::instance().get("_NET_CURRENT_DESKTOP");
         bool exists;
         unsigned int ret=static_cast<unsigned int>(rootWindow().cardinalProperty(net_desktop, &exists));
         if (exists) {
@@ -479,10 +557,15 @@ BScreen::BScreen(FbTk::ResourceManager &rm,
     changeWorkspaceID(first_desktop);
 
 #ifdef SLIT
-    m_slit.reset(new Slit(*this, *layerManager().getLayer(ResourceLayer::DESKTOP),
-                 fluxbox->getSlitlistFilename().c_str()));
+    {
+        FbTk::StartupProfile::Phase phase("slit");
+        m_slit.reset(new Slit(*this, *layerManager().getLayer(ResourceLayer::DESKTOP),
+                     fluxbox->getSlitlistFilename().c_str()));
+    }
 #endif // SLIT
 
+    updateCompositor();
+
     rm.unlock();
 
     XFlush(disp);
@@ -496,7 +579,10 @@ BScreen::~BScreen() {
         return;
     
     m_configmenu.reset(0);
-    
+
+    // hands the windows back to the server before they go
+    m_compositor.reset(0);
+
     m_toolbar.reset(0);
 
     FbTk::EventManager *evm = FbTk::EventManager::instance();
@@ -587,99 +673,93 @@ bool BScreen::isRestart() {
 void BScreen::initWindows() {
 
 #ifdef USE_TOOLBAR
-    m_toolbar.reset(new Toolbar(*this,
-                                *layerManager().getLayer(::ResourceLayer::NORMAL)));
+    {
+        FbTk::StartupProfile::Phase phase("toolbar");
+        m_toolbar.reset(new Toolbar(*this,
+                                    *layerManager().getLayer(::ResourceLayer::NORMAL)));
+    }
 #endif // USE_TOOLBAR
 
+    FbTk::StartupProfile::Phase phase("adopt windows");
     unsigned int nchild;
     Window r, p, *children;
     Display *disp = FbTk::App::instance()->display();
+    FBTK_ROUNDTRIP("BScreen::initWindows");
     XQueryTree(disp, rootWindow().window(), &r, &p, &children, &nchild);
+    vector<Window> windows(children, children + nchild);
+    if (children)
+        XFree(children);
+
+    // ask for everything we read of the windows at once, the replies come
+    // with the sync
+    vector<FbTk::PropertyPrefetch *> prefetches;
+    prefetches.reserve(windows.size());
+    for (size_t i = 0; i < windows.size(); ++i)
+        prefetches.push_back(new FbTk::PropertyPrefetch(windows[i], adoptionAtoms()));
+    vector<Xutil::Attributes> attribs;
+    Xutil::getAttributes(windows, attribs);
+    FbTk::App::instance()->sync(false);
 
     // preen the window list of all icon windows... for better dockapp support
-    for (unsigned int i = 0; i < nchild; i++) {
+    std::set<Window> icon_windows;
+    for (size_t i = 0; i < windows.size(); ++i) {
+        XWMHints wmhints;
+        if (Xutil::getWMHints(windows[i], wmhints) &&
+            (wmhints.flags & IconWindowHint) &&
+            wmhints.icon_window != windows[i])
+            icon_windows.insert(wmhints.icon_window);
+    }
 
-        if (children[i] == None)
+    vector<Window> shown;
+    for (size_t i = 0; i < windows.size(); ++i) {
+        if (icon_windows.count(windows[i])) {
+            fbdbg<<"BScreen::initWindows(): icon_window = 0x"<<hex<<windows[i]<<dec<<endl;
             continue;
-
-        XWMHints *wmhints = XGetWMHints(disp, children[i]);
-
-        if (wmhints) {
-            if ((wmhints->flags & IconWindowHint) &&
-                (wmhints->icon_window != children[i]))
-                for (unsigned int j = 0; j < nchild; j++) {
-                    if (children[j] == wmhints->icon_window) {
-
-                        fbdbg<<"BScreen::initWindows(): children[j] = 0x"<<hex<<children[j]<<dec<<endl;
-                        fbdbg<<"BScreen::initWindows(): = icon_window"<<endl;
-
-                        children[j] = None;
-                        break;
-                    }
-                }
-            XFree(wmhints);
         }
-
+        if (attribs[i].valid && !attribs[i].override_redirect &&
+            attribs[i].map_state != IsUnmapped)
+            shown.push_back(windows[i]);
     }
 
     Fluxbox *fluxbox = Fluxbox::instance();
 
-    // manage shown windows
-    Window transient_for = 0;
+    // manage shown windows, and restack them all at once afterwards
+    m_layermanager.lock();
     bool safety_flag = false;
-    unsigned int num_transients = 0;
-    for (unsigned int i = 0; i <= nchild; ++i) {
-        if (i == nchild) {
-            if (num_transients) {
-                if (num_transients == nchild)
-                    safety_flag = true;
-                nchild = num_transients;
-                i = num_transients = 0;
-            } else
-                break;
-        }
-
-        if (children[i] == None)
-            continue;
-        else if (!fluxbox->validateWindow(children[i])) {
-
-            fbdbg<<"BScreen::initWindows(): not valid window = "<<hex<<children[i]<<dec<<endl;
-
-            children[i] = None;
-            continue;
-        }
-
-        // if we have a transient_for window and it isn't created yet...
-        // postpone creation of this window until after all others
-        if (XGetTransientForHint(disp, children[i], &transient_for) &&
-            fluxbox->searchWindow(transient_for) == 0 && !safety_flag) {
-            // add this window back to the beginning of the list of children
-            children[num_transients] = children[i];
-            num_transients++;
+    while (!shown.empty()) {
+        vector<Window> postponed;
+        for (size_t i = 0; i < shown.size(); ++i) {
+            if (!fluxbox->validateWindow(shown[i])) {
+                fbdbg<<"BScreen::initWindows(): not valid window = "<<hex<<shown[i]<<dec<<endl;
+                continue;
+            }
 
-            fbdbg<<"BScreen::initWindows(): postpone creation of 0x"<<hex<<children[i]<<dec<<endl;
-            fbdbg<<"BScreen::initWindows(): transient_for = 0x"<<hex<<transient_for<<dec<<endl;
+            // if we have a transient_for window and it isn't created yet...
+            // postpone creation of this window until after all others
+            Window transient_for = 0;
+            if (!safety_flag && Xutil::getTransientFor(shown[i], transient_for) &&
+                fluxbox->searchWindow(transient_for) == 0) {
+                postponed.push_back(shown[i]);
 
-            continue;
-        }
+                fbdbg<<"BScreen::initWindows(): postpone creation of 0x"<<hex<<shown[i]<<dec<<endl;
+                fbdbg<<"BScreen::initWindows(): transient_for = 0x"<<hex<<transient_for<<dec<<endl;
 
-
-        XWindowAttributes attrib;
-        if (XGetWindowAttributes(disp, children[i],
-                                 &attrib)) {
-            if (attrib.override_redirect) {
-                children[i] = None; // we dont need this anymore, since we already created a window for it
                 continue;
             }
 
-            if (attrib.map_state != IsUnmapped)
-                createWindow(children[i]);
-
+            adoptWindow(shown[i]);
         }
-        children[i] = None; // we dont need this anymore, since we already created a window for it
+
+        // nothing got created, their transient_for windows won't come
+        if (postponed.size() == shown.size())
+            safety_flag = true;
+        shown.swap(postponed);
     }
+    m_layermanager.unlock();
 
-    XFree(children);
+    for (size_t i = 0; i < prefetches.size(); ++i)
+        delete prefetches[i];
+    FbTk::App::instance()->sync(false);
 
     // now, show slit and toolbar
 #ifdef SLIT
@@ -687,6 +767,7 @@ void BScreen::initWindows() {
         slit()->show();
 #endif // SLIT
 
+    m_prerender_task.schedule();
 }
 
 unsigned int BScreen::currentWorkspaceID() const {
@@ -743,6 +824,26 @@ unsigned int BScreen::maxBottom(int head) const {
 void BScreen::focusedWinFrameThemeReconfigured() {
     renderGeomWindow();
     renderPosWindow();
+    scheduleFrameReconfigure();
+}
+
+void BScreen::scheduleFrameReconfigure() {
+    // both window themes signal a style change, and the button themes are
+    // loaded after them, so wait until they are all done
+    if (!m_reconfigure_frames_timer.isTiming())
+        m_reconfigure_frames_timer.start();
+}
+
+void BScreen::reconfigureFrames() {
+    Workspaces::iterator w_it = m_workspaces_list.begin();
+    Workspaces::iterator w_it_end = m_workspaces_list.end();
+    for (; w_it != w_it_end; ++w_it) {
+        Workspace::Windows &wins = (*w_it)->windowList();
+        for_each(wins.begin(), wins.end(),
+                 mem_fun(&FluxboxWindow::themeReconfigured));
+    }
+    for_each(m_icon_list.begin(), m_icon_list.end(),
+             mem_fun(&FluxboxWindow::themeReconfigured));
 
     Fluxbox *fluxbox = Fluxbox::instance();
     const std::list<Focusable *> winlist =
@@ -752,11 +853,11 @@ void BScreen::focusedWinFrameThemeReconfigured() {
     for (; it != it_end; ++it)
         fluxbox->updateFrameExtents(*(*it)->fbwindow());
 
+    XFlush(FbTk::App::instance()->display());
 }
 
 void BScreen::propertyNotify(Atom atom) {
-    static Atom fbcmd_atom = XInternAtom(FbTk::App::instance()->display(),
-                                         "_FLUXBOX_ACTION", False);
+    static Atom fbcmd_atom = FbTk::AtomCache::instance().get("_FLUXBOX_ACTION");
     if (allowRemoteActions() && atom == fbcmd_atom) {
         Atom xa_ret_type;
         int ret_format;
@@ -774,16 +875,57 @@ void BScreen::propertyNotify(Atom atom) {
                     &ret_bytes_after, (unsigned char **)&str);
             }
 
-            static std::auto_ptr<FbTk::Command<void> > cmd(0);
-            cmd.reset(FbTk::CommandParser<void>::instance().parse(str, false));
-            if (cmd.get())
+            // scripts tend to send the same commands again and again
+            FbTk::RefCount<FbTk::Command<void> > cmd(
+                FbTk::CommandParser<void>::instance().parseCached(str, false));
+            if (cmd)
                 cmd->execute();
             XFree(str);
 
         }
-    // TODO: this doesn't belong in FbPixmap
-    } else if (FbTk::FbPixmap::rootwinPropertyNotify(screenNumber(), atom))
-        m_bg_change_sig.emit(*this);
+    } else if (FbTk::FbPixmap::isRootPixmapProperty(atom)) {
+        // setters change several of them for one wallpaper
+        m_root_pixmap_task.schedule();
+    }
+}
+
+void BScreen::prerenderWorkspaces() {
+    // without a delay, hidden windows aren't meant to keep pixmaps
+    size_t count = m_workspaces_list.size();
+    if (getDecorationReleaseDelay() == 0 || count < 2 || !m_current_workspace)
+        return;
+
+    unsigned int current = currentWorkspaceID();
+    unsigned int id;
+    switch (m_prerender_step++) {
+    case 0:
+        id = (current + 1) % count;
+        break;
+    case 1:
+        id = (current + count - 1) % count;
+        break;
+    case 2:
+        id = m_last_workspace;
+        break;
+    default:
+        return;
+    }
+
+    // one workspace per idle moment, events go first
+    m_prerender_task.schedule();
+    if (id == current || id >= count)
+        return;
+
+    Workspace::Windows &windows = getWorkspace(id)->windowList();
+    Workspace::Windows::iterator it = windows.begin();
+    for (; it != windows.end(); ++it)
+        (*it)->frame().prerender();
+}
+
+void BScreen::updateRootPixmap() {
+    m_root_pixmap_task.cancel();
+    FbTk::FbPixmap::updateRootPixmap(screenNumber());
+    m_bg_change_sig.emit(*this);
 }
 
 void BScreen::keyPressEvent(XKeyEvent &ke) {
@@ -866,12 +1008,15 @@ void BScreen::addExtraWindowMenu(const FbTk::FbString &label, FbTk::Menu *menu)
     menu->setInternalMenu();
     menu->disableTitle();
     m_extramenus.push_back(make_pair(label, menu));
-    rereadWindowMenu();
+    if (m_menus_loaded)
+        rereadWindowMenu();
 }
 
 void BScreen::reconfigure() {
     Fluxbox *fluxbox = Fluxbox::instance();
 
+    FbTk::Transparent::usePseudoTransparent(screenNumber(), *resource.force_pseudo_trans);
+
     focusedWinFrameTheme()->setAlpha(*resource.focused_alpha);
     unfocusedWinFrameTheme()->setAlpha(*resource.unfocused_alpha);
     m_menutheme->setAlpha(*resource.menu_alpha);
@@ -879,6 +1024,9 @@ void BScreen::reconfigure() {
     clampMenuDelay(*resource.menu_delay);
 
     m_menutheme->setDelay(*resource.menu_delay);
+    m_menutheme->setMaxColumns(*resource.menu_max_columns);
+    m_menutheme->setSearchMode(*resource.menu_search == "somewhere" ?
+                               FbTk::TYPEAHEAD_SUBSTRING : FbTk::TYPEAHEAD_PREFIX);
 
     // realize the number of workspaces from the init-file
     const unsigned int nr_ws = *resource.workspaces;
@@ -916,6 +1064,14 @@ void BScreen::reconfigure() {
                                         m_root_theme->screenNum());
 
     reconfigureTabs();
+    updateCompositor();
+}
+
+void BScreen::updateCompositor() {
+    if (*resource.compositor && m_compositor.get() == 0)
+        m_compositor.reset(Compositor::create(*this));
+    else if (!*resource.compositor)
+        m_compositor.reset(0);
 }
 
 void BScreen::reconfigureTabs() {
@@ -951,7 +1107,7 @@ void BScreen::addIcon(FluxboxWindow *w) {
     iconList().push_back(w);
 
     // notify listeners
-    iconListSig().emit(*this);
+    iconListChanged();
 }
 
 
@@ -966,7 +1122,7 @@ void BScreen::removeIcon(FluxboxWindow *w) {
     // change the iconlist
     if (erase_it != m_icon_list.end()) {
         iconList().erase(erase_it);
-        iconListSig().emit(*this);
+        iconListChanged();
     }
 }
 
@@ -989,7 +1145,7 @@ void BScreen::removeClient(WinClient &client) {
     focusControl().removeClient(client);
 
     if (client.fbwindow() && client.fbwindow()->isIconic())
-        iconListSig().emit(*this);
+        iconListChanged();
 
     using namespace FbTk;
 
@@ -1008,6 +1164,40 @@ void BScreen::removeClient(WinClient &client) {
 
 }
 
+void BScreen::clientListChanged() {
+    if (m_update_lock > 0)
+        m_clientlist_changed = true;
+    else
+        m_clientlist_sig.emit(*this);
+}
+
+void BScreen::iconListChanged() {
+    if (m_update_lock > 0)
+        m_iconlist_changed = true;
+    else
+        m_iconlist_sig.emit(*this);
+}
+
+void BScreen::lockUpdates() {
+    ++m_update_lock;
+    m_layermanager.lock();
+}
+
+void BScreen::unlockUpdates() {
+    m_layermanager.unlock();
+    if (--m_update_lock > 0)
+        return;
+
+    if (m_clientlist_changed) {
+        m_clientlist_changed = false;
+        m_clientlist_sig.emit(*this);
+    }
+    if (m_iconlist_changed) {
+        m_iconlist_changed = false;
+        m_iconlist_sig.emit(*this);
+    }
+}
+
 int BScreen::addWorkspace() {
 
     bool save_name = getNameOfWorkspace(m_workspaces_list.size()) == "";
@@ -1046,7 +1236,7 @@ int BScreen::removeLastWorkspace() {
         if ((*it)->workspaceNumber() == wkspc->workspaceID())
             (*it)->setWorkspace(wkspc->workspaceID()-1);
     }
-    m_clientlist_sig.emit(*this);
+    clientListChanged();
 
     //remove last workspace
     m_workspaces_list.pop_back();
@@ -1068,13 +1258,18 @@ void BScreen::changeWorkspaceID(unsigned int id, bool revert) {
         id == m_current_workspace->workspaceID())
         return;
 
+    uint64_t start = FbTk::FbTime::mono();
+
     /* Ignore all EnterNotify events until the pointer actually moves */
     this->focusControl().ignoreAtPointer();
 
-    FbTk::App::instance()->sync(false);
-
     FluxboxWindow *focused = FocusControl::focusedFbWindow();
 
+    // the whole switch goes to the server in one burst, so nothing gets
+    // drawn halfway and the layers restack only once. a server grab would
+    // freeze all other clients meanwhile
+    m_layermanager.lock();
+
     if (focused && focused->isMoving() && doOpaqueMove())
         // don't reassociate if not opaque moving
         reassociateWindow(focused, id, true);
@@ -1109,7 +1304,19 @@ void BScreen::changeWorkspaceID(unsigned int id, bool revert) {
 
     old->hideAll(false);
 
-    FbTk::App::instance()->sync(false);
+    m_layermanager.unlock();
+    XFlush(FbTk::App::instance()->display());
+
+    uint64_t elapsed = FbTk::FbTime::mono() - start;
+    ++m_switch_stats.switches;
+    m_switch_stats.total += elapsed;
+    if (elapsed > m_switch_stats.max)
+        m_switch_stats.max = elapsed;
+
+    // the workspaces we may go to next are rendered while we're idle
+    m_last_workspace = old->workspaceID();
+    m_prerender_step = 0;
+    m_prerender_task.schedule();
 
     m_currentworkspace_sig.emit(*this);
 
@@ -1165,15 +1372,12 @@ bool BScreen::isKdeDockapp(Window client) const {
     bool iskdedockapp = false;
     Atom ajunk;
     int ijunk;
-    unsigned long *data = 0, uljunk;
-    Display *disp = FbTk::App::instance()->display();
+    unsigned char *data = 0;
+    unsigned long uljunk;
     // Check if KDE v2.x dock applet
-    if (XGetWindowProperty(disp, client,
-                           XInternAtom(FbTk::App::instance()->display(),
-                                       "_KDE_NET_WM_SYSTEM_TRAY_WINDOW_FOR", False),
-                           0l, 1l, False,
-                           XA_WINDOW, &ajunk, &ijunk, &uljunk,
-                           &uljunk, (unsigned char **) &data) == Success) {
+    if (Xutil::getProperty(client,
+                           FbTk::AtomCache::instance().get("_KDE_NET_WM_SYSTEM_TRAY_WINDOW_FOR"),
+                           1l, XA_WINDOW, ajunk, ijunk, uljunk, data)) {
 
         if (data)
             iskdedockapp = true;
@@ -1183,13 +1387,10 @@ bool BScreen::isKdeDockapp(Window client) const {
 
     // Check if KDE v1.x dock applet
     if (!iskdedockapp) {
-        Atom kwm1 = XInternAtom(FbTk::App::instance()->display(),
-                                "KWM_DOCKWINDOW", False);
-        if (XGetWindowProperty(disp, client,
-                               kwm1, 0l, 1l, False,
-                               kwm1, &ajunk, &ijunk, &uljunk,
-                               &uljunk, (unsigned char **) &data) == Success && data) {
-            iskdedockapp = (data && data[0] != 0);
+        Atom kwm1 = FbTk::AtomCache::instance().get("KWM_DOCKWINDOW");
+        if (Xutil::getProperty(client, kwm1, 1l, kwm1, ajunk, ijunk, uljunk,
+                               data) && data) {
+            iskdedockapp = reinterpret_cast<unsigned long *>(data)[0] != 0;
             XFree((void *) data);
             data = 0;
         }
@@ -1231,8 +1432,16 @@ bool BScreen::addKdeDockapp(Window client) {
 }
 
 FluxboxWindow *BScreen::createWindow(Window client) {
+    // the replies come with the sync, the setup below reads them
+    FbTk::PropertyPrefetch prefetch(client, adoptionAtoms());
+    FbTk::App::instance()->sync(false);
+
+    FluxboxWindow *win = adoptWindow(client);
     FbTk::App::instance()->sync(false);
+    return win;
+}
 
+FluxboxWindow *BScreen::adoptWindow(Window client) {
 
     if (isKdeDockapp(client) && addKdeDockapp(client)) {
         return 0; // dont create a FluxboxWindow for this one
@@ -1262,7 +1471,7 @@ FluxboxWindow *BScreen::createWindow(Window client) {
             win = winclient->fbwindow();
             Workspace *workspace = getWorkspace(win->workspaceNumber());
             if (workspace)
-                workspace->updateClientmenu();
+                workspace->updateClientmenu(*win);
         } else {
             win = new FluxboxWindow(*winclient);
 
@@ -1287,9 +1496,8 @@ FluxboxWindow *BScreen::createWindow(Window client) {
     else if (other) // should never happen
         win->moveClientRightOf(*other, *winclient);
 
-    m_clientlist_sig.emit(*this);
+    clientListChanged();
 
-    FbTk::App::instance()->sync(false);
     return win;
 }
 
@@ -1321,7 +1529,7 @@ FluxboxWindow *BScreen::createWindow(WinClient &client) {
             && win->focus())
         FocusControl::setFocusedWindow(&client);
 
-    m_clientlist_sig.emit(*this);
+    clientListChanged();
 
     return win;
 }
@@ -1367,8 +1575,22 @@ void BScreen::updateAvailableWorkspaceArea() {
         updated = m_head_areas[i]->updateAvailableWorkspaceArea() || updated;
     }
 
+    // panels may change their struts many times in a row, e.g. while they
+    // slide in and out, maximized windows follow only the last of them
     if (updated)
-        m_workspace_area_sig.emit(*this);
+        m_workspace_area_task.schedule();
+}
+
+void BScreen::signalWorkspaceArea() {
+    size_t n = (numHeads() ? numHeads() : 1);
+    std::vector<Strut> areas;
+    for (size_t i = 0; i < n; i++)
+        areas.push_back(*m_head_areas[i]->availableWorkspaceArea());
+
+    if (areas == m_signalled_areas)
+        return;
+    m_signalled_areas.swap(areas);
+    m_workspace_area_sig.emit(*this);
 }
 
 void BScreen::addWorkspaceName(const char *name) {
@@ -1412,13 +1634,34 @@ void BScreen::reassociateWindow(FluxboxWindow *w, unsigned int wkspc_id,
 }
 
 void BScreen::initMenus() {
+    FbTk::StartupProfile::Phase phase("menus");
     m_workspacemenu.reset(MenuCreator::createMenuType("workspacemenu", screenNumber()));
-    m_rootmenu->reloadHelper()->setMainFile(Fluxbox::instance()->getMenuFilename());
-    m_windowmenu->reloadHelper()->setMainFile(windowMenuFilename());
+    // nobody looks at the other menus before the windows are adopted
+    m_rootmenu->reloadHelper()->deferMainFile(Fluxbox::instance()->getMenuFilename());
+    m_windowmenu->reloadHelper()->deferMainFile(windowMenuFilename());
+    m_menu_task.schedule();
+}
+
+void BScreen::loadMenus() {
+    if (m_menus_loaded)
+        return;
+    m_menus_loaded = true;
+    m_menu_task.cancel();
+
+    setupConfigmenu(*m_configmenu.get());
+    m_rootmenu->reloadHelper()->checkReload();
+    m_windowmenu->reloadHelper()->checkReload();
+}
+
+FbMenu &BScreen::configMenu() {
+    loadMenus();
+    return *m_configmenu.get();
 }
 
 
 void BScreen::rereadMenu() {
+    // the config menu goes with it
+    loadMenus();
 
     m_rootmenu->removeAll();
     m_rootmenu->setLabel(FbTk::BiDiString(""));
@@ -1453,6 +1696,7 @@ const std::string BScreen::windowMenuFilename() const {
 }
 
 void BScreen::rereadWindowMenu() {
+    loadMenus();
 
     m_windowmenu->removeAll();
     if (!windowMenuFilename().empty())
@@ -1463,7 +1707,7 @@ void BScreen::rereadWindowMenu() {
 
 void BScreen::addConfigMenu(const FbTk::FbString &label, FbTk::Menu &menu) {
     m_configmenu_list.push_back(make_pair(label, &menu));
-    if (m_configmenu.get())
+    if (m_configmenu.get() && m_menus_loaded)
         setupConfigmenu(*m_configmenu.get());
 }
 
@@ -1475,7 +1719,7 @@ void BScreen::removeConfigMenu(FbTk::Menu &menu) {
     if (erase_it != m_configmenu_list.end())
         m_configmenu_list.erase(erase_it);
 
-    if (!isShuttingdown() && m_configmenu.get())
+    if (!isShuttingdown() && m_configmenu.get() && m_menus_loaded)
         setupConfigmenu(*m_configmenu.get());
 
 }
@@ -1732,6 +1976,7 @@ void BScreen::setupConfigmenu(FbTk::Menu &menu) {
 
 
 void BScreen::shutdown() {
+    m_compositor.reset(0);
     rootWindow().setEventMask(NoEventMask);
     FbTk::App::instance()->sync(false);
     m_shutdown = true;
@@ -1840,30 +2085,41 @@ void BScreen::renderGeomWindow() {
     FbTk::BiDiString label(buf);
     m_geom_window->resize(label);
     m_geom_window->reconfigTheme();
+    m_geom_window->setRedrawInterval(refreshInterval());
 }
 
 
 void BScreen::renderPosWindow() {
     m_pos_window->resize(FbTk::BiDiString("0:00000 x 0:00000"));
     m_pos_window->reconfigTheme();
+    m_pos_window->setRedrawInterval(refreshInterval());
 }
 
 void BScreen::updateSize() {
-    // update xinerama layout
-    initXinerama();
+    // docking a laptop sends a burst of these, most change nothing
+    m_changed_heads.clear();
+    m_root_resized = rootWindow().syncGeometry();
+    bool heads_changed = initXinerama();
+    if (!m_root_resized && !heads_changed)
+        return;
 
-    // check if window geometry has changed
-    if (rootWindow().updateGeometry()) {
-        // reset background
+    // the background covers the root window, not a head
+    if (m_root_resized)
         m_root_theme->reset();
 
-        // send resize notify
-        m_resize_sig.emit(*this);
-        m_workspace_area_sig.emit(*this);
+    // send resize notify, the handlers ask headChanged()
+    m_resize_sig.emit(*this);
+    m_workspace_area_sig.emit(*this);
 
-        // move windows out of inactive heads
+    // move windows out of inactive heads
+    if (heads_changed)
         clearHeads();
-    }
+}
+
+bool BScreen::headChanged(int head) const {
+    if (head <= 0 || !hasXinerama())
+        return m_root_resized || !m_changed_heads.empty();
+    return m_changed_heads.find(head) != m_changed_heads.end();
 }
 
 
@@ -1908,19 +2164,23 @@ void BScreen::clearXinerama() {
     fbdbg<<"BScreen::initXinerama(): dont have Xinerama"<<endl;
 
     m_xinerama_avail = false;
+    for (int i = 0; i < m_xinerama_num_heads; ++i)
+        m_changed_heads.insert(i + 1);
     if (m_xinerama_headinfo)
         delete [] m_xinerama_headinfo;
     m_xinerama_headinfo = 0;
     m_xinerama_num_heads = 0;
+    m_head_map.clear();
 }
 
-void BScreen::initXinerama() {
+bool BScreen::initXinerama() {
 #ifdef XINERAMA
     Display *display = FbTk::App::instance()->display();
 
     if (!XineramaIsActive(display)) {
+        bool had_heads = m_xinerama_avail;
         clearXinerama();
-        return;
+        return had_heads;
     }
 
     fbdbg<<"BScreen::initXinerama(): have Xinerama"<<endl;
@@ -1937,7 +2197,22 @@ void BScreen::initXinerama() {
     if (!screen_info) {
         if (!m_xinerama_headinfo)
             clearXinerama();
-        return;
+        return false;
+    }
+
+    // heads are numbered by their place in the list, so a head that
+    // moves to another place changes, like one that moves on the screen
+    for (int i = 0; i < number || i < m_xinerama_num_heads; ++i) {
+        if (i >= number || i >= m_xinerama_num_heads ||
+            m_xinerama_headinfo[i]._x != screen_info[i].x_org ||
+            m_xinerama_headinfo[i]._y != screen_info[i].y_org ||
+            m_xinerama_headinfo[i]._width != screen_info[i].width ||
+            m_xinerama_headinfo[i]._height != screen_info[i].height)
+            m_changed_heads.insert(i + 1);
+    }
+    if (m_changed_heads.empty()) {
+        XFree(screen_info);
+        return false;
     }
 
     if (m_xinerama_headinfo)
@@ -1945,13 +2220,17 @@ void BScreen::initXinerama() {
 
     m_xinerama_headinfo = new XineramaHeadInfo[number];
     m_xinerama_num_heads = number;
+    m_head_map.clear();
     for (int i=0; i < number; i++) {
         m_xinerama_headinfo[i]._x = screen_info[i].x_org;
         m_xinerama_headinfo[i]._y = screen_info[i].y_org;
         m_xinerama_headinfo[i]._width = screen_info[i].width;
         m_xinerama_headinfo[i]._height = screen_info[i].height;
+        m_head_map.add(screen_info[i].x_org, screen_info[i].y_org,
+                       screen_info[i].width, screen_info[i].height);
     }
     XFree(screen_info);
+    m_head_map.build();
 
     fbdbg<<"BScreen::initXinerama(): number of heads ="<<number<<endl;
 
@@ -1968,10 +2247,13 @@ void BScreen::initXinerama() {
         m_head_areas.resize(ha_num);
     }
 
+    return true;
+
 #else // XINERAMA
     // no xinerama
     m_xinerama_avail = false;
     m_xinerama_num_heads = 0;
+    return false;
 #endif // XINERAMA
 
 }
@@ -2009,16 +2291,43 @@ void BScreen::clearHeads() {
     }
 }
 
+bool BScreen::doOutlineWindow() const {
+    return *resource.outline_window && OutlineWindow::isSupported();
+}
+
+uint64_t BScreen::opaqueMoveInterval() const {
+    int rate = *resource.opaque_move_rate;
+    if (rate == 0)
+        return 0;
+    // negative: as often as the screen refreshes
+    if (rate < 0)
+        return refreshInterval();
+    return FbTk::FbTime::IN_SECONDS / rate;
+}
+
+uint64_t BScreen::refreshInterval() const {
+    int rate = 0;
+
+#ifdef HAVE_RANDR
+    FBTK_ROUNDTRIP("BScreen::refreshInterval");
+    XRRScreenConfiguration *config =
+        XRRGetScreenInfo(FbTk::App::instance()->display(), rootWindow().window());
+    if (config) {
+        rate = XRRConfigCurrentRate(config);
+        XRRFreeScreenConfigInfo(config);
+    }
+#endif // HAVE_RANDR
+
+    if (rate <= 0)
+        rate = 60;
+    return FbTk::FbTime::IN_SECONDS / rate;
+}
+
 int BScreen::getHead(int x, int y) const {
 
 #ifdef XINERAMA
-    if (hasXinerama()) {
-        for (int i=0; i < m_xinerama_num_heads; i++) {
-            if (RectangleUtil::insideBorder(m_xinerama_headinfo[i], x, y, 0)) {
-                return i+1;
-            }
-        }
-    }
+    if (hasXinerama())
+        return m_head_map.find(x, y);
 #endif // XINERAMA
     return 0;
 }
@@ -2065,6 +2374,7 @@ int BScreen::getCurrHead() const {
 
     Window ignore_w;
 
+    FBTK_ROUNDTRIP("BScreen::getCurrHead");
     XQueryPointer(FbTk::App::instance()->display(),
                   rootWindow().window(), &ignore_w,
                   &ignore_w, &root_x, &root_y,
@@ -38,8 +38,12 @@
 #include "FbTk/MultLayers.hh"
 #include "FbTk/NotCopyable.hh"
 #include "FbTk/Signal.hh"
+#include "FbTk/Timer.hh"
+#include "FbTk/IdleTask.hh"
 
 #include "FocusControl.hh"
+#include "HeadMap.hh"
+#include "Strut.hh"
 
 #include <X11/Xresource.h>
 
@@ -53,6 +57,7 @@
 #include <fstream>
 #include <memory>
 #include <map>
+#include <set>
 
 class ClientPattern;
 class FbMenu;
@@ -60,13 +65,14 @@ class Focusable;
 class FluxboxWindow;
 class WinClient;
 class Workspace;
-class Strut;
 class Slit;
 class Toolbar;
+class Compositor;
 class HeadArea;
 class ScreenPlacement;
 class TooltipWindow;
 class OSDWindow;
+class OutlineWindow;
 
 namespace FbTk {
 class Menu;
@@ -95,6 +101,8 @@ public:
 
     void initWindows();
     void initMenus();
+    /// builds the menus initMenus() left for after the startup
+    void loadMenus();
 
     bool isRootColormapInstalled() const { return root_colormap_installed; }
     bool isScreenManaged() const { return managed; }
@@ -102,7 +110,12 @@ public:
     bool doAutoRaise() const { return *resource.auto_raise; }
     bool clickRaises() const { return *resource.click_raises; }
     bool doOpaqueMove() const { return *resource.opaque_move; }
+    /// @return true if outline moves move an OutlineWindow instead of
+    ///         drawing on the root window
+    bool doOutlineWindow() const;
     bool doFullMax() const { return *resource.full_max; }
+    /// @return true if fullscreen frames ask the compositor to unredirect them
+    bool doFullscreenUnredirect() const { return *resource.fullscreen_unredirect; }
     bool getMaxIgnoreIncrement() const { return *resource.max_ignore_inc; }
     bool getMaxDisableMove() const { return *resource.max_disable_move; }
     bool getMaxDisableResize() const { return *resource.max_disable_resize; }
@@ -114,7 +127,7 @@ public:
     const FbMenu &rootMenu() const { return *m_rootmenu.get(); }
     FbMenu &rootMenu() { return *m_rootmenu.get(); }
     const FbMenu &configMenu() const { return *m_configmenu.get(); }
-    FbMenu &configMenu() { return *m_configmenu.get(); }
+    FbMenu &configMenu();
     const FbMenu &windowMenu() const { return *m_windowmenu.get(); }
     FbMenu &windowMenu() { return *m_windowmenu.get(); }
     ExtraMenus &extraWindowMenus() { return m_extramenus; }
@@ -134,6 +147,8 @@ public:
     Slit *slit() { return m_slit.get(); }
     /// @return the slit, @see Slit
     const Slit *slit() const { return m_slit.get(); }
+    /// @return the built-in compositor, 0 if it doesn't run
+    Compositor *compositor() { return m_compositor.get(); }
     /**
      * @param w the workspace number
      * @return workspace for the given workspace number
@@ -252,6 +267,15 @@ public:
     void addExtraWindowMenu(const FbTk::FbString &label, FbTk::Menu *menu);
 
     int getEdgeSnapThreshold() const { return *resource.edge_snap_threshold; }
+    /// @return seconds a hidden window keeps its decoration pixmaps
+    int getDecorationReleaseDelay() const { return *resource.decoration_release_delay; }
+    /// @return the minimum time between two steps of an opaque move in
+    ///         micro-seconds, 0 if there is no limit
+    uint64_t opaqueMoveInterval() const;
+    /// @return the time between two refreshes of the screen in micro-seconds
+    uint64_t refreshInterval() const;
+
+    OutlineWindow &outlineWindow() { return *m_outline_window; }
 
     void setRootColormapInstalled(bool r) { root_colormap_installed = r;  }
 
@@ -283,6 +307,14 @@ public:
 
     FbTk::MultLayers &layerManager() { return m_layermanager; }
     const FbTk::MultLayers &layerManager() const { return m_layermanager; }
+
+    /// workspace switches of this screen, see Fluxbox::dumpStats
+    struct SwitchStats {
+        unsigned long switches;
+        uint64_t total; ///< microseconds spent switching
+        uint64_t max; ///< microseconds of the slowest switch
+    };
+    const SwitchStats &switchStats() const { return m_switch_stats; }
     FbTk::ResourceManager &resourceManager() { return m_resource_manager; }
     const FbTk::ResourceManager &resourceManager() const { return m_resource_manager; }
     const std::string &name() const { return m_name; }
@@ -331,6 +363,17 @@ public:
     void removeWindow(FluxboxWindow *win);
     /// remove a client
     void removeClient(WinClient &client);
+    /// sends the client list signal, or holds it back while updates are locked
+    void clientListChanged();
+    /// sends the icon list signal, or holds it back while updates are locked
+    void iconListChanged();
+    /**
+     * Holds back restacking and the client and icon list signals until the
+     * matching unlockUpdates(), so a command changing many windows causes
+     * one restack, one _NET_CLIENT_LIST and one menu update. Nests.
+     */
+    void lockUpdates();
+    void unlockUpdates();
     /**
      * Gets name of a specific workspace
      * @param workspace the workspace number to get the name of
@@ -383,6 +426,9 @@ public:
     /// that depends on screen size (slit)
     /// (and maximized windows?)
     void updateSize();
+    /// @return true if the head changed in the last updateSize(), for the
+    ///         handlers of resizeSig(); head 0 asks for the whole screen
+    bool headChanged(int head) const;
 
     // Xinerama-related functions
 
@@ -391,7 +437,8 @@ public:
     /// @return umber of xinerama heads
     int numHeads() const { return m_xinerama_num_heads; }
 
-    void initXinerama();
+    /// @return true if the heads differ from before
+    bool initXinerama();
     void clearHeads();
     /// clean up xinerama
     void clearXinerama();
@@ -438,7 +485,8 @@ public:
     Strut *requestStrut(int head, int left, int right, int top, int bottom);
     /// remove requested space and destroy strut
     void clearStrut(Strut *strut);
-    /// updates max avaible area for the workspace
+    /// updates max avaible area for the workspace, the workspace area
+    /// signal follows once the events of this burst are handled
     void updateAvailableWorkspaceArea();
 
     // for extras to add menus. These menus must be marked
@@ -455,13 +503,36 @@ public:
 
 private:
     void setupConfigmenu(FbTk::Menu &menu);
+    /// createWindow() without the prefetch of the properties
+    FluxboxWindow *adoptWindow(Window clientwin);
     void renderGeomWindow();
     void renderPosWindow();
     void focusedWinFrameThemeReconfigured();
+    /// reconfigures all frames once the window themes are done loading
+    void scheduleFrameReconfigure();
+    void reconfigureFrames();
 
     const Strut* availableWorkspaceArea(int head) const;
+    /// emits the workspace area signal if the areas differ from the last time
+    void signalWorkspaceArea();
+    /// starts or stops the compositor, as session.screenN.compositor says
+    void updateCompositor();
+    /// follows a new wallpaper, once for all the root properties it set
+    void updateRootPixmap();
+    /// renders the windows of one of the workspaces we may switch to next
+    void prerenderWorkspaces();
 
     FbTk::SignalTracker m_tracker;
+    FbTk::Timer m_reconfigure_frames_timer;
+    FbTk::IdleTask m_workspace_area_task;
+    std::vector<Strut> m_signalled_areas; ///< per head, at the last signal
+    FbTk::IdleTask m_root_pixmap_task;
+    FbTk::IdleTask m_menu_task; ///< runs loadMenus() once we're idle
+    FbTk::IdleTask m_prerender_task;
+    unsigned int m_prerender_step; ///< next, previous, last workspace
+    unsigned int m_last_workspace; ///< the one we switched away from last
+    bool m_menus_loaded;
+    SwitchStats m_switch_stats;
     ScreenSignal m_reconfigure_sig; ///< reconfigure signal
 
     FbTk::Signal<BScreen&, FluxboxWindow*, WinClient*> m_focusedwindow_sig;  ///< focused window signal
@@ -491,6 +562,7 @@ private:
 
     std::auto_ptr<Slit> m_slit;
     std::auto_ptr<Toolbar> m_toolbar;
+    std::auto_ptr<Compositor> m_compositor;
 
     Workspace *m_current_workspace;
 
@@ -507,21 +579,25 @@ private:
     FbRootWindow m_root_window;
     std::auto_ptr<OSDWindow> m_geom_window, m_pos_window;
     std::auto_ptr<TooltipWindow> m_tooltip_window;
+    std::auto_ptr<OutlineWindow> m_outline_window;
     FbTk::FbWindow m_dummy_window;
 
     struct ScreenResource {
         ScreenResource(FbTk::ResourceManager &rm, const std::string &scrname,
                        const std::string &altscrname);
 
-        FbTk::Resource<bool> opaque_move, full_max,
-            max_ignore_inc, max_disable_move, max_disable_resize,
-            workspace_warping, show_window_pos, auto_raise, click_raises;
+        FbTk::Resource<bool> opaque_move, outline_window, full_max,
+            fullscreen_unredirect, max_ignore_inc, max_disable_move, max_disable_resize,
+            workspace_warping, show_window_pos, auto_raise, click_raises,
+            compositor, force_pseudo_trans;
         FbTk::Resource<std::string> default_deco;
         FbTk::Resource<FbWinFrame::TabPlacement> tab_placement;
         FbTk::Resource<std::string> windowmenufile;
+        FbTk::Resource<std::string> menu_search;
         FbTk::Resource<unsigned int> typing_delay;
-        FbTk::Resource<int> workspaces, edge_snap_threshold, focused_alpha,
-            unfocused_alpha, menu_alpha, menu_delay,
+        FbTk::Resource<int> workspaces, edge_snap_threshold, opaque_move_rate,
+            decoration_release_delay, focused_alpha,
+            unfocused_alpha, menu_alpha, menu_delay, menu_max_columns,
             tab_width, tooltip_delay;
         FbTk::Resource<bool> allow_remote_actions;
         FbTk::Resource<bool> clientmenu_use_pixmap;
@@ -563,8 +639,14 @@ private:
         int width() const { return _width; }
         int height() const { return _height; }
     } *m_xinerama_headinfo;
+    HeadMap m_head_map; ///< finds the head at a point
+    std::set<int> m_changed_heads; ///< by the last initXinerama()
+    bool m_root_resized; ///< by the last updateSize()
 
     bool m_restart, m_shutdown;
+
+    int m_update_lock;
+    bool m_clientlist_changed, m_iconlist_changed; ///< held back signals
 };
 
 
@@ -27,8 +27,10 @@
 #include "ColSmartPlacement.hh"
 #include "CascadePlacement.hh"
 
+#include "FocusControl.hh"
 #include "Screen.hh"
 #include "Window.hh"
+#include "WindowCoverage.hh"
 
 #include "FbTk/Menu.hh"
 
@@ -131,6 +133,34 @@ bool ScreenPlacement::placeWindow(const FluxboxWindow &win, int head,
     return true;
 }
 
+void ScreenPlacement::getCoverage(const FluxboxWindow &win, bool include_win,
+                                  WindowCoverage &coverage) {
+
+    const std::list<Focusable *> focusables =
+            win.screen().focusControl().focusedOrderWinList().clientList();
+    std::list<Focusable *>::const_iterator foc_it = focusables.begin(),
+                                           foc_it_end = focusables.end();
+    unsigned int workspace = win.workspaceNumber();
+    for (; foc_it != foc_it_end; ++foc_it) {
+        // make sure it's a FluxboxWindow
+        const FluxboxWindow *fbwin = (*foc_it)->fbwindow();
+        if (*foc_it != fbwin ||
+            (workspace != fbwin->workspaceNumber() && !fbwin->isStuck()))
+            continue;
+
+        // the frame including its decorations and borders
+        const int bw = 2 * fbwin->frame().window().borderWidth();
+        int left = fbwin->x() - fbwin->xOffset();
+        int top = fbwin->y() - fbwin->yOffset();
+        int right = left + fbwin->width() + bw + fbwin->widthOffset();
+        int bottom = top + fbwin->height() + bw + fbwin->heightOffset();
+
+        coverage.add(fbwin, left, top, right, bottom, include_win || fbwin != &win);
+    }
+
+    coverage.build();
+}
+
 void ScreenPlacement::placeAndShowMenu(FbTk::Menu& menu, int x, int y, bool respect_struts) {
 
     int head = m_screen.getHead(x, y);
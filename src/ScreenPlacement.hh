@@ -31,6 +31,7 @@ namespace FbTk {
     class Menu;
 }
 class BScreen;
+class WindowCoverage;
 
 /**
  * Main class for strategy handling
@@ -75,6 +76,14 @@ public:
     RowDirection rowDirection() const { return *m_row_direction; }
     ColumnDirection colDirection() const { return *m_col_direction; }
 
+    /**
+     * Fills @coverage with the windows on the workspace of @win, most
+     * recently focused first, and builds it.
+     * @param include_win whether @win itself counts for the coverage
+     */
+    static void getCoverage(const FluxboxWindow &win, bool include_win,
+                            WindowCoverage &coverage);
+
 private:
     FbTk::Resource<RowDirection> m_row_direction; ///< row direction resource
     FbTk::Resource<ColumnDirection> m_col_direction; ///< column direction resource
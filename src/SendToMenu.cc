@@ -53,17 +53,14 @@ SendToMenu::SendToMenu(BScreen &screen):
     // listen to:
     // workspace count signal
     // workspace names signal
-    // current workspace signal
+    // the items don't depend on the current workspace, show() takes care
+    // of the window's own one
 
     join(screen.workspaceNamesSig(),
-         FbTk::MemFun(*this, &SendToMenu::rebuildMenuForScreen));
+         FbTk::MemFun(*this, &SendToMenu::workspaceInfoChanged));
 
-    join(screen.currentWorkspaceSig(),
-         FbTk::MemFun(*this, &SendToMenu::rebuildMenuForScreen));
-
-    // setup new signal system
     join(screen.workspaceCountSig(),
-         FbTk::MemFun(*this, &SendToMenu::rebuildMenuForScreen));
+         FbTk::MemFun(*this, &SendToMenu::workspaceInfoChanged));
 
     // no title for this menu, it should be a submenu in the window menu.
     disableTitle();
@@ -75,26 +72,53 @@ SendToMenu::~SendToMenu() {
 
 }
 
+namespace {
+
+FbTk::MenuItem *sendto_item(const FbTk::FbString &name, int workspace) {
+    FbTk::RefCount<FbTk::Command<void> > sendto_cmd(new SendToCmd(workspace, false));
+    FbTk::RefCount<FbTk::Command<void> > sendto_follow_cmd(new SendToCmd(workspace, true));
+
+    FbTk::MultiButtonMenuItem* item = new FbTk::MultiButtonMenuItem(3, name);
+    item->setCommand(1, sendto_cmd);
+    item->setCommand(2, sendto_follow_cmd);
+    item->setCommand(3, sendto_cmd);
+    return item;
+}
+
+} // end anonymous namespace
+
 void SendToMenu::rebuildMenu() {
     // rebuild menu
 
     removeAll();
     BScreen *screen = Fluxbox::instance()->findScreen(screenNumber());
     const BScreen::Workspaces &wlist = screen->getWorkspacesList();
-    for (size_t i = 0; i < wlist.size(); ++i) {
-        FbTk::RefCount<FbTk::Command<void> > sendto_cmd(new SendToCmd(i, false));
-        FbTk::RefCount<FbTk::Command<void> > sendto_follow_cmd(new SendToCmd(i, true));
-        
-        FbTk::MultiButtonMenuItem* item = new FbTk::MultiButtonMenuItem(3, wlist[i]->name());
-        item->setCommand(1, sendto_cmd);
-        item->setCommand(2, sendto_follow_cmd);
-        item->setCommand(3, sendto_cmd);
-        insert(item);
-    }
+    for (size_t i = 0; i < wlist.size(); ++i)
+        insert(sendto_item(wlist[i]->name(), i));
 
     updateMenu();
 }
 
+void SendToMenu::workspaceInfoChanged(BScreen &screen) {
+    // the commands only know the number of their workspace, so renamed
+    // workspaces just need new labels
+    const BScreen::Workspaces &wlist = screen.getWorkspacesList();
+    for (size_t i = 0; i < wlist.size() && i < numberOfItems(); ++i) {
+        FbTk::MenuItem *item = find(i);
+        if (item->label().logical() != wlist[i]->name()) {
+            unsigned int old_width = item->width(theme());
+            item->setLabel(FbTk::BiDiString(wlist[i]->name()));
+            updateItem(i, old_width);
+        }
+    }
+    while (numberOfItems() > wlist.size())
+        remove(numberOfItems() - 1);
+    for (size_t i = numberOfItems(); i < wlist.size(); ++i)
+        insert(sendto_item(wlist[i]->name(), i));
+
+    updateMenuLater();
+}
+
 void SendToMenu::show() {
     if (FbMenu::window() != 0) {
         for (unsigned int i=0; i < numberOfItems(); ++i)
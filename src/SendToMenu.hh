@@ -41,10 +41,9 @@ public:
     /// @see FbTk::Menu
     void show();
 private:
-    /// workspace count changed on screen
-    void rebuildMenuForScreen( BScreen& screen ) {
-        rebuildMenu();
-    }
+    /// workspace count or names changed on screen, updates only the
+    /// items that changed
+    void workspaceInfoChanged(BScreen &screen);
 
     /// Rebuild the menu from scratch.
     void rebuildMenu();
@@ -42,6 +42,10 @@
 #include "FbTk/Theme.hh"
 #include "FbTk/Transparent.hh"
 #include "FbTk/MacroCommand.hh"
+#include "FbTk/RoundTrips.hh"
+#include "FbTk/MemoryAccount.hh"
+#include "FbTk/RequestStats.hh"
+#include "FbTk/AtomCache.hh"
 #include "FbTk/MemFun.hh"
 
 #include "FbCommands.hh"
@@ -232,11 +236,10 @@ Slit::Slit(BScreen &scr, FbTk::Layer &layer, const char *filename)
       m_xineramaheadmenu(0),
 #endif // XINERAMA
       frame(scr.rootWindow()),
+      m_render_background(true),
        //For KDE dock applets
-      m_kwm1_dockwindow(XInternAtom(FbTk::App::instance()->display(),
-                                    "KWM_DOCKWINDOW", False)), //KDE v1.x
-      m_kwm2_dockwindow(XInternAtom(FbTk::App::instance()->display(),
-                                    "_KDE_NET_WM_SYSTEM_TRAY_WINDOW_FOR", False)), //KDE v2.x
+      m_kwm1_dockwindow(FbTk::AtomCache::instance().get("KWM_DOCKWINDOW")), //KDE v1.x
+      m_kwm2_dockwindow(FbTk::AtomCache::instance().get("_KDE_NET_WM_SYSTEM_TRAY_WINDOW_FOR")), //KDE v2.x
 
       m_layeritem(0),
 
@@ -276,6 +279,7 @@ Slit::Slit(BScreen &scr, FbTk::Layer &layer, const char *filename)
     scr.addConfigMenu(_FB_XTEXT(Slit, Slit, "Slit", "The Slit"), m_slitmenu);
 
     frame.pixmap = None;
+    m_relayout.setFunctor(FbTk::MemFun(*this, &Slit::relayout));
     // move the frame out of sight for a moment
     frame.window.move(-frame.window.width(), -frame.window.height());
     // setup timer
@@ -287,7 +291,7 @@ Slit::Slit(BScreen &scr, FbTk::Layer &layer, const char *filename)
 
     FbTk::EventManager::instance()->add(*this, frame.window);
 
-    if (FbTk::Transparent::haveComposite()) {
+    if (FbTk::Transparent::useComposite(screen().screenNumber())) {
         frame.window.setOpaque(*m_rc_alpha);
     } else {
         frame.window.setAlpha(*m_rc_alpha);
@@ -434,6 +438,7 @@ void Slit::addClient(Window w) {
     }
 
     Display *disp = FbTk::App::instance()->display();
+    FBTK_ROUNDTRIP("Slit::addClient");
     XWMHints *wmhints = XGetWMHints(disp, w);
 
     if (wmhints != 0) {
@@ -457,6 +462,7 @@ void Slit::addClient(Window w) {
     Atom *proto = 0;
     int num_return = 0;
 
+    FBTK_ROUNDTRIP("Slit::addClient");
     if (XGetWMProtocols(disp, w, &proto, &num_return)) {
         XFree((void *) proto);
     } else {
@@ -497,7 +503,8 @@ void Slit::addClient(Window w) {
 
     //    frame.window.show();
     clearWindow();
-    reconfigure();
+    // dockapps often start in a row, place them all at once
+    m_relayout.schedule();
 
     updateClientmenu();
 
@@ -569,12 +576,23 @@ void Slit::removeClient(Window w, bool remap) {
         }
     }
     if (reconf)
-        reconfigure();
+        m_relayout.schedule();
 
 }
 
 
 void Slit::reconfigure() {
+    FbTk::MemoryAccount::Scope account(FbTk::MemoryAccount::IN_SLIT);
+    FbTk::RequestStats::Widget widget(typeid(*this));
+    m_render_background = true;
+    relayout();
+
+    m_slitmenu.reconfigure();
+    updateClientmenu();
+}
+
+void Slit::relayout() {
+    m_relayout.cancel();
 
     frame.width = 0;
     frame.height = 0;
@@ -605,7 +623,8 @@ void Slit::reconfigure() {
             num_windows++;
 
             // get the dockapps to update their backgrounds
-            if (screen().isKdeDockapp((*client_it)->window())) {
+            if (m_render_background &&
+                screen().isKdeDockapp((*client_it)->window())) {
                 (*client_it)->hide();
                 (*client_it)->show();
             }
@@ -641,26 +660,33 @@ void Slit::reconfigure() {
     frame.window.setBorderWidth(theme()->borderWidth());
     frame.window.setBorderColor(theme()->borderColor());
 
-    Pixmap tmp = frame.pixmap;
-    FbTk::ImageControl &image_ctrl = screen().imageControl();
-    const FbTk::Texture &texture = m_slit_theme->texture();
-    if (!texture.usePixmap()) {
-        frame.pixmap = 0;
-        frame.window.setBackgroundColor(texture.color());
-    } else {
-        frame.pixmap = image_ctrl.renderImage(frame.width, frame.height,
-                                              texture);
-        if (frame.pixmap == 0)
+    // the background only changes with the theme and the size
+    const bool render = m_render_background ||
+        frame.width != frame.pixmap_width || frame.height != frame.pixmap_height;
+    if (render) {
+        Pixmap tmp = frame.pixmap;
+        FbTk::ImageControl &image_ctrl = screen().imageControl();
+        const FbTk::Texture &texture = m_slit_theme->texture();
+        if (!texture.usePixmap()) {
+            frame.pixmap = 0;
             frame.window.setBackgroundColor(texture.color());
-        else
-            frame.window.setBackgroundPixmap(frame.pixmap);
-    }
+        } else {
+            frame.pixmap = image_ctrl.renderImage(frame.width, frame.height,
+                                                  texture);
+            if (frame.pixmap == 0)
+                frame.window.setBackgroundColor(texture.color());
+            else
+                frame.window.setBackgroundPixmap(frame.pixmap);
+        }
 
-    if (tmp)
-        image_ctrl.removeImage(tmp);
+        if (tmp)
+            image_ctrl.removeImage(tmp);
+        frame.pixmap_width = frame.width;
+        frame.pixmap_height = frame.height;
+    }
 
     // could have changed types, so we must set both
-    if (FbTk::Transparent::haveComposite()) {
+    if (FbTk::Transparent::useComposite(screen().screenNumber())) {
         frame.window.setAlpha(255);
         frame.window.setOpaque(*m_rc_alpha);
     } else {
@@ -702,6 +728,16 @@ void Slit::reconfigure() {
         else
             y = (frame.height - (*client_it)->height()) / 2;
 
+        // clients before one that changed stay where they are
+        if (!m_render_background && (*client_it)->placed() &&
+            (*client_it)->x() == x && (*client_it)->y() == y) {
+            if (height_inc)
+                y += (*client_it)->height() + bevel_width;
+            else
+                x += (*client_it)->width() + bevel_width;
+            continue;
+        }
+
         XMoveResizeWindow(disp, (*client_it)->window(), x, y,
                           (*client_it)->width(), (*client_it)->height());
 
@@ -724,6 +760,7 @@ void Slit::reconfigure() {
 
         XSendEvent(disp, (*client_it)->window(), False, StructureNotifyMask,
                    &event);
+        (*client_it)->setPlaced(true);
 
         if (height_inc)
             y += (*client_it)->height() + bevel_width;
@@ -736,10 +773,8 @@ void Slit::reconfigure() {
     else if (!doAutoHide() && isHidden())
         toggleHidden(); // restore visible
 
-    m_slitmenu.reconfigure();
-    updateClientmenu();
     updateStrut();
-
+    m_render_background = false;
 }
 
 
@@ -1024,8 +1059,9 @@ void Slit::configureRequestEvent(XConfigureRequestEvent &event) {
         }
     }
 
+    // dockapps resizing themselves may ask many times in a row
     if (reconf)
-        reconfigure();
+        m_relayout.schedule();
 }
 
 void Slit::exposeEvent(XExposeEvent &ev) {
@@ -1035,7 +1071,8 @@ void Slit::exposeEvent(XExposeEvent &ev) {
 }
 
 void Slit::screenSizeChanged(BScreen &screen) {
-    reconfigure();
+    if (screen.headChanged(getOnHead()))
+        reconfigure();
 #ifdef XINERAMA
     if (m_xineramaheadmenu)
         m_xineramaheadmenu->reloadHeads();
@@ -1281,8 +1318,10 @@ void Slit::saveOnHead(int head) {
 }
 
 void Slit::updateAlpha() {
+    FbTk::MemoryAccount::Scope account(FbTk::MemoryAccount::IN_SLIT);
+    FbTk::RequestStats::Widget widget(typeid(*this));
     // called when the alpha resource is changed
-    if (FbTk::Transparent::haveComposite()) {
+    if (FbTk::Transparent::useComposite(screen().screenNumber())) {
         frame.window.setOpaque(*m_rc_alpha);
     } else {
         frame.window.setAlpha(*m_rc_alpha);
@@ -36,6 +36,7 @@
 #include "FbTk/Menu.hh"
 #include "FbTk/FbWindow.hh"
 #include "FbTk/Timer.hh"
+#include "FbTk/IdleTask.hh"
 #include "FbTk/Resource.hh"
 #include "FbTk/LayerItem.hh"
 #include "FbTk/Signal.hh"
@@ -77,6 +78,9 @@ public:
     void addClient(Window clientwin);
     void removeClient(Window clientwin, bool remap = true);
     void reconfigure();
+    /// places the clients and sizes the slit around them, without
+    /// reloading the theme or the menus
+    void relayout();
     void reposition();
     void shutdown();
     /// save clients name in a file
@@ -163,14 +167,20 @@ private:
                    EnterWindowMask | LeaveWindowMask | ExposureMask,
                    true),  // override redirect
             x(0), y(0), x_hidden(0), y_hidden(0),
-        width(10), height(10) {}
+        width(10), height(10), pixmap_width(0), pixmap_height(0) {}
         Pixmap pixmap;
         FbTk::FbWindow window;
 
         int x, y, x_hidden, y_hidden;
         unsigned int width, height;
+        unsigned int pixmap_width, pixmap_height; ///< size pixmap was rendered for
     } frame;
 
+    /// the theme or the background changed, render and place everything
+    bool m_render_background;
+    /// coalesces the relayouts of clients docking and resizing themselves
+    FbTk::IdleTask m_relayout;
+
     // for KDE
     Atom m_kwm1_dockwindow, m_kwm2_dockwindow;
 
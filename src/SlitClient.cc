@@ -49,8 +49,9 @@ void SlitClient::initialize(BScreen *screen, Window win) {
 
     m_client_window = win;
     m_window = m_icon_window = None;
-    move(0, 0);
-    resize(0, 0);
+    m_x = m_y = 0;
+    m_width = m_height = 0;
+    m_placed = false;
 
     if (matchName().logical().empty())
         m_match_name.setLogical(Xutil::getWMClassName(clientWindow()));
@@ -25,6 +25,7 @@
 #include "FbTk/ImageControl.hh"
 #include "FbTk/TextUtils.hh"
 #include "FbTk/MemFun.hh"
+#include "FbTk/FbTime.hh"
 
 #include "AtomHandler.hh"
 #include "fluxbox.hh"
@@ -32,6 +33,9 @@
 #include "Screen.hh"
 #include "ButtonTheme.hh"
 #include "Debug.hh"
+#include "FbTk/RoundTrips.hh"
+#include "FbTk/AtomCache.hh"
+#include "FbTk/RequestStats.hh"
 
 #include <X11/Xutil.h>
 #include <X11/Xatom.h>
@@ -48,10 +52,23 @@ using std::dec;
 /// helper class for tray windows, so we dont call XDestroyWindow
 class TrayWindow: public FbTk::FbWindow {
 public:
-    TrayWindow(Window win, bool using_xembed):FbTk::FbWindow(win), m_visible(false), m_xembedded(using_xembed) {
+    TrayWindow(Window win, bool using_xembed):FbTk::FbWindow(win), m_visible(false), m_xembedded(using_xembed),
+                                              m_corrections(0), m_corrections_since(0) {
         setEventMask(PropertyChangeMask);
     }
 
+    /// some icons keep resizing themselves, we put them back into
+    /// shape only so often
+    bool mayCorrectSize() {
+        static const unsigned int MAX_CORRECTIONS = 5; // per second
+        uint64_t now = FbTk::FbTime::mono();
+        if (now - m_corrections_since >= FbTk::FbTime::IN_SECONDS) {
+            m_corrections_since = now;
+            m_corrections = 0;
+        }
+        return m_corrections++ < MAX_CORRECTIONS;
+    }
+
     bool isVisible() { return m_visible; }
     bool isXEmbedded() { return m_xembedded; }
     void show() {
@@ -94,6 +111,8 @@ public:
 private:
     bool m_visible;
     bool m_xembedded; // using xembed protocol? (i.e. unmap when done)
+    unsigned int m_corrections; ///< size corrections since m_corrections_since
+    uint64_t m_corrections_since;
 };
 
 /// handles clientmessage event and notifies systemtray
@@ -165,6 +184,7 @@ SystemTray::SystemTray(const FbTk::FbWindow& parent,
     
     FbTk::EventManager::instance()->add(*this, m_window);
     FbTk::EventManager::instance()->add(*this, m_selection_owner);
+    m_update_task.setFunctor(FbTk::MemFun(*this, &SystemTray::updateClients));
     // setup signals
     join(m_theme->reconfigSig(), FbTk::MemFun(*this, &SystemTray::update));
 
@@ -177,7 +197,7 @@ SystemTray::SystemTray(const FbTk::FbWindow& parent,
 
     // get selection owner and see if it's free
     string atom_name = getNetSystemTrayAtom(m_window.screenNumber());
-    Atom tray_atom = XInternAtom(disp, atom_name.c_str(), False);
+    Atom tray_atom = FbTk::AtomCache::instance().get(atom_name);
     Window owner = XGetSelectionOwner(disp, tray_atom);
     if (owner != 0) {
         fbdbg<<"(SystemTray(const FbTk::FbWindow)): can't set owner!"<<endl;
@@ -201,7 +221,7 @@ SystemTray::SystemTray(const FbTk::FbWindow& parent,
     Window root_window = m_screen.rootWindow().window();
     XEvent ce;
     ce.xclient.type = ClientMessage;
-    ce.xclient.message_type = XInternAtom(disp, "MANAGER", False);
+    ce.xclient.message_type = FbTk::AtomCache::instance().get("MANAGER");
     ce.xclient.display = disp;
     ce.xclient.window = root_window;
     ce.xclient.format = 32;
@@ -224,7 +244,7 @@ SystemTray::~SystemTray() {
 
     // get selection owner and see if it's free
     string atom_name = getNetSystemTrayAtom(m_window.screenNumber());
-    Atom tray_atom = XInternAtom(disp, atom_name.c_str(), False);
+    Atom tray_atom = FbTk::AtomCache::instance().get(atom_name);
 
     // Properly give up selection.
     XSetSelectionOwner(disp, tray_atom, None, CurrentTime);
@@ -295,7 +315,7 @@ bool SystemTray::clientMessage(const XClientMessageEvent &event) {
     static const int SYSTEM_TRAY_REQUEST_DOCK  =  0;
     //    static const int SYSTEM_TRAY_BEGIN_MESSAGE =  1;
     //    static const int SYSTEM_TRAY_CANCEL_MESSAGE = 2;
-    static Atom systray_opcode_atom = XInternAtom(FbTk::App::instance()->display(), "_NET_SYSTEM_TRAY_OPCODE", False);
+    static Atom systray_opcode_atom = FbTk::AtomCache::instance().get("_NET_SYSTEM_TRAY_OPCODE");
 
     if (event.message_type == systray_opcode_atom) {
 
@@ -333,26 +353,49 @@ SystemTray::ClientList::iterator SystemTray::findClient(Window win) {
 }
 
 void SystemTray::addClient(Window win, bool using_xembed) {
-    if (win == 0)
+    if (win == 0 || findClient(win) != m_clients.end())
         return;
 
-    ClientList::iterator it = findClient(win);
-    if (it != m_clients.end())
+    for (size_t i = 0; i < m_pending.size(); ++i) {
+        if (m_pending[i].first == win)
+            return;
+    }
+
+    // applets dock in bursts at startup, embed them all in one go
+    m_pending.push_back(std::make_pair(win, using_xembed));
+    m_update_task.schedule();
+}
+
+void SystemTray::updateClients() {
+    PendingList pending;
+    pending.swap(m_pending);
+    for (size_t i = 0; i < pending.size(); ++i)
+        embedClient(pending[i].first, pending[i].second);
+
+    // showing the new clients asked for another run
+    m_update_task.cancel();
+    rearrangeClients();
+}
+
+void SystemTray::embedClient(Window win, bool using_xembed) {
+    if (findClient(win) != m_clients.end())
         return;
 
     Display *disp = Fluxbox::instance()->display();
-    // make sure we have the same screen number
+    // make sure we have the same screen number, and that the window
+    // still exists after waiting for idle
     XWindowAttributes attr;
     attr.screen = 0;
-    if (XGetWindowAttributes(disp, win, &attr) != 0 &&
-        attr.screen != 0 &&
-        XScreenNumberOfScreen(attr.screen) != window().screenNumber()) {
+    FBTK_ROUNDTRIP("SystemTray::embedClient");
+    if (XGetWindowAttributes(disp, win, &attr) == 0 ||
+        (attr.screen != 0 &&
+         XScreenNumberOfScreen(attr.screen) != window().screenNumber())) {
         return;
     }
 
     TrayWindow *traywin = new TrayWindow(win, using_xembed);
 
-    fbdbg<<"SystemTray::addClient(Window): 0x"<<hex<<win<<dec<<endl;
+    fbdbg<<"SystemTray::embedClient(Window): 0x"<<hex<<win<<dec<<endl;
 
     m_clients.push_back(traywin);
     FbTk::EventManager::instance()->add(*this, win);
@@ -360,7 +403,7 @@ void SystemTray::addClient(Window win, bool using_xembed) {
     traywin->addToSaveSet();
 
     if (using_xembed) {
-        static Atom xembed_atom = XInternAtom(disp, "_XEMBED", False);
+        static Atom xembed_atom = FbTk::AtomCache::instance().get("_XEMBED");
 
 #define XEMBED_EMBEDDED_NOTIFY		0
         // send embedded message
@@ -384,6 +427,13 @@ void SystemTray::addClient(Window win, bool using_xembed) {
 }
 
 void SystemTray::removeClient(Window win, bool destroyed) {
+    for (size_t i = 0; i < m_pending.size(); ++i) {
+        if (m_pending[i].first == win) {
+            m_pending.erase(m_pending.begin() + i);
+            return;
+        }
+    }
+
     ClientList::iterator tray_it = findClient(win);
     if (tray_it == m_clients.end())
         return;
@@ -423,8 +473,9 @@ void SystemTray::handleEvent(XEvent &event) {
         // our toolbar
         ClientList::iterator it = findClient(event.xconfigure.window);
         if (it != m_clients.end()) {
-            if (static_cast<unsigned int>(event.xconfigure.width) != (*it)->width() ||
-                static_cast<unsigned int>(event.xconfigure.height) != (*it)->height()) {
+            if ((static_cast<unsigned int>(event.xconfigure.width) != (*it)->width() ||
+                 static_cast<unsigned int>(event.xconfigure.height) != (*it)->height()) &&
+                (*it)->mayCorrectSize()) {
                 // the position might differ so we update from our local
                 // copy of position
                 XMoveResizeWindow(FbTk::App::instance()->display(), (*it)->window(),
@@ -504,7 +555,7 @@ void SystemTray::hideClient(TrayWindow *traywin, bool destroyed) {
     if (!destroyed)
         traywin->hide();
     m_num_visible_clients--;
-    rearrangeClients();
+    m_update_task.schedule();
 }
 
 void SystemTray::showClient(TrayWindow *traywin) {
@@ -516,21 +567,25 @@ void SystemTray::showClient(TrayWindow *traywin) {
 
     traywin->show();
     m_num_visible_clients++;
-    rearrangeClients();
+    m_update_task.schedule();
 }
 
 void SystemTray::update() {
+    FbTk::RequestStats::Widget widget(typeid(*this));
 
+    // released last, an unchanged tray gets its pixmap from the cache
+    Pixmap old_pm = m_pixmap;
     if (!m_theme->texture().usePixmap()) {
+        m_pixmap = 0;
         m_window.setBackgroundColor(m_theme->texture().color());
     }
     else {
-        if(m_pixmap)
-            m_screen.imageControl().removeImage(m_pixmap);
         m_pixmap = m_screen.imageControl().renderImage(width(), height(),
                                                        m_theme->texture(), orientation());
         m_window.setBackgroundPixmap(m_pixmap);
     }
+    if (old_pm)
+        m_screen.imageControl().removeImage(old_pm);
 
     ClientList::iterator client_it = m_clients.begin();
     ClientList::iterator client_it_end = m_clients.end();
@@ -547,7 +602,7 @@ void SystemTray::update() {
 }
 
 Atom SystemTray::getXEmbedInfoAtom() {
-    static Atom theatom = XInternAtom(Fluxbox::instance()->display(), "_XEMBED_INFO", False);
+    static Atom theatom = FbTk::AtomCache::instance().get("_XEMBED_INFO");
     return theatom;
 }
 
@@ -26,12 +26,15 @@
 #include "FbTk/FbWindow.hh"
 #include "FbTk/EventHandler.hh"
 #include "FbTk/Signal.hh"
+#include "FbTk/IdleTask.hh"
 
 #include "ToolTheme.hh"
 #include "ToolbarItem.hh"
 
 #include <list>
 #include <memory>
+#include <utility>
+#include <vector>
 
 class BScreen;
 class ButtonTheme;
@@ -63,6 +66,7 @@ public:
     void exposeEvent(XExposeEvent &event);
     void handleEvent(XEvent &event);
 
+    /// docks a window when idle, together with all others asking meanwhile
     void addClient(Window win, bool using_xembed);
     void removeClient(Window win, bool destroyed);
 
@@ -94,6 +98,9 @@ private:
     ClientList::iterator findClient(Window win);
 
     void rearrangeClients();
+    /// docks the pending windows and rearranges them all, once
+    void updateClients();
+    void embedClient(Window win, bool using_xembed);
     void removeAllClients();
     void hideClient(TrayWindow *traywin, bool destroyed = false);
     void showClient(TrayWindow *traywin);
@@ -108,6 +115,11 @@ private:
     ClientList m_clients;
     size_t m_num_visible_clients;
 
+    /// windows waiting to be docked, and whether they use xembed
+    typedef std::vector<std::pair<Window, bool> > PendingList;
+    PendingList m_pending;
+    FbTk::IdleTask m_update_task;
+
     // gaim/pidgin seems to barf if the selection is not an independent window.
     // I suspect it's an interacton with parent relationship and gdk window caching.
     FbTk::FbWindow m_selection_owner;
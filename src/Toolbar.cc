@@ -42,6 +42,8 @@
 
 #include "FbTk/I18n.hh"
 #include "FbTk/ImageControl.hh"
+#include "FbTk/MemoryAccount.hh"
+#include "FbTk/RequestStats.hh"
 #include "FbTk/TextUtils.hh"
 #include "FbTk/MacroCommand.hh"
 #include "FbTk/EventManager.hh"
@@ -223,6 +225,8 @@ Toolbar::Toolbar(BScreen &scrn, FbTk::Layer &layer, size_t width):
     m_rc_height(scrn.resourceManager(), 0, scrn.name() + ".toolbar.height", scrn.altName() + ".Toolbar.Height"),
     m_rc_tools(scrn.resourceManager(), "prevworkspace, workspacename, nextworkspace, iconbar, systemtray, clock",
                scrn.name() + ".toolbar.tools", scrn.altName() + ".Toolbar.Tools"),
+    m_rc_double_buffer(scrn.resourceManager(), false,
+                       scrn.name() + ".toolbar.doubleBuffer", scrn.altName() + ".Toolbar.DoubleBuffer"),
     m_shape(new FbTk::Shape(frame.window, 0)),
     m_resize_lock(false) {
     _FB_USES_NLS;
@@ -363,10 +367,13 @@ void Toolbar::lower() {
 }
 
 void Toolbar::screenChanged(BScreen &screen) {
-    reconfigure();
+    if (screen.headChanged(getOnHead()))
+        reconfigure();
 }
 
 void Toolbar::reconfigure() {
+    FbTk::MemoryAccount::Scope account(FbTk::MemoryAccount::IN_TOOLBAR);
+    FbTk::RequestStats::Widget widget(typeid(*this));
 
     updateVisibleState();
 
@@ -453,6 +460,9 @@ void Toolbar::reconfigure() {
                                 frame.width, frame.height);
     }
 
+    // tools with a ParentRelative texture compose their look from ours
+    frame.window.setDoubleBuffered(*m_rc_double_buffer);
+
     // render frame window
     Pixmap tmp = m_window_pm;
     if (!theme()->toolbar().usePixmap()) {
@@ -477,7 +487,7 @@ void Toolbar::reconfigure() {
     frame.window.setBorderColor(theme()->border().color());
     frame.window.setBorderWidth(theme()->border().width());
 
-    bool have_composite = FbTk::Transparent::haveComposite();
+    bool have_composite = FbTk::Transparent::useComposite(screen().screenNumber());
     // have_composite could have changed, so we need to change both
     if (have_composite) {
         frame.window.setOpaque(alpha());
@@ -493,6 +503,8 @@ void Toolbar::reconfigure() {
 
     forAll(m_item_list, std::mem_fun(&ToolbarItem::updateSizing));
 
+    // the theme may have changed anything, place all items again
+    m_item_geometry.clear();
     rearrangeItems();
 
     forAll(m_item_list, std::bind2nd(std::mem_fun(&ToolbarItem::renderTheme), alpha()));
@@ -526,8 +538,9 @@ void Toolbar::buttonPressEvent(XButtonEvent &be) {
 }
 
 void Toolbar::enterNotifyEvent(XCrossingEvent &ce) {
-    Fluxbox::instance()->keys()->doAction(ce.type, ce.state, 0,
-                                          Keys::ON_TOOLBAR);
+    Keys *keys = Fluxbox::instance()->keys();
+    if (keys->isBound(ce.type, Keys::ON_TOOLBAR))
+        keys->doAction(ce.type, ce.state, 0, Keys::ON_TOOLBAR);
 
     if (! doAutoHide()) {
         if (isHidden())
@@ -556,8 +569,9 @@ void Toolbar::leaveNotifyEvent(XCrossingEvent &event) {
         return;
     }
 
-    Fluxbox::instance()->keys()->doAction(event.type, event.state, 0,
-                                          Keys::ON_TOOLBAR);
+    Keys *keys = Fluxbox::instance()->keys();
+    if (keys->isBound(event.type, Keys::ON_TOOLBAR))
+        keys->doAction(event.type, event.state, 0, Keys::ON_TOOLBAR);
 
     if (! doAutoHide())
         return;
@@ -996,15 +1010,25 @@ void Toolbar::rearrangeItems() {
         next_x = 0;
 
     last_bw = 0;
+    bool changed = false;
     for (item_it = m_item_list.begin(); item_it != item_it_end; ++item_it) {
         int borderW = (*item_it)->borderWidth();
+        ItemGeometries::iterator geom = m_item_geometry.find(*item_it);
         if (!(*item_it)->active()) {
-            (*item_it)->hide();
             // make sure it still gets told the toolbar height
             tmpw = 1; tmph = height - 2*(bevel_width+borderW);
             if (tmph >= (1<<30)) tmph = 1;
             FbTk::translateSize(orient, tmpw, tmph);
+            if (geom != m_item_geometry.end() && !geom->second.shown &&
+                (*item_it)->width() == tmpw && (*item_it)->height() == tmph)
+                continue;
+
+            (*item_it)->hide();
             (*item_it)->resize(tmpw, tmph);  // width of 0 changes to 1 anyway
+            ItemGeometry &hidden = m_item_geometry[*item_it];
+            hidden.x = hidden.y = 0;
+            hidden.shown = false;
+            changed = true;
             continue;
         }
         int offset = bevel_width;
@@ -1048,16 +1072,29 @@ void Toolbar::rearrangeItems() {
         FbTk::translateCoords(orient, tmpx, tmpy, width, height);
         FbTk::translatePosition(orient, tmpx, tmpy, tmpw, tmph, borderW);
         FbTk::translateSize(orient, tmpw, tmph);
+
+        // items left of a changed one usually stay where they are
+        if (geom != m_item_geometry.end() && geom->second.shown &&
+            geom->second.x == tmpx && geom->second.y == tmpy &&
+            (*item_it)->width() == tmpw && (*item_it)->height() == tmph)
+            continue;
+
         (*item_it)->moveResize(tmpx, tmpy, tmpw, tmph);
         (*item_it)->show();
-
+        ItemGeometry &shown = m_item_geometry[*item_it];
+        shown.x = tmpx;
+        shown.y = tmpy;
+        shown.shown = true;
+        changed = true;
     }
     // unlock
     m_resize_lock = false;
-    frame.window.clear();
+    if (changed)
+        frame.window.clear();
 }
 
 void Toolbar::deleteItems() {
+    m_item_geometry.clear();
     while (!m_item_list.empty()) {
         delete m_item_list.back();
         m_item_list.pop_back();
@@ -1066,8 +1103,10 @@ void Toolbar::deleteItems() {
 }
 
 void Toolbar::updateAlpha() {
+    FbTk::MemoryAccount::Scope account(FbTk::MemoryAccount::IN_TOOLBAR);
+    FbTk::RequestStats::Widget widget(typeid(*this));
     // called when the alpha resource is changed
-    if (FbTk::Transparent::haveComposite()) {
+    if (FbTk::Transparent::useComposite(screen().screenNumber())) {
         frame.window.setOpaque(*m_rc_alpha);
     } else {
         frame.window.setAlpha(*m_rc_alpha);
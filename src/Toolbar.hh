@@ -43,6 +43,7 @@
 #include "FbTk/FbWindow.hh"
 #include "FbTk/Signal.hh"
 
+#include <map>
 #include <memory>
 
 class BScreen;
@@ -179,6 +180,15 @@ private:
     typedef std::list<ToolbarItem *> ItemList;
     ItemList m_item_list;
 
+    /// where rearrangeItems last put an item, so only the items
+    /// that change get moved
+    struct ItemGeometry {
+        int x, y;
+        bool shown;
+    };
+    typedef std::map<ToolbarItem *, ItemGeometry> ItemGeometries;
+    ItemGeometries m_item_geometry;
+
     ToolFactory m_tool_factory;
 
     Strut *m_strut; ///< created and destroyed by BScreen
@@ -192,6 +202,7 @@ private:
     FbTk::Resource<Placement> m_rc_placement;
     FbTk::Resource<int> m_rc_height;
     FbTk::Resource<std::string> m_rc_tools;
+    FbTk::Resource<bool> m_rc_double_buffer;
     std::auto_ptr<FbTk::Shape> m_shape;
     typedef std::list<std::string> StringList;
     StringList m_tools;
@@ -23,6 +23,8 @@
 #include "TooltipWindow.hh"
 #include "Screen.hh"
 #include "FbWinFrameTheme.hh"
+#include "FbTk/RoundTrips.hh"
+#include "FbTk/MemFun.hh"
 
 
 TooltipWindow::TooltipWindow(const FbTk::FbWindow &parent, BScreen &screen,
@@ -36,6 +38,7 @@ TooltipWindow::TooltipWindow(const FbTk::FbWindow &parent, BScreen &screen,
     m_timer.setCommand(raisecmd);
     m_timer.fireOnce(true);
 
+    m_tracker.join(theme.reconfigSig(), FbTk::MemFun(*this, &TooltipWindow::clearCache));
 }
 
 void TooltipWindow::showText(const FbTk::BiDiString& text) {
@@ -53,10 +56,9 @@ void TooltipWindow::raiseTooltip() {
     if (m_lastText.logical().empty())
         return;
 
-    resize(m_lastText);
-    reconfigTheme();
-    int h = theme()->iconbarTheme().text().font().height() + theme()->bevelWidth() * 2;
-    int w = theme()->iconbarTheme().text().font().textWidth(m_lastText) + theme()->bevelWidth() * 2;
+    FbTk::RefCount<FbTk::FbPixmap> pixmap = renderTooltip(m_lastText);
+    int h = pixmap->height();
+    int w = pixmap->width();
 
     Window root_ret; // not used
     Window window_ret; // not used
@@ -64,6 +66,7 @@ void TooltipWindow::raiseTooltip() {
     int wx, wy; // not used
     unsigned int mask; // not used
 
+    FBTK_ROUNDTRIP("TooltipWindow::raiseTooltip");
     XQueryPointer(display(), screen().rootWindow().window(),
                   &root_ret, &window_ret, &rx, &ry, &wx, &wy, &mask);
 
@@ -87,15 +90,47 @@ void TooltipWindow::raiseTooltip() {
         rx = head_left;
 
     moveResize(rx,ry,w, h);
+    setBackgroundPixmap(pixmap->drawable());
 
     show();
     clear();
+}
+
+FbTk::RefCount<FbTk::FbPixmap> TooltipWindow::renderTooltip(const FbTk::BiDiString &text) {
+
+    CacheIndex::iterator found = m_cache_index.find(text.visual());
+    if (found != m_cache_index.end()) {
+        // move to the front of the lru list
+        m_cache.splice(m_cache.begin(), m_cache, found->second);
+        return found->second->second;
+    }
+
+    const FbTk::Font &font = theme()->iconbarTheme().text().font();
+    int bevel = theme()->bevelWidth();
+    FbTk::FbWindow::resize(font.textWidth(text) + bevel * 2,
+                           font.height() + bevel * 2);
+    reconfigTheme();
+
+    FbTk::RefCount<FbTk::FbPixmap> pixmap(
+        new FbTk::FbPixmap(*this, width(), height(), depth()));
+    drawBackground(*pixmap);
     // TODO: make this use a TextButton like TextDialog does
-    theme()->iconbarTheme().text().font().drawText(*this, screen().screenNumber(),
-                             theme()->iconbarTheme().text().textGC(), 
-                             m_lastText,
-                             theme()->bevelWidth(),
-                             theme()->bevelWidth() + theme()->iconbarTheme().text().font().ascent());
+    font.drawText(*pixmap, screen().screenNumber(),
+                  theme()->iconbarTheme().text().textGC(), text,
+                  bevel, bevel + font.ascent());
+
+    m_cache.push_front(std::make_pair(text.visual(), pixmap));
+    m_cache_index[text.visual()] = m_cache.begin();
+    if (m_cache.size() > CACHE_SIZE) {
+        m_cache_index.erase(m_cache.back().first);
+        m_cache.pop_back();
+    }
+    return pixmap;
+}
+
+void TooltipWindow::clearCache() {
+    m_cache_index.clear();
+    m_cache.clear();
 }
 
 void TooltipWindow::updateText(const FbTk::BiDiString& text) {
@@ -28,6 +28,11 @@
 #include "FbTk/Timer.hh"
 #include "FbTk/SimpleCommand.hh"
 #include "FbTk/FbString.hh"
+#include "FbTk/FbPixmap.hh"
+#include "FbTk/Signal.hh"
+
+#include <list>
+#include <map>
 
 /**
  * Displays a tooltip window
@@ -54,11 +59,23 @@ public:
 
 
 private:
+    /// the most recently shown tooltips, kept until the theme changes
+    typedef std::list<std::pair<FbTk::FbString, FbTk::RefCount<FbTk::FbPixmap> > > Cache;
+    typedef std::map<FbTk::FbString, Cache::iterator> CacheIndex;
+    enum { CACHE_SIZE = 32 };
+
     void raiseTooltip();
     void show();
+    /// @return the tooltip for 'text' with its background and text drawn
+    FbTk::RefCount<FbTk::FbPixmap> renderTooltip(const FbTk::BiDiString &text);
+    void clearCache();
+
     int m_delay; ///< delay time for the timer
     FbTk::BiDiString m_lastText; ///< last text to be displayed
     FbTk::Timer m_timer; ///< delay timer before the tooltip will show
+    Cache m_cache;
+    CacheIndex m_cache_index;
+    FbTk::SignalTracker m_tracker;
 };
 
 #endif // TOOLTIPWINDOW_HH_
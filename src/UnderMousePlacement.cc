@@ -24,6 +24,7 @@
 #include "FbTk/App.hh"
 #include "Screen.hh"
 #include "Window.hh"
+#include "FbTk/RoundTrips.hh"
 
 bool UnderMousePlacement::placeWindow(const FluxboxWindow &win, int head,
                                       int &place_x, int &place_y) {
@@ -34,6 +35,7 @@ bool UnderMousePlacement::placeWindow(const FluxboxWindow &win, int head,
 
     Window ignore_w;
 
+    FBTK_ROUNDTRIP("UnderMousePlacement::placeWindow");
     XQueryPointer(FbTk::App::instance()->display(),
                   win.screen().rootWindow().window(), &ignore_w, 
                   &ignore_w, &root_x, &root_y,
@@ -24,6 +24,7 @@
 
 #include "FbTk/Button.hh"
 #include "FbTk/FbPixmap.hh"
+#include "FbTk/ObjectPool.hh"
 #include "FbTk/Signal.hh"
 
 class FluxboxWindow;
@@ -35,7 +36,8 @@ template <class T> class ThemeProxy;
 }
 
 /// draws and handles basic window button graphic
-class WinButton:public FbTk::Button, public FbTk::SignalTracker {
+class WinButton:public FbTk::Button, public FbTk::SignalTracker,
+                public FbTk::Pooled<WinButton> {
 public:
     /// draw type for the button
     enum Type {MAXIMIZE, MINIMIZE, SHADE, STICK, CLOSE, MENUICON};
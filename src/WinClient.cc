@@ -31,12 +31,17 @@
 
 #include "FbTk/EventManager.hh"
 #include "FbTk/MultLayers.hh"
+#include "FbTk/RoundTrips.hh"
+#include "FbTk/AtomCache.hh"
 
 #include <iostream>
 #include <algorithm>
 #include <iterator>
 #include <memory>
 #include <X11/Xatom.h>
+#ifdef HAVE_XSYNC
+#include <X11/extensions/sync.h>
+#endif // HAVE_XSYNC
 
 #ifdef HAVE_CASSERT
   #include <cassert>
@@ -59,7 +64,8 @@ using std::dec;
 
 namespace {
 
-void sendMessage(const WinClient& win, Atom atom, Time time) {
+void sendMessage(const WinClient& win, Atom atom, Time time,
+                 long data2 = 0l, long data3 = 0l) {
     XEvent ce;
     ce.xclient.type = ClientMessage;
     ce.xclient.message_type = FbAtoms::instance()->getWMProtocolsAtom();
@@ -68,12 +74,24 @@ void sendMessage(const WinClient& win, Atom atom, Time time) {
     ce.xclient.format = 32;
     ce.xclient.data.l[0] = atom;
     ce.xclient.data.l[1] = time;
-    ce.xclient.data.l[2] = 0l;
-    ce.xclient.data.l[3] = 0l;
+    ce.xclient.data.l[2] = data2;
+    ce.xclient.data.l[3] = data3;
     ce.xclient.data.l[4] = 0l;
     XSendEvent(win.display(), win.window(), false, NoEventMask, &ce);
 }
 
+#ifdef HAVE_XSYNC
+bool haveSyncExtension(Display *disp) {
+    static int s_have_sync = -1;
+    if (s_have_sync < 0) {
+        int event_base, error_base, major, minor;
+        s_have_sync = XSyncQueryExtension(disp, &event_base, &error_base) &&
+            XSyncInitialize(disp, &major, &minor);
+    }
+    return s_have_sync;
+}
+#endif // HAVE_XSYNC
+
 } // end of anonymous namespace
 
 WinClient::TransientWaitMap WinClient::s_transient_wait;
@@ -91,11 +109,17 @@ WinClient::WinClient(Window win, BScreen &screen, FluxboxWindow *fbwin):
                      accepts_input(false),
                      send_focus_message(false),
                      send_close_message(false),
+                     send_sync_request(false),
+                     m_sync_counter(0),
+                     m_sync_value(0),
                      m_title_override(false),
                      m_icon_override(false),
                      m_window_type(WindowState::TYPE_NORMAL),
                      m_mwm_hint(0),
-                     m_strut(0) {
+                     m_strut(0),
+                     m_group_left(None),
+                     m_group_left_set(false),
+                     m_properties(win) {
 
     old_bw = borderWidth();
     updateWMProtocols();
@@ -164,7 +188,7 @@ WinClient::~WinClient() {
     s_transient_wait.erase(window());
 
     if (window_group != 0) {
-        fluxbox->removeGroupSearch(window_group);
+        fluxbox->removeGroupSearch(window_group, this);
         window_group = 0;
     }
 
@@ -208,10 +232,12 @@ void WinClient::sendClose(bool forceful) {
 }
 
 bool WinClient::getAttrib(XWindowAttributes &attr) const {
+    FBTK_ROUNDTRIP("WinClient::getAttrib");
     return XGetWindowAttributes(display(), window(), &attr);
 }
 
 bool WinClient::getWMName(XTextProperty &textprop) const {
+    FBTK_ROUNDTRIP("WinClient::getWMName");
     return XGetWMName(display(), window(), &textprop);
 }
 
@@ -220,15 +246,13 @@ bool WinClient::getWMIconName(XTextProperty &textprop) const {
 }
 
 string WinClient::getWMRole() const {
-    Atom wm_role = XInternAtom(FbTk::App::instance()->display(),
-                               "WM_WINDOW_ROLE", False);
+    Atom wm_role = FbTk::AtomCache::instance().get("WM_WINDOW_ROLE");
     return textProperty(wm_role);
 }
 
 void WinClient::updateWMClassHint() {
 
-    m_instance_name = Xutil::getWMClassName(window());
-    m_class_name = Xutil::getWMClassClass(window());
+    Xutil::getWMClass(window(), m_instance_name, m_class_name);
 }
 
 void WinClient::updateTransientInfo() {
@@ -242,7 +266,7 @@ void WinClient::updateTransientInfo() {
     transient_for = 0;
     // determine if this is a transient window
     Window win = 0;
-    if (!XGetTransientForHint(display(), window(), &win)) {
+    if (!Xutil::getTransientFor(window(), win)) {
 
         fbdbg<<__FUNCTION__<<": window() = 0x"<<hex<<window()<<dec<<"Failed to read transient for hint."<<endl;
         return;
@@ -327,6 +351,18 @@ void WinClient::setIcon(const FbTk::PixmapWithMask& pm) {
 
     m_icon.pixmap().copy(pm.pixmap());
     m_icon.mask().copy(pm.mask());
+    m_shared_icon = FbTk::RefCount<FbTk::PixmapWithMask>();
+    m_icon_override = true;
+    titleSig().emit(m_title.logical(), *this);
+}
+
+void WinClient::setIcon(const FbTk::RefCount<FbTk::PixmapWithMask>& pm) {
+
+    // share before letting go of the old one, it may be the same
+    FbTk::RefCount<FbTk::PixmapWithMask> old = m_shared_icon;
+    m_shared_icon = pm;
+    m_icon.pixmap().share(pm->pixmap());
+    m_icon.mask().share(pm->mask());
     m_icon_override = true;
     titleSig().emit(m_title.logical(), *this);
 }
@@ -361,7 +397,8 @@ void WinClient::updateMWMHints() {
 }
 
 void WinClient::updateWMHints() {
-    XWMHints *wmhint = XGetWMHints(display(), window());
+    XWMHints hints;
+    XWMHints *wmhint = Xutil::getWMHints(window(), hints) ? &hints : 0;
     accepts_input = true;
     window_group = None;
     initial_state = NormalState;
@@ -409,16 +446,13 @@ void WinClient::updateWMHints() {
                 Fluxbox::instance()->attentionHandler().windowFocusChanged(*this);
             }
         }
-
-        XFree(wmhint);
     }
 }
 
 
 void WinClient::updateWMNormalHints() {
-    long icccm_mask;
     XSizeHints sizehint;
-    if (!XGetWMNormalHints(display(), window(), &sizehint, &icccm_mask))
+    if (!Xutil::getWMNormalHints(window(), sizehint))
         sizehint.flags = 0;
 
     normal_hint_flags = sizehint.flags;
@@ -429,7 +463,7 @@ Window WinClient::getGroupLeftWindow() const {
     int format;
     Atom atom_return;
     unsigned long num = 0, len = 0;
-    static Atom group_left_hint = XInternAtom(display(), "_FLUXBOX_GROUP_LEFT", False);
+    static Atom group_left_hint = FbTk::AtomCache::instance().get("_FLUXBOX_GROUP_LEFT");
 
     Window *data = 0;
     if (property(group_left_hint, 0,
@@ -454,7 +488,12 @@ Window WinClient::getGroupLeftWindow() const {
 void WinClient::setGroupLeftWindow(Window win) {
     if (m_screen.isShuttingdown())
         return;
-    static Atom group_left_hint = XInternAtom(display(), "_FLUXBOX_GROUP_LEFT", False);
+    // tabs are relinked as a whole, most keep their left neighbour
+    if (m_group_left_set && m_group_left == win)
+        return;
+    m_group_left = win;
+    m_group_left_set = true;
+    static Atom group_left_hint = FbTk::AtomCache::instance().get("_FLUXBOX_GROUP_LEFT");
     changeProperty(group_left_hint, XA_WINDOW, 32,
                    PropModeReplace, (unsigned char *) &win, 1);
 }
@@ -465,7 +504,7 @@ bool WinClient::hasGroupLeftWindow() const {
     int format;
     Atom atom_return;
     unsigned long num = 0, len = 0;
-    static Atom group_left_hint = XInternAtom(display(), "_FLUXBOX_GROUP_LEFT", False);
+    static Atom group_left_hint = FbTk::AtomCache::instance().get("_FLUXBOX_GROUP_LEFT");
 
     Window *data = 0;
     if (property(group_left_hint, 0,
@@ -548,23 +587,25 @@ void WinClient::setAttentionState(bool value) {
 }
 
 void WinClient::updateWMProtocols() {
-    Atom *proto = 0;
-    int num_return = 0;
+    std::vector<Atom> proto;
     FbAtoms *fbatoms = FbAtoms::instance();
 
-    if (XGetWMProtocols(display(), window(), &proto, &num_return)) {
+    if (Xutil::getWMProtocols(window(), fbatoms->getWMProtocolsAtom(), proto)) {
 
         // defaults
         send_focus_message = false;
         send_close_message = false;
-        for (int i = 0; i < num_return; ++i) {
+        send_sync_request = false;
+        for (size_t i = 0; i < proto.size(); ++i) {
             if (proto[i] == fbatoms->getWMDeleteAtom())
                 send_close_message = true;
             else if (proto[i] == fbatoms->getWMTakeFocusAtom())
                 send_focus_message = true;
+            else if (proto[i] == fbatoms->getNetWMSyncRequestAtom())
+                send_sync_request = true;
         }
 
-        XFree(proto);
+        updateSyncCounter();
         if (fbwindow())
             fbwindow()->updateFunctions();
 
@@ -574,6 +615,44 @@ void WinClient::updateWMProtocols() {
 
 }
 
+void WinClient::updateSyncCounter() {
+    m_sync_counter = 0;
+    m_sync_value = 0;
+    if (!send_sync_request)
+        return;
+
+    bool exists = false;
+    long counter = cardinalProperty(FbAtoms::instance()->getNetWMSyncRequestCounterAtom(), &exists);
+    if (exists)
+        m_sync_counter = counter;
+}
+
+bool WinClient::sendSyncRequest(Time time) {
+    if (m_sync_counter == 0)
+        return false;
+
+#ifdef HAVE_XSYNC
+    // the client is still busy with the previous request, don't pile up
+    // another one
+    if (m_sync_value != 0 && haveSyncExtension(display())) {
+        FBTK_ROUNDTRIP("WinClient::sendSyncRequest");
+        XSyncValue value;
+        if (XSyncQueryCounter(display(), m_sync_counter, &value)) {
+            uint64_t current = (static_cast<uint64_t>(XSyncValueHigh32(value)) << 32) |
+                XSyncValueLow32(value);
+            if (current < m_sync_value)
+                return false;
+        }
+    }
+#endif // HAVE_XSYNC
+
+    ++m_sync_value;
+    sendMessage(*this, FbAtoms::instance()->getNetWMSyncRequestAtom(), time,
+                static_cast<long>(m_sync_value & 0xffffffff),
+                static_cast<long>(m_sync_value >> 32));
+    return true;
+}
+
 void WinClient::removeTransientFromWaitingList() {
 
     // holds the windows that dont have empty
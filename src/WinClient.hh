@@ -27,12 +27,18 @@
 
 #include "FbTk/FbWindow.hh"
 #include "FbTk/FbString.hh"
+#include "FbTk/ObjectPool.hh"
+#include "FbTk/RefCount.hh"
+#include "FbTk/PropertyPrefetch.hh"
+
+#include <stdint.h>
 
 class BScreen;
 class Strut;
 
 /// Holds client window info 
-class WinClient: public Focusable, public FbTk::FbWindow {
+class WinClient: public Focusable, public FbTk::FbWindow,
+                 public FbTk::Pooled<WinClient> {
 public:
     typedef std::list<WinClient *> TransientList;
     // this structure only contains 3 elements... the Motif 2.0 structure contains
@@ -51,12 +57,16 @@ public:
                       // i.e. whether we assume the focus will get taken
     bool acceptsFocus() const; // will this window accept focus (according to hints)
     void sendClose(bool forceful = false);
+    /// asks the client to update its _NET_WM_SYNC_REQUEST_COUNTER once it
+    /// has handled the next configure, returns whether a request was sent
+    bool sendSyncRequest(Time time);
     // not aware of anything that makes this false at present
     bool isClosable() const { return true; }
 
     /// updates from wm class hints
     void updateWMClassHint();
     void updateWMProtocols();
+    void updateSyncCounter();
 
     // override the title with this
     void setTitle(const FbTk::FbString &title);
@@ -66,6 +76,8 @@ public:
 
     // override the icon with this
     void setIcon(const FbTk::PixmapWithMask& pm);
+    /// uses a shared icon without copying it
+    void setIcon(const FbTk::RefCount<FbTk::PixmapWithMask>& pm);
 
     // update some thints
     void updateMWMHints();
@@ -153,15 +165,25 @@ private:
     int m_modal_count;
     bool m_modal;
     bool accepts_input, send_focus_message, send_close_message;
+    bool send_sync_request;
+    XID m_sync_counter;
+    uint64_t m_sync_value; ///< last value sent in a sync request
 
     bool m_title_override;
     bool m_icon_override;
+    /// keeps the pixmaps alive that m_icon shares
+    FbTk::RefCount<FbTk::PixmapWithMask> m_shared_icon;
 
     WindowState::WindowType m_window_type;
     MwmHints *m_mwm_hint;
     SizeHints m_size_hints;
 
     Strut *m_strut;
+    /// what we last wrote to _FLUXBOX_GROUP_LEFT, if m_group_left_set
+    Window m_group_left;
+    bool m_group_left_set;
+    /// properties read so far, Fluxbox forgets them on PropertyNotify
+    FbTk::PropertyPrefetch m_properties;
     // map transient_for X window to winclient transient 
     // (used if transient_for FbWindow was created after transient)    
     // Since a lot of transients can be created before transient_for 
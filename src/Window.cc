@@ -28,6 +28,7 @@
 #include "fluxbox.hh"
 #include "Keys.hh"
 #include "Screen.hh"
+#include "OutlineWindow.hh"
 #include "FbWinFrameTheme.hh"
 #include "FbAtoms.hh"
 #include "RootTheme.hh"
@@ -47,6 +48,8 @@
 #include "Debug.hh"
 
 #include "FbTk/StringUtil.hh"
+#include "FbTk/RoundTrips.hh"
+#include "FbTk/EventStats.hh"
 #include "FbTk/Compose.hh"
 #include "FbTk/EventManager.hh"
 #include "FbTk/KeyUtil.hh"
@@ -88,6 +91,7 @@
 #include <functional>
 #include <algorithm>
 
+using std::cerr;
 using std::endl;
 using std::string;
 using std::vector;
@@ -240,8 +244,7 @@ public:
 
     }
     void operator () (FbTk::FbWindow *win) {
-        XChangeProperty(m_disp, win->window(), m_prop, m_prop, 32, m_mode,
-                        m_state, m_num);
+        win->changeProperty(m_prop, m_prop, 32, m_mode, m_state, m_num);
     }
 private:
     Display *m_disp;
@@ -251,10 +254,89 @@ private:
     int m_mode;
 };
 
+/**
+ * How closely the current move or resize follows the pointer. While
+ * session.collectStats is set, a line per drag is printed when it ends:
+ * the motion events handled and those dropped because a newer one came
+ * first, how often the window (or its outline) was moved, and the time
+ * from handling a motion to following it.
+ */
+class DragPacing {
+public:
+    DragPacing(): m_active(false) { }
+
+    void start() {
+        m_active = FbTk::EventStats::instance().enabled();
+        if (!m_active)
+            return;
+        m_start = FbTk::FbTime::mono();
+        m_pending = 0;
+        m_motions = m_dropped = m_configures = 0;
+        m_coalesced = Fluxbox::instance()->coalescerStats().motion;
+        m_latency.reset();
+    }
+
+    /// a motion is handled, 'folded' older ones were skipped for it
+    void motion(unsigned long folded) {
+        if (!m_active)
+            return;
+        ++m_motions;
+        m_dropped += folded;
+        if (m_pending != 0)
+            ++m_dropped; // the last one wasn't followed yet
+        else
+            m_pending = FbTk::FbTime::mono();
+    }
+
+    /// the window or its outline followed the pointer
+    void configure() {
+        if (!m_active)
+            return;
+        ++m_configures;
+        if (m_pending != 0)
+            m_latency.add(FbTk::FbTime::mono() - m_pending);
+        m_pending = 0;
+    }
+
+    void stop(const char *what) {
+        if (!m_active)
+            return;
+        m_active = false;
+        m_dropped += Fluxbox::instance()->coalescerStats().motion - m_coalesced;
+
+        double seconds = double(FbTk::FbTime::mono() - m_start) / FbTk::FbTime::IN_SECONDS;
+        cerr<<what<<": "<<seconds<<" s, "<<m_motions<<" motions, "
+            <<m_dropped<<" dropped, "<<m_configures<<" configures";
+        if (seconds > 0)
+            cerr<<" ("<<m_configures / seconds<<" per second)";
+        if (m_latency.count() > 0)
+            cerr<<", motion to configure "
+                <<double(m_latency.total()) / m_latency.count() / FbTk::FbTime::IN_MILLISECONDS
+                <<" ms average, "
+                <<double(m_latency.percentile(0.99)) / FbTk::FbTime::IN_MILLISECONDS
+                <<" ms p99, "
+                <<double(m_latency.max()) / FbTk::FbTime::IN_MILLISECONDS
+                <<" ms longest";
+        cerr<<endl;
+    }
+
+private:
+    bool m_active;
+    uint64_t m_start;
+    uint64_t m_pending; ///< when the oldest motion not followed yet was handled
+    unsigned long m_motions, m_dropped, m_configures;
+    unsigned long m_coalesced; ///< motions folded by Fluxbox before the drag
+    FbTk::LatencyHistogram m_latency;
+};
+
+/// there is only one drag at a time, see FluxboxWindow::s_num_grabs
+DragPacing s_drag_pacing;
+
 }
 
 
 int FluxboxWindow::s_num_grabs = 0;
+bool FluxboxWindow::s_moving_all = false;
 
 FluxboxWindow::FluxboxWindow(WinClient &client):
     Focusable(client.screen(), this),
@@ -266,6 +348,8 @@ FluxboxWindow::FluxboxWindow(WinClient &client):
     display(FbTk::App::instance()->display()),
     m_button_grab_x(0), m_button_grab_y(0),
     m_last_move_x(0), m_last_move_y(0),
+    m_pending_move_x(0), m_pending_move_y(0),
+    m_move_interval(0), m_last_move_step(0),
     m_last_resize_h(1), m_last_resize_w(1),
     m_last_pressed_button(0),
     m_workspace_number(0),
@@ -287,7 +371,6 @@ FluxboxWindow::FluxboxWindow(WinClient &client):
     m_parent(client.screen().rootWindow()),
     m_resize_corner(RIGHTBOTTOM) {
 
-    join(m_theme.reconfigSig(), FbTk::MemFun(*this, &FluxboxWindow::themeReconfigured));
     join(m_frame.frameExtentSig(), FbTk::MemFun(*this, &FluxboxWindow::frameExtentChanged));
 
     init();
@@ -422,6 +505,9 @@ void FluxboxWindow::init() {
     m_timer.setCommand(raise_cmd);
     m_timer.fireOnce(true);
 
+    m_move_timer.setFunctor(FbTk::MemFun(*this, &FluxboxWindow::applyPendingMove));
+    m_move_timer.fireOnce(true);
+
     /**************************************************/
     /* Read state above here, apply state below here. */
     /**************************************************/
@@ -577,6 +663,11 @@ void FluxboxWindow::attachClient(WinClient &client, int x, int y) {
         if (client_insert_pos != m_clientlist.end())
             button_insert_pos = m_labelbuttons[*client_insert_pos];
 
+        // one relayout of the tabs for the whole group
+        FbTk::Container &tabs = frame().tabcontainer();
+        bool tabs_locked = tabs.updateLock();
+        tabs.setUpdateLock(true);
+
         // make sure we set new window search for each client
         ClientList::iterator client_it = old_win->clientList().begin();
         ClientList::iterator client_it_end = old_win->clientList().end();
@@ -595,6 +686,10 @@ void FluxboxWindow::attachClient(WinClient &client, int x, int y) {
                 frame().moveLabelButtonLeftOf(*m_labelbuttons[*client_it], *button_insert_pos);
         }
 
+        tabs.setUpdateLock(tabs_locked);
+        if (!tabs_locked)
+            tabs.update();
+
         // add client and move over all attached clients
         // from the old window to this list
         m_clientlist.splice(client_insert_pos, old_win->m_clientlist);
@@ -794,28 +889,22 @@ void FluxboxWindow::moveClientRight() {
 
 FluxboxWindow::ClientList::iterator FluxboxWindow::getClientInsertPosition(int x, int y) {
 
-    int dest_x = 0, dest_y = 0;
-    Window labelbutton = 0;
-    if (!XTranslateCoordinates(FbTk::App::instance()->display(),
-                               parent().window(), frame().tabcontainer().window(),
-                               x, y, &dest_x, &dest_y,
-                               &labelbutton))
+    // make x and y relative to the label button below them
+    FbTk::Container &tabs = frame().tabcontainer();
+    int tabs_x, tabs_y;
+    tabs.rootPosition(tabs_x, tabs_y);
+    x -= tabs_x;
+    y -= tabs_y;
+    FbTk::Container::Item labelbutton = tabs.itemAt(x, y);
+    if (!labelbutton)
         return m_clientlist.end();
 
-    WinClient* c = winClientOfLabelButtonWindow(labelbutton);
+    WinClient* c = winClientOfLabelButtonWindow(labelbutton->window());
 
     // label button not found
     if (!c)
         return m_clientlist.end();
 
-    Window child_return=0;
-    // make x and y relative to our labelbutton
-    if (!XTranslateCoordinates(FbTk::App::instance()->display(),
-                               frame().tabcontainer().window(), labelbutton,
-                               dest_x, dest_y, &x, &y,
-                               &child_return))
-        return m_clientlist.end();
-
     ClientList::iterator client = find(m_clientlist.begin(),
                                        m_clientlist.end(),
                                        c);
@@ -829,26 +918,21 @@ FluxboxWindow::ClientList::iterator FluxboxWindow::getClientInsertPosition(int x
 
 
 void FluxboxWindow::moveClientTo(WinClient &win, int x, int y) {
-    int dest_x = 0, dest_y = 0;
-    Window labelbutton = 0;
-    if (!XTranslateCoordinates(FbTk::App::instance()->display(),
-                               parent().window(), frame().tabcontainer().window(),
-                               x, y, &dest_x, &dest_y,
-                               &labelbutton))
+    //make x and y relative to the label button below them
+    FbTk::Container &tabs = frame().tabcontainer();
+    int tabs_x, tabs_y;
+    tabs.rootPosition(tabs_x, tabs_y);
+    x -= tabs_x;
+    y -= tabs_y;
+    FbTk::Container::Item labelbutton = tabs.itemAt(x, y);
+    if (!labelbutton)
         return;
 
-    WinClient* client = winClientOfLabelButtonWindow(labelbutton);
+    WinClient* client = winClientOfLabelButtonWindow(labelbutton->window());
 
     if (!client)
         return;
 
-    Window child_return = 0;
-    //make x and y relative to our labelbutton
-    if (!XTranslateCoordinates(FbTk::App::instance()->display(),
-                               frame().tabcontainer().window(), labelbutton,
-                               dest_x, dest_y, &x, &y,
-                               &child_return))
-        return;
     if (x > static_cast<signed>(m_labelbuttons[client]->width()) / 2)
         moveClientRightOf(win, *client);
     else
@@ -874,10 +958,8 @@ void FluxboxWindow::moveClientLeftOf(WinClient &win, WinClient &dest) {
         //moving a button to the left of itself results in no change
         if (new_pos == it)
             return;
-        //remove from list
-        m_clientlist.erase(it);
-        //insert on the new place
-        m_clientlist.insert(new_pos, &win);
+        //relink on the new place
+        m_clientlist.splice(new_pos, m_clientlist, it);
 
         updateClientLeftWindow();
 }
@@ -901,15 +983,8 @@ void FluxboxWindow::moveClientRightOf(WinClient &win, WinClient &dest) {
     if (new_pos == it)
         return;
 
-    //remove from list
-    m_clientlist.erase(it);
-    //need to insert into the next position
-    new_pos++;
-    //insert on the new place
-    if (new_pos == m_clientlist.end())
-        m_clientlist.push_back(&win);
-    else
-        m_clientlist.insert(new_pos, &win);
+    //relink into the next position
+    m_clientlist.splice(++new_pos, m_clientlist, it);
 
     updateClientLeftWindow();
 }
@@ -919,11 +994,8 @@ void FluxboxWindow::updateClientLeftWindow() {
     if (clientList().empty())
         return;
 
-    // It should just update the affected clients but that
-    // would require more complex code and we're assuming
-    // the user dont have alot of windows grouped so this
-    // wouldn't be too time consuming and it's easier to
-    // implement.
+    // only the clients that got another left neighbour change the
+    // property, WinClient remembers what it wrote
     ClientList::iterator it = clientList().begin();
     ClientList::iterator it_end = clientList().end();
     // set no left window on first tab
@@ -1181,11 +1253,37 @@ void FluxboxWindow::moveResize(int new_x, int new_y,
         m_last_resize_y = new_y;
 
         /* Ignore all EnterNotify events until the pointer actually moves */
-        screen().focusControl().ignoreAtPointer();
+        if (!s_moving_all)
+            screen().focusControl().ignoreAtPointer();
     }
 
 }
 
+void FluxboxWindow::moveResizeAll(const Geometries &geometries) {
+    if (geometries.empty())
+        return;
+
+    // no server grab, the moves go out in one burst anyway
+    FbWinFrame::deferRendering(true);
+    s_moving_all = true;
+
+    Geometries::const_iterator it = geometries.begin();
+    Geometries::const_iterator it_end = geometries.end();
+    for (; it != it_end; ++it)
+        it->window->moveResize(it->x, it->y, it->width, it->height);
+
+    s_moving_all = false;
+    FbWinFrame::deferRendering(false);
+
+    for (it = geometries.begin(); it != it_end; ++it)
+        it->window->frame().renderDeferred();
+
+    /* Ignore all EnterNotify events until the pointer actually moves */
+    geometries.front().window->screen().focusControl().ignoreAtPointer();
+
+    XFlush(FbTk::App::instance()->display());
+}
+
 void FluxboxWindow::moveResizeForClient(int new_x, int new_y,
                                unsigned int new_width, unsigned int new_height, int gravity, unsigned int client_bw) {
 
@@ -1787,7 +1885,7 @@ void FluxboxWindow::installColormap(bool install) {
     if (m_client == 0) return;
 
     Fluxbox *fluxbox = Fluxbox::instance();
-    fluxbox->grab();
+    fluxbox->grab("FluxboxWindow::installColormap");
     if (! m_client->validateClient())
         return;
 
@@ -2140,6 +2238,8 @@ void FluxboxWindow::propertyNotifyEvent(WinClient &client, Atom atom) {
         FbAtoms *fbatoms = FbAtoms::instance();
         if (atom == fbatoms->getWMProtocolsAtom()) {
             client.updateWMProtocols();
+        } else if (atom == fbatoms->getNetWMSyncRequestCounterAtom()) {
+            client.updateSyncCounter();
         } else if (atom == fbatoms->getMWMHintsAtom()) {
             client.updateMWMHints();
             updateMWMHintsFromClient(client);
@@ -2374,7 +2474,19 @@ void FluxboxWindow::buttonReleaseEvent(XButtonEvent &re) {
 
 void FluxboxWindow::motionNotifyEvent(XMotionEvent &me) {
 
+    unsigned long folded = 0;
     if (isMoving() && me.window == parent()) {
+        // only the latest pointer position matters, but don't skip past
+        // anything else, e.g. the release of the button
+        XEvent e;
+        while (XEventsQueued(display, QueuedAlready) > 0) {
+            XPeekEvent(display, &e);
+            if (e.type != MotionNotify || e.xmotion.window != me.window)
+                break;
+            XNextEvent(display, &e);
+            me = e.xmotion;
+            ++folded;
+        }
         me.window = frame().window().window();
     }
 
@@ -2434,18 +2546,23 @@ void FluxboxWindow::motionNotifyEvent(XMotionEvent &me) {
 
     // in case someone put  MoveX :StartMoving etc into keys, we have
     // to activate it before doing the actual motionNotify code
-    Fluxbox::instance()->keys()->doAction(me.type, me.state, m_last_pressed_button, context, &winClient(), me.time);
+    Keys *keys = Fluxbox::instance()->keys();
+    if (keys->isBound(me.type, context))
+        keys->doAction(me.type, me.state, m_last_pressed_button, context, &winClient(), me.time);
 
     if (moving) {
 
+        s_drag_pacing.motion(folded);
+
         // Warp to next or previous workspace?, must have moved sideways some
         int moved_x = me.x_root - m_last_resize_x;
         // save last event point
         m_last_resize_x = me.x_root;
         m_last_resize_y = me.y_root;
 
-        // undraw rectangle before warping workspaces
-        if (!screen().doOpaqueMove()) {
+        // undraw rectangle before warping workspaces, the outline window
+        // stays where it is
+        if (!screen().doOpaqueMove() && !screen().doOutlineWindow()) {
             parent().drawRectangle(screen().rootTheme()->opGC(),
                     m_last_move_x, m_last_move_y,
                     frame().width() + 2*frame().window().borderWidth()-1,
@@ -2499,22 +2616,24 @@ void FluxboxWindow::motionNotifyEvent(XMotionEvent &me) {
         doSnapping(dx, dy);
 
         if (!screen().doOpaqueMove()) {
-            parent().drawRectangle(screen().rootTheme()->opGC(),
-                    dx, dy,
-                    frame().width() + 2*frame().window().borderWidth()-1,
-                    frame().height() + 2*frame().window().borderWidth()-1);
+            if (screen().doOutlineWindow())
+                showOutline(dx, dy, frame().width(), frame().height());
+            else
+                parent().drawRectangle(screen().rootTheme()->opGC(),
+                        dx, dy,
+                        frame().width() + 2*frame().window().borderWidth()-1,
+                        frame().height() + 2*frame().window().borderWidth()-1);
             m_last_move_x = dx;
             m_last_move_y = dy;
-        } else {
-            //moveResize(dx, dy, frame().width(), frame().height());
-            // need to move the base window without interfering with transparency
-            frame().quietMoveResize(dx, dy, frame().width(), frame().height());
-        }
-
-        screen().showPosition(dx, dy);
+            screen().showPosition(dx, dy);
+            s_drag_pacing.configure();
+        } else
+            scheduleMove(dx, dy);
         // end if moving
     } else if (resizing) {
 
+        s_drag_pacing.motion(folded);
+
         int old_resize_x = m_last_resize_x;
         int old_resize_y = m_last_resize_y;
         int old_resize_w = m_last_resize_w;
@@ -2561,18 +2680,23 @@ void FluxboxWindow::motionNotifyEvent(XMotionEvent &me) {
                 old_resize_w != m_last_resize_w ||
                 old_resize_h != m_last_resize_h ) {
 
-            // draw over old rect
-            parent().drawRectangle(screen().rootTheme()->opGC(),
-                    old_resize_x, old_resize_y,
-                    old_resize_w - 1 + 2 * frame().window().borderWidth(),
-                    old_resize_h - 1 + 2 * frame().window().borderWidth());
-
-            // draw resize rectangle
-            parent().drawRectangle(screen().rootTheme()->opGC(),
-                    m_last_resize_x, m_last_resize_y,
-                    m_last_resize_w - 1 + 2 * frame().window().borderWidth(),
-                    m_last_resize_h - 1 + 2 * frame().window().borderWidth());
-
+            if (screen().doOutlineWindow()) {
+                showOutline(m_last_resize_x, m_last_resize_y,
+                            m_last_resize_w, m_last_resize_h);
+            } else {
+                // draw over old rect
+                parent().drawRectangle(screen().rootTheme()->opGC(),
+                        old_resize_x, old_resize_y,
+                        old_resize_w - 1 + 2 * frame().window().borderWidth(),
+                        old_resize_h - 1 + 2 * frame().window().borderWidth());
+
+                // draw resize rectangle
+                parent().drawRectangle(screen().rootTheme()->opGC(),
+                        m_last_resize_x, m_last_resize_y,
+                        m_last_resize_w - 1 + 2 * frame().window().borderWidth(),
+                        m_last_resize_h - 1 + 2 * frame().window().borderWidth());
+            }
+            s_drag_pacing.configure();
         }
     } else if (m_attaching_tab != 0) {
         //
@@ -2605,9 +2729,9 @@ void FluxboxWindow::enterNotifyEvent(XCrossingEvent &ev) {
         return;
     }
 
-    if (ev.window == frame().window())
-        Fluxbox::instance()->keys()->doAction(ev.type, ev.state, 0,
-                                              Keys::ON_WINDOW, m_client);
+    Keys *keys = Fluxbox::instance()->keys();
+    if (ev.window == frame().window() && keys->isBound(ev.type, Keys::ON_WINDOW))
+        keys->doAction(ev.type, ev.state, 0, Keys::ON_WINDOW, m_client);
 
     WinClient *client = 0;
     if (screen().focusControl().isMouseTabFocus()) {
@@ -2659,8 +2783,9 @@ void FluxboxWindow::leaveNotifyEvent(XCrossingEvent &ev) {
         ev.y_root <= (int)(frame().y() + frame().height()))
         return;
 
-    Fluxbox::instance()->keys()->doAction(ev.type, ev.state, 0,
-                                          Keys::ON_WINDOW, m_client);
+    Keys *keys = Fluxbox::instance()->keys();
+    if (keys->isBound(ev.type, Keys::ON_WINDOW))
+        keys->doAction(ev.type, ev.state, 0, Keys::ON_WINDOW, m_client);
 
     // I hope commenting this out is right - simon 21jul2003
     //if (ev.window == frame().window())
@@ -2763,6 +2888,137 @@ void FluxboxWindow::setDecorationMask(unsigned int mask, bool apply) {
         applyDecorations();
 }
 
+namespace {
+
+/**
+ * Sorted edges of the windows (and their external tab boxes) a moving window
+ * can snap to. Built when the move starts, so that every motion event only
+ * looks at the edges that are within the snap threshold.
+ */
+class SnapIndex {
+public:
+    SnapIndex(): m_owner(0), m_workspace(0), m_windows(0) { }
+
+    bool validFor(const FluxboxWindow &win, unsigned int workspace,
+                  size_t windows) const {
+        return m_owner == &win && m_workspace == workspace &&
+            m_windows == windows;
+    }
+
+    void clear() {
+        m_owner = 0;
+        m_boxes.clear();
+        m_xedges.clear();
+        m_yedges.clear();
+    }
+
+    void build(const FluxboxWindow &win, unsigned int workspace,
+               const Workspace::Windows &wins);
+
+    /// same as snapToWindow() against every indexed box
+    void snap(int &xlimit, int &ylimit,
+              int left, int right, int top, int bottom) const;
+
+private:
+    struct Box {
+        int left, right, top, bottom;
+    };
+
+    struct Edge {
+        Edge(int p, size_t b): pos(p), box(b) { }
+        bool operator < (const Edge &other) const { return pos < other.pos; }
+        int pos;
+        size_t box;
+    };
+
+    typedef std::vector<Edge> Edges;
+
+    void add(int left, int right, int top, int bottom);
+
+    const FluxboxWindow *m_owner;
+    unsigned int m_workspace;
+    size_t m_windows;
+    std::vector<Box> m_boxes;
+    Edges m_xedges, m_yedges;
+};
+
+void SnapIndex::add(int left, int right, int top, int bottom) {
+    Box box = { left, right, top, bottom };
+    size_t idx = m_boxes.size();
+    m_boxes.push_back(box);
+    m_xedges.push_back(Edge(left, idx));
+    m_xedges.push_back(Edge(right, idx));
+    m_yedges.push_back(Edge(top, idx));
+    m_yedges.push_back(Edge(bottom, idx));
+}
+
+void SnapIndex::build(const FluxboxWindow &win, unsigned int workspace,
+                      const Workspace::Windows &wins) {
+    clear();
+    m_owner = &win;
+    m_workspace = workspace;
+    m_windows = wins.size();
+
+    Workspace::Windows::const_iterator it = wins.begin();
+    Workspace::Windows::const_iterator it_end = wins.end();
+    for (; it != it_end; ++it) {
+        const FluxboxWindow &w = **it;
+        if (&w == &win)
+            continue;
+
+        int bw = w.decorationMask() & (WindowState::DECORM_BORDER|WindowState::DECORM_HANDLE) ?
+            w.frame().window().borderWidth() : 0;
+
+        add(w.x(), w.x() + w.width() + 2 * bw,
+            w.y(), w.y() + w.height() + 2 * bw);
+
+        // also snap to the box containing the tabs (don't bother with actual
+        // tab edges, since they're dynamic
+        if (w.frame().externalTabMode())
+            add(w.x() - w.xOffset(),
+                w.x() - w.xOffset() + w.width() + 2 * bw + w.widthOffset(),
+                w.y() - w.yOffset(),
+                w.y() - w.yOffset() + w.height() + 2 * bw + w.heightOffset());
+    }
+
+    std::sort(m_xedges.begin(), m_xedges.end());
+    std::sort(m_yedges.begin(), m_yedges.end());
+}
+
+void SnapIndex::snap(int &xlimit, int &ylimit,
+                     int left, int right, int top, int bottom) const {
+
+    const int xs[2] = { left, right };
+    for (int i = 0; i < 2; ++i) {
+        Edges::const_iterator it = std::upper_bound(m_xedges.begin(), m_xedges.end(),
+                                                    Edge(xs[i] - abs(xlimit), 0));
+        for (; it != m_xedges.end() && it->pos < xs[i] + abs(xlimit); ++it) {
+            const Box &box = m_boxes[it->box];
+            // for left + right, need to be in the right y range
+            if (top <= box.bottom && bottom >= box.top &&
+                abs(xs[i] - it->pos) < abs(xlimit))
+                xlimit = it->pos - xs[i];
+        }
+    }
+
+    const int ys[2] = { top, bottom };
+    for (int i = 0; i < 2; ++i) {
+        Edges::const_iterator it = std::upper_bound(m_yedges.begin(), m_yedges.end(),
+                                                    Edge(ys[i] - abs(ylimit), 0));
+        for (; it != m_yedges.end() && it->pos < ys[i] + abs(ylimit); ++it) {
+            const Box &box = m_boxes[it->box];
+            // for top + bottom, need to be in the right x range
+            if (left <= box.right && right >= box.left &&
+                abs(ys[i] - it->pos) < abs(ylimit))
+                ylimit = it->pos - ys[i];
+        }
+    }
+}
+
+SnapIndex s_snap_index;
+
+} // end anonymous namespace
+
 void FluxboxWindow::startMoving(int x, int y) {
 
     if (isMoving()) {
@@ -2798,34 +3054,58 @@ void FluxboxWindow::startMoving(int x, int y) {
 
     m_last_move_x = frame().x();
     m_last_move_y = frame().y();
+    m_move_interval = screen().doOpaqueMove() ? screen().opaqueMoveInterval() : 0;
+    if (screen().getEdgeSnapThreshold() != 0)
+        s_snap_index.build(*this, screen().currentWorkspaceID(),
+                           screen().currentWorkspace()->windowList());
+    m_last_move_step = 0;
+    s_drag_pacing.start();
     if (! screen().doOpaqueMove()) {
-        fluxbox->grab();
-        parent().drawRectangle(screen().rootTheme()->opGC(),
-                               frame().x(), frame().y(),
-                               frame().width() + 2*frame().window().borderWidth()-1,
-                               frame().height() + 2*frame().window().borderWidth()-1);
+        // nothing is drawn on the root window with the outline window, so
+        // the server doesn't need to be grabbed
+        if (screen().doOutlineWindow())
+            showOutline(frame().x(), frame().y(), frame().width(), frame().height());
+        else {
+            // the outline is drawn with xor, nothing else may draw there
+            fluxbox->grab("FluxboxWindow::startMoving");
+            parent().drawRectangle(screen().rootTheme()->opGC(),
+                                   frame().x(), frame().y(),
+                                   frame().width() + 2*frame().window().borderWidth()-1,
+                                   frame().height() + 2*frame().window().borderWidth()-1);
+        }
         screen().showPosition(frame().x(), frame().y());
     }
 }
 
 void FluxboxWindow::stopMoving(bool interrupted) {
+    // the final position is always applied
+    if (m_move_timer.isTiming() && !interrupted)
+        applyPendingMove();
+    m_move_timer.stop();
+    s_snap_index.clear();
+    s_drag_pacing.stop("move");
     moving = false;
     Fluxbox *fluxbox = Fluxbox::instance();
 
     fluxbox->maskWindowEvents(0, 0);
 
     if (! screen().doOpaqueMove()) {
-        parent().drawRectangle(screen().rootTheme()->opGC(),
-                               m_last_move_x, m_last_move_y,
-                               frame().width() + 2*frame().window().borderWidth()-1,
-                               frame().height() + 2*frame().window().borderWidth()-1);
+        bool outline_window = screen().outlineWindow().isVisible();
+        if (outline_window)
+            screen().outlineWindow().hide();
+        else
+            parent().drawRectangle(screen().rootTheme()->opGC(),
+                                   m_last_move_x, m_last_move_y,
+                                   frame().width() + 2*frame().window().borderWidth()-1,
+                                   frame().height() + 2*frame().window().borderWidth()-1);
         if (!interrupted) {
             moveResize(m_last_move_x, m_last_move_y, frame().width(), frame().height());
             if (m_workspace_number != screen().currentWorkspaceID())
                 screen().sendToWorkspace(screen().currentWorkspaceID(), this);
             focus();
         }
-        fluxbox->ungrab();
+        if (!outline_window)
+            fluxbox->ungrab();
     } else if (!interrupted) {
         moveResize(frame().x(), frame().y(), frame().width(), frame().height(), true);
         frame().notifyMoved(true);
@@ -2845,6 +3125,39 @@ void FluxboxWindow::stopMoving(bool interrupted) {
     }
 }
 
+void FluxboxWindow::showOutline(int x, int y,
+                                unsigned int width, unsigned int height) {
+    screen().outlineWindow().showOutline(x, y,
+                                         width + 2 * frame().window().borderWidth(),
+                                         height + 2 * frame().window().borderWidth());
+}
+
+void FluxboxWindow::scheduleMove(int x, int y) {
+    m_pending_move_x = x;
+    m_pending_move_y = y;
+
+    uint64_t since = FbTk::FbTime::mono() - m_last_move_step;
+    if (since >= m_move_interval)
+        applyPendingMove();
+    else if (!m_move_timer.isTiming()) {
+        m_move_timer.setTimeout(0, static_cast<unsigned int>(m_move_interval - since));
+        m_move_timer.start();
+    }
+}
+
+void FluxboxWindow::applyPendingMove() {
+    m_move_timer.stop();
+    if (!moving)
+        return;
+
+    m_last_move_step = FbTk::FbTime::mono();
+    // need to move the base window without interfering with transparency
+    frame().quietMoveResize(m_pending_move_x, m_pending_move_y,
+                            frame().width(), frame().height());
+    screen().showPosition(m_pending_move_x, m_pending_move_y);
+    s_drag_pacing.configure();
+}
+
 /**
  * Helper function that snaps a window to another window
  * We snap if we're closer than the x/ylimits.
@@ -2962,47 +3275,15 @@ void FluxboxWindow::doSnapping(int &orig_left, int &orig_top) {
     Workspace::Windows &wins =
         screen().currentWorkspace()->windowList();
 
-    Workspace::Windows::iterator it = wins.begin();
-    Workspace::Windows::iterator it_end = wins.end();
-
-    unsigned int bw;
-    for (; it != it_end; it++) {
-        if ((*it) == this)
-            continue; // skip myself
-
-        bw = (*it)->decorationMask() & (WindowState::DECORM_BORDER|WindowState::DECORM_HANDLE) ?
-                (*it)->frame().window().borderWidth() : 0;
-
-        snapToWindow(dx, dy, left, right, top, bottom,
-                     (*it)->x(),
-                     (*it)->x() + (*it)->width() + 2 * bw,
-                     (*it)->y(),
-                     (*it)->y() + (*it)->height() + 2 * bw);
+    // the index is built when the move starts, rebuild it if the workspace
+    // or its list of windows changed since then
+    if (!s_snap_index.validFor(*this, screen().currentWorkspaceID(), wins.size()))
+        s_snap_index.build(*this, screen().currentWorkspaceID(), wins);
 
-        if (i_have_tabs)
-            snapToWindow(dx, dy, left - xoff, right - xoff + woff, top - yoff, bottom - yoff + hoff,
-                         (*it)->x(),
-                         (*it)->x() + (*it)->width() + 2 * bw,
-                         (*it)->y(),
-                         (*it)->y() + (*it)->height() + 2 * bw);
-
-        // also snap to the box containing the tabs (don't bother with actual
-        // tab edges, since they're dynamic
-        if ((*it)->frame().externalTabMode())
-            snapToWindow(dx, dy, left, right, top, bottom,
-                         (*it)->x() - (*it)->xOffset(),
-                         (*it)->x() - (*it)->xOffset() + (*it)->width() + 2 * bw + (*it)->widthOffset(),
-                         (*it)->y() - (*it)->yOffset(),
-                         (*it)->y() - (*it)->yOffset() + (*it)->height() + 2 * bw + (*it)->heightOffset());
-
-        if (i_have_tabs)
-            snapToWindow(dx, dy, left - xoff, right - xoff + woff, top - yoff, bottom - yoff + hoff,
-                         (*it)->x() - (*it)->xOffset(),
-                         (*it)->x() - (*it)->xOffset() + (*it)->width() + 2 * bw + (*it)->widthOffset(),
-                         (*it)->y() - (*it)->yOffset(),
-                         (*it)->y() - (*it)->yOffset() + (*it)->height() + 2 * bw + (*it)->heightOffset());
-
-    }
+    s_snap_index.snap(dx, dy, left, right, top, bottom);
+    if (i_have_tabs)
+        s_snap_index.snap(dx, dy, left - xoff, right - xoff + woff,
+                          top - yoff, bottom - yoff + hoff);
 
     // commit
     if (dx <= screen().getEdgeSnapThreshold())
@@ -3078,26 +3359,41 @@ void FluxboxWindow::startResizing(int x, int y, ReferenceCorner dir) {
 
     fixSize();
     frame().displaySize(m_last_resize_w, m_last_resize_h);
+    s_drag_pacing.start();
 
-    parent().drawRectangle(screen().rootTheme()->opGC(),
-                       m_last_resize_x, m_last_resize_y,
-                       m_last_resize_w - 1 + 2 * frame().window().borderWidth(),
-                       m_last_resize_h - 1 + 2 * frame().window().borderWidth());
+    if (screen().doOutlineWindow())
+        showOutline(m_last_resize_x, m_last_resize_y,
+                    m_last_resize_w, m_last_resize_h);
+    else
+        parent().drawRectangle(screen().rootTheme()->opGC(),
+                           m_last_resize_x, m_last_resize_y,
+                           m_last_resize_w - 1 + 2 * frame().window().borderWidth(),
+                           m_last_resize_h - 1 + 2 * frame().window().borderWidth());
 }
 
 void FluxboxWindow::stopResizing(bool interrupted) {
     resizing = false;
+    s_drag_pacing.stop("resize");
 
-    parent().drawRectangle(screen().rootTheme()->opGC(),
-                           m_last_resize_x, m_last_resize_y,
-                           m_last_resize_w - 1 + 2 * frame().window().borderWidth(),
-                           m_last_resize_h - 1 + 2 * frame().window().borderWidth());
+    if (screen().outlineWindow().isVisible())
+        screen().outlineWindow().hide();
+    else
+        parent().drawRectangle(screen().rootTheme()->opGC(),
+                               m_last_resize_x, m_last_resize_y,
+                               m_last_resize_w - 1 + 2 * frame().window().borderWidth(),
+                               m_last_resize_h - 1 + 2 * frame().window().borderWidth());
 
     screen().hideGeometry();
 
     if (!interrupted) {
         fixSize();
 
+        // let the clients tell when they are done with the new size
+        ClientList::iterator it = clientList().begin();
+        ClientList::iterator it_end = clientList().end();
+        for (; it != it_end; ++it)
+            (*it)->sendSyncRequest(Fluxbox::instance()->getLastTime());
+
         moveResize(m_last_resize_x, m_last_resize_y,
                    m_last_resize_w, m_last_resize_h);
     }
@@ -3141,7 +3437,7 @@ void FluxboxWindow::startTabbing(const XButtonEvent &be) {
     m_last_resize_x = be.x_root;
     m_last_resize_y = be.y_root;
 
-    Fluxbox::instance()->grab();
+    Fluxbox::instance()->grab("FluxboxWindow::startTabbing");
 
     if (m_attaching_tab) {
         FbTk::TextButton &active_button = *m_labelbuttons[m_attaching_tab];
@@ -3182,6 +3478,7 @@ void FluxboxWindow::attachTo(int x, int y, bool interrupted) {
 
     int dest_x = 0, dest_y = 0;
     Window child = 0;
+    FBTK_ROUNDTRIP("FluxboxWindow::attachTo");
     if (XTranslateCoordinates(display, parent().window(),
                               parent().window(),
                               x, y, &dest_x, &dest_y, &child)) {
@@ -3651,6 +3948,7 @@ void FluxboxWindow::grabPointer(Window grab_window,
                                 Cursor cursor,
                                 Time time) {
 
+    FBTK_ROUNDTRIP("FluxboxWindow::grabPointer");
     XGrabPointer(FbTk::App::instance()->display(),
                  grab_window,
                  owner_events,
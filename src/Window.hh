@@ -35,6 +35,7 @@
 #include "FbTk/Timer.hh"
 #include "FbTk/EventHandler.hh"
 #include "FbTk/LayerItem.hh"
+#include "FbTk/ObjectPool.hh"
 #include "FbTk/Signal.hh"
 
 #include <sys/time.h>
@@ -58,7 +59,8 @@ class Layer;
 /// Creates the window frame and handles any window event for it
 class FluxboxWindow: public Focusable,
                      public FbTk::EventHandler,
-                     private FbTk::SignalTracker {
+                     private FbTk::SignalTracker,
+                     public FbTk::Pooled<FluxboxWindow> {
 public:
     /// Motif wm Hints
     enum {
@@ -261,6 +263,8 @@ public:
     /// sets whether or not the window gets focused with click
     void setClickFocus(bool value) { m_click_focus = value; }
     void reconfigure();
+    /// applies a changed window theme to the frame
+    void themeReconfigured();
 
 
     void installColormap(bool);
@@ -272,6 +276,20 @@ public:
     void resize(unsigned int width, unsigned int height);
     /// move and resize frame to pox x,y and size width, height
     void moveResize(int x, int y, unsigned int width, unsigned int height, bool send_event = false);
+
+    /// target geometry of a window, for moveResizeAll
+    struct Geometry {
+        FluxboxWindow *window;
+        int x, y;
+        unsigned int width, height;
+    };
+    typedef std::vector<Geometry> Geometries;
+    /**
+     * Moves and resizes all the windows in one go: under a single server
+     * grab, with each frame rendered once at the end, so it shows up as
+     * one update instead of one window after the other.
+     */
+    static void moveResizeAll(const Geometries &geometries);
     /// move to pos x,y and resize client window to size width, height
     void moveResizeForClient(int x, int y, unsigned int width, unsigned int height, int gravity = ForgetGravity, unsigned int client_bw = 0);
     /**
@@ -474,8 +492,6 @@ private:
     void updateClientLeftWindow();
     void grabButtons();
 
-    void themeReconfigured();
-
     /**
      * Calculates insertition position in the list by
      * using pixel position x and y.
@@ -500,6 +516,12 @@ private:
 
     // modifies left and top if snap is necessary
     void doSnapping(int &left, int &top);
+    /// moves the frame at most once per move interval, the last position
+    /// is applied when the interval is over
+    void scheduleMove(int x, int y);
+    /// moves the outline window to a frame geometry, without the borders
+    void showOutline(int x, int y, unsigned int width, unsigned int height);
+    void applyPendingMove();
     // user_w/h return the values that should be shown to the user
     void fixSize();
     void moveResizeClient(WinClient &client);
@@ -534,11 +556,14 @@ private:
     WinClient *m_attaching_tab;
 
     FbTk::Timer m_timer;
+    FbTk::Timer m_move_timer; ///< applies the pending opaque move step
     Display *display; /// display connection
 
     int m_button_grab_x, m_button_grab_y; // handles last button press event for move
     int m_last_resize_x, m_last_resize_y; // handles last button press event for resize
     int m_last_move_x, m_last_move_y; // handles last pos for non opaque moving
+    int m_pending_move_x, m_pending_move_y; // where the next opaque move step goes
+    uint64_t m_move_interval, m_last_move_step; // limits the opaque move steps
     int m_last_resize_h, m_last_resize_w; // handles height/width for resize "window"
     int m_last_pressed_button;
 
@@ -591,6 +616,7 @@ private:
     ReferenceCorner m_resize_corner; //< the current corner used while resizing
 
     static int s_num_grabs; ///< number of XGrabPointer's
+    static bool s_moving_all; ///< inside moveResizeAll
 };
 
 
@@ -0,0 +1,298 @@
+// WindowCoverage.cc
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "WindowCoverage.hh"
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <set>
+
+namespace {
+
+/**
+ * Fills @candidates with the positions a scan in one direction can stop at:
+ * the start of the head and the far side of each window, within the head.
+ */
+void getCandidates(std::vector<int> &candidates, const WindowCoverage::Windows &windows,
+                   bool x_axis, bool forward, int size, int head_min, int head_max) {
+
+    candidates.clear();
+    candidates.push_back(forward ? head_min : head_max - size);
+
+    WindowCoverage::Windows::const_iterator it = windows.begin(),
+                                           it_end = windows.end();
+    for (; it != it_end; ++it) {
+        int pos;
+        if (forward)
+            pos = x_axis ? it->right : it->bottom;
+        else
+            pos = (x_axis ? it->left : it->top) - size;
+
+        if (pos >= head_min && pos + size <= head_max)
+            candidates.push_back(pos);
+    }
+
+    if (forward)
+        std::sort(candidates.begin(), candidates.end());
+    else
+        std::sort(candidates.begin(), candidates.end(), std::greater<int>());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                     candidates.end());
+}
+
+/// a place for the top left corner of the window, from one of its corners
+struct Area {
+    enum Corner {
+        TOPLEFT,
+        TOPRIGHT,
+        BOTTOMLEFT,
+        BOTTOMRIGHT
+    } corner; // indicates the corner of the window that will be placed
+
+    Area(Corner _corner, int _x, int _y):
+        corner(_corner), x(_x), y(_y) { };
+
+    // position where the top left corner of the window will be placed
+    int x, y;
+};
+
+/// orders the areas the way the placement scans, in rows or in columns
+class AreaLess {
+public:
+    AreaLess(bool rows, bool left_right, bool top_bot):
+        m_rows(rows), m_left_right(left_right), m_top_bot(top_bot) { }
+
+    bool operator ()(const Area &a, const Area &o) const {
+        if (m_rows) {
+            // if we're making rows, y-value is most important
+            if (a.y != o.y)
+                return ((a.y < o.y) ^ !m_top_bot);
+            if (a.x != o.x)
+                return ((a.x < o.x) ^ !m_left_right);
+        } else {
+            // if we're making columns, x-value is most important
+            if (a.x != o.x)
+                return ((a.x < o.x) ^ !m_left_right);
+            if (a.y != o.y)
+                return ((a.y < o.y) ^ !m_top_bot);
+        }
+        return (a.corner < o.corner);
+    }
+
+private:
+    bool m_rows, m_left_right, m_top_bot;
+};
+
+/**
+ * The distinct coordinates of the areas for one corner: for each x the
+ * range of y values that has an area, and the other way around.
+ * New areas are generated from all areas on one side of a window edge, so
+ * this finds them without going through every area.
+ */
+class CornerIndex {
+public:
+    typedef std::pair<int, int> Range;
+    typedef std::map<int, Range> Map;
+
+    void add(int x, int y) {
+        addTo(m_by_x, x, y);
+        addTo(m_by_y, y, x);
+    }
+
+    const Map &byX() const { return m_by_x; }
+    const Map &byY() const { return m_by_y; }
+
+private:
+    static void addTo(Map &map, int key, int value) {
+        Map::iterator it = map.find(key);
+        if (it == map.end())
+            map.insert(std::make_pair(key, Range(value, value)));
+        else {
+            it->second.first = std::min(it->second.first, value);
+            it->second.second = std::max(it->second.second, value);
+        }
+    }
+
+    Map m_by_x, m_by_y;
+};
+
+} // end anonymous namespace
+
+void WindowCoverage::add(const FluxboxWindow *window,
+                         int left, int top, int right, int bottom, bool covers) {
+
+    Window w = { window, left, top, right, bottom };
+    m_windows.push_back(w);
+
+    if (covers)
+        m_table.add(left, top, right, bottom);
+}
+
+bool WindowCoverage::findFree(int width, int height,
+                              int head_left, int head_top, int head_right, int head_bot,
+                              bool rows, bool left_right, bool top_bot,
+                              int &place_x, int &place_y) const {
+
+    // a free place always starts at the head or where a window ends, so
+    // only those positions need testing
+    std::vector<int> xs, ys;
+    getCandidates(xs, m_windows, true, left_right, width, head_left, head_right);
+    getCandidates(ys, m_windows, false, top_bot, height, head_top, head_bot);
+
+    const std::vector<int> &outer = rows ? ys : xs;
+    const std::vector<int> &inner = rows ? xs : ys;
+
+    for (size_t i = 0; i < outer.size(); ++i) {
+        for (size_t j = 0; j < inner.size(); ++j) {
+            int x = rows ? inner[j] : outer[i];
+            int y = rows ? outer[i] : inner[j];
+            if (isFree(x, y, width, height)) {
+                place_x = x;
+                place_y = y;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void WindowCoverage::findMinOverlap(int win_w, int win_h,
+                                    int head_left, int head_top, int head_right, int head_bot,
+                                    bool rows, bool left_right, bool top_bot,
+                                    const FluxboxWindow *skip,
+                                    int &place_x, int &place_y) const {
+
+    // we keep a set of open spaces on the desktop, sorted by size/location
+    typedef std::set<Area, AreaLess> Areas;
+    Areas areas(AreaLess(rows, left_right, top_bot));
+
+    CornerIndex index[4];
+    std::vector<Area> added;
+    added.push_back(Area(Area::TOPLEFT, head_left, head_top));
+    added.push_back(Area(Area::TOPRIGHT, head_right - win_w, head_top));
+    added.push_back(Area(Area::BOTTOMLEFT, head_left, head_bot - win_h));
+    added.push_back(Area(Area::BOTTOMRIGHT, head_right - win_w, head_bot - win_h));
+
+    // go through the list of windows, creating other reasonable placements
+    // at the end, we'll find the one with minimum overlap
+    // the size of this set is at most 2(n+2)(n+1) (n = number of windows)
+    // a window creates new areas from every area it overlaps, those never
+    // overlap the same window again, so this only needs the distinct
+    // coordinates of the areas it overlaps
+    Windows::const_reverse_iterator it = m_windows.rbegin(),
+                                    it_end = m_windows.rend();
+    for (;; ++it) {
+
+        for (size_t i = 0; i < added.size(); ++i) {
+            if (areas.insert(added[i]).second)
+                index[added[i].corner].add(added[i].x, added[i].y);
+        }
+        added.clear();
+
+        if (it == it_end)
+            break;
+
+        if (skip != 0 && it->window == skip) continue;
+
+        const int left = it->left, top = it->top;
+        const int right = it->right, bottom = it->bottom;
+
+        CornerIndex::Map::const_iterator ix;
+        const CornerIndex::Map *by_x, *by_y;
+
+        by_x = &index[Area::TOPLEFT].byX();
+        by_y = &index[Area::TOPLEFT].byY();
+        if (bottom + win_h <= head_bot) {
+            for (ix = by_x->begin(); ix != by_x->end() && ix->first < right; ++ix)
+                if (ix->second.first < bottom)
+                    added.push_back(Area(Area::TOPLEFT, ix->first, bottom));
+        }
+        if (right + win_w <= head_right) {
+            for (ix = by_y->begin(); ix != by_y->end() && ix->first < bottom; ++ix)
+                if (ix->second.first < right)
+                    added.push_back(Area(Area::TOPLEFT, right, ix->first));
+        }
+
+        by_x = &index[Area::TOPRIGHT].byX();
+        by_y = &index[Area::TOPRIGHT].byY();
+        if (bottom + win_h <= head_bot) {
+            for (ix = by_x->upper_bound(left - win_w); ix != by_x->end(); ++ix)
+                if (ix->second.first < bottom)
+                    added.push_back(Area(Area::TOPRIGHT, ix->first, bottom));
+        }
+        if (left - win_w >= head_left) {
+            for (ix = by_y->begin(); ix != by_y->end() && ix->first < bottom; ++ix)
+                if (ix->second.second > left - win_w)
+                    added.push_back(Area(Area::TOPRIGHT, left - win_w, ix->first));
+        }
+
+        by_x = &index[Area::BOTTOMRIGHT].byX();
+        by_y = &index[Area::BOTTOMRIGHT].byY();
+        if (top - win_h >= head_top) {
+            for (ix = by_x->upper_bound(left - win_w); ix != by_x->end(); ++ix)
+                if (ix->second.second > top - win_h)
+                    added.push_back(Area(Area::BOTTOMRIGHT, ix->first, top - win_h));
+        }
+        if (left - win_w >= head_left) {
+            for (ix = by_y->upper_bound(top - win_h); ix != by_y->end(); ++ix)
+                if (ix->second.second > left - win_w)
+                    added.push_back(Area(Area::BOTTOMRIGHT, left - win_w, ix->first));
+        }
+
+        by_x = &index[Area::BOTTOMLEFT].byX();
+        by_y = &index[Area::BOTTOMLEFT].byY();
+        if (top - win_h >= head_top) {
+            for (ix = by_x->begin(); ix != by_x->end() && ix->first < right; ++ix)
+                if (ix->second.second > top - win_h)
+                    added.push_back(Area(Area::BOTTOMLEFT, ix->first, top - win_h));
+        }
+        if (right + win_w <= head_right) {
+            for (ix = by_y->upper_bound(top - win_h); ix != by_y->end(); ++ix)
+                if (ix->second.first < right)
+                    added.push_back(Area(Area::BOTTOMLEFT, right, ix->first));
+        }
+    }
+
+    // choose the region with minimum overlap
+    int64_t min_so_far = (int64_t)win_w * win_h * m_windows.size() + 1;
+    Areas::const_iterator min_reg = areas.begin();
+
+    Areas::const_iterator ar_it = areas.begin();
+    for (; ar_it != areas.end(); ++ar_it) {
+
+        int64_t overlap = coverage(ar_it->x, ar_it->y, win_w, win_h);
+
+        // if this placement is better, use it
+        if (overlap < min_so_far) {
+            min_reg = ar_it;
+            min_so_far = overlap;
+            if (overlap == 0) // can't do better than this
+                break;
+        }
+
+    }
+
+    place_x = min_reg->x;
+    place_y = min_reg->y;
+}
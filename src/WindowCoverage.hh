@@ -0,0 +1,94 @@
+// WindowCoverage.hh
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#ifndef WINDOWCOVERAGE_HH
+#define WINDOWCOVERAGE_HH
+
+#include "FbTk/CoverageTable.hh"
+
+#include <vector>
+
+class FluxboxWindow;
+
+/**
+ * The windows a placement strategy has to work around, usually all windows
+ * on the workspace of the window being placed (see
+ * ScreenPlacement::getCoverage), and a FbTk::CoverageTable of them to tell
+ * how much of any place they cover. Only geometry, no X or FluxboxWindow.
+ */
+class WindowCoverage {
+public:
+    struct Window {
+        const FluxboxWindow *window;
+        /// the frame including its decorations and borders
+        int left, top, right, bottom;
+    };
+    typedef std::vector<Window> Windows;
+
+    /**
+     * Adds a window, call build() after the last one.
+     * @param covers whether the window counts for coverage()
+     */
+    void add(const FluxboxWindow *window, int left, int top, int right, int bottom,
+             bool covers = true);
+    /// makes coverage() and isFree() include the added windows
+    void build() { m_table.build(); }
+
+    /// @return the windows in the order they were added
+    const Windows &windows() const { return m_windows; }
+
+    /// @return the summed area the windows share with the place
+    int64_t coverage(int x, int y, int width, int height) const {
+        return m_table.coverage(x, y, x + width, y + height);
+    }
+
+    bool isFree(int x, int y, int width, int height) const {
+        return m_table.isFree(x, y, x + width, y + height);
+    }
+
+    /**
+     * Finds the first free place in rows (or columns) in the given directions,
+     * i.e. the place the row and column smart placements scan for.
+     * @return true if there is a free place
+     */
+    bool findFree(int width, int height,
+                  int head_left, int head_top, int head_right, int head_bot,
+                  bool rows, bool left_right, bool top_bot,
+                  int &place_x, int &place_y) const;
+
+    /**
+     * Finds the place with the least coverage, the first one in rows (or
+     * columns) in the given directions if several are equally good.
+     * @param skip window that doesn't create places, i.e. the one being placed
+     */
+    void findMinOverlap(int width, int height,
+                        int head_left, int head_top, int head_right, int head_bot,
+                        bool rows, bool left_right, bool top_bot,
+                        const FluxboxWindow *skip,
+                        int &place_x, int &place_y) const;
+
+private:
+    Windows m_windows;
+    FbTk::CoverageTable m_table;
+};
+
+#endif // WINDOWCOVERAGE_HH
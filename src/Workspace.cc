@@ -35,6 +35,8 @@
 #include "FbTk/StringUtil.hh"
 #include "FbTk/FbString.hh"
 #include "FbTk/MemFun.hh"
+#include "FbTk/MultLayers.hh"
+#include "FbTk/Layer.hh"
 
 // use GNU extensions
 #ifndef  _GNU_SOURCE
@@ -60,6 +62,7 @@
 #endif
 
 #include <algorithm>
+#include <map>
 
 using std::string;
 
@@ -69,9 +72,6 @@ Workspace::Workspace(BScreen &scrn, const string &name, unsigned int id):
     m_name(name),
     m_id(id) {
 
-    m_clientlist_sig.connect(FbTk::MemFun(m_clientmenu,
-                                          &ClientMenu::refreshMenu));
-
     menu().setInternalMenu();
     setName(name);
 
@@ -90,7 +90,7 @@ void Workspace::addWindow(FluxboxWindow &w) {
     w.setWorkspace(m_id);
 
     m_windowlist.push_back(&w);
-    m_clientlist_sig.emit();
+    m_clientmenu.addWindow(w);
 
 }
 
@@ -112,16 +112,39 @@ int Workspace::removeWindow(FluxboxWindow *w, bool still_alive) {
         FocusControl::unfocusWindow(w->winClient(), true, true);
 
     m_windowlist.remove(w);
-    m_clientlist_sig.emit();
+    m_clientmenu.removeWindow(*w);
 
     return m_windowlist.size();
 }
 
 void Workspace::showAll() {
+    // map from the top of the stack down, so the windows below are mapped
+    // already covered and don't get exposed for nothing
+    std::map<FbTk::LayerItem *, FluxboxWindow *> windows;
     Windows::iterator it = m_windowlist.begin();
     Windows::iterator it_end = m_windowlist.end();
     for (; it != it_end; ++it)
-        (*it)->show();
+        windows[&(*it)->layerItem()] = *it;
+
+    FbTk::MultLayers &layers = m_screen.layerManager();
+    for (int layer = 0; layer < layers.size() && !windows.empty(); ++layer) {
+        const FbTk::Layer::ItemList &items = layers.getLayer(layer)->itemList();
+        FbTk::Layer::ItemList::const_iterator item_it = items.begin();
+        for (; item_it != items.end(); ++item_it) {
+            std::map<FbTk::LayerItem *, FluxboxWindow *>::iterator win_it =
+                windows.find(*item_it);
+            if (win_it != windows.end()) {
+                win_it->second->show();
+                windows.erase(win_it);
+            }
+        }
+    }
+
+    // whatever isn't stacked yet
+    for (it = m_windowlist.begin(); it != it_end && !windows.empty(); ++it) {
+        if (windows.erase(&(*it)->layerItem()))
+            (*it)->show();
+    }
 }
 
 
@@ -193,6 +216,6 @@ void Workspace::shutdown() {
     }
 }
 
-void Workspace::updateClientmenu() {
-    m_clientlist_sig.emit();
+void Workspace::updateClientmenu(FluxboxWindow &win) {
+    m_clientmenu.addWindow(win);
 }
@@ -60,7 +60,8 @@ public:
     /// Add @a win to this workspace, placing it if @a place is true
     void addWindow(FluxboxWindow &win);
     int removeWindow(FluxboxWindow *win, bool still_alive);
-    void updateClientmenu();
+    /// show the clients @a win has now in the client menu
+    void updateClientmenu(FluxboxWindow &win);
 
     BScreen &screen() { return m_screen; }
     const BScreen &screen() const { return m_screen; }
@@ -85,7 +86,6 @@ private:
     BScreen &m_screen;
 
     Windows m_windowlist;
-    FbTk::Signal<> m_clientlist_sig;
     ClientMenu m_clientmenu;
 
     FbTk::FbString m_name;  ///< name of this workspace
@@ -85,6 +85,8 @@ void WindowListCmd::execute() {
                                             it_end = win_list.end();
         // save old value, so we can restore it later
         WinClient *old = WindowCmd<void>::client();
+        // restack and update the lists once, after all windows are done
+        screen->lockUpdates();
         for (; it != it_end; ++it) {
             if (typeid(**it) == typeid(FluxboxWindow))
                 WindowCmd<void>::setWindow((*it)->fbwindow());
@@ -93,6 +95,7 @@ void WindowListCmd::execute() {
             if (!m_filter || m_filter->execute())
                 m_cmd->execute();
         }
+        screen->unlockUpdates();
         WindowCmd<void>::setClient(old);
     }
 }
@@ -113,6 +116,7 @@ REGISTER_COMMAND_PARSER(some, SomeCmd::parse, bool);
 REGISTER_COMMAND_PARSER(every, SomeCmd::parse, bool);
 
 bool SomeCmd::execute() {
+    bool found = false;
     BScreen *screen = Fluxbox::instance()->keyScreen();
     if (screen != 0) {
         FocusControl::Focusables win_list(screen->focusControl().creationOrderList().clientList());
@@ -121,21 +125,21 @@ bool SomeCmd::execute() {
                                            it_end = win_list.end();
         // save old value, so we can restore it later
         WinClient *old = WindowCmd<void>::client();
-        for (; it != it_end; ++it) {
+        screen->lockUpdates();
+        for (; it != it_end && !found; ++it) {
             WinClient *client = dynamic_cast<WinClient *>(*it);
             if (!client) continue;
             WindowCmd<void>::setClient(client);
-            if (m_cmd->execute()) {
-                WindowCmd<void>::setClient(old);
-                return true;
-            }
+            found = m_cmd->execute();
         }
+        screen->unlockUpdates();
         WindowCmd<void>::setClient(old);
     }
-    return false;
+    return found;
 }
 
 bool EveryCmd::execute() {
+    bool all = true;
     BScreen *screen = Fluxbox::instance()->keyScreen();
     if (screen != 0) {
         FocusControl::Focusables win_list(screen->focusControl().creationOrderList().clientList());
@@ -144,18 +148,17 @@ bool EveryCmd::execute() {
                                            it_end = win_list.end();
         // save old value, so we can restore it later
         WinClient *old = WindowCmd<void>::client();
-        for (; it != it_end; ++it) {
+        screen->lockUpdates();
+        for (; it != it_end && all; ++it) {
             WinClient *client = dynamic_cast<WinClient *>(*it);
             if (!client) continue;
             WindowCmd<void>::setClient(client);
-            if (!m_cmd->execute()) {
-                WindowCmd<void>::setClient(old);
-                return false;
-            }
+            all = m_cmd->execute();
         }
+        screen->unlockUpdates();
         WindowCmd<void>::setClient(old);
     }
-    return true;
+    return all;
 }
 
 namespace {
@@ -419,8 +422,8 @@ void ArrangeWindowsCmd::execute() {
         std::swap(cols, rows);
     }
 
-    unsigned int x_offs = screen->maxLeft(head); // window position offset in x
-    unsigned int y_offs = screen->maxTop(head); // window position offset in y
+    int x_offs = screen->maxLeft(head); // window position offset in x
+    int y_offs = screen->maxTop(head); // window position offset in y
    // unsigned int window = 0; // current window
     const unsigned int cal_width = max_width/cols; // calculated width ratio (width of every window)
     unsigned int i;
@@ -430,11 +433,15 @@ void ArrangeWindowsCmd::execute() {
     // TODO: until i resolve the shadedwindow->moveResize() issue to place
     // them in the same columns as the normal windows i just place the shaded
     // windows unchanged ontop of the current head
+    // the whole layout is worked out first and then committed at once
+    FluxboxWindow::Geometries layout;
     for (i = 0, win = shaded_windows.begin(); win != shaded_windows.end(); win++, i++) {
-        if (i & 1)
-            (*win)->move(x_offs, y_offs);
-        else
-            (*win)->move(screen->maxRight(head) - (*win)->frame().width(), y_offs);
+        FluxboxWindow::Geometry geometry = { *win, x_offs, y_offs,
+                                             (*win)->frame().width(),
+                                             (*win)->frame().height() };
+        if (!(i & 1))
+            geometry.x = screen->maxRight(head) - (*win)->frame().width();
+        layout.push_back(geometry);
 
         y_offs += (*win)->frame().height();
     }
@@ -470,17 +477,15 @@ void ArrangeWindowsCmd::execute() {
                 }
             }
 
-            if (normal_windows.size() > 1) {
-                (*closest)->moveResize(x_offs + (*closest)->xOffset(),
-			y_offs + (*closest)->yOffset(),
-			cal_width - (*closest)->widthOffset(),
-			cal_height - (*closest)->heightOffset());
-            } else { // the last window gets everything that is left.
-                (*closest)->moveResize(x_offs + (*closest)->xOffset(),
-			y_offs + (*closest)->yOffset(),
-			screen->maxRight(head) - x_offs - (*closest)->widthOffset(),
-			cal_height - (*closest)->heightOffset());
-            }
+            FluxboxWindow::Geometry geometry = { *closest,
+                x_offs + (*closest)->xOffset(),
+                y_offs + (*closest)->yOffset(),
+                cal_width - (*closest)->widthOffset(),
+                cal_height - (*closest)->heightOffset() };
+            // the last window gets everything that is left.
+            if (normal_windows.size() == 1)
+                geometry.width = screen->maxRight(head) - x_offs - (*closest)->widthOffset();
+            layout.push_back(geometry);
 
             normal_windows.erase(closest);
 
@@ -490,6 +495,8 @@ void ArrangeWindowsCmd::execute() {
         // next y offset
         y_offs += cal_height;
     }
+
+    FluxboxWindow::moveResizeAll(layout);
 }
 
 REGISTER_COMMAND(showdesktop, ShowDesktopCmd, void);
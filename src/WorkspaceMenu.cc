@@ -53,15 +53,17 @@ namespace {
 const unsigned int IDX_AFTER_ICONS = 2;
 const unsigned int NR_STATIC_ITEMS = 6;
 
+FbTk::MenuItem *workspace_item(Workspace &w) {
+    w.menu().setInternalMenu();
+    FbTk::MultiButtonMenuItem* item = new FbTk::MultiButtonMenuItem(5, FbTk::BiDiString(w.name()), &w.menu());
+    FbTk::RefCount<FbTk::Command<void> > jump_cmd(new JumpToWorkspaceCmd(w.workspaceID()));
+    item->setCommand(3, jump_cmd);
+    return item;
+}
+
 void add_workspaces(WorkspaceMenu& menu, BScreen& screen) {
-    for (size_t i = 0; i < screen.numberOfWorkspaces(); ++i) {
-        Workspace* w = screen.getWorkspace(i);
-        w->menu().setInternalMenu();
-        FbTk::MultiButtonMenuItem* submenu = new FbTk::MultiButtonMenuItem(5, FbTk::BiDiString(w->name()), &w->menu());
-        FbTk::RefCount<FbTk::Command<void> > jump_cmd(new JumpToWorkspaceCmd(w->workspaceID()));
-        submenu->setCommand(3, jump_cmd);
-        menu.insert(submenu, i + IDX_AFTER_ICONS);
-    }
+    for (size_t i = 0; i < screen.numberOfWorkspaces(); ++i)
+        menu.insert(workspace_item(*screen.getWorkspace(i)), i + IDX_AFTER_ICONS);
 }
 
 } // end of anonymous namespace
@@ -75,25 +77,49 @@ WorkspaceMenu::WorkspaceMenu(BScreen &screen):
 }
 
 void WorkspaceMenu::workspaceInfoChanged( BScreen& screen ) {
-    while (numberOfItems() > NR_STATIC_ITEMS) {
-        remove(IDX_AFTER_ICONS);
+    // workspaces are only added and removed at the end, so the items of
+    // the others just need their names
+    size_t shown = numberOfItems() - NR_STATIC_ITEMS;
+    size_t count = screen.numberOfWorkspaces();
+    for (size_t i = 0; i < count; ++i) {
+        Workspace &w = *screen.getWorkspace(i);
+        unsigned int index = i + IDX_AFTER_ICONS;
+        FbTk::MenuItem *item = i < shown ? find(index) : 0;
+        if (item && item->submenu() == &w.menu()) {
+            if (item->label().logical() != w.name()) {
+                unsigned int old_width = item->width(theme());
+                item->setLabel(FbTk::BiDiString(w.name()));
+                updateItem(index, old_width);
+            }
+            continue;
+        }
+        // a removed workspace might have been added again meanwhile
+        if (item)
+            remove(index);
+        else
+            ++shown;
+        insert(workspace_item(w), index);
     }
-    ::add_workspaces(*this, screen);
-    updateMenu();
+    for (; shown > count; --shown)
+        remove(count + IDX_AFTER_ICONS);
+
+    setItemSelected(screen.currentWorkspace()->workspaceID() + IDX_AFTER_ICONS, true);
+    updateMenuLater();
 }
 
 void WorkspaceMenu::workspaceChanged(BScreen& screen) {
-    FbTk::MenuItem *item = 0;
+    unsigned int current = screen.currentWorkspace()->workspaceID() + IDX_AFTER_ICONS;
     for (unsigned int i = 0; i < screen.numberOfWorkspaces(); ++i) {
-        item = find(i + IDX_AFTER_ICONS);
-        if (item && item->isSelected()) {
-            setItemSelected(i + IDX_AFTER_ICONS, false);
-            updateMenu();
-            break;
+        unsigned int index = i + IDX_AFTER_ICONS;
+        FbTk::MenuItem *item = find(index);
+        if (item && item->isSelected() && index != current) {
+            setItemSelected(index, false);
+            updateItem(index, item->width(theme()));
         }
     }
-    setItemSelected(screen.currentWorkspace()->workspaceID() + IDX_AFTER_ICONS, true);
-    updateMenu();
+    setItemSelected(current, true);
+    if (find(current))
+        updateItem(current, find(current)->width(theme()));
 }
 
 void WorkspaceMenu::init(BScreen &screen) {
@@ -28,6 +28,7 @@
 
 #include "FbTk/ImageControl.hh"
 #include "FbTk/MemFun.hh"
+#include "FbTk/RequestStats.hh"
 
 #include <algorithm>
 
@@ -71,6 +72,7 @@ void WorkspaceNameTool::moveResize(int x, int y,
 }
 
 void WorkspaceNameTool::update() {
+    FbTk::RequestStats::Widget widget(typeid(*this));
     m_button.setText(m_screen.currentWorkspace()->name());
     if (m_button.width() != width()) {
         resize(width(), height());
@@ -130,9 +132,8 @@ void WorkspaceNameTool::updateSizing() {
 }
 
 void WorkspaceNameTool::reRender() {
-    if (m_pixmap)
-        m_screen.imageControl().removeImage(m_pixmap);
-
+    // the old one stays cached while we look it up again
+    Pixmap old_pm = m_pixmap;
     if (m_theme->texture().usePixmap()) {
         m_pixmap = m_screen.imageControl().renderImage(width(), height(),
                                                        m_theme->texture(), orientation());
@@ -141,9 +142,12 @@ void WorkspaceNameTool::reRender() {
         m_pixmap = 0;
         m_button.setBackgroundColor(m_theme->texture().color());
     }
+    if (old_pm)
+        m_screen.imageControl().removeImage(old_pm);
 }
 
 void WorkspaceNameTool::renderTheme(int alpha) {
+    FbTk::RequestStats::Widget widget(typeid(*this));
     
     m_button.setJustify(m_theme->justify());
     m_button.setBorderWidth(m_theme->border().width());
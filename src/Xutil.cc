@@ -25,10 +25,22 @@
 
 #include "FbTk/I18n.hh"
 #include "FbTk/App.hh"
+#include "FbTk/RoundTrips.hh"
+#include "FbTk/PropertyPrefetch.hh"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#ifdef HAVE_XCB
+#include <X11/Xlib-xcb.h>
+#include <xcb/xcb.h>
+#endif // HAVE_XCB
 
 #include <X11/Xutil.h>
 #include <X11/Xatom.h>
 #include <iostream>
+#include <cstdlib>
 
 #ifdef HAVE_CSTRING
   #include <cstring>
@@ -41,8 +53,32 @@ using std::strlen;
 using std::endl;
 
 
+namespace {
+
+// sizes of WM_HINTS and WM_NORMAL_HINTS, in 32 bit units, from Xatomtype.h
+const unsigned long WM_HINTS_SIZE = 9;
+const unsigned long SIZE_HINTS_SIZE = 18;
+const unsigned long OLD_SIZE_HINTS_SIZE = 15; ///< before ICCCM 1
+
+} // end anonymous namespace
+
 namespace Xutil {
 
+bool getProperty(Window win, Atom property, long length, Atom req_type,
+                 Atom &type, int &format, unsigned long &nitems,
+                 unsigned char *&data) {
+    unsigned long bytes_after = 0;
+    data = 0;
+    if (FbTk::PropertyPrefetch::lookup(win, property, 0, length, false, req_type,
+                                       &type, &format, &nitems, &bytes_after, &data))
+        return true;
+
+    FBTK_ROUNDTRIP("Xutil::getProperty");
+    return XGetWindowProperty(FbTk::App::instance()->display(), win, property,
+                              0, length, False, req_type, &type, &format,
+                              &nitems, &bytes_after, &data) == Success;
+}
+
 FbTk::FbString getWMName(Window window) {
 
     if (window == None)
@@ -57,7 +93,11 @@ FbTk::FbString getWMName(Window window) {
     _FB_USES_NLS;
     FbTk::FbString name;
 
-    if (XGetWMName(display, window, &text_prop)) {
+    // like XGetWMName()
+    if (getProperty(window, XA_WM_NAME, 1000000L, AnyPropertyType,
+                    text_prop.encoding, text_prop.format, text_prop.nitems,
+                    text_prop.value) &&
+        text_prop.encoding != None) {
         if (text_prop.value && text_prop.nitems > 0) {
             if (text_prop.encoding != XA_STRING) {
 
@@ -65,17 +105,16 @@ FbTk::FbString getWMName(Window window) {
                 XmbTextPropertyToTextList(display, &text_prop, &list, &num);
 
                 if (num > 0 && list != 0)
-                    name = FbTk::FbStringUtil::LocaleStrToFb(static_cast<char *>(*list));
+                    FbTk::FbStringUtil::LocaleStrToFb(*list, strlen(*list), name);
                 else
-                    name = text_prop.value ? FbTk::FbStringUtil::XStrToFb((char *)text_prop.value) : "";
+                    FbTk::FbStringUtil::XStrToFb((char *)text_prop.value, text_prop.nitems, name);
 
                 if (list)
                     XFreeStringList(list);
 
             } else
-                name = text_prop.value ? FbTk::FbStringUtil::XStrToFb((char *)text_prop.value) : "";
-
-            XFree(text_prop.value);
+                FbTk::FbStringUtil::XStrToFb((char *)text_prop.value,
+                        strlen((char *)text_prop.value), name);
 
         } else { // default name
             name = _FB_XTEXT(Window, Unnamed, "Unnamed", "Default name for a window without a WM_NAME");
@@ -85,58 +124,200 @@ FbTk::FbString getWMName(Window window) {
         name = _FB_XTEXT(Window, Unnamed, "Unnamed", "Default name for a window without a WM_NAME");
     }
 
+    if (text_prop.value)
+        XFree(text_prop.value);
+
     return name;
 }
 
-
-// The name of this particular instance
-FbTk::FbString getWMClassName(Window win) {
-
-    XClassHint ch;
-    FbTk::FbString instance_name;
-
-    if (XGetClassHint(FbTk::App::instance()->display(), win, &ch) == 0) {
+bool getWMClass(Window win, FbTk::FbString &instance_name,
+                FbTk::FbString &class_name) {
+    Atom type;
+    int format;
+    unsigned long nitems = 0;
+    unsigned char *data = 0;
+
+    instance_name = "";
+    class_name = "";
+    // like XGetClassHint(): two strings, each ends with a null
+    if (!getProperty(win, XA_WM_CLASS, 2048, XA_STRING, type, format, nitems, data) ||
+        type != XA_STRING || format != 8 || data == 0) {
         fbdbg<<"Xutil: Failed to read class hint!"<<endl;
-
-        instance_name = "";
-    } else {
-
-        XFree(ch.res_class);
-
-        if (ch.res_class != 0) {
-            instance_name = const_cast<char *>(ch.res_name);
-            XFree(ch.res_name);
-            ch.res_name = 0;
-        } else
-            instance_name = "";
+        if (data)
+            XFree(data);
+        return false;
     }
 
+    const char *str = reinterpret_cast<const char *>(data);
+    size_t len = strlen(str);
+    instance_name = str;
+    if (len + 1 < nitems)
+        class_name = str + len + 1;
+    XFree(data);
+    return true;
+}
+
+// The name of this particular instance
+FbTk::FbString getWMClassName(Window win) {
+    FbTk::FbString instance_name, class_name;
+    getWMClass(win, instance_name, class_name);
     return instance_name;
 }
 
 // the name of the general class of the app
 FbTk::FbString getWMClassClass(Window win) {
+    FbTk::FbString instance_name, class_name;
+    getWMClass(win, instance_name, class_name);
+    return class_name;
+}
+
+bool getWMHints(Window win, XWMHints &hints) {
+    Atom type;
+    int format;
+    unsigned long nitems = 0;
+    unsigned char *raw = 0;
+
+    // like XGetWMHints(), the window group came with ICCCM 1
+    if (!getProperty(win, XA_WM_HINTS, WM_HINTS_SIZE, XA_WM_HINTS,
+                     type, format, nitems, raw) ||
+        type != XA_WM_HINTS || format != 32 || nitems < WM_HINTS_SIZE - 1) {
+        if (raw)
+            XFree(raw);
+        return false;
+    }
 
-    XClassHint ch;
-    FbTk::FbString class_name;
+    const long *data = reinterpret_cast<long *>(raw);
+
+    hints.flags = data[0];
+    hints.input = data[1] ? True : False;
+    hints.initial_state = data[2];
+    hints.icon_pixmap = data[3];
+    hints.icon_window = data[4];
+    hints.icon_x = data[5];
+    hints.icon_y = data[6];
+    hints.icon_mask = data[7];
+    hints.window_group = nitems >= WM_HINTS_SIZE ? data[8] : 0;
+    XFree(raw);
+    return true;
+}
 
-    if (XGetClassHint(FbTk::App::instance()->display(), win, &ch) == 0) {
-        fbdbg<<"Xutil: Failed to read class hint!"<<endl;
-        class_name = "";
+bool getWMNormalHints(Window win, XSizeHints &hints) {
+    Atom type;
+    int format;
+    unsigned long nitems = 0;
+    unsigned char *raw = 0;
+
+    // like XGetWMNormalHints(), with the fields of ICCCM 1 if they're there
+    if (!getProperty(win, XA_WM_NORMAL_HINTS, SIZE_HINTS_SIZE, XA_WM_SIZE_HINTS,
+                     type, format, nitems, raw) ||
+        type != XA_WM_SIZE_HINTS || format != 32 || nitems < OLD_SIZE_HINTS_SIZE) {
+        if (raw)
+            XFree(raw);
+        return false;
+    }
+
+    const long *data = reinterpret_cast<long *>(raw);
+
+    long supplied = USPosition | USSize | PAllHints;
+    hints.x = data[1];
+    hints.y = data[2];
+    hints.width = data[3];
+    hints.height = data[4];
+    hints.min_width = data[5];
+    hints.min_height = data[6];
+    hints.max_width = data[7];
+    hints.max_height = data[8];
+    hints.width_inc = data[9];
+    hints.height_inc = data[10];
+    hints.min_aspect.x = data[11];
+    hints.min_aspect.y = data[12];
+    hints.max_aspect.x = data[13];
+    hints.max_aspect.y = data[14];
+    if (nitems >= SIZE_HINTS_SIZE) {
+        supplied |= PBaseSize | PWinGravity;
+        hints.base_width = data[15];
+        hints.base_height = data[16];
+        hints.win_gravity = data[17];
     } else {
+        hints.base_width = hints.base_height = 0;
+        hints.win_gravity = 0;
+    }
+    hints.flags = data[0] & supplied;
+    XFree(raw);
+    return true;
+}
 
-        XFree(ch.res_name);
+bool getTransientFor(Window win, Window &transient_for) {
+    Atom type;
+    int format;
+    unsigned long nitems = 0;
+    unsigned char *raw = 0;
+
+    transient_for = None;
+    bool ok = getProperty(win, XA_WM_TRANSIENT_FOR, 1, XA_WINDOW,
+                          type, format, nitems, raw) &&
+        type == XA_WINDOW && format == 32 && nitems != 0;
+    if (ok)
+        transient_for = reinterpret_cast<long *>(raw)[0];
+    if (raw)
+        XFree(raw);
+    return ok;
+}
 
-        if (ch.res_class != 0) {
-            class_name = const_cast<char *>(ch.res_class);
-            XFree(ch.res_class);
-            ch.res_class = 0;
-        } else
-            class_name = "";
+bool getWMProtocols(Window win, Atom wm_protocols, std::vector<Atom> &protocols) {
+    Atom type;
+    int format;
+    unsigned long nitems = 0;
+    unsigned char *raw = 0;
+
+    protocols.clear();
+    bool ok = getProperty(win, wm_protocols, 1000000L, XA_ATOM,
+                          type, format, nitems, raw) &&
+        type == XA_ATOM && format == 32;
+    if (ok) {
+        const long *data = reinterpret_cast<long *>(raw);
+        protocols.assign(data, data + nitems);
     }
+    if (raw)
+        XFree(raw);
+    return ok;
+}
 
-    return class_name;
+void getAttributes(const std::vector<Window> &wins,
+                   std::vector<Attributes> &attribs) {
+    attribs.resize(wins.size());
+
+#ifdef HAVE_XCB
+    // send all requests before waiting for the first reply
+    Display *disp = FbTk::App::instance()->display();
+    xcb_connection_t *conn = XGetXCBConnection(disp);
+    std::vector<xcb_get_window_attributes_cookie_t> cookies(wins.size());
+    for (size_t i = 0; i < wins.size(); ++i)
+        cookies[i] = xcb_get_window_attributes(conn, wins[i]);
+
+    FBTK_ROUNDTRIP("Xutil::getAttributes");
+    for (size_t i = 0; i < wins.size(); ++i) {
+        xcb_get_window_attributes_reply_t *reply =
+            xcb_get_window_attributes_reply(conn, cookies[i], 0);
+        attribs[i].valid = reply != 0;
+        if (reply) {
+            attribs[i].override_redirect = reply->override_redirect;
+            attribs[i].map_state = reply->map_state;
+            free(reply);
+        }
+    }
+#else // !HAVE_XCB
+    for (size_t i = 0; i < wins.size(); ++i) {
+        XWindowAttributes attrib;
+        FBTK_ROUNDTRIP("Xutil::getAttributes");
+        attribs[i].valid = XGetWindowAttributes(FbTk::App::instance()->display(),
+                                                wins[i], &attrib);
+        if (attribs[i].valid) {
+            attribs[i].override_redirect = attrib.override_redirect;
+            attribs[i].map_state = attrib.map_state;
+        }
+    }
+#endif // HAVE_XCB
 }
 
 } // end namespace Xutil
-
@@ -24,15 +24,49 @@
 #define XUTIL_HH
 
 #include <X11/Xlib.h>
+#include <X11/Xutil.h>
 #include "FbTk/FbString.hh"
 
+#include <vector>
+
+/**
+ * The readers of ICCCM properties work like their Xlib counterparts, but
+ * answer from a FbTk::PropertyPrefetch of the window when there is one.
+ */
 namespace Xutil {
 
+/// XGetWindowProperty() from the start, or its prefetched reply
+bool getProperty(Window win, Atom property, long length, Atom req_type,
+                 Atom &type, int &format, unsigned long &nitems,
+                 unsigned char *&data);
+
 FbTk::FbString getWMName(Window window);
 
+/// reads both strings of WM_CLASS at once
+bool getWMClass(Window win, FbTk::FbString &instance_name,
+                FbTk::FbString &class_name);
 FbTk::FbString getWMClassName(Window win);
 FbTk::FbString getWMClassClass(Window win);
 
+/// like XGetWMHints()
+bool getWMHints(Window win, XWMHints &hints);
+/// like XGetWMNormalHints()
+bool getWMNormalHints(Window win, XSizeHints &hints);
+/// like XGetTransientForHint()
+bool getTransientFor(Window win, Window &transient_for);
+/// like XGetWMProtocols()
+bool getWMProtocols(Window win, Atom wm_protocols, std::vector<Atom> &protocols);
+
+/// what adopting a window needs of XGetWindowAttributes()
+struct Attributes {
+    bool valid; ///< false if the window is gone
+    bool override_redirect;
+    int map_state;
+};
+/// the attributes of many windows, with a single round-trip if we can
+void getAttributes(const std::vector<Window> &wins,
+                   std::vector<Attributes> &attribs);
+
 
 } // end namespace Xutil
 
@@ -33,7 +33,13 @@
 #include "Keys.hh"
 #include "FbAtoms.hh"
 #include "FocusControl.hh"
+#include "ClientPattern.hh"
 #include "Layer.hh"
+#include "RemoteServer.hh"
+#include "LeakCheck.hh"
+#include "MenuCache.hh"
+#include "RestartState.hh"
+#include "Compositor.hh"
 
 #include "defaults.hh"
 #include "Debug.hh"
@@ -43,12 +49,21 @@
 #include "FbTk/FileUtil.hh"
 #include "FbTk/ImageControl.hh"
 #include "FbTk/EventManager.hh"
+#include "FbTk/EventStats.hh"
+#include "FbTk/AllocStats.hh"
+#include "FbTk/ObjectPool.hh"
+#include "FbTk/MemoryAccount.hh"
+#include "FbTk/Font.hh"
+#include "FbTk/IdleTask.hh"
+#include "FbTk/AtomCache.hh"
+#include "FbTk/PropertyPrefetch.hh"
 #include "FbTk/StringUtil.hh"
 #include "FbTk/Util.hh"
 #include "FbTk/Resource.hh"
 #include "FbTk/SimpleCommand.hh"
 #include "FbTk/XrmDatabaseHelper.hh"
 #include "FbTk/Command.hh"
+#include "FbTk/CommandParser.hh"
 #include "FbTk/RefCount.hh"
 #include "FbTk/CompareEqual.hh"
 #include "FbTk/Transparent.hh"
@@ -56,6 +71,14 @@
 #include "FbTk/Compose.hh"
 #include "FbTk/KeyUtil.hh"
 #include "FbTk/MemFun.hh"
+#include "FbTk/RoundTrips.hh"
+#include "FbTk/Tracer.hh"
+#include "FbTk/StartupProfile.hh"
+#include "FbTk/Watchdog.hh"
+#include "FbTk/RequestStats.hh"
+#include "FbTk/TextureCache.hh"
+#include "FbTk/StyleCache.hh"
+#include "FbTk/IconCache.hh"
 
 //Use GNU extensions
 #ifndef	 _GNU_SOURCE
@@ -87,9 +110,17 @@
 #ifdef HAVE_RANDR
 #include <X11/extensions/Xrandr.h>
 #endif // HAVE_RANDR
+#ifdef HAVE_XRES
+#include <X11/extensions/XRes.h>
+#endif // HAVE_XRES
 
 // system headers
 
+#ifdef HAVE_CCTYPE
+  #include <cctype>
+#else
+  #include <ctype.h>
+#endif
 #ifdef HAVE_CSTDIO
   #include <cstdio>
 #else
@@ -151,6 +182,12 @@ namespace {
 
 Window last_bad_window = None;
 
+const char *const atom_names[] = {
+    "KWM_DOCKWINDOW", "_KDE_NET_WM_SYSTEM_TRAY_WINDOW_FOR",
+    "_BLACKBOX_PID", "_FLUXBOX_SOCKET"
+};
+AtomCache::Names queued_atoms(atom_names, sizeof(atom_names) / sizeof(atom_names[0]));
+
 // *** NOTE: if you want to debug here the X errors are
 //     coming from, you should turn on the XSynchronise call below
 int handleXErrors(Display *d, XErrorEvent *e) {
@@ -179,6 +216,14 @@ int handleXErrors(Display *d, XErrorEvent *e) {
     return False;
 }
 
+/// the client a stalled handler was busy with, for the watchdog
+std::string describeWindow(unsigned long window) {
+    WinClient *client = Fluxbox::instance()->searchWindow(window);
+    if (client == 0)
+        return std::string();
+    return client->getWMClassClass() + " \"" + client->title().logical() + "\"";
+}
+
 
 
 /* functor to call a memberfunction with by a reference argument
@@ -218,6 +263,13 @@ struct CallMemFunWithRefArg : std::unary_function<Type, ResultType> {
 };
 
 
+struct LongestGrabFirst {
+    template <typename It>
+    bool operator()(const It &a, const It &b) const {
+        return a->second.max() > b->second.max();
+    }
+};
+
 } // end anonymous
 
 //static singleton var
@@ -236,6 +288,9 @@ Fluxbox::Fluxbox(int argc, char **argv,
       m_RC_INIT_FILE("init"),
       m_rc_ignoreborder(m_resourcemanager, false, "session.ignoreBorder", "Session.IgnoreBorder"),
       m_rc_pseudotrans(m_resourcemanager, false, "session.forcePseudoTransparency", "Session.forcePseudoTransparency"),
+      m_rc_coalesce_events(m_resourcemanager, false, "session.coalesceEvents", "Session.CoalesceEvents"),
+      m_rc_collect_stats(m_resourcemanager, false, "session.collectStats", "Session.CollectStats"),
+      m_rc_audit_round_trips(m_resourcemanager, false, "session.auditRoundTrips", "Session.AuditRoundTrips"),
       m_rc_colors_per_channel(m_resourcemanager, 4,
                               "session.colorsPerChannel", "Session.ColorsPerChannel"),
       m_rc_double_click_interval(m_resourcemanager, 250, "session.doubleClickInterval", "Session.DoubleClickInterval"),
@@ -249,6 +304,12 @@ Fluxbox::Fluxbox(int argc, char **argv,
       m_rc_tabs_attach_area(m_resourcemanager, ATTACH_AREA_WINDOW, "session.tabsAttachArea", "Session.TabsAttachArea"),
       m_rc_cache_life(m_resourcemanager, 5, "session.cacheLife", "Session.CacheLife"),
       m_rc_cache_max(m_resourcemanager, 200, "session.cacheMax", "Session.CacheMax"),
+      m_rc_pixmap_budget(m_resourcemanager, 0, "session.pixmapBudget", "Session.PixmapBudget"),
+      m_rc_texture_cache_size(m_resourcemanager, 4096, "session.textureCacheSize", "Session.TextureCacheSize"),
+      m_rc_icon_cache_size(m_resourcemanager, 1024, "session.iconCacheSize", "Session.IconCacheSize"),
+      m_rc_leak_check_interval(m_resourcemanager, 0, "session.leakCheckInterval", "Session.LeakCheckInterval"),
+      m_rc_watchdog_deadline(m_resourcemanager, 0, "session.watchdogDeadline", "Session.WatchdogDeadline"),
+      m_rc_pipe_menu_ttl(m_resourcemanager, 60, "session.pipeMenuTTL", "Session.PipeMenuTTL"),
       m_rc_auto_raise_delay(m_resourcemanager, 250, "session.autoRaiseDelay", "Session.AutoRaiseDelay"),
       m_masked_window(0),
       m_mousescreen(0),
@@ -257,11 +318,15 @@ Fluxbox::Fluxbox(int argc, char **argv,
       m_masked(0),
       m_rc_file(rc_filename),
       m_argv(argv), m_argc(argc),
+      m_coalescer(display()),
       m_showing_dialog(false),
+      m_restart_state(0),
       m_starting(true),
       m_restarting(false),
       m_shutdown(false),
       m_server_grabs(0),
+      m_grab_site(0),
+      m_grab_start(0),
       m_randr_event_type(0) {
 
     _FB_USES_NLS;
@@ -277,11 +342,9 @@ Fluxbox::Fluxbox(int argc, char **argv,
     Display *disp = FbTk::App::instance()->display();
     // For KDE dock applets
     // KDE v1.x
-    m_kwm1_dockwindow = XInternAtom(disp,
-                                    "KWM_DOCKWINDOW", False);
+    m_kwm1_dockwindow = FbTk::AtomCache::instance().get("KWM_DOCKWINDOW");
     // KDE v2.x
-    m_kwm2_dockwindow = XInternAtom(disp,
-                                    "_KDE_NET_WM_SYSTEM_TRAY_WINDOW_FOR", False);
+    m_kwm2_dockwindow = FbTk::AtomCache::instance().get("_KDE_NET_WM_SYSTEM_TRAY_WINDOW_FOR");
     // setup X error handler
     XSetErrorHandler((XErrorHandler) handleXErrors);
 
@@ -310,6 +373,11 @@ Fluxbox::Fluxbox(int argc, char **argv,
     m_reconfig_timer.setCommand(reconfig_cmd);
     m_reconfig_timer.fireOnce(true);
 
+    FbTk::RefCount<FbTk::Command<void> > save_rc_cmd(new FbTk::SimpleCommand<Fluxbox>(*this, &Fluxbox::writeRc));
+    m_save_rc_timer.setTimeout(1, 0);
+    m_save_rc_timer.setCommand(save_rc_cmd);
+    m_save_rc_timer.fireOnce(true);
+
     if (xsync)
         XSynchronize(disp, True);
 
@@ -329,7 +397,8 @@ Fluxbox::Fluxbox(int argc, char **argv,
 
     load_rc();
 
-    grab();
+    // until the screens redirect the maps of new windows to us
+    grab("Fluxbox::Fluxbox");
 
     if (! XSupportsLocale())
         cerr<<_FB_CONSOLETEXT(Fluxbox, WarningLocale, 
@@ -343,17 +412,34 @@ Fluxbox::Fluxbox(int argc, char **argv,
 
 
 #ifdef HAVE_GETPID
-    m_fluxbox_pid = XInternAtom(disp, "_BLACKBOX_PID", False);
+    m_fluxbox_pid = FbTk::AtomCache::instance().get("_BLACKBOX_PID");
 #endif // HAVE_GETPID
 
 
+    // gradients rendered by the last run
+    FbTk::TextureCache::instance().open(getDefaultDataFilename("cache/textures"),
+                                        *m_rc_texture_cache_size * 1024);
+    FbTk::IconCache::instance().setMaxBytes(*m_rc_icon_cache_size * 1024);
+    // tokens of the menu files read by the last run
+    MenuCache::setFile(getDefaultDataFilename("cache/menus"));
+    // each screen builds its menus from them, they are ready by then
+    vector<string> menu_files;
+    menu_files.push_back(FbTk::StringUtil::expandFilename(getMenuFilename()));
+    menu_files.push_back(getDefaultDataFilename("windowmenu"));
+    MenuCache::preload(menu_files);
+    // values of the styles used before
+    FbTk::StyleCache::instance().open(getDefaultDataFilename("cache/styles"));
+
     // setup theme manager to have our style file ready to be scanned
     FbTk::ThemeManager::instance().load(getStyleFilename(), getStyleOverlayFilename());
 
     // Create keybindings handler and load keys file
     // Note: this needs to be done before creating screens
-    m_key.reset(new Keys);
-    m_key->reconfigure();
+    {
+        FbTk::StartupProfile::Phase phase("keys");
+        m_key.reset(new Keys);
+        m_key->reconfigure();
+    }
 
     vector<int> screens;
     int i;
@@ -396,6 +482,7 @@ Fluxbox::Fluxbox(int argc, char **argv,
     // create screens
     for (size_t s = 0; s < screens.size(); s++) {
         std::string sc_nr = FbTk::StringUtil::number2String(screens[s]);
+        FbTk::StartupProfile::Phase phase("screen", screens[s]);
         BScreen *screen = new BScreen(m_screen_rm.lock(),
                                       std::string("session.screen") + sc_nr,
                                       std::string("session.Screen") + sc_nr,
@@ -419,9 +506,15 @@ Fluxbox::Fluxbox(int argc, char **argv,
 
     m_keyscreen = m_mousescreen = m_screen_list.front();
 
+    // windows that appear while we adopt the others come as MapRequest
+    ungrab();
+
 #ifdef USE_NEWWMSPEC
     addAtomHandler(new Ewmh()); // for Extended window manager atom support
 #endif // USE_NEWWMSPEC
+    // what the last run handed over, if it restarted into us
+    m_restart_state = new RestartState(getDefaultDataFilename("cache/restart"));
+    addAtomHandler(m_restart_state);
     // parse apps file after creating screens (so we can tell if it's a restart
     // for [startup] items) but before creating windows
     // this needs to be after ewmh and gnome, so state atoms don't get
@@ -433,6 +526,9 @@ Fluxbox::Fluxbox(int argc, char **argv,
     // init all "screens"
     STLUtil::forAll(m_screen_list, bind1st(mem_fun(&Fluxbox::initScreen), this));
 
+    updateRemoteServer();
+    updateLeakCheck();
+
     XAllowEvents(disp, ReplayPointer, CurrentTime);
 
     //XSynchronize(disp, False);
@@ -441,7 +537,6 @@ Fluxbox::Fluxbox(int argc, char **argv,
     m_reconfigure_wait = false;
 
     m_resourcemanager.unlock();
-    ungrab();
 
     if (m_resourcemanager.lockDepth() != 0) {
         fbdbg<<"--- resource manager lockdepth = "<<m_resourcemanager.lockDepth()<<endl;
@@ -462,9 +557,19 @@ Fluxbox::~Fluxbox() {
     // this needs to be destroyed before screens; otherwise, menus stored in
     // key commands cause a segfault when the LayerItem is destroyed
     m_key.reset(0);
+    // same for the commands cached for remote actions
+    m_remote_server.reset(0);
+    FbTk::CommandParser<void>::instance().clearCache();
+    // it names our client with a window of the first screen
+    m_leak_check.reset(0);
 
     leaveAll(); // leave all connections
 
+#ifdef DEBUG
+    if (*m_rc_coalesce_events || *m_rc_collect_stats)
+        dumpStats(cerr);
+#endif // DEBUG
+
     // destroy screens (after others, as they may do screen things)
     FbTk::STLUtil::destroyAndClear(m_screen_list);
 
@@ -473,6 +578,7 @@ Fluxbox::~Fluxbox() {
 
 
 void Fluxbox::initScreen(BScreen *screen) {
+    FbTk::StartupProfile::Phase phase("init screen", screen->screenNumber());
 
     // now we can create menus (which needs this screen to be in screen_list)
     screen->initMenus();
@@ -508,10 +614,30 @@ void Fluxbox::initScreen(BScreen *screen) {
 
 void Fluxbox::eventLoop() {
     Display *disp = display();
+    FbTk::EventStats &stats = FbTk::EventStats::instance();
+    FbTk::MemoryAccount &account = FbTk::MemoryAccount::instance();
+    account.setBudget(*m_rc_pixmap_budget * 1024ul);
+    FbTk::Watchdog &watchdog = FbTk::Watchdog::instance();
+    watchdog.setDescribe(describeWindow);
+    watchdog.setDeadline(*m_rc_watchdog_deadline);
     while (!m_shutdown) {
-        if (XPending(disp)) {
+        int pending;
+        {
+            // flushes what we sent, then reads what came
+            FbTk::Tracer::Span span("x", "XPending");
+            pending = XPending(disp);
+        }
+        // startup ends when the queue and the deferred redraws are done
+        if (!pending && !FbTk::IdleTask::pending() &&
+            FbTk::StartupProfile::instance().enabled())
+            FbTk::StartupProfile::instance().finish(cerr);
+        if (pending) {
+            if (*m_rc_coalesce_events)
+                m_coalescer.coalesce();
+
             XEvent e;
             XNextEvent(disp, &e);
+            m_coalescer.eventTaken();
 
             if (last_bad_window != None && e.xany.window == last_bad_window &&
                 e.type != DestroyNotify) { // we must let the actual destroys through
@@ -521,14 +647,278 @@ void Fluxbox::eventLoop() {
                     fbdbg<<"Fluxbox::eventLoop(): removing bad window from event queue"<<endl;
             } else {
                 last_bad_window = None;
-                handleEvent(&e);
+                // session.collectStats might have been changed by SetResourceValue
+                stats.setEnabled(*m_rc_collect_stats);
+                FbTk::RequestStats::instance().setEnabled(*m_rc_collect_stats);
+                ClientPattern::setCollectStats(*m_rc_collect_stats);
+                FbTk::RoundTrips::instance().setAudit(*m_rc_audit_round_trips);
+                account.setBudget(*m_rc_pixmap_budget * 1024ul);
+                watchdog.setDeadline(*m_rc_watchdog_deadline);
+                const char *event_name = FbTk::EventStats::eventName(e.type);
+                FbTk::Watchdog::Guard guard(event_name ? event_name : "extension event",
+                                            e.xany.window);
+                if (stats.enabled()) {
+                    unsigned long allocations = FbTk::AllocStats::count();
+                    uint64_t start = FbTk::FbTime::mono();
+                    handleEvent(&e);
+                    uint64_t usec = FbTk::FbTime::mono() - start;
+                    stats.addEvent(e.type, usec,
+                                   FbTk::AllocStats::count() - allocations);
+                } else
+                    handleEvent(&e);
             }
+        } else if (FbTk::IdleTask::pending()) {
+            // the queue is empty, do deferred redraws before sleeping
+            FbTk::IdleTask::runAll();
+        } else if (account.underPressure()) {
+            // after the redraws, which may have released pixmaps
+            account.relieve();
         } else {
             FbTk::Timer::updateTimers(ConnectionNumber(disp)); //handle all timers
         }
     }
 }
 
+void Fluxbox::dumpStats(std::ostream &os) const {
+    FbTk::EventStats::instance().dump(os);
+
+    const FbTk::EventCoalescer::Stats &coalesced = m_coalescer.stats();
+    os<<endl<<"coalesced events: "<<coalesced.dispatched
+      <<", folded: "<<coalesced.folded()
+      <<" (motion: "<<coalesced.motion
+      <<", expose: "<<coalesced.expose
+      <<", configure: "<<coalesced.configure
+      <<", property: "<<coalesced.property<<")"<<endl;
+
+    os<<endl<<"X requests: "<<NextRequest(display()) - 1<<endl;
+    FbTk::RoundTrips::instance().dump(os);
+
+    os<<endl;
+    FbTk::RequestStats::instance().dump(os);
+
+    // the longest grabs first, they froze all other clients
+    std::vector<GrabStats::const_iterator> grabs;
+    for (GrabStats::const_iterator it = m_grab_stats.begin(); it != m_grab_stats.end(); ++it)
+        grabs.push_back(it);
+    std::sort(grabs.begin(), grabs.end(), LongestGrabFirst());
+    os<<endl<<"server grabs:"<<endl;
+    for (size_t i = 0; i < grabs.size(); ++i) {
+        const FbTk::LatencyHistogram &grab = grabs[i]->second;
+        os<<"  "<<grabs[i]->first<<": "<<grab.count()<<" grabs, "
+          <<double(grab.total()) / grab.count() / FbTk::FbTime::IN_MILLISECONDS
+          <<" ms average, "<<double(grab.max()) / FbTk::FbTime::IN_MILLISECONDS
+          <<" ms longest"<<endl;
+    }
+
+    os<<endl;
+    ScreenList::const_iterator it = m_screen_list.begin();
+    for (; it != m_screen_list.end(); ++it) {
+        FbTk::ImageControl &images = (*it)->imageControl();
+        os<<"screen "<<(*it)->screenNumber()<<" pixmap cache: "
+          <<images.cacheEntries()<<" pixmaps, "
+          <<images.cacheBytes() / 1024<<" KB, uploaded: "
+          <<images.shmBytes() / 1024<<" KB through shared memory, "
+          <<images.socketBytes() / 1024<<" KB through the socket"<<endl;
+
+        const FbTk::ImageControl::Stats &istats = images.stats();
+        os<<"screen "<<(*it)->screenNumber()<<" pixmap cache: "
+          <<istats.hits + istats.misses<<" lookups, "
+          <<istats.hits<<" hits, "<<istats.misses<<" misses, "
+          <<istats.evictions<<" evicted over cacheMax, "
+          <<istats.expired<<" expired after cacheLife"<<endl;
+        os<<"screen "<<(*it)->screenNumber()<<" textures rendered: "
+          <<istats.rendered_bytes / 1024<<" KB";
+        for (int k = 0; k < FbTk::ImageControl::NUM_RENDER_KINDS; ++k) {
+            FbTk::ImageControl::RenderKind kind = FbTk::ImageControl::RenderKind(k);
+            os<<", "<<istats.renders[k]<<" "<<FbTk::ImageControl::renderKindName(kind);
+            if (istats.renders[k] > 0)
+                os<<" ("<<double(istats.render_usec[k]) / istats.renders[k] / FbTk::FbTime::IN_MILLISECONDS
+                  <<" ms average)";
+        }
+        os<<endl;
+
+        const BScreen::SwitchStats &switches = (*it)->switchStats();
+        os<<"screen "<<(*it)->screenNumber()<<" workspace switches: "
+          <<switches.switches;
+        if (switches.switches > 0)
+            os<<", "<<double(switches.total) / switches.switches / FbTk::FbTime::IN_MILLISECONDS
+              <<" ms average, "<<double(switches.max) / FbTk::FbTime::IN_MILLISECONDS
+              <<" ms slowest";
+        os<<endl;
+    }
+
+    const FbTk::TextureCache &textures = FbTk::TextureCache::instance();
+    os<<"texture cache: "<<textures.hits()<<" hits, "
+      <<textures.misses()<<" misses, "
+      <<textures.bytes() / 1024<<" KB in use"<<endl;
+
+    const FbTk::IconCache &icons = FbTk::IconCache::instance();
+    os<<"icon cache: "<<icons.hits()<<" hits, "
+      <<icons.misses()<<" misses, "<<icons.entries()<<" icons, "
+      <<icons.bytes() / 1024<<" KB"<<endl;
+
+    const FbTk::Menu::Stats &menus = FbTk::Menu::stats();
+    const FbTk::Menu::Stats::Timing *timings[] = {
+        &menus.show, &menus.update, &menus.render, &menus.expose
+    };
+    const char *timing_names[] = {
+        "show", "updateMenu", "renderForeground", "show to first expose"
+    };
+    for (size_t i = 0; i < sizeof(timings) / sizeof(timings[0]); ++i) {
+        os<<"menus "<<timing_names[i]<<": "<<timings[i]->count;
+        if (timings[i]->count > 0)
+            os<<", "<<double(timings[i]->total) / timings[i]->count / FbTk::FbTime::IN_MILLISECONDS
+              <<" ms average, "<<double(timings[i]->max) / FbTk::FbTime::IN_MILLISECONDS
+              <<" ms slowest";
+        os<<endl;
+    }
+
+    const FbWinFrame::Stats &frames = FbWinFrame::stats();
+    os<<"frame decorations: "<<frames.renders<<" renders, "
+      <<frames.applies<<" applies, "<<frames.frames<<" frames";
+    double seconds = double(FbTk::FbTime::mono() - frames.since) / FbTk::FbTime::IN_SECONDS;
+    if (frames.frames > 0 && frames.since != 0 && seconds > 0)
+        os<<" ("<<frames.renders / frames.frames / seconds<<" renders and "
+          <<frames.applies / frames.frames / seconds<<" applies per frame per second)";
+    os<<endl;
+
+    os<<endl;
+    ClientPattern::dumpStats(os, 20);
+
+    os<<endl;
+    FbTk::ObjectPool::dump(os);
+}
+
+void Fluxbox::writeStatsJson(std::ostream &os) const {
+    os<<"{\"collecting\":"<<(*m_rc_collect_stats ? "true" : "false")
+      <<",\"events\":";
+    FbTk::EventStats::instance().writeJson(os);
+
+    os<<",\"timers_armed\":"<<FbTk::Timer::armed()
+      <<",\"font_cache_entries\":"<<FbTk::Font::cacheEntries()
+      <<",\"pixmaps\":"<<FbTk::MemoryAccount::instance().total().pixmaps
+      <<",\"pixmap_bytes\":"<<FbTk::MemoryAccount::instance().total().bytes
+      <<",\"x_requests\":"<<NextRequest(display()) - 1
+      <<",\"x_roundtrips\":"<<FbTk::RoundTrips::instance().total()
+      <<",\"widget_requests\":";
+    FbTk::RequestStats::instance().writeJson(os);
+
+    unsigned long grabs = 0;
+    uint64_t grab_usec = 0, grab_max = 0;
+    GrabStats::const_iterator git = m_grab_stats.begin();
+    for (; git != m_grab_stats.end(); ++git) {
+        grabs += git->second.count();
+        grab_usec += git->second.total();
+        grab_max = std::max(grab_max, git->second.max());
+    }
+    os<<",\"server_grabs\":{\"count\":"<<grabs
+      <<",\"total_us\":"<<grab_usec
+      <<",\"max_us\":"<<grab_max<<'}';
+
+    os<<",\"screens\":[";
+    ScreenList::const_iterator it = m_screen_list.begin();
+    for (; it != m_screen_list.end(); ++it) {
+        if (it != m_screen_list.begin())
+            os<<',';
+        const FbTk::ImageControl &images = (*it)->imageControl();
+        const FbTk::ImageControl::Stats &istats = images.stats();
+        os<<"{\"screen\":"<<(*it)->screenNumber()
+          <<",\"windows\":"<<(*it)->focusControl().creationOrderList().clientList().size()
+          <<",\"image_cache\":{\"entries\":"<<images.cacheEntries()
+          <<",\"bytes\":"<<images.cacheBytes()
+          <<",\"hits\":"<<istats.hits
+          <<",\"misses\":"<<istats.misses
+          <<",\"evictions\":"<<istats.evictions
+          <<",\"expired\":"<<istats.expired
+          <<",\"rendered_bytes\":"<<istats.rendered_bytes
+          <<",\"renders\":{";
+        for (int k = 0; k < FbTk::ImageControl::NUM_RENDER_KINDS; ++k) {
+            FbTk::ImageControl::RenderKind kind = FbTk::ImageControl::RenderKind(k);
+            os<<(k ? "," : "")<<'"'<<FbTk::ImageControl::renderKindName(kind)
+              <<"\":{\"count\":"<<istats.renders[k]
+              <<",\"total_us\":"<<istats.render_usec[k]<<'}';
+        }
+        os<<"}}}";
+    }
+    os<<"],\"patterns\":";
+    ClientPattern::writeStatsJson(os);
+    os<<'}';
+}
+
+void Fluxbox::dumpMemory(std::ostream &os) const {
+    using FbTk::MemoryAccount;
+    const MemoryAccount &account = MemoryAccount::instance();
+
+    os<<"pixmaps by subsystem:"<<endl;
+    for (int i = 0; i < MemoryAccount::NUM_SUBSYSTEMS; ++i) {
+        MemoryAccount::Subsystem subsystem = MemoryAccount::Subsystem(i);
+        const MemoryAccount::Usage &usage = account.usage(subsystem);
+        os<<"  "<<MemoryAccount::name(subsystem)<<": "<<usage.pixmaps
+          <<" pixmaps, "<<usage.bytes / 1024<<" KB"<<endl;
+    }
+    const MemoryAccount::Usage total = account.total();
+    os<<"  total: "<<total.pixmaps<<" pixmaps, "<<total.bytes / 1024<<" KB"<<endl;
+    if (account.budget())
+        os<<"  budget: "<<account.budget() / 1024<<" KB"<<endl;
+
+#ifdef HAVE_XRES
+    int event_base, error_base;
+    if (!m_screen_list.empty() &&
+        XResQueryExtension(display(), &event_base, &error_base)) {
+        // the server finds our client by any resource we created
+        unsigned long bytes = 0;
+        if (XResQueryClientPixmapBytes(display(),
+                                       m_screen_list.front()->dummyWindow().window(),
+                                       &bytes))
+            os<<"  X server says: "<<bytes / 1024<<" KB"<<endl;
+    }
+#endif // HAVE_XRES
+
+    os<<endl<<"caches:"<<endl;
+    ScreenList::const_iterator it = m_screen_list.begin();
+    for (; it != m_screen_list.end(); ++it) {
+        const FbTk::ImageControl &images = (*it)->imageControl();
+        os<<"  screen "<<(*it)->screenNumber()<<" pixmaps: "
+          <<images.cacheEntries()<<" pixmaps, "
+          <<images.cacheBytes() / 1024<<" KB"<<endl;
+    }
+    os<<"  textures: "<<FbTk::TextureCache::instance().bytes() / 1024<<" KB"<<endl;
+    const FbTk::IconCache &icons = FbTk::IconCache::instance();
+    os<<"  icons: "<<icons.entries()<<" icons, "<<icons.bytes() / 1024<<" KB"<<endl;
+    os<<"  fonts: "<<FbTk::Font::cacheEntries()<<" fonts"<<endl;
+
+    // pixmaps of the image cache that windows share are counted for the
+    // window that rendered them first
+    os<<endl<<"pixmaps by window:"<<endl;
+    for (it = m_screen_list.begin(); it != m_screen_list.end(); ++it) {
+        const FocusableList::Focusables &wins =
+            (*it)->focusControl().creationOrderWinList().clientList();
+        FocusableList::Focusables::const_iterator win_it = wins.begin();
+        for (; win_it != wins.end(); ++win_it) {
+            const FluxboxWindow *win = (*win_it)->fbwindow();
+            if (win == 0)
+                continue;
+            MemoryAccount::Usage usage = account.usage(&win->frame());
+            MemoryAccount::Usage owned = account.usage(*win_it);
+            usage.pixmaps += owned.pixmaps;
+            usage.bytes += owned.bytes;
+            FluxboxWindow::ClientList::const_iterator client = win->clientList().begin();
+            for (; client != win->clientList().end(); ++client) {
+                if (*client == *win_it)
+                    continue;
+                owned = account.usage(*client);
+                usage.pixmaps += owned.pixmaps;
+                usage.bytes += owned.bytes;
+            }
+            os<<"  "<<win->title().logical()<<": "<<usage.pixmaps
+              <<" pixmaps, "<<usage.bytes / 1024<<" KB"<<endl;
+        }
+    }
+
+    os<<endl;
+    FbTk::ObjectPool::dump(os);
+}
+
 bool Fluxbox::validateWindow(Window window) const {
     XEvent event;
     if (XCheckTypedWindowEvent(display(), window, DestroyNotify, &event)) {
@@ -539,14 +929,22 @@ bool Fluxbox::validateWindow(Window window) const {
     return true;
 }
 
-void Fluxbox::grab() {
-    if (! m_server_grabs++)
-       XGrabServer(display());
+void Fluxbox::grab(const char *site) {
+    if (! m_server_grabs++) {
+        XGrabServer(display());
+        m_grab_site = site;
+        m_grab_start = FbTk::FbTime::mono();
+    }
 }
 
 void Fluxbox::ungrab() {
-    if (! --m_server_grabs)
+    if (! --m_server_grabs) {
         XUngrabServer(display());
+        // every other client waits until the server sees this
+        FbTk::Tracer::Span span("x", "XFlush");
+        XFlush(display());
+        m_grab_stats[m_grab_site].add(FbTk::FbTime::mono() - m_grab_start);
+    }
 
     if (m_server_grabs < 0)
         m_server_grabs = 0;
@@ -554,6 +952,9 @@ void Fluxbox::ungrab() {
 
 void Fluxbox::handleEvent(XEvent * const e) {
     _FB_USES_NLS;
+    const char *event_name = FbTk::EventStats::eventName(e->type);
+    FbTk::Tracer::Span span("event", event_name ? event_name : "extension",
+                            "window", e->xany.window);
     m_last_event = *e;
 
     // it is possible (e.g. during moving) for a window
@@ -588,6 +989,8 @@ void Fluxbox::handleEvent(XEvent * const e) {
         m_mousescreen = searchScreen(e->xcrossing.root);
     } else if (e->type == PropertyNotify) {
         m_last_time = e->xproperty.time;
+        // before anyone reads it again from a WinClient's cache
+        FbTk::PropertyPrefetch::forget(e->xproperty.window, e->xproperty.atom);
         // check transparency atoms if it's a root pm
 
         BScreen *screen = searchScreen(e->xproperty.window);
@@ -596,6 +999,13 @@ void Fluxbox::handleEvent(XEvent * const e) {
         }
     }
 
+    // the compositors follow all windows, including those we don't manage
+    for (ScreenList::iterator it = m_screen_list.begin();
+         it != m_screen_list.end(); ++it) {
+        if ((*it)->compositor())
+            (*it)->compositor()->handleEvent(*e);
+    }
+
     // try FbTk::EventHandler first
     FbTk::EventManager::instance()->handleEvent(*e);
 
@@ -607,8 +1017,7 @@ void Fluxbox::handleEvent(XEvent * const e) {
 
         if (!searchWindow(e->xconfigurerequest.window)) {
 
-            grab();
-
+            // a window that is gone meanwhile only causes an ignored error
             if (validateWindow(e->xconfigurerequest.window)) {
                 XWindowChanges xwc;
 
@@ -624,8 +1033,6 @@ void Fluxbox::handleEvent(XEvent * const e) {
                                  e->xconfigurerequest.window,
                                  e->xconfigurerequest.value_mask, &xwc);
             }
-
-            ungrab();
         } // else already handled in FluxboxWindow::handleEvent
 
     }
@@ -641,6 +1048,7 @@ void Fluxbox::handleEvent(XEvent * const e) {
             int screen_num;
             XWindowAttributes attr;
             // find screen
+            FBTK_ROUNDTRIP("Fluxbox::handleEvent");
             if (XGetWindowAttributes(display(),
                                      e->xmaprequest.window,
                                      &attr) && attr.screen != 0) {
@@ -792,14 +1200,34 @@ void Fluxbox::handleEvent(XEvent * const e) {
     default: {
 
 #ifdef HAVE_RANDR
-        if (e->type == m_randr_event_type) {
+        bool randr_event = e->type == m_randr_event_type;
+#ifdef HAVE_RANDR1_2
+        randr_event = randr_event || e->type == m_randr_event_type + RRNotify;
+#endif // HAVE_RANDR1_2
+        if (randr_event) {
+            Display *disp = FbTk::App::instance()->display();
 #ifdef HAVE_RANDR1_2
             XRRUpdateConfiguration(e);
-#endif
+            // an output change comes with a few of these, one update
+            // looks at all of them
+            XEvent next;
+            while (XCheckTypedWindowEvent(disp, e->xany.window,
+                                          m_randr_event_type, &next) ||
+                   XCheckTypedWindowEvent(disp, e->xany.window,
+                                          m_randr_event_type + RRNotify, &next))
+                XRRUpdateConfiguration(&next);
+#else
+            XEvent next;
+            while (XCheckTypedWindowEvent(disp, e->xany.window,
+                                          m_randr_event_type, &next))
+                ;
+#endif // HAVE_RANDR1_2
             // update root window size in screen
             BScreen *scr = searchScreen(e->xany.window);
-            if (scr != 0)
+            if (scr != 0) {
+                scr->rootWindow().invalidateGeometry();
                 scr->updateSize();
+            }
         }
 #endif // HAVE_RANDR
 
@@ -1058,52 +1486,86 @@ void Fluxbox::removeAtomHandler(AtomHandler *atomh) {
 }
 
 WinClient *Fluxbox::searchWindow(Window window) {
-    WinClientMap::iterator it = m_window_search.find(window);
-    if (it != m_window_search.end())
-        return it->second;
+    const SearchEntry *entry = m_window_search.find(window);
+    if (entry == 0)
+        return 0;
+    if (entry->client)
+        return entry->client;
+    return entry->fbwindow ? &entry->fbwindow->winClient() : 0;
+}
 
-    WindowMap::iterator git = m_window_search_group.find(window);
-    return git == m_window_search_group.end() ? 0 : &git->second->winClient();
+WinClient *Fluxbox::searchGroup(Window window) {
+    const SearchEntry *entry = m_window_search.find(window);
+    return entry == 0 || entry->group.empty() ? 0 : entry->group.front();
 }
 
+Fluxbox::SearchEntry &Fluxbox::searchEntry(Window window) {
+    SearchEntry *entry = m_window_search.find(window);
+    if (entry == 0) {
+        m_window_search.insert(window, SearchEntry());
+        entry = m_window_search.find(window);
+    }
+    return *entry;
+}
 
-/* Not implemented until we know how it'll be used
- * Recall that this refers to ICCCM groups, not fluxbox tabgroups
- * See ICCCM 4.1.11 for details
- */
-/*
-WinClient *Fluxbox::searchGroup(Window window) {
+void Fluxbox::cleanSearchEntry(Window window) {
+    const SearchEntry *entry = m_window_search.find(window);
+    if (entry && entry->empty())
+        m_window_search.erase(window);
 }
-*/
 
 void Fluxbox::saveWindowSearch(Window window, WinClient *data) {
-    m_window_search[window] = data;
+    if (window == None)
+        return;
+    SearchEntry &entry = searchEntry(window);
+    if (entry.client != data)
+        m_clients.erase(entry.client);
+    entry.client = data;
+    m_clients.insert(data);
 }
 
 /* some windows relate to the whole group */
 void Fluxbox::saveWindowSearchGroup(Window window, FluxboxWindow *data) {
-    m_window_search_group[window] = data;
+    if (window != None)
+        searchEntry(window).fbwindow = data;
 }
 
 void Fluxbox::saveGroupSearch(Window window, WinClient *data) {
-    m_group_search.insert(pair<const Window, WinClient *>(window, data));
+    if (window != None)
+        searchEntry(window).group.push_back(data);
 }
 
 
 void Fluxbox::removeWindowSearch(Window window) {
-    m_window_search.erase(window);
+    SearchEntry *entry = m_window_search.find(window);
+    if (entry == 0)
+        return;
+    m_clients.erase(entry->client);
+    entry->client = 0;
+    cleanSearchEntry(window);
 }
 
 void Fluxbox::removeWindowSearchGroup(Window window) {
-    m_window_search_group.erase(window);
+    SearchEntry *entry = m_window_search.find(window);
+    if (entry == 0)
+        return;
+    entry->fbwindow = 0;
+    cleanSearchEntry(window);
 }
 
-void Fluxbox::removeGroupSearch(Window window) {
-    m_group_search.erase(window);
+void Fluxbox::removeGroupSearch(Window window, WinClient *data) {
+    SearchEntry *entry = m_window_search.find(window);
+    if (entry == 0)
+        return;
+    std::vector<WinClient *> &group = entry->group;
+    group.erase(std::remove(group.begin(), group.end(), data), group.end());
+    cleanSearchEntry(window);
 }
 
 /// restarts fluxbox
 void Fluxbox::restart(const char *prog) {
+    if (m_restart_state && !m_shutdown)
+        m_restart_state->save(m_screen_list);
     shutdown();
 
     m_restarting = true;
@@ -1124,11 +1586,28 @@ void Fluxbox::shutdown() {
 
     STLUtil::forAll(m_screen_list, mem_fun(&BScreen::shutdown));
 
+    flushRc();
+    FbTk::TextureCache::instance().save();
+    FbTk::StyleCache::instance().save();
+
     sync(false);
 }
 
-/// saves resources
+/// saves resources, once the changes that come with this one are made
 void Fluxbox::save_rc() {
+    // timed from the first change, so a long drag gets saved too
+    if (!m_save_rc_timer.isTiming())
+        m_save_rc_timer.start();
+}
+
+void Fluxbox::flushRc() {
+    if (!m_save_rc_timer.isTiming())
+        return;
+    m_save_rc_timer.stop();
+    writeRc();
+}
+
+void Fluxbox::writeRc() {
     _FB_USES_NLS;
     XrmDatabase new_rc = 0;
 
@@ -1168,7 +1647,7 @@ void Fluxbox::save_rc() {
     XrmDatabase old_rc = XrmGetFileDatabase(dbfile.c_str());
 
     XrmMergeDatabases(new_rc, &old_rc);
-    XrmPutFileDatabase(old_rc, dbfile.c_str());
+    FbTk::ResourceManager::putFileDatabase(old_rc, dbfile);
     XrmDestroyDatabase(old_rc);
 
     fbdbg<<__FILE__<<"("<<__LINE__<<"): ------------ SAVING DONE"<<endl;
@@ -1182,6 +1661,66 @@ string Fluxbox::getRcFilename() {
     return m_rc_file;
 }
 
+void Fluxbox::updateLeakCheck() {
+    m_leak_check.reset(0);
+    if (*m_rc_leak_check_interval == 0 || m_screen_list.empty())
+        return;
+
+    if (!LeakCheck::supported()) {
+        _FB_USES_NLS;
+        cerr<<_FB_CONSOLETEXT(Fluxbox, LeakCheckUnsupported,
+                              "Warning: session.leakCheckInterval needs the X-Resource extension",
+                              "the X server or this build lacks XRes")<<endl;
+        return;
+    }
+    m_leak_check.reset(new LeakCheck(m_screen_list.front()->dummyWindow().window(),
+                                     *m_rc_leak_check_interval));
+}
+
+void Fluxbox::updateRemoteServer() {
+    Atom socket_atom = FbTk::AtomCache::instance().get("_FLUXBOX_SOCKET");
+
+    bool allowed = false;
+    ScreenList::iterator it = m_screen_list.begin();
+    for (; it != m_screen_list.end(); ++it)
+        allowed |= (*it)->allowRemoteActions();
+
+    if (!allowed) {
+        if (m_remote_server.get()) {
+            for (it = m_screen_list.begin(); it != m_screen_list.end(); ++it)
+                (*it)->rootWindow().deleteProperty(socket_atom);
+            m_remote_server.reset(0);
+        }
+        return;
+    }
+    if (m_remote_server.get())
+        return;
+
+    // one socket per display, like ~/.fluxbox/remote_0.0
+    string name = string("remote") + DisplayString(display());
+    for (string::iterator c = name.begin(); c != name.end(); ++c) {
+        if (!isalnum((unsigned char)*c) && *c != '.')
+            *c = '_';
+    }
+    m_remote_server.reset(new RemoteServer(getDefaultDataFilename(name.c_str())));
+    if (!m_remote_server->isListening()) {
+        m_remote_server.reset(0);
+        return;
+    }
+
+    for (it = m_screen_list.begin(); it != m_screen_list.end(); ++it)
+        m_remote_server->watch(**it);
+
+    // tell fluxbox-remote where to find it
+    const string &path = m_remote_server->path();
+    FbTk::App::setenv("FLUXBOX_SOCKET", path.c_str());
+    for (it = m_screen_list.begin(); it != m_screen_list.end(); ++it)
+        (*it)->rootWindow().changeProperty(socket_atom, XA_STRING, 8,
+                                           PropModeReplace,
+                                           (unsigned char *)path.c_str(),
+                                           path.size());
+}
+
 /// Provides default filename of data file
 string Fluxbox::getDefaultDataFilename(const char *name) const {
     return m_RC_PATH + string("/") + name;
@@ -1189,7 +1728,10 @@ string Fluxbox::getDefaultDataFilename(const char *name) const {
 
 /// loads resources
 void Fluxbox::load_rc() {
+    FbTk::StartupProfile::Phase phase("load_rc");
     _FB_USES_NLS;
+    // don't lose changes that weren't written yet
+    flushRc();
 
     string dbfile(getRcFilename());
 
@@ -1226,6 +1768,7 @@ void Fluxbox::load_rc() {
 void Fluxbox::load_rc(BScreen &screen) {
     //get resource filename
     _FB_USES_NLS;
+    flushRc();
     string dbfile(getRcFilename());
 
     XrmDatabaseHelper database;
@@ -1279,6 +1822,7 @@ void Fluxbox::load_rc(BScreen &screen) {
 }
 
 void Fluxbox::reconfigure() {
+    FbTk::Tracer::Span span("reconfigure", "Fluxbox::load_rc");
     load_rc();
     m_reconfigure_wait = true;
     m_reconfig_timer.start();
@@ -1289,13 +1833,26 @@ void Fluxbox::real_reconfigure() {
 
     FbTk::Transparent::usePseudoTransparent(*m_rc_pseudotrans);
 
-    ScreenList::iterator screen_it = m_screen_list.begin();
-    ScreenList::iterator screen_it_end = m_screen_list.end();
-    for (; screen_it != screen_it_end; ++screen_it)
-        load_rc(*(*screen_it));
+    {
+        FbTk::Tracer::Span span("reconfigure", "screen resources");
+        ScreenList::iterator screen_it = m_screen_list.begin();
+        ScreenList::iterator screen_it_end = m_screen_list.end();
+        for (; screen_it != screen_it_end; ++screen_it)
+            load_rc(*(*screen_it));
+    }
 
-    STLUtil::forAll(m_screen_list, mem_fun(&BScreen::reconfigure));
-    m_key->reconfigure();
+    {
+        FbTk::Tracer::Span span("reconfigure", "BScreen::reconfigure");
+        STLUtil::forAll(m_screen_list, mem_fun(&BScreen::reconfigure));
+    }
+    FbTk::CommandParser<void>::instance().clearCache();
+    updateRemoteServer();
+    updateLeakCheck();
+    {
+        FbTk::Tracer::Span span("reconfigure", "Keys::reconfigure");
+        m_key->reconfigure();
+    }
+    FbTk::Tracer::Span span("reconfigure", "AtomHandler::reconfigure");
     STLUtil::forAll(m_atomhandler, mem_fun(&AtomHandler::reconfigure));
 }
 
@@ -1331,6 +1888,7 @@ void Fluxbox::revertFocus() {
 
         Window win;
         int blah;
+        FBTK_ROUNDTRIP("Fluxbox::revertFocus");
         XGetInputFocus(display(), &win, &blah);
 
         // we only want to revert focus if it's left dangling, as some other
@@ -1347,12 +1905,7 @@ void Fluxbox::revertFocus() {
 }
 
 bool Fluxbox::validateClient(const WinClient *client) const {
-    WinClientMap::const_iterator it =
-        find_if(m_window_search.begin(),
-                m_window_search.end(),
-                Compose(bind2nd(equal_to<WinClient *>(), client),
-                        Select2nd<WinClientMap::value_type>()));
-    return it != m_window_search.end();
+    return m_clients.find(client) != m_clients.end();
 }
 
 void Fluxbox::updateFrameExtents(FluxboxWindow &win) {
@@ -28,6 +28,9 @@
 #include "FbTk/App.hh"
 #include "FbTk/Resource.hh"
 #include "FbTk/Timer.hh"
+#include "FbTk/EventCoalescer.hh"
+#include "FbTk/EventStats.hh"
+#include "FbTk/XIDMap.hh"
 #include "FbTk/SignalHandler.hh"
 #include "FbTk/Signal.hh"
 
@@ -56,9 +59,11 @@
 #endif // HAVE_SYS_TIME_H
 #endif // TIME_WITH_SYS_TIME
 
+#include <iosfwd>
 #include <list>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -68,6 +73,9 @@ class WinClient;
 class Keys;
 class BScreen;
 class FbAtoms;
+class RemoteServer;
+class LeakCheck;
+class RestartState;
 
 /// main class for the window manager.
 /**
@@ -90,13 +98,15 @@ public:
     bool validateWindow(Window win) const;
     bool validateClient(const WinClient *client) const;
 
-    void grab();
+    /// grabs the server, 'site' names the caller in the statistics
+    void grab(const char *site);
     void ungrab();
     Keys *keys() { return m_key.get(); }
     Atom getFluxboxPidAtom() const { return m_fluxbox_pid; }
 
-    // Not currently implemented until we decide how it'll be used
-    //WinClient *searchGroup(Window);
+    /// @return the first client of the ICCCM group (see ICCCM 4.1.11) with
+    ///         the given leader, 0 if there is none
+    WinClient *searchGroup(Window leader);
     WinClient *searchWindow(Window);
 
     void initScreen(BScreen *screen);
@@ -132,6 +142,9 @@ public:
 
     unsigned int getCacheLife() const { return *m_rc_cache_life * 60000; }
     unsigned int getCacheMax() const { return *m_rc_cache_max; }
+    /// @return seconds the items of a [pipemenu] are shown before its
+    ///         command runs again
+    unsigned int getPipeMenuTTL() const { return *m_rc_pipe_menu_ttl; }
 
 
     void maskWindowEvents(Window w, FluxboxWindow *bw)
@@ -148,7 +161,7 @@ public:
     void save_rc();
     void removeWindowSearch(Window win);
     void removeWindowSearchGroup(Window win);
-    void removeGroupSearch(Window win);
+    void removeGroupSearch(Window win, WinClient *winclient);
     void restart(const char *command = 0);
     void reconfigure();
 
@@ -188,9 +201,29 @@ public:
 
     AttentionNoticeHandler &attentionHandler() { return m_attention_handler; }
 
+    /// @return counters of events folded by session.coalesceEvents
+    const FbTk::EventCoalescer::Stats &coalescerStats() const { return m_coalescer.stats(); }
+    /// prints the statistics collected with session.collectStats,
+    /// the round-trips to the X server and the size of the pixmap caches
+    void dumpStats(std::ostream &os) const;
+    /// writes a snapshot of the live counters as a JSON object on a single
+    /// line, for monitoring through the remote socket
+    void writeStatsJson(std::ostream &os) const;
+    /// prints the pixmaps we hold in the X server by subsystem and by
+    /// window, and the size of the caches and pools
+    void dumpMemory(std::ostream &os) const;
+
 private:
     std::string getRcFilename();
     void load_rc();
+    /// writes the resources save_rc() asked for
+    void writeRc();
+    /// writes the resources now if save_rc() is waiting to
+    void flushRc();
+    /// listens for remote commands while any screen allows them
+    void updateRemoteServer();
+    /// starts or stops the leak check as session.leakCheckInterval says
+    void updateLeakCheck();
 
     void real_reconfigure();
 
@@ -236,6 +269,9 @@ private:
 
     FbTk::Resource<bool> m_rc_ignoreborder;
     FbTk::Resource<bool> m_rc_pseudotrans;
+    FbTk::Resource<bool> m_rc_coalesce_events;
+    FbTk::Resource<bool> m_rc_collect_stats;
+    FbTk::Resource<bool> m_rc_audit_round_trips;
     FbTk::Resource<int> m_rc_colors_per_channel,
         m_rc_double_click_interval,
         m_rc_tabs_padding;
@@ -246,19 +282,38 @@ private:
 
 
     FbTk::Resource<TabsAttachArea> m_rc_tabs_attach_area;
-    FbTk::Resource<unsigned int> m_rc_cache_life, m_rc_cache_max;
+    FbTk::Resource<unsigned int> m_rc_cache_life, m_rc_cache_max, m_rc_pixmap_budget;
+    FbTk::Resource<unsigned int> m_rc_texture_cache_size;
+    FbTk::Resource<unsigned int> m_rc_icon_cache_size;
+    FbTk::Resource<unsigned int> m_rc_leak_check_interval;
+    FbTk::Resource<unsigned int> m_rc_watchdog_deadline;
+    FbTk::Resource<unsigned int> m_rc_pipe_menu_ttl;
     FbTk::Resource<time_t> m_rc_auto_raise_delay;
 
-    typedef std::map<Window, WinClient *> WinClientMap;
-    WinClientMap m_window_search;
-    typedef std::map<Window, FluxboxWindow *> WindowMap;
-    WindowMap m_window_search_group;
-    // A window is the group leader, which can map to several
-    // WinClients in the group, it is *not* fluxbox's concept of groups
-    // See ICCCM section 4.1.11
-    // The group leader (which may not be mapped, so may not have a WinClient)
-    // will have it's window being the group index
-    std::multimap<Window, WinClient *> m_group_search;
+    /// everything searchWindow() and searchGroup() know about a window id;
+    /// the event handler of the window stays with FbTk::EventManager,
+    /// which also serves menus, the toolbar and the slit and can't know
+    /// about clients and frames
+    struct SearchEntry {
+        SearchEntry(): client(0), fbwindow(0) { }
+        bool empty() const { return client == 0 && fbwindow == 0 && group.empty(); }
+
+        WinClient *client; ///< the client of this window
+        FluxboxWindow *fbwindow; ///< the window is part of this frame
+        // A window is the group leader, which can map to several
+        // WinClients in the group, it is *not* fluxbox's concept of groups
+        // See ICCCM section 4.1.11
+        // The group leader (which may not be mapped, so may not have a WinClient)
+        // will have it's window being the group index
+        std::vector<WinClient *> group;
+    };
+    /// returns the entry of 'win', creating it if needed
+    SearchEntry &searchEntry(Window win);
+    /// removes the entry of 'win' if nothing refers to it anymore
+    void cleanSearchEntry(Window win);
+
+    FbTk::XIDMap<SearchEntry> m_window_search;
+    std::set<const WinClient *> m_clients; ///< all clients, for validateClient()
 
     ScreenList m_screen_list;
 
@@ -278,12 +333,17 @@ private:
     std::string m_restart_argument; ///< what to restart
 
     XEvent m_last_event;
+    FbTk::EventCoalescer m_coalescer;
 
     ///< when we execute reconfig command we must wait until next event round
     FbTk::Timer m_reconfig_timer;
+    /// save_rc() writes once a burst of changes is over
+    FbTk::Timer m_save_rc_timer;
     bool m_showing_dialog;
 
     std::auto_ptr<Keys> m_key;
+    std::auto_ptr<RemoteServer> m_remote_server;
+    std::auto_ptr<LeakCheck> m_leak_check;
 
     //default arguments for titlebar left and right
     static Fluxbox *s_singleton;
@@ -292,11 +352,17 @@ private:
     typedef AtomHandlerContainer::iterator AtomHandlerContainerIt;
 
     AtomHandlerContainer m_atomhandler;
+    RestartState *m_restart_state; ///< one of m_atomhandler
 
     bool m_starting;
     bool m_restarting;
     bool m_shutdown;
     int m_server_grabs;
+    /// how long the server was grabbed, per site of the outermost grab()
+    typedef std::map<std::string, FbTk::LatencyHistogram> GrabStats;
+    GrabStats m_grab_stats;
+    const char *m_grab_site;
+    uint64_t m_grab_start;
     int m_randr_event_type; ///< the type number of randr event
     int m_shape_eventbase; ///< event base for shape events
     bool m_have_shape; ///< if shape is supported by server
@@ -31,10 +31,12 @@
 #include "Debug.hh"
 
 #include "FbTk/Theme.hh"
+#include "FbTk/Font.hh"
 #include "FbTk/I18n.hh"
 #include "FbTk/CommandParser.hh"
 #include "FbTk/FileUtil.hh"
 #include "FbTk/StringUtil.hh"
+#include "FbTk/StartupProfile.hh"
 
 //use GNU extensions
 #ifndef	 _GNU_SOURCE
@@ -303,6 +305,7 @@ static void parseOptions(int argc, char** argv, Options& opts) {
                            "-list-commands\t\t\tlist all valid key commands.\n"
                            "-sync\t\t\t\tsynchronize with X server for debugging.\n"
                            "-log <filename>\t\t\tlog output to file.\n"
+                           "-startup-profile\t\tprint where the startup time goes.\n"
                            "-help\t\t\t\tdisplay this help text and exit.\n\n",
 
                            "Main usage string. Please lay it out nicely. There is one %s that is given the version").c_str(),
@@ -318,6 +321,8 @@ static void parseOptions(int argc, char** argv, Options& opts) {
             for (; it != it_end; ++it)
                 cout << it->first << endl;
             exit(EXIT_SUCCESS);
+        } else if (arg == "-startup-profile" || arg == "--startup-profile") {
+            FbTk::StartupProfile::instance().start();
         } else if (arg == "-verbose" || arg == "--verbose") {
             FbTk::ThemeManager::instance().setVerbose(true);
         }
@@ -376,6 +381,11 @@ void setupConfigFiles(const std::string& dirname, const std::string& rc) {
         }
     }
 
+    // rendered textures are kept here between runs
+    const std::string cache_dir = dirname + "/cache";
+    if (!FbTk::FileUtil::isDirectory(cache_dir.c_str()))
+        mkdir(cache_dir.c_str(), 0700);
+
     bool sync_fs = false;
 
     // copy default files if needed
@@ -474,6 +484,10 @@ int main(int argc, char **argv) {
     setupConfigFiles(opts.rc_path, opts.rc_file);
     updateConfigFilesIfNeeded(opts.rc_file);
 
+    // fontconfig can take a while with cold caches, let it overlap with
+    // connecting to the display and setting up the screens
+    FbTk::Font::preload();
+
     auto_ptr<Fluxbox> fluxbox;
     try {
 
@@ -1,18 +1,215 @@
 // parsertest.cc a test app for Parser
 // Copyright (c) 2006 Henrik Kinnunen (fluxgen at fluxbox dot org)
 
+// prints the items of a menu file:
+//   ./testParser ~/.fluxbox/menu
+// or generates menu, keys and apps files of some megabytes and compares
+// reading them through FbTk::Tokenizer with std::getline() and
+// StringUtil::getStringBetween(), one tab separated line each:
+//   ./testParser -bench 8
+
 #include "../FbMenuParser.hh"
+#include "FbTk/FileUtil.hh"
+#include "FbTk/StringUtil.hh"
+#include "FbTk/Tokenizer.hh"
+#include "testTime.hh"
 
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <unistd.h>
 
 using namespace std;
+using namespace FbTk;
+
+namespace {
+
+/// what was read, to tell that both ways read the same
+struct Result {
+    Result(): tokens(0), bytes(0) { }
+    bool operator == (const Result &other) const {
+        return tokens == other.tokens && bytes == other.bytes;
+    }
+    unsigned long tokens, bytes;
+};
+
+void generate(const string &filename, const char *const lines[], size_t megabytes) {
+    ofstream file(filename.c_str());
+    size_t size = 0;
+    for (unsigned long n = 0; size < megabytes * 1024 * 1024; ++n) {
+        char line[256];
+        int len = snprintf(line, sizeof(line), lines[n % 4], n, n);
+        file << line << '\n';
+        size += len + 1;
+    }
+}
+
+const char *const MENU_LINES[] = {
+    "  [exec] (Terminal %lu) {xterm -e top -d %lu} <icons/term.png>",
+    "  [submenu] (Submenu %lu) {Title %lu}",
+    "    [exec] (Editor \\) %lu) {emacs --file notes%lu.txt}",
+    "  [end]"
+};
+
+const char *const KEYS_LINES[] = {
+    "Mod4 %lu :Workspace %lu",
+    "# comment %lu %lu",
+    "OnTitlebar Mouse%lu :MacroCmd {Raise} {Focus} {ActivateTab %lu}",
+    "Control Mod1 Left :SendToPrevWorkspace"
+};
+
+const char *const APPS_LINES[] = {
+    "[app] (name=xterm%lu) (class=XTerm%lu)",
+    "  [Workspace]\t{%lu}   # comment %lu",
+    "  [Dimensions] (WINCENTER) {%lu %lu}",
+    "[end]"
+};
+
+/// what FbMenuParser reads
+Result readMenu(const string &filename) {
+    Result result;
+    FbMenuParser parser(filename);
+    Parser::Item item;
+    while (!parser.eof()) {
+        parser >> item;
+        if (!item.second.empty()) {
+            ++result.tokens;
+            result.bytes += item.second.size();
+        }
+    }
+    return result;
+}
+
+/// the [key] (option) {value} tokens of each line, the old way
+Result readTokensStream(const string &filename) {
+    Result result;
+    ifstream file(filename.c_str());
+    string line, token;
+    while (getline(file, line)) {
+        StringUtil::removeFirstWhitespace(line);
+        StringUtil::removeTrailingWhitespace(line);
+        int pos = 0;
+        const char delims[] = "[](){}";
+        for (int i = 0; i < 3; ++i) {
+            int err = StringUtil::getStringBetween(token, line.c_str() + pos,
+                                                   delims[i * 2], delims[i * 2 + 1]);
+            if (err <= 0)
+                continue;
+            pos += err;
+            ++result.tokens;
+            result.bytes += token.size();
+        }
+    }
+    return result;
+}
+
+/// the same with a Tokenizer over the mapped file
+Result readTokens(const string &filename) {
+    Result result;
+    MappedFile file(filename.c_str());
+    Tokenizer tokenizer(file);
+    string token;
+    while (tokenizer.nextLine()) {
+        Tokenizer::Range line = Tokenizer::strip(tokenizer.line());
+        const char delims[] = "[](){}";
+        for (int i = 0; i < 3; ++i) {
+            const char *end = Tokenizer::between(line, delims[i * 2],
+                                                 delims[i * 2 + 1], token);
+            if (end == 0)
+                continue;
+            line.begin = end;
+            ++result.tokens;
+            result.bytes += token.size();
+        }
+    }
+    return result;
+}
+
+/// only the lines, like Keys reads them
+Result readLinesStream(const string &filename) {
+    Result result;
+    ifstream file(filename.c_str());
+    string line;
+    while (getline(file, line)) {
+        ++result.tokens;
+        result.bytes += line.size();
+    }
+    return result;
+}
+
+Result readLines(const string &filename) {
+    Result result;
+    MappedFile file(filename.c_str());
+    Tokenizer tokenizer(file);
+    string line;
+    while (tokenizer.nextLine()) {
+        tokenizer.line().assignTo(line);
+        ++result.tokens;
+        result.bytes += line.size();
+    }
+    return result;
+}
+
+bool measure(const char *what, const string &filename, size_t megabytes,
+             Result (*old_way)(const string &), Result (*new_way)(const string &)) {
+    Result results[2];
+    double seconds[2];
+    Result (*ways[2])(const string &) = { old_way, new_way };
+    for (int i = 0; i < 2; ++i) {
+        if (ways[i] == 0)
+            continue;
+        ways[i](filename); // warm up the page cache
+        double start = now();
+        results[i] = ways[i](filename);
+        seconds[i] = now() - start;
+    }
 
+    for (int i = 0; i < 2; ++i) {
+        if (ways[i] == 0)
+            continue;
+        printf("%s\t%s\t%lu\t%.1f\t%.0f\n", what, i == 0 ? "stream" : "tokenizer",
+               results[i].tokens, seconds[i] * 1000, megabytes / seconds[i]);
+    }
+    if (old_way && !(results[0] == results[1])) {
+        printf("# %s: the tokenizer read something else\n", what);
+        return false;
+    }
+    return true;
+}
+
+int bench(size_t megabytes) {
+    string dir = "/tmp/testParser." + StringUtil::number2String(getpid());
+    string menu = dir + ".menu", keys = dir + ".keys", apps = dir + ".apps";
+    generate(menu, MENU_LINES, megabytes);
+    generate(keys, KEYS_LINES, megabytes);
+    generate(apps, APPS_LINES, megabytes);
+
+    printf("# %lu MB each\n", (unsigned long)megabytes);
+    printf("# file\tway\ttokens\tms\tMB/s\n");
+    bool ok = measure("menu", menu, megabytes, 0, readMenu);
+    ok = measure("menu", menu, megabytes, readTokensStream, readTokens) && ok;
+    ok = measure("keys", keys, megabytes, readLinesStream, readLines) && ok;
+    ok = measure("apps", apps, megabytes, readTokensStream, readTokens) && ok;
+
+    remove(menu.c_str());
+    remove(keys.c_str());
+    remove(apps.c_str());
+    return ok ? 0 : 1;
+}
+
+} // anonymous namespace
 
 int main(int argc, char **argv) {
     if (argc < 2) {
         cerr<<"you must supply an argument!"<<endl;
         exit(0);
     }
+    if (strcmp(argv[1], "-bench") == 0)
+        return bench(argc > 2 ? atoi(argv[2]) : 4);
+
     cerr<<"Loading: "<<argv[1]<<endl;
     Parser *p = new FbMenuParser(argv[1]);
     if (!p->isLoaded()) {
@@ -22,10 +219,6 @@ int main(int argc, char **argv) {
     }
 
     Parser::Item item, item2, item3;
-    int args = 0;
-    int last_line_num = 0;
-    std::string last_line;
-    std::string type, name, argument;
     while (!p->eof()) {
         (*p)>>item>>item2>>item3;
         cerr<<item.second<<","<<item2.second<<", "<<item3.second<<endl;
@@ -0,0 +1,58 @@
+// testArgbKernels.cc for fbtk test suite
+
+// checks that all _NET_WM_ICON conversion kernels usable on this cpu
+// produce the same bytes as the scalar one
+
+#include "FbTk/ArgbKernels.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace FbTk;
+
+namespace {
+
+int compare(const ArgbKernels::Impl &ref, const ArgbKernels::Impl &impl) {
+    int failed = 0;
+    std::vector<unsigned long> argb(300);
+    std::vector<unsigned int> expected_rgb(300), got_rgb(300);
+    std::vector<unsigned char> expected_opaque(300), got_opaque(300);
+
+    for (int run = 0; run < 2000; ++run) {
+        unsigned int num = rand() % argb.size();
+        // clients leave garbage in the upper half of 64 bit longs
+        for (unsigned int i = 0; i < num; ++i)
+            argb[i] = ((unsigned long)rand() << 16 << 16) ^
+                ((unsigned long)rand() << 8) ^ rand();
+        unsigned char threshold = rand();
+
+        ref.split(&expected_rgb[0], &expected_opaque[0], &argb[0], num, threshold);
+        impl.split(&got_rgb[0], &got_opaque[0], &argb[0], num, threshold);
+        if (memcmp(&expected_rgb[0], &got_rgb[0], num * sizeof(unsigned int)) != 0 ||
+            memcmp(&expected_opaque[0], &got_opaque[0], num) != 0) {
+            printf("%s: split of %u pixels differs\n", impl.name, num);
+            ++failed;
+        }
+    }
+    return failed;
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv) {
+    srand(0);
+
+    const ArgbKernels::Impl &scalar = ArgbKernels::get(0);
+    int failed = 0;
+    for (unsigned int i = 1; i < ArgbKernels::count(); ++i) {
+        const ArgbKernels::Impl &impl = ArgbKernels::get(i);
+        int num = compare(scalar, impl);
+        printf("%s: %s\n", impl.name, num == 0 ? "ok" : "FAILED");
+        failed += num;
+    }
+    printf("using %s\n", ArgbKernels::best().name);
+
+    return failed != 0;
+}
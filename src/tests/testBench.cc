@@ -0,0 +1,493 @@
+// testBench.cc for fbtk test suite
+
+// the microbenchmarks of make bench: times the FbTk primitives (Timer,
+// Signal, RefCount, RegExp, StringUtil, and Layer and Container if a display
+// is available) and the parts of fluxbox that run without a window manager
+// (the trigger index of Keys, the ClientPattern terms Remember matches new
+// windows against, and the placement strategies on WindowCoverage). prints
+// the best of three runs in ns per operation as JSON. with a baseline from an
+// earlier run, fails if anything got slower by more than 'percent':
+//   ./testBench > baseline.json
+//   ./testBench -baseline baseline.json -threshold 25
+
+#include "FbTk/App.hh"
+#include "FbTk/Button.hh"
+#include "FbTk/Container.hh"
+#include "FbTk/FbWindow.hh"
+#include "FbTk/LayerItem.hh"
+#include "FbTk/MultLayers.hh"
+#include "FbTk/RefCount.hh"
+#include "FbTk/RegExp.hh"
+#include "FbTk/Signal.hh"
+#include "FbTk/StringUtil.hh"
+#include "FbTk/Timer.hh"
+#include "WindowCoverage.hh"
+#include "testTime.hh"
+
+#include <X11/Xlib.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace FbTk;
+
+namespace {
+
+/// how often each benchmark runs, the best run counts
+const int RUNS = 3;
+
+typedef std::map<std::string, double> Results;
+Results s_results;
+/// operations per benchmark, scaled with -scale
+unsigned long s_scale = 1;
+
+/// times its scope and keeps the best time per operation of 'name'
+class Measure {
+public:
+    Measure(const char *name, unsigned long ops):
+        m_name(name), m_ops(ops), m_start(now()) { }
+    ~Measure() {
+        double ns = (now() - m_start) * 1e9 / m_ops;
+        Results::iterator it = s_results.find(m_name);
+        if (it == s_results.end())
+            s_results[m_name] = ns;
+        else if (ns < it->second)
+            it->second = ns;
+    }
+private:
+    const char *m_name;
+    unsigned long m_ops;
+    double m_start;
+};
+
+/// keeps the compiler from dropping the work
+volatile unsigned long s_sink = 0;
+
+struct Noop {
+    void operator()() const { }
+};
+
+void slot() { ++s_sink; }
+
+struct Counted: public RefCounted {
+};
+
+void timers() {
+    const unsigned long num = 100000 * s_scale;
+    std::vector<Timer *> timers(num);
+    srand(0);
+    for (unsigned long i = 0; i < num; ++i) {
+        timers[i] = new Timer();
+        timers[i]->setFunctor(Noop());
+        // spread the timeouts, so that inserts don't just append
+        timers[i]->setTimeout(1 + rand() % 100000);
+    }
+    {
+        Measure measure("timer.arm", num);
+        for (unsigned long i = 0; i < num; ++i)
+            timers[i]->start();
+    }
+    {
+        Measure measure("timer.rearm", num);
+        for (unsigned long i = 0; i < num; ++i)
+            timers[i]->start();
+    }
+    {
+        Measure measure("timer.cancel", num);
+        for (unsigned long i = 0; i < num; i += 2)
+            timers[i]->stop();
+        for (unsigned long i = 1; i < num; i += 2)
+            timers[i]->stop();
+    }
+    for (unsigned long i = 0; i < num; ++i)
+        delete timers[i];
+}
+
+void signals() {
+    const unsigned long num = 200000 * s_scale;
+    Signal<> signal;
+    {
+        Measure measure("signal.connect", num);
+        for (unsigned long i = 0; i < num; ++i)
+            signal.disconnect(signal.connect(&slot));
+    }
+    // about as many as the signals of a window have
+    for (int i = 0; i < 10; ++i)
+        signal.connect(&slot);
+    {
+        Measure measure("signal.emit10", num);
+        for (unsigned long i = 0; i < num; ++i)
+            signal.emit();
+    }
+}
+
+void refcounts() {
+    const unsigned long num = 1000000 * s_scale;
+    {
+        Measure measure("refcount.create", num);
+        for (unsigned long i = 0; i < num; ++i)
+            RefCount<Counted> ref(new Counted);
+    }
+    RefCount<Counted> ref(new Counted);
+    {
+        Measure measure("refcount.copy", num);
+        for (unsigned long i = 0; i < num; ++i) {
+            RefCount<Counted> copy(ref);
+            RefCount<Counted> other;
+            other = copy;
+        }
+    }
+}
+
+/// window names, classes and titles as apps files and keys files see them
+const char *s_names[] = {
+    "xterm", "urxvt", "Navigator", "Mail", "gimp-2.10", "Dialog",
+    "emacs@host", "pidgin", "vlc", "Terminal - user@host: ~/src/fluxbox",
+    "Mozilla Firefox", "Inbox - Thunderbird", "GNU Image Manipulation Program",
+    "main.cc - Visual Studio Code", "VLC media player", "Buddy List"
+};
+const size_t NUM_NAMES = sizeof(s_names) / sizeof(s_names[0]);
+
+void regexps() {
+    const unsigned long num = 200000 * s_scale;
+    RegExp literal("xterm");
+    RegExp regex(".*[Ff]irefox.*");
+    std::vector<std::string> names(s_names, s_names + NUM_NAMES);
+    {
+        Measure measure("regexp.literal", num);
+        for (unsigned long i = 0; i < num; ++i)
+            s_sink += literal.match(names[i % NUM_NAMES]);
+    }
+    {
+        Measure measure("regexp.regex", num);
+        for (unsigned long i = 0; i < num; ++i)
+            s_sink += regex.match(names[i % NUM_NAMES]);
+    }
+}
+
+void strings() {
+    const unsigned long num = 200000 * s_scale;
+    const std::string line = "  OnTitlebar Mouse1 :StartMoving  ";
+    {
+        Measure measure("stringutil.toLower", num);
+        for (unsigned long i = 0; i < num; ++i)
+            s_sink += StringUtil::toLower(line).size();
+    }
+    {
+        Measure measure("stringutil.strip", num);
+        for (unsigned long i = 0; i < num; ++i) {
+            std::string str = line;
+            StringUtil::removeFirstWhitespace(str);
+            StringUtil::removeTrailingWhitespace(str);
+            s_sink += str.size();
+        }
+    }
+    {
+        Measure measure("stringutil.stringtok", num);
+        for (unsigned long i = 0; i < num; ++i) {
+            std::vector<std::string> tokens;
+            StringUtil::stringtok(tokens, line, " \t");
+            s_sink += tokens.size();
+        }
+    }
+    {
+        Measure measure("stringutil.extractNumber", num);
+        for (unsigned long i = 0; i < num; ++i) {
+            int value = 0;
+            StringUtil::extractNumber("1920", value);
+            s_sink += value;
+        }
+    }
+}
+
+/// the trigger a binding of the keys file reacts to, like in Keys::t_key
+struct Trigger {
+    Trigger(int type_, unsigned int mod_, unsigned int key_):
+        type(type_), mod(mod_), key(key_) { }
+    bool operator<(const Trigger &other) const {
+        if (type != other.type)
+            return type < other.type;
+        if (mod != other.mod)
+            return mod < other.mod;
+        return key < other.key;
+    }
+    int type;
+    unsigned int mod, key;
+};
+
+struct Binding {
+    int context;
+    bool isdouble;
+};
+
+/// Keys::t_key::find on a level with the bindings of a large keys file
+void keys() {
+    const unsigned long num = 1000000 * s_scale;
+    typedef std::map<Trigger, std::vector<Binding> > Index;
+    Index index;
+    srand(0);
+    for (int i = 0; i < 300; ++i) {
+        Binding binding = { 1 << (rand() % 8), rand() % 4 == 0 };
+        index[Trigger(KeyPress + rand() % 3, rand() % 16, 9 + rand() % 120)]
+            .push_back(binding);
+    }
+    {
+        Measure measure("keys.find", num);
+        for (unsigned long i = 0; i < num; ++i) {
+            Index::const_iterator bucket = index.find(
+                Trigger(KeyPress + i % 3, i % 16, 9 + i % 120));
+            if (bucket == index.end())
+                continue;
+            for (size_t b = 0; b < bucket->second.size(); ++b) {
+                if ((bucket->second[b].context & (1 << (i % 8))) &&
+                    !bucket->second[b].isdouble) {
+                    ++s_sink;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/// a ClientPattern term: the property and the regexp it has to match
+struct Term {
+    Term(int property_, const char *regexp_): property(property_), regexp(regexp_) { }
+    int property;
+    RegExp regexp;
+};
+
+/// the apps file entries Remember::find checks a new window against, every
+/// term of an entry has to match, the first entry that does wins
+void patterns() {
+    const unsigned long num = 20000 * s_scale;
+    std::list<std::vector<Term *> > entries;
+    char buf[64];
+    for (int i = 0; i < 50; ++i) {
+        std::vector<Term *> terms;
+        snprintf(buf, sizeof(buf), "app%d", i);
+        terms.push_back(new Term(0, buf));
+        if (i % 3 == 0)
+            terms.push_back(new Term(1, ".*Dialog.*"));
+        entries.push_back(terms);
+    }
+    std::vector<Term *> last;
+    last.push_back(new Term(0, "xterm"));
+    last.push_back(new Term(2, "Terminal.*"));
+    entries.push_back(last);
+
+    std::vector<std::string> props(3);
+    {
+        Measure measure("clientpattern.match", num * entries.size());
+        for (unsigned long i = 0; i < num; ++i) {
+            props[0] = s_names[i % NUM_NAMES];
+            props[1] = s_names[(i + 5) % NUM_NAMES];
+            props[2] = s_names[(i + 9) % NUM_NAMES];
+            std::list<std::vector<Term *> >::const_iterator it = entries.begin();
+            for (; it != entries.end(); ++it) {
+                size_t t = 0;
+                while (t < it->size() &&
+                       (*it)[t]->regexp.match(props[(*it)[t]->property]))
+                    ++t;
+                if (t == it->size()) {
+                    ++s_sink;
+                    break;
+                }
+            }
+        }
+    }
+
+    std::list<std::vector<Term *> >::iterator it = entries.begin();
+    for (; it != entries.end(); ++it) {
+        for (size_t t = 0; t < it->size(); ++t)
+            delete (*it)[t];
+    }
+}
+
+/// the smart and min overlap placements among 200 windows on a 1920x1080 head
+void placement() {
+    const unsigned long num = 20 * s_scale;
+    srand(0);
+    WindowCoverage coverage;
+    for (int i = 0; i < 200; ++i) {
+        int x = rand() % 1600, y = rand() % 800;
+        coverage.add(0, x, y, x + 100 + rand() % 600, y + 100 + rand() % 400);
+    }
+    coverage.build();
+    int x = 0, y = 0;
+    {
+        Measure measure("placement.rowsmart", num);
+        for (unsigned long i = 0; i < num; ++i)
+            s_sink += coverage.findFree(300, 200, 0, 0, 1920, 1080,
+                                        true, true, true, x, y);
+    }
+    {
+        Measure measure("placement.minoverlap", num);
+        for (unsigned long i = 0; i < num; ++i) {
+            coverage.findMinOverlap(300, 200, 0, 0, 1920, 1080,
+                                    true, true, true, 0, x, y);
+            s_sink += x;
+        }
+    }
+}
+
+/// MultLayers bookkeeping, as in testLayers
+void layers() {
+    const unsigned long num = 2000 * s_scale;
+    const int NUM_LAYERS = 3;
+    MultLayers layers(NUM_LAYERS);
+    FbWindow win;
+    std::vector<LayerItem *> items(num);
+    for (unsigned long i = 0; i < num; ++i)
+        items[i] = new LayerItem(win, *layers.getLayer(i % NUM_LAYERS));
+    srand(0);
+    {
+        Measure measure("layer.restack", 10 * num);
+        for (unsigned long i = 0; i < 10 * num; ++i) {
+            LayerItem &item = *items[rand() % num];
+            if (i % 2)
+                item.raise();
+            else
+                item.lower();
+        }
+    }
+    for (unsigned long i = 0; i < num; ++i)
+        delete items[i];
+}
+
+/// inserting and removing the buttons of an iconbar
+void containers() {
+    const unsigned long num = 100 * s_scale;
+    FbWindow parent(0, 0, 0, 1000, 20, ExposureMask);
+    Container container(parent);
+    container.resize(1000, 20);
+    std::vector<Button *> buttons(num);
+    for (unsigned long i = 0; i < num; ++i)
+        buttons[i] = new Button(container, 0, 0, 20, 20);
+    {
+        Measure measure("container.insert", num);
+        for (unsigned long i = 0; i < num; ++i)
+            container.insertItem(buttons[i]);
+    }
+    {
+        Measure measure("container.remove", num);
+        for (unsigned long i = 0; i < num; ++i)
+            container.removeItem(buttons[i]);
+    }
+    for (unsigned long i = 0; i < num; ++i)
+        delete buttons[i];
+}
+
+void writeJson(FILE *file) {
+    fprintf(file, "{\n");
+    size_t left = s_results.size();
+    Results::const_iterator it = s_results.begin();
+    for (; it != s_results.end(); ++it) {
+        fprintf(file, "  \"%s\": %.2f%s\n", it->first.c_str(), it->second,
+                --left ? "," : "");
+    }
+    fprintf(file, "}\n");
+}
+
+/// reads what writeJson wrote
+bool readJson(const char *filename, Results &results) {
+    FILE *file = fopen(filename, "r");
+    if (file == 0)
+        return false;
+    char line[256], name[128];
+    double value;
+    while (fgets(line, sizeof(line), file)) {
+        if (sscanf(line, " \"%127[^\"]\": %lf", name, &value) == 2)
+            results[name] = value;
+    }
+    fclose(file);
+    return true;
+}
+
+/// @return the number of benchmarks slower than 'baseline' by over 'percent'
+int compare(const Results &baseline, double percent) {
+    int regressions = 0;
+    Results::const_iterator it = baseline.begin();
+    for (; it != baseline.end(); ++it) {
+        Results::const_iterator result = s_results.find(it->first);
+        if (result == s_results.end()) {
+            fprintf(stderr, "%-26s skipped\n", it->first.c_str());
+            continue;
+        }
+        double change = it->second > 0 ?
+            (result->second - it->second) * 100 / it->second : 0;
+        bool regressed = change > percent;
+        fprintf(stderr, "%-26s %10.2f ns, baseline %10.2f ns, %+6.1f%%%s\n",
+                it->first.c_str(), result->second, it->second, change,
+                regressed ? "  REGRESSION" : "");
+        if (regressed)
+            ++regressions;
+    }
+    return regressions;
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv) {
+    const char *baseline_file = 0;
+    double threshold = 25;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-baseline") == 0 && i + 1 < argc)
+            baseline_file = argv[++i];
+        else if (strcmp(argv[i], "-threshold") == 0 && i + 1 < argc)
+            threshold = atof(argv[++i]);
+        else if (strcmp(argv[i], "-scale") == 0 && i + 1 < argc)
+            s_scale = atol(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [-baseline file] [-threshold percent] "
+                    "[-scale factor]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (s_scale == 0)
+        s_scale = 1;
+
+    Results baseline;
+    if (baseline_file && !readJson(baseline_file, baseline)) {
+        fprintf(stderr, "can't read %s\n", baseline_file);
+        return 2;
+    }
+
+    // Layer and Container need a display, the rest doesn't
+    Display *disp = XOpenDisplay(0);
+    App *app = 0;
+    if (disp) {
+        XCloseDisplay(disp);
+        app = new App;
+    } else
+        fprintf(stderr, "no display, skipping layer and container\n");
+
+    for (int run = 0; run < RUNS; ++run) {
+        timers();
+        signals();
+        refcounts();
+        regexps();
+        strings();
+        keys();
+        patterns();
+        placement();
+        if (app) {
+            layers();
+            containers();
+        }
+    }
+    delete app;
+
+    writeJson(stdout);
+
+    if (baseline_file && compare(baseline, threshold) > 0) {
+        fprintf(stderr, "slower than %s by more than %.0f%%\n",
+                baseline_file, threshold);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+// testCoverage.cc for fbtk test suite
+
+// checks FbTk::CoverageTable against adding up the overlaps pairwise and
+// times both, the way MinOverlapPlacement uses them: n windows on a
+// 1920x1080 screen and every right/bottom edge pair as candidate position.
+
+#include "FbTk/CoverageTable.hh"
+#include "testTime.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+struct Rect {
+    int left, top, right, bottom;
+};
+
+int64_t pairwise(const std::vector<Rect> &rects, const Rect &r) {
+    int64_t overlap = 0;
+    for (size_t i = 0; i < rects.size(); ++i) {
+        int right = std::min(rects[i].right, r.right);
+        int bottom = std::min(rects[i].bottom, r.bottom);
+        int left = std::max(rects[i].left, r.left);
+        int top = std::max(rects[i].top, r.top);
+        if (right > left && bottom > top)
+            overlap += (int64_t)(right - left) * (bottom - top);
+    }
+    return overlap;
+}
+
+}
+
+int main() {
+
+    const size_t counts[] = { 10, 100, 500 };
+    const int win_w = 640, win_h = 480;
+    int errors = 0;
+
+    srand(0);
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+        std::vector<Rect> rects(counts[c]);
+        FbTk::CoverageTable table;
+        for (size_t i = 0; i < rects.size(); ++i) {
+            rects[i].left = rand() % 1800 - 50;
+            rects[i].top = rand() % 1000 - 50;
+            rects[i].right = rects[i].left + 1 + rand() % 800;
+            rects[i].bottom = rects[i].top + 1 + rand() % 600;
+            table.add(rects[i].left, rects[i].top, rects[i].right, rects[i].bottom);
+        }
+
+        // the placement tries the corners against every other window edge
+        std::vector<Rect> candidates;
+        for (size_t i = 0; i < rects.size(); ++i) {
+            for (size_t j = 0; j < rects.size(); ++j) {
+                Rect r = { rects[i].right, rects[j].bottom,
+                           rects[i].right + win_w, rects[j].bottom + win_h };
+                candidates.push_back(r);
+            }
+        }
+
+        std::vector<int64_t> expected(candidates.size());
+        double start = now();
+        for (size_t i = 0; i < candidates.size(); ++i)
+            expected[i] = pairwise(rects, candidates[i]);
+        double pairwise_time = now() - start;
+
+        start = now();
+        table.build();
+        double build_time = now() - start;
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            const Rect &r = candidates[i];
+            if (table.coverage(r.left, r.top, r.right, r.bottom) != expected[i]) {
+                printf("mismatch for window %lu\n", (unsigned long)i);
+                ++errors;
+            }
+        }
+        double table_time = now() - start;
+
+        printf("%4lu windows, %6lu candidates: pairwise %.3f ms, "
+               "table %.3f ms (build %.3f ms)\n",
+               (unsigned long)rects.size(), (unsigned long)candidates.size(),
+               pairwise_time * 1000, table_time * 1000, build_time * 1000);
+    }
+
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+// testFocusRequests.cc for fbtk test suite
+
+// counts the X requests a focus change sends to the windows of a frame:
+// each window gets the border and background of the new focus state, like
+// FbWinFrame::applyAll does. prints one tab separated line for changing
+// the focus and one for applying the same state again.
+// needs an X display, Xvfb will do:
+//   xvfb-run ./testFocusRequests
+
+#include "FbTk/App.hh"
+#include "FbTk/FbWindow.hh"
+#include "FbTk/FbPixmap.hh"
+#include "FbTk/Color.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace FbTk;
+
+namespace {
+
+// window, titlebar, label, handle, two grips, three buttons and three tabs
+const size_t NUM_WINDOWS = 12;
+
+struct State {
+    Pixmap background;
+    Color border;
+    unsigned int border_width;
+};
+
+void applyState(std::vector<FbWindow *> &wins, const State &state) {
+    for (size_t i = 0; i < wins.size(); ++i) {
+        wins[i]->setBorderWidth(state.border_width);
+        wins[i]->setBorderColor(state.border);
+        wins[i]->setBackgroundPixmap(state.background);
+    }
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv) {
+
+    unsigned long runs = 1000;
+    if (argc > 1)
+        runs = atol(argv[1]);
+
+    App app;
+    Display *disp = app.display();
+    int screen = DefaultScreen(disp);
+
+    FbWindow frame(screen, 0, 0, 400, 300, 0);
+    std::vector<FbWindow *> wins;
+    for (size_t i = 0; i < NUM_WINDOWS; ++i)
+        wins.push_back(new FbWindow(frame, 0, 0, 64, 16, 0));
+
+    FbPixmap focused(frame, 64, 16, frame.depth());
+    FbPixmap unfocused(frame, 64, 16, frame.depth());
+
+    State states[2];
+    states[0].background = focused.drawable();
+    states[0].border.setFromString("rgb:20/40/80", screen);
+    states[0].border_width = 1;
+    states[1].background = unfocused.drawable();
+    states[1].border.setFromString("rgb:80/80/80", screen);
+    states[1].border_width = 1;
+
+    applyState(wins, states[0]);
+    XSync(disp, False);
+
+    printf("# case\truns\trequests/focus change\n");
+
+    unsigned long start = NextRequest(disp);
+    for (unsigned long i = 0; i < runs; ++i)
+        applyState(wins, states[i % 2]);
+    printf("toggle\t%lu\t%.1f\n", runs,
+           (double)(NextRequest(disp) - start) / runs);
+    XSync(disp, False);
+
+    start = NextRequest(disp);
+    for (unsigned long i = 0; i < runs; ++i)
+        applyState(wins, states[0]);
+    printf("same\t%lu\t%.1f\n", runs,
+           (double)(NextRequest(disp) - start) / runs);
+    XSync(disp, False);
+
+    for (size_t i = 0; i < wins.size(); ++i)
+        delete wins[i];
+
+    return 0;
+}
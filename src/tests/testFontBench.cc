@@ -0,0 +1,165 @@
+// testFontBench.cc for fbtk test suite
+
+// measures Font::textWidth, Font::drawText and doAlignment for a few kinds
+// of text and prints the calls per second, the X requests and the
+// round-trips per call, one tab separated line each.
+// the font names decide the implementation: "-..." names use Xmb in
+// multibyte locales and the core font code otherwise (LC_ALL=C), other
+// names use Xft. needs an X display, Xvfb will do:
+//   xvfb-run ./testFontBench 0.2 sans-10 '-misc-fixed-*-*-*-*-13-*-*-*-*-*-*-*'
+
+#include "FbTk/App.hh"
+#include "FbTk/Font.hh"
+#include "FbTk/FbString.hh"
+#include "FbTk/FbPixmap.hh"
+#include "FbTk/GContext.hh"
+#include "FbTk/TextUtils.hh"
+#include "FbTk/RoundTrips.hh"
+#include "testTime.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace FbTk;
+
+namespace {
+
+struct Text {
+    const char *name;
+    const char *utf8;
+};
+
+const Text s_texts[] = {
+    { "ascii-short", "xterm" },
+    { "ascii-long", "~/src/fluxbox/src/FbTk - vim TextUtils.cc "
+      "(modified) - 128x48 - the quick brown fox jumps over the lazy dog" },
+    { "cjk", "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\xe3\x81\xae"
+      "\xe3\x83\x86\xe3\x82\xad\xe3\x82\xb9\xe3\x83\x88 - "
+      "\xe6\x96\x87\xe5\xad\x97\xe5\x88\x97" },
+    { "rtl", "\xd7\xa9\xd7\x9c\xd7\x95\xd7\x9d \xd7\xa2\xd7\x95\xd7\x9c"
+      "\xd7\x9d - \xd9\x85\xd8\xb1\xd8\xad\xd8\xa8\xd8\xa7" }
+};
+
+const Orientation s_orients[] = { ROT0, ROT90, ROT180, ROT270 };
+const char *s_orient_names[] = { "0", "90", "180", "270" };
+
+const unsigned int CHUNK = 64;
+
+/// runs op in chunks until min_time has passed and prints the results
+template <typename Op>
+void run(const char *font, const char *text, const char *op_name,
+         const char *orient, Display *disp, double min_time, Op op) {
+
+    unsigned long calls = 0, requests = 0;
+    RoundTrips::instance().reset();
+    double start = now(), elapsed = 0;
+    do {
+        unsigned long first = NextRequest(disp);
+        for (unsigned int i = 0; i < CHUNK; ++i)
+            op();
+        requests += NextRequest(disp) - first;
+        calls += CHUNK;
+        // the drawing has to be done by the server too
+        XSync(disp, False);
+        elapsed = now() - start;
+    } while (elapsed < min_time);
+
+    printf("%s\t%s\t%s\t%s\t%lu\t%.0f\t%.2f\t%.3f\n",
+           font, text, op_name, orient, calls, calls / elapsed,
+           (double)requests / calls,
+           (double)RoundTrips::instance().total() / calls);
+}
+
+struct WidthOp {
+    const FbTk::Font &font;
+    const BiDiString &text;
+    void operator()() const { font.textWidth(text); }
+};
+
+struct DrawOp {
+    const FbTk::Font &font;
+    const FbPixmap &canvas;
+    int screen;
+    GC gc;
+    const BiDiString &text;
+    Orientation orient;
+    void operator()() const {
+        font.drawText(canvas, screen, gc, text, 20, 20, orient);
+    }
+};
+
+struct AlignOp {
+    const FbTk::Font &font;
+    const BiDiString &text;
+    int max_width;
+    void operator()() const {
+        unsigned int newlen = 0;
+        doAlignment(max_width, 2, LEFT, font, text.visual().c_str(),
+                    text.visual().size(), newlen);
+    }
+};
+
+} // anonymous namespace
+
+int main(int argc, char **argv) {
+
+    double min_time = 0.2;
+    if (argc > 1)
+        min_time = atof(argv[1]);
+
+    std::vector<const char *> fonts;
+    for (int i = 2; i < argc; ++i)
+        fonts.push_back(argv[i]);
+    if (fonts.empty()) {
+        fonts.push_back("sans-10");
+        fonts.push_back("-misc-fixed-medium-r-normal-*-13-*-*-*-*-*-*-*");
+    }
+
+    App app;
+    Display *disp = app.display();
+    FbStringUtil::init();
+
+    FbPixmap canvas(RootWindow(disp, DefaultScreen(disp)), 1024, 1024,
+                    DefaultDepth(disp, DefaultScreen(disp)));
+    FbTk::GContext gc(canvas);
+    gc.setForeground(BlackPixel(disp, DefaultScreen(disp)));
+
+    printf("# font\ttext\top\torient\tcalls\tcalls/s\trequests/call\troundtrips/call\n");
+
+    for (size_t f = 0; f < fonts.size(); ++f) {
+        FbTk::Font font;
+        if (!font.load(fonts[f])) {
+            printf("# can't load %s\n", fonts[f]);
+            continue;
+        }
+
+        for (size_t t = 0; t < sizeof(s_texts) / sizeof(s_texts[0]); ++t) {
+            BiDiString text(s_texts[t].utf8);
+
+            WidthOp width = { font, text };
+            run(fonts[f], s_texts[t].name, "textWidth", "-", disp, min_time, width);
+
+            // about half of the text fits, so it gets truncated
+            AlignOp align = { font, text, static_cast<int>(font.textWidth(text) / 2) };
+            run(fonts[f], s_texts[t].name, "doAlignment", "-", disp, min_time, align);
+
+            for (size_t o = 0; o < sizeof(s_orients) / sizeof(s_orients[0]); ++o) {
+                if (!font.validOrientation(s_orients[o])) {
+                    printf("# %s can't be drawn rotated by %s\n", fonts[f],
+                           s_orient_names[o]);
+                    continue;
+                }
+                DrawOp draw = { font, canvas, DefaultScreen(disp), gc.gc(), text,
+                                s_orients[o] };
+                run(fonts[f], s_texts[t].name, "drawText", s_orient_names[o],
+                    disp, min_time, draw);
+            }
+        }
+    }
+
+    FbTk::Font::shutdown();
+    FbStringUtil::shutdown();
+
+    return 0;
+}
@@ -0,0 +1,246 @@
+// testGradientKernels.cc for fbtk test suite
+
+// checks that all gradient kernels usable on this cpu produce the same
+// bytes as the scalar one, and that the gradients combined with each of
+// them are the ones TextureRender rendered before it had the kernels
+
+#include "FbTk/GradientKernels.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+using namespace FbTk;
+
+namespace {
+
+const char *opName(GradientKernels::Op op) {
+    switch (op) {
+    case GradientKernels::SUM: return "sum";
+    case GradientKernels::MAX: return "max";
+    case GradientKernels::MIN: return "min";
+    }
+    return "?";
+}
+
+int compare(const GradientKernels::Impl &ref, const GradientKernels::Impl &impl) {
+    int failed = 0;
+    std::vector<unsigned char> xtab(300), expected(300), got(300);
+    const GradientKernels::Op ops[] = {
+        GradientKernels::SUM, GradientKernels::MAX, GradientKernels::MIN
+    };
+
+    for (int run = 0; run < 2000; ++run) {
+        unsigned int num = rand() % xtab.size();
+        for (unsigned int i = 0; i < num; ++i)
+            xtab[i] = rand();
+        unsigned char y = rand(), base = rand();
+        bool negate = rand() & 1;
+        GradientKernels::Op op = ops[rand() % 3];
+
+        ref.combine(&expected[0], &xtab[0], num, op, y, base, negate);
+        impl.combine(&got[0], &xtab[0], num, op, y, base, negate);
+        if (memcmp(&expected[0], &got[0], num) != 0) {
+            printf("%s: combine %s of %u bytes differs\n", impl.name, opName(op), num);
+            ++failed;
+        }
+
+        memcpy(&got[0], &xtab[0], num);
+        memcpy(&expected[0], &xtab[0], num);
+        ref.darken(&expected[0], num);
+        impl.darken(&got[0], num);
+        if (memcmp(&expected[0], &got[0], num) != 0) {
+            printf("%s: darken of %u bytes differs\n", impl.name, num);
+            ++failed;
+        }
+
+        memcpy(&got[0], &xtab[0], num);
+        memcpy(&expected[0], &xtab[0], num);
+        ref.brighten(&expected[0], num);
+        impl.brighten(&got[0], num);
+        if (memcmp(&expected[0], &got[0], num) != 0) {
+            printf("%s: brighten of %u bytes differs\n", impl.name, num);
+            ++failed;
+        }
+    }
+    return failed;
+}
+
+/// the two-dimensional gradients as the kernels see them
+enum Gradient { PYRAMID, RECTANGLE, PIPECROSS, DIAGONAL };
+
+const char *gradientName(Gradient gradient) {
+    switch (gradient) {
+    case PYRAMID: return "pyramid";
+    case RECTANGLE: return "rectangle";
+    case PIPECROSS: return "pipecross";
+    case DIAGONAL: return "diagonal";
+    }
+    return "?";
+}
+
+/// fills the x and y tables the way TextureRender does for 'gradient'
+void makeTables(Gradient gradient, const int from[3], const int to[3],
+                unsigned int width, unsigned int height,
+                std::vector<unsigned int> &xtable,
+                std::vector<unsigned int> &ytable) {
+    xtable.resize(width * 3);
+    ytable.resize(height * 3);
+    for (int c = 0; c < 3; ++c) {
+        float d = (float) (to[c] - from[c]);
+        if (gradient == DIAGONAL) {
+            float dx = d / (width * 2), dy = d / (height * 2);
+            float xv = (float) from[c], yv = 0.0;
+            for (unsigned int x = 0; x < width; ++x, xv += dx)
+                xtable[x * 3 + c] = (unsigned char) xv;
+            for (unsigned int y = 0; y < height; ++y, yv += dy)
+                ytable[y * 3 + c] = (unsigned char) yv;
+        } else {
+            float xv = d / 2, yv = d / 2;
+            for (unsigned int x = 0; x < width; ++x, xv -= d / width)
+                xtable[x * 3 + c] = (unsigned char) ((xv < 0) ? -xv : xv);
+            for (unsigned int y = 0; y < height; ++y, yv -= d / height)
+                ytable[y * 3 + c] = (unsigned char) ((yv < 0) ? -yv : yv);
+        }
+    }
+}
+
+/// the loops TextureRender combined the tables with before the kernels
+void oldCombine(Gradient gradient, bool interlaced, const int to[3],
+                const int sign[3], unsigned int width, unsigned int height,
+                const unsigned int *xtable, const unsigned int *ytable,
+                unsigned char *out[3]) {
+    const unsigned int *yt = ytable;
+    for (unsigned int y = 0; y < height; ++y, yt += 3) {
+        const unsigned int *xt = xtable;
+        for (unsigned int x = 0; x < width; ++x, xt += 3) {
+            for (int c = 0; c < 3; ++c) {
+                // the dark lines of pipecross swapped the green and blue signs
+                int s = sign[c];
+                if (gradient == PIPECROSS && interlaced && (y & 1) && c != 0)
+                    s = sign[3 - c];
+
+                unsigned char channel = 0;
+                switch (gradient) {
+                case PYRAMID:
+                    channel = (unsigned char) (to[c] - (s * (xt[c] + yt[c])));
+                    break;
+                case RECTANGLE:
+                    channel = (unsigned char) (to[c] - (s * std::max(xt[c], yt[c])));
+                    break;
+                case PIPECROSS:
+                    channel = (unsigned char) (to[c] - (s * std::min(xt[c], yt[c])));
+                    break;
+                case DIAGONAL:
+                    channel = xt[c] + yt[c];
+                    break;
+                }
+
+                unsigned char channel2 = channel;
+                if (interlaced && (y & 1)) {
+                    channel2 = (channel >> 1) + (channel >> 2);
+                    if (channel2 > channel) channel2 = 0;
+                } else if (interlaced) {
+                    channel2 = channel + (channel >> 3);
+                    if (channel2 < channel) channel2 = ~0;
+                }
+                out[c][y * width + x] = channel2;
+            }
+        }
+    }
+}
+
+int compareGradients(const GradientKernels::Impl &impl) {
+    // odd widths and the tails behind 16 and 32 byte vectors
+    const unsigned int widths[] = { 1, 7, 15, 16, 17, 31, 33, 63, 100, 257 };
+    const unsigned int heights[] = { 1, 2, 5, 16 };
+    const int colors[][2][3] = {
+        { { 0x20, 0x40, 0x80 }, { 0xe0, 0xc0, 0xa0 } },
+        { { 0xff, 0x00, 0x7f }, { 0x00, 0xff, 0x80 } },
+        { { 0x80, 0x20, 0xc0 }, { 0x40, 0x90, 0x10 } },
+        { { 0x10, 0x10, 0x10 }, { 0x10, 0x10, 0x10 } }
+    };
+    const Gradient gradients[] = { PYRAMID, RECTANGLE, PIPECROSS, DIAGONAL };
+    int failed = 0;
+
+    for (size_t g = 0; g < sizeof(gradients) / sizeof(gradients[0]); ++g)
+    for (size_t col = 0; col < sizeof(colors) / sizeof(colors[0]); ++col)
+    for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); ++w)
+    for (size_t h = 0; h < sizeof(heights) / sizeof(heights[0]); ++h)
+    for (int interlaced = 0; interlaced < 2; ++interlaced) {
+        Gradient gradient = gradients[g];
+        const int *from = colors[col][0], *to = colors[col][1];
+        unsigned int width = widths[w], height = heights[h];
+
+        std::vector<unsigned int> xtable, ytable;
+        makeTables(gradient, from, to, width, height, xtable, ytable);
+
+        // the signs and operations of the render functions
+        int sign[3], odd_sign[3];
+        unsigned int to_rgb[3];
+        for (int c = 0; c < 3; ++c) {
+            int unit = gradient == PYRAMID ? 1 : 2;
+            sign[c] = gradient == DIAGONAL ? 0 : (to[c] - from[c] < 0 ? -unit : unit);
+            to_rgb[c] = gradient == DIAGONAL ? 0 : to[c];
+        }
+        odd_sign[0] = sign[0];
+        odd_sign[1] = gradient == PIPECROSS ? sign[2] : sign[1];
+        odd_sign[2] = gradient == PIPECROSS ? sign[1] : sign[2];
+
+        std::vector<unsigned char> expected(width * height * 3), got(width * height * 3);
+        unsigned char *old_out[3] = {
+            &expected[0], &expected[width * height], &expected[2 * width * height]
+        };
+        oldCombine(gradient, interlaced, to, sign, width, height,
+                   &xtable[0], &ytable[0], old_out);
+
+        std::vector<unsigned char> xplanes(width * 3);
+        for (unsigned int x = 0; x < width; ++x)
+            for (int c = 0; c < 3; ++c)
+                xplanes[c * width + x] = (unsigned char) xtable[x * 3 + c];
+
+        GradientKernels::Tables tables;
+        tables.interlaced = interlaced;
+        tables.width = width;
+        for (int c = 0; c < 3; ++c)
+            tables.out[c] = &got[c * width * height];
+        tables.xplanes = &xplanes[0];
+        tables.ytable = &ytable[0];
+        tables.op = gradient == RECTANGLE ? GradientKernels::MAX :
+            gradient == PIPECROSS ? GradientKernels::MIN : GradientKernels::SUM;
+        tables.to = to_rgb;
+        tables.sign = sign;
+        tables.odd_sign = odd_sign;
+        GradientKernels::combineRows(impl, tables, 0, height);
+
+        if (expected != got) {
+            printf("%s: %s%s gradient %ux%u, colors %u, differs from the old one\n",
+                   impl.name, interlaced ? "interlaced " : "",
+                   gradientName(gradient), width, height, (unsigned int)col);
+            ++failed;
+        }
+    }
+    return failed;
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv) {
+    srand(0);
+
+    const GradientKernels::Impl &scalar = GradientKernels::get(0);
+    int failed = 0;
+    for (unsigned int i = 0; i < GradientKernels::count(); ++i) {
+        const GradientKernels::Impl &impl = GradientKernels::get(i);
+        int num = compareGradients(impl);
+        if (i != 0)
+            num += compare(scalar, impl);
+        printf("%s: %s\n", impl.name, num == 0 ? "ok" : "FAILED");
+        failed += num;
+    }
+    printf("using %s\n", GradientKernels::best().name);
+
+    return failed != 0;
+}
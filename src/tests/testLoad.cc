@@ -0,0 +1,325 @@
+// testLoad.cc for fbtk test suite
+
+// generates load on a running fluxbox for soak tests: round after round it
+// creates client windows, retitles, resizes, focuses, tabs, iconifies and
+// destroys them, at most 'rate' requests per second. after each round it
+// prints one tab separated line with the resident memory of fluxbox, the
+// pixmap memory the X server holds for it and how long fluxbox took to
+// answer _NET_REQUEST_FRAME_EXTENTS after each step, so leaks and
+// slowdowns of long sessions show over time. tabbing needs
+// session.screen0.allowRemoteActions, the pixmap memory the XRes extension:
+//   ./testLoad `pidof fluxbox` 1000 100 2000
+// (pid, windows, rounds, requests per second; 0 for no limit)
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include "FbTk/App.hh"
+#include "testTime.hh"
+
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+#ifdef HAVE_XRES
+#include <X11/extensions/XRes.h>
+#endif // HAVE_XRES
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/select.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+using namespace FbTk;
+
+namespace {
+
+/// windows in a tab group
+const size_t GROUP_SIZE = 4;
+/// how long we wait for fluxbox to answer a probe
+const double PROBE_TIMEOUT = 5.0;
+
+/// sleeps so that we don't send more than 'rate' requests per second
+class Pacer {
+public:
+    Pacer(Display *disp, unsigned long rate):
+        m_disp(disp), m_rate(rate),
+        m_start(now()), m_request(NextRequest(disp)) { }
+
+    void pace() {
+        if (m_rate == 0)
+            return;
+        double due = m_start + double(NextRequest(m_disp) - m_request) / m_rate;
+        double ahead = due - now();
+        if (ahead > 0) {
+            XFlush(m_disp);
+            usleep(static_cast<useconds_t>(ahead * 1000000));
+        }
+    }
+
+private:
+    Display *m_disp;
+    unsigned long m_rate;
+    double m_start;
+    unsigned long m_request;
+};
+
+/// the answers of fluxbox to _NET_REQUEST_FRAME_EXTENTS, in milliseconds
+class Probe {
+public:
+    explicit Probe(Display *disp):
+        m_disp(disp), m_count(0), m_lost(0), m_sum(0), m_max(0) {
+        XSetWindowAttributes attrib;
+        attrib.event_mask = PropertyChangeMask;
+        m_window = XCreateWindow(disp, DefaultRootWindow(disp), 0, 0, 1, 1, 0,
+                                 CopyFromParent, InputOnly, CopyFromParent,
+                                 CWEventMask, &attrib);
+        m_request = XInternAtom(disp, "_NET_REQUEST_FRAME_EXTENTS", False);
+        m_extents = XInternAtom(disp, "_NET_FRAME_EXTENTS", False);
+    }
+
+    ~Probe() { XDestroyWindow(m_disp, m_window); }
+
+    /// sends a request and waits for the answer
+    void run() {
+        XDeleteProperty(m_disp, m_window, m_extents);
+        XSync(m_disp, False);
+        discard();
+
+        XEvent ce;
+        memset(&ce, 0, sizeof(ce));
+        ce.xclient.type = ClientMessage;
+        ce.xclient.window = m_window;
+        ce.xclient.message_type = m_request;
+        ce.xclient.format = 32;
+        double start = now();
+        XSendEvent(m_disp, DefaultRootWindow(m_disp), False,
+                   SubstructureRedirectMask | SubstructureNotifyMask, &ce);
+        XFlush(m_disp);
+
+        const int fd = ConnectionNumber(m_disp);
+        while (now() - start < PROBE_TIMEOUT) {
+            XEvent event;
+            while (XCheckTypedWindowEvent(m_disp, m_window, PropertyNotify, &event)) {
+                if (event.xproperty.atom == m_extents &&
+                    event.xproperty.state == PropertyNewValue) {
+                    double ms = (now() - start) * 1000;
+                    ++m_count;
+                    m_sum += ms;
+                    if (ms > m_max)
+                        m_max = ms;
+                    return;
+                }
+            }
+            fd_set fds;
+            FD_ZERO(&fds);
+            FD_SET(fd, &fds);
+            timeval tv = { 0, 10000 };
+            select(fd + 1, &fds, 0, 0, &tv);
+            XEventsQueued(m_disp, QueuedAfterReading);
+        }
+        ++m_lost;
+    }
+
+    /// starts a new round of measurements
+    void reset() { m_count = m_lost = 0; m_sum = m_max = 0; }
+
+    double average() const { return m_count ? m_sum / m_count : 0; }
+    double max() const { return m_max; }
+    unsigned int lost() const { return m_lost; }
+
+private:
+    /// drops the events of our client windows, we only want the probe's
+    void discard() {
+        XEvent event;
+        while (XPending(m_disp))
+            XNextEvent(m_disp, &event);
+    }
+
+    Display *m_disp;
+    Window m_window;
+    Atom m_request, m_extents;
+    unsigned int m_count, m_lost;
+    double m_sum, m_max;
+};
+
+/// @return resident memory of 'pid' in KB, 0 if we can't tell
+unsigned long residentKB(int pid) {
+    if (pid <= 0)
+        return 0;
+
+    char filename[64];
+    snprintf(filename, sizeof(filename), "/proc/%d/statm", pid);
+    FILE *file = fopen(filename, "r");
+    if (file == 0)
+        return 0;
+
+    unsigned long size = 0, resident = 0;
+    if (fscanf(file, "%lu %lu", &size, &resident) != 2)
+        resident = 0;
+    fclose(file);
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/// @return the window fluxbox names in _NET_SUPPORTING_WM_CHECK
+Window wmCheckWindow(Display *disp) {
+    Atom check = XInternAtom(disp, "_NET_SUPPORTING_WM_CHECK", False);
+    Atom type;
+    int format;
+    unsigned long nitems, bytes_after;
+    unsigned char *data = 0;
+    Window win = None;
+    if (XGetWindowProperty(disp, DefaultRootWindow(disp), check, 0, 1, False,
+                           XA_WINDOW, &type, &format, &nitems, &bytes_after,
+                           &data) == Success && data) {
+        if (nitems == 1)
+            win = *reinterpret_cast<Window *>(data);
+        XFree(data);
+    }
+    return win;
+}
+
+/// @return the pixmap memory of the client that created 'win' in KB,
+///         -1 if the server can't tell
+long pixmapKB(Display *disp, Window win) {
+#ifdef HAVE_XRES
+    int event_base, error_base;
+    unsigned long bytes = 0;
+    if (win != None && XResQueryExtension(disp, &event_base, &error_base) &&
+        XResQueryClientPixmapBytes(disp, win, &bytes))
+        return bytes / 1024;
+#endif // HAVE_XRES
+    return -1;
+}
+
+void sendMessage(Display *disp, Window win, Atom type, long data0) {
+    XEvent ce;
+    memset(&ce, 0, sizeof(ce));
+    ce.xclient.type = ClientMessage;
+    ce.xclient.window = win;
+    ce.xclient.message_type = type;
+    ce.xclient.format = 32;
+    ce.xclient.data.l[0] = data0;
+    ce.xclient.data.l[1] = CurrentTime;
+    XSendEvent(disp, DefaultRootWindow(disp), False,
+               SubstructureRedirectMask | SubstructureNotifyMask, &ce);
+}
+
+/// runs a fluxbox command, if it allows remote actions
+void fluxboxAction(Display *disp, const std::string &command) {
+    Atom action = XInternAtom(disp, "_FLUXBOX_ACTION", False);
+    XChangeProperty(disp, DefaultRootWindow(disp), action, XA_STRING, 8,
+                    PropModeReplace,
+                    reinterpret_cast<const unsigned char *>(command.c_str()),
+                    command.size());
+}
+
+Window createClient(Display *disp, size_t index, int round) {
+    int screen = DefaultScreen(disp);
+    Window win = XCreateSimpleWindow(disp, RootWindow(disp, screen),
+                                     (index * 37) % 800, (index * 23) % 600,
+                                     200 + index % 100, 150 + index % 80, 0,
+                                     BlackPixel(disp, screen),
+                                     WhitePixel(disp, screen));
+
+    // the class names the tab group
+    char name[32], group[32];
+    snprintf(name, sizeof(name), "load%lu", (unsigned long)index);
+    snprintf(group, sizeof(group), "LoadTab%lu", (unsigned long)(index / GROUP_SIZE));
+    XClassHint class_hint;
+    class_hint.res_name = name;
+    class_hint.res_class = group;
+    XSetClassHint(disp, win, &class_hint);
+
+    char title[64];
+    snprintf(title, sizeof(title), "testLoad %d.%lu", round, (unsigned long)index);
+    XStoreName(disp, win, title);
+    XMapWindow(disp, win);
+    return win;
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <fluxbox pid> [windows] [rounds] [requests/s]\n",
+                argv[0]);
+        return 1;
+    }
+    int pid = atoi(argv[1]);
+    size_t windows = argc > 2 ? atol(argv[2]) : 1000;
+    int rounds = argc > 3 ? atoi(argv[3]) : 10;
+    unsigned long rate = argc > 4 ? atol(argv[4]) : 0;
+
+    App app;
+    Display *disp = app.display();
+    Window wm_check = wmCheckWindow(disp);
+    if (wm_check == None) {
+        printf("# no window manager with _NET_SUPPORTING_WM_CHECK is running\n");
+        return 1;
+    }
+    Atom active = XInternAtom(disp, "_NET_ACTIVE_WINDOW", False);
+
+    Probe probe(disp);
+    std::vector<Window> clients(windows);
+    std::string titles[] = { "", ">>", std::string(32, '>'), std::string(256, '>') };
+    const double start = now();
+
+    printf("# %lu windows, %lu requests/s\n", (unsigned long)windows, rate);
+    printf("# round\tseconds\trequests\tresident KB\tpixmap KB\t"
+           "latency ms\tmax latency ms\tlost probes\n");
+    printf("0\t0.0\t0\t%lu\t%ld\t-\t-\t-\n", residentKB(pid), pixmapKB(disp, wm_check));
+    fflush(stdout);
+
+    for (int round = 1; round <= rounds; ++round) {
+        Pacer pacer(disp, rate);
+        const unsigned long first_request = NextRequest(disp);
+        probe.reset();
+
+        for (size_t i = 0; i < windows; ++i, pacer.pace())
+            clients[i] = createClient(disp, i, round);
+        probe.run();
+
+        for (size_t i = 0; i < windows; ++i, pacer.pace()) {
+            std::string title = titles[(i + round) % 4] + " testLoad";
+            XStoreName(disp, clients[i], title.c_str());
+        }
+        probe.run();
+
+        for (size_t i = 0; i < windows; ++i, pacer.pace())
+            XResizeWindow(disp, clients[i], 100 + (i * round) % 400,
+                          80 + (i * round) % 300);
+        probe.run();
+
+        for (size_t i = 0; i < windows; ++i, pacer.pace())
+            sendMessage(disp, clients[i], active, 2); // from a pager
+        probe.run();
+
+        for (size_t i = 0; i < windows; i += GROUP_SIZE, pacer.pace()) {
+            char command[64];
+            snprintf(command, sizeof(command), "Attach (class=LoadTab%lu)",
+                     (unsigned long)(i / GROUP_SIZE));
+            fluxboxAction(disp, command);
+        }
+        probe.run();
+
+        for (size_t i = 0; i < windows; ++i, pacer.pace())
+            XIconifyWindow(disp, clients[i], DefaultScreen(disp));
+        probe.run();
+
+        for (size_t i = 0; i < windows; ++i, pacer.pace())
+            XDestroyWindow(disp, clients[i]);
+        probe.run();
+
+        printf("%d\t%.1f\t%lu\t%lu\t%ld\t%.2f\t%.2f\t%u\n", round, now() - start,
+               NextRequest(disp) - first_request,
+               residentKB(pid), pixmapKB(disp, wm_check),
+               probe.average(), probe.max(), probe.lost());
+        fflush(stdout);
+    }
+
+    return 0;
+}
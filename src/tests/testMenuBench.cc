@@ -0,0 +1,168 @@
+// testMenuBench.cc for fbtk test suite
+
+// builds menus of 10 to 5000 items, lays them out, shows them until the
+// first expose is drawn, hides and destroys them, and prints the time and
+// the allocations of each step, one tab separated line each. the numbers
+// of FbTk::Menu::stats() are those the DumpStats command writes.
+// needs an X display, Xvfb will do:
+//   xvfb-run ./testMenuBench 5 10 100 1000 5000
+
+#include "FbTk/App.hh"
+#include "FbTk/EventManager.hh"
+#include "FbTk/ImageControl.hh"
+#include "FbTk/Menu.hh"
+#include "FbTk/MenuTheme.hh"
+#include "testTime.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+using namespace FbTk;
+
+namespace {
+
+unsigned long s_allocs = 0;
+
+/// the time and allocations of one step, summed over the runs
+struct Step {
+    Step(): seconds(0), allocs(0) { }
+    const char *name;
+    double seconds;
+    unsigned long allocs;
+};
+
+class Measure {
+public:
+    explicit Measure(Step &step): m_step(step), m_start(now()), m_allocs(s_allocs) { }
+    ~Measure() {
+        m_step.seconds += now() - m_start;
+        m_step.allocs += s_allocs - m_allocs;
+    }
+private:
+    Step &m_step;
+    double m_start;
+    unsigned long m_allocs;
+};
+
+/// handles events until the menu drew its first expose after show()
+void waitForExpose(Display *disp) {
+    unsigned long exposes = Menu::stats().expose.count;
+    XSync(disp, False);
+    while (Menu::stats().expose.count == exposes) {
+        XEvent event;
+        XNextEvent(disp, &event);
+        EventManager::instance()->handleEvent(event);
+    }
+}
+
+} // anonymous namespace
+
+// counts the allocations; the exception specifications changed with C++11
+#if __cplusplus >= 201103L
+#define BENCH_THROW_BAD_ALLOC
+#define BENCH_THROW_NOTHING noexcept
+#else
+#define BENCH_THROW_BAD_ALLOC throw (std::bad_alloc)
+#define BENCH_THROW_NOTHING throw ()
+#endif
+
+void *operator new(size_t size) BENCH_THROW_BAD_ALLOC {
+    ++s_allocs;
+    void *p = malloc(size ? size : 1);
+    if (p == 0)
+        throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t size) BENCH_THROW_BAD_ALLOC {
+    return operator new(size);
+}
+
+void operator delete(void *p) BENCH_THROW_NOTHING {
+    free(p);
+}
+
+void operator delete[](void *p) BENCH_THROW_NOTHING {
+    free(p);
+}
+
+int main(int argc, char **argv) {
+
+    int runs = 5;
+    if (argc > 1)
+        runs = atoi(argv[1]);
+
+    std::vector<unsigned int> sizes;
+    for (int i = 2; i < argc; ++i)
+        sizes.push_back(atoi(argv[i]));
+    if (sizes.empty()) {
+        sizes.push_back(10);
+        sizes.push_back(100);
+        sizes.push_back(1000);
+        sizes.push_back(5000);
+    }
+
+    App app;
+    Display *disp = app.display();
+    ImageControl imgctrl(DefaultScreen(disp));
+    MenuTheme theme(DefaultScreen(disp));
+    // like session.screen0.menuMaxColumns
+    theme.setMaxColumns(3);
+
+    printf("# items\tstep\truns\tms/run\tallocs/run\n");
+
+    for (size_t s = 0; s < sizes.size(); ++s) {
+        Step steps[5];
+        steps[0].name = "insert";
+        steps[1].name = "updateMenu";
+        steps[2].name = "show to expose";
+        steps[3].name = "hide";
+        steps[4].name = "destroy";
+
+        char label[64];
+        for (int r = 0; r < runs; ++r) {
+            Menu *menu = new Menu(theme, imgctrl);
+            menu->setLabel(BiDiString("bench"));
+            {
+                Measure measure(steps[0]);
+                for (unsigned int i = 0; i < sizes[s]; ++i) {
+                    sprintf(label, "menu item %u", i);
+                    menu->insert(label);
+                }
+            }
+            {
+                Measure measure(steps[1]);
+                menu->updateMenu();
+            }
+            {
+                Measure measure(steps[2]);
+                menu->show();
+                waitForExpose(disp);
+            }
+            {
+                Measure measure(steps[3]);
+                menu->hide(true);
+                XSync(disp, False);
+            }
+            {
+                Measure measure(steps[4]);
+                delete menu;
+            }
+        }
+
+        for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); ++i)
+            printf("%u\t%s\t%d\t%.3f\t%.0f\n", sizes[s], steps[i].name, runs,
+                   steps[i].seconds * 1000 / runs,
+                   (double)steps[i].allocs / runs);
+    }
+
+    const Menu::Stats &stats = Menu::stats();
+    printf("# renderForeground: %lu calls, %.3f ms average\n",
+           stats.render.count,
+           stats.render.count ?
+           stats.render.total / 1000.0 / stats.render.count : 0.0);
+
+    return 0;
+}
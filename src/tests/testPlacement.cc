@@ -0,0 +1,263 @@
+// testPlacement.cc for fluxbox test suite
+
+// benchmark for the window placement strategies: places windows into
+// synthetic window sets (random, tiled, cascaded and two heads with struts)
+// and prints the time per placement and the area the placed windows
+// overlap as a measure of quality.
+// the smart and min overlap placements run on WindowCoverage like they do
+// in fluxbox, cascade and under mouse only do a few sums and are repeated
+// here, so no X server is needed.
+
+#include "WindowCoverage.hh"
+#include "RectangleUtil.hh"
+#include "testTime.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+struct Rect {
+    int x() const { return m_x; }
+    int y() const { return m_y; }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+
+    int m_x, m_y, m_width, m_height;
+};
+
+/// a head with its struts already taken off, like BScreen::maxLeft() etc.
+struct Head {
+    int left, top, right, bottom;
+};
+
+struct Scene {
+    const char *name;
+    std::vector<Head> heads;
+    std::vector<Rect> windows;
+};
+
+enum Strategy {
+    ROWSMART,
+    COLSMART,
+    ROWMINOVERLAP,
+    COLMINOVERLAP,
+    CASCADE,
+    UNDERMOUSE,
+    NUM_STRATEGIES
+};
+
+const char *strategy_names[NUM_STRATEGIES] = {
+    "RowSmart", "ColSmart", "RowMinOverlap", "ColMinOverlap",
+    "Cascade", "UnderMouse"
+};
+
+// like a titlebar plus one border
+const int CASCADE_STEP = 19;
+
+Rect randomRect(const Head &head) {
+    Rect r;
+    r.m_width = 200 + rand() % 700;
+    r.m_height = 150 + rand() % 550;
+    r.m_x = head.left + rand() % (head.right - head.left - r.m_width / 2);
+    r.m_y = head.top + rand() % (head.bottom - head.top - r.m_height / 2);
+    return r;
+}
+
+Head makeHead(int x, int y, int width, int height,
+              int strut_left, int strut_top, int strut_right, int strut_bottom) {
+    Head head = { x + strut_left, y + strut_top,
+                  x + width - strut_right, y + height - strut_bottom };
+    return head;
+}
+
+void makeScenes(std::vector<Scene> &scenes, size_t num) {
+
+    const Head screen = makeHead(0, 0, 1920, 1080, 0, 0, 0, 0);
+
+    Scene random;
+    random.name = "random";
+    random.heads.push_back(screen);
+    for (size_t i = 0; i < num; ++i)
+        random.windows.push_back(randomRect(screen));
+    scenes.push_back(random);
+
+    // the screen is full, so the smart placements fall back to cascade
+    Scene tiled;
+    tiled.name = "tiled";
+    tiled.heads.push_back(screen);
+    int cols = 1;
+    while ((size_t)(cols * cols) < num)
+        ++cols;
+    int rows = (num + cols - 1) / cols;
+    for (size_t i = 0; i < num; ++i) {
+        Rect r = { (int)(i % cols) * 1920 / cols, (int)(i / cols) * 1080 / rows,
+                   1920 / cols, 1080 / rows };
+        tiled.windows.push_back(r);
+    }
+    scenes.push_back(tiled);
+
+    Scene cascaded;
+    cascaded.name = "cascaded";
+    cascaded.heads.push_back(screen);
+    for (size_t i = 0; i < num; ++i) {
+        int step = (i * CASCADE_STEP) % 540;
+        Rect r = { step, step, 800, 500 };
+        cascaded.windows.push_back(r);
+    }
+    scenes.push_back(cascaded);
+
+    // a toolbar at the bottom of the first head, the slit on the right of
+    // the second one
+    Scene multihead;
+    multihead.name = "multihead";
+    multihead.heads.push_back(makeHead(0, 0, 1920, 1080, 0, 0, 0, 24));
+    multihead.heads.push_back(makeHead(1920, 0, 1280, 1024, 0, 0, 64, 0));
+    for (size_t i = 0; i < num; ++i)
+        multihead.windows.push_back(randomRect(multihead.heads[i % 2]));
+    scenes.push_back(multihead);
+}
+
+/// the placement of ScreenPlacement::placeWindow, without decorations
+void place(Strategy strategy, const std::vector<Rect> &windows,
+           const Head &head, int width, int height,
+           int &cascade_x, int &cascade_y, int &x, int &y) {
+
+    WindowCoverage coverage;
+    if (strategy != CASCADE && strategy != UNDERMOUSE) {
+        for (size_t i = 0; i < windows.size(); ++i) {
+            const Rect &w = windows[i];
+            coverage.add(0, w.m_x, w.m_y, w.m_x + w.m_width, w.m_y + w.m_height);
+        }
+        coverage.build();
+    }
+
+    bool placed = true;
+    x = head.left;
+    y = head.top;
+
+    switch (strategy) {
+    case ROWSMART:
+    case COLSMART:
+        placed = coverage.findFree(width, height,
+                                   head.left, head.top, head.right, head.bottom,
+                                   strategy == ROWSMART, true, true, x, y);
+        break;
+    case ROWMINOVERLAP:
+    case COLMINOVERLAP:
+        coverage.findMinOverlap(width, height,
+                                head.left, head.top, head.right, head.bottom,
+                                strategy == ROWMINOVERLAP, true, true, 0, x, y);
+        break;
+    case CASCADE:
+        placed = false;
+        break;
+    case UNDERMOUSE: {
+        int mouse_x = head.left + rand() % (head.right - head.left);
+        int mouse_y = head.top + rand() % (head.bottom - head.top);
+        x = mouse_x - width / 2;
+        y = mouse_y - height / 2;
+        if (x < head.left)
+            x = head.left;
+        if (x + width > head.right)
+            x = head.right - width;
+        if (y < head.top)
+            y = head.top;
+        if (y + height > head.bottom)
+            y = head.bottom - height;
+        break;
+    }
+    default:
+        break;
+    }
+
+    // CascadePlacement, also the fallback of the other strategies
+    if (!placed) {
+        if (cascade_x > (head.left + head.right) / 2)
+            cascade_x = head.left;
+        if (cascade_y > (head.top + head.bottom) / 2)
+            cascade_y = head.top;
+        x = cascade_x;
+        y = cascade_y;
+        cascade_x += CASCADE_STEP;
+        cascade_y += CASCADE_STEP;
+    }
+
+    if (x + width > head.right)
+        x = head.left + (head.right - head.left - width) / 2;
+    if (y + height > head.bottom)
+        y = head.top + (head.bottom - head.top - height) / 2;
+}
+
+}
+
+int main(int argc, char **argv) {
+
+    size_t num = 20;
+    if (argc > 1)
+        num = atoi(argv[1]);
+    const size_t num_placed = 50;
+    int errors = 0;
+
+    srand(0);
+    std::vector<Scene> scenes;
+    makeScenes(scenes, num);
+
+    // the same new windows for every strategy
+    std::vector<Rect> sizes(num_placed);
+    for (size_t i = 0; i < num_placed; ++i) {
+        sizes[i].m_width = 300 + rand() % 500;
+        sizes[i].m_height = 200 + rand() % 400;
+    }
+
+    printf("%lu windows, placing %lu more\n",
+           (unsigned long)num, (unsigned long)num_placed);
+
+    for (size_t s = 0; s < scenes.size(); ++s) {
+        const Scene &scene = scenes[s];
+        printf("%s:\n", scene.name);
+
+        for (int strategy = 0; strategy < NUM_STRATEGIES; ++strategy) {
+            std::vector<Rect> windows = scene.windows;
+            std::vector<int> cascade_x, cascade_y;
+            for (size_t h = 0; h < scene.heads.size(); ++h) {
+                cascade_x.push_back(scene.heads[h].right);
+                cascade_y.push_back(scene.heads[h].bottom);
+            }
+
+            double time = 0;
+            long long overlap = 0, area = 0;
+            srand(1);
+            for (size_t i = 0; i < num_placed; ++i) {
+                size_t h = i % scene.heads.size();
+                const Head &head = scene.heads[h];
+                Rect r = sizes[i];
+
+                double start = now();
+                place((Strategy)strategy, windows, head, r.m_width, r.m_height,
+                      cascade_x[h], cascade_y[h], r.m_x, r.m_y);
+                time += now() - start;
+
+                if (r.m_x < head.left || r.m_y < head.top ||
+                    r.m_x + r.m_width > head.right ||
+                    r.m_y + r.m_height > head.bottom) {
+                    printf("  %s placed window %lu outside its head\n",
+                           strategy_names[strategy], (unsigned long)i);
+                    ++errors;
+                }
+
+                for (size_t j = 0; j < windows.size(); ++j)
+                    overlap += RectangleUtil::overlapArea(r, windows[j]);
+                area += (long long)r.m_width * r.m_height;
+                windows.push_back(r);
+            }
+
+            printf("  %-14s %8.3f ms/window, overlap %7.1f%% of the placed area\n",
+                   strategy_names[strategy], time * 1000 / num_placed,
+                   overlap * 100.0 / area);
+        }
+    }
+
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -109,11 +109,49 @@ int test_overlapRectangles() {
     return 0;
 }
 
+int test_overlapArea() {
+
+    printf("testing RectangleUtil::overlapArea()\n");
+
+    struct _t {
+        struct Rect a;
+        struct Rect b;
+        long long truth;
+    };
+
+    const _t tests[] = {
+        { { 0, 0, 8, 8 }, {  0, 0, 8, 8 }, 64 }, // b equals a
+        { { 0, 0, 8, 8 }, {  3, 3, 3, 3 },  9 }, // b completely inside a
+        { { 0, 0, 8, 8 }, {  4, 4, 8, 8 }, 16 }, // b overlaps a in one corner
+        { { 0, 0, 8, 8 }, {  8, 0, 8, 8 },  0 }, // b touches a
+        { { 0, 0, 8, 8 }, { -8, 0, 5, 8 },  0 }, // b completely left from a
+    };
+
+    for (unsigned int i = 0; i < sizeof(tests)/sizeof(_t); ++i) {
+        const _t& t = tests[i];
+        long long ab = RectangleUtil::overlapArea(t.a, t.b);
+        long long ba = RectangleUtil::overlapArea(t.b, t.a);
+
+        printf("  %u: [%2d %2d]-[%2d %2d] and [%2d %2d]-[%2d %2d] share %lld: %s\n",
+                i,
+                t.a.x(), t.a.y(),
+                t.a.x() + (int)t.a.width(), t.a.y() + (int)t.a.height(),
+                t.b.x(), t.b.y(),
+                t.b.x() + (int)t.b.width(), t.b.y() + (int)t.b.height(),
+                ab, ab == t.truth && ba == t.truth ? "ok" : "failed");
+    }
+
+    printf("done.\n");
+
+    return 0;
+}
+
 
 int main(int argc, char **argv) {
 
     test_insideBorder();
     test_overlapRectangles();
+    test_overlapArea();
 
     return 0;
 }
@@ -0,0 +1,141 @@
+// testRefCount.cc for fbtk test suite
+
+// counts the allocations and the time of creating and copying RefCounts:
+// empty ones, ones with a counter of their own and ones to RefCounted
+// objects like commands, and of connecting slots to a signal. prints one
+// tab separated line each, and checks that every object is deleted once:
+//   ./testRefCount 1000000
+
+#include "FbTk/Command.hh"
+#include "FbTk/RefCount.hh"
+#include "FbTk/Signal.hh"
+#include "testTime.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+using namespace FbTk;
+
+namespace {
+
+unsigned long s_allocations = 0;
+int s_objects = 0;
+
+/// an object with a separate counter
+struct Plain {
+    Plain() { ++s_objects; }
+    ~Plain() { --s_objects; }
+};
+
+/// an object that counts itself
+class NoOp: public Command<void> {
+public:
+    NoOp() { ++s_objects; }
+    ~NoOp() { --s_objects; }
+    void execute() { }
+};
+
+void slot() { }
+
+class Measure {
+public:
+    Measure(const char *name, unsigned long count):
+        m_name(name), m_count(count),
+        m_allocations(s_allocations), m_start(now()) { }
+    ~Measure() {
+        double seconds = now() - m_start;
+        printf("%s\t%lu\t%.2f\t%.1f\n", m_name, m_count,
+               double(s_allocations - m_allocations) / m_count,
+               seconds * 1e9 / m_count);
+    }
+private:
+    const char *m_name;
+    unsigned long m_count, m_allocations;
+    double m_start;
+};
+
+template <typename T>
+void copies(const char *name, const RefCount<T> &ref, unsigned long count) {
+    Measure measure(name, count);
+    for (unsigned long i = 0; i < count; ++i) {
+        RefCount<T> copy(ref);
+        RefCount<T> other;
+        other = copy;
+    }
+}
+
+} // anonymous namespace
+
+#if __cplusplus < 201103L
+#define THROWS_BAD_ALLOC throw (std::bad_alloc)
+#define THROWS_NOTHING throw ()
+#else
+#define THROWS_BAD_ALLOC
+#define THROWS_NOTHING noexcept
+#endif
+
+void *operator new(size_t size) THROWS_BAD_ALLOC {
+    ++s_allocations;
+    void *p = malloc(size ? size : 1);
+    if (p == 0)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) THROWS_NOTHING {
+    free(p);
+}
+
+void operator delete(void *p, size_t) THROWS_NOTHING {
+    free(p);
+}
+
+int main(int argc, char **argv) {
+    unsigned long count = argc > 1 ? atol(argv[1]) : 1000000;
+
+    printf("# what\tcount\tallocations/each\tns/each\n");
+    {
+        std::vector<RefCount<Plain> > refs;
+        refs.reserve(count);
+        Measure measure("empty", count);
+        for (unsigned long i = 0; i < count; ++i)
+            refs.push_back(RefCount<Plain>());
+    }
+    {
+        Measure measure("plain", count);
+        for (unsigned long i = 0; i < count; ++i)
+            RefCount<Plain> ref(new Plain);
+    }
+    {
+        Measure measure("counted", count);
+        for (unsigned long i = 0; i < count; ++i)
+            RefCount<Command<void> > ref(new NoOp);
+    }
+    copies("plain copy", RefCount<Plain>(new Plain), count);
+    copies("counted copy", RefCount<Command<void> >(new NoOp), count);
+    {
+        Signal<> signal;
+        Measure measure("connect", count);
+        for (unsigned long i = 0; i < count; ++i)
+            signal.disconnect(signal.connect(&slot));
+    }
+
+    // a RefCount made from another's pointer shares its count
+    NoOp *noop = new NoOp;
+    RefCount<Command<void> > a(noop);
+    RefCount<NoOp> b(noop);
+    a.reset();
+    if (s_objects != 1 || b.useCount() != 1) {
+        printf("# the counter of the command isn't shared\n");
+        return 1;
+    }
+    b.reset();
+
+    if (s_objects != 0) {
+        printf("# %d objects weren't deleted\n", s_objects);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+// testRegExpBench.cc for fbtk test suite
+
+// checks FbTk::RegExp against regexec on patterns as they appear in apps
+// files and window titles and classes to match them to, and times both.
+// literal patterns take the string compare fast paths, the others show the
+// cost of regexec for comparison.
+
+#include "FbTk/RegExp.hh"
+#include "testTime.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include <regex.h>
+
+namespace {
+
+const char *patterns[] = {
+    "xterm", "Firefox", "Navigator", "[Ff]irefox", "[Gg]imp", "URxvt",
+    "Gimp.*", ".*Mozilla Firefox", ".*- Vim", ".*mail.*", "^Thunder",
+    "bird$", "a\\.out", "",
+    "(xterm|urxvt)", "[a-z]+term", "Gimp-[0-9.]+", "gimp.*(toolbox|dock)"
+};
+
+const char *texts[] = {
+    "xterm", "XTerm", "Firefox", "firefox", "Navigator", "URxvt", "urxvt",
+    "Gimp-2.8", "gimp-toolbox", "gimp-dock", "Thunderbird", "a.out", "aXout",
+    "Mozilla Firefox", "Fluxbox - Mozilla Firefox", "main.cc - Vim",
+    "Inbox - Thunderbird mail", "",
+    "a rather long window title of some web page - Mozilla Firefox"
+};
+
+}
+
+int main(int argc, char **argv) {
+
+    const size_t num_patterns = sizeof(patterns) / sizeof(patterns[0]);
+    const size_t num_texts = sizeof(texts) / sizeof(texts[0]);
+    const int rounds = argc > 1 ? atoi(argv[1]) : 10000;
+    int errors = 0;
+
+    std::vector<std::string> strings(texts, texts + num_texts);
+
+    for (size_t p = 0; p < num_patterns; ++p) {
+        FbTk::RegExp regexp(patterns[p], true);
+
+        // what the patterns used to be matched with
+        std::string anchored = std::string("^") + patterns[p] + "$";
+        regex_t regex;
+        if (regcomp(&regex, anchored.c_str(), REG_NOSUB | REG_EXTENDED) != 0) {
+            printf("can't compile '%s'\n", patterns[p]);
+            ++errors;
+            continue;
+        }
+
+        for (size_t t = 0; t < num_texts; ++t) {
+            bool expected = regexec(&regex, texts[t], 0, 0, 0) == 0;
+            if (regexp.match(strings[t]) != expected) {
+                printf("'%s' %s '%s'\n", patterns[p],
+                       expected ? "doesn't match" : "matches", texts[t]);
+                ++errors;
+            }
+        }
+
+        int matches = 0;
+        double start = now();
+        for (int r = 0; r < rounds; ++r)
+            for (size_t t = 0; t < num_texts; ++t)
+                matches += regexec(&regex, texts[t], 0, 0, 0) == 0;
+        double regexec_time = now() - start;
+
+        start = now();
+        for (int r = 0; r < rounds; ++r)
+            for (size_t t = 0; t < num_texts; ++t)
+                matches -= regexp.match(strings[t]);
+        double regexp_time = now() - start;
+
+        regfree(&regex);
+
+        printf("%-22s regexec %8.1f ns, RegExp %8.1f ns per match%s\n",
+               anchored.c_str(),
+               regexec_time * 1e9 / (rounds * num_texts),
+               regexp_time * 1e9 / (rounds * num_texts),
+               matches ? " (counts differ)" : "");
+    }
+
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
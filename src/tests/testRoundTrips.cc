@@ -0,0 +1,80 @@
+// testRoundTrips.cc for fbtk test suite
+
+// checks that common window operations stay within a budget of
+// synchronous requests (round-trips) to the X server
+
+#include "FbTk/App.hh"
+#include "FbTk/FbWindow.hh"
+#include "FbTk/RoundTrips.hh"
+
+#include <X11/Xlib.h>
+
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+struct Budget {
+    const char *operation;
+    unsigned long allowed;
+};
+
+int failed = 0;
+
+void check(const Budget &budget) {
+    FbTk::RoundTrips &trips = FbTk::RoundTrips::instance();
+    unsigned long used = trips.total();
+    cout<<budget.operation<<": "<<used<<" round-trips (budget "<<budget.allowed<<")";
+    if (used > budget.allowed) {
+        cout<<" FAILED"<<endl;
+        trips.dump(cout);
+        ++failed;
+    } else
+        cout<<endl;
+    trips.reset();
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv) {
+    string displayname("");
+    for (int a = 1; a < argc; ++a) {
+        if (string("-display") == argv[a] && a + 1 < argc)
+            displayname = argv[++a];
+    }
+
+    try {
+        FbTk::App app(displayname.c_str());
+        FbTk::FbWindow win(DefaultScreen(app.display()), 0, 0, 100, 100,
+                           ExposureMask | FocusChangeMask);
+        app.sync(false);
+        FbTk::RoundTrips::instance().reset();
+
+        const Budget map = { "map", 0 };
+        win.show();
+        win.raise();
+        check(map);
+
+        const Budget move = { "move", 0 };
+        for (int i = 0; i < 100; ++i)
+            win.moveResize(i, i, 100 + i, 100 + i);
+        check(move);
+
+        const Budget focus = { "focus", 0 };
+        win.setInputFocus(RevertToParent, CurrentTime);
+        check(focus);
+
+        // the explicit sync must be counted
+        const Budget sync = { "sync", 1 };
+        app.sync(false);
+        check(sync);
+
+    } catch (const string &error) {
+        cerr<<error<<endl;
+        return 1;
+    }
+
+    return failed;
+}
@@ -0,0 +1,520 @@
+// testSessionBench.cc for fbtk test suite
+
+// an end-to-end benchmark: starts Xvfb and fluxbox on it with a fixed
+// config and style, and drives scenarios as a client: adopting 500
+// windows, switching through 10 workspaces, alt-tabbing through 200
+// windows, dragging windows to the screen edge where they snap, changing
+// the style and restarting. prints one tab separated line per scenario
+// with the wall time, the requests and round-trips of fluxbox (from
+// DumpStats) and the cpu time fluxbox used. without XTest, alt-tab runs
+// NextWindow through _FLUXBOX_ACTION and there is no drag scenario:
+//   ./testSessionBench ../fluxbox ../../data/styles/Emerge ../../data/styles/Flux
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include "FbTk/App.hh"
+#include "testTime.hh"
+
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+#ifdef HAVE_XTEST
+#include <X11/extensions/XTest.h>
+#endif // HAVE_XTEST
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/select.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace FbTk;
+using std::string;
+using std::vector;
+
+namespace {
+
+const size_t WINDOWS = 500;
+/// the windows on the first workspace, the others share the rest
+const size_t FIRST_WORKSPACE_WINDOWS = 200;
+const int WORKSPACES = 10;
+const int WORKSPACE_CYCLES = 5;
+const int ALT_TABS = 200;
+const size_t DRAGS = 20;
+const int STYLE_CHANGES = 10;
+/// how long we wait for fluxbox
+const double TIMEOUT = 10.0;
+
+/// starts 'args' with its output going to 'log' and HOME set to 'home'
+pid_t spawn(const vector<string> &args, const string &home, const string &log) {
+    pid_t pid = fork();
+    if (pid != 0)
+        return pid;
+
+    if (!home.empty())
+        setenv("HOME", home.c_str(), 1);
+    int fd = open(log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0) {
+        dup2(fd, 1);
+        dup2(fd, 2);
+        close(fd);
+    }
+    vector<char *> argv;
+    for (size_t i = 0; i < args.size(); ++i)
+        argv.push_back(const_cast<char *>(args[i].c_str()));
+    argv.push_back(0);
+    execvp(argv[0], &argv[0]);
+    _exit(127);
+}
+
+void stop(pid_t pid) {
+    if (pid <= 0)
+        return;
+    kill(pid, SIGTERM);
+    waitpid(pid, 0, 0);
+}
+
+/// starts Xvfb on a free display, @return its name, empty on failure
+string startXvfb(const string &dir, pid_t &pid) {
+    int fds[2];
+    if (pipe(fds) != 0)
+        return "";
+
+    char fd[16];
+    snprintf(fd, sizeof(fd), "%d", fds[1]);
+    vector<string> args;
+    args.push_back("Xvfb");
+    args.push_back("-displayfd");
+    args.push_back(fd);
+    args.push_back("-screen");
+    args.push_back("0");
+    args.push_back("1280x1024x24");
+    args.push_back("-nolisten");
+    args.push_back("tcp");
+    pid = spawn(args, "", dir + "/Xvfb.log");
+    close(fds[1]);
+
+    // Xvfb writes the display number once it accepts connections
+    string number;
+    char c;
+    while (read(fds[0], &c, 1) == 1 && c != '\n')
+        number += c;
+    close(fds[0]);
+    return number.empty() ? "" : ":" + number;
+}
+
+void writeConfig(const string &rc_path, const string &style) {
+    mkdir(rc_path.c_str(), 0755);
+
+    std::ofstream init((rc_path + "/init").c_str());
+    init << "session.configVersion: 13\n"
+         << "session.styleFile: " << style << '\n'
+         << "session.keyFile: " << rc_path << "/keys\n"
+         << "session.menuFile: " << rc_path << "/menu\n"
+         << "session.appsFile: " << rc_path << "/apps\n"
+         << "session.screen0.workspaces: " << WORKSPACES << '\n'
+         << "session.screen0.allowRemoteActions: true\n"
+         << "session.screen0.opaqueMove: true\n"
+         << "session.screen0.edgeSnapThreshold: 20\n"
+         << "session.screen0.workspacewarping: false\n";
+
+    std::ofstream keys((rc_path + "/keys").c_str());
+    keys << "Mod1 Tab :NextWindow {groups} (workspace=[current])\n"
+         << "OnWindow Mod1 Mouse1 :MacroCmd {Raise} {Focus} {StartMoving}\n";
+
+    std::ofstream menu((rc_path + "/menu").c_str());
+    std::ofstream apps((rc_path + "/apps").c_str());
+}
+
+Window wmCheckWindow(Display *disp) {
+    Atom check = XInternAtom(disp, "_NET_SUPPORTING_WM_CHECK", False);
+    Atom type;
+    int format;
+    unsigned long nitems, bytes_after;
+    unsigned char *data = 0;
+    Window win = None;
+    if (XGetWindowProperty(disp, DefaultRootWindow(disp), check, 0, 1, False,
+                           XA_WINDOW, &type, &format, &nitems, &bytes_after,
+                           &data) == Success && data) {
+        if (nitems == 1)
+            win = *reinterpret_cast<Window *>(data);
+        XFree(data);
+    }
+    return win;
+}
+
+/// waits until a window manager other than 'old' runs
+bool waitForWM(Display *disp, Window old) {
+    double start = now();
+    while (now() - start < TIMEOUT) {
+        Window check = wmCheckWindow(disp);
+        if (check != None && check != old)
+            return true;
+        usleep(50000);
+    }
+    return false;
+}
+
+/**
+   Waits until fluxbox handled everything we sent before: it answers
+   _NET_REQUEST_FRAME_EXTENTS in its event loop, after the events that
+   came first.
+ */
+class Barrier {
+public:
+    explicit Barrier(Display *disp): m_disp(disp) {
+        XSetWindowAttributes attrib;
+        attrib.event_mask = PropertyChangeMask;
+        m_window = XCreateWindow(disp, DefaultRootWindow(disp), 0, 0, 1, 1, 0,
+                                 CopyFromParent, InputOnly, CopyFromParent,
+                                 CWEventMask, &attrib);
+        m_request = XInternAtom(disp, "_NET_REQUEST_FRAME_EXTENTS", False);
+        m_extents = XInternAtom(disp, "_NET_FRAME_EXTENTS", False);
+    }
+
+    ~Barrier() { XDestroyWindow(m_disp, m_window); }
+
+    bool wait() {
+        XDeleteProperty(m_disp, m_window, m_extents);
+        XEvent ce;
+        memset(&ce, 0, sizeof(ce));
+        ce.xclient.type = ClientMessage;
+        ce.xclient.window = m_window;
+        ce.xclient.message_type = m_request;
+        ce.xclient.format = 32;
+        XSendEvent(m_disp, DefaultRootWindow(m_disp), False,
+                   SubstructureRedirectMask | SubstructureNotifyMask, &ce);
+        XFlush(m_disp);
+
+        const int fd = ConnectionNumber(m_disp);
+        double start = now();
+        while (now() - start < TIMEOUT) {
+            XEvent event;
+            while (XCheckTypedWindowEvent(m_disp, m_window, PropertyNotify, &event)) {
+                if (event.xproperty.atom == m_extents &&
+                    event.xproperty.state == PropertyNewValue)
+                    return true;
+            }
+            fd_set fds;
+            FD_ZERO(&fds);
+            FD_SET(fd, &fds);
+            timeval tv = { 0, 10000 };
+            select(fd + 1, &fds, 0, 0, &tv);
+            XEventsQueued(m_disp, QueuedAfterReading);
+        }
+        return false;
+    }
+
+private:
+    Display *m_disp;
+    Window m_window;
+    Atom m_request, m_extents;
+};
+
+/// runs a fluxbox command and waits until it is done, as fluxbox drops
+/// commands that are sent before it read the last one
+void fluxboxAction(Display *disp, Barrier &barrier, const string &command) {
+    Atom action = XInternAtom(disp, "_FLUXBOX_ACTION", False);
+    XChangeProperty(disp, DefaultRootWindow(disp), action, XA_STRING, 8,
+                    PropModeReplace,
+                    reinterpret_cast<const unsigned char *>(command.c_str()),
+                    command.size());
+    barrier.wait();
+}
+
+void sendMessage(Display *disp, Window win, Atom type, long data0) {
+    XEvent ce;
+    memset(&ce, 0, sizeof(ce));
+    ce.xclient.type = ClientMessage;
+    ce.xclient.window = win;
+    ce.xclient.message_type = type;
+    ce.xclient.format = 32;
+    ce.xclient.data.l[0] = data0;
+    ce.xclient.data.l[1] = CurrentTime;
+    XSendEvent(disp, DefaultRootWindow(disp), False,
+               SubstructureRedirectMask | SubstructureNotifyMask, &ce);
+}
+
+/// what fluxbox did so far
+struct Counters {
+    Counters(): requests(0), round_trips(0), cpu(0) { }
+    unsigned long requests, round_trips;
+    double cpu; ///< seconds
+};
+
+/// @return the user and system time of 'pid' in seconds
+double cpuSeconds(pid_t pid) {
+    char filename[64];
+    snprintf(filename, sizeof(filename), "/proc/%d/stat", (int)pid);
+    std::ifstream file(filename);
+    string stat;
+    std::getline(file, stat);
+    // the name may contain anything, the fields start after its ')'
+    string::size_type pos = stat.rfind(')');
+    if (pos == string::npos)
+        return 0;
+    unsigned long utime = 0, stime = 0;
+    if (sscanf(stat.c_str() + pos + 1,
+               " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+               &utime, &stime) != 2)
+        return 0;
+    return double(utime + stime) / sysconf(_SC_CLK_TCK);
+}
+
+Counters readCounters(Display *disp, Barrier &barrier,
+                      const string &rc_path, pid_t pid) {
+    Counters counters;
+    string filename = rc_path + "/stats";
+    remove(filename.c_str());
+    fluxboxAction(disp, barrier, "DumpStats");
+
+    std::ifstream stats(filename.c_str());
+    string line;
+    bool requests = false;
+    while (std::getline(stats, line)) {
+        if (line.compare(0, 12, "X requests: ") == 0) {
+            counters.requests = strtoul(line.c_str() + 12, 0, 10);
+            requests = true;
+        } else if (requests && line.compare(0, 5, "total") == 0) {
+            // the last line of the round-trips
+            counters.round_trips = strtoul(line.c_str() + 5, 0, 10);
+            break;
+        }
+    }
+    counters.cpu = cpuSeconds(pid);
+    return counters;
+}
+
+/// measures a scenario from its construction until report()
+class Scenario {
+public:
+    Scenario(Display *disp, Barrier &barrier, const string &rc_path,
+             pid_t pid, const char *name):
+        m_disp(disp), m_barrier(barrier), m_rc_path(rc_path), m_pid(pid),
+        m_name(name) {
+        m_before = readCounters(disp, barrier, rc_path, pid);
+        m_start = now();
+    }
+
+    void report() {
+        bool done = m_barrier.wait();
+        double seconds = now() - m_start;
+        Counters after = readCounters(m_disp, m_barrier, m_rc_path, m_pid);
+        // a restart starts counting anew
+        if (after.requests < m_before.requests)
+            m_before.requests = m_before.round_trips = 0;
+        printf("%s\t%.3f\t%lu\t%lu\t%.0f%s\n", m_name, seconds,
+               after.requests - m_before.requests,
+               after.round_trips - m_before.round_trips,
+               (after.cpu - m_before.cpu) * 1000,
+               done ? "" : "\t# fluxbox didn't answer");
+        fflush(stdout);
+    }
+
+private:
+    Display *m_disp;
+    Barrier &m_barrier;
+    string m_rc_path;
+    pid_t m_pid;
+    const char *m_name;
+    Counters m_before;
+    double m_start;
+};
+
+Window createClient(Display *disp, size_t index) {
+    int screen = DefaultScreen(disp);
+    Window win = XCreateSimpleWindow(disp, RootWindow(disp, screen),
+                                     100 + (index * 37) % 700, 100 + (index * 23) % 500,
+                                     300, 200, 0,
+                                     BlackPixel(disp, screen),
+                                     WhitePixel(disp, screen));
+
+    XClassHint class_hint;
+    char name[] = "bench", class_name[] = "SessionBench";
+    class_hint.res_name = name;
+    class_hint.res_class = class_name;
+    XSetClassHint(disp, win, &class_hint);
+
+    char title[64];
+    snprintf(title, sizeof(title), "session bench %lu", (unsigned long)index);
+    XStoreName(disp, win, title);
+
+    long workspace = index < FIRST_WORKSPACE_WINDOWS ? 0 :
+        1 + index % (WORKSPACES - 1);
+    XChangeProperty(disp, win, XInternAtom(disp, "_NET_WM_DESKTOP", False),
+                    XA_CARDINAL, 32, PropModeReplace,
+                    reinterpret_cast<unsigned char *>(&workspace), 1);
+    XMapWindow(disp, win);
+    return win;
+}
+
+#ifdef HAVE_XTEST
+void altTab(Display *disp) {
+    KeyCode alt = XKeysymToKeycode(disp, XK_Alt_L);
+    KeyCode tab = XKeysymToKeycode(disp, XK_Tab);
+    XTestFakeKeyEvent(disp, alt, True, CurrentTime);
+    for (int i = 0; i < ALT_TABS; ++i) {
+        XTestFakeKeyEvent(disp, tab, True, CurrentTime);
+        XTestFakeKeyEvent(disp, tab, False, CurrentTime);
+    }
+    XTestFakeKeyEvent(disp, alt, False, CurrentTime);
+}
+
+/// drags 'win' with Alt and the first button to the left edge of the screen
+void drag(Display *disp, Window win) {
+    int x = 0, y = 0;
+    Window child;
+    XTranslateCoordinates(disp, win, DefaultRootWindow(disp), 150, 100,
+                          &x, &y, &child);
+
+    KeyCode alt = XKeysymToKeycode(disp, XK_Alt_L);
+    XTestFakeMotionEvent(disp, -1, x, y, CurrentTime);
+    XTestFakeKeyEvent(disp, alt, True, CurrentTime);
+    XTestFakeButtonEvent(disp, 1, True, CurrentTime);
+    // the last steps are within the snap threshold
+    for (int step = 0; step < 40 && x > 150; ++step) {
+        x -= x > 160 ? 10 : 2;
+        XTestFakeMotionEvent(disp, -1, x, y, CurrentTime);
+        XFlush(disp);
+        usleep(2000);
+    }
+    XTestFakeButtonEvent(disp, 1, False, CurrentTime);
+    XTestFakeKeyEvent(disp, alt, False, CurrentTime);
+}
+#endif // HAVE_XTEST
+
+} // anonymous namespace
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        fprintf(stderr, "usage: %s <fluxbox> <style> <other style>\n", argv[0]);
+        return 1;
+    }
+    const string fluxbox = argv[1];
+    const string styles[] = { argv[2], argv[3] };
+
+    char dir[] = "/tmp/testSessionBench.XXXXXX";
+    if (mkdtemp(dir) == 0) {
+        perror("mkdtemp");
+        return 1;
+    }
+    const string rc_path = string(dir) + "/.fluxbox";
+    writeConfig(rc_path, styles[0]);
+
+    pid_t xvfb = 0;
+    string display = startXvfb(dir, xvfb);
+    if (display.empty()) {
+        printf("# Xvfb didn't start\n");
+        stop(xvfb);
+        return 1;
+    }
+
+    vector<string> args;
+    args.push_back(fluxbox);
+    args.push_back("-display");
+    args.push_back(display);
+    pid_t wm = spawn(args, dir, string(dir) + "/fluxbox.log");
+
+    int ret = 0;
+    {
+        App app(display.c_str());
+        Display *disp = app.display();
+        if (!waitForWM(disp, None)) {
+            printf("# fluxbox didn't start, see %s/fluxbox.log\n", dir);
+            stop(wm);
+            stop(xvfb);
+            return 1;
+        }
+        Barrier barrier(disp);
+        vector<Window> clients;
+
+#ifndef HAVE_XTEST
+        printf("# built without XTest: alt-tab through remote actions, no drag\n");
+#endif // HAVE_XTEST
+        printf("# %lu windows, %d workspaces\n", (unsigned long)WINDOWS, WORKSPACES);
+        printf("# scenario\tseconds\trequests\tround-trips\tcpu ms\n");
+
+        {
+            Scenario scenario(disp, barrier, rc_path, wm, "adopt");
+            for (size_t i = 0; i < WINDOWS; ++i)
+                clients.push_back(createClient(disp, i));
+            scenario.report();
+        }
+
+        {
+            Atom current = XInternAtom(disp, "_NET_CURRENT_DESKTOP", False);
+            Scenario scenario(disp, barrier, rc_path, wm, "workspaces");
+            for (int i = 1; i <= WORKSPACE_CYCLES * WORKSPACES; ++i)
+                sendMessage(disp, DefaultRootWindow(disp), current, i % WORKSPACES);
+            scenario.report();
+        }
+
+        {
+            Scenario scenario(disp, barrier, rc_path, wm, "alt-tab");
+#ifdef HAVE_XTEST
+            altTab(disp);
+#else
+            for (int i = 0; i < ALT_TABS; ++i)
+                fluxboxAction(disp, barrier, "NextWindow {groups} (workspace=[current])");
+#endif // HAVE_XTEST
+            scenario.report();
+        }
+
+#ifdef HAVE_XTEST
+        {
+            Scenario scenario(disp, barrier, rc_path, wm, "drag");
+            for (size_t i = 0; i < DRAGS && i < FIRST_WORKSPACE_WINDOWS; ++i) {
+                drag(disp, clients[i]);
+                barrier.wait();
+            }
+            scenario.report();
+        }
+#endif // HAVE_XTEST
+
+        {
+            Scenario scenario(disp, barrier, rc_path, wm, "style");
+            for (int i = 1; i <= STYLE_CHANGES; ++i)
+                fluxboxAction(disp, barrier, "SetStyle " + styles[i % 2]);
+            scenario.report();
+        }
+
+        {
+            Window old = wmCheckWindow(disp);
+            Scenario scenario(disp, barrier, rc_path, wm, "restart");
+            Atom action = XInternAtom(disp, "_FLUXBOX_ACTION", False);
+            const string restart = "Restart";
+            XChangeProperty(disp, DefaultRootWindow(disp), action, XA_STRING, 8,
+                            PropModeReplace,
+                            reinterpret_cast<const unsigned char *>(restart.c_str()),
+                            restart.size());
+            XFlush(disp);
+            if (!waitForWM(disp, old)) {
+                printf("# fluxbox didn't come back\n");
+                ret = 1;
+            } else
+                scenario.report();
+        }
+
+        for (size_t i = 0; i < clients.size(); ++i)
+            XDestroyWindow(disp, clients[i]);
+        XSync(disp, False);
+    }
+
+    stop(wm);
+    stop(xvfb);
+
+    string command = string("rm -rf ") + dir;
+    if (system(command.c_str()) != 0)
+        ret = 1;
+    return ret;
+}
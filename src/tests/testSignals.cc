@@ -3,9 +3,11 @@ using namespace std;
 
 #include "../FbTk/Signal.hh"
 #include "../FbTk/MemFun.hh"
+#include "testTime.hh"
 
 #include <string>
-
+#include <vector>
+#include <cstdio>
 
 
 struct NoArgument {
@@ -61,6 +63,57 @@ struct FunctionClass {
 
 };
 
+struct Counter {
+    Counter(): count(0) { }
+    void add(int value) { count += value; }
+    long count;
+};
+
+// disconnects itself the first time it is called
+struct Leaver {
+    Leaver(FbTk::SignalTracker &tracker): tracker(tracker) { }
+    void operator ()(int value) {
+        cout << "Leaving at " << value << endl;
+        tracker.leaveAll();
+    }
+    FbTk::SignalTracker &tracker;
+};
+
+// connects 'listeners' slots, emits and disconnects them 'rounds' times
+void measure(int listeners, int rounds) {
+    using namespace FbTk;
+    Signal<int> signal;
+    Counter counter;
+    std::vector<SignalTracker *> trackers(listeners);
+    for (int i = 0; i < listeners; ++i)
+        trackers[i] = new SignalTracker;
+
+    double connect = 0, emit = 0, disconnect = 0;
+    for (int r = 0; r < rounds; ++r) {
+        double start = now();
+        for (int i = 0; i < listeners; ++i)
+            trackers[i]->join(signal, MemFun(counter, &Counter::add));
+        double connected = now();
+        for (int e = 0; e < 10; ++e)
+            signal.emit(1);
+        double emitted = now();
+        for (int i = 0; i < listeners; ++i)
+            trackers[i]->leaveAll();
+        double end = now();
+        connect += connected - start;
+        emit += emitted - connected;
+        disconnect += end - emitted;
+    }
+    for (int i = 0; i < listeners; ++i)
+        delete trackers[i];
+
+    long calls = long(rounds) * listeners;
+    printf("%d\t%.1f\t%.1f\t%.1f\t%s\n", listeners,
+           connect * 1e9 / calls, emit * 1e9 / (calls * 10),
+           disconnect * 1e9 / calls,
+           counter.count == calls * 10 ? "ok" : "wrong count");
+}
+
 struct Printer {
     void printInt(int value) {
         cout << "Int:" << value << endl;
@@ -169,4 +222,25 @@ int main() {
         source2.connect(MemFunSelectArg1(printer, &Printer::printInt));
         source2.emit("world", 37);
     }
+
+    // Test disconnecting and connecting while emitting
+    {
+        cout << "---- while emitting ----" << endl;
+        Signal<int> source;
+        SignalTracker tracker;
+        tracker.join(source, Leaver(tracker));
+        source.connect(OneArgument());
+        // once from each, the leaver is gone the second time
+        source.emit(1);
+        source.emit(2);
+    }
+
+    // Test throughput, the times are per slot
+    {
+        cout << "---- throughput ----" << endl;
+        printf("# slots\tns/connect\tns/call\tns/disconnect\n");
+        const int listeners[] = { 1, 2, 4, 8, 32 };
+        for (size_t i = 0; i < sizeof(listeners) / sizeof(listeners[0]); ++i)
+            measure(listeners[i], 200000 / listeners[i]);
+    }
 }
@@ -0,0 +1,147 @@
+// testTextureBench.cc for fbtk test suite
+
+// renders every texture type at the sizes fluxbox uses and prints the time
+// per pixel and the allocations per render, one tab separated line each.
+// needs an X display, Xvfb will do:
+//   xvfb-run -s "-screen 0 3840x2160x24" ./testTextureBench
+
+#include "FbTk/App.hh"
+#include "FbTk/ImageControl.hh"
+#include "FbTk/Texture.hh"
+#include "FbTk/FbPixmap.hh"
+#include "FbTk/GContext.hh"
+#include "testTime.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace FbTk;
+
+namespace {
+
+unsigned long s_allocs = 0;
+unsigned long s_alloc_bytes = 0;
+
+struct Size {
+    unsigned int width, height;
+    const char *name;
+};
+
+const Size s_sizes[] = {
+    { 16, 16, "button" },
+    { 1920, 22, "titlebar" },
+    { 3840, 22, "titlebar" },
+    { 1920, 1080, "fullscreen" },
+    { 3840, 2160, "fullscreen" }
+};
+
+const char *s_textures[] = {
+    "flat solid",
+    "raised bevel1 solid",
+    "sunken bevel2 solid",
+    "flat interlaced solid",
+    "flat gradient horizontal",
+    "flat gradient vertical",
+    "flat gradient diagonal",
+    "flat gradient crossdiagonal",
+    "flat gradient pipecross",
+    "flat gradient elliptic",
+    "flat gradient rectangle",
+    "flat gradient pyramid",
+    "raised bevel1 gradient diagonal",
+    "sunken bevel2 gradient vertical",
+    "flat interlaced gradient horizontal",
+    "flat interlaced gradient elliptic",
+    "flat pixmap",
+    "flat tiled pixmap"
+};
+
+} // anonymous namespace
+
+// counts the allocations; the exception specifications changed with C++11
+#if __cplusplus >= 201103L
+#define BENCH_THROW_BAD_ALLOC
+#define BENCH_THROW_NOTHING noexcept
+#else
+#define BENCH_THROW_BAD_ALLOC throw (std::bad_alloc)
+#define BENCH_THROW_NOTHING throw ()
+#endif
+
+void *operator new(size_t size) BENCH_THROW_BAD_ALLOC {
+    ++s_allocs;
+    s_alloc_bytes += size;
+    void *p = malloc(size ? size : 1);
+    if (p == 0)
+        throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t size) BENCH_THROW_BAD_ALLOC {
+    return operator new(size);
+}
+
+void operator delete(void *p) BENCH_THROW_NOTHING {
+    free(p);
+}
+
+void operator delete[](void *p) BENCH_THROW_NOTHING {
+    free(p);
+}
+
+int main(int argc, char **argv) {
+
+    double min_time = 0.2;
+    if (argc > 1)
+        min_time = atof(argv[1]);
+
+    App app;
+    Display *disp = app.display();
+    ImageControl imgctrl(DefaultScreen(disp));
+
+    // source for the pixmap textures
+    FbPixmap source(RootWindow(disp, imgctrl.screenNumber()), 64, 64,
+                    imgctrl.depth());
+    FbTk::GContext gc(source);
+    gc.setForeground(WhitePixel(disp, imgctrl.screenNumber()));
+    source.fillRectangle(gc.gc(), 0, 0, 64, 64);
+
+    printf("# texture\tsize\twidth\theight\truns\tns/pixel\tallocs/render\tbytes/render\n");
+
+    for (size_t t = 0; t < sizeof(s_textures) / sizeof(s_textures[0]); ++t) {
+        Texture texture;
+        texture.setFromString(s_textures[t]);
+        texture.color().setFromString("rgb:20/40/80", imgctrl.screenNumber());
+        texture.colorTo().setFromString("rgb:e0/c0/a0", imgctrl.screenNumber());
+        if (strstr(s_textures[t], "pixmap"))
+            texture.pixmap() = source;
+
+        for (size_t s = 0; s < sizeof(s_sizes) / sizeof(s_sizes[0]); ++s) {
+            const Size &size = s_sizes[s];
+            unsigned long runs = 0;
+            unsigned long allocs = s_allocs, bytes = s_alloc_bytes;
+            double start = now(), elapsed = 0;
+            // render until min_time has passed, at least three times
+            do {
+                Pixmap pm = imgctrl.renderImage(size.width, size.height,
+                                                texture, ROT0, false);
+                if (pm != ParentRelative)
+                    XFreePixmap(disp, pm);
+                XSync(disp, False);
+                ++runs;
+                elapsed = now() - start;
+            } while (runs < 3 || elapsed < min_time);
+
+            printf("%s\t%s\t%u\t%u\t%lu\t%.3f\t%.1f\t%.0f\n",
+                   s_textures[t], size.name, size.width, size.height, runs,
+                   elapsed * 1e9 / runs / (size.width * size.height),
+                   (double)(s_allocs - allocs) / runs,
+                   (double)(s_alloc_bytes - bytes) / runs);
+        }
+    }
+
+    return 0;
+}
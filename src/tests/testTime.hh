@@ -0,0 +1,14 @@
+// testTime.hh for fbtk test suite
+
+#ifndef TESTTIME_HH
+#define TESTTIME_HH
+
+#include "FbTk/FbTime.hh"
+
+/// @return seconds on the monotonic clock, for timing what a test does;
+///         unlike the date it doesn't jump while a benchmark runs
+inline double now() {
+    return FbTk::FbTime::monoNanoseconds() / 1e9;
+}
+
+#endif // TESTTIME_HH
@@ -0,0 +1,64 @@
+// testTimer.cc for fbtk test suite
+
+// microbenchmark for arming and cancelling FbTk::Timer
+
+#include "FbTk/Timer.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <sys/time.h>
+
+namespace {
+
+struct Noop {
+    void operator()() const { }
+};
+
+double elapsed(const timeval &from) {
+    timeval now;
+    gettimeofday(&now, 0);
+    return (now.tv_sec - from.tv_sec) + (now.tv_usec - from.tv_usec) / 1000000.0;
+}
+
+}
+
+int main(int argc, char **argv) {
+
+    size_t num = 100000;
+    if (argc > 1)
+        num = atoi(argv[1]);
+
+    std::vector<FbTk::Timer *> timers(num);
+    srand(0);
+    for (size_t i = 0; i < num; ++i) {
+        timers[i] = new FbTk::Timer();
+        timers[i]->setFunctor(Noop());
+        // spread the timeouts, so that inserts don't just append
+        timers[i]->setTimeout(1 + rand() % 100000);
+    }
+
+    timeval start;
+
+    gettimeofday(&start, 0);
+    for (size_t i = 0; i < num; ++i)
+        timers[i]->start();
+    printf("arm %lu timers:    %.3f s\n", (unsigned long)num, elapsed(start));
+
+    gettimeofday(&start, 0);
+    for (size_t i = 0; i < num; ++i)
+        timers[i]->start();
+    printf("re-arm %lu timers: %.3f s\n", (unsigned long)num, elapsed(start));
+
+    gettimeofday(&start, 0);
+    for (size_t i = 0; i < num; i += 2)
+        timers[i]->stop();
+    for (size_t i = 1; i < num; i += 2)
+        timers[i]->stop();
+    printf("cancel %lu timers: %.3f s\n", (unsigned long)num, elapsed(start));
+
+    for (size_t i = 0; i < num; ++i)
+        delete timers[i];
+
+    return 0;
+}
@@ -0,0 +1,264 @@
+// testTransparencyBench.cc for fbtk test suite
+
+// creates translucent frames, each a window with a title button, and
+// translucent menus, then moves them, changes their focus colors and
+// changes the wallpaper below them. prints the time, the X requests and
+// the bytes sent to the server of each step, one tab separated line each.
+// the modes are pseudo transparency, where we blend the root pixmap with
+// RENDER ourselves, and Composite, where we only set the opacity and the
+// compositing manager blends. fluxbox has no ARGB frames, so there is no
+// mode for them.
+// needs an X display with RENDER, Xvfb will do:
+//   xvfb-run ./testTransparencyBench 50 5
+
+#include "FbTk/App.hh"
+#include "FbTk/Color.hh"
+#include "FbTk/EventManager.hh"
+#include "FbTk/FbPixmap.hh"
+#include "FbTk/Font.hh"
+#include "FbTk/ImageControl.hh"
+#include "FbTk/Menu.hh"
+#include "FbTk/MenuTheme.hh"
+#include "FbTk/TextButton.hh"
+#include "FbTk/Transparent.hh"
+#include "testTime.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#ifdef __GLIBC__
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#define BENCH_COUNT_BYTES
+#endif // __GLIBC__
+
+using namespace FbTk;
+
+namespace {
+
+int s_x_fd = -1;
+unsigned long s_bytes = 0;
+
+/// the time, requests and bytes of one step, summed over the runs
+struct Step {
+    Step(): seconds(0), requests(0), bytes(0) { }
+    const char *name;
+    double seconds;
+    unsigned long requests, bytes;
+};
+
+/// measures until the server handled all requests of the step
+class Measure {
+public:
+    Measure(Display *disp, Step &step): m_disp(disp), m_step(step) {
+        XSync(m_disp, False);
+        m_start = now();
+        m_request = NextRequest(m_disp);
+        m_bytes = s_bytes;
+    }
+    ~Measure() {
+        // without the request of the XSync
+        m_step.requests += NextRequest(m_disp) - m_request;
+        XSync(m_disp, False);
+        m_step.seconds += now() - m_start;
+        m_step.bytes += s_bytes - m_bytes;
+    }
+private:
+    Display *m_disp;
+    Step &m_step;
+    double m_start;
+    unsigned long m_request, m_bytes;
+};
+
+void handleEvents(Display *disp) {
+    XSync(disp, False);
+    while (XPending(disp)) {
+        XEvent event;
+        XNextEvent(disp, &event);
+        EventManager::instance()->handleEvent(event);
+    }
+}
+
+/// a top level window with a title, like the frame of a client
+struct Frame {
+    Frame(int screen, FbTk::Font &font, int x, int y):
+        window(screen, x, y, 240, 180, ExposureMask),
+        title(window, font, BiDiString("transparency bench")) {
+        title.moveResize(0, 0, 240, 20);
+    }
+    FbWindow window;
+    TextButton title;
+};
+
+Pixmap createWallpaper(Display *disp, int screen, const char *color) {
+    Window root = RootWindow(disp, screen);
+    Pixmap pm = XCreatePixmap(disp, root,
+                              DisplayWidth(disp, screen),
+                              DisplayHeight(disp, screen),
+                              DefaultDepth(disp, screen));
+    GC gc = XCreateGC(disp, root, 0, 0);
+    XSetForeground(disp, gc, Color(color, screen).pixel());
+    XFillRectangle(disp, pm, gc, 0, 0,
+                   DisplayWidth(disp, screen), DisplayHeight(disp, screen));
+    XFreeGC(disp, gc);
+    return pm;
+}
+
+} // anonymous namespace
+
+#ifdef BENCH_COUNT_BYTES
+// xcb sends the requests with writev, count what goes to the X server
+extern "C" ssize_t writev(int fd, const struct iovec *iov, int iovcnt) __THROW {
+    ssize_t ret = syscall(SYS_writev, fd, iov, iovcnt);
+    if (ret > 0 && fd == s_x_fd)
+        s_bytes += ret;
+    return ret;
+}
+#endif // BENCH_COUNT_BYTES
+
+int main(int argc, char **argv) {
+
+    unsigned int frames = 50;
+    int runs = 5;
+    if (argc > 1)
+        frames = atoi(argv[1]);
+    if (argc > 2)
+        runs = atoi(argv[2]);
+    const unsigned int menus = frames / 10 + 1;
+    const int alpha = 200;
+
+    App app;
+    Display *disp = app.display();
+    const int screen = DefaultScreen(disp);
+    s_x_fd = ConnectionNumber(disp);
+    ImageControl imgctrl(screen);
+    MenuTheme theme(screen);
+    theme.setAlpha(alpha);
+    FbTk::Font font;
+    Color focused("#5080c0", screen), unfocused("#808080", screen);
+
+    if (!Transparent::haveRender()) {
+        printf("# the display has no RENDER extension\n");
+        return 1;
+    }
+#ifndef BENCH_COUNT_BYTES
+    printf("# bytes are not counted on this system\n");
+#endif // BENCH_COUNT_BYTES
+
+    Pixmap wallpapers[2];
+    wallpapers[0] = createWallpaper(disp, screen, "#204060");
+    wallpapers[1] = createWallpaper(disp, screen, "#602040");
+
+    printf("# %u frames, %u menus\n", frames, menus);
+    printf("# mode\tstep\truns\tms/run\trequests/run\tbytes/run\n");
+
+    for (int pseudo = 1; pseudo >= 0; --pseudo) {
+        const char *mode = pseudo ? "pseudo" : "composite";
+        if (!pseudo && !Transparent::haveComposite(true)) {
+            printf("# the display has no Composite extension, no composite mode\n");
+            continue;
+        }
+        Transparent::usePseudoTransparent(pseudo);
+        FbPixmap::setRootPixmap(screen, wallpapers[0]);
+
+        Step steps[5];
+        steps[0].name = "create";
+        steps[1].name = "move";
+        steps[2].name = "focus";
+        steps[3].name = "wallpaper";
+        steps[4].name = "destroy";
+
+        for (int r = 0; r < runs; ++r) {
+            std::vector<Frame *> frame_list;
+            std::vector<Menu *> menu_list;
+            {
+                Measure measure(disp, steps[0]);
+                for (unsigned int i = 0; i < frames; ++i) {
+                    Frame *frame = new Frame(screen, font, (i * 37) % 800, (i * 23) % 600);
+                    frame->window.setBackgroundColor(unfocused);
+                    frame->title.setBackgroundColor(unfocused);
+                    if (pseudo) {
+                        frame->window.setAlpha(alpha);
+                        frame->title.setAlpha(alpha);
+                    } else
+                        frame->window.setOpaque(alpha);
+                    frame->window.showSubwindows();
+                    frame->window.show();
+                    frame_list.push_back(frame);
+                }
+                for (unsigned int i = 0; i < menus; ++i) {
+                    Menu *menu = new Menu(theme, imgctrl);
+                    menu->setLabel(BiDiString("bench"));
+                    for (int item = 0; item < 10; ++item)
+                        menu->insert("menu item");
+                    menu->reconfigure();
+                    menu->move((i * 53) % 800, (i * 31) % 600);
+                    menu->show();
+                    menu_list.push_back(menu);
+                }
+            }
+            handleEvents(disp);
+
+            {
+                Measure measure(disp, steps[1]);
+                for (int step = 1; step <= 10; ++step) {
+                    for (size_t i = 0; i < frame_list.size(); ++i) {
+                        FbWindow &win = frame_list[i]->window;
+                        win.move(win.x() + 5, win.y() + 3);
+                        // the children of a frame are told by the frame
+                        frame_list[i]->title.parentMoved();
+                    }
+                    for (size_t i = 0; i < menu_list.size(); ++i)
+                        menu_list[i]->move(menu_list[i]->x() + 5,
+                                           menu_list[i]->y() + 3);
+                }
+            }
+            handleEvents(disp);
+
+            {
+                Measure measure(disp, steps[2]);
+                for (size_t i = 0; i < frame_list.size(); ++i) {
+                    Frame &frame = *frame_list[i];
+                    frame.title.setBackgroundColor(focused);
+                    frame.title.clear();
+                    if (!pseudo)
+                        frame.window.setOpaque(255);
+                    frame.title.setBackgroundColor(unfocused);
+                    frame.title.clear();
+                    if (!pseudo)
+                        frame.window.setOpaque(alpha);
+                }
+            }
+            handleEvents(disp);
+
+            {
+                Measure measure(disp, steps[3]);
+                FbPixmap::setRootPixmap(screen, wallpapers[1]);
+                FbPixmap::setRootPixmap(screen, wallpapers[0]);
+            }
+            handleEvents(disp);
+
+            {
+                Measure measure(disp, steps[4]);
+                for (size_t i = 0; i < menu_list.size(); ++i)
+                    delete menu_list[i];
+                for (size_t i = 0; i < frame_list.size(); ++i)
+                    delete frame_list[i];
+            }
+        }
+
+        for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); ++i)
+            printf("%s\t%s\t%d\t%.3f\t%.0f\t%.0f\n", mode, steps[i].name, runs,
+                   steps[i].seconds * 1000 / runs,
+                   (double)steps[i].requests / runs,
+                   (double)steps[i].bytes / runs);
+    }
+
+    FbPixmap::setRootPixmap(screen, None);
+    XFreePixmap(disp, wallpapers[0]);
+    XFreePixmap(disp, wallpapers[1]);
+
+    return 0;
+}
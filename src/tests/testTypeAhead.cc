@@ -0,0 +1,120 @@
+// testTypeAhead.cc for fbtk test suite
+
+// checks FbTk::TypeAhead against a plain scan of the items for prefixes
+// and substrings, then times typing into a menu sized list.
+
+#include "FbTk/TypeAhead.hh"
+#include "testTime.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+class Item: public FbTk::ITypeAheadable {
+public:
+    Item(const std::string &str, bool enabled): m_str(str), m_enabled(enabled) { }
+    const std::string &iTypeString() const { return m_str; }
+    bool isEnabled() { return m_enabled; }
+private:
+    std::string m_str;
+    bool m_enabled;
+};
+
+typedef std::vector<Item *> Items;
+
+std::string lower(const std::string &str) {
+    std::string result(str);
+    for (size_t i = 0; i < result.size(); ++i)
+        result[i] = tolower(result[i]);
+    return result;
+}
+
+Items expected(const Items &items, const std::string &text, bool substring) {
+    Items result;
+    for (size_t i = 0; i < items.size(); ++i) {
+        size_t pos = lower(items[i]->iTypeString()).find(lower(text));
+        if (items[i]->isEnabled() && (substring ? pos != std::string::npos : pos == 0))
+            result.push_back(items[i]);
+    }
+    return result;
+}
+
+const char *words[] = {
+    "Terminal", "Firefox", "Thunderbird", "GIMP", "Inkscape", "xterm",
+    "Text Editor", "File Manager", "Calculator", "Settings", "Vim", "Emacs"
+};
+
+}
+
+int main(int argc, char **argv) {
+    const size_t num_words = sizeof(words) / sizeof(words[0]);
+    const size_t num_items = argc > 1 ? atoi(argv[1]) : 5000;
+    int errors = 0;
+
+    Items items;
+    char buf[64];
+    for (size_t i = 0; i < num_items; ++i) {
+        sprintf(buf, "%s %lu", words[i % num_words], (unsigned long)i);
+        items.push_back(new Item(buf, i % 7 != 3));
+    }
+
+    const char *typed[] = { "t", "te", "ter", "term", "x", "1", "12", "r 1", "zz" };
+    const size_t num_typed = sizeof(typed) / sizeof(typed[0]);
+
+    for (int substring = 0; substring < 2; ++substring) {
+        FbTk::TypeAhead<Items, Item *> typeahead;
+        typeahead.init(items);
+        typeahead.setMode(substring ? FbTk::TYPEAHEAD_SUBSTRING : FbTk::TYPEAHEAD_PREFIX);
+
+        for (size_t t = 0; t < num_typed; ++t) {
+            std::string text(typed[t]);
+            Items want = expected(items, text, substring);
+            typeahead.reset();
+            bool found = true;
+            for (size_t i = 0; i < text.size() && found; ++i)
+                found = typeahead.putCharacter(text[i]);
+
+            Items got = found ? typeahead.matched() : Items();
+            if (got != want) {
+                printf("%s '%s': %lu matches, expected %lu\n",
+                       substring ? "substring" : "prefix", typed[t],
+                       (unsigned long)got.size(), (unsigned long)want.size());
+                ++errors;
+            }
+        }
+
+        // backspace gets the earlier matches back
+        typeahead.reset();
+        typeahead.putCharacter('t');
+        typeahead.putCharacter('h');
+        typeahead.putBackSpace();
+        if (typeahead.matched() != expected(items, "t", substring)) {
+            printf("%s: backspace doesn't restore the matches\n",
+                   substring ? "substring" : "prefix");
+            ++errors;
+        }
+
+        const int rounds = 1000;
+        double start = now();
+        size_t matches = 0;
+        for (int r = 0; r < rounds; ++r) {
+            typeahead.reset();
+            typeahead.putCharacter('t');
+            typeahead.putCharacter('e');
+            typeahead.putCharacter('r');
+            matches += typeahead.matched().size();
+        }
+        double elapsed = now() - start;
+        printf("%-9s %lu items: %8.1f us per keystroke and matched() (%lu matches)\n",
+               substring ? "substring" : "prefix", (unsigned long)num_items,
+               elapsed * 1e6 / (rounds * 3), (unsigned long)(matches / rounds));
+    }
+
+    for (size_t i = 0; i < items.size(); ++i)
+        delete items[i];
+
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
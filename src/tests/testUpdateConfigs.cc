@@ -0,0 +1,126 @@
+// testUpdateConfigs.cc for fbtk test suite
+
+// runs fluxbox-update_configs over generated keys, apps and groups files
+// of some megabytes, once with all the updates and once with none left
+// to do. prints the time of each run and which files it rewrote, one tab
+// separated line each:
+//   ./testUpdateConfigs ../../util/fluxbox-update_configs 8
+
+#include "testTime.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+using namespace std;
+
+namespace {
+
+const char *const KEYS_LINES[] = {
+    "Mod4 %lu :Workspace %lu",
+    "Mod1 Tab :NextWindow %lu # %lu",
+    "OnTitlebar Mouse%lu :MacroCmd {Raise} {Focus} {PrevGroup %lu}",
+    "Control Mod1 Left :SendToPrevWorkspace"
+};
+
+const char *const APPS_LINES[] = {
+    "[app] (name=xterm%lu) (class=XTerm%lu)",
+    "  [Workspace]\t{%lu}   # comment %lu",
+    "  [Dimensions] {%lu %lu}",
+    "[end]"
+};
+
+const char *const GROUPS_LINES[] = {
+    "xterm%lu rxvt%lu",
+    "emacs%lu gvim%lu",
+    "firefox%lu chromium%lu",
+    "mutt%lu"
+};
+
+void generate(const string &filename, const char *const lines[], size_t megabytes) {
+    ofstream file(filename.c_str());
+    size_t size = 0;
+    for (unsigned long n = 0; size < megabytes * 1024 * 1024; ++n) {
+        char line[256];
+        int len = snprintf(line, sizeof(line), lines[n % 4], n, n);
+        file << line << '\n';
+        size += len + 1;
+    }
+}
+
+void writeInit(const string &dir, int version) {
+    ofstream file((dir + "/init").c_str());
+    file << "session.keyFile: " << dir << "/keys\n"
+         << "session.appsFile: " << dir << "/apps\n"
+         << "session.groupFile: " << dir << "/groups\n"
+         << "session.screen0.iconbar.wheelMode: On\n"
+         << "session.configVersion: " << version << '\n';
+}
+
+/// dates 'filename' back, so a write shows in its time
+void backdate(const string &filename) {
+    utimbuf times;
+    times.actime = times.modtime = 1;
+    utime(filename.c_str(), &times);
+}
+
+bool written(const string &filename) {
+    struct stat st;
+    return stat(filename.c_str(), &st) == 0 && st.st_mtime != 1;
+}
+
+void run(const string &tool, const string &dir, const char *what) {
+    const char *files[] = { "init", "keys", "apps" };
+    for (int i = 0; i < 3; ++i)
+        backdate(dir + '/' + files[i]);
+
+    string command = tool + " -rc " + dir + "/init > /dev/null 2>&1";
+    double start = now();
+    int ret = system(command.c_str());
+    double seconds = now() - start;
+
+    string changed;
+    for (int i = 0; i < 3; ++i) {
+        if (written(dir + '/' + files[i]))
+            changed += string(changed.empty() ? "" : ",") + files[i];
+    }
+    printf("%s\t%d\t%.1f\t%s\n", what, ret, seconds * 1000,
+           changed.empty() ? "-" : changed.c_str());
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <fluxbox-update_configs> [megabytes]\n", argv[0]);
+        return 1;
+    }
+    string tool = argv[1];
+    size_t megabytes = argc > 2 ? atoi(argv[2]) : 4;
+
+    char dir[] = "/tmp/testUpdateConfigs.XXXXXX";
+    if (mkdtemp(dir) == 0) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    generate(string(dir) + "/keys", KEYS_LINES, megabytes);
+    generate(string(dir) + "/apps", APPS_LINES, megabytes);
+    generate(string(dir) + "/groups", GROUPS_LINES, megabytes / 4 + 1);
+    writeInit(dir, 0);
+
+    printf("# %lu MB keys and apps\n", (unsigned long)megabytes);
+    printf("# run\texit\tms\twritten\n");
+    run(tool, dir, "all");
+    run(tool, dir, "none");
+
+    const char *files[] = { "init", "keys", "apps", "groups" };
+    for (int i = 0; i < 4; ++i)
+        remove((string(dir) + '/' + files[i]).c_str());
+    rmdir(dir);
+    return 0;
+}
@@ -0,0 +1,87 @@
+// testXIDMap.cc for fbtk test suite
+
+#include "FbTk/XIDMap.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+
+namespace {
+
+int failed = 0;
+
+void check(bool cond, const char *what) {
+    if (!cond) {
+        printf("FAILED: %s\n", what);
+        ++failed;
+    }
+}
+
+}
+
+int main(int argc, char **argv) {
+
+    printf("testing FbTk::XIDMap against std::map\n");
+
+    FbTk::XIDMap<int> xidmap;
+    std::map<XID, int> reference;
+
+    check(xidmap.find(None) == 0, "None is never found");
+    xidmap.insert(None, 1);
+    check(xidmap.empty(), "None can't be inserted");
+
+    srand(0);
+    for (int round = 0; round < 200000; ++round) {
+        // a small key range, so that we hit existing keys and get
+        // long probe sequences
+        XID key = 0x1200000 + rand() % 2048;
+        switch (rand() % 3) {
+        case 0:
+        case 1:
+            xidmap.insert(key, round);
+            reference[key] = round;
+            break;
+        case 2:
+            check(xidmap.erase(key) == (reference.erase(key) == 1), "erase result");
+            break;
+        }
+
+        // asked again and again, like the window of a burst of events
+        const int *val = xidmap.find(key);
+        std::map<XID, int>::const_iterator it = reference.find(key);
+        check(it == reference.end() ? val == 0 : val != 0 && *val == it->second,
+              "value of the last key");
+    }
+
+    check(xidmap.size() == reference.size(), "size");
+
+    for (XID key = 0x1200000; key < 0x1200000 + 2048; ++key) {
+        std::map<XID, int>::const_iterator it = reference.find(key);
+        const int *val = xidmap.find(key);
+        if (it == reference.end())
+            check(val == 0, "missing key not found");
+        else
+            check(val != 0 && *val == it->second, "value of key");
+    }
+
+    // the remembered slot must not outlive an erase, neither of its key
+    // nor of a key before it that shifts it back
+    FbTk::XIDMap<int> lasthit;
+    for (XID key = 1; key <= 16; ++key)
+        lasthit.insert(key * 1024, static_cast<int>(key));
+    for (XID key = 1; key <= 16; ++key) {
+        check(lasthit.find(key * 1024) != 0, "last hit found");
+        check(lasthit.erase(key * 1024), "last hit erased");
+        check(lasthit.find(key * 1024) == 0, "erased last hit not found");
+        for (XID rest = key + 1; rest <= 16; ++rest) {
+            const int *val = lasthit.find(rest * 1024);
+            check(val != 0 && *val == static_cast<int>(rest), "value after erase");
+        }
+    }
+
+    xidmap.clear();
+    check(xidmap.empty() && xidmap.find(0x1200000) == 0, "clear");
+
+    printf("%s\n", failed ? "FAILED" : "passed");
+    return failed ? 1 : 0;
+}
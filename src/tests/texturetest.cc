@@ -18,6 +18,7 @@
 #include <stdio.h>
 #include <memory>
 #include <string>
+#include <sys/time.h>
 
 using namespace std;
 using namespace FbTk;
@@ -117,16 +118,63 @@ private:
     FbTk::GContext m_gc;
 };
 
+/// renders every gradient type without cache and prints the throughput
+void benchmark(unsigned int width, unsigned int height) {
+    static const char *gradients[] = {
+        "horizontal", "vertical", "diagonal", "crossdiagonal",
+        "pipecross", "elliptic", "rectangle", "pyramid"
+    };
+    const int runs = 20;
+
+    ImageControl imgctrl(DefaultScreen(App::instance()->display()));
+    for (size_t i = 0; i < sizeof(gradients) / sizeof(gradients[0]); ++i) {
+        for (int interlaced = 0; interlaced < 2; ++interlaced) {
+            Texture texture;
+            string desc = string("gradient ") + gradients[i] +
+                (interlaced ? " interlaced" : "");
+            texture.setFromString(desc.c_str());
+            texture.color().setFromString("rgb:20/40/80", imgctrl.screenNumber());
+            texture.colorTo().setFromString("rgb:e0/c0/a0", imgctrl.screenNumber());
+
+            timeval start, end;
+            gettimeofday(&start, 0);
+            for (int run = 0; run < runs; ++run) {
+                Pixmap pm = imgctrl.renderImage(width, height, texture, ROT0, false);
+                XFreePixmap(App::instance()->display(), pm);
+            }
+            XSync(App::instance()->display(), False);
+            gettimeofday(&end, 0);
+
+            double secs = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
+            printf("%-36s %8.1f Mpixels/s\n", desc.c_str(),
+                   (double)width * height * runs / secs / 1000000.0);
+        }
+    }
+}
+
 int main(int argc, char **argv) {
     int boxsize= 30;
     int num = 63;
+    bool bench = false;
+    unsigned int bench_width = 3840, bench_height = 2160;
     for (int i=1; i<argc; ++i) {
         if (strcmp(argv[i], "-boxsize") == 0 && i + 1 < argc)
             boxsize = atoi(argv[++i]);
         else if (strcmp(argv[i], "-num") == 0 && i + 1 < argc)
             num = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-bench") == 0) {
+            bench = true;
+            if (i + 2 < argc && atoi(argv[i + 1]) > 0) {
+                bench_width = atoi(argv[++i]);
+                bench_height = atoi(argv[++i]);
+            }
+        }
      }
     App realapp;
+    if (bench) {
+        benchmark(bench_width, bench_height);
+        return 0;
+    }
     Application app(boxsize, num);
 
     realapp.eventLoop();
@@ -0,0 +1,171 @@
+// AppIndex.cc
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#include "AppIndex.hh"
+
+#include "FbTk/FileUtil.hh"
+#include "FbTk/StringUtil.hh"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+using std::string;
+using std::vector;
+
+namespace {
+
+/// first line of the cache file, change it when the format changes
+const char CACHE_VERSION[] = "fbrun apps 1";
+
+} // anonymous namespace
+
+AppIndex::AppIndex(): m_loading(false) { }
+
+AppIndex::~AppIndex() {
+    wait();
+}
+
+void AppIndex::load(const string &path, const string &cache_file) {
+    wait();
+    m_path = path;
+    m_cache_file = cache_file;
+    m_names.clear();
+    m_loading = true;
+#ifdef HAVE_PTHREAD
+    if (pthread_create(&m_thread, 0, run, this) == 0)
+        return;
+#endif // HAVE_PTHREAD
+    build();
+    m_loading = false;
+}
+
+void AppIndex::wait() {
+#ifdef HAVE_PTHREAD
+    if (m_loading)
+        pthread_join(m_thread, 0);
+#endif // HAVE_PTHREAD
+    m_loading = false;
+}
+
+void *AppIndex::run(void *index) {
+    static_cast<AppIndex *>(index)->build();
+    return 0;
+}
+
+void AppIndex::complete(const string &prefix, vector<string> &matches) {
+    wait();
+    vector<string>::const_iterator it =
+        std::lower_bound(m_names.begin(), m_names.end(), prefix);
+    for (; it != m_names.end() && it->compare(0, prefix.size(), prefix) == 0; ++it)
+        matches.push_back(*it);
+}
+
+void AppIndex::build() {
+    Dirs dirs;
+    string::size_type start = 0;
+    while (start <= m_path.size()) {
+        string::size_type end = m_path.find(':', start);
+        if (end == string::npos)
+            end = m_path.size();
+        Dir dir;
+        dir.name = m_path.substr(start, end - start);
+        start = end + 1;
+        if (dir.name.empty())
+            continue;
+        struct stat buf;
+        dir.mtime = stat(dir.name.c_str(), &buf) == 0 ? buf.st_mtime : 0;
+        dirs.push_back(dir);
+    }
+
+    if (readCache(dirs))
+        return;
+
+    FbTk::Directory directory;
+    for (Dirs::const_iterator it = dirs.begin(); it != dirs.end(); ++it) {
+        if (it->mtime == 0 || !directory.open(it->name.c_str()))
+            continue;
+        string dirname = it->name;
+        if (*dirname.rbegin() != '/')
+            dirname += '/';
+        for (int n = directory.entries(); n > 0; --n) {
+            string filename = directory.readFilename();
+            string fncomplete = dirname + filename;
+            if (filename.find('\n') == string::npos &&
+                FbTk::FileUtil::isRegularFile(fncomplete.c_str()) &&
+                FbTk::FileUtil::isExecutable(fncomplete.c_str()))
+                m_names.push_back(filename);
+        }
+        directory.close();
+    }
+    std::sort(m_names.begin(), m_names.end());
+    m_names.erase(std::unique(m_names.begin(), m_names.end()), m_names.end());
+
+    writeCache(dirs);
+}
+
+bool AppIndex::readCache(const Dirs &dirs) {
+    if (m_cache_file.empty())
+        return false;
+    std::ifstream in(m_cache_file.c_str());
+    string line;
+    size_t num_dirs = 0;
+    if (!getline(in, line) || line != CACHE_VERSION || !(in>>num_dirs) ||
+        num_dirs != dirs.size())
+        return false;
+
+    for (Dirs::const_iterator it = dirs.begin(); it != dirs.end(); ++it) {
+        long mtime = 0;
+        if (!(in>>mtime) || mtime != it->mtime || !in.ignore(1) ||
+            !getline(in, line) || line != it->name)
+            return false;
+    }
+
+    while (getline(in, line)) {
+        if (!line.empty())
+            m_names.push_back(line);
+    }
+    return true;
+}
+
+void AppIndex::writeCache(const Dirs &dirs) const {
+    if (m_cache_file.empty())
+        return;
+    // other fbruns may read it meanwhile, so replace it as a whole
+    string tmp = m_cache_file + "." + FbTk::StringUtil::number2String(getpid());
+    {
+        std::ofstream out(tmp.c_str());
+        if (!out)
+            return;
+        out<<CACHE_VERSION<<'\n'<<dirs.size()<<'\n';
+        for (Dirs::const_iterator it = dirs.begin(); it != dirs.end(); ++it)
+            out<<it->mtime<<' '<<it->name<<'\n';
+        for (size_t i = 0; i < m_names.size(); ++i)
+            out<<m_names[i]<<'\n';
+        if (!out)
+            return;
+    }
+    rename(tmp.c_str(), m_cache_file.c_str());
+}
@@ -0,0 +1,78 @@
+// AppIndex.hh
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#ifndef APPINDEX_HH
+#define APPINDEX_HH
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif // HAVE_PTHREAD
+
+#include <string>
+#include <vector>
+
+/**
+   The executables in the directories of $PATH, sorted, so completing a
+   prefix is a binary search. The names are kept in a cache file with the
+   modification times of the directories, so the next fbrun only stats the
+   directories instead of every file in them, and scans again only when
+   one changed. With threads, this happens in the background while the
+   window is shown.
+ */
+class AppIndex {
+public:
+    AppIndex();
+    ~AppIndex();
+
+    /// starts loading the executables in 'path', separated by ':'
+    void load(const std::string &path, const std::string &cache_file);
+    /// appends the names that start with 'prefix' to 'matches', in order,
+    /// waits for load() to finish
+    void complete(const std::string &prefix, std::vector<std::string> &matches);
+
+private:
+    struct Dir {
+        std::string name;
+        long mtime;
+    };
+    typedef std::vector<Dir> Dirs;
+
+    static void *run(void *index);
+    /// reads the cache if the directories didn't change, otherwise scans them
+    void build();
+    bool readCache(const Dirs &dirs);
+    void writeCache(const Dirs &dirs) const;
+    void wait();
+
+    std::string m_path;
+    std::string m_cache_file;
+    std::vector<std::string> m_names; ///< sorted, no duplicates
+    bool m_loading;
+#ifdef HAVE_PTHREAD
+    pthread_t m_thread;
+#endif // HAVE_PTHREAD
+};
+
+#endif // APPINDEX_HH
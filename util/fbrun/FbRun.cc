@@ -44,7 +44,6 @@
 
 #include <iostream>
 #include <iterator>
-#include <fstream>
 #include <algorithm>
 
 #ifdef _WIN32
@@ -54,10 +53,6 @@
 using std::cerr;
 using std::endl;
 using std::string;
-using std::fstream;
-using std::ifstream;
-using std::ofstream;
-using std::ios;
 
 FbRun::FbRun(int x, int y, size_t width):
     FbTk::TextBox(DefaultScreen(FbTk::App::instance()->display()),
@@ -162,75 +157,15 @@ void FbRun::run(const std::string &command) {
     hide(); // hide gui
 
     // save command history to file
-    if (text().size() != 0) { // no need to save empty command
-
-        // don't allow duplicates into the history file, first
-        // look for a duplicate
-        if (m_current_history_item < m_history.size()
-            && text() == m_history[m_current_history_item]) {
-            // m_current_history_item is the duplicate
-        } else {
-            m_current_history_item = 0;
-            for (; m_current_history_item < m_history.size();
-                 ++m_current_history_item) {
-                if (m_history[m_current_history_item] == text())
-                    break;
-            }
-        }
-
-        fstream inoutfile(m_history_file.c_str(), ios::in|ios::out);
-        if (inoutfile) {
-            // now m_current_history_item points at the duplicate, or
-            // at m_history.size() if no duplicate
-            if (m_current_history_item != m_history.size()) {
-                unsigned int i = 0;
-                // read past history items before current
-                for (; inoutfile.good() && i < m_current_history_item; i++)
-                    inoutfile.ignore(1, '\n');
-
-                // write the history items that come after current
-                for (i++; i < m_history.size(); i++)
-                    inoutfile<<m_history[i]<<endl;
-
-            } else {
-                // set put-pointer at end of file
-                inoutfile.seekp(0, ios::end);
-            }
-            // append current command to the file
-            inoutfile<<command<<endl;
-
-        } else
-            cerr<<"FbRun Warning: Can't write command history to file: "<<m_history_file<<endl;
-    }
-
+    if (!m_history.add(command))
+        cerr<<"FbRun Warning: Can't write command history to file: "<<m_history.filename()<<endl;
 }
 
 bool FbRun::loadHistory(const char *filename) {
-    if (filename == 0)
+    if (filename == 0 || !m_history.load(filename))
         return false;
-    ifstream infile(filename);
-    if (!infile) {
-        //even though we fail to load file, we should try save to it
-        ofstream outfile(filename);
-        if (outfile) {
-            m_history_file = filename;
-            return true;
-        }
-        return false;
-    }
-    // clear old history and load new one from file
-    m_history.clear();
-    // each line is a command
-    string line;
-    while (!infile.eof()) {
-        getline(infile, line);
-        if (line.size()) // don't add empty lines
-            m_history.push_back(line);
-    }
-    // set no current histor to display
+    // set no current history to display
     m_current_history_item = m_history.size();
-    // set history file
-    m_history_file = filename;
     return true;
 }
 
@@ -392,131 +327,77 @@ void FbRun::tabCompleteHistory() {
     if (m_current_history_item == 0 || m_history.empty() ) {
         XBell(m_display, 0);
     } else {
-        unsigned int nr= 0;
-        unsigned int history_item = m_current_history_item - 1;
         if (m_last_completion_prefix.empty())
             m_last_completion_prefix = text().substr(0, textStartPos() + cursorPosition());
 
-        while (history_item != m_current_history_item && nr++ < m_history.size()) {
-            if (m_history[history_item].find(m_last_completion_prefix) == 0) {
-                m_current_history_item = history_item;
-                setText(FbTk::BiDiString(m_history[m_current_history_item]));
-                cursorEnd();
-                break;
-            }
-            if (history_item == 0) // loop
-                history_item = m_history.size();
-            history_item--;
+        size_t history_item = m_history.findPrevious(m_last_completion_prefix,
+                                                     m_current_history_item);
+        if (history_item == m_history.size() || history_item == m_current_history_item) {
+            XBell(m_display, 0);
+        } else {
+            m_current_history_item = history_item;
+            setText(FbTk::BiDiString(m_history[m_current_history_item]));
+            cursorEnd();
         }
-        if (history_item == m_current_history_item) XBell(m_display, 0);
     }
 }
 
-void FbRun::tabCompleteApps() {
-
-    static bool first_run= true;
-    if (m_last_completion_prefix.empty())
-        m_last_completion_prefix = text().substr(0, textStartPos() + cursorPosition());
-    string prefix = m_last_completion_prefix;
-    FbTk::Directory dir;
-
-    bool add_dirs= false;
-    bool changed_prefix= false;
+void FbRun::loadApps(const string &cache_file) {
+    const char *path = getenv("PATH");
+    m_app_index.load(path ? path : "", cache_file);
+}
 
-    // (re)build m_apps-container
-    if (first_run || m_last_completion_prefix != prefix) {
-        first_run= false;
+void FbRun::tabCompleteApps() {
 
-        string path;
+    bool changed_prefix = false;
 
-        if(!prefix.empty() &&
-            string("/.~").find_first_of(prefix[0]) != string::npos) {
-            size_t rseparator= prefix.find_last_of("/");
-            path= prefix.substr(0, rseparator + 1) +  ":";
-            add_dirs= true;
-        } else {
-            char* tmp_path = getenv("PATH");
-            if (tmp_path)
-                path = tmp_path;
-        }
+    // a new completion, unless the text is still the one we completed to
+    if (m_last_completion_prefix.empty() &&
+        (m_apps.empty() || text() != m_apps[m_current_apps_item])) {
+        m_last_completion_prefix = text().substr(0, textStartPos() + cursorPosition());
         m_apps.clear();
-
-        unsigned int l;
-        unsigned int r;
-
-        for(l= 0, r= 0; r < path.size(); r++) {
-            if ((path[r]==':' || r == path.size() - 1) && r - l > 0) {
-                string filename;
-                string fncomplete;
-                dir.open(path.substr(l, r - l).c_str());
-                int n= dir.entries();
-                if (n >= 0) {
-                    while(n--) {
-                        filename= dir.readFilename();
-                        fncomplete= dir.name() +
-                                    (*dir.name().rbegin() != '/' ? "/" : "") +
-                                    filename;
-
-                        // directories in dirmode ?
-                        if (add_dirs && FbTk::FileUtil::isDirectory(fncomplete.c_str()) &&
-                            filename != ".." && filename != ".") {
-                            m_apps.push_back(fncomplete);
-                        // executables in dirmode ?
-                        } else if (add_dirs && FbTk::FileUtil::isRegularFile(fncomplete.c_str()) &&
-                                   FbTk::FileUtil::isExecutable(fncomplete.c_str()) &&
-                                   (prefix == "" ||
-                                    fncomplete.substr(0, prefix.size()) == prefix)) {
-                            m_apps.push_back(fncomplete);
-                        // executables in $PATH ?
-                        } else if (FbTk::FileUtil::isRegularFile(fncomplete.c_str()) &&
-                                   FbTk::FileUtil::isExecutable(fncomplete.c_str()) &&
-                                   (prefix == "" ||
-                                    filename.substr(0, prefix.size()) == prefix)) {
-                            m_apps.push_back(filename);
-                        }
-                    }
-                }
-                l= r + 1;
-                dir.close();
+        m_current_apps_item = 0;
+        changed_prefix = true;
+    }
+    const string &prefix = m_last_completion_prefix;
+    bool add_dirs = !prefix.empty() && string("/.~").find_first_of(prefix[0]) != string::npos;
+
+    if (changed_prefix && add_dirs) {
+        // the directories and executables in the directory of the prefix
+        FbTk::Directory dir;
+        string path = prefix.substr(0, prefix.find_last_of("/") + 1);
+        if (dir.open(path.c_str())) {
+            for (int n = dir.entries(); n > 0; --n) {
+                string filename = dir.readFilename();
+                string fncomplete = path + filename;
+                if (fncomplete.compare(0, prefix.size(), prefix) != 0 ||
+                    filename == "." || filename == "..")
+                    continue;
+                if (FbTk::FileUtil::isDirectory(fncomplete.c_str()) ||
+                    (FbTk::FileUtil::isRegularFile(fncomplete.c_str()) &&
+                     FbTk::FileUtil::isExecutable(fncomplete.c_str())))
+                    m_apps.push_back(fncomplete);
             }
+            dir.close();
         }
         sort(m_apps.begin(), m_apps.end());
-        unique(m_apps.begin(), m_apps.end());
+    } else if (changed_prefix)
+        m_app_index.complete(prefix, m_apps);
 
-        m_last_completion_prefix = prefix;
-        changed_prefix= true;
-        m_current_apps_item= 0;
+    if (m_apps.empty() || (!changed_prefix && m_apps.size() == 1)) {
+        XBell(m_display, 0);
+        return;
     }
 
-    if (m_apps.empty() ) {
-      XBell(m_display, 0);
-    } else {
-        size_t apps_item = m_current_apps_item + (changed_prefix ? 0 : 1);
-        bool loop= false;
-
-        while (true) {
-            if (apps_item >= m_apps.size() ) {
-                loop = true;
-                apps_item = 0;
-            }
+    if (!changed_prefix)
+        m_current_apps_item = (m_current_apps_item + 1) % m_apps.size();
 
-            if ((!changed_prefix || loop) && apps_item == m_current_apps_item) {
-                break;
-            }
-            if (m_apps[apps_item].find(prefix) == 0) {
-                m_current_apps_item = apps_item;
-                if (add_dirs && FbTk::FileUtil::isDirectory(m_apps[m_current_apps_item].c_str()))
-                    setText(m_apps[m_current_apps_item] +  "/");
-                else
-                    setText(m_apps[m_current_apps_item]);
-                cursorEnd();
-                break;
-            }
-            apps_item++;
-        }
-        if (!changed_prefix && apps_item == m_current_apps_item)
-            XBell(m_display, 0);
-    }
+    const string &app = m_apps[m_current_apps_item];
+    if (add_dirs && FbTk::FileUtil::isDirectory(app.c_str()))
+        setText(app + "/");
+    else
+        setText(app);
+    cursorEnd();
 }
 
 void FbRun::insertCharacter(char keychar) {
@@ -29,6 +29,9 @@
 #include "FbTk/GContext.hh"
 #include "FbTk/FbPixmap.hh"
 
+#include "AppIndex.hh"
+#include "History.hh"
+
 #include <string>
 #include <vector>
 
@@ -58,6 +61,9 @@ public:
        @return true on success, else false
     */
     bool loadHistory(const char *filename);
+    /// starts indexing the executables in $PATH for completion, keeping
+    /// the index in 'cache_file'
+    void loadApps(const std::string &cache_file);
     /**
        @name events
     */
@@ -90,15 +96,15 @@ private:
     int m_bevel;
     FbTk::GContext m_gc; ///< graphic context
     bool m_end; ///< marks when this object is done
-    std::vector<std::string> m_history; ///< history list of commands
-    std::string m_history_file; ///< holds filename for command history file
+    History m_history; ///< the commands run before, the most recent last
     size_t m_current_history_item; ///< holds current position in command history
     std::string m_last_completion_prefix; ///< last prefix we completed on
     
     typedef std::vector<std::string> AppsContainer;
     typedef AppsContainer::iterator AppsContainerIt;
-    AppsContainer m_apps; ///< holds all apps in $PATH
-    size_t m_current_apps_item; ///< holds current position in apps-history
+    AppIndex m_app_index; ///< the executables in $PATH
+    AppsContainer m_apps; ///< the completions of m_last_completion_prefix
+    size_t m_current_apps_item; ///< holds current position in m_apps
     
     Cursor m_cursor;
 
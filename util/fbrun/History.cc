@@ -0,0 +1,173 @@
+// History.cc
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#include "History.hh"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include "FbTk/StringUtil.hh"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif // HAVE_SYS_MMAN_H
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <set>
+
+using std::string;
+using std::vector;
+
+namespace {
+
+/// the file is compacted when it has this many lines more than commands
+const size_t MAX_DUPLICATES = 1000;
+
+struct CommandLess {
+    bool operator()(const std::pair<string, size_t> &a, const string &b) const {
+        return a.first < b;
+    }
+};
+
+} // anonymous namespace
+
+bool History::load(const string &filename) {
+    m_filename = filename;
+    m_commands.clear();
+    m_lines = 0;
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        // even though we fail to load the file, we should try to save to it
+        std::ofstream outfile(filename.c_str());
+        buildIndex();
+        return outfile.good();
+    }
+
+    struct stat buf;
+    if (fstat(fd, &buf) == 0 && buf.st_size > 0) {
+        size_t size = buf.st_size;
+#ifdef HAVE_SYS_MMAN_H
+        void *data = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            parse(static_cast<const char *>(data), size);
+            munmap(data, size);
+        } else
+#endif // HAVE_SYS_MMAN_H
+        {
+            vector<char> data(size);
+            ssize_t got = read(fd, &data[0], size);
+            if (got > 0)
+                parse(&data[0], got);
+        }
+    }
+    close(fd);
+
+    buildIndex();
+    if (m_lines > m_commands.size() + MAX_DUPLICATES)
+        compact();
+    return true;
+}
+
+void History::parse(const char *data, size_t size) {
+    // from the end, so the last time a command was run counts
+    std::set<string> seen;
+    const char *end = data + size;
+    while (end > data) {
+        const char *start = end;
+        while (start > data && start[-1] != '\n')
+            --start;
+        if (start != end) {
+            ++m_lines;
+            string command(start, end);
+            if (seen.insert(command).second)
+                m_commands.push_back(command);
+        }
+        end = start > data ? start - 1 : data;
+    }
+    std::reverse(m_commands.begin(), m_commands.end());
+}
+
+void History::buildIndex() {
+    m_index.clear();
+    m_index.reserve(m_commands.size());
+    for (size_t i = 0; i < m_commands.size(); ++i)
+        m_index.push_back(std::make_pair(m_commands[i], i));
+    std::sort(m_index.begin(), m_index.end());
+}
+
+size_t History::findPrevious(const string &prefix, size_t before) const {
+    vector<std::pair<string, size_t> >::const_iterator it =
+        std::lower_bound(m_index.begin(), m_index.end(), prefix, CommandLess());
+    size_t found = size(), latest = size();
+    for (; it != m_index.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+        if (it->second < before && (found == size() || it->second > found))
+            found = it->second;
+        if (latest == size() || it->second > latest)
+            latest = it->second;
+    }
+    return found != size() ? found : latest;
+}
+
+bool History::add(const string &command) {
+    if (command.empty())
+        return true;
+
+    vector<string>::iterator it = std::find(m_commands.begin(), m_commands.end(), command);
+    if (it != m_commands.end())
+        m_commands.erase(it);
+    m_commands.push_back(command);
+    buildIndex();
+
+    int fd = open(m_filename.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0666);
+    if (fd < 0)
+        return false;
+    string line = command + '\n';
+    bool ok = write(fd, line.data(), line.size()) == static_cast<ssize_t>(line.size());
+    close(fd);
+    ++m_lines;
+    return ok;
+}
+
+bool History::compact() {
+    string tmp = m_filename + "." + FbTk::StringUtil::number2String(getpid());
+    {
+        std::ofstream out(tmp.c_str());
+        std::copy(m_commands.begin(), m_commands.end(),
+                  std::ostream_iterator<string>(out, "\n"));
+        if (!out) {
+            remove(tmp.c_str());
+            return false;
+        }
+    }
+    if (rename(tmp.c_str(), m_filename.c_str()) != 0)
+        return false;
+    m_lines = m_commands.size();
+    return true;
+}
@@ -0,0 +1,68 @@
+// History.hh
+// Copyright (c) 2011 Fluxbox Team (fluxgen at fluxbox dot org)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+#ifndef HISTORY_HH
+#define HISTORY_HH
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+   The commands of the history file, each once, in the order they were
+   last run: the oldest first, the most recent last. An index sorted by
+   command finds those with a prefix without comparing all of them.
+   New commands are appended to the file; when it holds a lot more lines
+   than commands, it is rewritten without the duplicates.
+ */
+class History {
+public:
+    History(): m_lines(0) { }
+
+    /// reads the history file, false if it can't be read or created
+    bool load(const std::string &filename);
+    /// makes 'command' the most recent, and appends it to the file
+    bool add(const std::string &command);
+
+    size_t size() const { return m_commands.size(); }
+    bool empty() const { return m_commands.empty(); }
+    const std::string &operator[](size_t i) const { return m_commands[i]; }
+
+    /// @return the most recent command before 'before' that starts with
+    ///         'prefix', or the most recent one at all if there is none
+    ///         before, size() if no command starts with it
+    size_t findPrevious(const std::string &prefix, size_t before) const;
+
+    const std::string &filename() const { return m_filename; }
+
+private:
+    void parse(const char *data, size_t size);
+    void buildIndex();
+    bool compact();
+
+    std::string m_filename;
+    std::vector<std::string> m_commands;
+    /// each command and its position in m_commands, sorted by command
+    std::vector<std::pair<std::string, size_t> > m_index;
+    size_t m_lines; ///< in the file, including duplicates
+};
+
+#endif // HISTORY_HH
@@ -65,6 +65,7 @@ void showUsage(const char *progname) {
         "   -bg [color name]            Background color"<<endl<<
         "   -na                         Disable antialias"<<endl<<
         "   -hf [history file]          History file to load (default ~/.fluxbox/fbrun_history)"<<endl<<
+        "   -ac [cache file]            Cache of the programs to complete (default ~/.fluxbox/fbrun_apps)"<<endl<<
         "   -help                       Show this help"<<endl<<endl<<
         "Example: fbrun -fg black -bg white -text xterm -title \"run xterm\""<<endl;
 }
@@ -84,6 +85,7 @@ int main(int argc, char **argv) {
     string background("white");   // text background color
     string display_name; // name of the display connection
     string history_file("~/.fluxbox/fbrun_history"); // command history file
+    string apps_file("~/.fluxbox/fbrun_apps"); // cache of the programs in $PATH
     // parse arguments
     for (int i=1; i<argc; i++) {
         string arg = argv[i];
@@ -118,6 +120,8 @@ int main(int argc, char **argv) {
             antialias = false;
         } else if (strcmp(argv[i], "-hf") == 0 && i+1 < argc) {
             history_file = argv[++i];
+        } else if (strcmp(argv[i], "-ac") == 0 && i+1 < argc) {
+            apps_file = argv[++i];
         } else if (arg == "-h" || arg == "-help" || arg == "--help") {
             showUsage(argv[0]);
             exit(0);
@@ -160,6 +164,8 @@ int main(int argc, char **argv) {
         string expanded_filename = FbTk::StringUtil::expandFilename(history_file);
         if (!fbrun.loadHistory(expanded_filename.c_str()))
             cerr<<"FbRun Warning: Failed to load history file: "<<expanded_filename<<endl;
+        // indexes $PATH while the window shows
+        fbrun.loadApps(FbTk::StringUtil::expandFilename(apps_file));
 
         fbrun.setTitle(title);
         fbrun.setText(text);
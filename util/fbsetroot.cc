@@ -166,7 +166,7 @@ void fbsetroot::setRootAtoms(Pixmap pixmap, int screen) {
     int format;
     unsigned long length, after;
 
-    atom_root = XInternAtom(display(), "_XROOTMAP_ID", true);
+    atom_root = XInternAtom(display(), "_XROOTPMAP_ID", true);
     atom_eroot = XInternAtom(display(), "ESETROOT_PMAP_ID", true);
     FbRootWindow root(screen);
 
@@ -311,10 +311,6 @@ void fbsetroot::modula(int x, int y) {
  draws pixmaps with a fluxbox texure
 */
 void fbsetroot::gradient() {
-    // using temporaray pixmap and then copying it to background pixmap, as it'll
-    // get crashed somewhere on the way causing apps like XChat chrashing
-    // as the pixmap has been destroyed
-    Pixmap tmp;
     // we must insert gradient text
     string texture_value = grad ? grad : "solid";
     texture_value.insert(0, "gradient ");
@@ -323,8 +319,6 @@ void fbsetroot::gradient() {
 
     FbRootWindow root(screen);
 
-
-    FbTk::GContext gc(root);
     texture.color().setFromString(fore, screen);
     texture.colorTo().setFromString(back, screen);
 
@@ -335,28 +329,20 @@ void fbsetroot::gradient() {
     if (! texture.colorTo().isAllocated())
         texture.colorTo().setPixel(BlackPixel(display(), screen));
 
-    tmp = img_ctrl->renderImage(root.width(), root.height(), texture);
-
-    pixmap = new Pixmap(XCreatePixmap(display(),
-                                      root.window(),
-                                      root.width(), root.height(),
-                                      getRootDepth(root)));
-
-
-    XCopyArea(display(), tmp, *pixmap, gc.gc(), 0, 0,
-              root.width(), root.height(),
-              0, 0);
+    // not from the cache, the pixmap is ours to keep after we exit and
+    // doesn't need to be copied to a pixmap the cache won't free
+    Pixmap rendered = img_ctrl->renderImage(root.width(), root.height(),
+                                            texture, FbTk::ROT0, false);
+    if (rendered == None) {
+        solid();
+        return;
+    }
+    pixmap = new Pixmap(rendered);
 
     setRootAtoms(*pixmap, screen);
 
     root.setBackgroundPixmap(*pixmap);
     root.clear();
-
-    if (! (root.visual()->c_class & 1)) {
-        img_ctrl->removeImage(tmp);
-        img_ctrl->cleanCache();
-    }
-
 }
 
 /**
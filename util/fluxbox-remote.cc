@@ -24,6 +24,13 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <string>
 
 bool g_gotError;
 static int HandleIPCError(Display *disp, XErrorEvent*ptr)
@@ -33,13 +40,219 @@ static int HandleIPCError(Display *disp, XErrorEvent*ptr)
 	return( 0 );
 }
 
+// where fluxbox listens for commands, from the environment of programs it
+// started or from the root window
+static std::string socketPath() {
+    const char *path = getenv("FLUXBOX_SOCKET");
+    if (path && *path)
+        return path;
+
+    std::string result;
+    Display *disp = XOpenDisplay(NULL);
+    if (!disp)
+        return result;
+
+    Atom socket_atom = XInternAtom(disp, "_FLUXBOX_SOCKET", True);
+    Atom type;
+    int format;
+    unsigned long nitems, bytes_after;
+    unsigned char *data = 0;
+    if (socket_atom != None &&
+        XGetWindowProperty(disp, DefaultRootWindow(disp), socket_atom, 0, 1024,
+                           False, XA_STRING, &type, &format, &nitems,
+                           &bytes_after, &data) == Success && data) {
+        result.assign((char *)data, nitems);
+        XFree(data);
+    }
+    XCloseDisplay(disp);
+    return result;
+}
+
+static bool writeAll(int fd, const char *data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written == -1 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return false;
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+// @return the socket connected to fluxbox, or -1
+static int connectSocket() {
+    std::string path = socketPath();
+    if (path.empty()) {
+        fprintf(stderr, "fluxbox-remote: fluxbox doesn't accept remote commands"
+                " (session.screen0.allowRemoteActions)\n");
+        return -1;
+    }
+
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1 || connect(fd, (sockaddr *)&address, sizeof(address)) == -1) {
+        perror(path.c_str());
+        if (fd != -1)
+            close(fd);
+        return -1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    return fd;
+}
+
+// prints the events fluxbox sends, one per line, until it goes away
+static int subscribe(int argc, char **argv) {
+    int fd = connectSocket();
+    if (fd == -1)
+        return EXIT_FAILURE;
+
+    std::string request = "subscribe";
+    for (int i = 0; i < argc; ++i)
+        request += std::string(" ") + argv[i];
+    request += "\n";
+    if (!writeAll(fd, request.data(), request.size())) {
+        perror("fluxbox-remote");
+        close(fd);
+        return EXIT_FAILURE;
+    }
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    bool answered = false;
+    std::string line;
+    char buffer[4096];
+    ssize_t size;
+    while ((size = read(fd, buffer, sizeof(buffer))) > 0 ||
+           (size == -1 && errno == EINTR)) {
+        for (ssize_t i = 0; i < size; ++i) {
+            if (buffer[i] != '\n') {
+                line += buffer[i];
+                continue;
+            }
+            if (answered)
+                printf("%s\n", line.c_str() + 6); // without "event "
+            else if (line != "ok") {
+                fprintf(stderr, "fluxbox-remote: %s\n", line.c_str());
+                close(fd);
+                return EXIT_FAILURE;
+            }
+            answered = true;
+            line.clear();
+        }
+    }
+    close(fd);
+    return EXIT_SUCCESS;
+}
+
+// prints fluxbox's counters as a JSON object, see RemoteServer
+static int stats() {
+    int fd = connectSocket();
+    if (fd == -1)
+        return EXIT_FAILURE;
+
+    if (!writeAll(fd, "stats\n", 6)) {
+        perror("fluxbox-remote");
+        close(fd);
+        return EXIT_FAILURE;
+    }
+    shutdown(fd, SHUT_WR);
+
+    std::string answer;
+    char buffer[4096];
+    ssize_t size;
+    while ((size = read(fd, buffer, sizeof(buffer))) > 0 ||
+           (size == -1 && errno == EINTR)) {
+        if (size > 0)
+            answer.append(buffer, size);
+    }
+    close(fd);
+
+    if (answer.compare(0, 6, "stats ") != 0) {
+        fprintf(stderr, "fluxbox-remote: %s", answer.empty()
+                ? "no answer\n" : answer.c_str());
+        return EXIT_FAILURE;
+    }
+    fputs(answer.c_str() + 6, stdout);
+    return EXIT_SUCCESS;
+}
+
+// sends the commands on stdin, one per line, over fluxbox's socket and
+// reports those that failed
+static int batch() {
+    int fd = connectSocket();
+    if (fd == -1)
+        return EXIT_FAILURE;
+
+    // fluxbox answers while we're still sending, it doesn't wait for us
+    char buffer[4096];
+    size_t got;
+    unsigned int lines = 0;
+    bool newline = true;
+    while ((got = fread(buffer, 1, sizeof(buffer), stdin)) > 0) {
+        for (size_t i = 0; i < got; ++i)
+            lines += (buffer[i] == '\n');
+        newline = (buffer[got - 1] == '\n');
+        if (!writeAll(fd, buffer, got)) {
+            perror("fluxbox-remote");
+            close(fd);
+            return EXIT_FAILURE;
+        }
+    }
+    if (!newline)
+        ++lines;
+    shutdown(fd, SHUT_WR);
+
+    // one answer per line
+    int ret = EXIT_SUCCESS;
+    unsigned int line = 1;
+    std::string answer;
+    ssize_t size;
+    while ((size = read(fd, buffer, sizeof(buffer))) > 0 ||
+           (size == -1 && errno == EINTR)) {
+        for (ssize_t i = 0; i < size; ++i) {
+            if (buffer[i] != '\n') {
+                answer += buffer[i];
+                continue;
+            }
+            if (answer != "ok") {
+                fprintf(stderr, "line %u: %s\n", line, answer.c_str());
+                ret = EXIT_FAILURE;
+            }
+            answer.clear();
+            ++line;
+        }
+    }
+    close(fd);
+
+    if (line <= lines) {
+        fprintf(stderr, "fluxbox-remote: no answer for line %u and later\n", line);
+        ret = EXIT_FAILURE;
+    }
+    return ret;
+}
+
 int main(int argc, char **argv) {
 
     if (argc <= 1) {
         printf("fluxbox-remote <fluxbox-command>\n");
+        printf("fluxbox-remote --batch < <file with one command per line>\n");
+        printf("fluxbox-remote --subscribe [workspace] [focus] [clientlist] [title]\n");
+        printf("fluxbox-remote --stats\n");
         return EXIT_SUCCESS;
     }
 
+    if (strcmp(argv[1], "--batch") == 0)
+        return batch();
+    if (strcmp(argv[1], "--subscribe") == 0)
+        return subscribe(argc - 2, argv + 2);
+    if (strcmp(argv[1], "--stats") == 0)
+        return stats();
+
     Display *disp = XOpenDisplay(NULL);
     if (!disp) {
         perror("error, can't open display.");
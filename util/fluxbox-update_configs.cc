@@ -23,6 +23,7 @@
 #include "../src/FbTk/Resource.hh"
 #include "../src/FbTk/StringUtil.hh"
 #include "../src/FbTk/FileUtil.hh"
+#include "../src/FbTk/Tokenizer.hh"
 
 #include "../src/defaults.hh"
 
@@ -50,34 +51,129 @@
 #include <iostream>
 #include <fstream>
 #include <set>
-#include <map>
 #include <cstdlib>
+#include <cstdio>
 #include <list>
+#include <vector>
 
 using std::cout;
 using std::cerr;
 using std::endl;
 using std::string;
-using std::ifstream;
 using std::ofstream;
 using std::set;
-using std::map;
 using std::list;
 using std::exit;
 using std::getenv;
 
 string read_file(const string& filename);
-void write_file(const string& filename, const string &contents);
-void save_all_files();
+bool write_file(const string& filename, const string &contents);
+
+/*------------------------------------------------------------------*\
+\*------------------------------------------------------------------*/
+
+/// changes a line of a file, the line ends with its newline
+typedef void (*LineUpdate)(string &line);
+
+/**
+ * The changes of all the updates to a file. They are collected first and
+ * then applied in one pass over the file, as if each update had rewritten
+ * the file in turn: an update changes the lines the updates before it
+ * added, but not the ones the updates after it add.
+ */
+class FileUpdate {
+public:
+    /// puts 'text' in front of the file
+    void prepend(const string &text) { add(text, 0, true); }
+    /// puts 'text' at the end of the file
+    void append(const string &text) { add(text, 0, false); }
+    /// changes every line there is so far
+    void changeLines(LineUpdate update) { add("", update, false); }
+
+    /// writes the changes to 'filename', if there are any
+    /// @return true if the file was written
+    bool apply(const string &filename) const;
+    /// @return 'contents' with the changes
+    string apply(const char *contents, size_t size) const;
+
+private:
+    struct Step {
+        string text;
+        LineUpdate update;
+        bool prepend;
+    };
+    void add(const string &text, LineUpdate update, bool prepend) {
+        Step step;
+        step.text = text;
+        step.update = update;
+        step.prepend = prepend;
+        m_steps.push_back(step);
+    }
+    /// adds the lines of 'text' to 'out', changed by the steps from 'first' on
+    void addLines(string &out, const char *text, size_t size, size_t first) const;
+
+    std::vector<Step> m_steps;
+};
+
+string FileUpdate::apply(const char *contents, size_t size) const {
+    string out;
+    out.reserve(size + size / 16);
+    // each prepend goes in front of the ones before it
+    for (size_t i = m_steps.size(); i-- > 0; ) {
+        if (m_steps[i].prepend)
+            addLines(out, m_steps[i].text.data(), m_steps[i].text.size(), i + 1);
+    }
+    addLines(out, contents, size, 0);
+    for (size_t i = 0; i < m_steps.size(); ++i) {
+        if (!m_steps[i].prepend && m_steps[i].update == 0)
+            addLines(out, m_steps[i].text.data(), m_steps[i].text.size(), i + 1);
+    }
+    return out;
+}
+
+void FileUpdate::addLines(string &out, const char *text, size_t size,
+                          size_t first) const {
+    std::vector<LineUpdate> updates;
+    for (size_t i = first; i < m_steps.size(); ++i) {
+        if (m_steps[i].update)
+            updates.push_back(m_steps[i].update);
+    }
+    if (updates.empty()) {
+        out.append(text, size);
+        // every line ends with a newline, the last one too
+        if (size > 0 && text[size - 1] != '\n')
+            out += '\n';
+        return;
+    }
+
+    FbTk::Tokenizer lines(text, size);
+    string line;
+    while (lines.nextLine()) {
+        lines.line().assignTo(line);
+        line += '\n';
+        for (size_t i = 0; i < updates.size(); ++i)
+            updates[i](line);
+        out += line;
+    }
+}
+
+bool FileUpdate::apply(const string &filename) const {
+    if (m_steps.empty())
+        return false;
+
+    FbTk::MappedFile file;
+    if (FbTk::FileUtil::isRegularFile(filename.c_str()))
+        file.open(filename.c_str());
+    return write_file(filename, apply(file.data(), file.size()));
+}
 
 
 /*------------------------------------------------------------------*\
 \*------------------------------------------------------------------*/
 
-void update_add_mouse_evens_to_keys(FbTk::ResourceManager& rm, 
-        const FbTk::FbString& keyfilename, const FbTk::FbString& appsfilename) {
+void update_add_mouse_evens_to_keys(FbTk::ResourceManager& rm,
+        FileUpdate& keys, FileUpdate& apps) {
 
-    string whole_keyfile = read_file(keyfilename);
     string new_keyfile = "";
     // let's put our new keybindings first, so they're easy to find
     new_keyfile += "!mouse actions added by fluxbox-update_configs\n";
@@ -105,20 +201,18 @@ void update_add_mouse_evens_to_keys(FbTk::ResourceManager& rm,
         }
     }
     new_keyfile += "\n"; // just for good looks
-    new_keyfile += whole_keyfile; // don't forget user's old keybindings
 
-    write_file(keyfilename, new_keyfile);
+    keys.prepend(new_keyfile);
 }
 
 
 void update_move_groups_entries_to_apps_file(FbTk::ResourceManager& rm,
-        const FbTk::FbString& keyfilename, const FbTk::FbString& appsfilename) {
+        FileUpdate& keys, FileUpdate& apps) {
 
     FbTk::Resource<string> rc_groupfile(rm, "~/.fluxbox/groups",
             "session.groupFile", "Session.GroupFile");
     string groupfilename = FbTk::StringUtil::expandFilename(*rc_groupfile);
     string whole_groupfile = read_file(groupfilename);
-    string whole_appsfile = read_file(appsfilename);
     string new_appsfile = "";
 
     list<string> lines;
@@ -143,15 +237,13 @@ void update_move_groups_entries_to_apps_file(FbTk::ResourceManager& rm,
         new_appsfile += "[end]\n";
     }
 
-    new_appsfile += whole_appsfile;
-    write_file(appsfilename, new_appsfile);
+    apps.prepend(new_appsfile);
 }
 
 
 void update_move_toolbar_wheeling_to_keys_file(FbTk::ResourceManager& rm,
-        const FbTk::FbString& keyfilename, const FbTk::FbString& appsfilename) {
+        FileUpdate& keys, FileUpdate& apps) {
 
-    string whole_keyfile = read_file(keyfilename);
     string new_keyfile = "";
     // let's put our new keybindings first, so they're easy to find
     new_keyfile += "!mouse actions added by fluxbox-update_configs\n";
@@ -179,17 +271,15 @@ void update_move_toolbar_wheeling_to_keys_file(FbTk::ResourceManager& rm,
         }
     }
     new_keyfile += "\n"; // just for good looks
-    new_keyfile += whole_keyfile; // don't forget user's old keybindings
 
     if (keep_changes)
-        write_file(keyfilename, new_keyfile);
+        keys.prepend(new_keyfile);
 }
 
 
 
 void update_move_modkey_to_keys_file(FbTk::ResourceManager& rm,
-        const FbTk::FbString& keyfilename, const FbTk::FbString& appsfilename) {
-    string whole_keyfile = read_file(keyfilename);
+        FileUpdate& keys, FileUpdate& apps) {
     string new_keyfile = "";
     // let's put our new keybindings first, so they're easy to find
     new_keyfile += "!mouse actions added by fluxbox-update_configs\n";
@@ -214,16 +304,15 @@ void update_move_modkey_to_keys_file(FbTk::ResourceManager& rm,
         new_keyfile += "BottomRight}\n";
     }
     new_keyfile += "\n"; // just for good looks
-    new_keyfile += whole_keyfile; // don't forget user's old keybindings
 
-    write_file(keyfilename, new_keyfile);
+    keys.prepend(new_keyfile);
 }
 
 
 
 
 void update_window_patterns_for_iconbar(FbTk::ResourceManager& rm,
-        const FbTk::FbString& keyfilename, const FbTk::FbString& appsfilename) {
+        FileUpdate& keys, FileUpdate& apps) {
 
     // this needs to survive after going out of scope
     // it won't get freed, but that's ok
@@ -252,8 +341,7 @@ void update_window_patterns_for_iconbar(FbTk::ResourceManager& rm,
 
 
 void update_move_titlebar_actions_to_keys_file(FbTk::ResourceManager& rm,
-        const FbTk::FbString& keyfilename, const FbTk::FbString& appsfilename) {
-    string whole_keyfile = read_file(keyfilename);
+        FileUpdate& keys, FileUpdate& apps) {
     string new_keyfile = "";
     // let's put our new keybindings first, so they're easy to find
     new_keyfile += "!mouse actions added by fluxbox-update_configs\n";
@@ -281,29 +369,26 @@ void update_move_titlebar_actions_to_keys_file(FbTk::ResourceManager& rm,
     }
 
     new_keyfile += "\n"; // just for good looks
-    new_keyfile += whole_keyfile; // don't forget user's old keybindings
 
-    write_file(keyfilename, new_keyfile);
+    keys.prepend(new_keyfile);
 
 }
 
 
 void update_added_starttabbing_command(FbTk::ResourceManager& rm,
-        const FbTk::FbString& keyfilename, const FbTk::FbString& appsfilename) {
-    string whole_keyfile = read_file(keyfilename);
+        FileUpdate& keys, FileUpdate& apps) {
     string new_keyfile = "";
     // let's put our new keybindings first, so they're easy to find
     new_keyfile += "!mouse actions added by fluxbox-update_configs\n";
     new_keyfile += "OnTitlebar Mouse2 :StartTabbing\n\n";
-    new_keyfile += whole_keyfile; // don't forget user's old keybindings
 
-    write_file(keyfilename, new_keyfile);
+    keys.prepend(new_keyfile);
 }
 
 
 
 void update_disable_icons_in_tabs_for_backwards_compatibility(FbTk::ResourceManager& rm,
-        const FbTk::FbString& keyfilename, const FbTk::FbString& appsfilename) {
+        FileUpdate& keys, FileUpdate& apps) {
 
     FbTk::Resource<bool> *show =
         new FbTk::Resource<bool>(rm, false,
@@ -317,7 +402,7 @@ void update_disable_icons_in_tabs_for_backwards_compatibility(FbTk::ResourceMana
 
 
 void update_change_format_of_split_placement_menu(FbTk::ResourceManager& rm,
-        const FbTk::FbString& keyfilename, const FbTk::FbString& appsfilename) {
+        FileUpdate& keys, FileUpdate& apps) {
 
     FbTk::Resource<string> *placement =
         new FbTk::Resource<string>(rm, "BottomRight",
@@ -344,10 +429,7 @@ void update_change_format_of_split_placement_menu(FbTk::ResourceManager& rm,
 
 
 
-void update_update_keys_file_for_nextwindow_syntax_changes(FbTk::ResourceManager& rm,
-        const FbTk::FbString& keyfilename, const FbTk::FbString& appsfilename) {
-
-    string whole_keyfile = read_file(keyfilename);
+void update_nextwindow_syntax_of_line(string& whole_keyfile) {
 
     size_t pos = 0;
     while (true) {
@@ -394,17 +476,19 @@ void update_update_keys_file_for_nextwindow_syntax_changes(FbTk::ResourceManager
                 whole_keyfile.replace(pos, endptr - keyfile - pos, insert);
         }
     }
+}
 
-    write_file(keyfilename, whole_keyfile);
+void update_update_keys_file_for_nextwindow_syntax_changes(FbTk::ResourceManager& rm,
+        FileUpdate& keys, FileUpdate& apps) {
+    keys.changeLines(update_nextwindow_syntax_of_line);
 }
 
 
 
 
 void update_keys_for_ongrip_onwindowborder(FbTk::ResourceManager& rm,
-        const FbTk::FbString& keyfilename, const FbTk::FbString& appsfilename) {
+        FileUpdate& keys, FileUpdate& apps) {
 
-    string whole_keyfile = read_file(keyfilename);
     string new_keyfile = "";
     // let's put our new keybindings first, so they're easy to find
     new_keyfile += "!mouse actions added by fluxbox-update_configs\n";
@@ -412,43 +496,34 @@ void update_keys_for_ongrip_onwindowborder(FbTk::ResourceManager& rm,
     new_keyfile += "OnLeftGrip Move1 :StartResizing bottomleft\n";
     new_keyfile += "OnRightGrip Move1 :StartResizing bottomright\n";
     new_keyfile += "OnWindowBorder Move1 :StartMoving\n\n";
-    new_keyfile += whole_keyfile; // don't forget user's old keybindings
 
-    new_keyfile += "\n"; // just for good looks
-    write_file(keyfilename, new_keyfile);
+    keys.prepend(new_keyfile);
+    keys.append("\n"); // just for good looks
 }
 
 
 
 
 void update_keys_for_activetab(FbTk::ResourceManager& rm,
-        const FbTk::FbString& keyfilename, const FbTk::FbString& appsfilename) {
+        FileUpdate& keys, FileUpdate& apps) {
 
-    string whole_file = read_file(keyfilename);
     string new_keyfile = "";
 
     new_keyfile += "!mouse actions added by fluxbox-update_configs\n";
     new_keyfile += "OnTitlebar Mouse1 :MacroCmd {Focus} {Raise} {ActivateTab}\n";
-    new_keyfile += whole_file;
 
-    new_keyfile += "\n"; // just for good looks
-    write_file(keyfilename, new_keyfile);
+    keys.prepend(new_keyfile);
+    keys.append("\n"); // just for good looks
 
 }
 
 
 
 // NextWindow {static groups} => NextWindow {static groups} (workspace=[current])
-void update_limit_nextwindow_to_current_workspace(FbTk::ResourceManager& rm,
-        const FbTk::FbString& keyfilename, const FbTk::FbString& appsfilename) {
+void limit_nextwindow_of_line(string& line) {
 
-    string whole_file = read_file(keyfilename);
     string new_keyfile = "";
-
-    new_keyfile += "! fluxbox-update_configs added '(workspace=[current])' to (Next|Prev)(Window|Group)\n";
-    new_keyfile += "! check lines marked by 'FBCV13' if they are correctly updated\n";
-
-    const char* pos = whole_file.c_str();
+    const char* pos = line.c_str();
 
 
     string last_word;
@@ -521,8 +596,19 @@ void update_limit_nextwindow_to_current_workspace(FbTk::ResourceManager& rm,
 
     }
 
-    new_keyfile += "\n"; // just for good looks
-    write_file(keyfilename, new_keyfile);
+    line = new_keyfile;
+}
+
+void update_limit_nextwindow_to_current_workspace(FbTk::ResourceManager& rm,
+        FileUpdate& keys, FileUpdate& apps) {
+
+    keys.changeLines(limit_nextwindow_of_line);
+
+    string new_keyfile = "";
+    new_keyfile += "! fluxbox-update_configs added '(workspace=[current])' to (Next|Prev)(Window|Group)\n";
+    new_keyfile += "! check lines marked by 'FBCV13' if they are correctly updated\n";
+    keys.prepend(new_keyfile);
+    keys.append("\n"); // just for good looks
 }
 
 /*------------------------------------------------------------------*\
@@ -530,7 +616,7 @@ void update_limit_nextwindow_to_current_workspace(FbTk::ResourceManager& rm,
 
 struct Update {
     int version;
-    void (*update)(FbTk::ResourceManager& rm, const FbTk::FbString&, const FbTk::FbString&);
+    void (*update)(FbTk::ResourceManager& rm, FileUpdate& keys, FileUpdate& apps);
 };
 
 const Update UPDATES[] = {
@@ -552,20 +638,15 @@ const Update UPDATES[] = {
 /*------------------------------------------------------------------*\
 \*------------------------------------------------------------------*/
 
-int run_updates(int old_version, FbTk::ResourceManager &rm) {
+// collects the changes of the updates after 'old_version', the init file
+// is changed through 'rm'
+int run_updates(int old_version, FbTk::ResourceManager &rm,
+                FileUpdate &keys, FileUpdate &apps) {
     int new_version = old_version;
 
-    FbTk::Resource<string> rc_keyfile(rm, "~/.fluxbox/keys",
-            "session.keyFile", "Session.KeyFile");
-    FbTk::Resource<string> rc_appsfile(rm, "~/.fluxbox/apps",
-            "session.appsFile", "Session.AppsFile");
-
-    string appsfilename = FbTk::StringUtil::expandFilename(*rc_appsfile);
-    string keyfilename = FbTk::StringUtil::expandFilename(*rc_keyfile);
-
     for (size_t i = 0; i < sizeof(UPDATES) / sizeof(Update); ++i) {
         if (old_version < UPDATES[i].version) {
-            UPDATES[i].update(rm, keyfilename, appsfilename);
+            UPDATES[i].update(rm, keys, apps);
             new_version = UPDATES[i].version;
         }
     }
@@ -643,13 +724,21 @@ int main(int argc, char **argv) {
     }
 
 
+    FbTk::Resource<string> rc_keyfile(resource_manager, "~/.fluxbox/keys",
+            "session.keyFile", "Session.KeyFile");
+    FbTk::Resource<string> rc_appsfile(resource_manager, "~/.fluxbox/apps",
+            "session.appsFile", "Session.AppsFile");
+
     int old_version = *config_version;
-    int new_version = run_updates(old_version, resource_manager);
+    FileUpdate keys, apps;
+    int new_version = run_updates(old_version, resource_manager, keys, apps);
     if (new_version > old_version) {
         // configs were updated -- let's save our changes
         config_version = new_version;
         resource_manager.save(rc_filename.c_str(), rc_filename.c_str());
-        save_all_files();
+        // one pass over each file for all the updates
+        keys.apply(FbTk::StringUtil::expandFilename(*rc_keyfile));
+        apps.apply(FbTk::StringUtil::expandFilename(*rc_appsfile));
 
 #if defined(HAVE_SIGNAL_H) && !defined(_WIN32)
         // if we were given a fluxbox pid, send it a reconfigure signal
@@ -662,81 +751,46 @@ int main(int argc, char **argv) {
     return 0;
 }
 
-namespace {
-
-set<string> modified_files;
-// we may want to put a size limit on this cache, so it doesn't grow too big
-map<string,string> file_cache;
-
-}
-
-// returns the contents of the file given, either from the cache or by reading
-// the file from disk
+// returns the contents of the file given
 string read_file(const string& filename) {
-    // check if we already have the file in memory
-    map<string,string>::iterator it = file_cache.find(filename);
-    if (it != file_cache.end())
-        return it->second;
-
-    if (!FbTk::FileUtil::isRegularFile(filename.c_str())) {
+    if (!FbTk::FileUtil::isRegularFile(filename.c_str()))
         return "";
-    }
-
-    // nope, we'll have to read the file
-    ifstream infile(filename.c_str());
-    string whole_file = "";
-
-    if (!infile) // failed to open file
-        return whole_file;
 
-    string linebuffer;
-    while (!infile.eof()) {
-        getline(infile, linebuffer);
-        whole_file += linebuffer + "\n";
-    }
-    infile.close();
-
-    file_cache[filename] = whole_file;
-    return whole_file;
+    FbTk::MappedFile file;
+    if (!file.open(filename.c_str()))
+        return "";
+    return string(file.data(), file.size());
 }
 
-#ifdef NOT_USED
-// remove the file from the cache, writing to disk if it's been changed
-void forget_file(const string& filename) {
-    map<string,string>::iterator cache_it = file_cache.find(filename);
-    // check if we knew about the file to begin with
-    if (cache_it == file_cache.end())
-        return;
-
-    // check if we've actually modified it
-    set<string>::iterator mod_it = modified_files.find(filename);
-    if (mod_it == modified_files.end()) {
-        file_cache.erase(cache_it);
-        return;
+// replaces the file with 'contents', unless it has them already
+bool write_file(const string& filename, const string &contents) {
+    FbTk::MappedFile current;
+    if (FbTk::FileUtil::isRegularFile(filename.c_str()) &&
+        current.open(filename.c_str()) && current.size() == contents.size() &&
+        memcmp(current.data(), contents.data(), contents.size()) == 0)
+        return false;
+    current.close();
+
+    // a rename would replace a link instead of the file it points to
+    struct stat st;
+    if (lstat(filename.c_str(), &st) == 0 && S_ISLNK(st.st_mode)) {
+        ofstream outfile(filename.c_str());
+        outfile << contents;
+        return true;
     }
 
-    // flush our changes to disk and remove all traces
-    ofstream outfile(filename.c_str());
-    outfile << cache_it->second;
-    file_cache.erase(cache_it);
-    modified_files.erase(mod_it);
-}
-#endif // NOT_USED
-
-// updates the file contents in the cache and marks the file as modified so it
-// gets saved later
-void write_file(const string& filename, const string &contents) {
-    modified_files.insert(filename);
-    file_cache[filename] = contents;
-}
-
-// actually save all the files we've modified
-void save_all_files() {
-    set<string>::iterator it = modified_files.begin();
-    set<string>::iterator it_end = modified_files.end();
-    for (; it != it_end; ++it) {
-        ofstream outfile(it->c_str());
-        outfile << file_cache[it->c_str()];
+    string tmpfile = filename + ".tmp";
+    {
+        ofstream outfile(tmpfile.c_str());
+        outfile << contents;
+        if (!outfile) {
+            remove(tmpfile.c_str());
+            return false;
+        }
+    }
+    if (rename(tmpfile.c_str(), filename.c_str()) != 0) {
+        remove(tmpfile.c_str());
+        return false;
     }
-    modified_files.clear();
+    return true;
 }